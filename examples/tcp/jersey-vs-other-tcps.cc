@@ -84,8 +84,12 @@ int main (int argc, char *argv[])
   std::string TcpWestwood = "ns3::TcpWestwood";
   std::string TcpVegas = "ns3::TcpVegas";
   std::string mobilityModel = "ns3::ConstantPositionMobilityModel";
+  std::string queueDiscType = "Red";
+  bool pacing = false;
 
   CommandLine cmd;
+  cmd.AddValue ("queueDiscType", "Bottleneck queue disc type: Red or Cw", queueDiscType);
+  cmd.AddValue ("pacing", "Enable the pacing of TCP segments", pacing);
   cmd.Parse (argc, argv);
 
   /**
@@ -95,6 +99,7 @@ int main (int argc, char *argv[])
    */
   Config::SetDefault ("ns3::TcpSocketBase::MaxWindowSize", UintegerValue (maxWindowSize));
   Config::SetDefault ("ns3::TcpSocketBase::WindowScaling", BooleanValue (isWindowScalingEnabled));
+  Config::SetDefault ("ns3::TcpSocketBase::Pacing", BooleanValue (pacing));
 
   Config::SetDefault ("ns3::RedQueueDisc::Mode", StringValue ("QUEUE_MODE_PACKETS"));
   Config::SetDefault ("ns3::RedQueueDisc::QueueLimit", UintegerValue (200));
@@ -104,6 +109,11 @@ int main (int argc, char *argv[])
   Config::SetDefault ("ns3::RedQueueDisc::UseEcn", BooleanValue (true));
   Config::SetDefault ("ns3::RedQueueDisc::Gentle", BooleanValue (false));
 
+  Config::SetDefault ("ns3::CwQueueDisc::Mode", StringValue ("QUEUE_MODE_PACKETS"));
+  Config::SetDefault ("ns3::CwQueueDisc::QueueLimit", UintegerValue (200));
+  Config::SetDefault ("ns3::CwQueueDisc::MarkThreshold", UintegerValue (50));
+  Config::SetDefault ("ns3::CwQueueDisc::AverageShift", UintegerValue (2));
+
   /**
    * Creating point to point channel for bottleneck
    * Setting the date rate of the bottleneck link
@@ -146,7 +156,7 @@ int main (int argc, char *argv[])
   QueueDiscContainer queueDiscsLeft;
   QueueDiscContainer queueDiscsMiddle;
   QueueDiscContainer queueDiscsRight;
-  tchBottleneck.SetRootQueueDisc ("ns3::RedQueueDisc");
+  tchBottleneck.SetRootQueueDisc ("ns3::" + queueDiscType + "QueueDisc");
   queueDiscsLeft = tchBottleneck.Install (d.GetLeft ()->GetDevice (0));
   queueDiscsMiddle = tchBottleneck.Install (d.GetMiddle ()->GetDevice (1));
   queueDiscsRight = tchBottleneck.Install (d.GetRight ()->GetDevice (0));
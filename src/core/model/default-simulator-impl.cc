@@ -25,10 +25,14 @@
 
 #include "ptr.h"
 #include "pointer.h"
+#include "double.h"
+#include "uinteger.h"
 #include "assert.h"
 #include "log.h"
 
+#include <algorithm>
 #include <cmath>
+#include <vector>
 
 
 /**
@@ -53,6 +57,18 @@ DefaultSimulatorImpl::GetTypeId (void)
     .SetParent<SimulatorImpl> ()
     .SetGroupName ("Core")
     .AddConstructor<DefaultSimulatorImpl> ()
+    .AddAttribute ("CompactionRatio",
+                   "Remove the cancelled events from the event list when "
+                   "they make up more than this fraction of it; 1 disables "
+                   "the compaction.",
+                   DoubleValue (0.5),
+                   MakeDoubleAccessor (&DefaultSimulatorImpl::m_compactionRatio),
+                   MakeDoubleChecker<double> (0, 1))
+    .AddAttribute ("CompactionMinEvents",
+                   "Do not compact event lists of fewer events.",
+                   UintegerValue (4096),
+                   MakeUintegerAccessor (&DefaultSimulatorImpl::m_compactionMinEvents),
+                   MakeUintegerChecker<uint32_t> ())
   ;
   return tid;
 }
@@ -71,7 +87,11 @@ DefaultSimulatorImpl::DefaultSimulatorImpl ()
   m_currentTs = 0;
   m_currentContext = Simulator::NO_CONTEXT;
   m_unscheduledEvents = 0;
-  m_eventsWithContextEmpty = true;
+  m_cancelledEvents = 0;
+  m_compactions = 0;
+  m_purgedEvents = 0;
+  m_compactable = true;
+  m_eventsWithContext.store (0);
   m_main = SystemThread::Self();
 }
 
@@ -84,7 +104,15 @@ void
 DefaultSimulatorImpl::DoDispose (void)
 {
   NS_LOG_FUNCTION (this);
-  ProcessEventsWithContext ();
+  // Free the events scheduled by other threads, which will never run
+  EventWithContext *ev = m_eventsWithContext.exchange (0, std::memory_order_acquire);
+  while (ev != 0)
+    {
+      EventWithContext *next = ev->next;
+      ev->event->Unref ();
+      delete ev;
+      ev = next;
+    }
 
   while (!m_events->IsEmpty ())
     {
@@ -92,6 +120,8 @@ DefaultSimulatorImpl::DoDispose (void)
       next.impl->Unref ();
     }
   m_events = 0;
+  m_unscheduledEvents = 0;
+  m_cancelledEvents = 0;
   SimulatorImpl::DoDispose ();
 }
 void
@@ -125,6 +155,7 @@ DefaultSimulatorImpl::SetScheduler (ObjectFactory schedulerFactory)
         }
     }
   m_events = scheduler;
+  m_compactable = true;
 }
 
 // System ID for non-distributed simulation is always zero
@@ -146,6 +177,11 @@ DefaultSimulatorImpl::ProcessOneEvent (void)
   m_currentTs = next.key.m_ts;
   m_currentContext = next.key.m_context;
   m_currentUid = next.key.m_uid;
+  if (next.impl->IsCancelled () && m_cancelledEvents > 0)
+    {
+      // The events cancelled without Cancel were not counted
+      m_cancelledEvents--;
+    }
   next.impl->Invoke ();
   next.impl->Unref ();
 
@@ -161,30 +197,41 @@ DefaultSimulatorImpl::IsFinished (void) const
 void
 DefaultSimulatorImpl::ProcessEventsWithContext (void)
 {
-  if (m_eventsWithContextEmpty)
+  if (m_eventsWithContext.load (std::memory_order_relaxed) == 0)
     {
       return;
     }
 
-  // swap queues
-  EventsWithContext eventsWithContext;
-  {
-    CriticalSection cs (m_eventsWithContextMutex);
-    m_eventsWithContext.swap(eventsWithContext);
-    m_eventsWithContextEmpty = true;
-  }
-  while (!eventsWithContext.empty ())
+  // Take all the events, and restore the order they were scheduled in
+  EventWithContext *last = m_eventsWithContext.exchange (0, std::memory_order_acquire);
+  EventWithContext *first = 0;
+  while (last != 0)
     {
-       EventWithContext event = eventsWithContext.front ();
-       eventsWithContext.pop_front ();
+      EventWithContext *next = last->next;
+      last->next = first;
+      first = last;
+      last = next;
+    }
+  while (first != 0)
+    {
+       EventWithContext *event = first;
+       first = event->next;
+       if (event->event->IsCancelled ())
+         {
+           // Cancelled while in the inbox, and never counted by Cancel
+           event->event->Unref ();
+           delete event;
+           continue;
+         }
        Scheduler::Event ev;
-       ev.impl = event.event;
-       ev.key.m_ts = m_currentTs + event.timestamp;
-       ev.key.m_context = event.context;
+       ev.impl = event->event;
+       ev.key.m_ts = m_currentTs + event->timestamp;
+       ev.key.m_context = event->context;
        ev.key.m_uid = m_uid;
        m_uid++;
        m_unscheduledEvents++;
        m_events->Insert (ev);
+       delete event;
     }
 }
 
@@ -264,16 +311,17 @@ DefaultSimulatorImpl::ScheduleWithContext (uint32_t context, Time const &delay,
     }
   else
     {
-      EventWithContext ev;
-      ev.context = context;
+      EventWithContext *ev = new EventWithContext ();
+      ev->context = context;
       // Current time added in ProcessEventsWithContext()
-      ev.timestamp = delay.GetTimeStep ();
-      ev.event = event;
-      {
-        CriticalSection cs (m_eventsWithContextMutex);
-        m_eventsWithContext.push_back(ev);
-        m_eventsWithContextEmpty = false;
-      }
+      ev->timestamp = delay.GetTimeStep ();
+      ev->event = event;
+      ev->next = m_eventsWithContext.load (std::memory_order_relaxed);
+      while (!m_eventsWithContext.compare_exchange_weak (ev->next, ev,
+                                                         std::memory_order_release,
+                                                         std::memory_order_relaxed))
+        {
+        }
     }
 }
 
@@ -363,9 +411,45 @@ DefaultSimulatorImpl::Cancel (const EventId &id)
   if (!IsExpired (id))
     {
       id.PeekEventImpl ()->Cancel ();
+      if (id.GetUid () == 2)
+        {
+          // destroy events are not in the event list
+          return;
+        }
+      m_cancelledEvents++;
+      if (m_compactable
+          && m_unscheduledEvents >= (int) m_compactionMinEvents
+          && m_cancelledEvents > m_compactionRatio * m_unscheduledEvents)
+        {
+          Compact ();
+        }
     }
 }
 
+void
+DefaultSimulatorImpl::Compact (void)
+{
+  NS_LOG_FUNCTION (this << m_unscheduledEvents << m_cancelledEvents);
+  std::vector<Scheduler::Event> removed;
+  removed.reserve (m_cancelledEvents);
+  m_events->RemoveCancelled (removed);
+  if (removed.empty ())
+    {
+      NS_LOG_LOGIC ("the scheduler does not remove cancelled events");
+      m_compactable = false;
+      return;
+    }
+  for (std::vector<Scheduler::Event>::const_iterator i = removed.begin (); i != removed.end (); ++i)
+    {
+      // whenever we remove an event from the event list, we have to unref it.
+      i->impl->Unref ();
+    }
+  m_unscheduledEvents -= removed.size ();
+  m_compactions++;
+  m_purgedEvents += removed.size ();
+  m_cancelledEvents -= std::min<uint64_t> (m_cancelledEvents, removed.size ());
+}
+
 bool
 DefaultSimulatorImpl::IsExpired (const EventId &id) const
 {
@@ -408,6 +492,17 @@ DefaultSimulatorImpl::GetMaximumSimulationTime (void) const
   return TimeStep (0x7fffffffffffffffLL);
 }
 
+Simulator::EventCounts
+DefaultSimulatorImpl::GetEventCounts (void) const
+{
+  Simulator::EventCounts counts;
+  counts.live = m_unscheduledEvents - m_cancelledEvents;
+  counts.cancelled = m_cancelledEvents;
+  counts.compactions = m_compactions;
+  counts.purged = m_purgedEvents;
+  return counts;
+}
+
 uint32_t
 DefaultSimulatorImpl::GetContext (void) const
 {
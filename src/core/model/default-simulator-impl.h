@@ -25,10 +25,10 @@
 #include "scheduler.h"
 #include "event-impl.h"
 #include "system-thread.h"
-#include "system-mutex.h"
 
 #include "ptr.h"
 
+#include <atomic>
 #include <list>
 
 /**
@@ -43,6 +43,13 @@ namespace ns3 {
  * \ingroup simulator
  *
  * The default single process simulator implementation.
+ *
+ * Cancelled events stay in the event list until their time comes, as
+ * removing them at once would cost a search in most schedulers.  When
+ * they make up more than the CompactionRatio of the event list, the list
+ * is rebuilt without them, so that the event list of a simulation which
+ * cancels many timers, as TCP does with its retransmission timer, stays
+ * close to the number of live events.
  */
 class DefaultSimulatorImpl : public SimulatorImpl
 {
@@ -74,6 +81,7 @@ public:
   virtual Time Now (void) const;
   virtual Time GetDelayLeft (const EventId &id) const;
   virtual Time GetMaximumSimulationTime (void) const;
+  virtual Simulator::EventCounts GetEventCounts (void) const;
   virtual void SetScheduler (ObjectFactory schedulerFactory);
   virtual uint32_t GetSystemId (void) const; 
   virtual uint32_t GetContext (void) const;
@@ -85,6 +93,8 @@ private:
   void ProcessOneEvent (void);
   /** Move events from a different context into the main event queue. */
   void ProcessEventsWithContext (void);
+  /** Remove the cancelled events from the event list. */
+  void Compact (void);
  
   /** Wrap an event with its execution context. */
   struct EventWithContext {
@@ -94,18 +104,17 @@ private:
     uint64_t timestamp;
     /** The event implementation. */
     EventImpl *event;
+    /** The event scheduled before this one. */
+    EventWithContext *next;
   };
-  /** Container type for the events from a different context. */
-  typedef std::list<struct EventWithContext> EventsWithContext;
-  /** The container of events from a different context. */
-  EventsWithContext m_eventsWithContext;
   /**
-   * Flag \c true if all events with context have been moved to the
-   * primary event queue.
+   * The events scheduled from other threads, most recent first.
+   *
+   * The other threads push their events with a compare and swap, and
+   * the main thread takes them all at once with an exchange, so that
+   * neither waits for the other.
    */
-  bool m_eventsWithContextEmpty;
-  /** Mutex to control access to the list of events with context. */
-  SystemMutex m_eventsWithContextMutex;
+  std::atomic<EventWithContext *> m_eventsWithContext;
 
   /** Container type for the events to run at Simulator::Destroy() */
   typedef std::list<EventId> DestroyEvents;
@@ -129,6 +138,18 @@ private:
    *  not counting the Destroy events; this is used for validation
    */
   int m_unscheduledEvents;
+  /** Number of cancelled events still in the event list. */
+  uint64_t m_cancelledEvents;
+  /** Number of compactions of the event list. */
+  uint64_t m_compactions;
+  /** Number of cancelled events removed by the compactions. */
+  uint64_t m_purgedEvents;
+  /** Fraction of cancelled events which triggers a compaction. */
+  double m_compactionRatio;
+  /** Minimum number of events in the event list to compact it. */
+  uint32_t m_compactionMinEvents;
+  /** Whether the scheduler removes the cancelled events. */
+  bool m_compactable;
 
   /** Main execution thread. */
   SystemThread::ThreadId m_main;
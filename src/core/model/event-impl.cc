@@ -21,6 +21,8 @@
 #include "event-impl.h"
 #include "log.h"
 
+#include <cstring>
+
 /**
  * \file
  * \ingroup events
@@ -31,6 +33,131 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("EventImpl");
 
+/**
+ * \ingroup events
+ * Anonymous namespace for the event free lists.
+ */
+namespace {
+
+/** Granularity of the event size classes, in bytes. */
+const std::size_t POOL_GRANULARITY = 16;
+/** Number of size classes: larger events use the system allocator. */
+const std::size_t POOL_CLASSES = 16;
+/** Maximum number of free blocks kept in each size class. */
+const uint32_t POOL_MAX_FREE = 65536;
+
+/** A free block, linked to the next one of its size class. */
+struct FreeBlock
+{
+  FreeBlock *m_next;   //!< The next free block
+};
+
+/**
+ * The free lists of a thread.
+ *
+ * This is trivially destructible, so that it stays usable while the
+ * thread, or the program, exits.
+ */
+struct EventPool
+{
+  FreeBlock *m_free[POOL_CLASSES];  //!< Free blocks, by size class
+  uint32_t m_nFree[POOL_CLASSES];   //!< Number of free blocks, by size class
+  EventImpl::PoolStats m_stats;     //!< Counters
+  bool m_active;                    //!< The cleaner of the thread is registered
+  bool m_exiting;                   //!< The thread exits: free lists are off
+};
+
+/** The free lists of each thread. */
+thread_local EventPool g_eventPool;
+
+/**
+ * Free the blocks of the free lists of a thread when it exits.
+ */
+struct EventPoolCleaner
+{
+  /** Constructor, run on first use in a thread. */
+  EventPoolCleaner ()
+  {
+    g_eventPool.m_active = true;
+  }
+  /** Destructor, run when the thread exits. */
+  ~EventPoolCleaner ()
+  {
+    for (std::size_t c = 0; c < POOL_CLASSES; c++)
+      {
+        while (g_eventPool.m_free[c] != 0)
+          {
+            FreeBlock *block = g_eventPool.m_free[c];
+            g_eventPool.m_free[c] = block->m_next;
+            ::operator delete (block);
+          }
+        g_eventPool.m_nFree[c] = 0;
+      }
+    g_eventPool.m_stats.cached = 0;
+    g_eventPool.m_exiting = true;
+  }
+  /** Make sure the cleaner of the thread is constructed. */
+  void Activate (void)
+  {
+  }
+};
+
+/** The cleaner of each thread. */
+thread_local EventPoolCleaner g_eventPoolCleaner;
+
+} // unnamed namespace
+
+void *
+EventImpl::operator new (std::size_t size)
+{
+  EventPool &pool = g_eventPool;
+  pool.m_stats.allocations++;
+  std::size_t c = (size + POOL_GRANULARITY - 1) / POOL_GRANULARITY - 1;
+  if (c >= POOL_CLASSES)
+    {
+      return ::operator new (size);
+    }
+  FreeBlock *block = pool.m_free[c];
+  if (block != 0)
+    {
+      pool.m_free[c] = block->m_next;
+      pool.m_nFree[c]--;
+      pool.m_stats.reused++;
+      pool.m_stats.cached--;
+      return block;
+    }
+  return ::operator new ((c + 1) * POOL_GRANULARITY);
+}
+
+void
+EventImpl::operator delete (void *p, std::size_t size)
+{
+  EventPool &pool = g_eventPool;
+  pool.m_stats.deallocations++;
+  std::size_t c = (size + POOL_GRANULARITY - 1) / POOL_GRANULARITY - 1;
+  if (c >= POOL_CLASSES || pool.m_exiting || pool.m_nFree[c] == POOL_MAX_FREE)
+    {
+      ::operator delete (p);
+      return;
+    }
+  if (!pool.m_active)
+    {
+      g_eventPoolCleaner.Activate ();
+    }
+  FreeBlock *block = static_cast<FreeBlock *> (p);
+  block->m_next = pool.m_free[c];
+  pool.m_free[c] = block;
+  pool.m_nFree[c]++;
+  pool.m_stats.cached++;
+}
+
+EventImpl::PoolStats
+EventImpl::GetPoolStats (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  return g_eventPool.m_stats;
+}
+
 EventImpl::~EventImpl ()
 {
   NS_LOG_FUNCTION (this);
@@ -66,4 +193,49 @@ EventImpl::IsCancelled (void)
   return m_cancel;
 }
 
+const void *
+EventImpl::GetFunction (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return 0;
+}
+
+const void *
+EventImpl::GetMemberFunctionAddress (const void *object, const void *function,
+                                     std::size_t size)
+{
+  NS_LOG_FUNCTION (object << function << size);
+#if defined (__GNUC__)
+  // A member function pointer is a pair of a code pointer, or of a vtable
+  // offset for virtual functions, and of an adjustment of the object
+  // pointer.  The virtual flag is the low bit of the first word, except on
+  // ARM, where it is the low bit of the adjustment.
+  std::ptrdiff_t pointer;
+  std::ptrdiff_t adjustment;
+  if (size != sizeof (pointer) + sizeof (adjustment))
+    {
+      return 0;
+    }
+  std::memcpy (&pointer, function, sizeof (pointer));
+  std::memcpy (&adjustment, static_cast<const char *> (function) + sizeof (pointer),
+               sizeof (adjustment));
+#if defined (__arm__) || defined (__aarch64__)
+  bool isVirtual = (adjustment & 1) != 0;
+  adjustment >>= 1;
+#else
+  bool isVirtual = (pointer & 1) != 0;
+  pointer -= isVirtual ? 1 : 0;
+#endif
+  if (!isVirtual)
+    {
+      return reinterpret_cast<const void *> (pointer);
+    }
+  const char *self = static_cast<const char *> (object) + adjustment;
+  const char *vtable = *reinterpret_cast<const char * const *> (self);
+  return *reinterpret_cast<const void * const *> (vtable + pointer);
+#else
+  return 0;
+#endif
+}
+
 } // namespace ns3
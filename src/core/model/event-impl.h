@@ -21,6 +21,7 @@
 #define EVENT_IMPL_H
 
 #include <stdint.h>
+#include <cstddef>
 #include "simple-ref-count.h"
 
 /**
@@ -40,6 +41,14 @@ namespace ns3 {
  * when it reaches the time associated to this event. Most subclasses
  * are usually created by one of the many Simulator::Schedule
  * methods.
+ *
+ * Events are allocated from per-thread free lists, one per size class,
+ * so that the memory of the events which were run or destroyed is
+ * reused by the next ones without going through the system allocator.
+ * An event may be freed by another thread than the one which allocated
+ * it, as happens with ScheduleWithContext, in which case its memory
+ * moves to the free lists of the freeing thread.  GetPoolStats reports
+ * the use of the free lists of the calling thread.
  */
 class EventImpl : public SimpleRefCount<EventImpl>
 {
@@ -66,6 +75,62 @@ public:
    */
   bool IsCancelled (void);
 
+  /**
+   * Allocate the memory of an event from the free lists.
+   *
+   * \param [in] size The size of the event.
+   * \returns The memory of the event.
+   */
+  static void * operator new (std::size_t size);
+  /**
+   * Return the memory of an event to the free lists.
+   *
+   * \param [in] p The memory of the event.
+   * \param [in] size The size of the event.
+   */
+  static void operator delete (void *p, std::size_t size);
+
+  /** Counters of the event free lists of a thread. */
+  struct PoolStats
+  {
+    uint64_t allocations;   //!< Events allocated
+    uint64_t reused;        //!< Events allocated from a free list
+    uint64_t deallocations; //!< Events freed
+    uint64_t cached;        //!< Blocks currently held in the free lists
+  };
+  /**
+   * Get the counters of the event free lists of the calling thread.
+   *
+   * Events larger than the largest size class are counted, but are
+   * allocated and freed by the system allocator.
+   *
+   * \returns The counters.
+   */
+  static PoolStats GetPoolStats (void);
+
+  /**
+   * Get the function called by the event, so that profilers such as
+   * ProfilingSimulatorImpl can attribute the event to its callsite.
+   *
+   * \returns The address of the function or member function which
+   *          Notify() calls, or 0 if it is not known.
+   */
+  virtual const void * GetFunction (void) const;
+  /**
+   * Get the address of the code which a member function pointer calls
+   * on an object, looking up the virtual functions in its vtable.
+   *
+   * This decodes the member function pointers of the Itanium C++ ABI,
+   * used by gcc and clang, and returns 0 with other compilers.
+   *
+   * \param [in] object The object, converted to the class of the member function.
+   * \param [in] function The member function pointer.
+   * \param [in] size The size of the member function pointer.
+   * \returns The address of the code, or 0 if it is not known.
+   */
+  static const void * GetMemberFunctionAddress (const void *object, const void *function,
+                                                std::size_t size);
+
 protected:
   /**
    * Implementation for Invoke().
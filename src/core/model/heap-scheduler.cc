@@ -236,6 +236,13 @@ HeapScheduler::Remove (const Event &ev)
           NS_ASSERT (m_heap[i].impl == ev.impl);
           Exch (i, Last ());
           m_heap.pop_back ();
+          // The last event may belong above or below the removed one
+          while (i < m_heap.size () && !IsRoot (i)
+                 && IsLessStrictly (i, Parent (i)))
+            {
+              Exch (i, Parent (i));
+              i = Parent (i);
+            }
           TopDown (i);
           return;
         }
@@ -243,5 +250,29 @@ HeapScheduler::Remove (const Event &ev)
   NS_ASSERT (false);
 }
 
+void
+HeapScheduler::RemoveCancelled (std::vector<Scheduler::Event> &removed)
+{
+  NS_LOG_FUNCTION (this);
+  uint32_t last = Root ();
+  for (uint32_t i = Root (); i < m_heap.size (); i++)
+    {
+      if (m_heap[i].impl->IsCancelled ())
+        {
+          removed.push_back (m_heap[i]);
+        }
+      else
+        {
+          m_heap[last++] = m_heap[i];
+        }
+    }
+  m_heap.resize (last);
+  // Rebuild the heap from the bottom, in linear time
+  for (uint32_t i = Parent (Last ()); i >= Root (); i--)
+    {
+      TopDown (i);
+    }
+}
+
 } // namespace ns3
 
@@ -0,0 +1,362 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ladder-scheduler.h"
+#include "event-impl.h"
+#include "assert.h"
+#include "log.h"
+#include <algorithm>
+
+/**
+ * \file
+ * \ingroup scheduler
+ * Implementation of ns3::LadderScheduler class.
+ */
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("LadderScheduler");
+
+NS_OBJECT_ENSURE_REGISTERED (LadderScheduler);
+
+const uint32_t LadderScheduler::BUCKET_THRESHOLD;
+const uint32_t LadderScheduler::BOTTOM_THRESHOLD;
+const uint32_t LadderScheduler::MAX_RUNGS;
+
+TypeId
+LadderScheduler::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::LadderScheduler")
+    .SetParent<Scheduler> ()
+    .SetGroupName ("Core")
+    .AddConstructor<LadderScheduler> ()
+  ;
+  return tid;
+}
+
+LadderScheduler::LadderScheduler ()
+  : m_topMin (0),
+    m_topMax (0),
+    m_topStart (0),
+    m_rungs (MAX_RUNGS),
+    m_nRungs (0),
+    m_bottomHead (0),
+    m_size (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+LadderScheduler::~LadderScheduler ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+uint64_t
+LadderScheduler::GetCurrentStart (const Rung &rung)
+{
+  return rung.m_start + rung.m_current * rung.m_width;
+}
+
+void
+LadderScheduler::InsertBottom (const Scheduler::Event &ev)
+{
+  NS_LOG_FUNCTION (this << ev.key.m_ts << ev.key.m_uid);
+  // New events are usually due after those of Bottom, so close to its end
+  Bucket::iterator i = std::upper_bound (m_bottom.begin () + m_bottomHead, m_bottom.end (), ev);
+  m_bottom.insert (i, ev);
+  if (m_bottom.size () - m_bottomHead > BOTTOM_THRESHOLD && m_nRungs < MAX_RUNGS)
+    {
+      SpillBottom ();
+    }
+}
+
+void
+LadderScheduler::SpillBottom (void)
+{
+  NS_LOG_FUNCTION (this << m_bottom.size () - m_bottomHead);
+  // The events of Bottom are all due before the events of the Ladder and
+  // of Top, and the new rung covers the whole gap up to them
+  uint64_t end = m_nRungs > 0 ? GetCurrentStart (m_rungs[m_nRungs - 1]) : m_topStart;
+  uint32_t nBuckets = m_bottom.size () - m_bottomHead;
+  Rung &rung = m_rungs[m_nRungs];
+  rung.m_start = m_bottom[m_bottomHead].key.m_ts;
+  NS_ASSERT (end > rung.m_start);
+  rung.m_width = (end - rung.m_start) / nBuckets + 1;
+  rung.m_current = 0;
+  rung.m_buckets.resize (nBuckets);
+  for (Bucket::const_iterator i = m_bottom.begin () + m_bottomHead; i != m_bottom.end (); ++i)
+    {
+      rung.m_buckets[(i->key.m_ts - rung.m_start) / rung.m_width].push_back (*i);
+    }
+  m_bottom.clear ();
+  m_bottomHead = 0;
+  m_nRungs++;
+}
+
+void
+LadderScheduler::SetBottom (Bucket &events)
+{
+  NS_LOG_FUNCTION (this << events.size ());
+  m_bottom.clear ();
+  m_bottom.swap (events);
+  m_bottomHead = 0;
+  std::sort (m_bottom.begin (), m_bottom.end ());
+}
+
+void
+LadderScheduler::Insert (const Scheduler::Event &ev)
+{
+  NS_LOG_FUNCTION (this << ev.key.m_ts << ev.key.m_uid);
+  uint64_t ts = ev.key.m_ts;
+  m_size++;
+  if (ts >= m_topStart)
+    {
+      if (m_top.empty ())
+        {
+          m_topMin = ts;
+          m_topMax = ts;
+        }
+      else
+        {
+          m_topMin = std::min (m_topMin, ts);
+          m_topMax = std::max (m_topMax, ts);
+        }
+      m_top.push_back (ev);
+      NS_LOG_LOGIC ("insert in top");
+    }
+  else
+    {
+      uint32_t i = 0;
+      while (i < m_nRungs && ts < GetCurrentStart (m_rungs[i]))
+        {
+          i++;
+        }
+      if (i < m_nRungs)
+        {
+          Rung &rung = m_rungs[i];
+          uint64_t bucket = (ts - rung.m_start) / rung.m_width;
+          NS_ASSERT (bucket < rung.m_buckets.size ());
+          rung.m_buckets[bucket].push_back (ev);
+          NS_LOG_LOGIC ("insert in rung " << i << ", bucket " << bucket);
+        }
+      else
+        {
+          NS_LOG_LOGIC ("insert in bottom");
+          InsertBottom (ev);
+        }
+    }
+  // Bottom is only empty if the scheduler was
+  if (m_bottomHead == m_bottom.size ())
+    {
+      FillBottom ();
+    }
+}
+
+bool
+LadderScheduler::IsEmpty (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_size == 0;
+}
+
+Scheduler::Event
+LadderScheduler::PeekNext (void) const
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (!IsEmpty ());
+  return m_bottom[m_bottomHead];
+}
+
+Scheduler::Event
+LadderScheduler::RemoveNext (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (!IsEmpty ());
+  Scheduler::Event ev = m_bottom[m_bottomHead++];
+  m_size--;
+  if (m_bottomHead == m_bottom.size ())
+    {
+      FillBottom ();
+    }
+  return ev;
+}
+
+void
+LadderScheduler::RemoveFromBucket (Bucket &bucket, const Scheduler::Event &ev)
+{
+  for (Bucket::iterator i = bucket.begin (); i != bucket.end (); ++i)
+    {
+      if (i->key.m_uid == ev.key.m_uid)
+        {
+          NS_ASSERT (i->impl == ev.impl);
+          *i = bucket.back ();
+          bucket.pop_back ();
+          return;
+        }
+    }
+  NS_ASSERT (false);
+}
+
+void
+LadderScheduler::Remove (const Scheduler::Event &ev)
+{
+  NS_LOG_FUNCTION (this << ev.key.m_ts << ev.key.m_uid);
+  NS_ASSERT (!IsEmpty ());
+  uint64_t ts = ev.key.m_ts;
+  m_size--;
+  if (ts >= m_topStart)
+    {
+      // The bounds of Top may become loose, which is harmless
+      RemoveFromBucket (m_top, ev);
+      return;
+    }
+  for (uint32_t i = 0; i < m_nRungs; i++)
+    {
+      Rung &rung = m_rungs[i];
+      if (ts >= GetCurrentStart (rung))
+        {
+          RemoveFromBucket (rung.m_buckets[(ts - rung.m_start) / rung.m_width], ev);
+          return;
+        }
+    }
+  Bucket::iterator i = std::lower_bound (m_bottom.begin () + m_bottomHead, m_bottom.end (), ev);
+  NS_ASSERT (i != m_bottom.end () && i->key.m_uid == ev.key.m_uid);
+  m_bottom.erase (i);
+  if (m_bottomHead == m_bottom.size ())
+    {
+      FillBottom ();
+    }
+}
+
+void
+LadderScheduler::RemoveCancelledFromBucket (Bucket &bucket, uint32_t first,
+                                            std::vector<Scheduler::Event> &removed)
+{
+  uint32_t last = first;
+  for (uint32_t i = first; i < bucket.size (); i++)
+    {
+      if (bucket[i].impl->IsCancelled ())
+        {
+          removed.push_back (bucket[i]);
+        }
+      else
+        {
+          bucket[last++] = bucket[i];
+        }
+    }
+  bucket.resize (last);
+}
+
+void
+LadderScheduler::RemoveCancelled (std::vector<Scheduler::Event> &removed)
+{
+  NS_LOG_FUNCTION (this);
+  uint32_t before = removed.size ();
+  // The bounds of Top may become loose, which is harmless
+  RemoveCancelledFromBucket (m_top, 0, removed);
+  for (uint32_t i = 0; i < m_nRungs; i++)
+    {
+      Rung &rung = m_rungs[i];
+      for (uint32_t j = rung.m_current; j < rung.m_buckets.size (); j++)
+        {
+          RemoveCancelledFromBucket (rung.m_buckets[j], 0, removed);
+        }
+    }
+  RemoveCancelledFromBucket (m_bottom, m_bottomHead, removed);
+  m_size -= removed.size () - before;
+  if (m_bottomHead == m_bottom.size ())
+    {
+      FillBottom ();
+    }
+}
+
+void
+LadderScheduler::TransferTop (void)
+{
+  NS_LOG_FUNCTION (this << m_top.size () << m_topMin << m_topMax);
+  NS_ASSERT (m_nRungs == 0);
+  if (m_top.size () <= BUCKET_THRESHOLD || m_topMin == m_topMax)
+    {
+      SetBottom (m_top);
+      m_topStart = m_topMax + 1;
+      return;
+    }
+  uint32_t nBuckets = m_top.size ();
+  Rung &rung = m_rungs[0];
+  rung.m_start = m_topMin;
+  rung.m_width = (m_topMax - m_topMin) / nBuckets + 1;
+  rung.m_current = 0;
+  rung.m_buckets.resize (nBuckets);
+  for (Bucket::const_iterator i = m_top.begin (); i != m_top.end (); ++i)
+    {
+      rung.m_buckets[(i->key.m_ts - rung.m_start) / rung.m_width].push_back (*i);
+    }
+  m_top.clear ();
+  m_nRungs = 1;
+  m_topStart = rung.m_start + nBuckets * rung.m_width;
+}
+
+void
+LadderScheduler::FillBottom (void)
+{
+  NS_LOG_FUNCTION (this);
+  while (m_bottomHead == m_bottom.size () && m_size > 0)
+    {
+      if (m_nRungs == 0)
+        {
+          TransferTop ();
+          continue;
+        }
+      Rung &rung = m_rungs[m_nRungs - 1];
+      uint32_t nBuckets = rung.m_buckets.size ();
+      while (rung.m_current < nBuckets && rung.m_buckets[rung.m_current].empty ())
+        {
+          rung.m_current++;
+        }
+      if (rung.m_current == nBuckets)
+        {
+          NS_LOG_LOGIC ("rung " << m_nRungs - 1 << " exhausted");
+          m_nRungs--;
+          continue;
+        }
+      Bucket &bucket = rung.m_buckets[rung.m_current];
+      if (bucket.size () <= BUCKET_THRESHOLD || rung.m_width == 1 || m_nRungs == MAX_RUNGS)
+        {
+          NS_LOG_LOGIC ("bucket " << rung.m_current << " of rung " << m_nRungs - 1 << " to bottom");
+          SetBottom (bucket);
+          rung.m_current++;
+          continue;
+        }
+      // Spread the bucket in a new rung, covering its range
+      NS_LOG_LOGIC ("bucket " << rung.m_current << " of rung " << m_nRungs - 1 << " to a new rung");
+      Rung &child = m_rungs[m_nRungs];
+      uint32_t nChildBuckets = bucket.size ();
+      child.m_start = GetCurrentStart (rung);
+      child.m_width = (rung.m_width + nChildBuckets - 1) / nChildBuckets;
+      child.m_current = 0;
+      child.m_buckets.resize (nChildBuckets);
+      for (Bucket::const_iterator i = bucket.begin (); i != bucket.end (); ++i)
+        {
+          child.m_buckets[(i->key.m_ts - child.m_start) / child.m_width].push_back (*i);
+        }
+      bucket.clear ();
+      rung.m_current++;
+      m_nRungs++;
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,169 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef LADDER_SCHEDULER_H
+#define LADDER_SCHEDULER_H
+
+#include "scheduler.h"
+#include <stdint.h>
+#include <vector>
+
+/**
+ * \file
+ * \ingroup scheduler
+ * Declaration of ns3::LadderScheduler class.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup scheduler
+ * \brief a ladder queue event scheduler
+ *
+ * This is the Ladder Queue of W. T. Tang, R. S. M. Goh and I. L.-J. Thng,
+ * "Ladder Queue: An O(1) Priority Queue Structure for Large-Scale
+ * Discrete Event Simulation", ACM TOMACS 15(3), 2005.
+ *
+ * The events are kept in three tiers:
+ *  - Top: an unsorted array of the events far in the future, with their
+ *    minimum and maximum timestamps;
+ *  - the Ladder: rungs of buckets, each bucket covering a range of
+ *    timestamps.  When Top is needed, its events are spread in the buckets
+ *    of the first rung.  A bucket holding too many events when its turn
+ *    comes is spread in turn in the buckets of a new, finer, rung;
+ *  - Bottom: a sorted array of the next events, filled with the first
+ *    non-empty bucket of the last rung.
+ *
+ * Inserting an event appends it to Top or to a bucket, or, if it is due
+ * before the first bucket left in the Ladder, inserts it in Bottom.  When
+ * Bottom grows too large, it is spread in a new rung in turn.  Each
+ * event is thus moved a few times between arrays, but is only sorted with
+ * the few events of its bucket, which makes both Insert and RemoveNext run
+ * in amortized constant time, on contiguous memory, whatever the number of
+ * events.
+ *
+ * Remove searches the tier, then the bucket, of the event, and is linear
+ * in the size of the bucket or of Top.
+ */
+class LadderScheduler : public Scheduler
+{
+public:
+  /**
+   *  Register this type.
+   *  \return The object TypeId.
+   */
+  static TypeId GetTypeId (void);
+
+  /** Constructor. */
+  LadderScheduler ();
+  /** Destructor. */
+  virtual ~LadderScheduler ();
+
+  // Inherited
+  virtual void Insert (const Scheduler::Event &ev);
+  virtual bool IsEmpty (void) const;
+  virtual Scheduler::Event PeekNext (void) const;
+  virtual Scheduler::Event RemoveNext (void);
+  virtual void Remove (const Scheduler::Event &ev);
+  virtual void RemoveCancelled (std::vector<Scheduler::Event> &removed);
+
+private:
+  /** Bucket type: an unsorted array of events. */
+  typedef std::vector<Scheduler::Event> Bucket;
+
+  /** A rung of the Ladder. */
+  struct Rung
+  {
+    uint64_t m_start;               //!< Timestamp of the start of the first bucket
+    uint64_t m_width;               //!< Range of timestamps of each bucket
+    uint32_t m_current;             //!< Index of the first bucket not yet consumed
+    std::vector<Bucket> m_buckets;  //!< The buckets
+  };
+
+  /**
+   * Get the start of the first bucket not yet consumed in a rung.
+   *
+   * \param [in] rung The rung.
+   * \returns The timestamp from which the events are placed in the rung.
+   */
+  static uint64_t GetCurrentStart (const Rung &rung);
+  /**
+   * Insert an event in Bottom, at its place.
+   *
+   * \param [in] ev The event.
+   */
+  void InsertBottom (const Scheduler::Event &ev);
+  /**
+   * Replace the empty Bottom with some events, and sort them.
+   *
+   * \param [in,out] events The events, left empty.
+   */
+  void SetBottom (Bucket &events);
+  /**
+   * Remove an event from an unsorted array.
+   *
+   * \param [in,out] bucket The array.
+   * \param [in] ev The event.
+   */
+  static void RemoveFromBucket (Bucket &bucket, const Scheduler::Event &ev);
+  /**
+   * Remove the cancelled events from an array, keeping the order of the
+   * others.
+   *
+   * \param [in,out] bucket The array.
+   * \param [in] first The index of the first event to check.
+   * \param [out] removed The cancelled events, appended to it.
+   */
+  static void RemoveCancelledFromBucket (Bucket &bucket, uint32_t first,
+                                         std::vector<Scheduler::Event> &removed);
+  /**
+   * Spread the events of Bottom in a new rung, below the last one.
+   */
+  void SpillBottom (void);
+  /**
+   * Move the events of Top to the first rung, or to Bottom if they are few.
+   */
+  void TransferTop (void);
+  /**
+   * Fill Bottom with the next events, if it is empty.
+   *
+   * Bottom is only empty when the scheduler is, so that PeekNext has
+   * nothing to do.
+   */
+  void FillBottom (void);
+
+  /** Above this number of events, a bucket is spread in a new rung. */
+  static const uint32_t BUCKET_THRESHOLD = 50;
+  /** Above this number of events, Bottom is spread in a new rung. */
+  static const uint32_t BOTTOM_THRESHOLD = 256;
+  /** Maximum number of rungs. */
+  static const uint32_t MAX_RUNGS = 8;
+
+  Bucket m_top;             //!< Events of Top
+  uint64_t m_topMin;        //!< Minimum timestamp in Top
+  uint64_t m_topMax;        //!< Maximum timestamp in Top
+  uint64_t m_topStart;      //!< Timestamp from which events go to Top
+  std::vector<Rung> m_rungs; //!< The rungs, kept allocated to reuse their buckets
+  uint32_t m_nRungs;        //!< Number of rungs in use
+  Bucket m_bottom;          //!< Events of Bottom, sorted, some already removed
+  uint32_t m_bottomHead;    //!< Index of the next event in m_bottom
+  uint32_t m_size;          //!< Number of events
+};
+
+} // namespace ns3
+
+#endif /* LADDER_SCHEDULER_H */
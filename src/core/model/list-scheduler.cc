@@ -108,4 +108,23 @@ ListScheduler::Remove (const Event &ev)
   NS_ASSERT (false);
 }
 
+void
+ListScheduler::RemoveCancelled (std::vector<Scheduler::Event> &removed)
+{
+  NS_LOG_FUNCTION (this);
+  EventsI i = m_events.begin ();
+  while (i != m_events.end ())
+    {
+      if (i->impl->IsCancelled ())
+        {
+          removed.push_back (*i);
+          i = m_events.erase (i);
+        }
+      else
+        {
+          ++i;
+        }
+    }
+}
+
 } // namespace ns3
@@ -25,6 +25,7 @@
 #include "attribute-helper.h"
 #include "int64x64.h"
 #include "unused.h"
+#include "ns3/core-config.h"
 #include <stdint.h>
 #include <limits>
 #include <cmath>
@@ -92,6 +93,15 @@ class TimeWithUnit;
  * data structure and stop tracking new instances, so we have no way
  * to do a second conversion.)
  *
+ * The resolution can also be fixed when ns-3 is configured, with
+ * \c --time-resolution=NS for example.  The conversions between the
+ * resolution and the other units are then multiplications or divisions
+ * by constants, instead of lookups in the conversion table and
+ * int64x64_t arithmetic, and Time objects are never tracked.
+ * SetResolution() only accepts the fixed resolution.  The conversions
+ * to doubles, such as GetSeconds(), are then rounded to the nearest
+ * double, and may differ in the last bit from those of the default build.
+ *
  * If you increase the global resolution, you also implicitly decrease
  * the range of your simulation.  The global simulation time is stored
  * in a 64 bit integer, whose interpretation will depend on the global
@@ -395,6 +405,9 @@ public:
    * Change the global resolution used to convert all
    * user-provided time values in Time objects and Time objects
    * in user-expected time units.
+   *
+   * If the resolution was fixed at configuration, \p resolution must be
+   * that resolution.
    */
   static void SetResolution (enum Unit resolution);
   /**
@@ -428,20 +441,41 @@ public:
    */
   inline static Time FromInteger (uint64_t value, enum Unit unit)
   {
+#ifdef NS3_TIME_RESOLUTION
+    const bool fromMul = FixedFromMul (unit);
+    const int64_t factor = FixedFactor (unit);
+#else
     struct Information *info = PeekInformation (unit);
-    if (info->fromMul)
+    const bool fromMul = info->fromMul;
+    const int64_t factor = info->factor;
+#endif
+    if (fromMul)
       {
-        value *= info->factor;
+        value *= factor;
       }
     else
       {
-        value /= info->factor;
+        value /= factor;
       }
     return Time (value);
   }
   inline static Time FromDouble (double value, enum Unit unit)
   {
+#ifdef NS3_TIME_RESOLUTION
+    // Rounded down, as From (int64x64_t) does
+    long double v = value;
+    if (FixedFromMul (unit))
+      {
+        v *= FixedFactor (unit);
+      }
+    else
+      {
+        v /= FixedFactor (unit);
+      }
+    return Time (static_cast<int64_t> (std::floor (v)));
+#else
     return From (int64x64_t (value), unit);
+#endif
   }
   inline static Time From (const int64x64_t & value, enum Unit unit)
   {
@@ -476,21 +510,33 @@ public:
    */
   inline int64_t ToInteger (enum Unit unit) const
   {
+#ifdef NS3_TIME_RESOLUTION
+    const bool toMul = !FixedFromMul (unit);
+    const int64_t factor = FixedFactor (unit);
+#else
     struct Information *info = PeekInformation (unit);
+    const bool toMul = info->toMul;
+    const int64_t factor = info->factor;
+#endif
     int64_t v = m_data;
-    if (info->toMul)
+    if (toMul)
       {
-        v *= info->factor;
+        v *= factor;
       }
     else
       {
-        v /= info->factor;
+        v /= factor;
       }
     return v;
   }
   inline double ToDouble (enum Unit unit) const
   {
+#ifdef NS3_TIME_RESOLUTION
+    const double factor = FixedFactor (unit);
+    return FixedFromMul (unit) ? m_data / factor : m_data * factor;
+#else
     return To (unit).GetDouble ();
+#endif
   }
   inline int64x64_t To (enum Unit unit) const
   {
@@ -575,6 +621,55 @@ private:
    * \return The Resolution object for the default resolution.
    */
   static struct Resolution SetDefaultNsResolution (void);
+
+#ifdef NS3_TIME_RESOLUTION
+  /**
+   * \name Fixed resolution.
+   * Conversion factors between the units and the resolution fixed
+   * at configuration, which the compiler folds into constants.
+   *
+   * @{
+   */
+  /** The resolution fixed at configuration. */
+  static constexpr enum Unit FIXED_RESOLUTION = NS3_TIME_RESOLUTION;
+  /**
+   * \param [in] n A multiple of 3, up to 15.
+   * \returns 10 to the power \p n.
+   */
+  static constexpr int64_t FixedPow10 (int n)
+  {
+    return n == 0 ? 1 : n == 3 ? 1000 : n == 6 ? 1000000 : n == 9 ? 1000000000
+      : n == 12 ? 1000000000000LL : 1000000000000000LL;
+  }
+  /**
+   * \param [in] unit A unit, at least a second.
+   * \returns The number of seconds in \p unit.
+   */
+  static constexpr int64_t FixedSeconds (enum Unit unit)
+  {
+    return unit == Y ? 31536000 : unit == D ? 86400 : unit == H ? 3600 : unit == MIN ? 60 : 1;
+  }
+  /**
+   * \param [in] unit A unit.
+   * \returns \c true if converting from \p unit to the resolution
+   *          multiplies by FixedFactor(), \c false if it divides.
+   */
+  static constexpr bool FixedFromMul (enum Unit unit)
+  {
+    return unit <= FIXED_RESOLUTION;
+  }
+  /**
+   * \param [in] unit A unit.
+   * \returns The ratio between \p unit and the resolution, or its inverse,
+   *          whichever is an integer.
+   */
+  static constexpr int64_t FixedFactor (enum Unit unit)
+  {
+    return unit <= S ? FixedSeconds (unit) * FixedPow10 (3 * (FIXED_RESOLUTION - S))
+      : FixedPow10 (3 * (unit < FIXED_RESOLUTION ? FIXED_RESOLUTION - unit : unit - FIXED_RESOLUTION));
+  }
+  /**@}*/
+#endif /* NS3_TIME_RESOLUTION */
   /**
    *  Set the current Resolution.
    *
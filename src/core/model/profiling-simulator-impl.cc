@@ -0,0 +1,498 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "profiling-simulator-impl.h"
+#include "default-simulator-impl.h"
+#include "string.h"
+#include "abort.h"
+#include "log.h"
+#include "ns3/core-config.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#if defined (HAVE_DLFCN_H) && defined (HAVE_DL)
+#include <dlfcn.h>
+#endif
+#if (__GNUC__ >= 3)
+#include <cxxabi.h>
+#endif
+
+/**
+ * \file
+ * \ingroup simulator
+ * Implementation of class ns3::ProfilingSimulatorImpl.
+ */
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("ProfilingSimulatorImpl");
+
+NS_OBJECT_ENSURE_REGISTERED (ProfilingSimulatorImpl);
+
+namespace {
+
+/**
+ * \ingroup simulator
+ * Get the factory of the default simulator implementation.
+ * \returns The factory.
+ */
+ObjectFactory
+GetDefaultSimulatorImplFactory (void)
+{
+  ObjectFactory factory;
+  factory.SetTypeId (DefaultSimulatorImpl::GetTypeId ());
+  return factory;
+}
+
+/**
+ * \ingroup simulator
+ * Demangle a symbol or type name.
+ * \param [in] mangled The mangled name.
+ * \returns The demangled name, or \p mangled if it cannot be demangled.
+ */
+std::string
+Demangle (const char *mangled)
+{
+  std::string name = mangled;
+#if (__GNUC__ >= 3)
+  int status;
+  char *demangled = abi::__cxa_demangle (mangled, 0, 0, &status);
+  if (status == 0 && demangled != 0)
+    {
+      name = demangled;
+    }
+  std::free (demangled);
+#endif
+  return name;
+}
+
+} // unnamed namespace
+
+/**
+ * \ingroup simulator
+ * An event which runs the event it wraps through the profiler.
+ */
+class ProfilingSimulatorImpl::ProfiledEvent : public EventImpl
+{
+public:
+  /**
+   * Constructor.
+   * \param [in] profiler The profiler.
+   * \param [in] event The event, whose reference is taken over.
+   */
+  ProfiledEvent (ProfilingSimulatorImpl *profiler, EventImpl *event)
+    : m_profiler (profiler),
+      m_event (event)
+  {
+  }
+  virtual ~ProfiledEvent ()
+  {
+    m_event->Unref ();
+  }
+  virtual const void * GetFunction (void) const
+  {
+    return m_event->GetFunction ();
+  }
+private:
+  virtual void Notify (void)
+  {
+    m_profiler->Invoke (m_event);
+  }
+  ProfilingSimulatorImpl *m_profiler;  //!< The profiler
+  EventImpl *m_event;                  //!< The wrapped event
+};
+
+bool
+ProfilingSimulatorImpl::Site::operator < (const Site &o) const
+{
+  if (function != o.function)
+    {
+      return function < o.function;
+    }
+  if (type != o.type)
+    {
+      return type < o.type;
+    }
+  return context < o.context;
+}
+
+TypeId
+ProfilingSimulatorImpl::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::ProfilingSimulatorImpl")
+    .SetParent<SimulatorImpl> ()
+    .SetGroupName ("Core")
+    .AddConstructor<ProfilingSimulatorImpl> ()
+    .AddAttribute ("SimulatorImplFactory",
+                   "Factory of the simulator implementation running the events.",
+                   ObjectFactoryValue (GetDefaultSimulatorImplFactory ()),
+                   MakeObjectFactoryAccessor (&ProfilingSimulatorImpl::m_simulatorImplFactory),
+                   MakeObjectFactoryChecker ())
+    .AddAttribute ("ReportFile",
+                   "File of the report of the callsites sorted by wall-clock time, "
+                   "written when the simulator is destroyed; the standard output "
+                   "if empty.",
+                   StringValue (""),
+                   MakeStringAccessor (&ProfilingSimulatorImpl::m_reportFile),
+                   MakeStringChecker ())
+    .AddAttribute ("FoldedFile",
+                   "File of the wall-clock time of the callsites in the folded "
+                   "stack format of flamegraph.pl, written when the simulator is "
+                   "destroyed; none if empty.",
+                   StringValue (""),
+                   MakeStringAccessor (&ProfilingSimulatorImpl::m_foldedFile),
+                   MakeStringChecker ())
+  ;
+  return tid;
+}
+
+ProfilingSimulatorImpl::ProfilingSimulatorImpl ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+ProfilingSimulatorImpl::~ProfilingSimulatorImpl ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+ProfilingSimulatorImpl::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_simulator)
+    {
+      m_simulator->Dispose ();
+      m_simulator = 0;
+    }
+  SimulatorImpl::DoDispose ();
+}
+
+void
+ProfilingSimulatorImpl::NotifyConstructionCompleted (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_simulator = m_simulatorImplFactory.Create<SimulatorImpl> ();
+  SimulatorImpl::NotifyConstructionCompleted ();
+}
+
+EventImpl *
+ProfilingSimulatorImpl::Wrap (EventImpl *event)
+{
+  return new ProfiledEvent (this, event);
+}
+
+void
+ProfilingSimulatorImpl::Invoke (EventImpl *event)
+{
+  Site site;
+  site.function = event->GetFunction ();
+  // The events which call the same function are counted together,
+  // whatever the types of their arguments
+  site.type = site.function == 0 ? &typeid (*event) : 0;
+  site.context = m_simulator->GetContext ();
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now ();
+  event->Invoke ();
+  std::chrono::steady_clock::duration elapsed = std::chrono::steady_clock::now () - start;
+
+  Measure &measure = m_sites[site];
+  measure.count++;
+  measure.nanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds> (elapsed).count ();
+  if (measure.type == 0)
+    {
+      measure.type = &typeid (*event);
+    }
+}
+
+void
+ProfilingSimulatorImpl::Destroy ()
+{
+  NS_LOG_FUNCTION (this);
+  m_simulator->Destroy ();
+
+  if (m_reportFile.empty ())
+    {
+      WriteReport (std::cout);
+    }
+  else
+    {
+      std::ofstream os (m_reportFile.c_str ());
+      NS_ABORT_MSG_UNLESS (os.is_open (), "Cannot open the profile report " << m_reportFile);
+      WriteReport (os);
+    }
+  if (!m_foldedFile.empty ())
+    {
+      std::ofstream os (m_foldedFile.c_str ());
+      NS_ABORT_MSG_UNLESS (os.is_open (), "Cannot open the folded stacks " << m_foldedFile);
+      WriteFolded (os);
+    }
+  m_sites.clear ();
+}
+
+std::string
+ProfilingSimulatorImpl::GetName (const Site &site, const Measure &measure)
+{
+#if defined (HAVE_DLFCN_H) && defined (HAVE_DL)
+  Dl_info info;
+  if (site.function != 0 && dladdr (site.function, &info) != 0
+      && info.dli_sname != 0 && info.dli_saddr == site.function)
+    {
+      return Demangle (info.dli_sname);
+    }
+#endif
+  std::ostringstream oss;
+  oss << Demangle (measure.type->name ());
+  if (site.function != 0)
+    {
+      oss << " [" << site.function << "]";
+    }
+  return oss.str ();
+}
+
+std::string
+ProfilingSimulatorImpl::GetContextName (uint32_t context)
+{
+  if (context == Simulator::NO_CONTEXT)
+    {
+      return "no context";
+    }
+  std::ostringstream oss;
+  oss << "context " << context;
+  return oss.str ();
+}
+
+namespace {
+
+/**
+ * \ingroup simulator
+ * Order the measures by decreasing time.
+ * \param [in] a The first measure.
+ * \param [in] b The second measure.
+ * \returns \c true if \p a took more time than \p b.
+ */
+template <typename T>
+bool
+IsSlower (const std::pair<T, std::pair<uint64_t, uint64_t> > &a,
+          const std::pair<T, std::pair<uint64_t, uint64_t> > &b)
+{
+  return a.second.second > b.second.second;
+}
+
+} // unnamed namespace
+
+void
+ProfilingSimulatorImpl::WriteReport (std::ostream &os) const
+{
+  NS_LOG_FUNCTION (this);
+  // The count and time of each function, over all the contexts, and of
+  // each function and context
+  typedef std::pair<uint64_t, uint64_t> Total;
+  std::map<std::string, Total> functions;
+  std::vector<std::pair<std::pair<std::string, uint32_t>, Total> > sites;
+  Total total (0, 0);
+  for (Sites::const_iterator i = m_sites.begin (); i != m_sites.end (); ++i)
+    {
+      std::string name = GetName (i->first, i->second);
+      Total &function = functions[name];
+      function.first += i->second.count;
+      function.second += i->second.nanoseconds;
+      sites.push_back (std::make_pair (std::make_pair (name, i->first.context),
+                                       Total (i->second.count, i->second.nanoseconds)));
+      total.first += i->second.count;
+      total.second += i->second.nanoseconds;
+    }
+  std::vector<std::pair<std::string, Total> > sorted (functions.begin (), functions.end ());
+  std::stable_sort (sorted.begin (), sorted.end (), IsSlower<std::string>);
+  std::stable_sort (sites.begin (), sites.end (), IsSlower<std::pair<std::string, uint32_t> >);
+
+  std::ios_base::fmtflags flags = os.flags ();
+  std::streamsize precision = os.precision ();
+  os << std::fixed;
+  os << "Wall-clock time of the events: " << std::setprecision (6) << total.second * 1e-9
+     << " s in " << total.first << " events" << std::endl;
+
+  os << std::endl << "By function:" << std::endl;
+  os << std::right << std::setw (12) << "Time (s)" << std::setw (8) << "Share"
+     << std::setw (12) << "Events" << std::setw (12) << "Mean (us)"
+     << "  Function" << std::endl;
+  for (std::vector<std::pair<std::string, Total> >::const_iterator i = sorted.begin ();
+       i != sorted.end (); ++i)
+    {
+      const Total &t = i->second;
+      os << std::setw (12) << std::setprecision (6) << t.second * 1e-9
+         << std::setw (7) << std::setprecision (1)
+         << (total.second > 0 ? 100.0 * t.second / total.second : 0.0) << "%"
+         << std::setw (12) << t.first
+         << std::setw (12) << std::setprecision (3) << t.second * 1e-3 / t.first
+         << "  " << i->first << std::endl;
+    }
+
+  os << std::endl << "By function and context:" << std::endl;
+  os << std::right << std::setw (12) << "Time (s)" << std::setw (8) << "Share"
+     << std::setw (12) << "Events" << std::setw (12) << "Mean (us)"
+     << std::left << "  " << std::setw (16) << "Context" << "Function" << std::right << std::endl;
+  for (std::vector<std::pair<std::pair<std::string, uint32_t>, Total> >::const_iterator i = sites.begin ();
+       i != sites.end (); ++i)
+    {
+      const Total &t = i->second;
+      os << std::setw (12) << std::setprecision (6) << t.second * 1e-9
+         << std::setw (7) << std::setprecision (1)
+         << (total.second > 0 ? 100.0 * t.second / total.second : 0.0) << "%"
+         << std::setw (12) << t.first
+         << std::setw (12) << std::setprecision (3) << t.second * 1e-3 / t.first
+         << std::left << "  " << std::setw (16) << GetContextName (i->first.second)
+         << i->first.first << std::right << std::endl;
+    }
+  os.flags (flags);
+  os.precision (precision);
+}
+
+void
+ProfilingSimulatorImpl::WriteFolded (std::ostream &os) const
+{
+  NS_LOG_FUNCTION (this);
+  for (Sites::const_iterator i = m_sites.begin (); i != m_sites.end (); ++i)
+    {
+      std::string name = GetName (i->first, i->second);
+      // flamegraph.pl splits the frames at the semicolons
+      std::replace (name.begin (), name.end (), ';', ',');
+      os << GetContextName (i->first.context) << ";" << name << " "
+         << i->second.nanoseconds << std::endl;
+    }
+}
+
+void
+ProfilingSimulatorImpl::SetScheduler (ObjectFactory schedulerFactory)
+{
+  NS_LOG_FUNCTION (this << schedulerFactory);
+  m_simulator->SetScheduler (schedulerFactory);
+}
+
+uint32_t
+ProfilingSimulatorImpl::GetSystemId (void) const
+{
+  return m_simulator->GetSystemId ();
+}
+
+bool
+ProfilingSimulatorImpl::IsFinished (void) const
+{
+  return m_simulator->IsFinished ();
+}
+
+void
+ProfilingSimulatorImpl::Run (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_simulator->Run ();
+}
+
+void
+ProfilingSimulatorImpl::Stop (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_simulator->Stop ();
+}
+
+void
+ProfilingSimulatorImpl::Stop (const Time &delay)
+{
+  NS_LOG_FUNCTION (this << delay);
+  m_simulator->Stop (delay);
+}
+
+EventId
+ProfilingSimulatorImpl::Schedule (const Time &delay, EventImpl *event)
+{
+  return m_simulator->Schedule (delay, Wrap (event));
+}
+
+void
+ProfilingSimulatorImpl::ScheduleWithContext (uint32_t context, const Time &delay, EventImpl *event)
+{
+  m_simulator->ScheduleWithContext (context, delay, Wrap (event));
+}
+
+EventId
+ProfilingSimulatorImpl::ScheduleNow (EventImpl *event)
+{
+  return m_simulator->ScheduleNow (Wrap (event));
+}
+
+EventId
+ProfilingSimulatorImpl::ScheduleDestroy (EventImpl *event)
+{
+  return m_simulator->ScheduleDestroy (Wrap (event));
+}
+
+Time
+ProfilingSimulatorImpl::Now (void) const
+{
+  return m_simulator->Now ();
+}
+
+Time
+ProfilingSimulatorImpl::GetDelayLeft (const EventId &id) const
+{
+  return m_simulator->GetDelayLeft (id);
+}
+
+void
+ProfilingSimulatorImpl::Remove (const EventId &id)
+{
+  m_simulator->Remove (id);
+}
+
+void
+ProfilingSimulatorImpl::Cancel (const EventId &id)
+{
+  m_simulator->Cancel (id);
+}
+
+bool
+ProfilingSimulatorImpl::IsExpired (const EventId &id) const
+{
+  return m_simulator->IsExpired (id);
+}
+
+Time
+ProfilingSimulatorImpl::GetMaximumSimulationTime (void) const
+{
+  return m_simulator->GetMaximumSimulationTime ();
+}
+
+Simulator::EventCounts
+ProfilingSimulatorImpl::GetEventCounts (void) const
+{
+  return m_simulator->GetEventCounts ();
+}
+
+uint32_t
+ProfilingSimulatorImpl::GetContext (void) const
+{
+  return m_simulator->GetContext ();
+}
+
+} // namespace ns3
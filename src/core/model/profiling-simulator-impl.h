@@ -0,0 +1,182 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef PROFILING_SIMULATOR_IMPL_H
+#define PROFILING_SIMULATOR_IMPL_H
+
+#include "simulator-impl.h"
+#include "object-factory.h"
+#include "event-impl.h"
+#include "ptr.h"
+
+#include <stdint.h>
+#include <map>
+#include <ostream>
+#include <string>
+#include <typeinfo>
+
+/**
+ * \file
+ * \ingroup simulator
+ * Declaration of class ns3::ProfilingSimulatorImpl.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup simulator
+ *
+ * A simulator implementation which measures the wall-clock time spent
+ * in the events of another implementation.
+ *
+ * Select it with
+ * \code
+ *   --SimulatorImplementationType=ns3::ProfilingSimulatorImpl
+ * \endcode
+ * on the command line of any simulation.  It runs the events with the
+ * implementation created by its SimulatorImplFactory attribute, by
+ * default a DefaultSimulatorImpl, and attributes the wall-clock time
+ * and the number of the events which run to their callsite: the
+ * function or class method which the event calls, as returned by
+ * EventImpl::GetFunction, and the context of the event.
+ *
+ * When the simulator is destroyed, it writes the callsites sorted by
+ * decreasing time to the ReportFile, and, if FoldedFile is set, the
+ * time of each callsite in the folded stack format of flamegraph.pl,
+ * as "context;function nanoseconds" lines.
+ *
+ * The functions are named from the dynamic symbols of the program, so
+ * the functions of the program itself, rather than of the ns-3
+ * libraries, are only named if it is linked with \c -rdynamic; the
+ * other functions are reported with the type of their event.
+ *
+ * The events must run in a single thread, as they do with the
+ * DefaultSimulatorImpl.
+ */
+class ProfilingSimulatorImpl : public SimulatorImpl
+{
+public:
+  /**
+   *  Register this type.
+   *  \return The object TypeId.
+   */
+  static TypeId GetTypeId (void);
+
+  /** Constructor. */
+  ProfilingSimulatorImpl ();
+  /** Destructor. */
+  ~ProfilingSimulatorImpl ();
+
+  // Inherited
+  virtual void Destroy ();
+  virtual bool IsFinished (void) const;
+  virtual void Stop (void);
+  virtual void Stop (const Time &delay);
+  virtual EventId Schedule (const Time &delay, EventImpl *event);
+  virtual void ScheduleWithContext (uint32_t context, const Time &delay, EventImpl *event);
+  virtual EventId ScheduleNow (EventImpl *event);
+  virtual EventId ScheduleDestroy (EventImpl *event);
+  virtual void Remove (const EventId &id);
+  virtual void Cancel (const EventId &id);
+  virtual bool IsExpired (const EventId &id) const;
+  virtual void Run (void);
+  virtual Time Now (void) const;
+  virtual Time GetDelayLeft (const EventId &id) const;
+  virtual Time GetMaximumSimulationTime (void) const;
+  virtual Simulator::EventCounts GetEventCounts (void) const;
+  virtual void SetScheduler (ObjectFactory schedulerFactory);
+  virtual uint32_t GetSystemId (void) const;
+  virtual uint32_t GetContext (void) const;
+
+  /**
+   * Write the callsites sorted by decreasing wall-clock time.
+   * \param [in,out] os The output stream.
+   */
+  void WriteReport (std::ostream &os) const;
+  /**
+   * Write the wall-clock time of the callsites in the folded stack
+   * format of flamegraph.pl.
+   * \param [in,out] os The output stream.
+   */
+  void WriteFolded (std::ostream &os) const;
+
+private:
+  virtual void DoDispose (void);
+  virtual void NotifyConstructionCompleted (void);
+
+  /** An event which measures the event it wraps. */
+  class ProfiledEvent;
+
+  /**
+   * Wrap an event to measure it.
+   * \param [in] event The event.
+   * \returns The wrapper.
+   */
+  EventImpl * Wrap (EventImpl *event);
+  /**
+   * Run an event and account for it.
+   * \param [in] event The event.
+   */
+  void Invoke (EventImpl *event);
+
+  /** A callsite: the function called, or the type of the event, and the context. */
+  struct Site
+  {
+    const void *function;          //!< The function called, or 0
+    const std::type_info *type;    //!< The type of the event, if the function is not known
+    uint32_t context;              //!< The context of the event
+    /**
+     * Order the callsites.
+     * \param [in] o The other callsite.
+     * \returns \c true if this callsite is before \p o.
+     */
+    bool operator < (const Site &o) const;
+  };
+  /** The measures of a callsite. */
+  struct Measure
+  {
+    uint64_t count;                //!< Number of events run
+    uint64_t nanoseconds;          //!< Wall-clock time of the events
+    const std::type_info *type;    //!< The type of the first event
+  };
+  /** The callsites and their measures. */
+  typedef std::map<Site, Measure> Sites;
+
+  /**
+   * Get the name of the function of a callsite.
+   * \param [in] site The callsite.
+   * \param [in] measure The measures of the callsite.
+   * \returns The name of the function, or the type of the event.
+   */
+  static std::string GetName (const Site &site, const Measure &measure);
+  /**
+   * Get the name of a context.
+   * \param [in] context The context.
+   * \returns The name of the context.
+   */
+  static std::string GetContextName (uint32_t context);
+
+  Ptr<SimulatorImpl> m_simulator;        //!< The simulator running the events
+  ObjectFactory m_simulatorImplFactory;  //!< Factory of the simulator
+  std::string m_reportFile;              //!< File of the sorted report
+  std::string m_foldedFile;              //!< File of the folded stacks
+  Sites m_sites;                         //!< The callsites
+};
+
+} // namespace ns3
+
+#endif /* PROFILING_SIMULATOR_IMPL_H */
@@ -33,6 +33,7 @@
 #include "enum.h"
 
 
+#include <algorithm>
 #include <cmath>
 
 
@@ -69,6 +70,14 @@ RealtimeSimulatorImpl::GetTypeId (void)
                    TimeValue (Seconds (0.1)),
                    MakeTimeAccessor (&RealtimeSimulatorImpl::m_hardLimit),
                    MakeTimeChecker ())
+    .AddAttribute ("BatchWindow",
+                   "Run at once, without waiting, the events due within this time "
+                   "of the current real time; the simulation then catches up "
+                   "with the events which are late, and runs the events which "
+                   "are due soon up to this much early.",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&RealtimeSimulatorImpl::m_batchWindow),
+                   MakeTimeChecker (Seconds (0)))
   ;
   return tid;
 }
@@ -90,6 +99,8 @@ RealtimeSimulatorImpl::RealtimeSimulatorImpl ()
   m_currentTs = 0;
   m_currentContext = Simulator::NO_CONTEXT;
   m_unscheduledEvents = 0;
+  m_cancelledEvents = 0;
+  ResetSynchronizationStats ();
 
   m_main = SystemThread::Self();
 
@@ -249,6 +260,15 @@ RealtimeSimulatorImpl::ProcessOneEvent (void)
             tsDelay = tsNext - tsNow;
           }
 
+        //
+        // The events due within the batch window do not wait: the wake-up
+        // of a wait would likely make them later than running them now.
+        //
+        if (tsDelay <= static_cast<uint64_t> (m_batchWindow.GetTimeStep ()))
+          {
+            break;
+          }
+
         //
         // We've figured out how long we need to delay in order to pace the 
         // simulation time with the real time.  We're going to sleep, but need
@@ -349,6 +369,10 @@ RealtimeSimulatorImpl::ProcessOneEvent (void)
     m_currentTs = next.key.m_ts;
     m_currentContext = next.key.m_context;
     m_currentUid = next.key.m_uid;
+    if (next.impl->IsCancelled ())
+      {
+        m_cancelledEvents--;
+      }
 
     // 
     // We're about to run the event and we've done our best to synchronize this
@@ -357,22 +381,28 @@ RealtimeSimulatorImpl::ProcessOneEvent (void)
     // been asked to commit ritual suicide.
     //
     // We check the simulation time against the current real time to make this
-    // judgement.
+    // judgement.  We also account for the synchronization error in the statistics.
     //
-    if (m_synchronizationMode == SYNC_HARD_LIMIT)
-      {
-        uint64_t tsFinal = m_synchronizer->GetCurrentRealtime ();
-        uint64_t tsJitter;
+    uint64_t tsFinal = m_synchronizer->GetCurrentRealtime ();
+    uint64_t tsJitter;
 
-        if (tsFinal >= m_currentTs)
-          {
-            tsJitter = tsFinal - m_currentTs;
-          }
-        else
-          {
-            tsJitter = m_currentTs - tsFinal;
-          }
+    if (tsFinal >= m_currentTs)
+      {
+        tsJitter = tsFinal - m_currentTs;
+        AddLateness (m_stats.late, tsJitter);
+        m_stats.maxLateness = std::max (m_stats.maxLateness, tsJitter);
+        m_stats.totalLateness += tsJitter;
+      }
+    else
+      {
+        tsJitter = m_currentTs - tsFinal;
+        AddLateness (m_stats.early, tsJitter);
+        m_stats.earlyEvents++;
+      }
+    m_stats.events++;
 
+    if (m_synchronizationMode == SYNC_HARD_LIMIT)
+      {
         if (tsJitter > static_cast<uint64_t>(m_hardLimit.GetTimeStep ()))
           {
             NS_FATAL_ERROR ("RealtimeSimulatorImpl::ProcessOneEvent (): "
@@ -753,6 +783,11 @@ RealtimeSimulatorImpl::Cancel (const EventId &id)
   if (IsExpired (id) == false)
     {
       id.PeekEventImpl ()->Cancel ();
+      if (id.GetUid () != 2)
+        {
+          CriticalSection cs (m_mutex);
+          m_cancelledEvents++;
+        }
     }
 }
 
@@ -807,6 +842,18 @@ RealtimeSimulatorImpl::GetMaximumSimulationTime (void) const
   return TimeStep (0x7fffffffffffffffLL);
 }
 
+Simulator::EventCounts
+RealtimeSimulatorImpl::GetEventCounts (void) const
+{
+  CriticalSection cs (m_mutex);
+  Simulator::EventCounts counts;
+  counts.live = m_unscheduledEvents - m_cancelledEvents;
+  counts.cancelled = m_cancelledEvents;
+  counts.compactions = 0;
+  counts.purged = 0;
+  return counts;
+}
+
 // System ID for non-distributed simulation is always zero
 uint32_t 
 RealtimeSimulatorImpl::GetSystemId (void) const
@@ -848,4 +895,79 @@ RealtimeSimulatorImpl::GetHardLimit (void) const
   return m_hardLimit;
 }
 
+RealtimeSimulatorImpl::SynchronizationStats
+RealtimeSimulatorImpl::GetSynchronizationStats (void) const
+{
+  NS_LOG_FUNCTION (this);
+  CriticalSection cs (m_mutex);
+  return m_stats;
+}
+
+void
+RealtimeSimulatorImpl::ResetSynchronizationStats (void)
+{
+  NS_LOG_FUNCTION (this);
+  CriticalSection cs (m_mutex);
+  m_stats.events = 0;
+  m_stats.earlyEvents = 0;
+  m_stats.maxLateness = 0;
+  m_stats.totalLateness = 0;
+  m_stats.late.clear ();
+  m_stats.early.clear ();
+}
+
+void
+RealtimeSimulatorImpl::AddLateness (std::vector<uint64_t> &histogram, uint64_t steps)
+{
+  uint32_t bin = 0;
+  while (steps != 0)
+    {
+      steps >>= 1;
+      bin++;
+    }
+  if (histogram.size () <= bin)
+    {
+      histogram.resize (bin + 1, 0);
+    }
+  histogram[bin]++;
+}
+
+void
+RealtimeSimulatorImpl::PrintSynchronizationStats (std::ostream &os) const
+{
+  NS_LOG_FUNCTION (this);
+  SynchronizationStats stats = GetSynchronizationStats ();
+  uint64_t lateEvents = stats.events - stats.earlyEvents;
+  os << stats.events << " events, " << stats.earlyEvents << " early, "
+     << lateEvents << " late by " << TimeStep (stats.maxLateness).As (Time::US)
+     << " at most and "
+     << TimeStep (lateEvents > 0 ? stats.totalLateness / lateEvents : 0).As (Time::US)
+     << " on average" << std::endl;
+  // From the earliest to the latest
+  for (uint32_t i = stats.early.size (); i-- > 1; )
+    {
+      if (stats.early[i] != 0)
+        {
+          os << "  early by [" << TimeStep (uint64_t (1) << (i - 1)).As (Time::US) << ", "
+             << TimeStep (uint64_t (1) << i).As (Time::US) << "): " << stats.early[i] << std::endl;
+        }
+    }
+  for (uint32_t i = 0; i < stats.late.size (); i++)
+    {
+      if (stats.late[i] == 0)
+        {
+          continue;
+        }
+      if (i == 0)
+        {
+          os << "  on time: " << stats.late[i] << std::endl;
+        }
+      else
+        {
+          os << "  late by [" << TimeStep (uint64_t (1) << (i - 1)).As (Time::US) << ", "
+             << TimeStep (uint64_t (1) << i).As (Time::US) << "): " << stats.late[i] << std::endl;
+        }
+    }
+}
+
 } // namespace ns3
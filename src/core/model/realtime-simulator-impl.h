@@ -32,6 +32,8 @@
 #include "system-mutex.h"
 
 #include <list>
+#include <ostream>
+#include <vector>
 
 /**
  * \file
@@ -52,6 +54,18 @@ namespace ns3 {
  * \ingroup realtime
  *
  * Realtime version of SimulatorImpl.
+ *
+ * For a low synchronization error, as with emulated devices, set the
+ * ns3::WallClockSynchronizer::SpinThreshold attribute to busy-wait the
+ * short waits, and the BatchWindow attribute to run at once the events
+ * due within a few microseconds of each other.  The synchronization
+ * error of the events is reported by GetSynchronizationStats and
+ * PrintSynchronizationStats, through
+ * \code
+ *   Ptr<RealtimeSimulatorImpl> impl =
+ *     DynamicCast<RealtimeSimulatorImpl> (Simulator::GetImplementation ());
+ *   impl->PrintSynchronizationStats (std::cout);
+ * \endcode
  */
 class RealtimeSimulatorImpl : public SimulatorImpl
 {
@@ -83,6 +97,26 @@ public:
     SYNC_HARD_LIMIT,  
   };
 
+  /**
+   * The synchronization error of the events run: how late or early they
+   * started with respect to the real time.
+   *
+   * The errors are in time steps, the unit of Time::GetTimeStep, which
+   * are nanoseconds with the default resolution.  The histograms count
+   * the events by powers of two of this error: bin 0 counts the events
+   * on time, and bin \c i > 0 the events late, or early, by
+   * [2^(i-1), 2^i) time steps.
+   */
+  struct SynchronizationStats
+  {
+    uint64_t events;               //!< Events run
+    uint64_t earlyEvents;          //!< Events run before their time, in a batch
+    uint64_t maxLateness;          //!< Maximum lateness, in time steps
+    uint64_t totalLateness;        //!< Sum of the lateness of the events not early, in time steps
+    std::vector<uint64_t> late;    //!< Histogram of the events not early
+    std::vector<uint64_t> early;   //!< Histogram of the early events
+  };
+
   /** Constructor. */
   RealtimeSimulatorImpl ();
   /** Destructor. */
@@ -104,6 +138,7 @@ public:
   virtual Time Now (void) const;
   virtual Time GetDelayLeft (const EventId &id) const;
   virtual Time GetMaximumSimulationTime (void) const;
+  virtual Simulator::EventCounts GetEventCounts (void) const;
   virtual void SetScheduler (ObjectFactory schedulerFactory);
   virtual uint32_t GetSystemId (void) const; 
   virtual uint32_t GetContext (void) const;
@@ -154,6 +189,20 @@ public:
    */
   Time GetHardLimit (void) const;
 
+  /**
+   * Get the synchronization error of the events run since the simulator
+   * was created, or since ResetSynchronizationStats.
+   * \returns The statistics.
+   */
+  SynchronizationStats GetSynchronizationStats (void) const;
+  /** Reset the synchronization statistics. */
+  void ResetSynchronizationStats (void);
+  /**
+   * Print the synchronization statistics and their histograms.
+   * \param [in,out] os The output stream.
+   */
+  void PrintSynchronizationStats (std::ostream &os) const;
+
 private:
   /**
    * Is the simulator running?
@@ -172,6 +221,12 @@ private:
   uint64_t NextTs (void) const;
   /** Process the next event. */
   void ProcessOneEvent (void);
+  /**
+   * Count an event in a synchronization error histogram.
+   * \param [in,out] histogram The histogram.
+   * \param [in] steps The error, in time steps.
+   */
+  static void AddLateness (std::vector<uint64_t> &histogram, uint64_t steps);
   /** Destructor implementation. */
   virtual void DoDispose (void);
 
@@ -194,6 +249,8 @@ private:
   Ptr<Scheduler> m_events;
   /**< Number of events in the event list. */
   int m_unscheduledEvents;
+  /**< Number of cancelled events in the event list. */
+  int m_cancelledEvents;
   /**< Unique id for the next event to be scheduled. */
   uint32_t m_uid;
   /**< Unique id of the current event. */
@@ -216,6 +273,12 @@ private:
   /** The maximum allowable drift from real-time in SYNC_HARD_LIMIT mode. */
   Time m_hardLimit;
 
+  /** The events due within this time of the real time run without waiting. */
+  Time m_batchWindow;
+
+  /** The synchronization error of the events, protected by #m_mutex. */
+  SynchronizationStats m_stats;
+
   /** Main SystemThread. */
   SystemThread::ThreadId m_main;
 };
@@ -0,0 +1,415 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "replication-runner.h"
+#include "rng-seed-manager.h"
+#include "simulator.h"
+#include "config.h"
+#include "string.h"
+#include "assert.h"
+#include "abort.h"
+#include "log.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/**
+ * \file
+ * \ingroup core
+ * ns3::ReplicationRunner implementation.
+ */
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("ReplicationRunner");
+
+ReplicationRunner::Replication::Replication (uint32_t index, uint64_t run,
+                                             const std::vector<std::string> &arguments,
+                                             std::ostream &output)
+  : m_index (index),
+    m_run (run),
+    m_arguments (arguments),
+    m_output (&output)
+{
+}
+
+uint32_t
+ReplicationRunner::Replication::GetIndex (void) const
+{
+  return m_index;
+}
+
+uint64_t
+ReplicationRunner::Replication::GetRun (void) const
+{
+  return m_run;
+}
+
+const std::vector<std::string> &
+ReplicationRunner::Replication::GetArguments (void) const
+{
+  return m_arguments;
+}
+
+void
+ReplicationRunner::Replication::Parse (CommandLine &cmd) const
+{
+  NS_LOG_FUNCTION (this);
+  // CommandLine::Parse expects the program name first; the attributes of
+  // existing objects are set once the command line is parsed
+  std::vector<std::string> arguments;
+  std::vector<std::pair<std::string, std::string> > paths;
+  arguments.push_back ("replication");
+  for (std::vector<std::string>::const_iterator i = m_arguments.begin (); i != m_arguments.end (); ++i)
+    {
+      if (i->compare (0, 3, "--/") == 0)
+        {
+          std::string::size_type equal = i->find ('=');
+          paths.push_back (std::make_pair (i->substr (2, equal - 2), i->substr (equal + 1)));
+        }
+      else
+        {
+          arguments.push_back (*i);
+        }
+    }
+  std::vector<char *> argv;
+  for (std::vector<std::string>::iterator i = arguments.begin (); i != arguments.end (); ++i)
+    {
+      argv.push_back (&(*i)[0]);
+    }
+  argv.push_back (0);
+  cmd.Parse (arguments.size (), &argv[0]);
+  for (std::vector<std::pair<std::string, std::string> >::const_iterator i = paths.begin ();
+       i != paths.end (); ++i)
+    {
+      NS_LOG_LOGIC ("set " << i->first << " to " << i->second);
+      Config::Set (i->first, StringValue (i->second));
+    }
+}
+
+std::ostream &
+ReplicationRunner::Replication::GetOutput (void) const
+{
+  return *m_output;
+}
+
+ReplicationRunner::ReplicationRunner ()
+  : m_firstRun (1),
+    m_runs (1),
+    m_workers (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+ReplicationRunner::SetRuns (uint64_t first, uint32_t count)
+{
+  NS_LOG_FUNCTION (this << first << count);
+  m_firstRun = first;
+  m_runs = count;
+}
+
+void
+ReplicationRunner::SetWorkers (uint32_t workers)
+{
+  NS_LOG_FUNCTION (this << workers);
+  m_workers = workers;
+}
+
+void
+ReplicationRunner::AddParameter (const std::string &name, const std::vector<std::string> &values)
+{
+  NS_LOG_FUNCTION (this << name << values.size ());
+  m_parameters.push_back (Parameter (name, values));
+}
+
+void
+ReplicationRunner::AddParameter (const std::string &name, const std::string &values)
+{
+  NS_LOG_FUNCTION (this << name << values);
+  std::vector<std::string> split;
+  std::string::size_type start = 0;
+  for (;;)
+    {
+      std::string::size_type comma = values.find (',', start);
+      split.push_back (values.substr (start, comma - start));
+      if (comma == std::string::npos)
+        {
+          break;
+        }
+      start = comma + 1;
+    }
+  AddParameter (name, split);
+}
+
+bool
+ReplicationRunner::ParseParameter (std::string parameter)
+{
+  NS_LOG_FUNCTION (this << parameter);
+  std::string::size_type equal = parameter.find ('=');
+  if (equal == 0 || equal == std::string::npos)
+    {
+      return false;
+    }
+  AddParameter (parameter.substr (0, equal), parameter.substr (equal + 1));
+  return true;
+}
+
+uint32_t
+ReplicationRunner::GetNReplications (void) const
+{
+  uint32_t n = m_runs;
+  for (std::vector<Parameter>::const_iterator i = m_parameters.begin (); i != m_parameters.end (); ++i)
+    {
+      n *= i->second.size ();
+    }
+  return n;
+}
+
+uint64_t
+ReplicationRunner::GetRun (uint32_t index) const
+{
+  NS_ASSERT (index < GetNReplications ());
+  return m_firstRun + index % m_runs;
+}
+
+std::vector<std::string>
+ReplicationRunner::GetArguments (uint32_t index) const
+{
+  NS_ASSERT (index < GetNReplications ());
+  // The runs of a set of values are consecutive, and the last parameter
+  // varies the fastest
+  uint32_t combination = index / m_runs;
+  std::vector<std::string> arguments (m_parameters.size ());
+  for (uint32_t i = m_parameters.size (); i-- > 0; )
+    {
+      const Parameter &parameter = m_parameters[i];
+      uint32_t n = parameter.second.size ();
+      arguments[i] = "--" + parameter.first + "=" + parameter.second[combination % n];
+      combination /= n;
+    }
+  return arguments;
+}
+
+int
+ReplicationRunner::RunReplication (Callback<void, const Replication &> scenario,
+                                   uint32_t index, const std::string &fileName) const
+{
+  std::ofstream output (fileName.c_str ());
+  if (!output.is_open ())
+    {
+      std::cerr << "Cannot open " << fileName << std::endl;
+      return 1;
+    }
+  RngSeedManager::SetRun (GetRun (index));
+  Replication replication (index, GetRun (index), GetArguments (index), output);
+  scenario (replication);
+  output.close ();
+  std::cout.flush ();
+  std::cerr.flush ();
+  return output.fail () ? 1 : 0;
+}
+
+namespace {
+
+/**
+ * Escape a string for an XML attribute.
+ * \param [in] value The string.
+ * \returns The escaped string.
+ */
+std::string
+EscapeXml (const std::string &value)
+{
+  std::string escaped;
+  for (std::string::const_iterator i = value.begin (); i != value.end (); ++i)
+    {
+      switch (*i)
+        {
+        case '&':
+          escaped += "&amp;";
+          break;
+        case '<':
+          escaped += "&lt;";
+          break;
+        case '>':
+          escaped += "&gt;";
+          break;
+        case '"':
+          escaped += "&quot;";
+          break;
+        default:
+          escaped += *i;
+          break;
+        }
+    }
+  return escaped;
+}
+
+} // unnamed namespace
+
+bool
+ReplicationRunner::Gather (const std::string &outputFile, const std::vector<int> &status) const
+{
+  NS_LOG_FUNCTION (this << outputFile);
+  std::ofstream os (outputFile.c_str ());
+  if (!os.is_open ())
+    {
+      return false;
+    }
+  os << "<?xml version=\"1.0\" ?>\n";
+  os << "<Replications>\n";
+  for (uint32_t i = 0; i < status.size (); i++)
+    {
+      std::ostringstream arguments;
+      std::vector<std::string> args = GetArguments (i);
+      for (uint32_t j = 0; j < args.size (); j++)
+        {
+          arguments << (j > 0 ? " " : "") << args[j];
+        }
+      std::ostringstream state;
+      if (WIFEXITED (status[i]) && WEXITSTATUS (status[i]) == 0)
+        {
+          state << "ok";
+        }
+      else if (WIFEXITED (status[i]))
+        {
+          state << "exit " << WEXITSTATUS (status[i]);
+        }
+      else
+        {
+          state << "signal " << WTERMSIG (status[i]);
+        }
+      os << "  <Replication index=\"" << i << "\" run=\"" << GetRun (i)
+         << "\" status=\"" << state.str ()
+         << "\" arguments=\"" << EscapeXml (arguments.str ()) << "\">\n";
+      std::ostringstream fileName;
+      fileName << outputFile << "." << i;
+      std::ifstream part (fileName.str ().c_str ());
+      if (part.is_open ())
+        {
+          if (part.peek () != std::ifstream::traits_type::eof ())
+            {
+              os << part.rdbuf ();
+            }
+          part.close ();
+          std::remove (fileName.str ().c_str ());
+        }
+      os << "  </Replication>\n";
+    }
+  os << "</Replications>\n";
+  os.close ();
+  return !os.fail ();
+}
+
+uint32_t
+ReplicationRunner::Run (Callback<void, const Replication &> scenario, const std::string &outputFile)
+{
+  NS_LOG_FUNCTION (this << outputFile);
+  // The streams of the existing objects ignore the run number: from a
+  // checkpoint, the runs of the same values would be identical.  The
+  // simulator is not created here, so that the workers can still choose
+  // its implementation.
+  NS_ABORT_MSG_IF (m_runs > 1 && Simulator::IsCreated () && Simulator::Now ().IsStrictlyPositive (),
+                   "ReplicationRunner: " << m_runs << " runs from a checkpoint at " <<
+                   Simulator::Now ().GetSeconds () << "s would draw the same random numbers; "
+                   "use a single run, and add a RngRun parameter if the streams "
+                   "created after the checkpoint should differ");
+  uint32_t nReplications = GetNReplications ();
+  uint32_t workers = m_workers;
+  if (workers == 0)
+    {
+      long processors = sysconf (_SC_NPROCESSORS_ONLN);
+      workers = processors > 0 ? processors : 1;
+    }
+
+  std::vector<int> status (nReplications, 0);
+  std::map<pid_t, uint32_t> running;
+  uint32_t next = 0;
+  uint32_t failed = 0;
+  while (next < nReplications || !running.empty ())
+    {
+      if (next < nReplications && running.size () < workers)
+        {
+          std::ostringstream fileName;
+          fileName << outputFile << "." << next;
+          // The buffers would be written by the worker as well
+          std::cout.flush ();
+          std::cerr.flush ();
+          std::fflush (0);
+          pid_t pid = fork ();
+          if (pid == 0)
+            {
+              // Exit without running the destructors of the objects of
+              // the parent process
+              _exit (RunReplication (scenario, next, fileName.str ()));
+            }
+          if (pid < 0)
+            {
+              NS_LOG_WARN ("cannot fork the worker of replication " << next);
+              status[next] = 1 << 8;
+              failed++;
+            }
+          else
+            {
+              NS_LOG_LOGIC ("replication " << next << " in process " << pid);
+              running[pid] = next;
+            }
+          next++;
+          continue;
+        }
+      int wstatus;
+      pid_t pid = waitpid (-1, &wstatus, 0);
+      if (pid < 0)
+        {
+          NS_LOG_WARN ("lost the workers");
+          break;
+        }
+      std::map<pid_t, uint32_t>::iterator i = running.find (pid);
+      if (i == running.end ())
+        {
+          // Not one of ours
+          continue;
+        }
+      NS_LOG_LOGIC ("replication " << i->second << " done with status " << wstatus);
+      status[i->second] = wstatus;
+      if (!WIFEXITED (wstatus) || WEXITSTATUS (wstatus) != 0)
+        {
+          failed++;
+        }
+      running.erase (i);
+    }
+  for (std::map<pid_t, uint32_t>::const_iterator i = running.begin (); i != running.end (); ++i)
+    {
+      status[i->second] = 1 << 8;
+      failed++;
+    }
+
+  if (!Gather (outputFile, status))
+    {
+      std::cerr << "Cannot write " << outputFile << std::endl;
+    }
+  return failed;
+}
+
+} // namespace ns3
@@ -0,0 +1,272 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef REPLICATION_RUNNER_H
+#define REPLICATION_RUNNER_H
+
+#include "callback.h"
+#include "command-line.h"
+#include <stdint.h>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * \file
+ * \ingroup core
+ * ns3::ReplicationRunner declaration.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup core
+ * \brief Run the replications of a simulation in parallel processes.
+ *
+ * A replication is a run of a scenario with a RngSeedManager run number
+ * and a set of command-line arguments.  The replications are the
+ * product of the runs and of the values of each parameter added with
+ * AddParameter.
+ *
+ * Run forks a worker process for each replication, up to a given number
+ * at a time, from the calling process: the workers start with the
+ * TypeIds registered and with the state built by the program before Run,
+ * such as the attribute defaults and global values set by its own
+ * command line.  Each worker sets the run number, and calls the scenario
+ * with the Replication, which parses the arguments of the replication
+ * with the CommandLine of the scenario, and writes the results of the
+ * replication, such as those of a FlowMonitor, to its output stream.
+ * The outputs of the replications are gathered in a single XML file:
+ *
+ * \code
+ *   <?xml version="1.0" ?>
+ *   <Replications>
+ *     <Replication index="0" run="1" status="0" arguments="--errorRate=0.01">
+ *       ... the output of the replication ...
+ *     </Replication>
+ *     ...
+ *   </Replications>
+ * \endcode
+ *
+ * A typical program is:
+ *
+ * \code
+ *   static void
+ *   Scenario (const ReplicationRunner::Replication &replication)
+ *   {
+ *     CommandLine cmd;
+ *     cmd.AddValue ("errorRate", "Loss rate of the link", g_errorRate);
+ *     replication.Parse (cmd);
+ *     ... build the topology, install a FlowMonitor ...
+ *     Simulator::Run ();
+ *     monitor->SerializeToXmlStream (replication.GetOutput (), 4, false, false);
+ *     Simulator::Destroy ();
+ *   }
+ *
+ *   int
+ *   main (int argc, char *argv[])
+ *   {
+ *     ReplicationRunner runner;
+ *     runner.SetRuns (1, 10);
+ *     runner.AddParameter ("errorRate", "0,0.001,0.01");
+ *     runner.Run (MakeCallback (&Scenario), "results.xml");
+ *   }
+ * \endcode
+ *
+ * Run can also be called from a checkpoint in the middle of a
+ * simulation, after a warm-up phase run by the calling process up to a
+ * Simulator::Stop.
+ * The workers are forks of the calling process, so each one starts
+ * from a snapshot of the whole simulation at that time: the pending
+ * events, the nodes, devices and sockets, and the positions of the
+ * random number streams.  The scenario then only changes what differs
+ * between the replications, and runs the rest of the simulation:
+ *
+ * \code
+ *   static void
+ *   Resume (const ReplicationRunner::Replication &replication)
+ *   {
+ *     CommandLine cmd;
+ *     cmd.AddValue ("errorRate", "Loss rate of the link", g_errorRate);
+ *     replication.Parse (cmd);
+ *     g_errorModel->SetAttribute ("ErrorRate", DoubleValue (g_errorRate));
+ *     Simulator::Stop (Seconds (300) - Simulator::Now ());
+ *     Simulator::Run ();
+ *     ...
+ *   }
+ *
+ *   int
+ *   main (int argc, char *argv[])
+ *   {
+ *     ... build the topology, install a FlowMonitor ...
+ *     Simulator::Stop (Seconds (60));
+ *     Simulator::Run ();
+ *     ReplicationRunner runner;
+ *     runner.AddParameter ("errorRate", "0,0.001,0.01");
+ *     runner.AddParameter ("/NodeList/0/DeviceList/0/$ns3::PointToPointNetDevice/DataRate", "5Mbps,10Mbps");
+ *     runner.Run (MakeCallback (&Resume), "results.xml");
+ *     Simulator::Destroy ();
+ *   }
+ * \endcode
+ *
+ * The parameters whose name is a Config path, starting with \c /, set
+ * the attributes of the existing objects with Config::Set when the
+ * replication is parsed.  The attribute defaults and global values only
+ * apply to the objects created after the checkpoint, and the run number
+ * only to the random number streams created after it: the streams of
+ * the existing objects continue from their positions, so that the
+ * replications of the same values are identical.  Run aborts if more
+ * than one run is set from a checkpoint; a \c RngRun parameter varies
+ * the streams created after the checkpoint instead.
+ *
+ * The snapshot only covers the calling thread: the simulator must be
+ * stopped, and the threads of the simulation, such as the reader
+ * threads of emulated devices, are not copied.
+ */
+class ReplicationRunner
+{
+public:
+  /** A replication, as seen by the worker running it. */
+  class Replication
+  {
+public:
+    /**
+     * Constructor.
+     * \param [in] index The index of the replication.
+     * \param [in] run The run number.
+     * \param [in] arguments The command-line arguments.
+     * \param [in] output The stream of the results.
+     */
+    Replication (uint32_t index, uint64_t run,
+                 const std::vector<std::string> &arguments, std::ostream &output);
+    /** \returns The index of the replication, from 0. */
+    uint32_t GetIndex (void) const;
+    /** \returns The RngSeedManager run number, already set. */
+    uint64_t GetRun (void) const;
+    /** \returns The command-line arguments of the replication, as \c --name=value. */
+    const std::vector<std::string> & GetArguments (void) const;
+    /**
+     * Parse the arguments of the replication.
+     *
+     * The arguments whose name is a Config path are not given to \p cmd,
+     * but set with Config::Set once \p cmd is parsed.
+     *
+     * \param [in,out] cmd The CommandLine of the scenario.
+     */
+    void Parse (CommandLine &cmd) const;
+    /** \returns The stream to which the results are written. */
+    std::ostream & GetOutput (void) const;
+
+private:
+    uint32_t m_index;                     //!< The index
+    uint64_t m_run;                       //!< The run number
+    std::vector<std::string> m_arguments; //!< The arguments
+    std::ostream *m_output;               //!< The stream of the results
+  };
+
+  /** Constructor: one run, no parameter, one worker per processor. */
+  ReplicationRunner ();
+
+  /**
+   * Set the run numbers of the replications.
+   * \param [in] first The first run number.
+   * \param [in] count The number of runs.
+   */
+  void SetRuns (uint64_t first, uint32_t count);
+  /**
+   * Set the maximum number of workers running at once.
+   * \param [in] workers The number of workers; 0 for one per processor.
+   */
+  void SetWorkers (uint32_t workers);
+  /**
+   * Add a parameter swept by the replications.
+   * \param [in] name The name of the command-line argument, such as
+   *        \c errorRate, \c ns3::TcpL4Protocol::SocketType or a global
+   *        value, or a Config path to the attribute of existing objects.
+   * \param [in] values The values of the parameter.
+   */
+  void AddParameter (const std::string &name, const std::vector<std::string> &values);
+  /**
+   * Add a parameter swept by the replications.
+   * \param [in] name The name of the command-line argument.
+   * \param [in] values The comma-separated values of the parameter.
+   */
+  void AddParameter (const std::string &name, const std::string &values);
+  /**
+   * Add a parameter given as \c name=value1,value2,...
+   *
+   * This can be used as a CommandLine callback.
+   *
+   * \param [in] parameter The parameter and its values.
+   * \returns \c false if the parameter has no name.
+   */
+  bool ParseParameter (std::string parameter);
+  /** \returns The number of replications. */
+  uint32_t GetNReplications (void) const;
+  /**
+   * Get the arguments of a replication.
+   * \param [in] index The index of the replication.
+   * \returns The \c --name=value arguments.
+   */
+  std::vector<std::string> GetArguments (uint32_t index) const;
+  /**
+   * Get the run number of a replication.
+   * \param [in] index The index of the replication.
+   * \returns The run number.
+   */
+  uint64_t GetRun (uint32_t index) const;
+
+  /**
+   * Run all the replications.
+   * \param [in] scenario The function running a replication.
+   * \param [in] outputFile The file gathering the outputs of the replications.
+   * \returns The number of replications which failed, by exiting with an
+   *          error or being killed.
+   */
+  uint32_t Run (Callback<void, const Replication &> scenario, const std::string &outputFile);
+
+private:
+  /**
+   * Run a replication in the worker process.
+   * \param [in] scenario The function running a replication.
+   * \param [in] index The index of the replication.
+   * \param [in] fileName The file of the output of the replication.
+   * \returns The exit status of the worker.
+   */
+  int RunReplication (Callback<void, const Replication &> scenario,
+                      uint32_t index, const std::string &fileName) const;
+  /**
+   * Gather the outputs of the replications.
+   * \param [in] outputFile The file gathering the outputs.
+   * \param [in] status The exit status of each replication.
+   * \returns \c false if the file could not be written.
+   */
+  bool Gather (const std::string &outputFile, const std::vector<int> &status) const;
+
+  /** A parameter: its name and its values. */
+  typedef std::pair<std::string, std::vector<std::string> > Parameter;
+
+  uint64_t m_firstRun;                   //!< The first run number
+  uint32_t m_runs;                       //!< The number of runs
+  uint32_t m_workers;                    //!< The maximum number of workers
+  std::vector<Parameter> m_parameters;   //!< The parameters swept
+};
+
+} // namespace ns3
+
+#endif /* REPLICATION_RUNNER_H */
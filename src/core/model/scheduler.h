@@ -22,6 +22,7 @@
 #define SCHEDULER_H
 
 #include <stdint.h>
+#include <vector>
 #include "object.h"
 
 /**
@@ -135,6 +136,16 @@ public:
    * \param [in] ev The event to remove
    */
   virtual void Remove (const Event &ev) = 0;
+  /**
+   * Remove all the cancelled events from the event list.
+   *
+   * The default implementation removes nothing, leaving the cancelled
+   * events to be removed at their time.
+   *
+   * \param [out] removed The cancelled events, appended to it, which the
+   *        caller has to unref.
+   */
+  virtual void RemoveCancelled (std::vector<Event> &removed);
 };
 
 /**
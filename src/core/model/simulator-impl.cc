@@ -42,4 +42,16 @@ SimulatorImpl::GetTypeId (void)
   return tid;
 }
 
+Simulator::EventCounts
+SimulatorImpl::GetEventCounts (void) const
+{
+  NS_LOG_FUNCTION (this);
+  Simulator::EventCounts counts;
+  counts.live = 0;
+  counts.cancelled = 0;
+  counts.compactions = 0;
+  counts.purged = 0;
+  return counts;
+}
+
 } // namespace ns3
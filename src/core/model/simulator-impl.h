@@ -27,6 +27,7 @@
 #include "object.h"
 #include "object-factory.h"
 #include "ptr.h"
+#include "simulator.h"
 
 /**
  * \file
@@ -85,6 +86,8 @@ public:
   virtual Time GetDelayLeft (const EventId &id) const = 0;
   /** \copydoc Simulator::GetMaximumSimulationTime */
   virtual Time GetMaximumSimulationTime (void) const = 0;
+  /** \copydoc Simulator::GetEventCounts */
+  virtual Simulator::EventCounts GetEventCounts (void) const;
   /**
    * Set the Scheduler to be used to manage the event list.
    *
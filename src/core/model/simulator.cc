@@ -222,6 +222,13 @@ Simulator::IsFinished (void)
   return GetImpl ()->IsFinished ();
 }
 
+bool
+Simulator::IsCreated (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  return *PeekImpl () != 0;
+}
+
 void 
 Simulator::Run (void)
 {
@@ -374,6 +381,13 @@ Simulator::GetMaximumSimulationTime (void)
   return GetImpl ()->GetMaximumSimulationTime ();
 }
 
+Simulator::EventCounts
+Simulator::GetEventCounts (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  return GetImpl ()->GetEventCounts ();
+}
+
 uint32_t
 Simulator::GetContext (void)
 {
@@ -133,6 +133,17 @@ public:
    */
   static bool IsFinished (void);
 
+  /**
+   * Check if the simulator implementation exists.
+   *
+   * It is created by the first call to the other methods, and deleted by
+   * Simulator::Destroy.  Unlike them, this method does not create it.
+   *
+   * @return @c true if the implementation has been created and not
+   *         destroyed since.
+   */
+  static bool IsCreated (void);
+
   /**
    * Run the simulation.
    *
@@ -1270,6 +1281,27 @@ public:
    */
   static Time GetMaximumSimulationTime (void);
 
+  /** Counters of the events in the event list. */
+  struct EventCounts
+  {
+    uint64_t live;         //!< Events scheduled, neither run nor cancelled
+    uint64_t cancelled;    //!< Events cancelled, still in the event list
+    uint64_t compactions;  //!< Times the cancelled events were purged
+    uint64_t purged;       //!< Cancelled events purged by the compactions
+  };
+
+  /**
+   * Get the counters of the events in the event list.
+   *
+   * Cancelled events stay in the event list until their time, unless
+   * the simulator compacts the list, as DefaultSimulatorImpl does when
+   * they make up a large part of it.  Simulator implementations which do
+   * not track their events return zero counters.
+   *
+   * @returns The counters of the events.
+   */
+  static EventCounts GetEventCounts (void);
+
   /**
    * Schedule a future event execution (in the same context).
    *
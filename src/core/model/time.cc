@@ -42,6 +42,10 @@ NS_LOG_COMPONENT_DEFINE_MASK ("Time", ns3::LOG_PREFIX_TIME);
 // static
 Time::MarkedTimes * Time::g_markingTimes = 0;
 
+#ifdef NS3_TIME_RESOLUTION
+constexpr enum Time::Unit Time::FIXED_RESOLUTION;
+#endif
+
 /**
  * \internal
  * Get mutex for critical sections around modification of Time::g_markingTimes
@@ -68,6 +72,9 @@ bool Time::StaticInit ()
 
   if (firstTime)
     {
+#ifndef NS3_TIME_RESOLUTION
+      // With a fixed resolution, Times are never converted, so they
+      // need not be tracked
       if (! g_markingTimes)
         {
           static MarkedTimes markingTimes;
@@ -77,6 +84,7 @@ bool Time::StaticInit ()
         {
           NS_LOG_ERROR ("firstTime but g_markingTimes != 0");
         }
+#endif
 
       // Schedule the cleanup.
       // We'd really like:
@@ -171,7 +179,11 @@ Time::SetDefaultNsResolution (void)
 {
   NS_LOG_FUNCTION_NOARGS ();
   struct Resolution resolution;
+#ifdef NS3_TIME_RESOLUTION
+  SetResolution (FIXED_RESOLUTION, &resolution, false);
+#else
   SetResolution (Time::NS, &resolution, false);
+#endif
   return resolution;
 }
 
@@ -180,7 +192,14 @@ void
 Time::SetResolution (enum Unit resolution)
 {
   NS_LOG_FUNCTION (resolution);
+#ifdef NS3_TIME_RESOLUTION
+  NS_ABORT_MSG_IF (resolution != FIXED_RESOLUTION,
+                   "The Time resolution is fixed at configuration to unit "
+                   << (int) FIXED_RESOLUTION << ", it cannot be changed to unit "
+                   << (int) resolution);
+#else
   SetResolution (resolution, PeekResolution ());
+#endif
 }
 
 
@@ -307,6 +307,7 @@ private:
     /** Value. */  enum { IsPointerToMember = 1   /**< Pointer to member function. */ };
     /** Value. */  enum { nArgs = 0               /**< Number of arguments.        */ };
     typedef U ReturnType;                         /**< Return type.                */
+    typedef V ClassType;                          /**< Class type.                 */
   };
   /**
    *  Pointer to const member function.
@@ -319,6 +320,7 @@ private:
     /** Value. */  enum { IsPointerToMember = 1   /**< Pointer to member function. */ };
     /** Value. */  enum { nArgs = 0               /**< Number of arguments.        */ };
     typedef U ReturnType;                         /**< Return type.                */
+    typedef V ClassType;                          /**< Class type.                 */
   };
   /**
    *  Pointer to member function.
@@ -333,6 +335,7 @@ private:
     /** Value. */  enum { IsPointerToMember = 1   /**< Pointer to member function. */ };
     /** Value. */  enum { nArgs = 1               /**< Number of arguments.        */ };
     typedef U ReturnType;                         /**< Return type.          */
+    typedef V ClassType;                          /**< Class type.           */
     typedef W1 Arg1Type;                          /**< First argument type.  */
   };
   /**
@@ -348,6 +351,7 @@ private:
     /** Value. */  enum { IsPointerToMember = 1   /**< Pointer to member function. */ };
     /** Value. */  enum { nArgs = 1               /**< Number of arguments.        */ };
     typedef U ReturnType;                         /**< Return type.          */
+    typedef V ClassType;                          /**< Class type.           */
     typedef W1 Arg1Type;                          /**< First argument type.  */
   };
   /**
@@ -364,6 +368,7 @@ private:
     /** Value. */  enum { IsPointerToMember = 1   /**< Pointer to member function. */ };
     /** Value. */  enum { nArgs = 2               /**< Number of arguments.        */ };
     typedef U ReturnType;                         /**< Return type.          */
+    typedef V ClassType;                          /**< Class type.           */
     typedef W1 Arg1Type;                          /**< First argument type.  */
     typedef W2 Arg2Type;                          /**< Second argument type. */
   };
@@ -381,6 +386,7 @@ private:
     /** Value. */  enum { IsPointerToMember = 1   /**< Pointer to member function. */ };
     /** Value. */  enum { nArgs = 2               /**< Number of arguments.        */ };
     typedef U ReturnType;                         /**< Return type.          */
+    typedef V ClassType;                          /**< Class type.           */
     typedef W1 Arg1Type;                          /**< First argument type.  */
     typedef W2 Arg2Type;                          /**< Second argument type. */
   };
@@ -399,6 +405,7 @@ private:
     /** Value. */  enum { IsPointerToMember = 1   /**< Pointer to member function. */ };
     /** Value. */  enum { nArgs = 3               /**< Number of arguments.        */ };
     typedef U ReturnType;                         /**< Return type.          */
+    typedef V ClassType;                          /**< Class type.           */
     typedef W1 Arg1Type;                          /**< First argument type.  */
     typedef W2 Arg2Type;                          /**< Second argument type. */
     typedef W3 Arg3Type;                          /**< Third argument type.  */
@@ -418,6 +425,7 @@ private:
     /** Value. */  enum { IsPointerToMember = 1   /**< Pointer to member function. */ };
     /** Value. */  enum { nArgs = 3               /**< Number of arguments.        */ };
     typedef U ReturnType;                         /**< Return type.          */
+    typedef V ClassType;                          /**< Class type.           */
     typedef W1 Arg1Type;                          /**< First argument type.  */
     typedef W2 Arg2Type;                          /**< Second argument type. */
     typedef W3 Arg3Type;                          /**< Third argument type.  */
@@ -439,6 +447,7 @@ private:
     /** Value. */  enum { IsPointerToMember = 1   /**< Pointer to member function. */ };
     /** Value. */  enum { nArgs = 4               /**< Number of arguments.        */ };
     typedef U ReturnType;                         /**< Return type.          */
+    typedef V ClassType;                          /**< Class type.           */
     typedef W1 Arg1Type;                          /**< First argument type.  */
     typedef W2 Arg2Type;                          /**< Second argument type. */
     typedef W3 Arg3Type;                          /**< Third argument type.  */
@@ -461,6 +470,7 @@ private:
     /** Value. */  enum { IsPointerToMember = 1   /**< Pointer to member function. */ };
     /** Value. */  enum { nArgs = 4               /**< Number of arguments.        */ };
     typedef U ReturnType;                         /**< Return type.          */
+    typedef V ClassType;                          /**< Class type.           */
     typedef W1 Arg1Type;                          /**< First argument type.  */
     typedef W2 Arg2Type;                          /**< Second argument type. */
     typedef W3 Arg3Type;                          /**< Third argument type.  */
@@ -484,6 +494,7 @@ private:
     /** Value. */  enum { IsPointerToMember = 1   /**< Pointer to member function. */ };
     /** Value. */  enum { nArgs = 5               /**< Number of arguments.        */ };
     typedef U ReturnType;                         /**< Return type.          */
+    typedef V ClassType;                          /**< Class type.           */
     typedef W1 Arg1Type;                          /**< First argument type.  */
     typedef W2 Arg2Type;                          /**< Second argument type. */
     typedef W3 Arg3Type;                          /**< Third argument type.  */
@@ -508,6 +519,7 @@ private:
     /** Value. */  enum { IsPointerToMember = 1   /**< Pointer to member function. */ };
     /** Value. */  enum { nArgs = 5               /**< Number of arguments.        */ };
     typedef U ReturnType;                         /**< Return type.          */
+    typedef V ClassType;                          /**< Class type.           */
     typedef W1 Arg1Type;                          /**< First argument type.  */
     typedef W2 Arg2Type;                          /**< Second argument type. */
     typedef W3 Arg3Type;                          /**< Third argument type.  */
@@ -533,6 +545,7 @@ private:
     /** Value. */  enum { IsPointerToMember = 1   /**< Pointer to member function. */ };
     /** Value. */  enum { nArgs = 6               /**< Number of arguments.        */ };
     typedef U ReturnType;                         /**< Return type.          */
+    typedef V ClassType;                          /**< Class type.           */
     typedef W1 Arg1Type;                          /**< First argument type.  */
     typedef W2 Arg2Type;                          /**< Second argument type. */
     typedef W3 Arg3Type;                          /**< Third argument type.  */
@@ -559,6 +572,7 @@ private:
     /** Value. */  enum { IsPointerToMember = 1   /**< Pointer to member function. */ };
     /** Value. */  enum { nArgs = 6               /**< Number of arguments.        */ };
     typedef U ReturnType;                         /**< Return type.          */
+    typedef V ClassType;                          /**< Class type.           */
     typedef W1 Arg1Type;                          /**< First argument type.  */
     typedef W2 Arg2Type;                          /**< Second argument type. */
     typedef W3 Arg3Type;                          /**< Third argument type.  */
@@ -17,11 +17,13 @@
  */
 
 
+#include <algorithm>   // max
 #include <ctime>       // clock_t
 #include <sys/time.h>  // gettimeofday
                        // clock_getres: glibc < 2.17, link with librt
 
 #include "log.h"
+#include "nstime.h"
 #include "system-condition.h"
 
 #include "wall-clock-synchronizer.h"
@@ -44,6 +46,14 @@ WallClockSynchronizer::GetTypeId (void)
   static TypeId tid = TypeId ("ns3::WallClockSynchronizer")
     .SetParent<Synchronizer> ()
     .SetGroupName ("Core")
+    .AddAttribute ("SpinThreshold",
+                   "Waits shorter than this busy-wait instead of sleeping, and the "
+                   "longer waits sleep until this time before the event and then "
+                   "busy-wait.  Sleeping only wakes up within tens of microseconds, "
+                   "busy-waiting takes a processor.",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&WallClockSynchronizer::m_spinThreshold),
+                   MakeTimeChecker (Seconds (0)))
   ;
   return tid;
 }
@@ -202,7 +212,16 @@ WallClockSynchronizer::DoSynchronize (uint64_t nsCurrent, uint64_t nsDelay)
 // If we want to be more accurate than a jiffy (we do) then we need to sleep
 // for some number of jiffies and then busy wait for any leftover time.
 //
-  uint64_t numberJiffies = ns / m_jiffy;
+// The SpinThreshold attribute extends this busy wait, for the simulations
+// which want to be more accurate than the time it takes the system to
+// wake us up.
+//
+  uint64_t nsSpin = 3 * m_jiffy;
+  if (m_spinThreshold.IsStrictlyPositive ())
+    {
+      nsSpin = std::max<uint64_t> (nsSpin, m_spinThreshold.GetNanoSeconds ());
+    }
+  uint64_t numberJiffies = ns > nsSpin ? (ns - nsSpin) / m_jiffy : 0;
   NS_LOG_INFO ("Synchronize numberJiffies = " << numberJiffies);
 //
 // This is where the real world interjects its very ugly head.  The code 
@@ -225,7 +244,7 @@ WallClockSynchronizer::DoSynchronize (uint64_t nsCurrent, uint64_t nsDelay)
 //
 // \todo Hardcoded tunable parameter below.
 //
-  if (numberJiffies > 3)
+  if (numberJiffies > 0)
     {
       NS_LOG_INFO ("SleepWait for " << numberJiffies * m_jiffy << " ns");
       NS_LOG_INFO ("SleepWait until " << nsCurrent + numberJiffies * m_jiffy 
@@ -236,7 +255,7 @@ WallClockSynchronizer::DoSynchronize (uint64_t nsCurrent, uint64_t nsDelay)
 // interrupted by a Signal.  In this case, we need to return and let the 
 // simulator re-evaluate what to do.
 //
-      if (SleepWait ((numberJiffies - 3) * m_jiffy) == false)
+      if (SleepWait (numberJiffies * m_jiffy) == false)
         {
           NS_LOG_INFO ("SleepWait interrupted");
           return false;
@@ -21,6 +21,7 @@
 
 #include "system-condition.h"
 #include "synchronizer.h"
+#include "nstime.h"
 
 /**
  * @file
@@ -60,6 +61,12 @@ namespace ns3 {
  * to use the function @c clock_nanosleep() to sleep until a simulation Time
  * specified by the caller. 
  *
+ * The wake-up from a sleep is usually late by tens of microseconds, so the
+ * synchronizer busy-waits the end of the waits.  The SpinThreshold
+ * attribute sets how long this busy wait is: with a threshold of 100 us,
+ * the events run within microseconds of their time, at the cost of a
+ * processor spinning for up to 100 us before each of them.
+ *
  * @todo Add more on jiffies, sleep, processes, etc.
  *
  * @internal
@@ -193,6 +200,8 @@ protected:
   uint64_t m_jiffy;
   /** Time recorded by DoEventStart. */
   uint64_t m_nsEventStart;
+  /** Waits shorter than this are busy waits. */
+  Time m_spinThreshold;
 
   /** Thread synchronizer. */
   SystemCondition m_condition;
@@ -0,0 +1,227 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/config.h"
+#include "ns3/string.h"
+#include "ns3/core-config.h"
+
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+
+/**
+ * \file
+ * \ingroup core-tests
+ * ProfilingSimulatorImpl test suite.
+ */
+
+using namespace ns3;
+
+/**
+ * \ingroup core-tests
+ *
+ * \brief A class whose virtual method is overridden.
+ */
+class ProfilingBase
+{
+public:
+  virtual ~ProfilingBase ();
+  /** The overridden method. */
+  virtual void Tick (void);
+};
+
+ProfilingBase::~ProfilingBase ()
+{
+}
+
+void
+ProfilingBase::Tick (void)
+{
+}
+
+/**
+ * \ingroup core-tests
+ *
+ * \brief The class overriding the virtual method.
+ */
+class ProfilingDerived : public ProfilingBase
+{
+public:
+  virtual void Tick (void);
+};
+
+void
+ProfilingDerived::Tick (void)
+{
+}
+
+/**
+ * \ingroup core-tests
+ *
+ * \brief Check the callsites, counts and times of the profiled events.
+ */
+class ProfilingSimulatorTestCase : public TestCase
+{
+public:
+  ProfilingSimulatorTestCase ();
+
+  /** An event taking one millisecond of wall-clock time. */
+  void Heavy (void);
+  /** An event taking no time. */
+  void Light (void);
+
+private:
+  virtual void DoRun (void);
+  virtual void DoTeardown (void);
+};
+
+ProfilingSimulatorTestCase::ProfilingSimulatorTestCase ()
+  : TestCase ("Check the profile of the events")
+{
+}
+
+void
+ProfilingSimulatorTestCase::Heavy (void)
+{
+  std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now ()
+    + std::chrono::milliseconds (1);
+  while (std::chrono::steady_clock::now () < end)
+    {
+    }
+}
+
+void
+ProfilingSimulatorTestCase::Light (void)
+{
+}
+
+void
+ProfilingSimulatorTestCase::DoRun (void)
+{
+  std::string reportFile = CreateTempDirFilename ("profile.txt");
+  std::string foldedFile = CreateTempDirFilename ("profile.folded");
+  Config::SetDefault ("ns3::ProfilingSimulatorImpl::ReportFile", StringValue (reportFile));
+  Config::SetDefault ("ns3::ProfilingSimulatorImpl::FoldedFile", StringValue (foldedFile));
+  Config::SetGlobal ("SimulatorImplementationType", StringValue ("ns3::ProfilingSimulatorImpl"));
+
+  ProfilingDerived derived;
+  ProfilingBase *base = &derived;
+  for (uint32_t i = 0; i < 10; i++)
+    {
+      Simulator::ScheduleWithContext (1, MicroSeconds (i), &ProfilingSimulatorTestCase::Heavy, this);
+      Simulator::ScheduleWithContext (2, MicroSeconds (i), &ProfilingSimulatorTestCase::Light, this);
+    }
+  for (uint32_t i = 0; i < 5; i++)
+    {
+      Simulator::ScheduleWithContext (2, MicroSeconds (i), &ProfilingSimulatorTestCase::Heavy, this);
+      Simulator::ScheduleWithContext (1, MicroSeconds (i), &ProfilingBase::Tick, base);
+    }
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  // The folded stacks, as context and function
+  std::map<std::pair<std::string, std::string>, uint64_t> stacks;
+  std::ifstream folded (foldedFile.c_str ());
+  NS_TEST_ASSERT_MSG_EQ (folded.is_open (), true, "No folded stacks");
+  std::string line;
+  while (std::getline (folded, line))
+    {
+      std::string::size_type semicolon = line.find (';');
+      std::string::size_type space = line.rfind (' ');
+      NS_TEST_ASSERT_MSG_NE (semicolon, std::string::npos, "Wrong folded stack " << line);
+      NS_TEST_ASSERT_MSG_NE (space, std::string::npos, "Wrong folded stack " << line);
+      std::istringstream nanoseconds (line.substr (space + 1));
+      uint64_t time;
+      nanoseconds >> time;
+      stacks[std::make_pair (line.substr (0, semicolon),
+                             line.substr (semicolon + 1, space - semicolon - 1))] = time;
+    }
+  NS_TEST_ASSERT_MSG_EQ (stacks.size (), 4, "Wrong number of callsites");
+
+  // The counts, from the report
+  std::map<std::pair<std::string, std::string>, uint64_t> counts;
+  std::ifstream report (reportFile.c_str ());
+  NS_TEST_ASSERT_MSG_EQ (report.is_open (), true, "No report");
+  while (std::getline (report, line) && line != "By function and context:")
+    {
+    }
+  std::getline (report, line);
+  while (std::getline (report, line))
+    {
+      std::istringstream iss (line);
+      double time, mean;
+      std::string share, context, number, function;
+      uint64_t count;
+      iss >> time >> share >> count >> mean >> context >> number >> std::ws;
+      std::getline (iss, function);
+      counts[std::make_pair (context + " " + number, function)] = count;
+    }
+  NS_TEST_ASSERT_MSG_EQ (counts.size (), 4, "Wrong number of callsites in the report");
+
+  std::map<std::pair<std::string, std::string>, uint64_t>::const_iterator i;
+  std::string heavy, light, tick;
+  for (i = stacks.begin (); i != stacks.end (); ++i)
+    {
+      NS_TEST_ASSERT_MSG_EQ (counts.count (i->first), 1, "Callsite not reported: " << i->first.second);
+      const std::string &function = i->first.second;
+      std::string &name = function.find ("Heavy") != std::string::npos ? heavy
+        : function.find ("Light") != std::string::npos ? light : tick;
+      name = function;
+    }
+#if defined (HAVE_DLFCN_H) && defined (HAVE_DL)
+  NS_TEST_ASSERT_MSG_EQ (heavy, "ProfilingSimulatorTestCase::Heavy()", "Wrong name of the heavy event");
+  NS_TEST_ASSERT_MSG_EQ (light, "ProfilingSimulatorTestCase::Light()", "Wrong name of the light event");
+  // The virtual method is attributed to the override called
+  NS_TEST_ASSERT_MSG_EQ (tick, "ProfilingDerived::Tick()", "Wrong name of the virtual event");
+#endif
+
+  typedef std::pair<std::string, std::string> Key;
+  NS_TEST_ASSERT_MSG_EQ (counts[Key ("context 1", heavy)], 10, "Wrong count of the heavy events of context 1");
+  NS_TEST_ASSERT_MSG_EQ (counts[Key ("context 2", heavy)], 5, "Wrong count of the heavy events of context 2");
+  NS_TEST_ASSERT_MSG_EQ (counts[Key ("context 2", light)], 10, "Wrong count of the light events");
+  NS_TEST_ASSERT_MSG_EQ (counts[Key ("context 1", tick)], 5, "Wrong count of the virtual events");
+  NS_TEST_ASSERT_MSG_GT (stacks[Key ("context 1", heavy)], 10000000, "Heavy events too fast");
+  NS_TEST_ASSERT_MSG_LT (stacks[Key ("context 2", light)], stacks[Key ("context 2", heavy)],
+                         "Light events slower than the heavy ones");
+}
+
+void
+ProfilingSimulatorTestCase::DoTeardown (void)
+{
+  Config::Reset ();
+}
+
+/**
+ * \ingroup core-tests
+ *
+ * \brief The ProfilingSimulatorImpl TestSuite
+ */
+class ProfilingSimulatorTestSuite : public TestSuite
+{
+public:
+  ProfilingSimulatorTestSuite ()
+    : TestSuite ("profiling-simulator")
+  {
+    AddTestCase (new ProfilingSimulatorTestCase (), TestCase::QUICK);
+  }
+};
+
+static ProfilingSimulatorTestSuite g_profilingSimulatorTestSuite; //!< Static variable for test initialization
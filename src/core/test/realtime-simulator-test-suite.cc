@@ -0,0 +1,176 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/realtime-simulator-impl.h"
+#include "ns3/config.h"
+#include "ns3/string.h"
+#include "ns3/nstime.h"
+
+#include <chrono>
+#include <numeric>
+#include <sstream>
+#include <string>
+
+/**
+ * \file
+ * \ingroup core-tests
+ * RealtimeSimulatorImpl test suite.
+ */
+
+using namespace ns3;
+
+/**
+ * \ingroup core-tests
+ *
+ * \brief Check the synchronization statistics, with or without the busy
+ * waits and the batches.
+ */
+class RealtimeSimulatorSyncTestCase : public TestCase
+{
+public:
+  /**
+   * Constructor.
+   * \param [in] spinThreshold The SpinThreshold of the synchronizer.
+   * \param [in] batchWindow The BatchWindow of the simulator.
+   */
+  RealtimeSimulatorSyncTestCase (Time spinThreshold, Time batchWindow);
+
+private:
+  virtual void DoRun (void);
+  virtual void DoTeardown (void);
+
+  /**
+   * An event taking some wall-clock time.
+   * \param [in] duration The wall-clock time.
+   */
+  static void Busy (Time duration);
+  /** An event taking no time. */
+  static void Light (void);
+
+  Time m_spinThreshold;  //!< The SpinThreshold of the synchronizer
+  Time m_batchWindow;    //!< The BatchWindow of the simulator
+};
+
+/**
+ * Get the name of a RealtimeSimulatorSyncTestCase.
+ * \param [in] spinThreshold The SpinThreshold of the synchronizer.
+ * \param [in] batchWindow The BatchWindow of the simulator.
+ * \returns The name of the test case.
+ */
+static std::string
+GetSyncTestCaseName (Time spinThreshold, Time batchWindow)
+{
+  std::ostringstream oss;
+  oss << "Check the synchronization with SpinThreshold=" << spinThreshold.As (Time::US)
+      << " and BatchWindow=" << batchWindow.As (Time::US);
+  return oss.str ();
+}
+
+RealtimeSimulatorSyncTestCase::RealtimeSimulatorSyncTestCase (Time spinThreshold, Time batchWindow)
+  : TestCase (GetSyncTestCaseName (spinThreshold, batchWindow)),
+    m_spinThreshold (spinThreshold),
+    m_batchWindow (batchWindow)
+{
+}
+
+void
+RealtimeSimulatorSyncTestCase::Busy (Time duration)
+{
+  std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now ()
+    + std::chrono::nanoseconds (duration.GetNanoSeconds ());
+  while (std::chrono::steady_clock::now () < end)
+    {
+    }
+}
+
+void
+RealtimeSimulatorSyncTestCase::Light (void)
+{
+}
+
+void
+RealtimeSimulatorSyncTestCase::DoRun (void)
+{
+  Config::SetDefault ("ns3::WallClockSynchronizer::SpinThreshold", TimeValue (m_spinThreshold));
+  Config::SetDefault ("ns3::RealtimeSimulatorImpl::BatchWindow", TimeValue (m_batchWindow));
+  Config::SetGlobal ("SimulatorImplementationType", StringValue ("ns3::RealtimeSimulatorImpl"));
+
+  // Ten events 100 us apart, and an event 5 ms late after a busy one
+  for (uint32_t i = 1; i <= 10; i++)
+    {
+      Simulator::Schedule (MicroSeconds (100 * i), &RealtimeSimulatorSyncTestCase::Light);
+    }
+  Simulator::Schedule (MilliSeconds (10), &RealtimeSimulatorSyncTestCase::Busy, MilliSeconds (6));
+  Simulator::Schedule (MilliSeconds (11), &RealtimeSimulatorSyncTestCase::Light);
+  Simulator::Stop (MilliSeconds (20));
+  Simulator::Run ();
+
+  Ptr<RealtimeSimulatorImpl> impl = DynamicCast<RealtimeSimulatorImpl> (Simulator::GetImplementation ());
+  NS_TEST_ASSERT_MSG_NE (impl, 0, "Not a realtime simulator");
+  RealtimeSimulatorImpl::SynchronizationStats stats = impl->GetSynchronizationStats ();
+  std::ostringstream oss;
+  impl->PrintSynchronizationStats (oss);
+  Simulator::Destroy ();
+
+  NS_TEST_EXPECT_MSG_EQ (stats.events, 13, "Wrong number of events: " << oss.str ());
+  NS_TEST_EXPECT_MSG_EQ (std::accumulate (stats.late.begin (), stats.late.end (), uint64_t (0)),
+                         stats.events - stats.earlyEvents, "Wrong histogram of the late events");
+  NS_TEST_EXPECT_MSG_EQ (std::accumulate (stats.early.begin (), stats.early.end (), uint64_t (0)),
+                         stats.earlyEvents, "Wrong histogram of the early events");
+  uint64_t busyLateness = MilliSeconds (5).GetTimeStep ();
+  NS_TEST_EXPECT_MSG_GT_OR_EQ (stats.maxLateness, busyLateness,
+                               "The event after the busy one is not late");
+  NS_TEST_EXPECT_MSG_LT_OR_EQ (stats.totalLateness, stats.maxLateness * stats.events,
+                               "Wrong total lateness");
+  if (m_batchWindow.IsZero ())
+    {
+      NS_TEST_EXPECT_MSG_EQ (stats.earlyEvents, 0, "Events run early: " << oss.str ());
+    }
+  else
+    {
+      // The ten first events are within the batch window of the start,
+      // and run at once
+      NS_TEST_EXPECT_MSG_GT_OR_EQ (stats.earlyEvents, 10, "Events not batched: " << oss.str ());
+    }
+}
+
+void
+RealtimeSimulatorSyncTestCase::DoTeardown (void)
+{
+  Config::Reset ();
+}
+
+/**
+ * \ingroup core-tests
+ *
+ * \brief The RealtimeSimulatorImpl TestSuite
+ */
+class RealtimeSimulatorTestSuite : public TestSuite
+{
+public:
+  RealtimeSimulatorTestSuite ()
+    : TestSuite ("realtime-simulator")
+  {
+    AddTestCase (new RealtimeSimulatorSyncTestCase (Seconds (0), Seconds (0)), TestCase::QUICK);
+    AddTestCase (new RealtimeSimulatorSyncTestCase (MicroSeconds (100), Seconds (0)), TestCase::QUICK);
+    AddTestCase (new RealtimeSimulatorSyncTestCase (MicroSeconds (100), MilliSeconds (5)), TestCase::QUICK);
+  }
+};
+
+static RealtimeSimulatorTestSuite g_realtimeSimulatorTestSuite; //!< Static variable for test initialization
@@ -0,0 +1,358 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ns3/test.h"
+#include "ns3/replication-runner.h"
+#include "ns3/command-line.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/simulator.h"
+#include "ns3/names.h"
+#include "ns3/double.h"
+#include "ns3/nstime.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/**
+ * \file
+ * \ingroup core-tests
+ * ReplicationRunner test suite.
+ */
+
+using namespace ns3;
+
+/**
+ * \ingroup core-tests
+ *
+ * \brief Check the arguments and run numbers of the replications.
+ */
+class ReplicationRunnerArgumentsTestCase : public TestCase
+{
+public:
+  ReplicationRunnerArgumentsTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+ReplicationRunnerArgumentsTestCase::ReplicationRunnerArgumentsTestCase ()
+  : TestCase ("Check the arguments of the replications")
+{
+}
+
+void
+ReplicationRunnerArgumentsTestCase::DoRun (void)
+{
+  ReplicationRunner runner;
+  NS_TEST_ASSERT_MSG_EQ (runner.GetNReplications (), 1, "Wrong default number of replications");
+  runner.SetRuns (5, 2);
+  runner.AddParameter ("a", "x,y");
+  NS_TEST_ASSERT_MSG_EQ (runner.ParseParameter ("ns3::Foo::Bar=1,2,3"), true, "Valid parameter rejected");
+  NS_TEST_ASSERT_MSG_EQ (runner.ParseParameter ("=1,2"), false, "Parameter without name accepted");
+  NS_TEST_ASSERT_MSG_EQ (runner.ParseParameter ("b"), false, "Parameter without values accepted");
+  NS_TEST_ASSERT_MSG_EQ (runner.GetNReplications (), 12, "Wrong number of replications");
+
+  // The runs of a set of values are consecutive, the last parameter
+  // varies the fastest
+  const char *expected[][2] = {
+    { "--a=x", "--ns3::Foo::Bar=1" },
+    { "--a=x", "--ns3::Foo::Bar=2" },
+    { "--a=x", "--ns3::Foo::Bar=3" },
+    { "--a=y", "--ns3::Foo::Bar=1" },
+    { "--a=y", "--ns3::Foo::Bar=2" },
+    { "--a=y", "--ns3::Foo::Bar=3" },
+  };
+  for (uint32_t i = 0; i < 12; i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (runner.GetRun (i), 5 + i % 2, "Wrong run of replication " << i);
+      std::vector<std::string> arguments = runner.GetArguments (i);
+      NS_TEST_ASSERT_MSG_EQ (arguments.size (), 2, "Wrong number of arguments of replication " << i);
+      NS_TEST_ASSERT_MSG_EQ (arguments[0], expected[i / 2][0], "Wrong argument of replication " << i);
+      NS_TEST_ASSERT_MSG_EQ (arguments[1], expected[i / 2][1], "Wrong argument of replication " << i);
+    }
+}
+
+/**
+ * \ingroup core-tests
+ *
+ * \brief Run replications in worker processes and check their gathered output.
+ */
+class ReplicationRunnerRunTestCase : public TestCase
+{
+public:
+  ReplicationRunnerRunTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * The scenario: write the run, the value parsed and a random number.
+   * \param [in] replication The replication.
+   */
+  static void Scenario (const ReplicationRunner::Replication &replication);
+  /** Set by the parent, inherited by the workers. */
+  static std::string m_base;
+};
+
+std::string ReplicationRunnerRunTestCase::m_base;
+
+ReplicationRunnerRunTestCase::ReplicationRunnerRunTestCase ()
+  : TestCase ("Check the replications run by the workers")
+{
+}
+
+void
+ReplicationRunnerRunTestCase::Scenario (const ReplicationRunner::Replication &replication)
+{
+  std::string value;
+  CommandLine cmd;
+  cmd.AddValue ("value", "A value", value);
+  replication.Parse (cmd);
+  if (value == "crash")
+    {
+      std::abort ();
+    }
+  Ptr<UniformRandomVariable> rng = CreateObject<UniformRandomVariable> ();
+  replication.GetOutput () << "    <Result base=\"" << m_base << "\" value=\"" << value
+                           << "\" run=\"" << replication.GetRun ()
+                           << "\" random=\"" << rng->GetInteger (0, 1000000000) << "\"/>\n";
+  Simulator::Destroy ();
+}
+
+void
+ReplicationRunnerRunTestCase::DoRun (void)
+{
+  m_base = "warm";
+  std::string fileName = CreateTempDirFilename ("replications.xml");
+  ReplicationRunner runner;
+  runner.SetRuns (1, 2);
+  runner.SetWorkers (2);
+  runner.AddParameter ("value", "a,crash,b");
+  uint32_t failed = runner.Run (MakeCallback (&ReplicationRunnerRunTestCase::Scenario), fileName);
+  NS_TEST_ASSERT_MSG_EQ (failed, 2, "Wrong number of failed replications");
+
+  std::ifstream is (fileName.c_str ());
+  NS_TEST_ASSERT_MSG_EQ (is.is_open (), true, "No output file");
+  std::vector<std::string> lines;
+  std::string line;
+  while (std::getline (is, line))
+    {
+      lines.push_back (line);
+    }
+  NS_TEST_ASSERT_MSG_EQ (lines.size (), 2 + 6 * 2 + 4 + 1, "Wrong number of lines");
+  NS_TEST_ASSERT_MSG_EQ (lines[1], "<Replications>", "Wrong root element");
+  NS_TEST_ASSERT_MSG_EQ (lines.back (), "</Replications>", "Wrong root element");
+
+  std::vector<std::string> randoms;
+  uint32_t l = 2;
+  for (uint32_t i = 0; i < 6; i++)
+    {
+      std::string value = i < 2 ? "a" : i < 4 ? "crash" : "b";
+      std::ostringstream header;
+      header << "  <Replication index=\"" << i << "\" run=\"" << 1 + i % 2
+             << "\" status=\"" << (value == "crash" ? "signal 6" : "ok")
+             << "\" arguments=\"--value=" << value << "\">";
+      NS_TEST_ASSERT_MSG_EQ (lines[l++], header.str (), "Wrong replication " << i);
+      if (value != "crash")
+        {
+          std::ostringstream result;
+          result << "    <Result base=\"warm\" value=\"" << value << "\" run=\"" << 1 + i % 2 << "\" random=\"";
+          NS_TEST_ASSERT_MSG_EQ (lines[l].compare (0, result.str ().size (), result.str ()), 0,
+                                 "Wrong result of replication " << i << ": " << lines[l]);
+          randoms.push_back (lines[l].substr (result.str ().size ()));
+          l++;
+        }
+      NS_TEST_ASSERT_MSG_EQ (lines[l++], "  </Replication>", "Wrong end of replication " << i);
+    }
+  // The random numbers only depend on the run
+  NS_TEST_ASSERT_MSG_EQ (randoms[0], randoms[2], "Different numbers for run 1");
+  NS_TEST_ASSERT_MSG_EQ (randoms[1], randoms[3], "Different numbers for run 2");
+  NS_TEST_ASSERT_MSG_NE (randoms[0], randoms[1], "Same numbers for runs 1 and 2");
+}
+
+/**
+ * \ingroup core-tests
+ *
+ * \brief Run replications from a checkpoint of a simulation.
+ */
+class ReplicationRunnerCheckpointTestCase : public TestCase
+{
+public:
+  ReplicationRunnerCheckpointTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /** Draw a random number every second. */
+  static void Draw (void);
+  /**
+   * The rest of the simulation: write the time, the sum drawn at the
+   * checkpoint, and the sum drawn at the end.
+   * \param [in] replication The replication.
+   */
+  static void Resume (const ReplicationRunner::Replication &replication);
+  /**
+   * Run the simulation up to its end.
+   * \returns The time, the sum at the checkpoint and the sum at the end.
+   */
+  static std::string Finish (void);
+
+  static Ptr<UniformRandomVariable> m_rng;   //!< The random variable
+  static uint32_t m_sum;                     //!< The sum of the numbers drawn
+};
+
+Ptr<UniformRandomVariable> ReplicationRunnerCheckpointTestCase::m_rng;
+uint32_t ReplicationRunnerCheckpointTestCase::m_sum;
+
+ReplicationRunnerCheckpointTestCase::ReplicationRunnerCheckpointTestCase ()
+  : TestCase ("Check the replications run from a checkpoint")
+{
+}
+
+void
+ReplicationRunnerCheckpointTestCase::Draw (void)
+{
+  m_sum += m_rng->GetInteger ();
+  Simulator::Schedule (Seconds (1), &ReplicationRunnerCheckpointTestCase::Draw);
+}
+
+std::string
+ReplicationRunnerCheckpointTestCase::Finish (void)
+{
+  std::ostringstream oss;
+  oss << Simulator::Now ().GetSeconds () << " " << m_sum;
+  Simulator::Stop (Seconds (20) - Simulator::Now ());
+  Simulator::Run ();
+  oss << " " << m_sum;
+  return oss.str ();
+}
+
+void
+ReplicationRunnerCheckpointTestCase::Resume (const ReplicationRunner::Replication &replication)
+{
+  CommandLine cmd;
+  replication.Parse (cmd);
+  replication.GetOutput () << Finish () << "\n";
+  m_rng = 0;
+  Simulator::Destroy ();
+}
+
+void
+ReplicationRunnerCheckpointTestCase::DoRun (void)
+{
+  m_rng = CreateObject<UniformRandomVariable> ();
+  m_rng->SetAttribute ("Min", DoubleValue (1));
+  m_rng->SetAttribute ("Max", DoubleValue (1000));
+  Names::Add ("checkpoint", m_rng);
+  m_sum = 0;
+  Simulator::Schedule (Seconds (0), &ReplicationRunnerCheckpointTestCase::Draw);
+  Simulator::Stop (Seconds (10));
+  Simulator::Run ();
+
+  std::string fileName = CreateTempDirFilename ("checkpoint.xml");
+  ReplicationRunner runner;
+  runner.SetWorkers (2);
+  runner.AddParameter ("/Names/checkpoint/Max", "1000,1");
+  runner.AddParameter ("RngRun", "1,2");
+  uint32_t failed = runner.Run (MakeCallback (&ReplicationRunnerCheckpointTestCase::Resume), fileName);
+  NS_TEST_ASSERT_MSG_EQ (failed, 0, "Failed replications");
+
+  // Several runs from a checkpoint are rejected
+  std::cout.flush ();
+  std::cerr.flush ();
+  std::fflush (0);
+  pid_t pid = fork ();
+  if (pid == 0)
+    {
+      // Keep the message of the abort out of the test output
+      if (std::freopen ("/dev/null", "w", stderr) == 0)
+        {
+          _exit (1);
+        }
+      ReplicationRunner rejected;
+      rejected.SetRuns (1, 2);
+      rejected.Run (MakeCallback (&ReplicationRunnerCheckpointTestCase::Resume),
+                    CreateTempDirFilename ("rejected.xml"));
+      _exit (0);
+    }
+  int wstatus = 0;
+  NS_TEST_ASSERT_MSG_EQ (waitpid (pid, &wstatus, 0), pid, "Lost the process");
+  bool aborted = WIFSIGNALED (wstatus);
+  NS_TEST_ASSERT_MSG_EQ (aborted, true, "Several runs from a checkpoint were not rejected");
+
+  // The calling process can still run its own simulation, unchanged
+  uint32_t sum = m_sum;
+  std::ostringstream checkpoint;
+  checkpoint << "10 " << sum << " ";
+  std::string expected = Finish ();
+  m_rng = 0;
+  Simulator::Destroy ();
+  Names::Clear ();
+
+  std::ifstream is (fileName.c_str ());
+  NS_TEST_ASSERT_MSG_EQ (is.is_open (), true, "No output file");
+  std::vector<std::string> results;
+  std::string line;
+  while (std::getline (is, line))
+    {
+      // The results, between the XML elements
+      if (line.find ('<') == std::string::npos)
+        {
+          results.push_back (line);
+        }
+    }
+  NS_TEST_ASSERT_MSG_EQ (results.size (), 4, "Wrong number of results");
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (results[i].compare (0, checkpoint.str ().size (), checkpoint.str ()), 0,
+                             "Replication " << i << " not started from the checkpoint: " << results[i]);
+    }
+  // The random number streams continue from the checkpoint, whatever the run
+  NS_TEST_ASSERT_MSG_EQ (results[0], expected, "Wrong replication of the checkpoint");
+  NS_TEST_ASSERT_MSG_EQ (results[1], expected, "Wrong replication of the checkpoint");
+  // The draws are all 1 once the attribute is set
+  std::ostringstream ones;
+  ones << checkpoint.str () << sum + 10;
+  NS_TEST_ASSERT_MSG_EQ (results[2], ones.str (), "Attribute not set at the checkpoint");
+  NS_TEST_ASSERT_MSG_EQ (results[3], ones.str (), "Attribute not set at the checkpoint");
+}
+
+/**
+ * \ingroup core-tests
+ *
+ * \brief The ReplicationRunner TestSuite
+ */
+class ReplicationRunnerTestSuite : public TestSuite
+{
+public:
+  ReplicationRunnerTestSuite ()
+    : TestSuite ("replication-runner")
+  {
+    AddTestCase (new ReplicationRunnerArgumentsTestCase (), TestCase::QUICK);
+    AddTestCase (new ReplicationRunnerRunTestCase (), TestCase::QUICK);
+    AddTestCase (new ReplicationRunnerCheckpointTestCase (), TestCase::QUICK);
+  }
+};
+
+static ReplicationRunnerTestSuite g_replicationRunnerTestSuite; //!< Static variable for test initialization
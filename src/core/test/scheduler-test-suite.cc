@@ -0,0 +1,283 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ns3/test.h"
+#include "ns3/scheduler.h"
+#include "ns3/list-scheduler.h"
+#include "ns3/heap-scheduler.h"
+#include "ns3/map-scheduler.h"
+#include "ns3/calendar-scheduler.h"
+#include "ns3/ladder-scheduler.h"
+#include "ns3/make-event.h"
+#include "ns3/object-factory.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/double.h"
+#include <set>
+#include <vector>
+#include <utility>
+
+/**
+ * \file
+ * \ingroup core-tests
+ * \ingroup scheduler
+ * Scheduler test suite.
+ */
+
+using namespace ns3;
+
+/**
+ * \ingroup core-tests
+ *
+ * \brief Check the order of the events of a scheduler against a sorted set
+ *
+ * Events are inserted, removed in order, removed at random and
+ * cancelled, with timestamps spread from identical to far apart, so that
+ * every tier of the LadderScheduler and every resizing of the
+ * CalendarScheduler is used.  The cancelled events are regularly removed
+ * with Scheduler::RemoveCancelled.
+ */
+class SchedulerOrderTestCase : public TestCase
+{
+public:
+  /**
+   * Constructor.
+   * \param [in] schedulerFactory The factory of the scheduler to check.
+   */
+  SchedulerOrderTestCase (ObjectFactory schedulerFactory);
+
+private:
+  virtual void DoRun (void);
+
+  /** Function scheduled by the events; never called. */
+  static void Nothing (void);
+
+  /**
+   * Insert an event in the scheduler and in the reference set.
+   * \param [in] ts The timestamp of the event.
+   */
+  void Insert (uint64_t ts);
+
+  /**
+   * Remove the next event of the scheduler and check it.
+   * \returns \c false if the event is not the next one of the reference.
+   */
+  bool RemoveNext (void);
+  /**
+   * Remove the cancelled events of the scheduler and check them.
+   * \returns \c false if they are not the cancelled events of the reference.
+   */
+  bool RemoveCancelled (void);
+
+  /** Event key as ordered by the scheduler: timestamp, then uid. */
+  typedef std::pair<uint64_t, uint32_t> Key;
+
+  ObjectFactory m_schedulerFactory;   //!< Factory of the scheduler
+  Ptr<Scheduler> m_scheduler;         //!< The scheduler
+  std::set<Key> m_reference;          //!< The events, in order
+  std::vector<Ptr<EventImpl> > m_impls; //!< Event implementations, by uid
+  std::vector<uint32_t> m_live;       //!< Uids of the events in the scheduler
+  std::set<uint32_t> m_cancelled;     //!< Uids of the cancelled events in the scheduler
+  std::vector<uint64_t> m_ts;         //!< Timestamps, by uid
+  uint64_t m_now;                     //!< Timestamp of the last event removed
+};
+
+SchedulerOrderTestCase::SchedulerOrderTestCase (ObjectFactory schedulerFactory)
+  : TestCase ("Check the order of the events with " +
+              schedulerFactory.GetTypeId ().GetName ()),
+    m_schedulerFactory (schedulerFactory),
+    m_now (0)
+{
+}
+
+void
+SchedulerOrderTestCase::Nothing (void)
+{
+}
+
+void
+SchedulerOrderTestCase::Insert (uint64_t ts)
+{
+  Scheduler::Event ev;
+  ev.impl = PeekPointer (m_impls[m_ts.size ()]);
+  ev.key.m_ts = ts;
+  ev.key.m_uid = m_ts.size ();
+  ev.key.m_context = 0;
+  m_scheduler->Insert (ev);
+  m_reference.insert (Key (ts, ev.key.m_uid));
+  m_live.push_back (ev.key.m_uid);
+  m_ts.push_back (ts);
+}
+
+bool
+SchedulerOrderTestCase::RemoveNext (void)
+{
+  Key next = *m_reference.begin ();
+  Scheduler::Event peeked = m_scheduler->PeekNext ();
+  Scheduler::Event ev = m_scheduler->RemoveNext ();
+  m_reference.erase (m_reference.begin ());
+  m_cancelled.erase (next.second);
+  for (uint32_t i = 0; i < m_live.size (); i++)
+    {
+      if (m_live[i] == next.second)
+        {
+          m_live[i] = m_live.back ();
+          m_live.pop_back ();
+          break;
+        }
+    }
+  m_now = next.first;
+  return peeked.key.m_uid == next.second && ev.key.m_uid == next.second
+         && ev.key.m_ts == next.first && ev.impl == PeekPointer (m_impls[next.second]);
+}
+
+bool
+SchedulerOrderTestCase::RemoveCancelled (void)
+{
+  std::vector<Scheduler::Event> removed;
+  m_scheduler->RemoveCancelled (removed);
+  std::set<uint32_t> uids;
+  for (std::vector<Scheduler::Event>::const_iterator i = removed.begin (); i != removed.end (); ++i)
+    {
+      uids.insert (i->key.m_uid);
+      m_reference.erase (Key (i->key.m_ts, i->key.m_uid));
+    }
+  bool ok = uids.size () == removed.size () && uids == m_cancelled;
+  for (uint32_t i = 0; i < m_live.size (); )
+    {
+      if (m_cancelled.count (m_live[i]) != 0)
+        {
+          m_live[i] = m_live.back ();
+          m_live.pop_back ();
+        }
+      else
+        {
+          i++;
+        }
+    }
+  m_cancelled.clear ();
+  return ok;
+}
+
+void
+SchedulerOrderTestCase::DoRun (void)
+{
+  const uint32_t nEvents = 10000;
+  m_scheduler = m_schedulerFactory.Create<Scheduler> ();
+  for (uint32_t i = 0; i < nEvents; i++)
+    {
+      m_impls.push_back (Ptr<EventImpl> (MakeEvent (&SchedulerOrderTestCase::Nothing), false));
+    }
+  Ptr<UniformRandomVariable> rng = CreateObject<UniformRandomVariable> ();
+  Ptr<ExponentialRandomVariable> delay = CreateObject<ExponentialRandomVariable> ();
+  delay->SetAttribute ("Mean", DoubleValue (1000));
+
+  uint32_t step = 0;
+  while (m_ts.size () < nEvents)
+    {
+      // Grow the number of events in the first half, then shrink it
+      uint32_t insertWeight = m_ts.size () < nEvents / 2 ? 6 : 3;
+      uint32_t op = rng->GetInteger (0, 9);
+      if (op < insertWeight || m_reference.empty ())
+        {
+          // Some events are at the time of the last one
+          uint32_t kind = rng->GetInteger (0, 9);
+          uint64_t ts = m_now;
+          if (kind < 2)
+            {
+              ts += rng->GetInteger (0, 1);
+            }
+          else if (kind < 4)
+            {
+              ts += rng->GetInteger (0, 10);
+            }
+          else if (kind < 9)
+            {
+              ts += delay->GetInteger ();
+            }
+          else
+            {
+              // Far away, as timeouts are
+              ts += rng->GetInteger (1000000, 1000000000);
+            }
+          Insert (ts);
+        }
+      else if (op < 9)
+        {
+          NS_TEST_ASSERT_MSG_EQ (RemoveNext (), true, "Wrong next event at step " << step);
+        }
+      else if (rng->GetInteger (0, 1) == 0)
+        {
+          uint32_t i = rng->GetInteger (0, m_live.size () - 1);
+          uint32_t uid = m_live[i];
+          m_live[i] = m_live.back ();
+          m_live.pop_back ();
+          Scheduler::Event ev;
+          ev.impl = PeekPointer (m_impls[uid]);
+          ev.key.m_ts = m_ts[uid];
+          ev.key.m_uid = uid;
+          ev.key.m_context = 0;
+          m_scheduler->Remove (ev);
+          m_reference.erase (Key (m_ts[uid], uid));
+          m_cancelled.erase (uid);
+        }
+      else
+        {
+          // Cancelled events stay in the scheduler
+          uint32_t uid = m_live[rng->GetInteger (0, m_live.size () - 1)];
+          m_impls[uid]->Cancel ();
+          m_cancelled.insert (uid);
+        }
+      if (step % 500 == 499)
+        {
+          NS_TEST_ASSERT_MSG_EQ (RemoveCancelled (), true, "Wrong cancelled events at step " << step);
+        }
+      NS_TEST_ASSERT_MSG_EQ (m_scheduler->IsEmpty (), m_reference.empty (), "Wrong emptiness at step " << step);
+      step++;
+    }
+  while (!m_reference.empty ())
+    {
+      NS_TEST_ASSERT_MSG_EQ (RemoveNext (), true, "Wrong next event while emptying");
+    }
+  NS_TEST_ASSERT_MSG_EQ (m_scheduler->IsEmpty (), true, "Events left in the scheduler");
+}
+
+/**
+ * \ingroup core-tests
+ *
+ * \brief The scheduler TestSuite
+ */
+class SchedulerTestSuite : public TestSuite
+{
+public:
+  SchedulerTestSuite ()
+    : TestSuite ("scheduler")
+  {
+    ObjectFactory factory;
+    factory.SetTypeId (ListScheduler::GetTypeId ());
+    AddTestCase (new SchedulerOrderTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (MapScheduler::GetTypeId ());
+    AddTestCase (new SchedulerOrderTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (HeapScheduler::GetTypeId ());
+    AddTestCase (new SchedulerOrderTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (CalendarScheduler::GetTypeId ());
+    AddTestCase (new SchedulerOrderTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (LadderScheduler::GetTypeId ());
+    AddTestCase (new SchedulerOrderTestCase (factory), TestCase::QUICK);
+  }
+};
+
+static SchedulerTestSuite g_schedulerTestSuite; //!< Static variable for test initialization
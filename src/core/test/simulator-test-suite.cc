@@ -23,6 +23,15 @@
 #include "ns3/heap-scheduler.h"
 #include "ns3/map-scheduler.h"
 #include "ns3/calendar-scheduler.h"
+#include "ns3/ladder-scheduler.h"
+#include "ns3/event-impl.h"
+#include "ns3/make-event.h"
+#include "ns3/simulator-impl.h"
+#include "ns3/system-thread.h"
+#include "ns3/config.h"
+#include "ns3/double.h"
+#include "ns3/uinteger.h"
+#include <vector>
 
 using namespace ns3;
 
@@ -459,6 +468,213 @@ SimulatorTemplateTestCase::DoRun (void)
   Simulator::Destroy ();
 }
 
+class SimulatorEventPoolTestCase : public TestCase
+{
+public:
+  SimulatorEventPoolTestCase ();
+private:
+  virtual void DoRun (void);
+
+  /** An argument too large for the event free lists. */
+  struct Large
+  {
+    char m_data[1024];
+  };
+  void Chain (uint32_t left);
+  void Bulky (Large large);
+
+  uint32_t m_chained;
+  bool m_bulky;
+};
+
+SimulatorEventPoolTestCase::SimulatorEventPoolTestCase ()
+  : TestCase ("Check the reuse of the memory of the events")
+{
+}
+
+void
+SimulatorEventPoolTestCase::Chain (uint32_t left)
+{
+  m_chained++;
+  if (left > 0)
+    {
+      Simulator::Schedule (MicroSeconds (1), &SimulatorEventPoolTestCase::Chain, this, left - 1);
+    }
+}
+
+void
+SimulatorEventPoolTestCase::Bulky (Large large)
+{
+  m_bulky = large.m_data[10] == 42;
+}
+
+void
+SimulatorEventPoolTestCase::DoRun (void)
+{
+  m_chained = 0;
+  m_bulky = false;
+  EventImpl::PoolStats before = EventImpl::GetPoolStats ();
+
+  const uint32_t n = 1000;
+  Simulator::Schedule (MicroSeconds (1), &SimulatorEventPoolTestCase::Chain, this, n - 1);
+  Large large;
+  large.m_data[10] = 42;
+  Simulator::Schedule (MicroSeconds (2), &SimulatorEventPoolTestCase::Bulky, this, large);
+  EventId cancelled = Simulator::Schedule (MicroSeconds (3), &SimulatorEventPoolTestCase::Bulky, this, large);
+  cancelled.Cancel ();
+  Simulator::Run ();
+  Simulator::Destroy ();
+  cancelled = EventId ();
+
+  EventImpl::PoolStats after = EventImpl::GetPoolStats ();
+  NS_TEST_EXPECT_MSG_EQ (m_chained, n, "Chained events not run");
+  NS_TEST_EXPECT_MSG_EQ (m_bulky, true, "Large event not run");
+  NS_TEST_EXPECT_MSG_EQ (after.allocations - before.allocations, n + 2, "Events not counted");
+  NS_TEST_EXPECT_MSG_EQ (after.deallocations - before.deallocations, n + 2, "Events not freed");
+  // Each event of the chain is scheduled while the previous one runs,
+  // so that only the first two need new memory
+  NS_TEST_EXPECT_MSG_GT_OR_EQ (after.reused - before.reused, n - 2, "Memory of the events not reused");
+  NS_TEST_EXPECT_MSG_GT (after.cached, 0, "No free block kept");
+}
+
+class SimulatorCompactionTestCase : public TestCase
+{
+public:
+  SimulatorCompactionTestCase (double ratio);
+private:
+  virtual void DoRun (void);
+  virtual void DoTeardown (void);
+
+  void Count (void);
+
+  double m_ratio;
+  uint32_t m_count;
+};
+
+SimulatorCompactionTestCase::SimulatorCompactionTestCase (double ratio)
+  : TestCase (ratio < 1 ? "Check the compaction of cancelled events"
+              : "Check the counts of cancelled events without compaction"),
+    m_ratio (ratio)
+{
+}
+
+void
+SimulatorCompactionTestCase::Count (void)
+{
+  m_count++;
+}
+
+void
+SimulatorCompactionTestCase::DoRun (void)
+{
+  Config::SetDefault ("ns3::DefaultSimulatorImpl::CompactionRatio", DoubleValue (m_ratio));
+  Config::SetDefault ("ns3::DefaultSimulatorImpl::CompactionMinEvents", UintegerValue (100));
+  m_count = 0;
+
+  std::vector<EventId> ids;
+  std::vector<bool> cancelled (1000, false);
+  for (uint32_t i = 0; i < 1000; i++)
+    {
+      ids.push_back (Simulator::Schedule (MicroSeconds (i + 1), &SimulatorCompactionTestCase::Count, this));
+    }
+  for (uint32_t i = 0; i < 600; i++)
+    {
+      ids[i * 5 / 3].Cancel ();
+      cancelled[i * 5 / 3] = true;
+    }
+  // Cancelling twice is not counted twice
+  ids[0].Cancel ();
+
+  Simulator::EventCounts counts = Simulator::GetEventCounts ();
+  NS_TEST_EXPECT_MSG_EQ (counts.live, 400, "Wrong number of live events");
+  if (m_ratio < 1)
+    {
+      // The 501st cancelled event triggers the compaction
+      NS_TEST_EXPECT_MSG_EQ (counts.cancelled, 99, "Wrong number of cancelled events");
+      NS_TEST_EXPECT_MSG_EQ (counts.compactions, 1, "Wrong number of compactions");
+      NS_TEST_EXPECT_MSG_EQ (counts.purged, 501, "Wrong number of purged events");
+    }
+  else
+    {
+      NS_TEST_EXPECT_MSG_EQ (counts.cancelled, 600, "Wrong number of cancelled events");
+      NS_TEST_EXPECT_MSG_EQ (counts.compactions, 0, "Wrong number of compactions");
+    }
+  for (uint32_t i = 0; i < 1000; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (ids[i].IsExpired (), cancelled[i], "Wrong expiration of event " << i);
+    }
+
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (m_count, 400, "Wrong number of events run");
+  counts = Simulator::GetEventCounts ();
+  NS_TEST_EXPECT_MSG_EQ (counts.live, 0, "Live events left");
+  NS_TEST_EXPECT_MSG_EQ (counts.cancelled, 0, "Cancelled events left");
+  Simulator::Destroy ();
+}
+
+void
+SimulatorCompactionTestCase::DoTeardown (void)
+{
+  Config::Reset ();
+}
+
+class SimulatorInboxCancelTestCase : public TestCase
+{
+public:
+  SimulatorInboxCancelTestCase ();
+private:
+  virtual void DoRun (void);
+
+  static void SchedulingThread (EventImpl *event);
+  void Count (void);
+
+  uint32_t m_count;
+};
+
+SimulatorInboxCancelTestCase::SimulatorInboxCancelTestCase ()
+  : TestCase ("Check the counts of an event cancelled before leaving the inbox of another thread")
+{
+}
+
+void
+SimulatorInboxCancelTestCase::SchedulingThread (EventImpl *event)
+{
+  Simulator::GetImplementation ()->ScheduleWithContext (1, Seconds (1), event);
+  event->Cancel ();
+}
+
+void
+SimulatorInboxCancelTestCase::Count (void)
+{
+  m_count++;
+}
+
+void
+SimulatorInboxCancelTestCase::DoRun (void)
+{
+  m_count = 0;
+  // Create the simulator in the main thread
+  Simulator::GetImplementation ();
+
+  EventImpl *event = MakeEvent (&SimulatorInboxCancelTestCase::Count, this);
+  event->Ref ();
+  Ptr<SystemThread> thread = Create<SystemThread> (MakeBoundCallback (
+      &SimulatorInboxCancelTestCase::SchedulingThread, event));
+  thread->Start ();
+  thread->Join ();
+  Simulator::Schedule (Seconds (2), &SimulatorInboxCancelTestCase::Count, this);
+
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (m_count, 1, "Cancelled event run");
+  Simulator::EventCounts counts = Simulator::GetEventCounts ();
+  NS_TEST_EXPECT_MSG_EQ (counts.live, 0, "Live events left");
+  NS_TEST_EXPECT_MSG_EQ (counts.cancelled, 0, "Cancelled events left");
+  Simulator::Destroy ();
+  uint32_t references = event->GetReferenceCount ();
+  event->Unref ();
+  NS_TEST_EXPECT_MSG_EQ (references, 1, "Cancelled event leaked");
+}
+
 class SimulatorTestSuite : public TestSuite
 {
 public:
@@ -475,5 +691,11 @@ public:
     AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
     factory.SetTypeId (CalendarScheduler::GetTypeId ());
     AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (LadderScheduler::GetTypeId ());
+    AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
+    AddTestCase (new SimulatorEventPoolTestCase (), TestCase::QUICK);
+    AddTestCase (new SimulatorCompactionTestCase (0.5), TestCase::QUICK);
+    AddTestCase (new SimulatorCompactionTestCase (1), TestCase::QUICK);
+    AddTestCase (new SimulatorInboxCancelTestCase (), TestCase::QUICK);
   }
 } g_simulatorTestSuite;
@@ -23,13 +23,18 @@
 #include "ns3/heap-scheduler.h"
 #include "ns3/map-scheduler.h"
 #include "ns3/calendar-scheduler.h"
+#include "ns3/ladder-scheduler.h"
 #include "ns3/config.h"
 #include "ns3/string.h"
 #include "ns3/system-thread.h"
+#include "ns3/make-event.h"
+#include "ns3/event-impl.h"
+#include "ns3/simulator-impl.h"
 
 #include <ctime>
 #include <list>
 #include <utility>
+#include <vector>
 
 using namespace ns3;
 
@@ -225,6 +230,185 @@ ThreadedSimulatorEventsTestCase::DoRun (void)
   NS_TEST_EXPECT_MSG_EQ (m_a, m_d, "Bad scheduling");
 }
 
+/**
+ * Check that the events scheduled by many threads at once all run, in the
+ * order each thread scheduled them.
+ */
+class ThreadedSimulatorInboxTestCase : public TestCase
+{
+public:
+  ThreadedSimulatorInboxTestCase (const std::string &simulatorType, uint32_t threads, uint32_t events);
+
+private:
+  virtual void DoRun (void);
+  virtual void DoTeardown (void);
+
+  /**
+   * Schedule the events of a thread as fast as possible.
+   * \param [in] context The test case and the thread number.
+   */
+  static void SchedulingThread (std::pair<ThreadedSimulatorInboxTestCase *, uint32_t> context);
+  /**
+   * An event scheduled by a thread.
+   * \param [in] thread The thread number.
+   * \param [in] sequence The sequence number of the event in the thread.
+   */
+  void Receive (uint32_t thread, uint32_t sequence);
+  /** Run the simulation until all the events are received. */
+  void Poll (void);
+
+  std::string m_simulatorType;        //!< The simulator implementation
+  uint32_t m_threads;                 //!< Number of scheduling threads
+  uint32_t m_events;                  //!< Number of events of each thread
+  std::vector<uint32_t> m_received;   //!< Events received of each thread
+  uint32_t m_total;                   //!< Events received
+  bool m_ordered;                     //!< All the events ran in order
+};
+
+ThreadedSimulatorInboxTestCase::ThreadedSimulatorInboxTestCase (const std::string &simulatorType,
+                                                                uint32_t threads, uint32_t events)
+  : TestCase ("Check the events scheduled at once by many threads in " + simulatorType),
+    m_simulatorType (simulatorType),
+    m_threads (threads),
+    m_events (events)
+{
+}
+
+void
+ThreadedSimulatorInboxTestCase::SchedulingThread (std::pair<ThreadedSimulatorInboxTestCase *, uint32_t> context)
+{
+  ThreadedSimulatorInboxTestCase *me = context.first;
+  uint32_t thread = context.second;
+  for (uint32_t i = 0; i < me->m_events; i++)
+    {
+      Simulator::ScheduleWithContext (thread, Time (0),
+                                      &ThreadedSimulatorInboxTestCase::Receive, me, thread, i);
+    }
+}
+
+void
+ThreadedSimulatorInboxTestCase::Receive (uint32_t thread, uint32_t sequence)
+{
+  if (Simulator::GetContext () != thread || m_received[thread] != sequence)
+    {
+      m_ordered = false;
+    }
+  m_received[thread]++;
+  m_total++;
+}
+
+void
+ThreadedSimulatorInboxTestCase::Poll (void)
+{
+  if (m_total < m_threads * m_events)
+    {
+      Simulator::Schedule (MicroSeconds (10), &ThreadedSimulatorInboxTestCase::Poll, this);
+    }
+  else
+    {
+      // The realtime simulator does not stop by lack of events
+      Simulator::Stop ();
+    }
+}
+
+void
+ThreadedSimulatorInboxTestCase::DoRun (void)
+{
+  Config::SetGlobal ("SimulatorImplementationType", StringValue (m_simulatorType));
+  m_received.assign (m_threads, 0);
+  m_total = 0;
+  m_ordered = true;
+
+  std::vector<Ptr<SystemThread> > threads;
+  for (uint32_t i = 0; i < m_threads; i++)
+    {
+      threads.push_back (Create<SystemThread> (MakeBoundCallback (
+            &ThreadedSimulatorInboxTestCase::SchedulingThread,
+            std::pair<ThreadedSimulatorInboxTestCase *, uint32_t> (this, i))));
+    }
+  Simulator::Schedule (MicroSeconds (10), &ThreadedSimulatorInboxTestCase::Poll, this);
+  for (uint32_t i = 0; i < m_threads; i++)
+    {
+      threads[i]->Start ();
+    }
+  Simulator::Run ();
+  for (uint32_t i = 0; i < m_threads; i++)
+    {
+      threads[i]->Join ();
+    }
+  Simulator::Destroy ();
+
+  NS_TEST_EXPECT_MSG_EQ (m_total, m_threads * m_events, "Lost events");
+  NS_TEST_EXPECT_MSG_EQ (m_ordered, true, "Events out of order");
+}
+
+void
+ThreadedSimulatorInboxTestCase::DoTeardown (void)
+{
+  Config::SetGlobal ("SimulatorImplementationType", StringValue ("ns3::DefaultSimulatorImpl"));
+}
+
+/**
+ * Check that destroying the simulator frees the events scheduled by
+ * another thread which never ran.
+ */
+class ThreadedSimulatorDisposeTestCase : public TestCase
+{
+public:
+  ThreadedSimulatorDisposeTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * Schedule the event from another thread.
+   * \param [in] event The event to schedule.
+   */
+  static void SchedulingThread (EventImpl *event);
+  /** The event, which must never run. */
+  void Receive (void);
+
+  bool m_received; //!< The event ran
+};
+
+ThreadedSimulatorDisposeTestCase::ThreadedSimulatorDisposeTestCase ()
+  : TestCase ("Check that Destroy frees the events scheduled by other threads")
+{
+}
+
+void
+ThreadedSimulatorDisposeTestCase::SchedulingThread (EventImpl *event)
+{
+  Simulator::GetImplementation ()->ScheduleWithContext (1, Seconds (1), event);
+}
+
+void
+ThreadedSimulatorDisposeTestCase::Receive (void)
+{
+  m_received = true;
+}
+
+void
+ThreadedSimulatorDisposeTestCase::DoRun (void)
+{
+  m_received = false;
+  // Create the simulator in the main thread
+  Simulator::GetImplementation ();
+
+  EventImpl *event = MakeEvent (&ThreadedSimulatorDisposeTestCase::Receive, this);
+  event->Ref ();
+  Ptr<SystemThread> thread = Create<SystemThread> (MakeBoundCallback (
+      &ThreadedSimulatorDisposeTestCase::SchedulingThread, event));
+  thread->Start ();
+  thread->Join ();
+  Simulator::Destroy ();
+
+  uint32_t references = event->GetReferenceCount ();
+  event->Unref ();
+  NS_TEST_EXPECT_MSG_EQ (references, 1, "Event of another thread leaked by Destroy");
+  NS_TEST_EXPECT_MSG_EQ (m_received, false, "Event ran without Run");
+}
+
 class ThreadedSimulatorTestSuite : public TestSuite
 {
 public:
@@ -241,7 +425,8 @@ public:
       "ns3::ListScheduler",
       "ns3::HeapScheduler",
       "ns3::MapScheduler",
-      "ns3::CalendarScheduler"
+      "ns3::CalendarScheduler",
+      "ns3::LadderScheduler"
     };
     unsigned int threadcounts[] = {
       0,
@@ -261,6 +446,8 @@ public:
                 AddTestCase (new ThreadedSimulatorEventsTestCase (factory, simulatorTypes[i], threadcounts[j]), TestCase::QUICK);
               }
           }
+        AddTestCase (new ThreadedSimulatorInboxTestCase (simulatorTypes[i], 32, 10000), TestCase::QUICK);
       }
+    AddTestCase (new ThreadedSimulatorDisposeTestCase (), TestCase::QUICK);
   }
 } g_threadedSimulatorTestSuite;
@@ -89,12 +89,14 @@ TimeSimpleTestCase::DoRun (void)
                          "is 1fs really 1fs ?");
 #endif
 
+#ifndef NS3_TIME_RESOLUTION
   Time ten = NanoSeconds (10);
   int64_t tenValue = ten.GetInteger ();
   Time::SetResolution (Time::PS);
   int64_t tenKValue = ten.GetInteger ();
   NS_TEST_ASSERT_MSG_EQ (tenValue * 1000, tenKValue,
                          "change resolution to PS");
+#endif
 }
 
 void 
@@ -229,7 +231,58 @@ TimeInputOutputTestCase::DoRun (void)
 
   std::cout << std::endl;
 }
-    
+
+class TimeConversionTestCase : public TestCase
+{
+public:
+  TimeConversionTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+TimeConversionTestCase::TimeConversionTestCase ()
+  : TestCase ("Conversions between units, with the resolution fixed or not")
+{
+}
+
+void
+TimeConversionTestCase::DoRun (void)
+{
+  // The expected values assume ns resolution
+  NS_TEST_ASSERT_MSG_EQ (Time::GetResolution (), Time::NS, "Resolution is not NS");
+
+  NS_TEST_ASSERT_MSG_EQ (Years (1).GetTimeStep (), 31536000000000000LL, "Years");
+  NS_TEST_ASSERT_MSG_EQ (Days (1.5).GetTimeStep (), 129600000000000LL, "Days");
+  NS_TEST_ASSERT_MSG_EQ (Hours (2).GetTimeStep (), 7200000000000LL, "Hours");
+  NS_TEST_ASSERT_MSG_EQ (Minutes (0.5).GetTimeStep (), 30000000000LL, "Minutes");
+  NS_TEST_ASSERT_MSG_EQ (Seconds (1.25).GetTimeStep (), 1250000000, "Seconds");
+  NS_TEST_ASSERT_MSG_EQ (Seconds (-1.25).GetTimeStep (), -1250000000, "Negative seconds");
+  // Rounded down
+  NS_TEST_ASSERT_MSG_EQ (Seconds (0.3).GetTimeStep (), 299999999, "Inexact seconds");
+  NS_TEST_ASSERT_MSG_EQ (Seconds (1e-10).GetTimeStep (), 0, "Seconds below the resolution");
+  NS_TEST_ASSERT_MSG_EQ (MilliSeconds (3).GetTimeStep (), 3000000, "MilliSeconds");
+  NS_TEST_ASSERT_MSG_EQ (MicroSeconds (7).GetTimeStep (), 7000, "MicroSeconds");
+  NS_TEST_ASSERT_MSG_EQ (NanoSeconds (11).GetTimeStep (), 11, "NanoSeconds");
+  NS_TEST_ASSERT_MSG_EQ (PicoSeconds (12345).GetTimeStep (), 12, "PicoSeconds");
+  NS_TEST_ASSERT_MSG_EQ (FemtoSeconds (999999).GetTimeStep (), 0, "FemtoSeconds");
+  NS_TEST_ASSERT_MSG_EQ (Time::FromDouble (2.5, Time::US).GetTimeStep (), 2500, "FromDouble");
+
+  Time t = NanoSeconds (90061001002003LL);  // 1d 1h 1min 1.001002003s
+  NS_TEST_ASSERT_MSG_EQ_TOL (t.GetDays (), 90061001002003 / 86400e9, 1e-15, "GetDays");
+  NS_TEST_ASSERT_MSG_EQ_TOL (t.GetHours (), 90061001002003 / 3600e9, 1e-13, "GetHours");
+  NS_TEST_ASSERT_MSG_EQ_TOL (t.GetMinutes (), 90061001002003 / 60e9, 1e-11, "GetMinutes");
+  NS_TEST_ASSERT_MSG_EQ_TOL (t.GetSeconds (), 90061.001002003, 1e-9, "GetSeconds");
+  NS_TEST_ASSERT_MSG_EQ (t.GetMilliSeconds (), 90061001, "GetMilliSeconds");
+  NS_TEST_ASSERT_MSG_EQ (t.GetMicroSeconds (), 90061001002LL, "GetMicroSeconds");
+  NS_TEST_ASSERT_MSG_EQ (t.GetNanoSeconds (), 90061001002003LL, "GetNanoSeconds");
+  NS_TEST_ASSERT_MSG_EQ (t.GetPicoSeconds (), 90061001002003000LL, "GetPicoSeconds");
+  NS_TEST_ASSERT_MSG_EQ (t.ToInteger (Time::S), 90061, "ToInteger");
+  NS_TEST_ASSERT_MSG_EQ (Time (-t.GetTimeStep ()).ToInteger (Time::MS), -90061001,
+                         "Negative ToInteger");
+  NS_TEST_ASSERT_MSG_EQ_TOL (MilliSeconds (3).GetSeconds (), 0.003, 1e-15, "GetSeconds of ms");
+  NS_TEST_ASSERT_MSG_EQ_TOL ((Seconds (2.5) * 3).GetSeconds (), 7.5, 1e-15, "Scaled");
+}
+
 static class TimeTestSuite : public TestSuite
 {
 public:
@@ -238,6 +291,7 @@ public:
   {
     AddTestCase (new TimeWithSignTestCase (), TestCase::QUICK);
     AddTestCase (new TimeInputOutputTestCase (), TestCase::QUICK);
+    AddTestCase (new TimeConversionTestCase (), TestCase::QUICK);
     // This should be last, since it changes the resolution
     AddTestCase (new TimeSimpleTestCase (), TestCase::QUICK);
   }
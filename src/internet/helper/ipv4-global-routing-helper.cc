@@ -22,6 +22,7 @@
 #include "ns3/ipv4-global-routing.h"
 #include "ns3/ipv4-list-routing.h"
 #include "ns3/log.h"
+#include "ns3/system-wall-clock-ms.h"
 
 namespace ns3 {
 
@@ -60,15 +61,21 @@ Ipv4GlobalRoutingHelper::Create (Ptr<Node> node) const
 void 
 Ipv4GlobalRoutingHelper::PopulateRoutingTables (void)
 {
+  SystemWallClockMs clock;
+  clock.Start ();
   GlobalRouteManager::BuildGlobalRoutingDatabase ();
   GlobalRouteManager::InitializeRoutes ();
+  int64_t elapsed = clock.End ();
+  NS_LOG_INFO ("Populated the routing tables in " << elapsed << " ms");
 }
 void 
 Ipv4GlobalRoutingHelper::RecomputeRoutingTables (void)
 {
-  GlobalRouteManager::DeleteGlobalRoutes ();
-  GlobalRouteManager::BuildGlobalRoutingDatabase ();
-  GlobalRouteManager::InitializeRoutes ();
+  SystemWallClockMs clock;
+  clock.Start ();
+  GlobalRouteManager::UpdateRoutes ();
+  int64_t elapsed = clock.End ();
+  NS_LOG_INFO ("Recomputed the routing tables in " << elapsed << " ms");
 }
 
 
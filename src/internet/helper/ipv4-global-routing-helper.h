@@ -69,6 +69,8 @@ public:
    * All this function does is call the functions
    * BuildGlobalRoutingDatabase () and  InitializeRoutes ().
    *
+   * The routes of the routers are computed by as many threads as the
+   * "GlobalRoutingThreads" global value, one by default.
    */
   static void PopulateRoutingTables (void);
   /**
@@ -82,6 +84,9 @@ public:
    * Users must first call PopulateRoutingTables() and then may subsequently
    * call RecomputeRoutingTables() at any later time in the simulation.
    *
+   * The routes which did not change are left in place rather than removed
+   * and added again; the resulting tables are the same.
+   *
    */
   static void RecomputeRoutingTables (void);
 private:
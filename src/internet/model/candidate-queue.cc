@@ -49,24 +49,27 @@ operator<< (std::ostream& os, const SPFVertex::VertexType& t)
 std::ostream& 
 operator<< (std::ostream& os, const CandidateQueue& q)
 {
-  typedef CandidateQueue::CandidateList_t List_t;
+  typedef std::vector<CandidateQueue::Candidate> List_t;
   typedef List_t::const_iterator CIter_t;
-  const CandidateQueue::CandidateList_t& list = q.m_candidates;
+  const List_t list = q.GetSorted ();
 
   os << "*** CandidateQueue Begin (<id, distance, LSA-type>) ***" << std::endl;
   for (CIter_t iter = list.begin (); iter != list.end (); iter++)
     {
       os << "<" 
-      << (*iter)->GetVertexId () << ", "
-      << (*iter)->GetDistanceFromRoot () << ", "
-      << (*iter)->GetVertexType () << ">" << std::endl;
+      << iter->m_vertex->GetVertexId () << ", "
+      << iter->m_vertex->GetDistanceFromRoot () << ", "
+      << iter->m_vertex->GetVertexType () << ">" << std::endl;
     }
   os << "*** CandidateQueue End ***";
   return os;
 }
 
 CandidateQueue::CandidateQueue()
-  : m_candidates ()
+  : m_candidates (),
+    m_positions (),
+    m_ids (),
+    m_sequence (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -94,11 +97,13 @@ CandidateQueue::Push (SPFVertex *vNew)
 {
   NS_LOG_FUNCTION (this << vNew);
 
-  CandidateList_t::iterator i = std::upper_bound (
-      m_candidates.begin (), m_candidates.end (), vNew,
-      &CandidateQueue::CompareSPFVertex
-      );
-  m_candidates.insert (i, vNew);
+  Candidate c;
+  c.m_vertex = vNew;
+  Rank (c);
+  m_candidates.push_back (c);
+  m_positions[vNew] = m_candidates.size () - 1;
+  m_ids.insert (std::make_pair (vNew->GetVertexId (), vNew));
+  SiftUp (m_candidates.size () - 1);
 }
 
 SPFVertex *
@@ -110,8 +115,25 @@ CandidateQueue::Pop (void)
       return 0;
     }
 
-  SPFVertex *v = m_candidates.front ();
-  m_candidates.pop_front ();
+  SPFVertex *v = m_candidates.front ().m_vertex;
+  m_positions.erase (v);
+  std::pair<IdMap_t::iterator, IdMap_t::iterator> range = m_ids.equal_range (v->GetVertexId ());
+  for (IdMap_t::iterator i = range.first; i != range.second; i++)
+    {
+      if (i->second == v)
+        {
+          m_ids.erase (i);
+          break;
+        }
+    }
+
+  Candidate last = m_candidates.back ();
+  m_candidates.pop_back ();
+  if (!m_candidates.empty ())
+    {
+      Place (0, last);
+      SiftDown (0);
+    }
   return v;
 }
 
@@ -124,7 +146,7 @@ CandidateQueue::Top (void) const
       return 0;
     }
 
-  return m_candidates.front ();
+  return m_candidates.front ().m_vertex;
 }
 
 bool
@@ -145,18 +167,35 @@ SPFVertex *
 CandidateQueue::Find (const Ipv4Address addr) const
 {
   NS_LOG_FUNCTION (this);
-  CandidateList_t::const_iterator i = m_candidates.begin ();
-
-  for (; i != m_candidates.end (); i++)
+//
+// Vertex IDs are unique in a routing calculation; should they not be, return
+// the vertex which would be popped first, as the scan of the sorted list did.
+//
+  std::pair<IdMap_t::const_iterator, IdMap_t::const_iterator> range = m_ids.equal_range (addr);
+  const Candidate *found = 0;
+  for (IdMap_t::const_iterator i = range.first; i != range.second; i++)
     {
-      SPFVertex *v = *i;
-      if (v->GetVertexId () == addr)
+      const Candidate *c = &m_candidates[m_positions.find (i->second)->second];
+      if (found == 0 || CompareCandidate (*c, *found))
         {
-          return v;
+          found = c;
         }
     }
 
-  return 0;
+  return found ? found->m_vertex : 0;
+}
+
+void
+CandidateQueue::Update (SPFVertex *v)
+{
+  NS_LOG_FUNCTION (this << v);
+
+  PositionMap_t::iterator i = m_positions.find (v);
+  NS_ASSERT_MSG (i != m_positions.end (), "CandidateQueue::Update (): vertex not in the queue");
+  uint32_t position = i->second;
+  Rank (m_candidates[position]);
+  SiftUp (position);
+  SiftDown (m_positions[v]);
 }
 
 void
@@ -164,11 +203,91 @@ CandidateQueue::Reorder (void)
 {
   NS_LOG_FUNCTION (this);
 
-  m_candidates.sort (&CandidateQueue::CompareSPFVertex);
+//
+// Sort the candidates by their new rank; those which compare equal keep
+// their former order, as in a stable sort of the list.  A sorted vector is
+// a heap.
+//
+  m_candidates = GetSorted ();
+  for (uint32_t i = 0; i < m_candidates.size (); i++)
+    {
+      Candidate c = m_candidates[i];
+      Rank (c);
+      Place (i, c);
+    }
   NS_LOG_LOGIC ("After reordering the CandidateQueue");
   NS_LOG_LOGIC (*this);
 }
 
+std::vector<CandidateQueue::Candidate>
+CandidateQueue::GetSorted (void) const
+{
+  NS_LOG_FUNCTION (this);
+
+  std::vector<Candidate> sorted (m_candidates);
+  std::sort (sorted.begin (), sorted.end (), &CandidateQueue::CompareCandidate);
+  std::stable_sort (sorted.begin (), sorted.end (), &CandidateQueue::CompareCandidateVertex);
+  return sorted;
+}
+
+void
+CandidateQueue::Rank (Candidate &c)
+{
+  c.m_distance = c.m_vertex->GetDistanceFromRoot ();
+  c.m_network = c.m_vertex->GetVertexType () == SPFVertex::VertexNetwork;
+  c.m_sequence = m_sequence++;
+}
+
+void
+CandidateQueue::Place (uint32_t position, const Candidate &c)
+{
+  m_candidates[position] = c;
+  m_positions[c.m_vertex] = position;
+}
+
+void
+CandidateQueue::SiftUp (uint32_t position)
+{
+  Candidate c = m_candidates[position];
+  while (position > 0)
+    {
+      uint32_t parent = (position - 1) / 2;
+      if (!CompareCandidate (c, m_candidates[parent]))
+        {
+          break;
+        }
+      Place (position, m_candidates[parent]);
+      position = parent;
+    }
+  Place (position, c);
+}
+
+void
+CandidateQueue::SiftDown (uint32_t position)
+{
+  Candidate c = m_candidates[position];
+  uint32_t size = m_candidates.size ();
+  while (true)
+    {
+      uint32_t child = 2 * position + 1;
+      if (child >= size)
+        {
+          break;
+        }
+      if (child + 1 < size && CompareCandidate (m_candidates[child + 1], m_candidates[child]))
+        {
+          child++;
+        }
+      if (!CompareCandidate (m_candidates[child], c))
+        {
+          break;
+        }
+      Place (position, m_candidates[child]);
+      position = child;
+    }
+  Place (position, c);
+}
+
 /*
  * In this implementation, SPFVertex follows the ordering where
  * a vertex is ranked first if its GetDistanceFromRoot () is smaller;
@@ -197,4 +316,24 @@ CandidateQueue::CompareSPFVertex (const SPFVertex* v1, const SPFVertex* v2)
   return result;
 }
 
+bool
+CandidateQueue::CompareCandidateVertex (const Candidate &c1, const Candidate &c2)
+{
+  return CompareSPFVertex (c1.m_vertex, c2.m_vertex);
+}
+
+bool
+CandidateQueue::CompareCandidate (const Candidate &c1, const Candidate &c2)
+{
+  if (c1.m_distance != c2.m_distance)
+    {
+      return c1.m_distance < c2.m_distance;
+    }
+  if (c1.m_network != c2.m_network)
+    {
+      return c1.m_network;
+    }
+  return c1.m_sequence < c2.m_sequence;
+}
+
 } // namespace ns3
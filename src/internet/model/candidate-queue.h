@@ -22,7 +22,8 @@
 #define CANDIDATE_QUEUE_H
 
 #include <stdint.h>
-#include <list>
+#include <vector>
+#include <unordered_map>
 #include "ns3/ipv4-address.h"
 
 namespace ns3 {
@@ -47,6 +48,11 @@ class SPFVertex;
  * for a Find () operation, the dynamic nature of the data and the derived
  * requirement for a Reorder () operation led us to implement this simple 
  * enhanced priority queue.
+ *
+ * The vertices are kept in a binary heap, so that Push (), Pop () and
+ * Update () take a logarithmic time, and indexed by vertex ID for Find ().
+ * Vertices which compare equal are popped in the order they were pushed
+ * (or last updated), as they were when the queue was a sorted list.
  */
 class CandidateQueue
 {
@@ -139,6 +145,19 @@ public:
  */
   SPFVertex* Find (const Ipv4Address addr) const;
 
+/**
+ * @brief Move a Shortest Path First Vertex pointer to its place after its
+ * m_distanceFromRoot has been lowered.
+ *
+ * The vertex is then popped after the queued vertices at the same
+ * distance, as if it had been pushed again.  This is the equivalent of
+ * Reorder () for a single vertex, in logarithmic rather than linear time.
+ *
+ * @see SPFVertex
+ * @param v The Shortest Path First Vertex, which must be in the queue.
+ */
+  void Update (SPFVertex *v);
+
 /**
  * @brief Reorders the Candidate Queue according to the priority scheme.
  * 
@@ -184,8 +203,70 @@ private:
  */
   static bool CompareSPFVertex (const SPFVertex* v1, const SPFVertex* v2);
 
-  typedef std::list<SPFVertex*> CandidateList_t; //!< container of SPFVertex pointers
-  CandidateList_t m_candidates;  //!< SPFVertex candidates
+  /// A vertex in the heap, with its rank when it was pushed or updated
+  struct Candidate
+  {
+    SPFVertex *m_vertex;   //!< The vertex
+    uint32_t m_distance;   //!< Distance from the root
+    bool m_network;        //!< True for a network vertex
+    uint32_t m_sequence;   //!< Order of the push, among equal candidates
+  };
+
+/**
+ * \param c1 first operand
+ * \param c2 second operand
+ * \return True if c1 should be popped before c2
+ */
+  static bool CompareCandidate (const Candidate &c1, const Candidate &c2);
+
+/**
+ * \param c1 first operand
+ * \param c2 second operand
+ * \return True if the vertex of c1 should be popped before the one of c2,
+ * according to their current distance
+ */
+  static bool CompareCandidateVertex (const Candidate &c1, const Candidate &c2);
+
+/**
+ * \brief Set the rank of a candidate from its vertex.
+ * \param c the candidate
+ */
+  void Rank (Candidate &c);
+
+/**
+ * \brief Store a candidate at a heap position.
+ * \param position the position
+ * \param c the candidate
+ */
+  void Place (uint32_t position, const Candidate &c);
+
+/**
+ * \brief Move a candidate towards the top until the heap is ordered.
+ * \param position the position of the candidate
+ */
+  void SiftUp (uint32_t position);
+
+/**
+ * \brief Move a candidate towards the bottom until the heap is ordered.
+ * \param position the position of the candidate
+ */
+  void SiftDown (uint32_t position);
+
+/**
+ * \return the candidates sorted according to the current distance of their
+ * vertex, those which compare equal in the order they were queued
+ */
+  std::vector<Candidate> GetSorted (void) const;
+
+  typedef std::vector<Candidate> CandidateHeap_t; //!< binary heap of candidates
+  CandidateHeap_t m_candidates;  //!< SPFVertex candidates
+  /// container of the heap positions, by vertex
+  typedef std::unordered_map<const SPFVertex*, uint32_t> PositionMap_t;
+  PositionMap_t m_positions;     //!< Heap position of each vertex
+  /// container of the vertices, by vertex ID
+  typedef std::unordered_multimap<Ipv4Address, SPFVertex*, Ipv4AddressHash> IdMap_t;
+  IdMap_t m_ids;                 //!< Vertices by ID, for Find ()
+  uint32_t m_sequence;           //!< Sequence number of the next push
 
   /**
    * \brief Stream insertion operator.
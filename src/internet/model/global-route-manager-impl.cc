@@ -26,6 +26,7 @@
 #include <vector>
 #include <queue>
 #include <algorithm>
+#include <iterator>
 #include <iostream>
 #include "ns3/assert.h"
 #include "ns3/fatal-error.h"
@@ -35,6 +36,14 @@
 #include "ns3/ipv4-routing-protocol.h"
 #include "ns3/ipv4-list-routing.h"
 #include "ns3/mpi-interface.h"
+#include "ns3/system-wall-clock-ms.h"
+#include "ns3/global-value.h"
+#include "ns3/uinteger.h"
+#include "ns3/core-config.h"
+#ifdef HAVE_PTHREAD_H
+#include "ns3/system-thread.h"
+#include "ns3/system-mutex.h"
+#endif /* HAVE_PTHREAD_H */
 #include "global-router-interface.h"
 #include "global-route-manager-impl.h"
 #include "candidate-queue.h"
@@ -44,6 +53,18 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("GlobalRouteManagerImpl");
 
+/**
+ * \brief The number of threads calculating the global routes.
+ *
+ * The SPF calculation of each router only reads the LSDB, so the routes of
+ * several routers can be calculated at the same time.  They are added to the
+ * routing tables afterwards, in the same order as with a single thread.
+ */
+static GlobalValue g_globalRoutingThreads = GlobalValue ("GlobalRoutingThreads",
+                                                         "The number of threads calculating the global routes of the routers",
+                                                         UintegerValue (1),
+                                                         MakeUintegerChecker<uint32_t> (1));
+
 /**
  * \brief Stream insertion operator.
  *
@@ -423,7 +444,9 @@ SPFVertex::ClearVertexProcessed (void)
 GlobalRouteManagerLSDB::GlobalRouteManagerLSDB ()
   :
     m_database (),
-    m_extdatabase ()
+    m_extdatabase (),
+    m_linkDataIndex (),
+    m_linkDataIndexValid (false)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -471,6 +494,106 @@ GlobalRouteManagerLSDB::Insert (Ipv4Address addr, GlobalRoutingLSA* lsa)
   else
     {
       m_database.insert (LSDBPair_t (addr, lsa));
+      m_linkDataIndexValid = false;
+    }
+}
+
+GlobalRouteManagerLSDB*
+GlobalRouteManagerLSDB::Copy () const
+{
+  NS_LOG_FUNCTION (this);
+  GlobalRouteManagerLSDB* lsdb = new GlobalRouteManagerLSDB ();
+  LSDBMap_t::const_iterator i;
+  for (i= m_database.begin (); i!= m_database.end (); i++)
+    {
+      lsdb->Insert (i->first, new GlobalRoutingLSA (*i->second));
+    }
+  for (uint32_t j = 0; j < m_extdatabase.size (); j++)
+    {
+      GlobalRoutingLSA* temp = m_extdatabase.at (j);
+      lsdb->Insert (temp->GetLinkStateId (), new GlobalRoutingLSA (*temp));
+    }
+  return lsdb;
+}
+
+/**
+ * \brief Compare the content of two LSAs, as used by the SPF calculation
+ * \param a an LSA
+ * \param b another LSA
+ * \returns true if they describe the same vertex and links
+ */
+static bool
+IsSameLSA (const GlobalRoutingLSA* a, const GlobalRoutingLSA* b)
+{
+  if (a->GetLSType () != b->GetLSType ()
+      || a->GetLinkStateId () != b->GetLinkStateId ()
+      || a->GetAdvertisingRouter () != b->GetAdvertisingRouter ()
+      || a->GetNetworkLSANetworkMask () != b->GetNetworkLSANetworkMask ()
+      || a->GetNAttachedRouters () != b->GetNAttachedRouters ()
+      || a->GetNLinkRecords () != b->GetNLinkRecords ())
+    {
+      return false;
+    }
+  for (uint32_t i = 0; i < a->GetNAttachedRouters (); i++)
+    {
+      if (a->GetAttachedRouter (i) != b->GetAttachedRouter (i))
+        {
+          return false;
+        }
+    }
+  for (uint32_t i = 0; i < a->GetNLinkRecords (); i++)
+    {
+      GlobalRoutingLinkRecord *la = a->GetLinkRecord (i);
+      GlobalRoutingLinkRecord *lb = b->GetLinkRecord (i);
+      if (la->GetLinkType () != lb->GetLinkType ()
+          || la->GetLinkId () != lb->GetLinkId ()
+          || la->GetLinkData () != lb->GetLinkData ()
+          || la->GetMetric () != lb->GetMetric ())
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+void
+GlobalRouteManagerLSDB::GetChangedLSAs (const GlobalRouteManagerLSDB& other,
+                                        std::vector<Ipv4Address>& changed) const
+{
+  NS_LOG_FUNCTION (this << &other);
+  LSDBMap_t::const_iterator i = m_database.begin ();
+  LSDBMap_t::const_iterator j = other.m_database.begin ();
+  while (i != m_database.end () || j != other.m_database.end ())
+    {
+      if (j == other.m_database.end () || (i != m_database.end () && i->first < j->first))
+        {
+          changed.push_back (i->first);
+          i++;
+        }
+      else if (i == m_database.end () || j->first < i->first)
+        {
+          changed.push_back (j->first);
+          j++;
+        }
+      else
+        {
+          if (!IsSameLSA (i->second, j->second))
+            {
+              changed.push_back (i->first);
+            }
+          i++;
+          j++;
+        }
+    }
+}
+
+void
+GlobalRouteManagerLSDB::GetLSAs (std::vector<GlobalRoutingLSA*>& lsas) const
+{
+  NS_LOG_FUNCTION (this);
+  for (LSDBMap_t::const_iterator i = m_database.begin (); i != m_database.end (); i++)
+    {
+      lsas.push_back (i->second);
     }
 }
 
@@ -495,13 +618,10 @@ GlobalRouteManagerLSDB::GetLSA (Ipv4Address addr) const
 //
 // Look up an LSA by its address.
 //
-  LSDBMap_t::const_iterator i;
-  for (i= m_database.begin (); i!= m_database.end (); i++)
+  LSDBMap_t::const_iterator i = m_database.find (addr);
+  if (i != m_database.end ())
     {
-      if (i->first == addr)
-        {
-          return i->second;
-        }
+      return i->second;
     }
   return 0;
 }
@@ -511,22 +631,33 @@ GlobalRouteManagerLSDB::GetLSAByLinkData (Ipv4Address addr) const
 {
   NS_LOG_FUNCTION (this << addr);
 //
-// Look up an LSA by its address.
+// Look up an LSA by its address.  The first LSA, in the order of the
+// database, with a matching transit network link record is the one found;
+// the index is rebuilt the first time it is used after an insertion.
 //
-  LSDBMap_t::const_iterator i;
-  for (i= m_database.begin (); i!= m_database.end (); i++)
+  if (!m_linkDataIndexValid)
     {
-      GlobalRoutingLSA* temp = i->second;
-// Iterate among temp's Link Records
-      for (uint32_t j = 0; j < temp->GetNLinkRecords (); j++)
+      m_linkDataIndex.clear ();
+      LSDBMap_t::const_iterator i;
+      for (i= m_database.begin (); i!= m_database.end (); i++)
         {
-          GlobalRoutingLinkRecord *lr = temp->GetLinkRecord (j);
-          if ( lr->GetLinkType () == GlobalRoutingLinkRecord::TransitNetwork &&
-               lr->GetLinkData () == addr)
+          GlobalRoutingLSA* temp = i->second;
+// Iterate among temp's Link Records
+          for (uint32_t j = 0; j < temp->GetNLinkRecords (); j++)
             {
-              return temp;
+              GlobalRoutingLinkRecord *lr = temp->GetLinkRecord (j);
+              if ( lr->GetLinkType () == GlobalRoutingLinkRecord::TransitNetwork)
+                {
+                  m_linkDataIndex.insert (LSDBPair_t (lr->GetLinkData (), temp));
+                }
             }
         }
+      m_linkDataIndexValid = true;
+    }
+  LSDBMap_t::const_iterator i = m_linkDataIndex.find (addr);
+  if (i != m_linkDataIndex.end ())
+    {
+      return i->second;
     }
   return 0;
 }
@@ -539,7 +670,13 @@ GlobalRouteManagerLSDB::GetLSAByLinkData (Ipv4Address addr) const
 
 GlobalRouteManagerImpl::GlobalRouteManagerImpl () 
   :
-    m_spfroot (0)
+    m_spfroot (0),
+    m_spfrootNode (0),
+    m_spfrootRouting (0),
+    m_spfRoutes (0),
+    m_spfTree (0),
+    m_spfReuse (0),
+    m_jobs (0)
 {
   NS_LOG_FUNCTION (this);
   m_lsdb = new GlobalRouteManagerLSDB ();
@@ -563,6 +700,7 @@ GlobalRouteManagerImpl::DebugUseLsdb (GlobalRouteManagerLSDB* lsdb)
       delete m_lsdb;
     }
   m_lsdb = lsdb;
+  m_spfTrees.clear ();
 }
 
 void
@@ -574,10 +712,7 @@ GlobalRouteManagerImpl::DeleteGlobalRoutes ()
     {
       Ptr<Node> node = *i;
       Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-      if (router == 0)
-        {
-          continue;
-        }
+      NS_ASSERT (router);
       Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
       uint32_t j = 0;
       uint32_t nRoutes = gr->GetNRoutes ();
@@ -598,6 +733,7 @@ GlobalRouteManagerImpl::DeleteGlobalRoutes ()
       delete m_lsdb;
       m_lsdb = new GlobalRouteManagerLSDB ();
     }
+  m_spfTrees.clear ();
 }
 
 //
@@ -613,6 +749,9 @@ void
 GlobalRouteManagerImpl::BuildGlobalRoutingDatabase () 
 {
   NS_LOG_FUNCTION (this);
+  SystemWallClockMs clock;
+  clock.Start ();
+  uint32_t nLSAs = 0;
 //
 // Walk the list of nodes looking for the GlobalRouter Interface.  Nodes with
 // global router interfaces are, not too surprisingly, our routers.
@@ -656,7 +795,10 @@ GlobalRouteManagerImpl::BuildGlobalRoutingDatabase ()
 //
           m_lsdb->Insert (lsa->GetLinkStateId (), lsa); 
         }
+      nLSAs += numLSAs;
     }
+  int64_t elapsed = clock.End ();
+  NS_LOG_INFO ("Gathered " << nLSAs << " LSAs in " << elapsed << " ms");
 }
 
 //
@@ -700,6 +842,10 @@ GlobalRouteManagerImpl::InitializeRoutes ()
 // Walk the list of nodes in the system.
 //
   NS_LOG_INFO ("About to start SPF calculation");
+  SystemWallClockMs clock;
+  clock.Start ();
+  uint32_t systemId = MpiInterface::GetSystemId ();
+  std::vector<Ptr<Node> > roots;
   NodeList::Iterator listEnd = NodeList::End ();
   for (NodeList::Iterator i = NodeList::Begin (); i != listEnd; i++)
     {
@@ -711,7 +857,6 @@ GlobalRouteManagerImpl::InitializeRoutes ()
       Ptr<GlobalRouter> rtr = 
         node->GetObject<GlobalRouter> ();
 
-      uint32_t systemId = MpiInterface::GetSystemId ();
       // Ignore nodes that are not assigned to our systemId (distributed sim)
       if (node->GetSystemId () != systemId) 
         {
@@ -724,10 +869,155 @@ GlobalRouteManagerImpl::InitializeRoutes ()
 //
       if (rtr && rtr->GetNumLSAs () )
         {
-          SPFCalculate (rtr->GetRouterId ());
+          roots.push_back (node);
+        }
+    }
+
+//
+// The shortest path trees are kept, so that UpdateRoutes () only calculates
+// again those which a change of the topology may change.
+//
+  uint32_t nThreads = GetNThreads (roots.size ());
+  std::vector<SPFTree> trees (roots.size ());
+  if (nThreads > 1)
+    {
+      std::vector<SPFRoutes_t> routes (roots.size ());
+      ParallelSPFCalculate (roots, routes, trees, std::vector<SPFMode> (roots.size (), SPF_CALCULATE),
+                            SPFChanges (), nThreads);
+      for (uint32_t i = 0; i < roots.size (); i++)
+        {
+          InstallRoutes (roots[i], routes[i]);
+        }
+    }
+  else
+    {
+      for (uint32_t i = 0; i < roots.size (); i++)
+        {
+          SPFRun (roots[i], trees[i], SPF_CALCULATE, SPFChanges ());
+        }
+    }
+  m_spfTrees.clear ();
+  for (uint32_t i = 0; i < roots.size (); i++)
+    {
+      std::swap (m_spfTrees[roots[i]->GetObject<GlobalRouter> ()->GetRouterId ()], trees[i]);
+    }
+  int64_t elapsed = clock.End ();
+  NS_LOG_INFO ("Finished SPF calculation for " << roots.size () << " routers with "
+               << nThreads << " threads in " << elapsed << " ms");
+}
+
+//
+// Recomputing the routes after a change of the topology amounts to deleting
+// them, gathering the LSAs again and running the SPF calculation from every
+// router.  Rather than emptying the routing tables first, each one is
+// updated in place: the routes are matched as they are found with those
+// already in the table (see Ipv4GlobalRouting::AddRoute), and only the
+// routes which changed are removed or added.  A single link going up or
+// down usually leaves most routes of most tables unchanged, which saves
+// allocating and indexing them again.
+//
+// The first stage of the SPF calculation, the Dijkstra algorithm, is only
+// run again for the routers whose shortest path tree may have changed: the
+// new LSDB is compared with the old one, and the edges which were removed or
+// added are checked against the trees kept from the last calculation (see
+// GetSPFMode ()).  The routers whose tree did not change replay it with the
+// new LSAs, which finds the same routes as the calculation would, in the
+// same order, without exploring the links and ordering the candidates
+// again.  When links only went down or got costlier, the routers whose tree
+// they are on repair it: only the vertices below these links are explored
+// again (see SPFRepair ()).  The routes still have to be found again, since
+// those to the networks and addresses of the routers which changed are in
+// every table.
+//
+void
+GlobalRouteManagerImpl::UpdateRoutes ()
+{
+  NS_LOG_FUNCTION (this);
+  SystemWallClockMs clock;
+  clock.Start ();
+  GlobalRouteManagerLSDB* oldLsdb = m_lsdb;
+  m_lsdb = new GlobalRouteManagerLSDB ();
+  BuildGlobalRoutingDatabase ();
+  SPFChanges changes;
+  GetSPFChanges (oldLsdb, changes);
+  delete oldLsdb;
+
+  uint32_t systemId = MpiInterface::GetSystemId ();
+  std::vector<Ptr<Node> > routers;
+  std::vector<Ptr<Node> > roots;
+  NodeList::Iterator listEnd = NodeList::End ();
+  for (NodeList::Iterator i = NodeList::Begin (); i != listEnd; i++)
+    {
+      Ptr<Node> node = *i;
+      Ptr<GlobalRouter> rtr = node->GetObject<GlobalRouter> ();
+      if (rtr == 0)
+        {
+          continue;
+        }
+      routers.push_back (node);
+      if (node->GetSystemId () == systemId && rtr->GetNumLSAs ())
+        {
+          roots.push_back (node);
+        }
+    }
+
+  std::vector<SPFTree> trees (roots.size ());
+  std::vector<SPFMode> modes (roots.size (), SPF_CALCULATE);
+  uint32_t nModes[SPF_REPAIR + 1] = { 0, 0, 0 };
+  for (uint32_t i = 0; i < roots.size (); i++)
+    {
+      SPFTrees_t::iterator tree = m_spfTrees.find (roots[i]->GetObject<GlobalRouter> ()->GetRouterId ());
+      if (tree != m_spfTrees.end ())
+        {
+          std::swap (trees[i], tree->second);
+          modes[i] = GetSPFMode (trees[i], changes);
+        }
+      nModes[modes[i]]++;
+    }
+  m_spfTrees.clear ();
+  if (nModes[SPF_REPAIR] > 0)
+    {
+      GetSPFPredecessors (changes);
+    }
+
+  uint32_t nThreads = GetNThreads (roots.size ());
+  std::vector<SPFRoutes_t> routes;
+  if (nThreads > 1)
+    {
+      routes.resize (roots.size ());
+      ParallelSPFCalculate (roots, routes, trees, modes, changes, nThreads);
+    }
+
+  uint32_t nRoots = 0;
+  for (uint32_t i = 0; i < routers.size (); i++)
+    {
+      Ptr<Node> node = routers[i];
+      Ptr<GlobalRouter> rtr = node->GetObject<GlobalRouter> ();
+      Ptr<Ipv4GlobalRouting> gr = rtr->GetRoutingProtocol ();
+      gr->BeginRouteUpdate ();
+//
+// The routers which InitializeRoutes () would skip have their routes removed,
+// as DeleteGlobalRoutes () would.
+//
+      if (nRoots < roots.size () && roots[nRoots] == node)
+        {
+          if (nThreads > 1)
+            {
+              InstallRoutes (node, routes[nRoots]);
+            }
+          else
+            {
+              SPFRun (node, trees[nRoots], modes[nRoots], changes);
+            }
+          std::swap (m_spfTrees[rtr->GetRouterId ()], trees[nRoots]);
+          nRoots++;
         }
+      gr->EndRouteUpdate ();
     }
-  NS_LOG_INFO ("Finished SPF calculation");
+  int64_t elapsed = clock.End ();
+  NS_LOG_INFO ("Updated the routes of " << nRoots << " routers, replaying the shortest path tree of "
+               << nModes[SPF_REPLAY] << " and repairing that of " << nModes[SPF_REPAIR]
+               << ", with " << nThreads << " threads in " << elapsed << " ms");
 }
 
 //
@@ -830,6 +1120,22 @@ GlobalRouteManagerImpl::SPFNext (SPFVertex* v, CandidateQueue& candidate)
 
 // Note:  w_lsa at this point may be either RouterLSA or NetworkLSA
 //
+// When the tree is repaired, a vertex whose paths did not change is only
+// pushed through the link of its first parent (see SPFRepair ()).
+//
+      if (m_spfReuse != 0)
+        {
+          uint32_t reusedDistance = v->GetDistanceFromRoot ();
+          if (v->GetVertexType () == SPFVertex::VertexRouter)
+            {
+              reusedDistance += l->GetMetric ();
+            }
+          if (SPFNextToReused (v, w_lsa, reusedDistance, candidate))
+            {
+              continue;
+            }
+        }
+//
 // (c) If vertex W is already on the shortest-path tree, examine the next
 // link in the LSA.
 //
@@ -960,7 +1266,7 @@ GlobalRouteManagerImpl::SPFNext (SPFVertex* v, CandidateQueue& candidate)
 // If we've changed the cost to get to the vertex represented by <w>, we 
 // must reorder the priority queue keyed to that cost.
 //
-                  candidate.Reorder ();
+                  candidate.Update (cw);
                 }
             } // new lower cost path found
         } // end W is already on the candidate list
@@ -1320,12 +1626,8 @@ GlobalRouteManagerImpl::CheckForStubNode (Ipv4Address root)
               if (lr->GetLinkId () == myRouterId)
                 {
                   // Next hop is stored in the LinkID field of lr
-                  Ptr<GlobalRouter> router = rlsa->GetNode ()->GetObject<GlobalRouter> ();
-                  NS_ASSERT (router);
-                  Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-                  NS_ASSERT (gr);
-                  gr->AddNetworkRouteTo (Ipv4Address ("0.0.0.0"), Ipv4Mask ("0.0.0.0"), lr->GetLinkData (), 
-                                         FindOutgoingInterfaceId (transitLink->GetLinkData ()));
+                  AddRoute (SPFRoute::NETWORK, Ipv4Address ("0.0.0.0"), Ipv4Mask ("0.0.0.0"), lr->GetLinkData (),
+                            FindOutgoingInterfaceId (transitLink->GetLinkData ()));
                   NS_LOG_LOGIC ("Inserting default route for node " << myRouterId << " to next hop " << 
                                 lr->GetLinkData () << " via interface " << 
                                 FindOutgoingInterfaceId (transitLink->GetLinkData ()));
@@ -1337,11 +1639,18 @@ GlobalRouteManagerImpl::CheckForStubNode (Ipv4Address root)
   return false;
 }
 
-// quagga ospf_spf_calculate
 void
 GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
 {
   NS_LOG_FUNCTION (this << root);
+  SPFCalculate (root, FindRouterNode (root));
+}
+
+// quagga ospf_spf_calculate
+void
+GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root, Ptr<Node> node)
+{
+  NS_LOG_FUNCTION (this << root << node);
 
   SPFVertex *v;
 //
@@ -1368,7 +1677,25 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
   m_spfroot= v;
   v->SetDistanceFromRoot (0);
   v->GetLSA ()->SetStatus (GlobalRoutingLSA::LSA_SPF_IN_SPFTREE);
+  if (m_spfReuse != 0)
+    {
+      m_spfReuse->m_vertices[0] = v;
+    }
   NS_LOG_LOGIC ("Starting SPFCalculate for node " << root);
+  SetSPFRootNode (node);
+//
+// The tree found by the first stage is recorded if m_spfTree is set, so that
+// it can be replayed later (see SPFReplay ()).  A truncated calculation
+// leaves it empty.
+//
+  std::unordered_map<const SPFVertex*, uint32_t> indexes;
+  if (m_spfTree != 0)
+    {
+      m_spfTree->m_vertices.clear ();
+      m_spfTree->m_parents.clear ();
+      m_spfTree->m_exits.clear ();
+      m_spfTree->m_byId.clear ();
+    }
 
 //
 // Optimize SPF calculation, for ns-3.
@@ -1377,12 +1704,18 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
 // reached.  Instead, short-circuit this computation and just install
 // a default route in the CheckForStubNode() method.
 //
-  if (NodeList::GetNNodes () > 0 && CheckForStubNode (root))
+  if (m_spfrootNode != 0 && CheckForStubNode (root))
     {
       NS_LOG_LOGIC ("SPFCalculate truncated for stub node " << root);
       delete m_spfroot;
+      m_spfroot = 0;
+      SetSPFRootNode (0);
       return;
     }
+  if (m_spfTree != 0)
+    {
+      RecordSPFVertex (v, indexes);
+    }
 
   for (;;)
     {
@@ -1400,7 +1733,13 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
 // shortest path).  If the new vertices represent shorter paths, we use them
 // and update the path cost.
 //
-      SPFNext (v, candidate);
+// When the tree is repaired, the vertices which keep their paths are pushed
+// without exploring the links (see SPFRepair ()).
+//
+      if (m_spfReuse == 0 || !SPFNextReused (v, candidate))
+        {
+          SPFNext (v, candidate);
+        }
 //
 // RFC2328 16.1. (3). 
 //
@@ -1429,6 +1768,19 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
 // tree.
 //
       v->GetLSA ()->SetStatus (GlobalRoutingLSA::LSA_SPF_IN_SPFTREE);
+      if (m_spfReuse != 0)
+        {
+          const SPFTree* tree = m_spfReuse->m_tree;
+          uint32_t i = tree->GetIndex (v->GetVertexId ());
+          if (i < tree->m_vertices.size () && !m_spfReuse->m_affected[i])
+            {
+              RestoreSPFVertex (v, *tree, i, m_spfReuse->m_vertices);
+            }
+        }
+      if (m_spfTree != 0)
+        {
+          RecordSPFVertex (v, indexes);
+        }
 //
 // The current vertex has a parent pointer.  By calling this rather oddly 
 // named method (blame quagga) we add the current vertex to the list of 
@@ -1485,7 +1837,37 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
 
     }  // end for loop
 
-// Second stage of SPF calculation procedure
+  if (m_spfTree != 0)
+    {
+      m_spfTree->IndexVertices ();
+    }
+  SPFSecondStage ();
+}
+
+void
+GlobalRouteManagerImpl::SetSPFRootNode (Ptr<Node> node)
+{
+  NS_LOG_FUNCTION (this << node);
+//
+// The routes found are all written to the node of the root vertex, through
+// its Ipv4 interface.  Only this node is used: the calculation may run in a
+// worker thread, alongside those of other routers.
+//
+  m_spfrootNode = node;
+  m_spfrootRouting = 0;
+  if (node != 0)
+    {
+      Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
+      NS_ASSERT (router);
+      m_spfrootRouting = router->GetRoutingProtocol ();
+      NS_ASSERT (m_spfrootRouting);
+    }
+}
+
+void
+GlobalRouteManagerImpl::SPFSecondStage (void)
+{
+  NS_LOG_FUNCTION (this);
   SPFProcessStubs (m_spfroot);
   for (uint32_t i = 0; i < m_lsdb->GetNumExtLSAs (); i++)
     {
@@ -1502,118 +1884,860 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
 //
   delete m_spfroot;
   m_spfroot = 0;
+  SetSPFRootNode (0);
 }
 
 void
-GlobalRouteManagerImpl::ProcessASExternals (SPFVertex* v, GlobalRoutingLSA* extlsa)
+GlobalRouteManagerImpl::RecordSPFVertex (SPFVertex* v,
+                                         std::unordered_map<const SPFVertex*, uint32_t> &indexes)
 {
-  NS_LOG_FUNCTION (this << v << extlsa);
-  NS_LOG_LOGIC ("Processing external for destination " << 
-                extlsa->GetLinkStateId () <<
-                ", for router "  << v->GetVertexId () <<
-                ", advertised by " << extlsa->GetAdvertisingRouter ());
-  if (v->GetVertexType () == SPFVertex::VertexRouter)
+  NS_LOG_FUNCTION (this << v);
+  NS_ASSERT (m_spfTree);
+  SPFTree::Vertex vertex;
+  vertex.m_link = 0;
+  uint32_t first = m_spfTree->m_vertices.size ();
+  for (uint32_t i = 0; v->GetParent (i) != 0; i++)
     {
-      GlobalRoutingLSA *rlsa = v->GetLSA ();
-      NS_LOG_LOGIC ("Processing router LSA with id " << rlsa->GetLinkStateId ());
-      if ((rlsa->GetLinkStateId ()) == (extlsa->GetAdvertisingRouter ()))
+      std::unordered_map<const SPFVertex*, uint32_t>::const_iterator parent = indexes.find (v->GetParent (i));
+      NS_ASSERT (parent != indexes.end ());
+      m_spfTree->m_parents.push_back (parent->second);
+      if (parent->second < first)
         {
-          NS_LOG_LOGIC ("Found advertising router to destination");
-          SPFAddASExternal (extlsa,v);
+          first = parent->second;
+          vertex.m_link = GetSPFLink (v->GetParent (i), v);
         }
     }
-  for (uint32_t i = 0; i < v->GetNChildren (); i++)
+  for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
     {
-      if (!v->GetChild (i)->IsVertexProcessed ())
-        {
-          NS_LOG_LOGIC ("Vertex's child " << i << " not yet processed, processing...");
-          ProcessASExternals (v->GetChild (i), extlsa);
-          v->GetChild (i)->SetVertexProcessed (true);
-        }
+      m_spfTree->m_exits.push_back (v->GetRootExitDirection (i));
     }
+  vertex.m_id = v->GetVertexId ();
+  vertex.m_distance = v->GetDistanceFromRoot ();
+  vertex.m_parentsEnd = m_spfTree->m_parents.size ();
+  vertex.m_exitsEnd = m_spfTree->m_exits.size ();
+  indexes[v] = m_spfTree->m_vertices.size ();
+  m_spfTree->m_vertices.push_back (vertex);
 }
 
-//
-// Adding external routes to routing table - modeled after
-// SPFAddIntraAddStub()
-//
-
-void
-GlobalRouteManagerImpl::SPFAddASExternal (GlobalRoutingLSA *extlsa, SPFVertex *v)
+Ptr<Node>
+GlobalRouteManagerImpl::FindRouterNode (Ipv4Address routerId) const
 {
-  NS_LOG_FUNCTION (this << extlsa << v);
-
-  NS_ASSERT_MSG (m_spfroot, "GlobalRouteManagerImpl::SPFAddASExternal (): Root pointer not set");
-// Two cases to consider: We are advertising the external ourselves
-// => No need to add anything
-// OR find best path to the advertising router
-  if (v->GetVertexId () == m_spfroot->GetVertexId ())
-    {
-      NS_LOG_LOGIC ("External is on local host: " 
-                    << v->GetVertexId () << "; returning");
-      return;
-    }
-  NS_LOG_LOGIC ("External is on remote host: " 
-                << extlsa->GetAdvertisingRouter () << "; installing");
-
-  Ipv4Address routerId = m_spfroot->GetVertexId ();
-
-  NS_LOG_LOGIC ("Vertex ID = " << routerId);
+  NS_LOG_FUNCTION (this << routerId);
 //
 // We need to walk the list of nodes looking for the one that has the router
-// ID corresponding to the root vertex.  This is the one we're going to write
-// the routing information to.
+// ID we are given.  The router ID is accessible through the GlobalRouter
+// interface; if there's no GlobalRouter interface, the node in question
+// cannot be the router we want.
 //
-  NodeList::Iterator i = NodeList::Begin (); 
   NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
+  for (NodeList::Iterator i = NodeList::Begin (); i != listEnd; i++)
     {
       Ptr<Node> node = *i;
-//
-// The router ID is accessible through the GlobalRouter interface, so we need
-// to QI for that interface.  If there's no GlobalRouter interface, the node
-// in question cannot be the router we want, so we continue.
-// 
       Ptr<GlobalRouter> rtr = node->GetObject<GlobalRouter> ();
-
-      if (rtr == 0)
+      if (rtr != 0 && rtr->GetRouterId () == routerId)
         {
-          NS_LOG_LOGIC ("No GlobalRouter interface on node " << node->GetId ());
-          continue;
+          return node;
         }
-//
-// If the router ID of the current node is equal to the router ID of the 
-// root of the SPF tree, then this node is the one for which we need to 
-// write the routing tables.
-//
-      NS_LOG_LOGIC ("Considering router " << rtr->GetRouterId ());
+    }
+  NS_LOG_LOGIC ("No node with router ID " << routerId);
+  return 0;
+}
 
-      if (rtr->GetRouterId () == routerId)
+uint32_t
+GlobalRouteManagerImpl::SPFTree::GetIndex (Ipv4Address id) const
+{
+  uint32_t begin = 0;
+  uint32_t end = m_byId.size ();
+  while (begin < end)
+    {
+      uint32_t middle = begin + (end - begin) / 2;
+      const Vertex &vertex = m_vertices[m_byId[middle]];
+      if (vertex.m_id == id)
         {
-          NS_LOG_LOGIC ("Setting routes for node " << node->GetId ());
-//
-// Routing information is updated using the Ipv4 interface.  We need to QI
-// for that interface.  If the node is acting as an IP version 4 router, it
-// should absolutely have an Ipv4 interface.
-//
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "QI for <Ipv4> interface failed");
-//
-// Get the Global Router Link State Advertisement from the vertex we're
-// adding the routes to.  The LSA will have a number of attached Global Router
-// Link Records corresponding to links off of that vertex / node.  We're going
-// to be interested in the records corresponding to point-to-point links.
-//
-          NS_ASSERT_MSG (v->GetLSA (), 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "Expected valid LSA in SPFVertex* v");
-          Ipv4Mask tempmask = extlsa->GetNetworkLSANetworkMask ();
-          Ipv4Address tempip = extlsa->GetLinkStateId ();
-          tempip = tempip.CombineMask (tempmask);
+          return m_byId[middle];
+        }
+      if (vertex.m_id < id)
+        {
+          begin = middle + 1;
+        }
+      else
+        {
+          end = middle;
+        }
+    }
+  return m_vertices.size ();
+}
 
-//
+uint32_t
+GlobalRouteManagerImpl::SPFTree::GetDistance (Ipv4Address id) const
+{
+  uint32_t i = GetIndex (id);
+  return i < m_vertices.size () ? m_vertices[i].m_distance : SPF_INFINITY;
+}
+
+uint32_t
+GlobalRouteManagerImpl::SPFTree::GetFirstParent (uint32_t i) const
+{
+  uint32_t first = m_vertices.size ();
+  for (uint32_t j = i > 0 ? m_vertices[i - 1].m_parentsEnd : 0; j < m_vertices[i].m_parentsEnd; j++)
+    {
+      first = std::min (first, m_parents[j]);
+    }
+  return first;
+}
+
+void
+GlobalRouteManagerImpl::SPFTree::IndexVertices (void)
+{
+  std::vector<std::pair<Ipv4Address, uint32_t> > ids;
+  ids.reserve (m_vertices.size ());
+  for (uint32_t i = 0; i < m_vertices.size (); i++)
+    {
+      ids.push_back (std::make_pair (m_vertices[i].m_id, i));
+    }
+  std::sort (ids.begin (), ids.end ());
+  m_byId.resize (ids.size ());
+  for (uint32_t i = 0; i < ids.size (); i++)
+    {
+      m_byId[i] = ids[i].second;
+    }
+}
+
+bool
+GlobalRouteManagerImpl::SPFEdge::operator< (const SPFEdge& other) const
+{
+  if (m_from != other.m_from)
+    {
+      return m_from < other.m_from;
+    }
+  if (m_to != other.m_to)
+    {
+      return m_to < other.m_to;
+    }
+  return m_metric < other.m_metric;
+}
+
+void
+GlobalRouteManagerImpl::SPFRun (Ptr<Node> node, SPFTree &tree, SPFMode mode, const SPFChanges &changes)
+{
+  NS_LOG_FUNCTION (this << node << mode);
+  switch (mode)
+    {
+    case SPF_REPLAY:
+      SPFReplay (tree, node);
+      break;
+    case SPF_REPAIR:
+      SPFRepair (tree, changes, node);
+      break;
+    default:
+      m_spfTree = &tree;
+      SPFCalculate (node->GetObject<GlobalRouter> ()->GetRouterId (), node);
+      m_spfTree = 0;
+      break;
+    }
+}
+
+//
+// The vertices are created again with the LSAs of the current LSDB, and
+// given the distance, parents and root exit directions the calculation gave
+// them.  The routes are then added as in SPFCalculate (), as each vertex
+// joins the tree: this only skips SPFNext () and the candidate queue.
+//
+void
+GlobalRouteManagerImpl::SPFReplay (const SPFTree &tree, Ptr<Node> node)
+{
+  NS_LOG_FUNCTION (this << node);
+  NS_ASSERT (!tree.m_vertices.empty ());
+  std::vector<SPFVertex*> vertices;
+  vertices.reserve (tree.m_vertices.size ());
+  m_spfroot = new SPFVertex (m_lsdb->GetLSA (tree.m_vertices[0].m_id));
+  m_spfroot->SetDistanceFromRoot (0);
+  vertices.push_back (m_spfroot);
+  SetSPFRootNode (node);
+  for (uint32_t i = 1; i < tree.m_vertices.size (); i++)
+    {
+      const SPFTree::Vertex &t = tree.m_vertices[i];
+      GlobalRoutingLSA* lsa = m_lsdb->GetLSA (t.m_id);
+      NS_ASSERT_MSG (lsa, "No LSA for vertex " << t.m_id << " of the tree");
+      SPFVertex* v = new SPFVertex (lsa);
+      v->SetDistanceFromRoot (t.m_distance);
+      RestoreSPFVertex (v, tree, i, vertices);
+      vertices.push_back (v);
+      SPFVertexAddParent (v);
+      if (v->GetVertexType () == SPFVertex::VertexRouter)
+        {
+          SPFIntraAddRouter (v);
+        }
+      else
+        {
+          SPFIntraAddTransit (v);
+        }
+    }
+  SPFSecondStage ();
+}
+
+//
+// The lists of parents and exits are set through another vertex, with the
+// same merges as in SPFNext ().  Lists of several exits only come from these
+// merges, and are kept sorted by them, so the order of the exits, and of the
+// routes, is the same.
+//
+void
+GlobalRouteManagerImpl::RestoreSPFVertex (SPFVertex* v, const SPFTree &tree, uint32_t i,
+                                          const std::vector<SPFVertex*> &vertices)
+{
+  NS_LOG_FUNCTION (v << &tree << i);
+  NS_ASSERT (i > 0 && i < tree.m_vertices.size ());
+  const SPFTree::Vertex &t = tree.m_vertices[i];
+  uint32_t parent = tree.m_vertices[i - 1].m_parentsEnd;
+  uint32_t exit = tree.m_vertices[i - 1].m_exitsEnd;
+  NS_ASSERT (parent < t.m_parentsEnd && exit <= t.m_exitsEnd);
+  SPFVertex other;
+  NS_ASSERT (vertices[tree.m_parents[parent]] != 0);
+  v->SetParent (vertices[tree.m_parents[parent++]]);
+  for (; parent < t.m_parentsEnd; parent++)
+    {
+      NS_ASSERT (vertices[tree.m_parents[parent]] != 0);
+      other.SetParent (vertices[tree.m_parents[parent]]);
+      v->MergeParent (&other);
+    }
+  if (exit < t.m_exitsEnd)
+    {
+      v->SetRootExitDirection (tree.m_exits[exit++]);
+    }
+  for (; exit < t.m_exitsEnd; exit++)
+    {
+      other.SetRootExitDirection (tree.m_exits[exit]);
+      v->MergeRootExitDirections (&other);
+    }
+}
+
+//
+// The removed edges which were on a shortest path affect the vertex at their
+// end, and an affected vertex affects its children.  The others keep their
+// distance, since paths can only get longer, and their parents: none of the
+// links from an affected vertex, or added, is as short as their paths.  The
+// order of the vertices which join the tree with the same distance is that
+// of their first push to the candidate queue at this distance, by their
+// first parent, as it explores its links in order: so the unaffected
+// vertices are pushed in that order when their first parent joins the tree,
+// and also join it in the same order.
+//
+void
+GlobalRouteManagerImpl::SPFRepair (SPFTree &tree, const SPFChanges &changes, Ptr<Node> node)
+{
+  NS_LOG_FUNCTION (this << node);
+  SPFTree old;
+  std::swap (old, tree);
+  uint32_t n = old.m_vertices.size ();
+  NS_ASSERT (n > 0);
+  SPFReuse reuse;
+  reuse.m_tree = &old;
+  reuse.m_affected.resize (n, false);
+  reuse.m_boundary.resize (n, false);
+  reuse.m_vertices.resize (n, 0);
+  for (uint32_t i = 0; i < changes.m_removed.size (); i++)
+    {
+      const SPFEdge &edge = changes.m_removed[i];
+      uint32_t from = old.GetIndex (edge.m_from);
+      uint32_t to = old.GetIndex (edge.m_to);
+      if (from < n && to > 0 && to < n
+          && old.m_vertices[from].m_distance + edge.m_metric <= old.m_vertices[to].m_distance)
+        {
+          reuse.m_affected[to] = true;
+        }
+    }
+  uint32_t nAffected = 0;
+  for (uint32_t i = 1; i < n; i++)
+    {
+      for (uint32_t j = old.m_vertices[i - 1].m_parentsEnd; j < old.m_vertices[i].m_parentsEnd && !reuse.m_affected[i]; j++)
+        {
+          reuse.m_affected[i] = reuse.m_affected[old.m_parents[j]];
+        }
+      if (!reuse.m_affected[i])
+        {
+          continue;
+        }
+      nAffected++;
+      std::map<Ipv4Address, std::vector<Ipv4Address> >::const_iterator predecessors =
+        changes.m_predecessors.find (old.m_vertices[i].m_id);
+      if (predecessors == changes.m_predecessors.end ())
+        {
+          continue;
+        }
+      for (uint32_t j = 0; j < predecessors->second.size (); j++)
+        {
+          uint32_t predecessor = old.GetIndex (predecessors->second[j]);
+          if (predecessor < n)
+            {
+              reuse.m_boundary[predecessor] = true;
+            }
+        }
+    }
+  NS_LOG_LOGIC (nAffected << " of the " << n << " vertices of the tree are affected");
+
+  //
+  // The unaffected vertices, by first parent, then by the index of their
+  // link from this parent.
+  //
+  std::vector<std::pair<uint64_t, uint32_t> > children;
+  for (uint32_t i = 1; i < n; i++)
+    {
+      if (!reuse.m_affected[i])
+        {
+          uint64_t key = (uint64_t (old.GetFirstParent (i)) << 32) | old.m_vertices[i].m_link;
+          children.push_back (std::make_pair (key, i));
+        }
+    }
+  std::sort (children.begin (), children.end ());
+  reuse.m_children.reserve (children.size ());
+  reuse.m_childrenEnd.resize (n);
+  uint32_t j = 0;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      for (; j < children.size () && (children[j].first >> 32) == i; j++)
+        {
+          reuse.m_children.push_back (children[j].second);
+        }
+      reuse.m_childrenEnd[i] = reuse.m_children.size ();
+    }
+
+  m_spfReuse = &reuse;
+  m_spfTree = &tree;
+  SPFCalculate (old.m_vertices[0].m_id, node);
+  m_spfTree = 0;
+  m_spfReuse = 0;
+}
+
+bool
+GlobalRouteManagerImpl::SPFNextReused (SPFVertex* v, CandidateQueue& candidate)
+{
+  NS_LOG_FUNCTION (this << v << &candidate);
+  NS_ASSERT (m_spfReuse);
+  uint32_t i = m_spfReuse->m_tree->GetIndex (v->GetVertexId ());
+  if (i == m_spfReuse->m_tree->m_vertices.size () || m_spfReuse->m_affected[i] || m_spfReuse->m_boundary[i])
+    {
+      return false;
+    }
+  for (uint32_t j = i > 0 ? m_spfReuse->m_childrenEnd[i - 1] : 0; j < m_spfReuse->m_childrenEnd[i]; j++)
+    {
+      PushReusedVertex (m_spfReuse->m_children[j], candidate);
+    }
+  return true;
+}
+
+bool
+GlobalRouteManagerImpl::SPFNextToReused (SPFVertex* v, GlobalRoutingLSA* wLsa, uint32_t distance,
+                                         CandidateQueue& candidate)
+{
+  NS_LOG_FUNCTION (this << v << wLsa << distance << &candidate);
+  NS_ASSERT (m_spfReuse);
+  const SPFTree* tree = m_spfReuse->m_tree;
+  uint32_t i = tree->GetIndex (wLsa->GetLinkStateId ());
+  if (i == tree->m_vertices.size () || m_spfReuse->m_affected[i])
+    {
+      return false;
+    }
+  if (wLsa->GetStatus () == GlobalRoutingLSA::LSA_SPF_NOT_EXPLORED
+      && distance == tree->m_vertices[i].m_distance
+      && tree->GetFirstParent (i) == tree->GetIndex (v->GetVertexId ()))
+    {
+      PushReusedVertex (i, candidate);
+    }
+  return true;
+}
+
+void
+GlobalRouteManagerImpl::PushReusedVertex (uint32_t i, CandidateQueue& candidate)
+{
+  NS_LOG_FUNCTION (this << i << &candidate);
+  NS_ASSERT (m_spfReuse);
+  const SPFTree::Vertex &t = m_spfReuse->m_tree->m_vertices[i];
+  GlobalRoutingLSA* lsa = m_lsdb->GetLSA (t.m_id);
+  NS_ASSERT_MSG (lsa, "No LSA for vertex " << t.m_id << " of the tree");
+  NS_ASSERT (lsa->GetStatus () == GlobalRoutingLSA::LSA_SPF_NOT_EXPLORED);
+  SPFVertex* w = new SPFVertex (lsa);
+  w->SetDistanceFromRoot (t.m_distance);
+  lsa->SetStatus (GlobalRoutingLSA::LSA_SPF_CANDIDATE);
+  m_spfReuse->m_vertices[i] = w;
+  candidate.Push (w);
+}
+
+//
+// The shortest paths only depend on the edges of the graph, so those are
+// compared for the vertices whose LSA changed, and for the networks of the
+// routers which changed: the edges from a network to the routers on it are
+// found through the link records of these routers.
+//
+void
+GlobalRouteManagerImpl::GetSPFChanges (const GlobalRouteManagerLSDB* oldLsdb, SPFChanges &changes) const
+{
+  NS_LOG_FUNCTION (this << oldLsdb);
+  std::vector<Ipv4Address> changed;
+  m_lsdb->GetChangedLSAs (*oldLsdb, changed);
+  std::set<Ipv4Address> vertices (changed.begin (), changed.end ());
+  for (uint32_t i = 0; i < changed.size (); i++)
+    {
+      const GlobalRoutingLSA* lsas[2] = { oldLsdb->GetLSA (changed[i]), m_lsdb->GetLSA (changed[i]) };
+      const GlobalRouteManagerLSDB* lsdbs[2] = { oldLsdb, m_lsdb };
+      if (lsas[0] != 0 && (lsas[1] == 0 || lsas[1]->GetLSType () != lsas[0]->GetLSType ()))
+        {
+          changes.m_gone.push_back (changed[i]);
+        }
+      for (uint32_t j = 0; j < 2; j++)
+        {
+          if (lsas[j] == 0)
+            {
+              continue;
+            }
+          GetSPFNeighbors (lsdbs[j], lsas[j], changes.m_roots);
+          for (uint32_t k = 0; k < lsas[j]->GetNLinkRecords (); k++)
+            {
+              GlobalRoutingLinkRecord *l = lsas[j]->GetLinkRecord (k);
+              if (l->GetLinkType () == GlobalRoutingLinkRecord::TransitNetwork)
+                {
+                  vertices.insert (l->GetLinkId ());
+                }
+            }
+        }
+    }
+
+  for (std::set<Ipv4Address>::const_iterator i = vertices.begin (); i != vertices.end (); i++)
+    {
+      std::vector<SPFEdge> oldEdges;
+      std::vector<SPFEdge> newEdges;
+      GetSPFEdges (oldLsdb, oldLsdb->GetLSA (*i), oldEdges);
+      GetSPFEdges (m_lsdb, m_lsdb->GetLSA (*i), newEdges);
+      std::sort (oldEdges.begin (), oldEdges.end ());
+      std::sort (newEdges.begin (), newEdges.end ());
+      std::set_difference (oldEdges.begin (), oldEdges.end (), newEdges.begin (), newEdges.end (),
+                           std::back_inserter (changes.m_removed));
+      std::set_difference (newEdges.begin (), newEdges.end (), oldEdges.begin (), oldEdges.end (),
+                           std::back_inserter (changes.m_added));
+    }
+  NS_LOG_LOGIC (changed.size () << " LSAs changed, " << changes.m_removed.size ()
+                << " edges removed, " << changes.m_added.size () << " edges added");
+}
+
+void
+GlobalRouteManagerImpl::GetSPFPredecessors (SPFChanges &changes) const
+{
+  NS_LOG_FUNCTION (this);
+  std::vector<GlobalRoutingLSA*> lsas;
+  m_lsdb->GetLSAs (lsas);
+  std::vector<SPFEdge> edges;
+  for (uint32_t i = 0; i < lsas.size (); i++)
+    {
+      GetSPFEdges (m_lsdb, lsas[i], edges);
+    }
+  for (uint32_t i = 0; i < edges.size (); i++)
+    {
+      changes.m_predecessors[edges[i].m_to].push_back (edges[i].m_from);
+    }
+}
+
+GlobalRouteManagerImpl::SPFMode
+GlobalRouteManagerImpl::GetSPFMode (const SPFTree &tree, const SPFChanges &changes)
+{
+  NS_LOG_FUNCTION (&tree);
+  if (tree.m_vertices.empty ()
+      || changes.m_roots.find (tree.m_vertices[0].m_id) != changes.m_roots.end ())
+    {
+      return SPF_CALCULATE;
+    }
+  for (uint32_t i = 0; i < changes.m_gone.size (); i++)
+    {
+      if (tree.GetDistance (changes.m_gone[i]) != SPF_INFINITY)
+        {
+          return SPF_CALCULATE;
+        }
+    }
+  for (uint32_t i = 0; i < changes.m_added.size (); i++)
+    {
+      const SPFEdge &edge = changes.m_added[i];
+      uint32_t from = tree.GetDistance (edge.m_from);
+      if (from != SPF_INFINITY && from + edge.m_metric <= tree.GetDistance (edge.m_to))
+        {
+          return SPF_CALCULATE;
+        }
+    }
+  for (uint32_t i = 0; i < changes.m_removed.size (); i++)
+    {
+      const SPFEdge &edge = changes.m_removed[i];
+      uint32_t from = tree.GetDistance (edge.m_from);
+      if (from != SPF_INFINITY && from + edge.m_metric <= tree.GetDistance (edge.m_to))
+        {
+          return SPF_REPAIR;
+        }
+    }
+  return SPF_REPLAY;
+}
+
+uint32_t
+GlobalRouteManagerImpl::GetSPFLink (const SPFVertex* parent, const SPFVertex* v)
+{
+  NS_LOG_FUNCTION (parent << v);
+  const GlobalRoutingLSA* lsa = parent->GetLSA ();
+  if (parent->GetVertexType () == SPFVertex::VertexRouter)
+    {
+      for (uint32_t i = 0; i < lsa->GetNLinkRecords (); i++)
+        {
+          GlobalRoutingLinkRecord *l = lsa->GetLinkRecord (i);
+          if ((l->GetLinkType () == GlobalRoutingLinkRecord::PointToPoint
+               || l->GetLinkType () == GlobalRoutingLinkRecord::TransitNetwork)
+              && l->GetLinkId () == v->GetVertexId ()
+              && parent->GetDistanceFromRoot () + l->GetMetric () == v->GetDistanceFromRoot ())
+            {
+              return i;
+            }
+        }
+      return 0;
+    }
+  //
+  // The routers on a network are found by the link data of their transit
+  // link records, as GetLSAByLinkData () does.
+  //
+  const GlobalRoutingLSA* vLsa = v->GetLSA ();
+  for (uint32_t i = 0; i < lsa->GetNAttachedRouters (); i++)
+    {
+      for (uint32_t j = 0; j < vLsa->GetNLinkRecords (); j++)
+        {
+          GlobalRoutingLinkRecord *l = vLsa->GetLinkRecord (j);
+          if (l->GetLinkType () == GlobalRoutingLinkRecord::TransitNetwork
+              && l->GetLinkData () == lsa->GetAttachedRouter (i))
+            {
+              return i;
+            }
+        }
+    }
+  return 0;
+}
+
+void
+GlobalRouteManagerImpl::GetSPFEdges (const GlobalRouteManagerLSDB* lsdb, const GlobalRoutingLSA* lsa,
+                                     std::vector<SPFEdge> &edges)
+{
+  NS_LOG_FUNCTION (lsdb << lsa);
+  if (lsa == 0)
+    {
+      return;
+    }
+  SPFEdge edge;
+  edge.m_from = lsa->GetLinkStateId ();
+  if (lsa->GetLSType () == GlobalRoutingLSA::RouterLSA)
+    {
+      for (uint32_t i = 0; i < lsa->GetNLinkRecords (); i++)
+        {
+          GlobalRoutingLinkRecord *l = lsa->GetLinkRecord (i);
+          if (l->GetLinkType () == GlobalRoutingLinkRecord::PointToPoint
+              || l->GetLinkType () == GlobalRoutingLinkRecord::TransitNetwork)
+            {
+              edge.m_to = l->GetLinkId ();
+              edge.m_metric = l->GetMetric ();
+              edges.push_back (edge);
+            }
+        }
+    }
+  else if (lsa->GetLSType () == GlobalRoutingLSA::NetworkLSA)
+    {
+      for (uint32_t i = 0; i < lsa->GetNAttachedRouters (); i++)
+        {
+          GlobalRoutingLSA* router = lsdb->GetLSAByLinkData (lsa->GetAttachedRouter (i));
+          if (router != 0)
+            {
+              edge.m_to = router->GetLinkStateId ();
+              edge.m_metric = 0;
+              edges.push_back (edge);
+            }
+        }
+    }
+}
+
+void
+GlobalRouteManagerImpl::GetSPFNeighbors (const GlobalRouteManagerLSDB* lsdb, const GlobalRoutingLSA* lsa,
+                                         std::set<Ipv4Address> &routers)
+{
+  NS_LOG_FUNCTION (lsdb << lsa);
+  if (lsa == 0)
+    {
+      return;
+    }
+  if (lsa->GetLSType () == GlobalRoutingLSA::RouterLSA)
+    {
+      routers.insert (lsa->GetLinkStateId ());
+      for (uint32_t i = 0; i < lsa->GetNLinkRecords (); i++)
+        {
+          GlobalRoutingLinkRecord *l = lsa->GetLinkRecord (i);
+          if (l->GetLinkType () == GlobalRoutingLinkRecord::PointToPoint)
+            {
+              routers.insert (l->GetLinkId ());
+            }
+          else if (l->GetLinkType () == GlobalRoutingLinkRecord::TransitNetwork)
+            {
+              GlobalRoutingLSA* network = lsdb->GetLSA (l->GetLinkId ());
+              if (network != 0 && network->GetLSType () == GlobalRoutingLSA::NetworkLSA)
+                {
+                  GetSPFNeighbors (lsdb, network, routers);
+                }
+            }
+        }
+    }
+  else if (lsa->GetLSType () == GlobalRoutingLSA::NetworkLSA)
+    {
+      std::vector<SPFEdge> edges;
+      GetSPFEdges (lsdb, lsa, edges);
+      for (uint32_t i = 0; i < edges.size (); i++)
+        {
+          routers.insert (edges[i].m_to);
+        }
+    }
+}
+
+#ifdef HAVE_PTHREAD_H
+struct GlobalRouteManagerImpl::SPFJobs
+{
+  const std::vector<Ptr<Node> > *m_roots; //!< the nodes of the routers
+  std::vector<SPFRoutes_t> *m_routes;     //!< the routes found, by router
+  std::vector<SPFTree> *m_trees;          //!< the shortest path trees, by router
+  const std::vector<SPFMode> *m_modes;    //!< how the routes are found, by router
+  const SPFChanges *m_changes;            //!< the changes of the LSDB since the trees were found
+  uint32_t m_next;                        //!< the next router without a worker
+  SystemMutex m_mutex;                    //!< protects m_next
+};
+#endif /* HAVE_PTHREAD_H */
+
+uint32_t
+GlobalRouteManagerImpl::GetNThreads (uint32_t nRoots) const
+{
+  NS_LOG_FUNCTION (this << nRoots);
+#ifdef HAVE_PTHREAD_H
+  UintegerValue nThreads;
+  g_globalRoutingThreads.GetValue (nThreads);
+  return std::max<uint32_t> (1, std::min<uint32_t> (nThreads.Get (), nRoots));
+#else
+  return 1;
+#endif /* HAVE_PTHREAD_H */
+}
+
+//
+// The SPF calculation changes the status of the LSAs and the state of this
+// object, so each worker thread has its own GlobalRouteManagerImpl, with a
+// copy of the LSDB.  A worker takes the next router without a worker, and
+// records its routes.  Nothing but the node of the router is used by the
+// worker: the Ptr reference counts are not thread-safe, and the NodeList
+// itself is not looked at.
+//
+void
+GlobalRouteManagerImpl::ParallelSPFCalculate (const std::vector<Ptr<Node> > &roots,
+                                              std::vector<SPFRoutes_t> &routes,
+                                              std::vector<SPFTree> &trees,
+                                              const std::vector<SPFMode> &modes,
+                                              const SPFChanges &changes, uint32_t nThreads)
+{
+  NS_LOG_FUNCTION (this << roots.size () << nThreads);
+#ifdef HAVE_PTHREAD_H
+  NS_ASSERT (roots.size () == routes.size ());
+  NS_ASSERT (roots.size () == trees.size () && roots.size () == modes.size ());
+  SPFJobs jobs;
+  jobs.m_roots = &roots;
+  jobs.m_routes = &routes;
+  jobs.m_trees = &trees;
+  jobs.m_modes = &modes;
+  jobs.m_changes = &changes;
+  jobs.m_next = 0;
+
+  std::vector<GlobalRouteManagerImpl*> workers;
+  std::vector<Ptr<SystemThread> > threads;
+  for (uint32_t i = 0; i < nThreads; i++)
+    {
+      GlobalRouteManagerImpl* worker = new GlobalRouteManagerImpl ();
+      worker->DebugUseLsdb (m_lsdb->Copy ());
+      worker->m_jobs = &jobs;
+      workers.push_back (worker);
+      threads.push_back (Create<SystemThread> (MakeCallback (&GlobalRouteManagerImpl::RunSPFJobs, worker)));
+    }
+  for (uint32_t i = 0; i < nThreads; i++)
+    {
+      threads[i]->Start ();
+    }
+  for (uint32_t i = 0; i < nThreads; i++)
+    {
+      threads[i]->Join ();
+      delete workers[i];
+    }
+#else
+  NS_FATAL_ERROR ("GlobalRouteManagerImpl::ParallelSPFCalculate (): threads are not supported");
+#endif /* HAVE_PTHREAD_H */
+}
+
+void
+GlobalRouteManagerImpl::RunSPFJobs (void)
+{
+  NS_LOG_FUNCTION (this);
+#ifdef HAVE_PTHREAD_H
+  NS_ASSERT (m_jobs);
+  for (;;)
+    {
+      uint32_t i;
+      {
+        CriticalSection cs (m_jobs->m_mutex);
+        if (m_jobs->m_next == m_jobs->m_roots->size ())
+          {
+            return;
+          }
+        i = m_jobs->m_next++;
+      }
+      m_spfRoutes = &(*m_jobs->m_routes)[i];
+      SPFRun ((*m_jobs->m_roots)[i], (*m_jobs->m_trees)[i], (*m_jobs->m_modes)[i], *m_jobs->m_changes);
+      m_spfRoutes = 0;
+    }
+#endif /* HAVE_PTHREAD_H */
+}
+
+void
+GlobalRouteManagerImpl::InstallRoutes (Ptr<Node> node, const SPFRoutes_t &routes)
+{
+  NS_LOG_FUNCTION (this << node << routes.size ());
+  Ptr<Ipv4GlobalRouting> gr = node->GetObject<GlobalRouter> ()->GetRoutingProtocol ();
+  NS_ASSERT (gr);
+  for (SPFRoutes_t::const_iterator i = routes.begin (); i != routes.end (); i++)
+    {
+      switch (i->m_type)
+        {
+        case SPFRoute::HOST:
+          gr->AddHostRouteTo (i->m_dest, i->m_nextHop, i->m_interface);
+          break;
+        case SPFRoute::NETWORK:
+          gr->AddNetworkRouteTo (i->m_dest, i->m_mask, i->m_nextHop, i->m_interface);
+          break;
+        case SPFRoute::EXTERNAL:
+          gr->AddASExternalRouteTo (i->m_dest, i->m_mask, i->m_nextHop, i->m_interface);
+          break;
+        }
+    }
+}
+
+void
+GlobalRouteManagerImpl::AddRoute (SPFRoute::Type type, Ipv4Address dest, Ipv4Mask mask,
+                                  Ipv4Address nextHop, uint32_t interface)
+{
+  NS_LOG_FUNCTION (this << type << dest << mask << nextHop << interface);
+  if (m_spfRoutes != 0)
+    {
+      SPFRoute route;
+      route.m_type = type;
+      route.m_dest = dest;
+      route.m_mask = mask;
+      route.m_nextHop = nextHop;
+      route.m_interface = interface;
+      m_spfRoutes->push_back (route);
+      return;
+    }
+  NS_ASSERT (m_spfrootRouting);
+  switch (type)
+    {
+    case SPFRoute::HOST:
+      m_spfrootRouting->AddHostRouteTo (dest, nextHop, interface);
+      break;
+    case SPFRoute::NETWORK:
+      m_spfrootRouting->AddNetworkRouteTo (dest, mask, nextHop, interface);
+      break;
+    case SPFRoute::EXTERNAL:
+      m_spfrootRouting->AddASExternalRouteTo (dest, mask, nextHop, interface);
+      break;
+    }
+}
+
+void
+GlobalRouteManagerImpl::ProcessASExternals (SPFVertex* v, GlobalRoutingLSA* extlsa)
+{
+  NS_LOG_FUNCTION (this << v << extlsa);
+  NS_LOG_LOGIC ("Processing external for destination " << 
+                extlsa->GetLinkStateId () <<
+                ", for router "  << v->GetVertexId () <<
+                ", advertised by " << extlsa->GetAdvertisingRouter ());
+  if (v->GetVertexType () == SPFVertex::VertexRouter)
+    {
+      GlobalRoutingLSA *rlsa = v->GetLSA ();
+      NS_LOG_LOGIC ("Processing router LSA with id " << rlsa->GetLinkStateId ());
+      if ((rlsa->GetLinkStateId ()) == (extlsa->GetAdvertisingRouter ()))
+        {
+          NS_LOG_LOGIC ("Found advertising router to destination");
+          SPFAddASExternal (extlsa,v);
+        }
+    }
+  for (uint32_t i = 0; i < v->GetNChildren (); i++)
+    {
+      if (!v->GetChild (i)->IsVertexProcessed ())
+        {
+          NS_LOG_LOGIC ("Vertex's child " << i << " not yet processed, processing...");
+          ProcessASExternals (v->GetChild (i), extlsa);
+          v->GetChild (i)->SetVertexProcessed (true);
+        }
+    }
+}
+
+//
+// Adding external routes to routing table - modeled after
+// SPFAddIntraAddStub()
+//
+
+void
+GlobalRouteManagerImpl::SPFAddASExternal (GlobalRoutingLSA *extlsa, SPFVertex *v)
+{
+  NS_LOG_FUNCTION (this << extlsa << v);
+
+  NS_ASSERT_MSG (m_spfroot, "GlobalRouteManagerImpl::SPFAddASExternal (): Root pointer not set");
+// Two cases to consider: We are advertising the external ourselves
+// => No need to add anything
+// OR find best path to the advertising router
+  if (v->GetVertexId () == m_spfroot->GetVertexId ())
+    {
+      NS_LOG_LOGIC ("External is on local host: " 
+                    << v->GetVertexId () << "; returning");
+      return;
+    }
+  NS_LOG_LOGIC ("External is on remote host: " 
+                << extlsa->GetAdvertisingRouter () << "; installing");
+
+  Ipv4Address routerId = m_spfroot->GetVertexId ();
+
+  NS_LOG_LOGIC ("Vertex ID = " << routerId);
+//
+// The node that has the router ID corresponding to the root vertex was found
+// when the calculation started.  This is the one we're going to write the
+// routing information to.
+//
+  Ptr<Node> node = m_spfrootNode;
+  if (node == 0)
+    {
+      NS_LOG_LOGIC ("Can't find root node " << routerId);
+      return;
+    }
+  NS_LOG_LOGIC ("Setting routes for node " << node->GetId ());
+//
+// Routing information is updated using the Ipv4 interface.  We need to QI
+// for that interface.  If the node is acting as an IP version 4 router, it
+// should absolutely have an Ipv4 interface.
+//
+  Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
+  NS_ASSERT_MSG (ipv4, 
+                 "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
+                 "QI for <Ipv4> interface failed");
+//
+// Get the Global Router Link State Advertisement from the vertex we're
+// adding the routes to.  The LSA will have a number of attached Global Router
+// Link Records corresponding to links off of that vertex / node.  We're going
+// to be interested in the records corresponding to point-to-point links.
+//
+  NS_ASSERT_MSG (v->GetLSA (), 
+                 "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
+                 "Expected valid LSA in SPFVertex* v");
+  Ipv4Mask tempmask = extlsa->GetNetworkLSANetworkMask ();
+  Ipv4Address tempip = extlsa->GetLinkStateId ();
+  tempip = tempip.CombineMask (tempmask);
+
+//
 // Here's why we did all of that work.  We're going to add a host route to the
 // host address found in the m_linkData field of the point-to-point link
 // record.  In the case of a point-to-point link, this is the local IP address
@@ -1626,39 +2750,29 @@ GlobalRouteManagerImpl::SPFAddASExternal (GlobalRoutingLSA *extlsa, SPFVertex *v
 // Similarly, the vertex <v> has an m_rootOif (outbound interface index) to
 // which the packets should be send for forwarding.
 //
-          Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-          if (router == 0)
-            {
-              continue;
-            }
-          Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-          NS_ASSERT (gr);
-          // walk through all next-hop-IPs and out-going-interfaces for reaching
-          // the stub network gateway 'v' from the root node
-          for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
-            {
-              SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
-              Ipv4Address nextHop = exit.first;
-              int32_t outIf = exit.second;
-              if (outIf >= 0)
-                {
-                  gr->AddASExternalRouteTo (tempip, tempmask, nextHop, outIf);
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " add external network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " via interface " << outIf);
-                }
-              else
-                {
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " NOT able to add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " since outgoing interface id is negative");
-                }
-            }
-          return;
-        } // if
-    } // for
+  // walk through all next-hop-IPs and out-going-interfaces for reaching
+  // the stub network gateway 'v' from the root node
+  for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
+    {
+      SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
+      Ipv4Address nextHop = exit.first;
+      int32_t outIf = exit.second;
+      if (outIf >= 0)
+        {
+          AddRoute (SPFRoute::EXTERNAL, tempip, tempmask, nextHop, outIf);
+          NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
+                        " add external network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " via interface " << outIf);
+        }
+      else
+        {
+          NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
+                        " NOT able to add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " since outgoing interface id is negative");
+        }
+    }
 }
 
 
@@ -1729,60 +2843,38 @@ GlobalRouteManagerImpl::SPFIntraAddStub (GlobalRoutingLinkRecord *l, SPFVertex*
 
   NS_LOG_LOGIC ("Vertex ID = " << routerId);
 //
-// We need to walk the list of nodes looking for the one that has the router
-// ID corresponding to the root vertex.  This is the one we're going to write
-// the routing information to.
+// The node that has the router ID corresponding to the root vertex was found
+// when the calculation started.  This is the one we're going to write the
+// routing information to.
 //
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
+  Ptr<Node> node = m_spfrootNode;
+  if (node == 0)
     {
-      Ptr<Node> node = *i;
-//
-// The router ID is accessible through the GlobalRouter interface, so we need
-// to QI for that interface.  If there's no GlobalRouter interface, the node
-// in question cannot be the router we want, so we continue.
-// 
-      Ptr<GlobalRouter> rtr = 
-        node->GetObject<GlobalRouter> ();
-
-      if (rtr == 0)
-        {
-          NS_LOG_LOGIC ("No GlobalRouter interface on node " << 
-                        node->GetId ());
-          continue;
-        }
-//
-// If the router ID of the current node is equal to the router ID of the 
-// root of the SPF tree, then this node is the one for which we need to 
-// write the routing tables.
-//
-      NS_LOG_LOGIC ("Considering router " << rtr->GetRouterId ());
-
-      if (rtr->GetRouterId () == routerId)
-        {
-          NS_LOG_LOGIC ("Setting routes for node " << node->GetId ());
+      NS_LOG_LOGIC ("Can't find root node " << routerId);
+      return;
+    }
+  NS_LOG_LOGIC ("Setting routes for node " << node->GetId ());
 //
 // Routing information is updated using the Ipv4 interface.  We need to QI
 // for that interface.  If the node is acting as an IP version 4 router, it
 // should absolutely have an Ipv4 interface.
 //
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "QI for <Ipv4> interface failed");
+  Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
+  NS_ASSERT_MSG (ipv4, 
+                 "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
+                 "QI for <Ipv4> interface failed");
 //
 // Get the Global Router Link State Advertisement from the vertex we're
 // adding the routes to.  The LSA will have a number of attached Global Router
 // Link Records corresponding to links off of that vertex / node.  We're going
 // to be interested in the records corresponding to point-to-point links.
 //
-          NS_ASSERT_MSG (v->GetLSA (), 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "Expected valid LSA in SPFVertex* v");
-          Ipv4Mask tempmask (l->GetLinkData ().Get ());
-          Ipv4Address tempip = l->GetLinkId ();
-          tempip = tempip.CombineMask (tempmask);
+  NS_ASSERT_MSG (v->GetLSA (), 
+                 "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
+                 "Expected valid LSA in SPFVertex* v");
+  Ipv4Mask tempmask (l->GetLinkData ().Get ());
+  Ipv4Address tempip = l->GetLinkId ();
+  tempip = tempip.CombineMask (tempmask);
 //
 // Here's why we did all of that work.  We're going to add a host route to the
 // host address found in the m_linkData field of the point-to-point link
@@ -1797,39 +2889,29 @@ GlobalRouteManagerImpl::SPFIntraAddStub (GlobalRoutingLinkRecord *l, SPFVertex*
 // which the packets should be send for forwarding.
 //
 
-          Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-          if (router == 0)
-            {
-              continue;
-            }
-          Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-          NS_ASSERT (gr);
-          // walk through all next-hop-IPs and out-going-interfaces for reaching
-          // the stub network gateway 'v' from the root node
-          for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
-            {
-              SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
-              Ipv4Address nextHop = exit.first;
-              int32_t outIf = exit.second;
-              if (outIf >= 0)
-                {
-                  gr->AddNetworkRouteTo (tempip, tempmask, nextHop, outIf);
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " via interface " << outIf);
-                }
-              else
-                {
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " NOT able to add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " since outgoing interface id is negative");
-                }
-            }
-          return;
-        } // if
-    } // for
+  // walk through all next-hop-IPs and out-going-interfaces for reaching
+  // the stub network gateway 'v' from the root node
+  for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
+    {
+      SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
+      Ipv4Address nextHop = exit.first;
+      int32_t outIf = exit.second;
+      if (outIf >= 0)
+        {
+          AddRoute (SPFRoute::NETWORK, tempip, tempmask, nextHop, outIf);
+          NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
+                        " add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " via interface " << outIf);
+        }
+      else
+        {
+          NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
+                        " NOT able to add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " since outgoing interface id is negative");
+        }
+    }
 }
 
 //
@@ -1853,61 +2935,43 @@ GlobalRouteManagerImpl::FindOutgoingInterfaceId (Ipv4Address a, Ipv4Mask amask)
 //
   Ipv4Address routerId = m_spfroot->GetVertexId ();
 //
-// Walk the list of nodes in the system looking for the one corresponding to
-// the node at the root of the SPF tree.  This is the node for which we are
-// building the routing table.
+// The node at the root of the SPF tree, the one for which we are building
+// the routing table, was found when the calculation started.
 //
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
+  Ptr<Node> node = m_spfrootNode;
+  if (node == 0)
     {
-      Ptr<Node> node = *i;
-
-      Ptr<GlobalRouter> rtr = 
-        node->GetObject<GlobalRouter> ();
 //
-// If the node doesn't have a GlobalRouter interface it can't be the one
-// we're interested in.
+// Couldn't find it.
 //
-      if (rtr == 0)
-        {
-          continue;
-        }
-
-      if (rtr->GetRouterId () == routerId)
-        {
+      NS_LOG_LOGIC ("FindOutgoingInterfaceId():Can't find root node " << routerId);
+      return -1;
+    }
 //
 // This is the node we're building the routing table for.  We're going to need
 // the Ipv4 interface to look for the ipv4 interface index.  Since this node
 // is participating in routing IP version 4 packets, it certainly must have 
 // an Ipv4 interface.
 //
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::FindOutgoingInterfaceId (): "
-                         "GetObject for <Ipv4> interface failed");
+  Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
+  NS_ASSERT_MSG (ipv4, 
+                 "GlobalRouteManagerImpl::FindOutgoingInterfaceId (): "
+                 "GetObject for <Ipv4> interface failed");
 //
 // Look through the interfaces on this node for one that has the IP address
 // we're looking for.  If we find one, return the corresponding interface
 // index, or -1 if not found.
 //
-          int32_t interface = ipv4->GetInterfaceForPrefix (a, amask);
+  int32_t interface = ipv4->GetInterfaceForPrefix (a, amask);
 
 #if 0
-          if (interface < 0)
-            {
-              NS_FATAL_ERROR ("GlobalRouteManagerImpl::FindOutgoingInterfaceId(): "
-                              "Expected an interface associated with address a:" << a);
-            }
-#endif 
-          return interface;
-        }
+  if (interface < 0)
+    {
+      NS_FATAL_ERROR ("GlobalRouteManagerImpl::FindOutgoingInterfaceId(): "
+                      "Expected an interface associated with address a:" << a);
     }
-//
-// Couldn't find it.
-//
-  NS_LOG_LOGIC ("FindOutgoingInterfaceId():Can't find root node " << routerId);
-  return -1;
+#endif 
+  return interface;
 }
 
 //
@@ -1944,60 +3008,38 @@ GlobalRouteManagerImpl::SPFIntraAddRouter (SPFVertex* v)
 
   NS_LOG_LOGIC ("Vertex ID = " << routerId);
 //
-// We need to walk the list of nodes looking for the one that has the router
-// ID corresponding to the root vertex.  This is the one we're going to write
-// the routing information to.
+// The node that has the router ID corresponding to the root vertex was found
+// when the calculation started.  This is the one we're going to write the
+// routing information to.
 //
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
+  Ptr<Node> node = m_spfrootNode;
+  if (node == 0)
     {
-      Ptr<Node> node = *i;
-//
-// The router ID is accessible through the GlobalRouter interface, so we need
-// to GetObject for that interface.  If there's no GlobalRouter interface, 
-// the node in question cannot be the router we want, so we continue.
-// 
-      Ptr<GlobalRouter> rtr = 
-        node->GetObject<GlobalRouter> ();
-
-      if (rtr == 0)
-        {
-          NS_LOG_LOGIC ("No GlobalRouter interface on node " << 
-                        node->GetId ());
-          continue;
-        }
-//
-// If the router ID of the current node is equal to the router ID of the 
-// root of the SPF tree, then this node is the one for which we need to 
-// write the routing tables.
-//
-      NS_LOG_LOGIC ("Considering router " << rtr->GetRouterId ());
-
-      if (rtr->GetRouterId () == routerId)
-        {
-          NS_LOG_LOGIC ("Setting routes for node " << node->GetId ());
+      NS_LOG_LOGIC ("Can't find root node " << routerId);
+      return;
+    }
+  NS_LOG_LOGIC ("Setting routes for node " << node->GetId ());
 //
 // Routing information is updated using the Ipv4 interface.  We need to 
 // GetObject for that interface.  If the node is acting as an IP version 4 
 // router, it should absolutely have an Ipv4 interface.
 //
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "GetObject for <Ipv4> interface failed");
+  Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
+  NS_ASSERT_MSG (ipv4, 
+                 "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
+                 "GetObject for <Ipv4> interface failed");
 //
 // Get the Global Router Link State Advertisement from the vertex we're
 // adding the routes to.  The LSA will have a number of attached Global Router
 // Link Records corresponding to links off of that vertex / node.  We're going
 // to be interested in the records corresponding to point-to-point links.
 //
-          GlobalRoutingLSA *lsa = v->GetLSA ();
-          NS_ASSERT_MSG (lsa, 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "Expected valid LSA in SPFVertex* v");
+  GlobalRoutingLSA *lsa = v->GetLSA ();
+  NS_ASSERT_MSG (lsa, 
+                 "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
+                 "Expected valid LSA in SPFVertex* v");
 
-          uint32_t nLinkRecords = lsa->GetNLinkRecords ();
+  uint32_t nLinkRecords = lsa->GetNLinkRecords ();
 //
 // Iterate through the link records on the vertex to which we're going to add
 // routes.  To make sure we're being clear, we're going to add routing table
@@ -2006,18 +3048,18 @@ GlobalRouteManagerImpl::SPFIntraAddRouter (SPFVertex* v)
 // the local side of the point-to-point links found on the node described by
 // the vertex <v>.
 //
-          NS_LOG_LOGIC (" Node " << node->GetId () <<
-                        " found " << nLinkRecords << " link records in LSA " << lsa << "with LinkStateId "<< lsa->GetLinkStateId ());
-          for (uint32_t j = 0; j < nLinkRecords; ++j)
-            {
+  NS_LOG_LOGIC (" Node " << node->GetId () <<
+                " found " << nLinkRecords << " link records in LSA " << lsa << "with LinkStateId "<< lsa->GetLinkStateId ());
+  for (uint32_t j = 0; j < nLinkRecords; ++j)
+    {
 //
 // We are only concerned about point-to-point links
 //
-              GlobalRoutingLinkRecord *lr = lsa->GetLinkRecord (j);
-              if (lr->GetLinkType () != GlobalRoutingLinkRecord::PointToPoint)
-                {
-                  continue;
-                }
+      GlobalRoutingLinkRecord *lr = lsa->GetLinkRecord (j);
+      if (lr->GetLinkType () != GlobalRoutingLinkRecord::PointToPoint)
+        {
+          continue;
+        }
 //
 // Here's why we did all of that work.  We're going to add a host route to the
 // host address found in the m_linkData field of the point-to-point link
@@ -2031,45 +3073,35 @@ GlobalRouteManagerImpl::SPFIntraAddRouter (SPFVertex* v)
 // Similarly, the vertex <v> has an m_rootOif (outbound interface index) to
 // which the packets should be send for forwarding.
 //
-              Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-              if (router == 0)
-                {
-                  continue;
-                }
-              Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-              NS_ASSERT (gr);
-              // walk through all available exit directions due to ECMP,
-              // and add host route for each of the exit direction toward
-              // the vertex 'v'
-              for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
-                {
-                  SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
-                  Ipv4Address nextHop = exit.first;
-                  int32_t outIf = exit.second;
-                  if (outIf >= 0)
-                    {
-                      gr->AddHostRouteTo (lr->GetLinkData (), nextHop,
-                                          outIf);
-                      NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                    " adding host route to " << lr->GetLinkData () <<
-                                    " using next hop " << nextHop <<
-                                    " and outgoing interface " << outIf);
-                    }
-                  else
-                    {
-                      NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                    " NOT able to add host route to " << lr->GetLinkData () <<
-                                    " using next hop " << nextHop <<
-                                    " since outgoing interface id is negative " << outIf);
-                    }
-                } // for all routes from the root the vertex 'v'
+      // walk through all available exit directions due to ECMP,
+      // and add host route for each of the exit direction toward
+      // the vertex 'v'
+      for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
+        {
+          SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
+          Ipv4Address nextHop = exit.first;
+          int32_t outIf = exit.second;
+          if (outIf >= 0)
+            {
+              AddRoute (SPFRoute::HOST, lr->GetLinkData (), Ipv4Mask::GetOnes (),
+                        nextHop, outIf);
+              NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
+                            " adding host route to " << lr->GetLinkData () <<
+                            " using next hop " << nextHop <<
+                            " and outgoing interface " << outIf);
             }
+          else
+            {
+              NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
+                            " NOT able to add host route to " << lr->GetLinkData () <<
+                            " using next hop " << nextHop <<
+                            " since outgoing interface id is negative " << outIf);
+            }
+        } // for all routes from the root the vertex 'v'
+    }
 //
 // Done adding the routes for the selected node.
 //
-          return;
-        }
-    }
 }
 void
 GlobalRouteManagerImpl::SPFIntraAddTransit (SPFVertex* v)
@@ -2089,95 +3121,65 @@ GlobalRouteManagerImpl::SPFIntraAddTransit (SPFVertex* v)
 
   NS_LOG_LOGIC ("Vertex ID = " << routerId);
 //
-// We need to walk the list of nodes looking for the one that has the router
-// ID corresponding to the root vertex.  This is the one we're going to write
-// the routing information to.
+// The node that has the router ID corresponding to the root vertex was found
+// when the calculation started.  This is the one we're going to write the
+// routing information to.
 //
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
+  Ptr<Node> node = m_spfrootNode;
+  if (node == 0)
     {
-      Ptr<Node> node = *i;
-//
-// The router ID is accessible through the GlobalRouter interface, so we need
-// to GetObject for that interface.  If there's no GlobalRouter interface, 
-// the node in question cannot be the router we want, so we continue.
-// 
-      Ptr<GlobalRouter> rtr = 
-        node->GetObject<GlobalRouter> ();
-
-      if (rtr == 0)
-        {
-          NS_LOG_LOGIC ("No GlobalRouter interface on node " << 
-                        node->GetId ());
-          continue;
-        }
-//
-// If the router ID of the current node is equal to the router ID of the 
-// root of the SPF tree, then this node is the one for which we need to 
-// write the routing tables.
-//
-      NS_LOG_LOGIC ("Considering router " << rtr->GetRouterId ());
-
-      if (rtr->GetRouterId () == routerId)
-        {
-          NS_LOG_LOGIC ("setting routes for node " << node->GetId ());
+      NS_LOG_LOGIC ("Can't find root node " << routerId);
+      return;
+    }
+  NS_LOG_LOGIC ("setting routes for node " << node->GetId ());
 //
 // Routing information is updated using the Ipv4 interface.  We need to 
 // GetObject for that interface.  If the node is acting as an IP version 4 
 // router, it should absolutely have an Ipv4 interface.
 //
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::SPFIntraAddTransit (): "
-                         "GetObject for <Ipv4> interface failed");
+  Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
+  NS_ASSERT_MSG (ipv4, 
+                 "GlobalRouteManagerImpl::SPFIntraAddTransit (): "
+                 "GetObject for <Ipv4> interface failed");
 //
 // Get the Global Router Link State Advertisement from the vertex we're
 // adding the routes to.  The LSA will have a number of attached Global Router
 // Link Records corresponding to links off of that vertex / node.  We're going
 // to be interested in the records corresponding to point-to-point links.
 //
-          GlobalRoutingLSA *lsa = v->GetLSA ();
-          NS_ASSERT_MSG (lsa, 
-                         "GlobalRouteManagerImpl::SPFIntraAddTransit (): "
-                         "Expected valid LSA in SPFVertex* v");
-          Ipv4Mask tempmask = lsa->GetNetworkLSANetworkMask ();
-          Ipv4Address tempip = lsa->GetLinkStateId ();
-          tempip = tempip.CombineMask (tempmask);
-          Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-          if (router == 0)
-            {
-              continue;
-            }
-          Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-          NS_ASSERT (gr);
-          // walk through all available exit directions due to ECMP,
-          // and add host route for each of the exit direction toward
-          // the vertex 'v'
-          for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
-            {
-              SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
-              Ipv4Address nextHop = exit.first;
-              int32_t outIf = exit.second;
+  GlobalRoutingLSA *lsa = v->GetLSA ();
+  NS_ASSERT_MSG (lsa, 
+                 "GlobalRouteManagerImpl::SPFIntraAddTransit (): "
+                 "Expected valid LSA in SPFVertex* v");
+  Ipv4Mask tempmask = lsa->GetNetworkLSANetworkMask ();
+  Ipv4Address tempip = lsa->GetLinkStateId ();
+  tempip = tempip.CombineMask (tempmask);
+  // walk through all available exit directions due to ECMP,
+  // and add host route for each of the exit direction toward
+  // the vertex 'v'
+  for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
+    {
+      SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
+      Ipv4Address nextHop = exit.first;
+      int32_t outIf = exit.second;
 
-              if (outIf >= 0)
-                {
-                  gr->AddNetworkRouteTo (tempip, tempmask, nextHop, outIf);
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " via interface " << outIf);
-                }
-              else
-                {
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " NOT able to add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " since outgoing interface id is negative " << outIf);
-                }
-            }
+      if (outIf >= 0)
+        {
+          AddRoute (SPFRoute::NETWORK, tempip, tempmask, nextHop, outIf);
+          NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
+                        " add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " via interface " << outIf);
         }
-    } 
+      else
+        {
+          NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
+                        " NOT able to add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " since outgoing interface id is negative " << outIf);
+        }
+    }
+
 }
 
 // Derived from quagga ospf_vertex_add_parents ()
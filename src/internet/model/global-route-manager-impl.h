@@ -26,9 +26,12 @@
 #include <list>
 #include <queue>
 #include <map>
+#include <set>
+#include <unordered_map>
 #include <vector>
 #include "ns3/object.h"
 #include "ns3/ptr.h"
+#include "ns3/node.h"
 #include "ns3/ipv4-address.h"
 #include "global-router-interface.h"
 
@@ -638,6 +641,9 @@ public:
  * @returns A pointer to the Link State Advertisement for the router specified
  * by the IP address addr.
  * ID.
+ *
+ * The link records are indexed on the first call following an Insert (), so
+ * they should not be modified once the LSA is in the database.
  */
   GlobalRoutingLSA* GetLSAByLinkData (Ipv4Address addr) const;
 
@@ -674,6 +680,37 @@ public:
    */
   uint32_t GetNumExtLSAs () const;
 
+/**
+ * @brief Copy the Link State Database.
+ *
+ * The Link State Advertisements are copied, so that an SPF calculation
+ * on the copy does not change the status flags of the original.
+ *
+ * @returns a new database, which the caller must delete
+ */
+  GlobalRouteManagerLSDB* Copy () const;
+
+/**
+ * @brief Compare the Link State Advertisements with those of another
+ * database.
+ *
+ * The external Link State Advertisements are not compared.
+ *
+ * @param other the other database
+ * @param changed receives the IDs of the LSAs which are in only one of the
+ * databases, or which differ, in increasing order
+ */
+  void GetChangedLSAs (const GlobalRouteManagerLSDB& other,
+                       std::vector<Ipv4Address>& changed) const;
+
+/**
+ * @brief Get all the Link State Advertisements of the database, except the
+ * external ones.
+ *
+ * @param lsas receives the LSAs, in increasing order of link state ID
+ */
+  void GetLSAs (std::vector<GlobalRoutingLSA*>& lsas) const;
+
 
 private:
   typedef std::map<Ipv4Address, GlobalRoutingLSA*> LSDBMap_t; //!< container of IPv4 addresses / Link State Advertisements
@@ -681,6 +718,9 @@ private:
 
   LSDBMap_t m_database; //!< database of IPv4 addresses / Link State Advertisements
   std::vector<GlobalRoutingLSA*> m_extdatabase; //!< database of External Link State Advertisements
+  /// Index of the LSAs by the link data of their transit network link records
+  mutable LSDBMap_t m_linkDataIndex;
+  mutable bool m_linkDataIndexValid; //!< True if m_linkDataIndex is up to date
 
 /**
  * @brief GlobalRouteManagerLSDB copy construction is disallowed.  There's no 
@@ -734,6 +774,15 @@ public:
  * per-node forwarding tables
  */
   virtual void InitializeRoutes ();
+/**
+ * @brief Recompute the routes after a change of the topology and update the
+ * per-node forwarding tables
+ *
+ * The tables end up as after DeleteGlobalRoutes (),
+ * BuildGlobalRoutingDatabase () and InitializeRoutes (), but the routes
+ * which did not change are not removed and added again.
+ */
+  virtual void UpdateRoutes ();
 
 /**
  * @brief Debugging routine; allow client code to supply a pre-built LSDB
@@ -766,8 +815,369 @@ private:
  */
   GlobalRouteManagerImpl& operator= (GlobalRouteManagerImpl& srmi);
 
+  /// A route found by the SPF calculation, to be added to the root node
+  struct SPFRoute
+  {
+    /// The kind of route, and so the Ipv4GlobalRouting method adding it
+    enum Type
+    {
+      HOST,     //!< AddHostRouteTo ()
+      NETWORK,  //!< AddNetworkRouteTo ()
+      EXTERNAL  //!< AddASExternalRouteTo ()
+    };
+    Type m_type;              //!< Kind of route
+    Ipv4Address m_dest;       //!< Destination
+    Ipv4Mask m_mask;          //!< Destination mask, unused for host routes
+    Ipv4Address m_nextHop;    //!< Next hop
+    uint32_t m_interface;     //!< Outgoing interface
+  };
+  typedef std::vector<SPFRoute> SPFRoutes_t; //!< Routes of a root node, in the order they were found
+
+  /**
+   * \brief The shortest path tree of a router, as found by the first stage
+   * of its SPF calculation
+   *
+   * The vertices are kept in the order they joined the tree, with their
+   * distance, parents and root exit directions: this is all the second
+   * stage and the routes depend on, besides the LSAs of the vertices.
+   */
+  struct SPFTree
+  {
+    /// A vertex of the tree
+    struct Vertex
+    {
+      Ipv4Address m_id;      //!< Vertex ID
+      uint32_t m_distance;   //!< Distance from the root
+      uint32_t m_parentsEnd; //!< End of the parents of the vertex in m_parents
+      uint32_t m_exitsEnd;   //!< End of the root exit directions of the vertex in m_exits
+      uint32_t m_link;       //!< Index of the link to the vertex in the LSA of its first parent
+    };
+    std::vector<Vertex> m_vertices;              //!< The root, then the other vertices in the order they joined the tree
+    std::vector<uint32_t> m_parents;             //!< Parents of the vertices, as indexes in m_vertices
+    std::vector<SPFVertex::NodeExit_t> m_exits;  //!< Root exit directions of the vertices
+    std::vector<uint32_t> m_byId;                //!< Indexes in m_vertices, by increasing vertex ID
+
+    /**
+     * \param id a vertex ID
+     * \returns the index of the vertex in m_vertices, or the number of
+     * vertices if it is not in the tree
+     */
+    uint32_t GetIndex (Ipv4Address id) const;
+
+    /**
+     * \param id a vertex ID
+     * \returns the distance of the vertex from the root, or SPF_INFINITY if
+     * it is not in the tree
+     */
+    uint32_t GetDistance (Ipv4Address id) const;
+
+    /**
+     * \param i the index of a vertex
+     * \returns the index of the parent of the vertex which joined the tree
+     * first, or the number of vertices for the root
+     */
+    uint32_t GetFirstParent (uint32_t i) const;
+
+    /**
+     * \brief Sort m_byId, once all the vertices are in the tree
+     */
+    void IndexVertices (void);
+  };
+  typedef std::map<Ipv4Address, SPFTree> SPFTrees_t; //!< Shortest path trees, by router ID
+
+  /// An edge of the graph the SPF calculation explores
+  struct SPFEdge
+  {
+    Ipv4Address m_from;  //!< ID of the vertex of the LSA describing the edge
+    Ipv4Address m_to;    //!< ID of the other vertex
+    uint32_t m_metric;   //!< Cost of the edge
+    /**
+     * \param other another edge
+     * \returns true if this edge sorts before the other one
+     */
+    bool operator< (const SPFEdge& other) const;
+  };
+
+  /// The changes of the LSDB which may change the shortest path trees
+  struct SPFChanges
+  {
+    std::set<Ipv4Address> m_roots;    //!< Routers whose next hops may have changed
+    std::vector<Ipv4Address> m_gone;  //!< Vertices whose LSA was removed, or changed type
+    std::vector<SPFEdge> m_removed;   //!< Edges which were removed, or whose cost changed
+    std::vector<SPFEdge> m_added;     //!< Edges which were added, or whose cost changed
+    /// The vertices with an edge to each vertex, in m_lsdb, once found
+    std::map<Ipv4Address, std::vector<Ipv4Address> > m_predecessors;
+  };
+
+  /// How the routes of a router are found, see SPFRun ()
+  enum SPFMode
+  {
+    SPF_CALCULATE, //!< Calculate the shortest path tree
+    SPF_REPLAY,    //!< Replay the shortest path tree found before
+    SPF_REPAIR     //!< Calculate the shortest paths which changed, and reuse the others
+  };
+
+  /**
+   * \brief The parts of a shortest path tree found before which a repairing
+   * SPF calculation reuses, see SPFRepair ()
+   *
+   * All the vectors are indexed as the vertices of the tree.
+   */
+  struct SPFReuse
+  {
+    const SPFTree* m_tree;                //!< The tree found before
+    std::vector<bool> m_affected;         //!< Whether the shortest paths to a vertex may have changed
+    std::vector<bool> m_boundary;         //!< Whether an unaffected vertex has an edge to an affected one
+    std::vector<SPFVertex*> m_vertices;   //!< The vertices of the calculation, once created
+    std::vector<uint32_t> m_children;     //!< Unaffected vertices, by first parent, in the order of its links
+    std::vector<uint32_t> m_childrenEnd;  //!< End of the children of a vertex in m_children
+  };
+
+  /// The routers whose routes are calculated by worker threads
+  struct SPFJobs;
+
   SPFVertex* m_spfroot; //!< the root node
+  Ptr<Node> m_spfrootNode; //!< the node of the root vertex, while its routes are calculated
+  Ptr<Ipv4GlobalRouting> m_spfrootRouting; //!< the routing protocol of m_spfrootNode
+  SPFRoutes_t* m_spfRoutes; //!< where the routes are recorded instead of added, if not 0
+  SPFTree* m_spfTree; //!< where the shortest path tree is recorded, if not 0
+  SPFReuse* m_spfReuse; //!< what the SPF calculation reuses from the tree found before, if not 0
+  SPFJobs* m_jobs; //!< the routers shared with the other workers, in a worker thread
   GlobalRouteManagerLSDB* m_lsdb; //!< the Link State DataBase (LSDB) of the Global Route Manager
+  SPFTrees_t m_spfTrees; //!< the shortest path trees of the routers, for m_lsdb
+
+  /**
+   * \brief Get the number of threads the routes are calculated with
+   *
+   * \param nRoots the number of routers to calculate the routes of
+   * \returns the value of the GlobalRoutingThreads global value, at most
+   * nRoots, or 1 if threads are not supported
+   */
+  uint32_t GetNThreads (uint32_t nRoots) const;
+
+  /**
+   * \brief Calculate the routes of several routers in worker threads
+   *
+   * Each worker has its own copy of the LSDB and records the routes it finds
+   * instead of adding them; routes[i] receives the routes of roots[i].
+   *
+   * \param roots the nodes of the routers
+   * \param routes the routes found
+   * \param trees the shortest path trees of the routers, see SPFRun ()
+   * \param modes how the routes of each router are found, see SPFRun ()
+   * \param changes the changes of the LSDB since the trees were found
+   * \param nThreads the number of worker threads
+   */
+  void ParallelSPFCalculate (const std::vector<Ptr<Node> > &roots,
+                             std::vector<SPFRoutes_t> &routes,
+                             std::vector<SPFTree> &trees,
+                             const std::vector<SPFMode> &modes,
+                             const SPFChanges &changes, uint32_t nThreads);
+
+  /**
+   * \brief Worker thread body: calculate the routes of the routers left in
+   * m_jobs until there is none
+   */
+  void RunSPFJobs (void);
+
+  /**
+   * \brief Find the routes of a router, either with the SPF calculation,
+   * or from the shortest path tree it found before
+   *
+   * \param node the node of the router
+   * \param tree the tree found before, which receives the tree calculated
+   * \param mode how the routes are found
+   * \param changes the changes of the LSDB since the tree was found
+   */
+  void SPFRun (Ptr<Node> node, SPFTree &tree, SPFMode mode, const SPFChanges &changes);
+
+  /**
+   * \brief Find the routes of a router from the shortest path tree it found
+   * before
+   *
+   * The vertices are added to the tree in the same order and with the same
+   * next hops as by SPFCalculate (), but with their current LSAs; their
+   * routes, and the second stage of the calculation, follow as in
+   * SPFCalculate ().  This is only valid if the changes of the LSDB since
+   * the tree was found can not change it, see GetSPFMode ().
+   *
+   * \param tree the tree
+   * \param node the node of the router
+   */
+  void SPFReplay (const SPFTree &tree, Ptr<Node> node);
+
+  /**
+   * \brief Find the routes of a router with an SPF calculation which only
+   * explores again the parts of the shortest path tree it found before
+   * whose paths may have changed
+   *
+   * This is only valid if the changes of the LSDB since the tree was found
+   * can only make paths longer, see GetSPFMode ().  The vertices whose
+   * parents are all unaffected by the changes keep their distance, parents
+   * and root exit directions.  They are pushed to the candidate queue when
+   * their first parent leaves it, as SPFNext () would push them, so that
+   * the vertices join the tree in the order a full calculation gives them.
+   * Only the links to the affected vertices are explored.
+   *
+   * \param tree the tree found before, which receives the tree calculated
+   * \param changes the changes of the LSDB since the tree was found
+   * \param node the node of the router
+   */
+  void SPFRepair (SPFTree &tree, const SPFChanges &changes, Ptr<Node> node);
+
+  /**
+   * \brief Push the unaffected vertices a vertex is the first parent of, if
+   * it has no link to an affected vertex; see SPFRepair ()
+   *
+   * \param v the vertex which joined the tree
+   * \param candidate the candidate queue
+   * \returns true if the vertices were pushed, false if SPFNext () must
+   * explore the links of the vertex
+   */
+  bool SPFNextReused (SPFVertex* v, CandidateQueue& candidate);
+
+  /**
+   * \brief Handle the link SPFNext () explores to a vertex unaffected by the
+   * changes of the LSDB, if it is; see SPFRepair ()
+   *
+   * \param v the vertex whose links are explored
+   * \param wLsa the LSA at the other end of the link
+   * \param distance the distance from the root through the link
+   * \param candidate the candidate queue
+   * \returns true if the vertex at the other end of the link is unaffected,
+   * and was pushed if this link is the one through which it joins the tree
+   */
+  bool SPFNextToReused (SPFVertex* v, GlobalRoutingLSA* wLsa, uint32_t distance,
+                        CandidateQueue& candidate);
+
+  /**
+   * \brief Push an unaffected vertex to the candidate queue; see SPFRepair ()
+   *
+   * \param i the index of the vertex in the tree found before
+   * \param candidate the candidate queue
+   */
+  void PushReusedVertex (uint32_t i, CandidateQueue& candidate);
+
+  /**
+   * \brief Give a vertex the parents and root exit directions it had in a
+   * shortest path tree found before
+   *
+   * \param v the vertex
+   * \param tree the tree
+   * \param i the index of the vertex in the tree
+   * \param vertices the vertices of the calculation, indexed as in the tree
+   */
+  static void RestoreSPFVertex (SPFVertex* v, const SPFTree &tree, uint32_t i,
+                                const std::vector<SPFVertex*> &vertices);
+
+  /**
+   * \brief Add a vertex to m_spfTree, when it joins the tree
+   *
+   * \param v the vertex
+   * \param indexes the indexes in the tree of the vertices already added
+   */
+  void RecordSPFVertex (SPFVertex* v, std::unordered_map<const SPFVertex*, uint32_t> &indexes);
+
+  /**
+   * \brief Set the node whose routes are found, and its routing protocol
+   *
+   * \param node the node of the root vertex, or 0 if there is none
+   */
+  void SetSPFRootNode (Ptr<Node> node);
+
+  /**
+   * \brief Second stage of the SPF calculation: add the routes to the stub
+   * networks and the external routes, then delete the tree
+   */
+  void SPFSecondStage (void);
+
+  /**
+   * \brief Find the changes between an older LSDB and m_lsdb which may
+   * change the shortest path trees found with the older one
+   *
+   * \param oldLsdb the older LSDB
+   * \param changes receives the changes
+   */
+  void GetSPFChanges (const GlobalRouteManagerLSDB* oldLsdb, SPFChanges &changes) const;
+
+  /**
+   * \brief Find the vertices with an edge to each vertex in m_lsdb, for
+   * SPFRepair ()
+   *
+   * \param changes receives the vertices
+   */
+  void GetSPFPredecessors (SPFChanges &changes) const;
+
+  /**
+   * \brief Choose how to find the routes of a router after some changes of
+   * the LSDB, from the shortest path tree it found before
+   *
+   * An edge which was removed, or added, only changes the tree if it is or
+   * becomes one of the shortest paths to its end; otherwise the vertices
+   * join the tree in the same order, through the same parents, and the tree
+   * is replayed.  If no edge added is one of the shortest paths, the paths
+   * can only get longer, and the tree is repaired.  The next hops also
+   * depend on the LSAs of the neighbors of the root.
+   *
+   * \param tree the tree
+   * \param changes the changes of the LSDB since the tree was found
+   * \returns how to find the routes of the router
+   */
+  static SPFMode GetSPFMode (const SPFTree &tree, const SPFChanges &changes);
+
+  /**
+   * \brief Get the index of the link through which the SPF calculation
+   * pushes a vertex to the candidate queue, as SPFNext () explores the links
+   * of its parent
+   *
+   * \param parent the parent of the vertex
+   * \param v the vertex
+   * \returns the index of the first link from the parent which is one of
+   * the shortest paths to the vertex
+   */
+  static uint32_t GetSPFLink (const SPFVertex* parent, const SPFVertex* v);
+
+  /**
+   * \brief Get the edges the SPF calculation follows from a vertex
+   *
+   * \param lsdb the LSDB
+   * \param lsa the LSA of the vertex, or 0 if there is none
+   * \param edges receives the edges
+   */
+  static void GetSPFEdges (const GlobalRouteManagerLSDB* lsdb, const GlobalRoutingLSA* lsa,
+                           std::vector<SPFEdge> &edges);
+
+  /**
+   * \brief Get the routers whose next hops from a root may depend on a
+   * vertex: the vertex itself, its point-to-point neighbors, and the
+   * routers on the same networks
+   *
+   * \param lsdb the LSDB
+   * \param lsa the LSA of the vertex, or 0 if there is none
+   * \param routers receives the IDs of the routers
+   */
+  static void GetSPFNeighbors (const GlobalRouteManagerLSDB* lsdb, const GlobalRoutingLSA* lsa,
+                               std::set<Ipv4Address> &routers);
+
+  /**
+   * \brief Add the routes recorded for a router to its routing table
+   *
+   * \param node the node of the router
+   * \param routes the routes, added in order
+   */
+  void InstallRoutes (Ptr<Node> node, const SPFRoutes_t &routes);
+
+  /**
+   * \brief Add a route to the root node, or record it if m_spfRoutes is set
+   *
+   * \param type the kind of route
+   * \param dest the destination
+   * \param mask the destination mask
+   * \param nextHop the next hop
+   * \param interface the outgoing interface
+   */
+  void AddRoute (SPFRoute::Type type, Ipv4Address dest, Ipv4Mask mask,
+                 Ipv4Address nextHop, uint32_t interface);
 
   /**
    * \brief Test if a node is a stub, from an OSPF sense.
@@ -788,6 +1198,21 @@ private:
    * \param root the root node
    */
   void SPFCalculate (Ipv4Address root);
+  /**
+   * \brief Calculate the shortest path first (SPF) tree of a router whose
+   * node is known
+   *
+   * \param root the root node
+   * \param node the node of the router, or 0 if there is none
+   */
+  void SPFCalculate (Ipv4Address root, Ptr<Node> node);
+  /**
+   * \brief Find the node of a router
+   *
+   * \param routerId the router ID
+   * \returns the node with a GlobalRouter of this ID, or 0
+   */
+  Ptr<Node> FindRouterNode (Ipv4Address routerId) const;
 
   /**
    * \brief Process Stub nodes
@@ -65,6 +65,16 @@ public:
  */
   static void InitializeRoutes ();
 
+/**
+ * @brief Rebuild the routing database and update the per-node forwarding
+ * tables, keeping the routes which did not change
+ *
+ * This is equivalent to calling DeleteGlobalRoutes (),
+ * BuildGlobalRoutingDatabase () and InitializeRoutes (), but faster when
+ * few routes changed.
+ */
+  static void UpdateRoutes ();
+
 private:
 /**
  * @brief Global Route Manager copy construction is disallowed.  There's no 
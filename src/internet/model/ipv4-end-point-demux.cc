@@ -28,8 +28,37 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("Ipv4EndPointDemux");
 
+Ipv4EndPointDemux::FourTuple::FourTuple (Ipv4Address localAddress, uint16_t localPort,
+                                         Ipv4Address peerAddress, uint16_t peerPort)
+  : m_localAddress (localAddress),
+    m_peerAddress (peerAddress),
+    m_localPort (localPort),
+    m_peerPort (peerPort)
+{
+}
+
+bool
+Ipv4EndPointDemux::FourTuple::operator== (const FourTuple &other) const
+{
+  return m_localPort == other.m_localPort
+         && m_peerPort == other.m_peerPort
+         && m_localAddress == other.m_localAddress
+         && m_peerAddress == other.m_peerAddress;
+}
+
+std::size_t
+Ipv4EndPointDemux::FourTupleHash::operator() (const FourTuple &tuple) const
+{
+  uint64_t h = (static_cast<uint64_t> (tuple.m_peerAddress.Get ()) << 32) | tuple.m_localAddress.Get ();
+  h ^= ((static_cast<uint64_t> (tuple.m_peerPort) << 16) | tuple.m_localPort) * 0x9e3779b97f4a7c15ULL;
+  h ^= h >> 31;
+  h *= 0xbf58476d1ce4e5b9ULL;
+  h ^= h >> 29;
+  return static_cast<std::size_t> (h);
+}
+
 Ipv4EndPointDemux::Ipv4EndPointDemux ()
-  : m_ephemeral (49152), m_portLast (65535), m_portFirst (49152)
+  : m_ephemeral (49152), m_portLast (65535), m_portFirst (49152), m_sequence (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -40,33 +69,136 @@ Ipv4EndPointDemux::~Ipv4EndPointDemux ()
   for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
     {
       Ipv4EndPoint *endPoint = *i;
+      endPoint->m_demux = 0;
       delete endPoint;
     }
   m_endPoints.clear ();
+  m_ports.clear ();
+  m_wildcards.clear ();
+  m_connected.clear ();
 }
 
 bool
-Ipv4EndPointDemux::LookupPortLocal (uint16_t port)
+Ipv4EndPointDemux::IsConnected (Ipv4EndPoint *endPoint)
 {
-  NS_LOG_FUNCTION (this << port);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  return endPoint->GetLocalAddress () != Ipv4Address::GetAny ()
+         && endPoint->GetPeerAddress () != Ipv4Address::GetAny ()
+         && endPoint->GetPeerPort () != 0;
+}
+
+void
+Ipv4EndPointDemux::Insert (Ipv4EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  endPoint->m_sequence = m_sequence++;
+  endPoint->m_endPointsIt = m_endPoints.insert (m_endPoints.end (), endPoint);
+  endPoint->m_demux = this;
+  IndexPort (endPoint);
+  Index (endPoint);
+  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
+}
+
+Ipv4EndPointDemux::EndPointsI
+Ipv4EndPointDemux::InsertInOrder (EndPoints &endPoints, Ipv4EndPoint *endPoint)
+{
+  EndPointsI i = endPoints.end ();
+  while (i != endPoints.begin ())
     {
-      if ((*i)->GetLocalPort  () == port) 
+      EndPointsI previous = i;
+      previous--;
+      if ((*previous)->m_sequence < endPoint->m_sequence)
         {
-          return true;
+          break;
         }
+      i = previous;
     }
-  return false;
+  return endPoints.insert (i, endPoint);
+}
+
+void
+Ipv4EndPointDemux::IndexPort (Ipv4EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  endPoint->m_portIt = InsertInOrder (m_ports[endPoint->GetLocalPort ()], endPoint);
+}
+
+void
+Ipv4EndPointDemux::UnindexPort (Ipv4EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  PortEndPoints::iterator it = m_ports.find (endPoint->GetLocalPort ());
+  NS_ASSERT (it != m_ports.end ());
+  it->second.erase (endPoint->m_portIt);
+  if (it->second.empty ())
+    {
+      m_ports.erase (it);
+    }
+}
+
+void
+Ipv4EndPointDemux::Index (Ipv4EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  if (IsConnected (endPoint))
+    {
+      FourTuple tuple (endPoint->GetLocalAddress (), endPoint->GetLocalPort (),
+                       endPoint->GetPeerAddress (), endPoint->GetPeerPort ());
+      m_connected.insert (std::make_pair (tuple, endPoint));
+      return;
+    }
+  endPoint->m_wildcardIt = InsertInOrder (m_wildcards[endPoint->GetLocalPort ()], endPoint);
+}
+
+void
+Ipv4EndPointDemux::Unindex (Ipv4EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  if (IsConnected (endPoint))
+    {
+      FourTuple tuple (endPoint->GetLocalAddress (), endPoint->GetLocalPort (),
+                       endPoint->GetPeerAddress (), endPoint->GetPeerPort ());
+      std::pair<ConnectedEndPoints::iterator, ConnectedEndPoints::iterator> range;
+      range = m_connected.equal_range (tuple);
+      for (ConnectedEndPoints::iterator i = range.first; i != range.second; i++)
+        {
+          if (i->second == endPoint)
+            {
+              m_connected.erase (i);
+              return;
+            }
+        }
+      NS_ASSERT_MSG (false, "Connected end point not indexed");
+      return;
+    }
+
+  PortEndPoints::iterator it = m_wildcards.find (endPoint->GetLocalPort ());
+  NS_ASSERT (it != m_wildcards.end ());
+  it->second.erase (endPoint->m_wildcardIt);
+  if (it->second.empty ())
+    {
+      m_wildcards.erase (it);
+    }
+}
+
+bool
+Ipv4EndPointDemux::LookupPortLocal (uint16_t port)
+{
+  NS_LOG_FUNCTION (this << port);
+  return m_ports.find (port) != m_ports.end ();
 }
 
 bool
 Ipv4EndPointDemux::LookupLocal (Ipv4Address addr, uint16_t port)
 {
   NS_LOG_FUNCTION (this << addr << port);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  PortEndPoints::iterator it = m_ports.find (port);
+  if (it == m_ports.end ())
+    {
+      return false;
+    }
+  for (EndPointsI i = it->second.begin (); i != it->second.end (); i++) 
     {
-      if ((*i)->GetLocalPort () == port &&
-          (*i)->GetLocalAddress () == addr) 
+      if ((*i)->GetLocalAddress () == addr) 
         {
           return true;
         }
@@ -85,8 +217,7 @@ Ipv4EndPointDemux::Allocate (void)
       return 0;
     }
   Ipv4EndPoint *endPoint = new Ipv4EndPoint (Ipv4Address::GetAny (), port);
-  m_endPoints.push_back (endPoint);
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
+  Insert (endPoint);
   return endPoint;
 }
 
@@ -101,8 +232,7 @@ Ipv4EndPointDemux::Allocate (Ipv4Address address)
       return 0;
     }
   Ipv4EndPoint *endPoint = new Ipv4EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
+  Insert (endPoint);
   return endPoint;
 }
 
@@ -124,8 +254,7 @@ Ipv4EndPointDemux::Allocate (Ipv4Address address, uint16_t port)
       return 0;
     }
   Ipv4EndPoint *endPoint = new Ipv4EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
+  Insert (endPoint);
   return endPoint;
 }
 
@@ -134,40 +263,54 @@ Ipv4EndPointDemux::Allocate (Ipv4Address localAddress, uint16_t localPort,
                              Ipv4Address peerAddress, uint16_t peerPort)
 {
   NS_LOG_FUNCTION (this << localAddress << localPort << peerAddress << peerPort);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  Ipv4EndPoint *endPoint = new Ipv4EndPoint (localAddress, localPort);
+  endPoint->SetPeer (peerAddress, peerPort);
+
+  bool duplicate = false;
+  if (IsConnected (endPoint))
+    {
+      FourTuple tuple (localAddress, localPort, peerAddress, peerPort);
+      duplicate = m_connected.find (tuple) != m_connected.end ();
+    }
+  else
     {
-      if ((*i)->GetLocalPort () == localPort &&
-          (*i)->GetLocalAddress () == localAddress &&
-          (*i)->GetPeerPort () == peerPort &&
-          (*i)->GetPeerAddress () == peerAddress) 
+      PortEndPoints::iterator it = m_wildcards.find (localPort);
+      if (it != m_wildcards.end ())
         {
-          NS_LOG_WARN ("No way we can allocate this end-point.");
-          /* no way we can allocate this end-point. */
-          return 0;
+          for (EndPointsI i = it->second.begin (); i != it->second.end (); i++)
+            {
+              if ((*i)->GetLocalAddress () == localAddress &&
+                  (*i)->GetPeerPort () == peerPort &&
+                  (*i)->GetPeerAddress () == peerAddress) 
+                {
+                  duplicate = true;
+                  break;
+                }
+            }
         }
     }
-  Ipv4EndPoint *endPoint = new Ipv4EndPoint (localAddress, localPort);
-  endPoint->SetPeer (peerAddress, peerPort);
-  m_endPoints.push_back (endPoint);
-
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
+  if (duplicate)
+    {
+      NS_LOG_WARN ("No way we can allocate this end-point.");
+      /* no way we can allocate this end-point. */
+      delete endPoint;
+      return 0;
+    }
 
+  Insert (endPoint);
   return endPoint;
 }
 
-void 
+void
 Ipv4EndPointDemux::DeAllocate (Ipv4EndPoint *endPoint)
 {
   NS_LOG_FUNCTION (this << endPoint);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
-    {
-      if (*i == endPoint)
-        {
-          delete endPoint;
-          m_endPoints.erase (i);
-          break;
-        }
-    }
+  NS_ASSERT (endPoint->m_demux == this);
+  Unindex (endPoint);
+  UnindexPort (endPoint);
+  m_endPoints.erase (endPoint->m_endPointsIt);
+  endPoint->m_demux = 0;
+  delete endPoint;
 }
 
 /*
@@ -200,122 +343,170 @@ Ipv4EndPointDemux::Lookup (Ipv4Address daddr, uint16_t dport,
 {
   NS_LOG_FUNCTION (this << daddr << dport << saddr << sport << incomingInterface);
   
-  EndPoints retval1; // Matches exact on local port, wildcards on others
-  EndPoints retval2; // Matches exact on local port/adder, wildcards on others
-  EndPoints retval3; // Matches all but local address
-  EndPoints retval4; // Exact match on all 4
-
-  NS_LOG_DEBUG ("Looking up endpoint for destination address " << daddr);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  // retval[0]: Matches exact on local port, wildcards on others
+  // retval[1]: Matches exact on local port/adder, wildcards on others
+  // retval[2]: Matches all but local address
+  // retval[3]: Exact match on all 4
+  EndPoints retval[4];
+
+  bool subnetDirected = false;
+  Ipv4Address incomingInterfaceAddr = daddr;  // may be a broadcast
+  for (uint32_t i = 0; incomingInterface && i < incomingInterface->GetNAddresses (); i++)
     {
-      Ipv4EndPoint* endP = *i;
-
-      NS_LOG_DEBUG ("Looking at endpoint dport=" << endP->GetLocalPort ()
-                                                 << " daddr=" << endP->GetLocalAddress ()
-                                                 << " sport=" << endP->GetPeerPort ()
-                                                 << " saddr=" << endP->GetPeerAddress ());
-
-      if (!endP->IsRxEnabled ())
+      Ipv4InterfaceAddress addr = incomingInterface->GetAddress (i);
+      if (addr.GetLocal ().CombineMask (addr.GetMask ()) == daddr.CombineMask (addr.GetMask ()) &&
+          daddr.IsSubnetDirectedBroadcast (addr.GetMask ()))
         {
-          NS_LOG_LOGIC ("Skipping endpoint " << &endP
-                        << " because endpoint can not receive packets");
-          continue;
+          subnetDirected = true;
+          incomingInterfaceAddr = addr.GetLocal ();
         }
+    }
+  bool isBroadcast = (daddr.IsBroadcast () || subnetDirected == true);
+  NS_LOG_DEBUG ("dest addr " << daddr << " broadcast? " << isBroadcast);
 
-      if (endP->GetLocalPort () != dport) 
-        {
-          NS_LOG_LOGIC ("Skipping endpoint " << &endP
-                                             << " because endpoint dport "
-                                             << endP->GetLocalPort ()
-                                             << " does not match packet dport " << dport);
-          continue;
-        }
-      if (endP->GetBoundNetDevice ())
+  NS_LOG_DEBUG ("Looking up endpoint for destination address " << daddr);
+  const EndPoints *candidates = 0;
+  PortEndPoints::const_iterator it;
+  FourTuple tuple (daddr, dport, saddr, sport);
+  if (!isBroadcast && m_connected.count (tuple) <= 1)
+    {
+      // A connected end point can only be an exact match on all 4; if
+      // there is one, no other end point can be a better match.
+      ConnectedEndPoints::const_iterator connected = m_connected.find (tuple);
+      if (connected != m_connected.end ())
         {
-          if (endP->GetBoundNetDevice () != incomingInterface->GetDevice ())
+          Match (connected->second, daddr, dport, saddr, sport, incomingInterface,
+                 isBroadcast, incomingInterfaceAddr, retval);
+          if (!retval[3].empty ())
             {
-              NS_LOG_LOGIC ("Skipping endpoint " << &endP
-                                                 << " because endpoint is bound to specific device and"
-                                                 << endP->GetBoundNetDevice ()
-                                                 << " does not match packet device " << incomingInterface->GetDevice ());
-              continue;
+              return retval[3];
             }
         }
-      bool subnetDirected = false;
-      Ipv4Address incomingInterfaceAddr = daddr;  // may be a broadcast
-      for (uint32_t i = 0; i < incomingInterface->GetNAddresses (); i++)
+      it = m_wildcards.find (dport);
+      if (it != m_wildcards.end ())
         {
-          Ipv4InterfaceAddress addr = incomingInterface->GetAddress (i);
-          if (addr.GetLocal ().CombineMask (addr.GetMask ()) == daddr.CombineMask (addr.GetMask ()) &&
-              daddr.IsSubnetDirectedBroadcast (addr.GetMask ()))
-            {
-              subnetDirected = true;
-              incomingInterfaceAddr = addr.GetLocal ();
-            }
+          candidates = &it->second;
         }
-      bool isBroadcast = (daddr.IsBroadcast () || subnetDirected == true);
-      NS_LOG_DEBUG ("dest addr " << daddr << " broadcast? " << isBroadcast);
-      bool localAddressMatchesWildCard = 
-        endP->GetLocalAddress () == Ipv4Address::GetAny ();
-      bool localAddressMatchesExact = endP->GetLocalAddress () == daddr;
-
-      if (isBroadcast)
+    }
+  else
+    {
+      // Broadcast packets can match connected end points bound to the
+      // address of the incoming interface, and several connected end
+      // points must be returned in allocation order: check all of them
+      it = m_ports.find (dport);
+      if (it != m_ports.end ())
         {
-          NS_LOG_DEBUG ("Found bcast, localaddr " << endP->GetLocalAddress ());
+          candidates = &it->second;
         }
+    }
 
-      if (isBroadcast && (endP->GetLocalAddress () != Ipv4Address::GetAny ()))
+  if (candidates != 0)
+    {
+      for (EndPoints::const_iterator i = candidates->begin (); i != candidates->end (); i++)
         {
-          localAddressMatchesExact = (endP->GetLocalAddress () ==
-                                      incomingInterfaceAddr);
-        }
-      // if no match here, keep looking
-      if (!(localAddressMatchesExact || localAddressMatchesWildCard))
-        continue; 
-      bool remotePeerMatchesExact = endP->GetPeerPort () == sport;
-      bool remotePeerMatchesWildCard = endP->GetPeerPort () == 0;
-      bool remoteAddressMatchesExact = endP->GetPeerAddress () == saddr;
-      bool remoteAddressMatchesWildCard = endP->GetPeerAddress () ==
-        Ipv4Address::GetAny ();
-      // If remote does not match either with exact or wildcard,
-      // skip this one
-      if (!(remotePeerMatchesExact || remotePeerMatchesWildCard))
-        continue;
-      if (!(remoteAddressMatchesExact || remoteAddressMatchesWildCard))
-        continue;
-
-      // Now figure out which return list to add this one to
-      if (localAddressMatchesWildCard &&
-          remotePeerMatchesWildCard &&
-          remoteAddressMatchesWildCard)
-        { // Only local port matches exactly
-          retval1.push_back (endP);
-        }
-      if ((localAddressMatchesExact || (isBroadcast && localAddressMatchesWildCard))&&
-          remotePeerMatchesWildCard &&
-          remoteAddressMatchesWildCard)
-        { // Only local port and local address matches exactly
-          retval2.push_back (endP);
-        }
-      if (localAddressMatchesWildCard &&
-          remotePeerMatchesExact &&
-          remoteAddressMatchesExact)
-        { // All but local address
-          retval3.push_back (endP);
-        }
-      if (localAddressMatchesExact &&
-          remotePeerMatchesExact &&
-          remoteAddressMatchesExact)
-        { // All 4 match
-          retval4.push_back (endP);
+          Match (*i, daddr, dport, saddr, sport, incomingInterface,
+                 isBroadcast, incomingInterfaceAddr, retval);
         }
     }
 
   // Here we find the most exact match
-  if (!retval4.empty ()) return retval4;
-  if (!retval3.empty ()) return retval3;
-  if (!retval2.empty ()) return retval2;
-  return retval1;  // might be empty if no matches
+  if (!retval[3].empty ()) return retval[3];
+  if (!retval[2].empty ()) return retval[2];
+  if (!retval[1].empty ()) return retval[1];
+  return retval[0];  // might be empty if no matches
+}
+
+void
+Ipv4EndPointDemux::Match (Ipv4EndPoint *endP, Ipv4Address daddr, uint16_t dport,
+                          Ipv4Address saddr, uint16_t sport,
+                          Ptr<Ipv4Interface> incomingInterface, bool isBroadcast,
+                          Ipv4Address incomingInterfaceAddr, EndPoints *retval)
+{
+  NS_LOG_DEBUG ("Looking at endpoint dport=" << endP->GetLocalPort ()
+                                             << " daddr=" << endP->GetLocalAddress ()
+                                             << " sport=" << endP->GetPeerPort ()
+                                             << " saddr=" << endP->GetPeerAddress ());
+
+  if (!endP->IsRxEnabled ())
+    {
+      NS_LOG_LOGIC ("Skipping endpoint " << &endP
+                    << " because endpoint can not receive packets");
+      return;
+    }
+
+  if (endP->GetLocalPort () != dport) 
+    {
+      NS_LOG_LOGIC ("Skipping endpoint " << &endP
+                                         << " because endpoint dport "
+                                         << endP->GetLocalPort ()
+                                         << " does not match packet dport " << dport);
+      return;
+    }
+  if (endP->GetBoundNetDevice ())
+    {
+      if (endP->GetBoundNetDevice () != incomingInterface->GetDevice ())
+        {
+          NS_LOG_LOGIC ("Skipping endpoint " << &endP
+                                             << " because endpoint is bound to specific device and"
+                                             << endP->GetBoundNetDevice ()
+                                             << " does not match packet device " << incomingInterface->GetDevice ());
+          return;
+        }
+    }
+  bool localAddressMatchesWildCard = 
+    endP->GetLocalAddress () == Ipv4Address::GetAny ();
+  bool localAddressMatchesExact = endP->GetLocalAddress () == daddr;
+
+  if (isBroadcast)
+    {
+      NS_LOG_DEBUG ("Found bcast, localaddr " << endP->GetLocalAddress ());
+    }
+
+  if (isBroadcast && (endP->GetLocalAddress () != Ipv4Address::GetAny ()))
+    {
+      localAddressMatchesExact = (endP->GetLocalAddress () ==
+                                  incomingInterfaceAddr);
+    }
+  // if no match here, keep looking
+  if (!(localAddressMatchesExact || localAddressMatchesWildCard))
+    return; 
+  bool remotePeerMatchesExact = endP->GetPeerPort () == sport;
+  bool remotePeerMatchesWildCard = endP->GetPeerPort () == 0;
+  bool remoteAddressMatchesExact = endP->GetPeerAddress () == saddr;
+  bool remoteAddressMatchesWildCard = endP->GetPeerAddress () ==
+    Ipv4Address::GetAny ();
+  // If remote does not match either with exact or wildcard,
+  // skip this one
+  if (!(remotePeerMatchesExact || remotePeerMatchesWildCard))
+    return;
+  if (!(remoteAddressMatchesExact || remoteAddressMatchesWildCard))
+    return;
+
+  // Now figure out which return list to add this one to
+  if (localAddressMatchesWildCard &&
+      remotePeerMatchesWildCard &&
+      remoteAddressMatchesWildCard)
+    { // Only local port matches exactly
+      retval[0].push_back (endP);
+    }
+  if ((localAddressMatchesExact || (isBroadcast && localAddressMatchesWildCard))&&
+      remotePeerMatchesWildCard &&
+      remoteAddressMatchesWildCard)
+    { // Only local port and local address matches exactly
+      retval[1].push_back (endP);
+    }
+  if (localAddressMatchesWildCard &&
+      remotePeerMatchesExact &&
+      remoteAddressMatchesExact)
+    { // All but local address
+      retval[2].push_back (endP);
+    }
+  if (localAddressMatchesExact &&
+      remotePeerMatchesExact &&
+      remoteAddressMatchesExact)
+    { // All 4 match
+      retval[3].push_back (endP);
+    }
 }
 
 Ipv4EndPoint *
@@ -326,16 +517,18 @@ Ipv4EndPointDemux::SimpleLookup (Ipv4Address daddr,
 {
   NS_LOG_FUNCTION (this << daddr << dport << saddr << sport);
 
+  PortEndPoints::iterator it = m_ports.find (dport);
+  if (it == m_ports.end ())
+    {
+      return 0;
+    }
+
   // this code is a copy/paste version of an old BSD ip stack lookup
   // function.
   uint32_t genericity = 3;
   Ipv4EndPoint *generic = 0;
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  for (EndPointsI i = it->second.begin (); i != it->second.end (); i++) 
     {
-      if ((*i)->GetLocalPort () != dport) 
-        {
-          continue;
-        }
       if ((*i)->GetLocalAddress () == daddr &&
           (*i)->GetPeerPort () == sport &&
           (*i)->GetPeerAddress () == saddr) 
@@ -22,6 +22,7 @@
 #define IPV4_END_POINT_H
 
 #include <stdint.h>
+#include <list>
 #include "ns3/ipv4-address.h"
 #include "ns3/callback.h"
 #include "ns3/net-device.h"
@@ -32,6 +33,7 @@ namespace ns3 {
 
 class Header;
 class Packet;
+class Ipv4EndPointDemux;
 
 /**
  * \ingroup ipv4
@@ -227,6 +229,38 @@ private:
    * \brief true if the endpoint can receive packets.
    */
   bool m_rxEnabled;
+
+  friend class Ipv4EndPointDemux;
+
+  /**
+   * \brief The demux indexing this end point (if any).
+   *
+   * The demux is told when the four-tuple changes, to keep its index
+   * up to date.
+   */
+  Ipv4EndPointDemux *m_demux;
+
+  /**
+   * \brief Allocation order of the end point in its demux.
+   */
+  uint64_t m_sequence;
+
+  /**
+   * \brief Position of the end point in the list of all the end points of its demux.
+   */
+  std::list<Ipv4EndPoint *>::iterator m_endPointsIt;
+
+  /**
+   * \brief Position of the end point in the list of its local port.
+   */
+  std::list<Ipv4EndPoint *>::iterator m_portIt;
+
+  /**
+   * \brief Position of the end point in the unconnected end points of its local port.
+   *
+   * Only valid while the end point is not connected.
+   */
+  std::list<Ipv4EndPoint *>::iterator m_wildcardIt;
 };
 
 } // namespace ns3
@@ -27,6 +27,7 @@
 #include "ns3/ipv4-route.h"
 #include "ns3/ipv4-routing-table-entry.h"
 #include "ns3/boolean.h"
+#include "ns3/unused.h"
 #include "ns3/node.h"
 #include "ipv4-global-routing.h"
 #include "global-route-manager.h"
@@ -59,7 +60,12 @@ Ipv4GlobalRouting::GetTypeId (void)
 
 Ipv4GlobalRouting::Ipv4GlobalRouting () 
   : m_randomEcmpRouting (false),
-    m_respondToInterfaceEvents (false)
+    m_respondToInterfaceEvents (false),
+    m_nextRank (RANK_STEP),
+    m_updating (false),
+    m_hostUpdate (m_hostRoutes.end ()),
+    m_networkUpdate (m_networkRoutes.end ()),
+    m_ASexternalUpdate (m_ASexternalRoutes.end ())
 {
   NS_LOG_FUNCTION (this);
 
@@ -77,9 +83,8 @@ Ipv4GlobalRouting::AddHostRouteTo (Ipv4Address dest,
                                    uint32_t interface)
 {
   NS_LOG_FUNCTION (this << dest << nextHop << interface);
-  Ipv4RoutingTableEntry *route = new Ipv4RoutingTableEntry ();
-  *route = Ipv4RoutingTableEntry::CreateHostRouteTo (dest, nextHop, interface);
-  m_hostRoutes.push_back (route);
+  Ipv4RoutingTableEntry route = Ipv4RoutingTableEntry::CreateHostRouteTo (dest, nextHop, interface);
+  AddRoute (m_hostRoutes, m_hostIndex, m_hostUpdate, route);
 }
 
 void 
@@ -87,9 +92,8 @@ Ipv4GlobalRouting::AddHostRouteTo (Ipv4Address dest,
                                    uint32_t interface)
 {
   NS_LOG_FUNCTION (this << dest << interface);
-  Ipv4RoutingTableEntry *route = new Ipv4RoutingTableEntry ();
-  *route = Ipv4RoutingTableEntry::CreateHostRouteTo (dest, interface);
-  m_hostRoutes.push_back (route);
+  Ipv4RoutingTableEntry route = Ipv4RoutingTableEntry::CreateHostRouteTo (dest, interface);
+  AddRoute (m_hostRoutes, m_hostIndex, m_hostUpdate, route);
 }
 
 void 
@@ -99,12 +103,11 @@ Ipv4GlobalRouting::AddNetworkRouteTo (Ipv4Address network,
                                       uint32_t interface)
 {
   NS_LOG_FUNCTION (this << network << networkMask << nextHop << interface);
-  Ipv4RoutingTableEntry *route = new Ipv4RoutingTableEntry ();
-  *route = Ipv4RoutingTableEntry::CreateNetworkRouteTo (network,
-                                                        networkMask,
-                                                        nextHop,
-                                                        interface);
-  m_networkRoutes.push_back (route);
+  Ipv4RoutingTableEntry route = Ipv4RoutingTableEntry::CreateNetworkRouteTo (network,
+                                                                             networkMask,
+                                                                             nextHop,
+                                                                             interface);
+  AddRoute (m_networkRoutes, m_networkIndex, m_networkUpdate, route);
 }
 
 void 
@@ -113,11 +116,10 @@ Ipv4GlobalRouting::AddNetworkRouteTo (Ipv4Address network,
                                       uint32_t interface)
 {
   NS_LOG_FUNCTION (this << network << networkMask << interface);
-  Ipv4RoutingTableEntry *route = new Ipv4RoutingTableEntry ();
-  *route = Ipv4RoutingTableEntry::CreateNetworkRouteTo (network,
-                                                        networkMask,
-                                                        interface);
-  m_networkRoutes.push_back (route);
+  Ipv4RoutingTableEntry route = Ipv4RoutingTableEntry::CreateNetworkRouteTo (network,
+                                                                             networkMask,
+                                                                             interface);
+  AddRoute (m_networkRoutes, m_networkIndex, m_networkUpdate, route);
 }
 
 void 
@@ -127,15 +129,218 @@ Ipv4GlobalRouting::AddASExternalRouteTo (Ipv4Address network,
                                          uint32_t interface)
 {
   NS_LOG_FUNCTION (this << network << networkMask << nextHop << interface);
-  Ipv4RoutingTableEntry *route = new Ipv4RoutingTableEntry ();
-  *route = Ipv4RoutingTableEntry::CreateNetworkRouteTo (network,
-                                                        networkMask,
-                                                        nextHop,
-                                                        interface);
-  m_ASexternalRoutes.push_back (route);
+  Ipv4RoutingTableEntry route = Ipv4RoutingTableEntry::CreateNetworkRouteTo (network,
+                                                                             networkMask,
+                                                                             nextHop,
+                                                                             interface);
+  AddRoute (m_ASexternalRoutes, m_ASexternalIndex, m_ASexternalUpdate, route);
 }
 
 
+/**
+ * \brief Serialize an address or a mask for a prefix index
+ * \param address the address or the mask
+ * \param buf the buffer
+ */
+static void
+GetIndexKey (uint32_t address, uint8_t buf[4])
+{
+  Ipv4Address (address).Serialize (buf);
+}
+
+/**
+ * \brief Compare two routes
+ * \param a a route
+ * \param b another route
+ * \return true if the routes have the same destination, gateway and interface
+ */
+static bool
+IsSameRoute (const Ipv4RoutingTableEntry &a, const Ipv4RoutingTableEntry &b)
+{
+  return a.GetDest () == b.GetDest ()
+         && a.GetDestNetworkMask () == b.GetDestNetworkMask ()
+         && a.GetGateway () == b.GetGateway ()
+         && a.GetInterface () == b.GetInterface ();
+}
+
+void
+Ipv4GlobalRouting::IndexRoute (RouteIndex &index, Ipv4RoutingTableEntry *route, uint64_t rank)
+{
+  NS_LOG_FUNCTION (this << &index << route << rank);
+  uint8_t address[4];
+  uint8_t mask[4];
+  GetIndexKey (route->GetDestNetwork ().Get (), address);
+  GetIndexKey (route->GetDestNetworkMask ().Get (), mask);
+  IndexedRoute indexed;
+  indexed.m_route = route;
+  indexed.m_rank = rank;
+  index.Insert (address, mask, indexed);
+}
+
+void
+Ipv4GlobalRouting::FindIndexedRoutes (const RouteIndex &index, const Ipv4RoutingTableEntry &route,
+                                      std::vector<IndexedRoute> &routes)
+{
+  NS_LOG_FUNCTION (&index << route);
+  uint8_t address[4];
+  uint8_t mask[4];
+  GetIndexKey (route.GetDestNetwork ().Get (), address);
+  GetIndexKey (route.GetDestNetworkMask ().Get (), mask);
+  routes.clear ();
+  index.Find (address, mask, routes);
+}
+
+uint64_t
+Ipv4GlobalRouting::GetRank (const RouteIndex &index, Ipv4RoutingTableEntry *route) const
+{
+  NS_LOG_FUNCTION (this << &index << route);
+  FindIndexedRoutes (index, *route, m_found);
+  for (std::vector<IndexedRoute>::const_iterator i = m_found.begin (); i != m_found.end (); i++)
+    {
+      if (i->m_route == route)
+        {
+          return i->m_rank;
+        }
+    }
+  NS_ASSERT_MSG (false, "Route " << *route << " is not indexed");
+  return 0;
+}
+
+void
+Ipv4GlobalRouting::AddRoute (std::list<Ipv4RoutingTableEntry *> &routes, RouteIndex &index,
+                             std::list<Ipv4RoutingTableEntry *>::iterator &position,
+                             const Ipv4RoutingTableEntry &route)
+{
+  NS_LOG_FUNCTION (this << &routes << &index << route);
+//
+// The ranks of the routes grow along the list, so the route is searched by
+// its prefix in the index, among the routes with a rank at least that of
+// the route at the update position.  The routes before it in the list are
+// no longer there, and are removed.
+//
+  if (position != routes.end ())
+    {
+      if (IsSameRoute (**position, route))
+        {
+          position++;
+          return;
+        }
+      uint64_t rank = GetRank (index, *position);
+      FindIndexedRoutes (index, route, m_found);
+      Ipv4RoutingTableEntry *match = 0;
+      uint64_t matchRank = 0;
+      for (std::vector<IndexedRoute>::const_iterator i = m_found.begin (); i != m_found.end (); i++)
+        {
+          if (i->m_rank >= rank && (match == 0 || i->m_rank < matchRank)
+              && IsSameRoute (*i->m_route, route))
+            {
+              match = i->m_route;
+              matchRank = i->m_rank;
+            }
+        }
+      if (match != 0)
+        {
+          while (*position != match)
+            {
+              UnindexRoute (index, *position);
+              delete *position;
+              position = routes.erase (position);
+            }
+          position++;
+          return;
+        }
+//
+// A new route is inserted at the update position, with a rank between
+// those of its neighbors.  The ranks of consecutive routes are RANK_STEP
+// apart when added at the end; once there is no rank left between two
+// routes, the routes from the update position on are removed, and added
+// again after the new one.
+//
+      uint64_t previous = 0;
+      if (position != routes.begin ())
+        {
+          std::list<Ipv4RoutingTableEntry *>::iterator i = position;
+          previous = GetRank (index, *--i);
+        }
+      if (rank - previous > 1)
+        {
+          Ipv4RoutingTableEntry *entry = new Ipv4RoutingTableEntry (route);
+          routes.insert (position, entry);
+          IndexRoute (index, entry, previous + (rank - previous) / 2);
+          return;
+        }
+      RemoveRoutes (routes, index, position);
+    }
+  Ipv4RoutingTableEntry *entry = new Ipv4RoutingTableEntry (route);
+  routes.push_back (entry);
+  IndexRoute (index, entry, m_nextRank);
+  m_nextRank += RANK_STEP;
+}
+
+void
+Ipv4GlobalRouting::RemoveRoutes (std::list<Ipv4RoutingTableEntry *> &routes, RouteIndex &index,
+                                 std::list<Ipv4RoutingTableEntry *>::iterator &position)
+{
+  NS_LOG_FUNCTION (&routes << &index);
+  while (position != routes.end ())
+    {
+      UnindexRoute (index, *position);
+      delete *position;
+      position = routes.erase (position);
+    }
+}
+
+void
+Ipv4GlobalRouting::UnindexRoute (RouteIndex &index, Ipv4RoutingTableEntry *route)
+{
+  NS_LOG_FUNCTION (&index << route);
+  uint8_t address[4];
+  uint8_t mask[4];
+  GetIndexKey (route->GetDestNetwork ().Get (), address);
+  GetIndexKey (route->GetDestNetworkMask ().Get (), mask);
+  IndexedRoute indexed;
+  indexed.m_route = route;
+  indexed.m_rank = 0;
+  bool found = index.Remove (address, mask, indexed);
+  NS_ASSERT_MSG (found, "Route " << *route << " is not indexed");
+  NS_UNUSED (found);
+}
+
+void
+Ipv4GlobalRouting::LookupIndex (const RouteIndex &index, Ipv4Address dest, Ptr<NetDevice> oif,
+                                std::vector<Ipv4RoutingTableEntry *> &routes) const
+{
+  NS_LOG_FUNCTION (this << &index << dest << oif);
+  uint8_t key[4];
+  GetIndexKey (dest.Get (), key);
+  m_found.clear ();
+  index.Lookup (key, m_found);
+
+  // Keep the routes on the requested interface, in the order of their list.
+  // The routes of a prefix are usually in that order already, so the
+  // insertion sort only moves routes when several prefixes match.
+  uint32_t n = 0;
+  for (uint32_t i = 0; i < m_found.size (); i++)
+    {
+      if (oif != 0 && oif != m_ipv4->GetNetDevice (m_found[i].m_route->GetInterface ()))
+        {
+          NS_LOG_LOGIC ("Not on requested interface, skipping");
+          continue;
+        }
+      IndexedRoute found = m_found[i];
+      uint32_t j = n++;
+      for (; j > 0 && m_found[j - 1].m_rank > found.m_rank; j--)
+        {
+          m_found[j] = m_found[j - 1];
+        }
+      m_found[j] = found;
+    }
+  for (uint32_t i = 0; i < n; i++)
+    {
+      routes.push_back (m_found[i].m_route);
+    }
+}
+
 Ptr<Ipv4Route>
 Ipv4GlobalRouting::LookupGlobal (Ipv4Address dest, Ptr<NetDevice> oif)
 {
@@ -143,75 +348,25 @@ Ipv4GlobalRouting::LookupGlobal (Ipv4Address dest, Ptr<NetDevice> oif)
   NS_LOG_LOGIC ("Looking for route for destination " << dest);
   Ptr<Ipv4Route> rtentry = 0;
   // store all available routes that bring packets to their destination
-  typedef std::vector<Ipv4RoutingTableEntry*> RouteVec_t;
-  RouteVec_t allRoutes;
+  std::vector<Ipv4RoutingTableEntry *> &allRoutes = m_lookup;
+  allRoutes.clear ();
 
   NS_LOG_LOGIC ("Number of m_hostRoutes = " << m_hostRoutes.size ());
-  for (HostRoutesCI i = m_hostRoutes.begin (); 
-       i != m_hostRoutes.end (); 
-       i++) 
-    {
-      NS_ASSERT ((*i)->IsHost ());
-      if ((*i)->GetDest ().IsEqual (dest)) 
-        {
-          if (oif != 0)
-            {
-              if (oif != m_ipv4->GetNetDevice ((*i)->GetInterface ()))
-                {
-                  NS_LOG_LOGIC ("Not on requested interface, skipping");
-                  continue;
-                }
-            }
-          allRoutes.push_back (*i);
-          NS_LOG_LOGIC (allRoutes.size () << "Found global host route" << *i); 
-        }
-    }
+  LookupIndex (m_hostIndex, dest, oif, allRoutes);
+  NS_LOG_LOGIC ("Found " << allRoutes.size () << " global host routes");
   if (allRoutes.size () == 0) // if no host route is found
     {
       NS_LOG_LOGIC ("Number of m_networkRoutes" << m_networkRoutes.size ());
-      for (NetworkRoutesI j = m_networkRoutes.begin (); 
-           j != m_networkRoutes.end (); 
-           j++) 
-        {
-          Ipv4Mask mask = (*j)->GetDestNetworkMask ();
-          Ipv4Address entry = (*j)->GetDestNetwork ();
-          if (mask.IsMatch (dest, entry)) 
-            {
-              if (oif != 0)
-                {
-                  if (oif != m_ipv4->GetNetDevice ((*j)->GetInterface ()))
-                    {
-                      NS_LOG_LOGIC ("Not on requested interface, skipping");
-                      continue;
-                    }
-                }
-              allRoutes.push_back (*j);
-              NS_LOG_LOGIC (allRoutes.size () << "Found global network route" << *j);
-            }
-        }
+      LookupIndex (m_networkIndex, dest, oif, allRoutes);
+      NS_LOG_LOGIC ("Found " << allRoutes.size () << " global network routes");
     }
   if (allRoutes.size () == 0)  // consider external if no host/network found
     {
-      for (ASExternalRoutesI k = m_ASexternalRoutes.begin ();
-           k != m_ASexternalRoutes.end ();
-           k++)
+      LookupIndex (m_ASexternalIndex, dest, oif, allRoutes);
+      if (allRoutes.size () > 1)
         {
-          Ipv4Mask mask = (*k)->GetDestNetworkMask ();
-          Ipv4Address entry = (*k)->GetDestNetwork ();
-          if (mask.IsMatch (dest, entry))
-            {
-              NS_LOG_LOGIC ("Found external route" << *k);
-              if (oif != 0)
-                {
-                  if (oif != m_ipv4->GetNetDevice ((*k)->GetInterface ()))
-                    {
-                      NS_LOG_LOGIC ("Not on requested interface, skipping");
-                      continue;
-                    }
-                }
-              allRoutes.push_back (*k);
-              break;
-            }
+          // only the first external route matching is used
+          allRoutes.resize (1);
         }
     }
   if (allRoutes.size () > 0 ) // if route(s) is found
@@ -309,6 +464,7 @@ void
 Ipv4GlobalRouting::RemoveRoute (uint32_t index)
 {
   NS_LOG_FUNCTION (this << index);
+  NS_ASSERT_MSG (!m_updating, "Routes can not be removed while being updated");
   if (index < m_hostRoutes.size ())
     {
       uint32_t tmp = 0;
@@ -319,6 +475,7 @@ Ipv4GlobalRouting::RemoveRoute (uint32_t index)
           if (tmp  == index)
             {
               NS_LOG_LOGIC ("Removing route " << index << "; size = " << m_hostRoutes.size ());
+              UnindexRoute (m_hostIndex, *i);
               delete *i;
               m_hostRoutes.erase (i);
               NS_LOG_LOGIC ("Done removing host route " << index << "; host route remaining size = " << m_hostRoutes.size ());
@@ -336,6 +493,7 @@ Ipv4GlobalRouting::RemoveRoute (uint32_t index)
       if (tmp == index)
         {
           NS_LOG_LOGIC ("Removing route " << index << "; size = " << m_networkRoutes.size ());
+          UnindexRoute (m_networkIndex, *j);
           delete *j;
           m_networkRoutes.erase (j);
           NS_LOG_LOGIC ("Done removing network route " << index << "; network route remaining size = " << m_networkRoutes.size ());
@@ -352,6 +510,7 @@ Ipv4GlobalRouting::RemoveRoute (uint32_t index)
       if (tmp == index)
         {
           NS_LOG_LOGIC ("Removing route " << index << "; size = " << m_ASexternalRoutes.size ());
+          UnindexRoute (m_ASexternalIndex, *k);
           delete *k;
           m_ASexternalRoutes.erase (k);
           NS_LOG_LOGIC ("Done removing network route " << index << "; network route remaining size = " << m_networkRoutes.size ());
@@ -362,6 +521,28 @@ Ipv4GlobalRouting::RemoveRoute (uint32_t index)
   NS_ASSERT (false);
 }
 
+void
+Ipv4GlobalRouting::BeginRouteUpdate (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT_MSG (!m_updating, "Routes already being updated");
+  m_updating = true;
+  m_hostUpdate = m_hostRoutes.begin ();
+  m_networkUpdate = m_networkRoutes.begin ();
+  m_ASexternalUpdate = m_ASexternalRoutes.begin ();
+}
+
+void
+Ipv4GlobalRouting::EndRouteUpdate (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT_MSG (m_updating, "Routes not being updated");
+  RemoveRoutes (m_hostRoutes, m_hostIndex, m_hostUpdate);
+  RemoveRoutes (m_networkRoutes, m_networkIndex, m_networkUpdate);
+  RemoveRoutes (m_ASexternalRoutes, m_ASexternalIndex, m_ASexternalUpdate);
+  m_updating = false;
+}
+
 int64_t
 Ipv4GlobalRouting::AssignStreams (int64_t stream)
 {
@@ -392,6 +573,9 @@ Ipv4GlobalRouting::DoDispose (void)
     {
       delete (*l);
     }
+  m_hostIndex.Clear ();
+  m_networkIndex.Clear ();
+  m_ASexternalIndex.Clear ();
 
   Ipv4RoutingProtocol::DoDispose ();
 }
@@ -537,9 +721,7 @@ Ipv4GlobalRouting::NotifyInterfaceUp (uint32_t i)
   NS_LOG_FUNCTION (this << i);
   if (m_respondToInterfaceEvents && Simulator::Now ().GetSeconds () > 0)  // avoid startup events
     {
-      GlobalRouteManager::DeleteGlobalRoutes ();
-      GlobalRouteManager::BuildGlobalRoutingDatabase ();
-      GlobalRouteManager::InitializeRoutes ();
+      GlobalRouteManager::UpdateRoutes ();
     }
 }
 
@@ -549,9 +731,7 @@ Ipv4GlobalRouting::NotifyInterfaceDown (uint32_t i)
   NS_LOG_FUNCTION (this << i);
   if (m_respondToInterfaceEvents && Simulator::Now ().GetSeconds () > 0)  // avoid startup events
     {
-      GlobalRouteManager::DeleteGlobalRoutes ();
-      GlobalRouteManager::BuildGlobalRoutingDatabase ();
-      GlobalRouteManager::InitializeRoutes ();
+      GlobalRouteManager::UpdateRoutes ();
     }
 }
 
@@ -561,9 +741,7 @@ Ipv4GlobalRouting::NotifyAddAddress (uint32_t interface, Ipv4InterfaceAddress ad
   NS_LOG_FUNCTION (this << interface << address);
   if (m_respondToInterfaceEvents && Simulator::Now ().GetSeconds () > 0)  // avoid startup events
     {
-      GlobalRouteManager::DeleteGlobalRoutes ();
-      GlobalRouteManager::BuildGlobalRoutingDatabase ();
-      GlobalRouteManager::InitializeRoutes ();
+      GlobalRouteManager::UpdateRoutes ();
     }
 }
 
@@ -573,9 +751,7 @@ Ipv4GlobalRouting::NotifyRemoveAddress (uint32_t interface, Ipv4InterfaceAddress
   NS_LOG_FUNCTION (this << interface << address);
   if (m_respondToInterfaceEvents && Simulator::Now ().GetSeconds () > 0)  // avoid startup events
     {
-      GlobalRouteManager::DeleteGlobalRoutes ();
-      GlobalRouteManager::BuildGlobalRoutingDatabase ();
-      GlobalRouteManager::InitializeRoutes ();
+      GlobalRouteManager::UpdateRoutes ();
     }
 }
 
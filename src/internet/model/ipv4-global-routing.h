@@ -21,6 +21,7 @@
 #define IPV4_GLOBAL_ROUTING_H
 
 #include <list>
+#include <vector>
 #include <stdint.h>
 #include "ns3/ipv4-address.h"
 #include "ns3/ipv4-header.h"
@@ -28,6 +29,7 @@
 #include "ns3/ipv4.h"
 #include "ns3/ipv4-routing-protocol.h"
 #include "ns3/random-variable-stream.h"
+#include "prefix-trie.h"
 
 namespace ns3 {
 
@@ -65,6 +67,10 @@ class Node;
  *
  * This class deals with Ipv4 unicast routes only.
  *
+ * The routes are kept in lists, which define their order, and indexed by
+ * destination prefix in a PrefixTrie, so that finding the routes to a
+ * destination does not depend on the size of the table.
+ *
  * \see Ipv4RoutingProtocol
  * \see GlobalRouteManager
  */
@@ -218,6 +224,27 @@ public:
    */
   void RemoveRoute (uint32_t i);
 
+  /**
+   * \brief Start replacing the routes by those added until EndRouteUpdate ().
+   *
+   * The global route manager calls this before computing the routes of the
+   * node again.  The routes then added are matched, in order, with the
+   * current ones (see AddRoute): the routes which did not change are kept as
+   * they are, and the others are removed or added.  The table ends up the
+   * same as if it had been emptied beforehand.
+   *
+   * \see Ipv4GlobalRouting::EndRouteUpdate
+   */
+  void BeginRouteUpdate (void);
+
+  /**
+   * \brief Remove the routes which were not added again since
+   * BeginRouteUpdate ().
+   *
+   * \see Ipv4GlobalRouting::BeginRouteUpdate
+   */
+  void EndRouteUpdate (void);
+
   /**
    * Assign a fixed random variable stream number to the random variables
    * used by this model.  Return the number of streams (possibly zero) that
@@ -260,6 +287,94 @@ private:
   /// iterator of container of Ipv4RoutingTableEntry (routes to external AS)
   typedef std::list<Ipv4RoutingTableEntry *>::iterator ASExternalRoutesI;
 
+  /// Route in a prefix index
+  struct IndexedRoute
+  {
+    Ipv4RoutingTableEntry *m_route; //!< The route
+    uint64_t m_rank;                //!< Rank of the route in its list
+    /**
+     * \param other another route
+     * \return true if both are the same route
+     */
+    bool operator== (const IndexedRoute &other) const
+    {
+      return m_route == other.m_route;
+    }
+  };
+
+  /// Index of routes by destination prefix
+  typedef PrefixTrie<IndexedRoute, 4> RouteIndex;
+
+  /// Difference between the ranks of two routes added in a row at the end of a list
+  static const uint64_t RANK_STEP = uint64_t (1) << 24;
+
+  /**
+   * \brief Add a route to a prefix index.
+   * \param index the index
+   * \param route the route
+   * \param rank the rank of the route, between those of its neighbors in its list
+   */
+  void IndexRoute (RouteIndex &index, Ipv4RoutingTableEntry *route, uint64_t rank);
+
+  /**
+   * \brief Find the indexed routes to the prefix of a route.
+   * \param index the index
+   * \param route the route
+   * \param routes receives the routes to the same prefix
+   */
+  static void FindIndexedRoutes (const RouteIndex &index, const Ipv4RoutingTableEntry &route,
+                                 std::vector<IndexedRoute> &routes);
+
+  /**
+   * \param index the index
+   * \param route a route of the index
+   * \return the rank of the route
+   */
+  uint64_t GetRank (const RouteIndex &index, Ipv4RoutingTableEntry *route) const;
+
+  /**
+   * \brief Remove a route from a prefix index.
+   * \param index the index
+   * \param route the route
+   */
+  static void UnindexRoute (RouteIndex &index, Ipv4RoutingTableEntry *route);
+
+  /**
+   * \brief Add a route at the end of a list, or keep the current one.
+   *
+   * During an update, the route is searched among the routes from the
+   * update position of the list on, through the index.  If it is found,
+   * the routes skipped before it are removed, and the update position moves
+   * past it.  Otherwise the route is inserted at the update position.
+   *
+   * \param routes the list
+   * \param index the index of the list
+   * \param position the update position in the list, or the end of the list
+   * \param route the route
+   */
+  void AddRoute (std::list<Ipv4RoutingTableEntry *> &routes, RouteIndex &index,
+                 std::list<Ipv4RoutingTableEntry *>::iterator &position,
+                 const Ipv4RoutingTableEntry &route);
+
+  /**
+   * \brief Remove the routes of a list from a position on.
+   * \param routes the list
+   * \param index the index of the list
+   * \param position the first route to remove; set to the end of the list
+   */
+  static void RemoveRoutes (std::list<Ipv4RoutingTableEntry *> &routes, RouteIndex &index,
+                            std::list<Ipv4RoutingTableEntry *>::iterator &position);
+
+  /**
+   * \brief Find the indexed routes to a destination, in list order.
+   * \param index the index
+   * \param dest the destination
+   * \param oif output device, or 0 for any device
+   * \param routes the vector the routes are appended to
+   */
+  void LookupIndex (const RouteIndex &index, Ipv4Address dest, Ptr<NetDevice> oif,
+                    std::vector<Ipv4RoutingTableEntry *> &routes) const;
+
   /**
    * \brief Lookup in the forwarding table for destination.
    * \param dest destination address
@@ -272,6 +387,18 @@ private:
   NetworkRoutes m_networkRoutes;       //!< Routes to networks
   ASExternalRoutes m_ASexternalRoutes; //!< External routes imported
 
+  RouteIndex m_hostIndex;              //!< Index of m_hostRoutes
+  RouteIndex m_networkIndex;           //!< Index of m_networkRoutes
+  RouteIndex m_ASexternalIndex;        //!< Index of m_ASexternalRoutes
+  uint64_t m_nextRank;                 //!< Rank of the next route added at the end of a list
+  mutable std::vector<IndexedRoute> m_found; //!< Routes found in an index, kept to reuse its memory
+  std::vector<Ipv4RoutingTableEntry *> m_lookup; //!< Routes found by LookupGlobal (), kept to reuse its memory
+
+  bool m_updating;                     //!< True between BeginRouteUpdate () and EndRouteUpdate ()
+  HostRoutesI m_hostUpdate;            //!< Next route of m_hostRoutes to compare during an update
+  NetworkRoutesI m_networkUpdate;      //!< Next route of m_networkRoutes to compare during an update
+  ASExternalRoutesI m_ASexternalUpdate; //!< Next route of m_ASexternalRoutes to compare during an update
+
   Ptr<Ipv4> m_ipv4; //!< associated IPv4 instance
 };
 
@@ -31,6 +31,7 @@
 #include "ns3/simulator.h"
 #include "ns3/ipv4-route.h"
 #include "ns3/output-stream-wrapper.h"
+#include "ns3/unused.h"
 #include "ipv4-static-routing.h"
 #include "ipv4-routing-table-entry.h"
 
@@ -54,7 +55,8 @@ Ipv4StaticRouting::GetTypeId (void)
 }
 
 Ipv4StaticRouting::Ipv4StaticRouting () 
-  : m_ipv4 (0)
+  : m_nextRank (0),
+    m_ipv4 (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -73,6 +75,7 @@ Ipv4StaticRouting::AddNetworkRouteTo (Ipv4Address network,
                                                         nextHop,
                                                         interface);
   m_networkRoutes.push_back (make_pair (route,metric));
+  IndexRoute (route, metric);
 }
 
 void 
@@ -87,6 +90,7 @@ Ipv4StaticRouting::AddNetworkRouteTo (Ipv4Address network,
                                                         networkMask,
                                                         interface);
   m_networkRoutes.push_back (make_pair (route,metric));
+  IndexRoute (route, metric);
 }
 
 void 
@@ -144,6 +148,7 @@ Ipv4StaticRouting::SetDefaultMulticastRoute (uint32_t outputInterface)
                                                         networkMask,
                                                         outputInterface);
   m_networkRoutes.push_back (make_pair (route,0));
+  IndexRoute (route, 0);
 }
 
 uint32_t 
@@ -219,6 +224,38 @@ Ipv4StaticRouting::RemoveMulticastRoute (uint32_t index)
     }
 }
 
+void
+Ipv4StaticRouting::IndexRoute (Ipv4RoutingTableEntry *route, uint32_t metric)
+{
+  NS_LOG_FUNCTION (this << route << metric);
+  uint8_t address[4];
+  uint8_t mask[4];
+  route->GetDestNetwork ().Serialize (address);
+  Ipv4Address (route->GetDestNetworkMask ().Get ()).Serialize (mask);
+  IndexedRoute indexed;
+  indexed.m_route = route;
+  indexed.m_metric = metric;
+  indexed.m_rank = m_nextRank++;
+  m_networkIndex.Insert (address, mask, indexed);
+}
+
+void
+Ipv4StaticRouting::UnindexRoute (Ipv4RoutingTableEntry *route)
+{
+  NS_LOG_FUNCTION (this << route);
+  uint8_t address[4];
+  uint8_t mask[4];
+  route->GetDestNetwork ().Serialize (address);
+  Ipv4Address (route->GetDestNetworkMask ().Get ()).Serialize (mask);
+  IndexedRoute indexed;
+  indexed.m_route = route;
+  indexed.m_metric = 0;
+  indexed.m_rank = 0;
+  bool found = m_networkIndex.Remove (address, mask, indexed);
+  NS_ASSERT_MSG (found, "Route " << *route << " is not indexed");
+  NS_UNUSED (found);
+}
+
 Ptr<Ipv4Route>
 Ipv4StaticRouting::LookupStatic (Ipv4Address dest, Ptr<NetDevice> oif)
 {
@@ -240,55 +277,63 @@ Ipv4StaticRouting::LookupStatic (Ipv4Address dest, Ptr<NetDevice> oif)
     }
 
 
-  for (NetworkRoutesI i = m_networkRoutes.begin (); 
-       i != m_networkRoutes.end (); 
+  uint8_t key[4];
+  dest.Serialize (key);
+  std::vector<IndexedRoute> matches;
+  m_networkIndex.Lookup (key, matches);
+
+  const IndexedRoute *best = 0;
+  for (std::vector<IndexedRoute>::const_iterator i = matches.begin (); 
+       i != matches.end (); 
        i++) 
     {
-      Ipv4RoutingTableEntry *j=i->first;
-      uint32_t metric =i->second;
-      Ipv4Mask mask = (j)->GetDestNetworkMask ();
-      uint16_t masklen = mask.GetPrefixLength ();
-      Ipv4Address entry = (j)->GetDestNetwork ();
-      NS_LOG_LOGIC ("Searching for route to " << dest << ", checking against route to " << entry << "/" << masklen);
-      if (mask.IsMatch (dest, entry)) 
+      Ipv4RoutingTableEntry *j = i->m_route;
+      uint32_t metric = i->m_metric;
+      uint16_t masklen = j->GetDestNetworkMask ().GetPrefixLength ();
+      NS_LOG_LOGIC ("Found global network route " << j << ", mask length " << masklen << ", metric " << metric);
+      if (oif != 0)
         {
-          NS_LOG_LOGIC ("Found global network route " << j << ", mask length " << masklen << ", metric " << metric);
-          if (oif != 0)
+          if (oif != m_ipv4->GetNetDevice (j->GetInterface ()))
             {
-              if (oif != m_ipv4->GetNetDevice (j->GetInterface ()))
-                {
-                  NS_LOG_LOGIC ("Not on requested interface, skipping");
-                  continue;
-                }
+              NS_LOG_LOGIC ("Not on requested interface, skipping");
+              continue;
             }
+        }
+      if (best != 0)
+        {
           if (masklen < longest_mask) // Not interested if got shorter mask
             {
               NS_LOG_LOGIC ("Previous match longer, skipping");
               continue;
             }
-          if (masklen > longest_mask) // Reset metric if longer masklen
+          // With equal masks, the first host route in the table is used;
+          // otherwise the last one with the lowest metric
+          if (masklen == longest_mask && masklen == 32 && i->m_rank > best->m_rank)
             {
-              shortest_metric = 0xffffffff;
+              NS_LOG_LOGIC ("Equal mask length, but previous host route first, skipping");
+              continue;
             }
-          longest_mask = masklen;
-          if (metric > shortest_metric)
+          if (masklen == longest_mask && masklen != 32 
+              && (metric > shortest_metric || (metric == shortest_metric && i->m_rank < best->m_rank)))
             {
               NS_LOG_LOGIC ("Equal mask length, but previous metric shorter, skipping");
               continue;
             }
-          shortest_metric = metric;
-          Ipv4RoutingTableEntry* route = (j);
-          uint32_t interfaceIdx = route->GetInterface ();
-          rtentry = Create<Ipv4Route> ();
-          rtentry->SetDestination (route->GetDest ());
-          rtentry->SetSource (m_ipv4->SourceAddressSelection (interfaceIdx, route->GetDest ()));
-          rtentry->SetGateway (route->GetGateway ());
-          rtentry->SetOutputDevice (m_ipv4->GetNetDevice (interfaceIdx));
-          if (masklen == 32)
-            {
-              break;
-            }
         }
+      longest_mask = masklen;
+      shortest_metric = metric;
+      best = &(*i);
+    }
+
+  if (best != 0)
+    {
+      Ipv4RoutingTableEntry* route = best->m_route;
+      uint32_t interfaceIdx = route->GetInterface ();
+      rtentry = Create<Ipv4Route> ();
+      rtentry->SetDestination (route->GetDest ());
+      rtentry->SetSource (m_ipv4->SourceAddressSelection (interfaceIdx, route->GetDest ()));
+      rtentry->SetGateway (route->GetGateway ());
+      rtentry->SetOutputDevice (m_ipv4->GetNetDevice (interfaceIdx));
     }
   if (rtentry != 0)
     {
@@ -447,6 +492,7 @@ Ipv4StaticRouting::RemoveRoute (uint32_t index)
     {
       if (tmp == index)
         {
+          UnindexRoute (j->first);
           delete j->first;
           m_networkRoutes.erase (j);
           return;
@@ -575,6 +621,7 @@ Ipv4StaticRouting::DoDispose (void)
     {
       delete (j->first);
     }
+  m_networkIndex.Clear ();
   for (MulticastRoutesI i = m_multicastRoutes.begin (); 
        i != m_multicastRoutes.end (); 
        i = m_multicastRoutes.erase (i)) 
@@ -613,6 +660,7 @@ Ipv4StaticRouting::NotifyInterfaceDown (uint32_t i)
     {
       if (it->first->GetInterface () == i)
         {
+          UnindexRoute (it->first);
           delete it->first;
           it = m_networkRoutes.erase (it);
         }
@@ -660,6 +708,7 @@ Ipv4StaticRouting::NotifyRemoveAddress (uint32_t interface, Ipv4InterfaceAddress
           && it->first->GetDestNetwork () == networkAddress
           && it->first->GetDestNetworkMask () == networkMask)
         {
+          UnindexRoute (it->first);
           delete it->first;
           it = m_networkRoutes.erase (it);
         }
@@ -31,6 +31,7 @@
 #include "ns3/ptr.h"
 #include "ns3/ipv4.h"
 #include "ns3/ipv4-routing-protocol.h"
+#include "prefix-trie.h"
 
 namespace ns3 {
 
@@ -53,6 +54,9 @@ class Node;
  * This particular protocol is designed to be inserted into an 
  * Ipv4ListRouting protocol but can be used also as a standalone
  * protocol.
+ *
+ * The unicast routes are indexed by destination prefix in a PrefixTrie,
+ * so that a lookup only considers the routes matching the destination.
  * 
  * The Ipv4StaticRouting class inherits from the abstract base class 
  * Ipv4RoutingProtocol that defines the interface methods that a routing 
@@ -395,6 +399,35 @@ private:
   /// Iterator for container for the multicast routes
   typedef std::list<Ipv4MulticastRoutingTableEntry *>::iterator MulticastRoutesI;
 
+  /// Route in the prefix index
+  struct IndexedRoute
+  {
+    Ipv4RoutingTableEntry *m_route; //!< The route
+    uint32_t m_metric;              //!< Metric of the route
+    uint64_t m_rank;                //!< Rank of the route in m_networkRoutes
+    /**
+     * \param other another route
+     * \return true if both are the same route
+     */
+    bool operator== (const IndexedRoute &other) const
+    {
+      return m_route == other.m_route;
+    }
+  };
+
+  /**
+   * \brief Add a route to the prefix index.
+   * \param route the route, last in m_networkRoutes
+   * \param metric metric of the route
+   */
+  void IndexRoute (Ipv4RoutingTableEntry *route, uint32_t metric);
+
+  /**
+   * \brief Remove a route from the prefix index.
+   * \param route the route
+   */
+  void UnindexRoute (Ipv4RoutingTableEntry *route);
+
   /**
    * \brief Lookup in the forwarding table for destination.
    * \param dest destination address
@@ -418,6 +451,16 @@ private:
    */
   NetworkRoutes m_networkRoutes;
 
+  /**
+   * \brief the network routes, by destination prefix.
+   */
+  PrefixTrie<IndexedRoute, 4> m_networkIndex;
+
+  /**
+   * \brief the rank of the next network route.
+   */
+  uint64_t m_nextRank;
+
   /**
    * \brief the forwarding table for multicast.
    */
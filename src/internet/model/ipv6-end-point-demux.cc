@@ -26,10 +26,40 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("Ipv6EndPointDemux");
 
+Ipv6EndPointDemux::FourTuple::FourTuple (Ipv6Address localAddress, uint16_t localPort,
+                                         Ipv6Address peerAddress, uint16_t peerPort)
+  : m_localAddress (localAddress),
+    m_peerAddress (peerAddress),
+    m_localPort (localPort),
+    m_peerPort (peerPort)
+{
+}
+
+bool Ipv6EndPointDemux::FourTuple::operator== (const FourTuple &other) const
+{
+  return m_localPort == other.m_localPort
+         && m_peerPort == other.m_peerPort
+         && m_localAddress == other.m_localAddress
+         && m_peerAddress == other.m_peerAddress;
+}
+
+std::size_t Ipv6EndPointDemux::FourTupleHash::operator() (const FourTuple &tuple) const
+{
+  Ipv6AddressHash addressHash;
+  uint64_t h = addressHash (tuple.m_localAddress);
+  h = h * 0x100000001b3ULL ^ addressHash (tuple.m_peerAddress);
+  h ^= ((static_cast<uint64_t> (tuple.m_peerPort) << 16) | tuple.m_localPort) * 0x9e3779b97f4a7c15ULL;
+  h ^= h >> 31;
+  h *= 0xbf58476d1ce4e5b9ULL;
+  h ^= h >> 29;
+  return static_cast<std::size_t> (h);
+}
+
 Ipv6EndPointDemux::Ipv6EndPointDemux ()
   : m_ephemeral (49152),
     m_portFirst (49152),
-    m_portLast (65535)
+    m_portLast (65535),
+    m_sequence (0)
 {
   NS_LOG_FUNCTION_NOARGS ();
 }
@@ -40,31 +70,127 @@ Ipv6EndPointDemux::~Ipv6EndPointDemux ()
   for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
     {
       Ipv6EndPoint *endPoint = *i;
+      endPoint->m_demux = 0;
       delete endPoint;
     }
   m_endPoints.clear ();
+  m_ports.clear ();
+  m_wildcards.clear ();
+  m_connected.clear ();
 }
 
-bool Ipv6EndPointDemux::LookupPortLocal (uint16_t port)
+bool Ipv6EndPointDemux::IsConnected (Ipv6EndPoint *endPoint)
 {
-  NS_LOG_FUNCTION (this << port);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  return endPoint->GetLocalAddress () != Ipv6Address::GetAny ()
+         && endPoint->GetPeerAddress () != Ipv6Address::GetAny ()
+         && endPoint->GetPeerPort () != 0;
+}
+
+void Ipv6EndPointDemux::Insert (Ipv6EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  endPoint->m_sequence = m_sequence++;
+  endPoint->m_endPointsIt = m_endPoints.insert (m_endPoints.end (), endPoint);
+  endPoint->m_demux = this;
+  IndexPort (endPoint);
+  Index (endPoint);
+  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
+}
+
+Ipv6EndPointDemux::EndPointsI Ipv6EndPointDemux::InsertInOrder (EndPoints &endPoints, Ipv6EndPoint *endPoint)
+{
+  EndPointsI i = endPoints.end ();
+  while (i != endPoints.begin ())
     {
-      if ((*i)->GetLocalPort  () == port)
+      EndPointsI previous = i;
+      previous--;
+      if ((*previous)->m_sequence < endPoint->m_sequence)
         {
-          return true;
+          break;
         }
+      i = previous;
     }
-  return false;
+  return endPoints.insert (i, endPoint);
+}
+
+void Ipv6EndPointDemux::IndexPort (Ipv6EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  endPoint->m_portIt = InsertInOrder (m_ports[endPoint->GetLocalPort ()], endPoint);
+}
+
+void Ipv6EndPointDemux::UnindexPort (Ipv6EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  PortEndPoints::iterator it = m_ports.find (endPoint->GetLocalPort ());
+  NS_ASSERT (it != m_ports.end ());
+  it->second.erase (endPoint->m_portIt);
+  if (it->second.empty ())
+    {
+      m_ports.erase (it);
+    }
+}
+
+void Ipv6EndPointDemux::Index (Ipv6EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  if (IsConnected (endPoint))
+    {
+      FourTuple tuple (endPoint->GetLocalAddress (), endPoint->GetLocalPort (),
+                       endPoint->GetPeerAddress (), endPoint->GetPeerPort ());
+      m_connected.insert (std::make_pair (tuple, endPoint));
+      return;
+    }
+  endPoint->m_wildcardIt = InsertInOrder (m_wildcards[endPoint->GetLocalPort ()], endPoint);
+}
+
+void Ipv6EndPointDemux::Unindex (Ipv6EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  if (IsConnected (endPoint))
+    {
+      FourTuple tuple (endPoint->GetLocalAddress (), endPoint->GetLocalPort (),
+                       endPoint->GetPeerAddress (), endPoint->GetPeerPort ());
+      std::pair<ConnectedEndPoints::iterator, ConnectedEndPoints::iterator> range;
+      range = m_connected.equal_range (tuple);
+      for (ConnectedEndPoints::iterator i = range.first; i != range.second; i++)
+        {
+          if (i->second == endPoint)
+            {
+              m_connected.erase (i);
+              return;
+            }
+        }
+      NS_ASSERT_MSG (false, "Connected end point not indexed");
+      return;
+    }
+
+  PortEndPoints::iterator it = m_wildcards.find (endPoint->GetLocalPort ());
+  NS_ASSERT (it != m_wildcards.end ());
+  it->second.erase (endPoint->m_wildcardIt);
+  if (it->second.empty ())
+    {
+      m_wildcards.erase (it);
+    }
+}
+
+bool Ipv6EndPointDemux::LookupPortLocal (uint16_t port)
+{
+  NS_LOG_FUNCTION (this << port);
+  return m_ports.find (port) != m_ports.end ();
 }
 
 bool Ipv6EndPointDemux::LookupLocal (Ipv6Address addr, uint16_t port)
 {
   NS_LOG_FUNCTION (this << addr << port);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  PortEndPoints::iterator it = m_ports.find (port);
+  if (it == m_ports.end ())
     {
-      if ((*i)->GetLocalPort () == port
-          && (*i)->GetLocalAddress () == addr)
+      return false;
+    }
+  for (EndPointsI i = it->second.begin (); i != it->second.end (); i++)
+    {
+      if ((*i)->GetLocalAddress () == addr)
         {
           return true;
         }
@@ -82,8 +208,7 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate ()
       return 0;
     }
   Ipv6EndPoint *endPoint = new Ipv6EndPoint (Ipv6Address::GetAny (), port);
-  m_endPoints.push_back (endPoint);
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
+  Insert (endPoint);
   return endPoint;
 }
 
@@ -97,8 +222,7 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate (Ipv6Address address)
       return 0;
     }
   Ipv6EndPoint *endPoint = new Ipv6EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
+  Insert (endPoint);
   return endPoint;
 }
 
@@ -118,8 +242,7 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate (Ipv6Address address, uint16_t port)
       return 0;
     }
   Ipv6EndPoint *endPoint = new Ipv6EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
+  Insert (endPoint);
   return endPoint;
 }
 
@@ -127,39 +250,53 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate (Ipv6Address localAddress, uint16_t lo
                                            Ipv6Address peerAddress, uint16_t peerPort)
 {
   NS_LOG_FUNCTION (this << localAddress << localPort << peerAddress << peerPort);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  Ipv6EndPoint *endPoint = new Ipv6EndPoint (localAddress, localPort);
+  endPoint->SetPeer (peerAddress, peerPort);
+
+  bool duplicate = false;
+  if (IsConnected (endPoint))
     {
-      if ((*i)->GetLocalPort () == localPort
-          && (*i)->GetLocalAddress () == localAddress
-          && (*i)->GetPeerPort () == peerPort
-          && (*i)->GetPeerAddress () == peerAddress)
+      FourTuple tuple (localAddress, localPort, peerAddress, peerPort);
+      duplicate = m_connected.find (tuple) != m_connected.end ();
+    }
+  else
+    {
+      PortEndPoints::iterator it = m_wildcards.find (localPort);
+      if (it != m_wildcards.end ())
         {
-          NS_LOG_WARN ("No way we can allocate this end-point.");
-          /* no way we can allocate this end-point. */
-          return 0;
+          for (EndPointsI i = it->second.begin (); i != it->second.end (); i++)
+            {
+              if ((*i)->GetLocalAddress () == localAddress
+                  && (*i)->GetPeerPort () == peerPort
+                  && (*i)->GetPeerAddress () == peerAddress)
+                {
+                  duplicate = true;
+                  break;
+                }
+            }
         }
     }
-  Ipv6EndPoint *endPoint = new Ipv6EndPoint (localAddress, localPort);
-  endPoint->SetPeer (peerAddress, peerPort);
-  m_endPoints.push_back (endPoint);
-
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
+  if (duplicate)
+    {
+      NS_LOG_WARN ("No way we can allocate this end-point.");
+      /* no way we can allocate this end-point. */
+      delete endPoint;
+      return 0;
+    }
 
+  Insert (endPoint);
   return endPoint;
 }
 
 void Ipv6EndPointDemux::DeAllocate (Ipv6EndPoint *endPoint)
 {
   NS_LOG_FUNCTION_NOARGS ();
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
-    {
-      if (*i == endPoint)
-        {
-          delete endPoint;
-          m_endPoints.erase (i);
-          break;
-        }
-    }
+  NS_ASSERT (endPoint->m_demux == this);
+  Unindex (endPoint);
+  UnindexPort (endPoint);
+  m_endPoints.erase (endPoint->m_endPointsIt);
+  endPoint->m_demux = 0;
+  delete endPoint;
 }
 
 /*
@@ -173,122 +310,164 @@ Ipv6EndPointDemux::EndPoints Ipv6EndPointDemux::Lookup (Ipv6Address daddr, uint1
 {
   NS_LOG_FUNCTION (this << daddr << dport << saddr << sport << incomingInterface);
 
-  EndPoints retval1; /* Matches exact on local port, wildcards on others */
-  EndPoints retval2; /* Matches exact on local port/adder, wildcards on others */
-  EndPoints retval3; /* Matches all but local address */
-  EndPoints retval4; /* Exact match on all 4 */
+  /* retval[0]: Matches exact on local port, wildcards on others
+   * retval[1]: Matches exact on local port/adder, wildcards on others
+   * retval[2]: Matches all but local address
+   * retval[3]: Exact match on all 4
+   */
+  EndPoints retval[4];
 
   NS_LOG_DEBUG ("Looking up endpoint for destination address " << daddr);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  const EndPoints *candidates = 0;
+  PortEndPoints::const_iterator it;
+  FourTuple tuple (daddr, dport, saddr, sport);
+  if (m_connected.count (tuple) <= 1)
     {
-      Ipv6EndPoint* endP = *i;
-
-      NS_LOG_DEBUG ("Looking at endpoint dport=" << endP->GetLocalPort ()
-                                                 << " daddr=" << endP->GetLocalAddress ()
-                                                 << " sport=" << endP->GetPeerPort ()
-                                                 << " saddr=" << endP->GetPeerAddress ());
-
-      if (!endP->IsRxEnabled ())
+      /* A connected end point can only be an exact match on all 4; if
+         there is one, no other end point can be a better match. */
+      ConnectedEndPoints::const_iterator connected = m_connected.find (tuple);
+      if (connected != m_connected.end ())
         {
-          NS_LOG_LOGIC ("Skipping endpoint " << &endP
-                        << " because endpoint can not receive packets");
-          continue;
+          Match (connected->second, daddr, dport, saddr, sport, incomingInterface, retval);
+          if (!retval[3].empty ())
+            {
+              return retval[3];
+            }
         }
-
-      if (endP->GetLocalPort () != dport)
+      it = m_wildcards.find (dport);
+      if (it != m_wildcards.end ())
         {
-          NS_LOG_LOGIC ("Skipping endpoint " << &endP
-                                             << " because endpoint dport "
-                                             << endP->GetLocalPort ()
-                                             << " does not match packet dport " << dport);
-          continue;
+          candidates = &it->second;
+        }
+    }
+  else
+    {
+      /* Several connected end points must be returned in allocation order */
+      it = m_ports.find (dport);
+      if (it != m_ports.end ())
+        {
+          candidates = &it->second;
         }
+    }
 
-      if (endP->GetBoundNetDevice ())
+  if (candidates != 0)
+    {
+      for (EndPoints::const_iterator i = candidates->begin (); i != candidates->end (); i++)
         {
-          if (!incomingInterface)
-            {
-              continue;
-            }
-          if (endP->GetBoundNetDevice () != incomingInterface->GetDevice ())
-            {
-              NS_LOG_LOGIC ("Skipping endpoint " << &endP
-                                                 << " because endpoint is bound to specific device and"
-                                                 << endP->GetBoundNetDevice ()
-                                                 << " does not match packet device " << incomingInterface->GetDevice ());
-              continue;
-            }
+          Match (*i, daddr, dport, saddr, sport, incomingInterface, retval);
         }
+    }
+
+  /* Here we find the most exact match */
+  if (!retval[3].empty ())
+    {
+      return retval[3];
+    }
+  if (!retval[2].empty ())
+    {
+      return retval[2];
+    }
+  if (!retval[1].empty ())
+    {
+      return retval[1];
+    }
+  return retval[0];  /* might be empty if no matches */
+}
 
-      /*    Ipv6Address incomingInterfaceAddr = incomingInterface->GetAddress (); */
-      NS_LOG_DEBUG ("dest addr " << daddr);
+void Ipv6EndPointDemux::Match (Ipv6EndPoint *endP, Ipv6Address daddr, uint16_t dport,
+                               Ipv6Address saddr, uint16_t sport,
+                               Ptr<Ipv6Interface> incomingInterface, EndPoints *retval)
+{
+  NS_LOG_DEBUG ("Looking at endpoint dport=" << endP->GetLocalPort ()
+                                             << " daddr=" << endP->GetLocalAddress ()
+                                             << " sport=" << endP->GetPeerPort ()
+                                             << " saddr=" << endP->GetPeerAddress ());
 
-      bool localAddressMatchesWildCard = endP->GetLocalAddress () == Ipv6Address::GetAny ();
-      bool localAddressMatchesExact = endP->GetLocalAddress () == daddr;
-      bool localAddressMatchesAllRouters = endP->GetLocalAddress () == Ipv6Address::GetAllRoutersMulticast ();
+  if (!endP->IsRxEnabled ())
+    {
+      NS_LOG_LOGIC ("Skipping endpoint " << &endP
+                    << " because endpoint can not receive packets");
+      return;
+    }
 
-      /* if no match here, keep looking */
-      if (!(localAddressMatchesExact || localAddressMatchesWildCard))
-        {
-          continue;
-        }
-      bool remotePeerMatchesExact = endP->GetPeerPort () == sport;
-      bool remotePeerMatchesWildCard = endP->GetPeerPort () == 0;
-      bool remoteAddressMatchesExact = endP->GetPeerAddress () == saddr;
-      bool remoteAddressMatchesWildCard = endP->GetPeerAddress () == Ipv6Address::GetAny ();
-
-      /* If remote does not match either with exact or wildcard,i
-         skip this one */
-      if (!(remotePeerMatchesExact || remotePeerMatchesWildCard))
+  if (endP->GetLocalPort () != dport)
+    {
+      NS_LOG_LOGIC ("Skipping endpoint " << &endP
+                                         << " because endpoint dport "
+                                         << endP->GetLocalPort ()
+                                         << " does not match packet dport " << dport);
+      return;
+    }
+
+  if (endP->GetBoundNetDevice ())
+    {
+      if (!incomingInterface)
         {
-          continue;
+          return;
         }
-      if (!(remoteAddressMatchesExact || remoteAddressMatchesWildCard))
+      if (endP->GetBoundNetDevice () != incomingInterface->GetDevice ())
         {
-          continue;
-        }
-
-      /* Now figure out which return list to add this one to */
-      if (localAddressMatchesWildCard
-          && remotePeerMatchesWildCard
-          && remoteAddressMatchesWildCard)
-        { /* Only local port matches exactly */
-          retval1.push_back (endP);
-        }
-      if ((localAddressMatchesExact || (localAddressMatchesAllRouters))
-          && remotePeerMatchesWildCard
-          && remoteAddressMatchesWildCard)
-        { /* Only local port and local address matches exactly */
-          retval2.push_back (endP);
-        }
-      if (localAddressMatchesWildCard
-          && remotePeerMatchesExact
-          && remoteAddressMatchesExact)
-        { /* All but local address */
-          retval3.push_back (endP);
-        }
-      if (localAddressMatchesExact
-          && remotePeerMatchesExact
-          && remoteAddressMatchesExact)
-        { /* All 4 match */
-          retval4.push_back (endP);
+          NS_LOG_LOGIC ("Skipping endpoint " << &endP
+                                             << " because endpoint is bound to specific device and"
+                                             << endP->GetBoundNetDevice ()
+                                             << " does not match packet device " << incomingInterface->GetDevice ());
+          return;
         }
     }
 
-  /* Here we find the most exact match */
-  if (!retval4.empty ())
+  /*    Ipv6Address incomingInterfaceAddr = incomingInterface->GetAddress (); */
+  NS_LOG_DEBUG ("dest addr " << daddr);
+
+  bool localAddressMatchesWildCard = endP->GetLocalAddress () == Ipv6Address::GetAny ();
+  bool localAddressMatchesExact = endP->GetLocalAddress () == daddr;
+  bool localAddressMatchesAllRouters = endP->GetLocalAddress () == Ipv6Address::GetAllRoutersMulticast ();
+
+  /* if no match here, keep looking */
+  if (!(localAddressMatchesExact || localAddressMatchesWildCard))
     {
-      return retval4;
+      return;
     }
-  if (!retval3.empty ())
+  bool remotePeerMatchesExact = endP->GetPeerPort () == sport;
+  bool remotePeerMatchesWildCard = endP->GetPeerPort () == 0;
+  bool remoteAddressMatchesExact = endP->GetPeerAddress () == saddr;
+  bool remoteAddressMatchesWildCard = endP->GetPeerAddress () == Ipv6Address::GetAny ();
+
+  /* If remote does not match either with exact or wildcard,i
+     skip this one */
+  if (!(remotePeerMatchesExact || remotePeerMatchesWildCard))
     {
-      return retval3;
+      return;
     }
-  if (!retval2.empty ())
+  if (!(remoteAddressMatchesExact || remoteAddressMatchesWildCard))
     {
-      return retval2;
+      return;
+    }
+
+  /* Now figure out which return list to add this one to */
+  if (localAddressMatchesWildCard
+      && remotePeerMatchesWildCard
+      && remoteAddressMatchesWildCard)
+    { /* Only local port matches exactly */
+      retval[0].push_back (endP);
+    }
+  if ((localAddressMatchesExact || (localAddressMatchesAllRouters))
+      && remotePeerMatchesWildCard
+      && remoteAddressMatchesWildCard)
+    { /* Only local port and local address matches exactly */
+      retval[1].push_back (endP);
+    }
+  if (localAddressMatchesWildCard
+      && remotePeerMatchesExact
+      && remoteAddressMatchesExact)
+    { /* All but local address */
+      retval[2].push_back (endP);
+    }
+  if (localAddressMatchesExact
+      && remotePeerMatchesExact
+      && remoteAddressMatchesExact)
+    { /* All 4 match */
+      retval[3].push_back (endP);
     }
-  return retval1;  /* might be empty if no matches */
 }
 
 Ipv6EndPoint* Ipv6EndPointDemux::SimpleLookup (Ipv6Address dst, uint16_t dport, Ipv6Address src, uint16_t sport)
@@ -296,14 +475,15 @@ Ipv6EndPoint* Ipv6EndPointDemux::SimpleLookup (Ipv6Address dst, uint16_t dport,
   uint32_t genericity = 3;
   Ipv6EndPoint *generic = 0;
 
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  PortEndPoints::iterator it = m_ports.find (dport);
+  if (it == m_ports.end ())
     {
-      uint32_t tmp = 0;
+      return 0;
+    }
 
-      if ((*i)->GetLocalPort () != dport)
-        {
-          continue;
-        }
+  for (EndPointsI i = it->second.begin (); i != it->second.end (); i++)
+    {
+      uint32_t tmp = 0;
 
       if ((*i)->GetLocalAddress () == dst && (*i)->GetPeerPort () == sport
           && (*i)->GetPeerAddress () == src)
@@ -23,6 +23,7 @@
 
 #include <stdint.h>
 #include <list>
+#include <unordered_map>
 #include "ns3/ipv6-address.h"
 #include "ipv6-interface.h"
 
@@ -34,6 +35,12 @@ class Ipv6EndPoint;
  * \ingroup ipv6
  *
  * \brief Demultiplexer for end points.
+ *
+ * The end points whose four-tuple is fully specified (local address, peer
+ * address and peer port set) are kept in a hash table; the others (e.g.,
+ * the listening ones) are kept in a table indexed by local port, that is
+ * searched only when there is no connected end point for the packet.
+ * The end points tell the demux when their four-tuple changes.
  */
 class Ipv6EndPointDemux
 {
@@ -147,6 +154,134 @@ public:
   EndPoints GetEndPoints () const;
 
 private:
+  friend class Ipv6EndPoint;
+
+  /**
+   * \brief Four-tuple of a connected end point
+   */
+  struct FourTuple
+  {
+    /**
+     * \brief Constructor
+     * \param localAddress local address
+     * \param localPort local port
+     * \param peerAddress peer address
+     * \param peerPort peer port
+     */
+    FourTuple (Ipv6Address localAddress, uint16_t localPort,
+               Ipv6Address peerAddress, uint16_t peerPort);
+
+    /**
+     * \brief Comparison operator
+     * \param other the four-tuple to compare with
+     * \return true if the four-tuples are equal
+     */
+    bool operator== (const FourTuple &other) const;
+
+    Ipv6Address m_localAddress; //!< Local address
+    Ipv6Address m_peerAddress;  //!< Peer address
+    uint16_t m_localPort;       //!< Local port
+    uint16_t m_peerPort;        //!< Peer port
+  };
+
+  /**
+   * \brief Hash function of a four-tuple
+   */
+  struct FourTupleHash
+  {
+    /**
+     * \brief Hash a four-tuple
+     * \param tuple the four-tuple
+     * \return the hash
+     */
+    std::size_t operator() (const FourTuple &tuple) const;
+  };
+
+  /**
+   * \brief Connected end points, by four-tuple.
+   */
+  typedef std::unordered_multimap<FourTuple, Ipv6EndPoint *, FourTupleHash> ConnectedEndPoints;
+
+  /**
+   * \brief End points, by local port.
+   */
+  typedef std::unordered_map<uint16_t, EndPoints> PortEndPoints;
+
+  /**
+   * \brief Check if the four-tuple of an end point is fully specified.
+   * \param endPoint the end point
+   * \return true if the end point is connected
+   */
+  static bool IsConnected (Ipv6EndPoint *endPoint);
+
+  /**
+   * \brief Add a new end point to the demux.
+   * \param endPoint the end point
+   */
+  void Insert (Ipv6EndPoint *endPoint);
+
+  /**
+   * \brief Insert an end point in a list kept in allocation order.
+   *
+   * The list is searched from its end, so adding the last allocated end
+   * point takes constant time.
+   *
+   * \param endPoints the list
+   * \param endPoint the end point
+   * \return the position of the end point in the list
+   */
+  static EndPointsI InsertInOrder (EndPoints &endPoints, Ipv6EndPoint *endPoint);
+
+  /**
+   * \brief Add an end point to the table of its local port.
+   *
+   * The table is kept in allocation order.
+   *
+   * \param endPoint the end point
+   */
+  void IndexPort (Ipv6EndPoint *endPoint);
+
+  /**
+   * \brief Remove an end point from the table of its local port.
+   *
+   * Must be called before the local port of the end point changes.
+   *
+   * \param endPoint the end point
+   */
+  void UnindexPort (Ipv6EndPoint *endPoint);
+
+  /**
+   * \brief Add an end point to the connected or to the wildcard table.
+   *
+   * The wildcard table is kept in allocation order.
+   *
+   * \param endPoint the end point
+   */
+  void Index (Ipv6EndPoint *endPoint);
+
+  /**
+   * \brief Remove an end point from the connected or from the wildcard table.
+   *
+   * Must be called before the four-tuple of the end point changes.
+   *
+   * \param endPoint the end point
+   */
+  void Unindex (Ipv6EndPoint *endPoint);
+
+  /**
+   * \brief Add an end point to the Lookup result it matches.
+   * \param endP end point
+   * \param dst destination address
+   * \param dport destination port
+   * \param src source address
+   * \param sport source port
+   * \param incomingInterface the incoming interface
+   * \param retval results, from the least to the most exact match
+   */
+  void Match (Ipv6EndPoint *endP, Ipv6Address dst, uint16_t dport,
+              Ipv6Address src, uint16_t sport,
+              Ptr<Ipv6Interface> incomingInterface, EndPoints *retval);
+
   /**
    * \brief Allocate a ephemeral port.
    * \return a port
@@ -168,10 +303,30 @@ private:
    */
   uint16_t m_portLast;
 
+  /**
+   * \brief The allocation order of the next end point.
+   */
+  uint64_t m_sequence;
+
   /**
    * \brief A list of IPv6 end points.
    */
   EndPoints m_endPoints;
+
+  /**
+   * \brief All the end points, by local port.
+   */
+  PortEndPoints m_ports;
+
+  /**
+   * \brief The end points that are not connected, by local port.
+   */
+  PortEndPoints m_wildcards;
+
+  /**
+   * \brief The connected end points.
+   */
+  ConnectedEndPoints m_connected;
 };
 
 } /* namespace ns3 */
@@ -30,6 +30,7 @@
 #include "ns3/ipv6.h"
 #include "ns3/ipv6-header.h"
 #include "ns3/ipv6-routing-protocol.h"
+#include "prefix-trie.h"
 
 namespace ns3 {
 
@@ -52,6 +53,9 @@ class Ipv6MulticastRoutingTableEntry;
  * Ipv6ListRouting protocol but can be used also as a standalone
  * protocol.
  *
+ * The unicast routes are indexed by destination prefix in a PrefixTrie,
+ * so that a lookup only considers the routes matching the destination.
+ *
  * The Ipv6StaticRouting class inherits from the abstract base class
  * Ipv6RoutingProtocol that defines the interface methods that a routing
  * protocol must support.
@@ -264,6 +268,35 @@ private:
   /// Iterator for container for the multicast routes
   typedef std::list<Ipv6MulticastRoutingTableEntry *>::iterator MulticastRoutesI;
 
+  /// Route in the prefix index
+  struct IndexedRoute
+  {
+    Ipv6RoutingTableEntry *m_route; //!< The route
+    uint32_t m_metric;              //!< Metric of the route
+    uint64_t m_rank;                //!< Rank of the route in m_networkRoutes
+    /**
+     * \param other another route
+     * \return true if both are the same route
+     */
+    bool operator== (const IndexedRoute &other) const
+    {
+      return m_route == other.m_route;
+    }
+  };
+
+  /**
+   * \brief Add a route to the prefix index.
+   * \param route the route, last in m_networkRoutes
+   * \param metric metric of the route
+   */
+  void IndexRoute (Ipv6RoutingTableEntry *route, uint32_t metric);
+
+  /**
+   * \brief Remove a route from the prefix index.
+   * \param route the route
+   */
+  void UnindexRoute (Ipv6RoutingTableEntry *route);
+
   /**
    * \brief Lookup in the forwarding table for destination.
    * \param dest destination address
@@ -286,6 +319,16 @@ private:
    */
   NetworkRoutes m_networkRoutes;
 
+  /**
+   * \brief the network routes, by destination prefix.
+   */
+  PrefixTrie<IndexedRoute, 16> m_networkIndex;
+
+  /**
+   * \brief the rank of the next network route.
+   */
+  uint64_t m_nextRank;
+
   /**
    * \brief the forwarding table for multicast.
    */
@@ -0,0 +1,464 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef PREFIX_TRIE_H
+#define PREFIX_TRIE_H
+
+#include <stdint.h>
+#include <vector>
+#include <algorithm>
+#include "ns3/assert.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup internet
+ *
+ * \brief Path-compressed binary trie of routes, indexed by prefix.
+ *
+ * The routing protocols keep their routes in lists, in the order the
+ * user added them, and used to scan the whole list for each packet.
+ * This index is kept alongside the lists and returns, for a destination,
+ * only the routes whose prefix contains it.
+ *
+ * Each node of the trie is a prefix, and holds the routes to that exact
+ * prefix, in the order they were inserted: these are the equal-cost
+ * candidates of the prefix. Nodes without routes only exist where two
+ * branches diverge, so a lookup visits at most one node per distinct
+ * matching prefix plus one per branching point.
+ *
+ * Masks that are not a contiguous run of leading ones can not be placed in
+ * the trie; the routes using them are kept aside and checked on each
+ * lookup, as the lists did.
+ *
+ * \tparam T the route type. Two values are the same route if they compare
+ * equal.
+ * \tparam N the length of the addresses, in bytes.
+ */
+template <typename T, uint32_t N>
+class PrefixTrie
+{
+public:
+  PrefixTrie ();
+  ~PrefixTrie ();
+
+  /**
+   * \brief Add a route.
+   * \param address the network address, in network byte order
+   * \param mask the network mask, in network byte order
+   * \param route the route
+   */
+  void Insert (const uint8_t address[N], const uint8_t mask[N], const T &route);
+
+  /**
+   * \brief Remove a route.
+   * \param address the network address, in network byte order
+   * \param mask the network mask, in network byte order
+   * \param route the route
+   * \return true if the route was found
+   */
+  bool Remove (const uint8_t address[N], const uint8_t mask[N], const T &route);
+
+  /**
+   * \brief Remove all the routes.
+   */
+  void Clear (void);
+
+  /**
+   * \brief Find the routes matching a destination.
+   *
+   * The routes are appended from the shortest prefix to the longest one,
+   * the routes of a prefix in the order they were inserted; the routes with
+   * a non-contiguous mask come last.
+   *
+   * \param destination the destination, in network byte order
+   * \param routes the vector the routes are appended to
+   */
+  void Lookup (const uint8_t destination[N], std::vector<T> &routes) const;
+
+  /**
+   * \brief Find the routes to a prefix.
+   *
+   * The routes are appended in the order they were inserted.
+   *
+   * \param address the network address, in network byte order
+   * \param mask the network mask, in network byte order
+   * \param routes the vector the routes are appended to
+   */
+  void Find (const uint8_t address[N], const uint8_t mask[N], std::vector<T> &routes) const;
+
+private:
+  /// Trie node: a prefix and the routes to it
+  struct Node
+  {
+    uint8_t m_prefix[N];   //!< Prefix, with the bits past m_length cleared
+    uint32_t m_length;     //!< Prefix length, in bits
+    Node *m_child[2];      //!< Sub-tries, by the bit following the prefix
+    std::vector<T> m_routes; //!< Routes to the prefix, in insertion order
+  };
+
+  /// Route with a non-contiguous mask
+  struct Irregular
+  {
+    uint8_t m_address[N];  //!< Network address, masked
+    uint8_t m_mask[N];     //!< Network mask
+    T m_route;             //!< The route
+  };
+
+  /// Copying is not supported
+  PrefixTrie (const PrefixTrie &);
+  /// Copying is not supported
+  PrefixTrie &operator= (const PrefixTrie &);
+
+  /**
+   * \param mask the network mask
+   * \return the prefix length, or N * 8 + 1 if the mask is not contiguous
+   */
+  static uint32_t GetLength (const uint8_t mask[N]);
+
+  /**
+   * \param address an address
+   * \param bit the index of the bit, from the most significant one
+   * \return the bit
+   */
+  static uint32_t GetBit (const uint8_t address[N], uint32_t bit);
+
+  /**
+   * \param a an address
+   * \param b another address
+   * \param length maximum length to compare, in bits
+   * \return the length of the common prefix, at most length
+   */
+  static uint32_t GetCommonLength (const uint8_t a[N], const uint8_t b[N], uint32_t length);
+
+  /**
+   * \param address the prefix address
+   * \param length the prefix length
+   * \return a node without routes nor children
+   */
+  static Node * NewNode (const uint8_t address[N], uint32_t length);
+
+  /**
+   * \param node the root of the sub-trie to delete
+   */
+  static void DeleteNode (Node *node);
+
+  Node *m_root;                        //!< Root of the trie
+  std::vector<Irregular> m_irregular;  //!< Routes with non-contiguous masks
+};
+
+template <typename T, uint32_t N>
+PrefixTrie<T, N>::PrefixTrie ()
+  : m_root (0)
+{
+}
+
+template <typename T, uint32_t N>
+PrefixTrie<T, N>::~PrefixTrie ()
+{
+  Clear ();
+}
+
+template <typename T, uint32_t N>
+uint32_t
+PrefixTrie<T, N>::GetLength (const uint8_t mask[N])
+{
+  uint32_t i = 0;
+  while (i < N && mask[i] == 0xff)
+    {
+      ++i;
+    }
+  uint32_t length = i * 8;
+  if (i == N)
+    {
+      return length;
+    }
+  uint8_t last = mask[i];
+  while (last & 0x80)
+    {
+      last <<= 1;
+      ++length;
+    }
+  if (last != 0)
+    {
+      return N * 8 + 1;
+    }
+  for (++i; i < N; ++i)
+    {
+      if (mask[i] != 0)
+        {
+          return N * 8 + 1;
+        }
+    }
+  return length;
+}
+
+template <typename T, uint32_t N>
+uint32_t
+PrefixTrie<T, N>::GetBit (const uint8_t address[N], uint32_t bit)
+{
+  return (address[bit >> 3] >> (7 - (bit & 7))) & 1;
+}
+
+template <typename T, uint32_t N>
+uint32_t
+PrefixTrie<T, N>::GetCommonLength (const uint8_t a[N], const uint8_t b[N], uint32_t length)
+{
+  uint32_t i = 0;
+  while (i * 8 < length && a[i] == b[i])
+    {
+      ++i;
+    }
+  if (i * 8 >= length)
+    {
+      return length;
+    }
+  uint32_t common = i * 8;
+  uint8_t diff = a[i] ^ b[i];
+  while (!(diff & 0x80))
+    {
+      diff <<= 1;
+      ++common;
+    }
+  return std::min (common, length);
+}
+
+template <typename T, uint32_t N>
+typename PrefixTrie<T, N>::Node *
+PrefixTrie<T, N>::NewNode (const uint8_t address[N], uint32_t length)
+{
+  Node *node = new Node;
+  for (uint32_t i = 0; i < N; ++i)
+    {
+      uint32_t bits = length > i * 8 ? length - i * 8 : 0;
+      uint8_t mask = bits >= 8 ? 0xff : static_cast<uint8_t> (0xff << (8 - bits));
+      node->m_prefix[i] = address[i] & mask;
+    }
+  node->m_length = length;
+  node->m_child[0] = 0;
+  node->m_child[1] = 0;
+  return node;
+}
+
+template <typename T, uint32_t N>
+void
+PrefixTrie<T, N>::DeleteNode (Node *node)
+{
+  if (node != 0)
+    {
+      DeleteNode (node->m_child[0]);
+      DeleteNode (node->m_child[1]);
+      delete node;
+    }
+}
+
+template <typename T, uint32_t N>
+void
+PrefixTrie<T, N>::Clear (void)
+{
+  DeleteNode (m_root);
+  m_root = 0;
+  m_irregular.clear ();
+}
+
+template <typename T, uint32_t N>
+void
+PrefixTrie<T, N>::Insert (const uint8_t address[N], const uint8_t mask[N], const T &route)
+{
+  uint32_t length = GetLength (mask);
+  if (length > N * 8)
+    {
+      Irregular irregular;
+      for (uint32_t i = 0; i < N; ++i)
+        {
+          irregular.m_address[i] = address[i] & mask[i];
+          irregular.m_mask[i] = mask[i];
+        }
+      irregular.m_route = route;
+      m_irregular.push_back (irregular);
+      return;
+    }
+
+  Node **link = &m_root;
+  while (true)
+    {
+      Node *node = *link;
+      if (node == 0)
+        {
+          node = NewNode (address, length);
+          node->m_routes.push_back (route);
+          *link = node;
+          return;
+        }
+      uint32_t common = GetCommonLength (node->m_prefix, address, std::min (node->m_length, length));
+      if (common == node->m_length)
+        {
+          if (length == node->m_length)
+            {
+              node->m_routes.push_back (route);
+              return;
+            }
+          link = &node->m_child[GetBit (address, node->m_length)];
+          continue;
+        }
+      // The prefix diverges from the node before its end
+      Node *leaf = NewNode (address, length);
+      leaf->m_routes.push_back (route);
+      if (common == length)
+        {
+          leaf->m_child[GetBit (node->m_prefix, length)] = node;
+          *link = leaf;
+          return;
+        }
+      Node *branch = NewNode (address, common);
+      branch->m_child[GetBit (address, common)] = leaf;
+      branch->m_child[GetBit (node->m_prefix, common)] = node;
+      *link = branch;
+      return;
+    }
+}
+
+template <typename T, uint32_t N>
+bool
+PrefixTrie<T, N>::Remove (const uint8_t address[N], const uint8_t mask[N], const T &route)
+{
+  uint32_t length = GetLength (mask);
+  if (length > N * 8)
+    {
+      for (typename std::vector<Irregular>::iterator i = m_irregular.begin (); i != m_irregular.end (); ++i)
+        {
+          if (i->m_route == route)
+            {
+              m_irregular.erase (i);
+              return true;
+            }
+        }
+      return false;
+    }
+
+  Node **parentLink = 0;
+  Node **link = &m_root;
+  while (*link != 0 && (*link)->m_length < length)
+    {
+      Node *node = *link;
+      if (GetCommonLength (node->m_prefix, address, node->m_length) != node->m_length)
+        {
+          return false;
+        }
+      parentLink = link;
+      link = &node->m_child[GetBit (address, node->m_length)];
+    }
+  Node *node = *link;
+  if (node == 0 || node->m_length != length
+      || GetCommonLength (node->m_prefix, address, length) != length)
+    {
+      return false;
+    }
+  typename std::vector<T>::iterator i = std::find (node->m_routes.begin (), node->m_routes.end (), route);
+  if (i == node->m_routes.end ())
+    {
+      return false;
+    }
+  node->m_routes.erase (i);
+  if (!node->m_routes.empty () || (node->m_child[0] != 0 && node->m_child[1] != 0))
+    {
+      return true;
+    }
+
+  // Splice the node out, then its parent if only there to branch
+  *link = node->m_child[0] != 0 ? node->m_child[0] : node->m_child[1];
+  delete node;
+  if (parentLink != 0)
+    {
+      Node *parent = *parentLink;
+      if (parent->m_routes.empty () && (parent->m_child[0] == 0 || parent->m_child[1] == 0))
+        {
+          *parentLink = parent->m_child[0] != 0 ? parent->m_child[0] : parent->m_child[1];
+          delete parent;
+        }
+    }
+  return true;
+}
+
+template <typename T, uint32_t N>
+void
+PrefixTrie<T, N>::Lookup (const uint8_t destination[N], std::vector<T> &routes) const
+{
+  const Node *node = m_root;
+  while (node != 0
+         && GetCommonLength (node->m_prefix, destination, node->m_length) == node->m_length)
+    {
+      routes.insert (routes.end (), node->m_routes.begin (), node->m_routes.end ());
+      if (node->m_length == N * 8)
+        {
+          break;
+        }
+      node = node->m_child[GetBit (destination, node->m_length)];
+    }
+
+  for (typename std::vector<Irregular>::const_iterator i = m_irregular.begin (); i != m_irregular.end (); ++i)
+    {
+      bool match = true;
+      for (uint32_t j = 0; j < N && match; ++j)
+        {
+          match = (destination[j] & i->m_mask[j]) == i->m_address[j];
+        }
+      if (match)
+        {
+          routes.push_back (i->m_route);
+        }
+    }
+}
+
+template <typename T, uint32_t N>
+void
+PrefixTrie<T, N>::Find (const uint8_t address[N], const uint8_t mask[N], std::vector<T> &routes) const
+{
+  uint32_t length = GetLength (mask);
+  if (length > N * 8)
+    {
+      for (typename std::vector<Irregular>::const_iterator i = m_irregular.begin (); i != m_irregular.end (); ++i)
+        {
+          bool match = true;
+          for (uint32_t j = 0; j < N && match; ++j)
+            {
+              match = i->m_mask[j] == mask[j] && i->m_address[j] == (address[j] & mask[j]);
+            }
+          if (match)
+            {
+              routes.push_back (i->m_route);
+            }
+        }
+      return;
+    }
+
+  const Node *node = m_root;
+  while (node != 0 && node->m_length < length
+         && GetCommonLength (node->m_prefix, address, node->m_length) == node->m_length)
+    {
+      node = node->m_child[GetBit (address, node->m_length)];
+    }
+  if (node != 0 && node->m_length == length
+      && GetCommonLength (node->m_prefix, address, length) == length)
+    {
+      routes.insert (routes.end (), node->m_routes.begin (), node->m_routes.end ());
+    }
+}
+
+} // namespace ns3
+
+#endif /* PREFIX_TRIE_H */
@@ -0,0 +1,276 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017 NITK Surathkal
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Vivek Jain <jain.vivek.anand@gmail.com>
+ *          Sourabh Jain <sourabhjain560@outlook.com>
+ *          Mohit P. Tahiliani <tahiliani@nitk.edu.in>
+ */
+
+#include "tcp-bw-estimator.h"
+#include "ns3/log.h"
+#include "ns3/enum.h"
+#include "ns3/uinteger.h"
+#include "ns3/double.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TcpBwEstimator");
+
+NS_OBJECT_ENSURE_REGISTERED (TcpBwEstimator);
+
+/// Nanoseconds per second, to turn bytes per nanosecond into bytes per second
+static const double NS_PER_SEC = 1e9;
+
+TypeId
+TcpBwEstimator::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::TcpBwEstimator")
+    .SetParent<Object> ()
+    .SetGroupName ("Internet")
+    .AddConstructor<TcpBwEstimator> ()
+    .AddAttribute ("FilterType", "Filter applied to the bandwidth samples",
+                   EnumValue (TcpBwEstimator::NONE),
+                   MakeEnumAccessor (&TcpBwEstimator::SetFilterType,
+                                     &TcpBwEstimator::GetFilterType),
+                   MakeEnumChecker (TcpBwEstimator::NONE, "None",
+                                    TcpBwEstimator::TUSTIN, "Tustin",
+                                    TcpBwEstimator::TSW, "Tsw",
+                                    TcpBwEstimator::MAX, "Max"))
+    .AddAttribute ("Window", "Length of the TSW and MAX windows, in RTTs",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&TcpBwEstimator::SetWindow,
+                                         &TcpBwEstimator::GetWindow),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("TustinAlpha", "Gain of the Tustin filter",
+                   DoubleValue (0.9),
+                   MakeDoubleAccessor (&TcpBwEstimator::m_tustinAlpha),
+                   MakeDoubleChecker<double> (0, 1))
+    .AddTraceSource ("Bandwidth", "The estimated bandwidth, in bytes per second",
+                     MakeTraceSourceAccessor (&TcpBwEstimator::m_bw),
+                     "ns3::TracedValueCallback::Double")
+  ;
+  return tid;
+}
+
+TcpBwEstimator::TcpBwEstimator ()
+  : m_bw (0),
+    m_filterType (NONE),
+    m_window (1),
+    m_tustinAlpha (0.9),
+    m_ackedBytes (0),
+    m_lastSampleNs (0),
+    m_lastAckNs (0),
+    m_lastSample (0)
+{
+  NS_LOG_FUNCTION (this);
+  for (uint32_t i = 0; i < 3; ++i)
+    {
+      m_max[i].t = 0;
+      m_max[i].v = 0;
+    }
+}
+
+TcpBwEstimator::TcpBwEstimator (const TcpBwEstimator &other)
+  : Object (other),
+    m_bw (other.m_bw),
+    m_filterType (other.m_filterType),
+    m_window (other.m_window),
+    m_tustinAlpha (other.m_tustinAlpha),
+    m_ackedBytes (other.m_ackedBytes),
+    m_lastSampleNs (other.m_lastSampleNs),
+    m_lastAckNs (other.m_lastAckNs),
+    m_lastSample (other.m_lastSample)
+{
+  NS_LOG_FUNCTION (this);
+  for (uint32_t i = 0; i < 3; ++i)
+    {
+      m_max[i] = other.m_max[i];
+    }
+}
+
+TcpBwEstimator::~TcpBwEstimator ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+TcpBwEstimator::SetFilterType (FilterType type)
+{
+  NS_LOG_FUNCTION (this << type);
+  m_filterType = type;
+}
+
+TcpBwEstimator::FilterType
+TcpBwEstimator::GetFilterType (void) const
+{
+  return m_filterType;
+}
+
+void
+TcpBwEstimator::SetWindow (uint32_t rtts)
+{
+  NS_LOG_FUNCTION (this << rtts);
+  m_window = rtts;
+}
+
+uint32_t
+TcpBwEstimator::GetWindow (void) const
+{
+  return m_window;
+}
+
+bool
+TcpBwEstimator::AckReceived (int64_t nowNs, int64_t rttNs, uint32_t bytes)
+{
+  NS_LOG_FUNCTION (this << nowNs << rttNs << bytes);
+  NS_ASSERT (rttNs > 0);
+
+  m_ackedBytes += bytes;
+
+  int64_t ackDelta = nowNs - m_lastAckNs;
+  m_lastAckNs = nowNs;
+
+  if (nowNs - m_lastSampleNs < rttNs)
+    {
+      return false;
+    }
+
+  // As in the original TCP Jersey model, TSW weights the new bytes with
+  // the last ACK inter-arrival time; the other filters use the time
+  // elapsed since the last sample.
+  int64_t intervalNs = (m_filterType == TSW) ? ackDelta : nowNs - m_lastSampleNs;
+  Filter (nowNs, intervalNs, m_window * rttNs);
+  m_lastSampleNs = nowNs;
+  return true;
+}
+
+void
+TcpBwEstimator::AddAckedBytes (uint32_t bytes)
+{
+  NS_LOG_FUNCTION (this << bytes);
+  m_ackedBytes += bytes;
+}
+
+void
+TcpBwEstimator::Sample (int64_t nowNs, int64_t intervalNs)
+{
+  NS_LOG_FUNCTION (this << nowNs << intervalNs);
+  NS_ASSERT (intervalNs > 0);
+
+  Filter (nowNs, intervalNs, m_window * intervalNs);
+  m_lastSampleNs = nowNs;
+}
+
+void
+TcpBwEstimator::Filter (int64_t nowNs, int64_t intervalNs, int64_t windowNs)
+{
+  double bytes = static_cast<double> (m_ackedBytes) * NS_PER_SEC;
+  double bw = m_bw;
+  m_ackedBytes = 0;
+
+  switch (m_filterType)
+    {
+    case NONE:
+      bw = bytes / intervalNs;
+      break;
+    case TUSTIN:
+      {
+        double sample = bytes / intervalNs;
+        bw = (m_tustinAlpha * bw) + ((1 - m_tustinAlpha) * ((sample + m_lastSample) / 2));
+        m_lastSample = sample;
+      }
+      break;
+    case TSW:
+      bw = (windowNs * bw + bytes) / (intervalNs + windowNs);
+      break;
+    case MAX:
+      bw = RunningMax (nowNs, windowNs, bytes / intervalNs);
+      break;
+    }
+
+  m_bw = bw;
+  NS_LOG_LOGIC ("Estimated BW: " << m_bw);
+}
+
+double
+TcpBwEstimator::RunningMax (int64_t nowNs, int64_t windowNs, double sample)
+{
+  MaxSample val;
+  val.t = nowNs;
+  val.v = sample;
+
+  if (val.v >= m_max[0].v || val.t - m_max[2].t > windowNs)
+    {
+      // New best, or nothing left in the window
+      m_max[0] = m_max[1] = m_max[2] = val;
+      return m_max[0].v;
+    }
+
+  if (val.v >= m_max[1].v)
+    {
+      m_max[2] = m_max[1] = val;
+    }
+  else if (val.v >= m_max[2].v)
+    {
+      m_max[2] = val;
+    }
+
+  // Age the best samples out of the window
+  int64_t dt = val.t - m_max[0].t;
+  if (dt > windowNs)
+    {
+      m_max[0] = m_max[1];
+      m_max[1] = m_max[2];
+      m_max[2] = val;
+      if (val.t - m_max[0].t > windowNs)
+        {
+          m_max[0] = m_max[1];
+          m_max[1] = m_max[2];
+          m_max[2] = val;
+        }
+    }
+  else if (m_max[1].t == m_max[0].t && dt > windowNs / 4)
+    {
+      // A quarter of the window has passed without a second best
+      m_max[2] = m_max[1] = val;
+    }
+  else if (m_max[2].t == m_max[1].t && dt > windowNs / 2)
+    {
+      // Half of the window has passed without a third best
+      m_max[2] = val;
+    }
+
+  return m_max[0].v;
+}
+
+void
+TcpBwEstimator::Reset (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_bw = 0;
+  m_ackedBytes = 0;
+  m_lastSampleNs = 0;
+  m_lastAckNs = 0;
+  m_lastSample = 0;
+  for (uint32_t i = 0; i < 3; ++i)
+    {
+      m_max[i].t = 0;
+      m_max[i].v = 0;
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,192 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017 NITK Surathkal
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Vivek Jain <jain.vivek.anand@gmail.com>
+ *          Sourabh Jain <sourabhjain560@outlook.com>
+ *          Mohit P. Tahiliani <tahiliani@nitk.edu.in>
+ */
+
+#ifndef TCP_BW_ESTIMATOR_H
+#define TCP_BW_ESTIMATOR_H
+
+#include "ns3/object.h"
+#include "ns3/traced-value.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup tcp
+ *
+ * \brief Bandwidth estimator for rate-based congestion controls
+ *
+ * The estimator accumulates the bytes acknowledged by the receiver and
+ * turns them into a bandwidth sample (in bytes per second), which is then
+ * passed through one of the following filters:
+ *
+ * - NONE: the estimate is the last sample
+ * - TUSTIN: Tustin approximation of a first order low pass filter, as
+ *   used by TCP Westwood (estimate = a * last + (1 - a) * (s + last_s) / 2)
+ * - TSW: Time Sliding Window, as used by TCP Jersey. The window is
+ *   Window times the RTT.
+ * - MAX: maximum of the samples taken over the last Window RTTs
+ *
+ * Two sampling modes are available. With AckReceived () the estimator
+ * takes one sample per RTT by itself; with AddAckedBytes () and Sample ()
+ * the caller decides when a sample is taken and over which interval.
+ *
+ * All times are integer nanoseconds, so that the per-ACK path does not
+ * need any Time conversion, and no memory is allocated after construction.
+ * The estimate is exported through the "Bandwidth" trace source.
+ */
+class TcpBwEstimator : public Object
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  /**
+   * \brief Filter applied to the bandwidth samples
+   */
+  enum FilterType
+  {
+    NONE,
+    TUSTIN,
+    TSW,
+    MAX
+  };
+
+  TcpBwEstimator ();
+
+  /**
+   * \brief Copy constructor
+   * \param other the object to copy
+   */
+  TcpBwEstimator (const TcpBwEstimator &other);
+
+  virtual ~TcpBwEstimator ();
+
+  /**
+   * \brief Set the filter applied to the samples
+   * \param type the filter type
+   */
+  void SetFilterType (FilterType type);
+
+  /**
+   * \brief Get the filter applied to the samples
+   * \return the filter type
+   */
+  FilterType GetFilterType (void) const;
+
+  /**
+   * \brief Set the length of the TSW and MAX windows
+   * \param rtts the window length, in RTTs
+   */
+  void SetWindow (uint32_t rtts);
+
+  /**
+   * \brief Get the length of the TSW and MAX windows
+   * \return the window length, in RTTs
+   */
+  uint32_t GetWindow (void) const;
+
+  /**
+   * \brief Account an ACK and take a sample if an RTT has elapsed
+   *
+   * \param nowNs the current time in nanoseconds
+   * \param rttNs the last RTT sample in nanoseconds (must be positive)
+   * \param bytes the bytes acknowledged by this ACK
+   * \return true if a new estimate has been computed
+   */
+  bool AckReceived (int64_t nowNs, int64_t rttNs, uint32_t bytes);
+
+  /**
+   * \brief Account acknowledged bytes without sampling
+   * \param bytes the bytes acknowledged
+   */
+  void AddAckedBytes (uint32_t bytes);
+
+  /**
+   * \brief Take a sample of the bytes accounted over an interval
+   *
+   * The bytes accounted so far are divided by the interval, the result
+   * is filtered and the accounted bytes are cleared.
+   *
+   * \param nowNs the current time in nanoseconds
+   * \param intervalNs the sampling interval in nanoseconds (must be positive)
+   */
+  void Sample (int64_t nowNs, int64_t intervalNs);
+
+  /**
+   * \brief Get the bandwidth estimate
+   * \return the estimate, in bytes per second
+   */
+  double GetBandwidth (void) const
+  {
+    return m_bw;
+  }
+
+  /**
+   * \brief Resets the estimator to its initial state.
+   */
+  void Reset (void);
+
+private:
+  /**
+   * \brief Filter a new sample into the estimate
+   * \param nowNs the current time in nanoseconds
+   * \param intervalNs the interval covered by the sample, in nanoseconds
+   * \param windowNs the length of the TSW and MAX windows, in nanoseconds
+   */
+  void Filter (int64_t nowNs, int64_t intervalNs, int64_t windowNs);
+
+  /**
+   * \brief Windowed maximum, as in Linux lib/win_minmax.c
+   *
+   * Keeps the best, second best and third best samples of the window
+   * so that the maximum is updated in constant time.
+   *
+   * \param nowNs the current time in nanoseconds
+   * \param windowNs the window length in nanoseconds
+   * \param sample the new sample
+   * \return the maximum over the window
+   */
+  double RunningMax (int64_t nowNs, int64_t windowNs, double sample);
+
+  /// A timestamped sample of the MAX filter
+  struct MaxSample
+  {
+    int64_t t;     //!< Sample time, in nanoseconds
+    double v;      //!< Sample value
+  };
+
+  TracedValue<double> m_bw;      //!< Current estimate, in bytes per second
+  FilterType m_filterType;       //!< Filter applied to the samples
+  uint32_t m_window;             //!< Window of the TSW and MAX filters, in RTTs
+  double m_tustinAlpha;          //!< Gain of the Tustin filter
+  uint64_t m_ackedBytes;         //!< Bytes acknowledged since the last sample
+  int64_t m_lastSampleNs;        //!< Time of the last sample
+  int64_t m_lastAckNs;           //!< Time of the last ACK
+  double m_lastSample;           //!< Last unfiltered sample (Tustin)
+  MaxSample m_max[3];            //!< Best samples of the MAX window
+};
+
+} // namespace ns3
+
+#endif /* TCP_BW_ESTIMATOR_H */
@@ -22,6 +22,11 @@
 #include <iostream>
 #include "tcp-header.h"
 #include "tcp-option.h"
+#include "tcp-option-rfc793.h"
+#include "tcp-option-winscale.h"
+#include "tcp-option-sack-permitted.h"
+#include "tcp-option-sack.h"
+#include "tcp-option-ts.h"
 #include "ns3/buffer.h"
 #include "ns3/address-utils.h"
 #include "ns3/log.h"
@@ -43,7 +48,13 @@ TcpHeader::TcpHeader ()
     m_urgentPointer (0),
     m_calcChecksum (false),
     m_goodChecksum (true),
-    m_optionsLen (0)
+    m_optionsLen (0),
+    m_nValues (0),
+    m_mss (0),
+    m_windowScale (0),
+    m_timestamp (0),
+    m_timestampEcho (0),
+    m_nSackBlocks (0)
 {
 }
 
@@ -295,6 +306,11 @@ TcpHeader::Print (std::ostream &os)  const
 
   os << " Seq=" << m_sequenceNumber << " Ack=" << m_ackNumber << " Win=" << m_windowSize;
 
+  for (uint8_t v = 0; v < m_nValues; v++)
+    {
+      PrintValue (os, m_valueKinds[v]);
+    }
+
   TcpOptionList::const_iterator op;
 
   for (op = m_options.begin (); op != m_options.end (); ++op)
@@ -328,6 +344,11 @@ TcpHeader::Serialize (Buffer::Iterator start)  const
   // This implementation does not presently try to align options on word
   // boundaries using NOP options
   uint32_t optionLen = 0;
+  for (uint8_t v = 0; v < m_nValues; v++)
+    {
+      optionLen += GetValueSize (m_valueKinds[v]);
+      SerializeValue (i, m_valueKinds[v]);
+    }
   TcpOptionList::const_iterator op;
   for (op = m_options.begin (); op != m_options.end (); ++op)
     {
@@ -374,6 +395,7 @@ TcpHeader::Deserialize (Buffer::Iterator start)
 
   // Deserialize options if they exist
   m_options.clear ();
+  m_nValues = 0;
   uint32_t optionLen = (m_length - 5) * 4;
   if (optionLen > m_maxOptionsLen)
     {
@@ -383,6 +405,29 @@ TcpHeader::Deserialize (Buffer::Iterator start)
   while (optionLen)
     {
       uint8_t kind = i.PeekU8 ();
+      if (kind == TcpOption::END)
+        {
+          // Discard the END and the padding bytes without adding them
+          // to the option list
+          i.Next (optionLen);
+          m_optionsLen += optionLen;
+          break;
+        }
+      if (optionLen >= 2 && CanHoldValue (kind))
+        {
+          // Keep the leading known options as values, without TcpOption
+          Buffer::Iterator j = i;
+          j.Next (1);
+          uint8_t size = j.ReadU8 ();
+          if (size <= optionLen && DeserializeValue (j, kind, size))
+            {
+              m_valueKinds[m_nValues++] = kind;
+              i.Next (size);
+              optionLen -= size;
+              m_optionsLen += size;
+              continue;
+            }
+        }
       Ptr<TcpOption> op;
       uint32_t optionSize;
       if (TcpOption::IsKindKnown (kind))
@@ -404,6 +449,7 @@ TcpHeader::Deserialize (Buffer::Iterator start)
         {
           optionLen -= optionSize;
           i.Next (optionSize);
+          MaterializeOptions ();
           m_options.push_back (op);
           m_optionsLen += optionSize;
         }
@@ -412,16 +458,6 @@ TcpHeader::Deserialize (Buffer::Iterator start)
           NS_LOG_ERROR ("Option exceeds TCP option space; option discarded");
           break;
         }
-      if (op->GetKind () == TcpOption::END)
-        {
-          while (optionLen)
-            {
-              // Discard padding bytes without adding to option list
-              i.Next (1);
-              --optionLen;
-              ++m_optionsLen;
-            }
-        }
     }
 
   if (m_length != CalculateHeaderLength ())
@@ -445,6 +481,10 @@ uint8_t
 TcpHeader::CalculateHeaderLength () const
 {
   uint32_t len = 20;
+  for (uint8_t v = 0; v < m_nValues; v++)
+    {
+      len += GetValueSize (m_valueKinds[v]);
+    }
   TcpOptionList::const_iterator i;
 
   for (i = m_options.begin (); i != m_options.end (); ++i)
@@ -472,6 +512,7 @@ TcpHeader::AppendOption (Ptr<const TcpOption> option)
 
       if (option->GetKind () != TcpOption::END)
         {
+          MaterializeOptions ();
           m_options.push_back (option);
           m_optionsLen += option->GetSerializedSize ();
 
@@ -485,15 +526,428 @@ TcpHeader::AppendOption (Ptr<const TcpOption> option)
   return false;
 }
 
+bool
+TcpHeader::AppendMss (uint16_t mss)
+{
+  if (!CanHoldValue (TcpOption::MSS))
+    {
+      Ptr<TcpOptionMSS> option = CreateObject<TcpOptionMSS> ();
+      option->SetMSS (mss);
+      return AppendOption (option);
+    }
+  if (!AppendValue (TcpOption::MSS, 4))
+    {
+      return false;
+    }
+  m_mss = mss;
+  return true;
+}
+
+bool
+TcpHeader::GetMss (uint16_t &mss) const
+{
+  if (HasValue (TcpOption::MSS))
+    {
+      mss = m_mss;
+      return true;
+    }
+  Ptr<const TcpOptionMSS> option = DynamicCast<const TcpOptionMSS> (GetOption (TcpOption::MSS));
+  if (option == 0)
+    {
+      return false;
+    }
+  mss = option->GetMSS ();
+  return true;
+}
+
+bool
+TcpHeader::AppendWindowScale (uint8_t scale)
+{
+  if (!CanHoldValue (TcpOption::WINSCALE))
+    {
+      Ptr<TcpOptionWinScale> option = CreateObject<TcpOptionWinScale> ();
+      option->SetScale (scale);
+      return AppendOption (option);
+    }
+  if (!AppendValue (TcpOption::WINSCALE, 3))
+    {
+      return false;
+    }
+  m_windowScale = scale;
+  return true;
+}
+
+bool
+TcpHeader::GetWindowScale (uint8_t &scale) const
+{
+  if (HasValue (TcpOption::WINSCALE))
+    {
+      scale = m_windowScale;
+      return true;
+    }
+  Ptr<const TcpOptionWinScale> option = DynamicCast<const TcpOptionWinScale> (GetOption (TcpOption::WINSCALE));
+  if (option == 0)
+    {
+      return false;
+    }
+  scale = option->GetScale ();
+  return true;
+}
+
+bool
+TcpHeader::AppendSackPermitted (void)
+{
+  if (!CanHoldValue (TcpOption::SACKPERMITTED))
+    {
+      return AppendOption (CreateObject<TcpOptionSackPermitted> ());
+    }
+  return AppendValue (TcpOption::SACKPERMITTED, 2);
+}
+
+bool
+TcpHeader::AppendSackBlock (const TcpOptionSack::SackBlock &block)
+{
+  if (HasValue (TcpOption::SACK))
+    {
+      if (m_nSackBlocks == m_maxSackBlocks || m_optionsLen + 8 > m_maxOptionsLen)
+        {
+          return false;
+        }
+      m_sackBlocks[m_nSackBlocks++] = block;
+      m_optionsLen += 8;
+      m_length = (20 + 3 + m_optionsLen) >> 2;
+      return true;
+    }
+  if (CanHoldValue (TcpOption::SACK))
+    {
+      if (!AppendValue (TcpOption::SACK, 10))
+        {
+          return false;
+        }
+      m_sackBlocks[0] = block;
+      m_nSackBlocks = 1;
+      return true;
+    }
+
+  // Replace the TcpOptionSack of the list by a copy with the block
+  TcpOptionList::iterator i;
+  for (i = m_options.begin (); i != m_options.end (); ++i)
+    {
+      if ((*i)->GetKind () == TcpOption::SACK)
+        {
+          break;
+        }
+    }
+  Ptr<TcpOptionSack> option = CreateObject<TcpOptionSack> ();
+  if (i == m_options.end ())
+    {
+      option->AddSackBlock (block);
+      return AppendOption (option);
+    }
+  Ptr<const TcpOptionSack> old = DynamicCast<const TcpOptionSack> (*i);
+  if (old == 0 || m_optionsLen + 8 > m_maxOptionsLen)
+    {
+      return false;
+    }
+  TcpOptionSack::SackList list = old->GetSackList ();
+  TcpOptionSack::SackList::const_iterator it;
+  for (it = list.begin (); it != list.end (); ++it)
+    {
+      option->AddSackBlock (*it);
+    }
+  option->AddSackBlock (block);
+  *i = option;
+  m_optionsLen += 8;
+  m_length = (20 + 3 + m_optionsLen) >> 2;
+  return true;
+}
+
+bool
+TcpHeader::GetSackList (TcpOptionSack::SackList &list) const
+{
+  if (HasValue (TcpOption::SACK))
+    {
+      list.assign (m_sackBlocks, m_sackBlocks + m_nSackBlocks);
+      return true;
+    }
+  Ptr<const TcpOptionSack> option = DynamicCast<const TcpOptionSack> (GetOption (TcpOption::SACK));
+  if (option == 0)
+    {
+      return false;
+    }
+  list = option->GetSackList ();
+  return true;
+}
+
+bool
+TcpHeader::AppendTimestamp (uint32_t timestamp, uint32_t echo)
+{
+  if (!CanHoldValue (TcpOption::TS))
+    {
+      Ptr<TcpOptionTS> option = CreateObject<TcpOptionTS> ();
+      option->SetTimestamp (timestamp);
+      option->SetEcho (echo);
+      return AppendOption (option);
+    }
+  if (!AppendValue (TcpOption::TS, 10))
+    {
+      return false;
+    }
+  m_timestamp = timestamp;
+  m_timestampEcho = echo;
+  return true;
+}
+
+bool
+TcpHeader::GetTimestamp (uint32_t &timestamp, uint32_t &echo) const
+{
+  if (HasValue (TcpOption::TS))
+    {
+      timestamp = m_timestamp;
+      echo = m_timestampEcho;
+      return true;
+    }
+  Ptr<const TcpOptionTS> ts = DynamicCast<const TcpOptionTS> (GetOption (TcpOption::TS));
+  if (ts == 0)
+    {
+      return false;
+    }
+  timestamp = ts->GetTimestamp ();
+  echo = ts->GetEcho ();
+  return true;
+}
+
+bool
+TcpHeader::HasValue (uint8_t kind) const
+{
+  for (uint8_t v = 0; v < m_nValues; v++)
+    {
+      if (m_valueKinds[v] == kind)
+        {
+          return true;
+        }
+    }
+  return false;
+}
+
+bool
+TcpHeader::CanHoldValue (uint8_t kind) const
+{
+  // Keep the order of the options: the options held as values come first
+  return m_options.empty () && !HasValue (kind);
+}
+
+bool
+TcpHeader::AppendValue (uint8_t kind, uint8_t size)
+{
+  if (m_optionsLen + size > m_maxOptionsLen)
+    {
+      return false;
+    }
+  m_valueKinds[m_nValues++] = kind;
+  m_optionsLen += size;
+  m_length = (20 + 3 + m_optionsLen) >> 2;
+  return true;
+}
+
+uint8_t
+TcpHeader::GetValueSize (uint8_t kind) const
+{
+  switch (kind)
+    {
+    case TcpOption::MSS:
+      return 4;
+    case TcpOption::WINSCALE:
+      return 3;
+    case TcpOption::SACKPERMITTED:
+      return 2;
+    case TcpOption::SACK:
+      return 2 + m_nSackBlocks * 8;
+    case TcpOption::TS:
+      return 10;
+    default:
+      NS_FATAL_ERROR ("Option kind " << static_cast<int> (kind) << " not held as values");
+      return 0;
+    }
+}
+
+void
+TcpHeader::PrintValue (std::ostream &os, uint8_t kind) const
+{
+  switch (kind)
+    {
+    case TcpOption::MSS:
+      os << " " << TcpOptionMSS::GetTypeId ().GetName () << "(MSS:" << m_mss << ")";
+      break;
+    case TcpOption::WINSCALE:
+      os << " " << TcpOptionWinScale::GetTypeId ().GetName () << "("
+         << static_cast<int> (m_windowScale) << ")";
+      break;
+    case TcpOption::SACKPERMITTED:
+      os << " " << TcpOptionSackPermitted::GetTypeId ().GetName () << "([sack_perm])";
+      break;
+    case TcpOption::SACK:
+      os << " " << TcpOptionSack::GetTypeId ().GetName () << "(blocks: "
+         << static_cast<int> (m_nSackBlocks) << ",";
+      for (uint8_t b = 0; b < m_nSackBlocks; b++)
+        {
+          os << "[" << m_sackBlocks[b].first << "," << m_sackBlocks[b].second << "]";
+        }
+      os << ")";
+      break;
+    case TcpOption::TS:
+      os << " " << TcpOptionTS::GetTypeId ().GetName () << "("
+         << m_timestamp << ";" << m_timestampEcho << ")";
+      break;
+    default:
+      NS_FATAL_ERROR ("Option kind " << static_cast<int> (kind) << " not held as values");
+    }
+}
+
+void
+TcpHeader::SerializeValue (Buffer::Iterator &i, uint8_t kind) const
+{
+  // As the Serialize method of the TcpOption
+  i.WriteU8 (kind);
+  i.WriteU8 (GetValueSize (kind));
+  switch (kind)
+    {
+    case TcpOption::MSS:
+      i.WriteHtonU16 (m_mss);
+      break;
+    case TcpOption::WINSCALE:
+      i.WriteU8 (m_windowScale);
+      break;
+    case TcpOption::SACKPERMITTED:
+      break;
+    case TcpOption::SACK:
+      for (uint8_t b = 0; b < m_nSackBlocks; b++)
+        {
+          i.WriteHtonU32 (m_sackBlocks[b].first.GetValue ());
+          i.WriteHtonU32 (m_sackBlocks[b].second.GetValue ());
+        }
+      break;
+    case TcpOption::TS:
+      i.WriteHtonU32 (m_timestamp);
+      i.WriteHtonU32 (m_timestampEcho);
+      break;
+    default:
+      NS_FATAL_ERROR ("Option kind " << static_cast<int> (kind) << " not held as values");
+    }
+}
+
+bool
+TcpHeader::DeserializeValue (Buffer::Iterator i, uint8_t kind, uint8_t size)
+{
+  // The malformed options are left to the Deserialize method of the
+  // TcpOption, which reports them
+  switch (kind)
+    {
+    case TcpOption::MSS:
+      if (size != 4)
+        {
+          return false;
+        }
+      m_mss = i.ReadNtohU16 ();
+      return true;
+    case TcpOption::WINSCALE:
+      if (size != 3)
+        {
+          return false;
+        }
+      m_windowScale = i.ReadU8 ();
+      return true;
+    case TcpOption::SACKPERMITTED:
+      return size == 2;
+    case TcpOption::SACK:
+      if (size < 2 || (size - 2) % 8 != 0 || (size - 2) / 8 > m_maxSackBlocks)
+        {
+          return false;
+        }
+      m_nSackBlocks = (size - 2) / 8;
+      for (uint8_t b = 0; b < m_nSackBlocks; b++)
+        {
+          m_sackBlocks[b].first = SequenceNumber32 (i.ReadNtohU32 ());
+          m_sackBlocks[b].second = SequenceNumber32 (i.ReadNtohU32 ());
+        }
+      return true;
+    case TcpOption::TS:
+      if (size != 10)
+        {
+          return false;
+        }
+      m_timestamp = i.ReadNtohU32 ();
+      m_timestampEcho = i.ReadNtohU32 ();
+      return true;
+    default:
+      return false;
+    }
+}
+
+Ptr<TcpOption>
+TcpHeader::CreateValueOption (uint8_t kind) const
+{
+  switch (kind)
+    {
+    case TcpOption::MSS:
+      {
+        Ptr<TcpOptionMSS> option = CreateObject<TcpOptionMSS> ();
+        option->SetMSS (m_mss);
+        return option;
+      }
+    case TcpOption::WINSCALE:
+      {
+        Ptr<TcpOptionWinScale> option = CreateObject<TcpOptionWinScale> ();
+        option->SetScale (m_windowScale);
+        return option;
+      }
+    case TcpOption::SACKPERMITTED:
+      return CreateObject<TcpOptionSackPermitted> ();
+    case TcpOption::SACK:
+      {
+        Ptr<TcpOptionSack> option = CreateObject<TcpOptionSack> ();
+        for (uint8_t b = 0; b < m_nSackBlocks; b++)
+          {
+            option->AddSackBlock (m_sackBlocks[b]);
+          }
+        return option;
+      }
+    case TcpOption::TS:
+      {
+        Ptr<TcpOptionTS> option = CreateObject<TcpOptionTS> ();
+        option->SetTimestamp (m_timestamp);
+        option->SetEcho (m_timestampEcho);
+        return option;
+      }
+    default:
+      NS_FATAL_ERROR ("Option kind " << static_cast<int> (kind) << " not held as values");
+      return 0;
+    }
+}
+
+void
+TcpHeader::MaterializeOptions (void) const
+{
+  while (m_nValues > 0)
+    {
+      m_options.push_front (CreateValueOption (m_valueKinds[--m_nValues]));
+    }
+}
+
 const TcpHeader::TcpOptionList&
 TcpHeader::GetOptionList () const
 {
+  MaterializeOptions ();
   return m_options;
 }
 
 Ptr<const TcpOption>
 TcpHeader::GetOption(uint8_t kind) const
 {
+  if (HasValue (kind))
+    {
+      MaterializeOptions ();
+    }
   TcpOptionList::const_iterator i;
 
   for (i = m_options.begin (); i != m_options.end (); ++i)
@@ -510,6 +964,10 @@ TcpHeader::GetOption(uint8_t kind) const
 bool
 TcpHeader::HasOption (uint8_t kind) const
 {
+  if (HasValue (kind))
+    {
+      return true;
+    }
   TcpOptionList::const_iterator i;
 
   for (i = m_options.begin (); i != m_options.end (); ++i)
@@ -24,6 +24,7 @@
 #include <stdint.h>
 #include "ns3/header.h"
 #include "ns3/tcp-option.h"
+#include "ns3/tcp-option-sack.h"
 #include "ns3/buffer.h"
 #include "ns3/tcp-socket-factory.h"
 #include "ns3/ipv4-address.h"
@@ -39,6 +40,15 @@ namespace ns3 {
  * This class has fields corresponding to those in a network TCP header
  * (port numbers, sequence and acknowledgement numbers, flags, etc) as well
  * as methods for serialization to and deserialization from a byte buffer.
+ *
+ * The MSS, window scale, SACK permitted, SACK and timestamp options
+ * which come before any other option are held as values, in the
+ * header, rather than as TcpOption objects: they are added with
+ * AppendMss, AppendWindowScale, AppendSackPermitted, AppendSackBlock
+ * and AppendTimestamp, and read with GetMss, GetWindowScale, HasOption,
+ * GetSackList and GetTimestamp, without allocation.  The other options
+ * are held as TcpOption objects.  GetOption and GetOptionList create
+ * the objects of the options held as values on demand.
  */
 
 class TcpHeader : public Header
@@ -219,6 +229,73 @@ public:
    */
   bool AppendOption (Ptr<const TcpOption> option);
 
+  /**
+   * \brief Append a MSS option to the TCP header
+   * \param mss The maximum segment size
+   * \return true if option has been appended, false otherwise
+   */
+  bool AppendMss (uint16_t mss);
+
+  /**
+   * \brief Get the MSS option, without allocating a TcpOptionMSS
+   * \param [out] mss The maximum segment size
+   * \return true if the header has a MSS option, false otherwise
+   */
+  bool GetMss (uint16_t &mss) const;
+
+  /**
+   * \brief Append a window scale option to the TCP header
+   * \param scale The window scale
+   * \return true if option has been appended, false otherwise
+   */
+  bool AppendWindowScale (uint8_t scale);
+
+  /**
+   * \brief Get the window scale option, without allocating a TcpOptionWinScale
+   * \param [out] scale The window scale
+   * \return true if the header has a window scale option, false otherwise
+   */
+  bool GetWindowScale (uint8_t &scale) const;
+
+  /**
+   * \brief Append a SACK permitted option to the TCP header
+   * \return true if option has been appended, false otherwise
+   */
+  bool AppendSackPermitted (void);
+
+  /**
+   * \brief Add a block to the SACK option of the TCP header
+   *
+   * The SACK option is appended with the block if the header has none.
+   *
+   * \param block The SACK block
+   * \return true if the block has been added, false otherwise
+   */
+  bool AppendSackBlock (const TcpOptionSack::SackBlock &block);
+
+  /**
+   * \brief Get the blocks of the SACK option, without allocating a TcpOptionSack
+   * \param [out] list The SACK blocks
+   * \return true if the header has a SACK option, false otherwise
+   */
+  bool GetSackList (TcpOptionSack::SackList &list) const;
+
+  /**
+   * \brief Append a timestamp option to the TCP header
+   * \param timestamp The timestamp
+   * \param echo The echoed timestamp
+   * \return true if option has been appended, false otherwise
+   */
+  bool AppendTimestamp (uint32_t timestamp, uint32_t echo);
+
+  /**
+   * \brief Get the timestamp option, without allocating a TcpOptionTS
+   * \param [out] timestamp The timestamp
+   * \param [out] echo The echoed timestamp
+   * \return true if the header has a timestamp option, false otherwise
+   */
+  bool GetTimestamp (uint32_t &timestamp, uint32_t &echo) const;
+
   /**
    * \brief Initialize the TCP checksum.
    *
@@ -332,6 +409,75 @@ private:
    */
   uint8_t CalculateHeaderLength () const;
 
+  /**
+   * \brief Check if an option is held as values
+   * \param kind The kind of the option
+   * \return true if the option is held as values
+   */
+  bool HasValue (uint8_t kind) const;
+
+  /**
+   * \brief Check if an option appended now may be held as values
+   * \param kind The kind of the option
+   * \return true if no other option follows, and the option is not
+   * already held as values
+   */
+  bool CanHoldValue (uint8_t kind) const;
+
+  /**
+   * \brief Add an option held as values after the other ones
+   *
+   * The caller sets the values when this succeeds.
+   *
+   * \param kind The kind of the option
+   * \param size The serialized size of the option
+   * \return true if the option fits in the header, false otherwise
+   */
+  bool AppendValue (uint8_t kind, uint8_t size);
+
+  /**
+   * \brief Get the serialized size of an option held as values
+   * \param kind The kind of the option
+   * \return the serialized size of the option
+   */
+  uint8_t GetValueSize (uint8_t kind) const;
+
+  /**
+   * \brief Print an option held as values, as the TcpOption would
+   * \param os The output stream
+   * \param kind The kind of the option
+   */
+  void PrintValue (std::ostream &os, uint8_t kind) const;
+
+  /**
+   * \brief Serialize an option held as values, as the TcpOption would
+   * \param i The buffer iterator, moved after the option
+   * \param kind The kind of the option
+   */
+  void SerializeValue (Buffer::Iterator &i, uint8_t kind) const;
+
+  /**
+   * \brief Deserialize an option into values
+   * \param i The buffer iterator, after the kind and the length of the option
+   * \param kind The kind of the option
+   * \param size The length of the option
+   * \return false if the option cannot be held as values, or is malformed
+   */
+  bool DeserializeValue (Buffer::Iterator i, uint8_t kind, uint8_t size);
+
+  /**
+   * \brief Create the TcpOption of an option held as values
+   * \param kind The kind of the option
+   * \return the option
+   */
+  Ptr<TcpOption> CreateValueOption (uint8_t kind) const;
+
+  /**
+   * \brief Move the options held as values to the head of the option
+   * list, as TcpOption objects
+   */
+  void MaterializeOptions (void) const;
+
   uint16_t m_sourcePort;        //!< Source port
   uint16_t m_destinationPort;   //!< Destination port
   SequenceNumber32 m_sequenceNumber;  //!< Sequence number
@@ -349,8 +495,24 @@ private:
   bool m_goodChecksum;    //!< Flag to indicate that checksum is correct
 
   static const uint8_t m_maxOptionsLen = 40;         //!< Maximum options length
-  TcpOptionList m_options;     //!< TcpOption present in the header
+  mutable TcpOptionList m_options;  //!< TcpOption present in the header
   uint8_t m_optionsLen;        //!< Tcp options length.
+
+  static const uint8_t m_maxValues = 5;      //!< Number of kinds of options held as values
+  static const uint8_t m_maxSackBlocks = 4;  //!< Maximum number of SACK blocks held as values
+
+  /**
+   * Number of options held as values, which come before the options of
+   * #m_options
+   */
+  mutable uint8_t m_nValues;
+  uint8_t m_valueKinds[m_maxValues];         //!< Kinds of the options held as values, in order
+  uint16_t m_mss;                            //!< The MSS, if held as values
+  uint8_t m_windowScale;                     //!< The window scale, if held as values
+  uint32_t m_timestamp;                      //!< The timestamp, if held as values
+  uint32_t m_timestampEcho;                  //!< The echoed timestamp, if held as values
+  uint8_t m_nSackBlocks;                     //!< Number of SACK blocks, if held as values
+  TcpOptionSack::SackBlock m_sackBlocks[m_maxSackBlocks]; //!< The SACK blocks, if held as values
 };
 
 } // namespace ns3
@@ -23,6 +23,7 @@
 #include "tcp-jersey.h"
 #include "ns3/log.h"
 #include "ns3/simulator.h"
+#include "ns3/double.h"
 #include "rtt-estimator.h"
 #include "tcp-socket-base.h"
 
@@ -41,30 +42,37 @@ TcpJersey::GetTypeId (void)
     .AddConstructor<TcpJersey> ()
     .AddAttribute ("K", "RTT multiple constant",
                    UintegerValue (1),
-                   MakeUintegerAccessor (&TcpJersey::m_K),
+                   MakeUintegerAccessor (&TcpJersey::SetK,
+                                         &TcpJersey::GetK),
                    MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("PacingGain", "Gain applied to the estimated bandwidth to get "
+                   "the pacing rate published to the socket",
+                   DoubleValue (1.25),
+                   MakeDoubleAccessor (&TcpJersey::m_pacingGain),
+                   MakeDoubleChecker<double> (1.0))
   ;
   return tid;
 }
 
 TcpJersey::TcpJersey (void)
   : TcpNewReno (),
-    m_currentBW (0),
+    m_bwEstimator (CreateObject<TcpBwEstimator> ()),
     m_currentRTT (Time (0)),
-    m_prevAckTime (Time (0)),
-    m_tLast (Time (0)),
-    m_ackedSegments (0)
+    m_K (1),
+    m_pacingGain (1.25),
+    m_warningHighTxMark (0)
 {
   NS_LOG_FUNCTION (this);
+  m_bwEstimator->SetFilterType (TcpBwEstimator::TSW);
 }
 
 TcpJersey::TcpJersey (const TcpJersey& sock)
   : TcpNewReno (sock),
-    m_currentBW (sock.m_currentBW),
+    m_bwEstimator (CopyObject<TcpBwEstimator> (sock.m_bwEstimator)),
     m_currentRTT (sock.m_currentRTT),
-    m_prevAckTime (Time (0)),
-    m_tLast (Time (0)),
-    m_ackedSegments (0)
+    m_K (sock.m_K),
+    m_pacingGain (sock.m_pacingGain),
+    m_warningHighTxMark (sock.m_warningHighTxMark)
 {
   NS_LOG_FUNCTION (this);
   NS_LOG_LOGIC ("Invoked the copy constructor");
@@ -74,6 +82,26 @@ TcpJersey::~TcpJersey (void)
 {
 }
 
+void
+TcpJersey::SetK (uint32_t k)
+{
+  NS_LOG_FUNCTION (this << k);
+  m_K = k;
+  m_bwEstimator->SetWindow (k);
+}
+
+uint32_t
+TcpJersey::GetK (void) const
+{
+  return m_K;
+}
+
+Ptr<TcpBwEstimator>
+TcpJersey::GetBwEstimator (void) const
+{
+  return m_bwEstimator;
+}
+
 void
 TcpJersey::PktsAcked (Ptr<TcpSocketState> tcb, uint32_t packetsAcked,
                       const Time& rtt)
@@ -86,29 +114,14 @@ TcpJersey::PktsAcked (Ptr<TcpSocketState> tcb, uint32_t packetsAcked,
       return;
     }
 
-  m_ackedSegments += packetsAcked;
   m_currentRTT = rtt;
-  EstimateBW (tcb, rtt);
-}
-
-void
-TcpJersey::EstimateBW (Ptr<TcpSocketState> tcb, const Time &rtt)
-{
-  NS_LOG_FUNCTION (this);
-  NS_ASSERT (!rtt.IsZero ());
-
-  Time now = Simulator::Now ();
-
-  Time Tw =  rtt * m_K;
-  double delta = now.GetSeconds () - m_prevAckTime.GetSeconds ();
-  m_prevAckTime = now;
-
-  if ((now - m_tLast) >= rtt)
+  if (m_bwEstimator->AckReceived (Simulator::Now ().GetNanoSeconds (), rtt.GetNanoSeconds (),
+                                  packetsAcked * tcb->m_segmentSize))
     {
-      double temp = (Tw.GetSeconds () * m_currentBW) + (m_ackedSegments * tcb->m_segmentSize);
-      m_currentBW = temp / (delta + Tw.GetSeconds ());
-      m_tLast = now;
-      m_ackedSegments = 0;
+      // Publish the estimate as pacing rate (used only if the socket paces).
+      // The gain lets the sender probe above the estimated bandwidth, which
+      // would otherwise be bounded by the pacing rate itself.
+      tcb->m_pacingRate = DataRate (static_cast<uint64_t> (m_bwEstimator->GetBandwidth () * 8 * m_pacingGain));
     }
 }
 
@@ -118,9 +131,10 @@ TcpJersey::GetSsThresh (Ptr<const TcpSocketState> tcb,
 {
   (void) bytesInFlight;
 
-  uint32_t ownd = m_currentRTT.GetSeconds () * m_currentBW;
+  double bw = m_bwEstimator->GetBandwidth ();
+  uint32_t ownd = m_currentRTT.GetSeconds () * bw;
 
-  NS_LOG_LOGIC ("CurrentBW: " << m_currentBW << " ssthresh: " << ownd);
+  NS_LOG_LOGIC ("CurrentBW: " << bw << " ssthresh: " << ownd);
 
   return std::max (2 * tcb->m_segmentSize, ownd);
 }
@@ -128,6 +142,10 @@ TcpJersey::GetSsThresh (Ptr<const TcpSocketState> tcb,
 void
 TcpJersey::RateControl (Ptr<TcpSocketState> tcb, uint32_t bytesInFlight)
 {
+  NS_LOG_FUNCTION (this << tcb << bytesInFlight);
+
+  // The congestion warning concerns the segments sent so far
+  m_warningHighTxMark = tcb->m_highTxMark;
   tcb->m_ssThresh = GetSsThresh (tcb, bytesInFlight);
 
   if ((tcb->m_congState == TcpSocketState::CA_OPEN) || (tcb->m_congState == TcpSocketState::CA_DISORDER) || (tcb->m_congState == TcpSocketState::CA_CWR) || (tcb->m_congState == TcpSocketState::CA_RECOVERY) || (tcb->m_congState == TcpSocketState::CA_LOSS) || (tcb->m_congState == TcpSocketState::CA_LAST_STATE))
@@ -139,6 +157,38 @@ TcpJersey::RateControl (Ptr<TcpSocketState> tcb, uint32_t bytesInFlight)
 void
 TcpJersey::ExplicitRetransmit (Ptr<TcpSocketState> tcb, uint32_t bytesInFlight)
 {
+  NS_LOG_FUNCTION (this << tcb << bytesInFlight);
+
+  if (m_bwEstimator->GetBandwidth () == 0 || m_currentRTT.IsZero ())
+    {
+      // No bandwidth sample yet: behave as NewReno
+      NS_LOG_LOGIC ("No bandwidth estimate, halving the window");
+      tcb->m_ssThresh = TcpNewReno::GetSsThresh (tcb, bytesInFlight);
+      tcb->m_cWnd = tcb->m_ssThresh;
+      return;
+    }
+
+  tcb->m_ssThresh = GetSsThresh (tcb, bytesInFlight);
+
+  // The ECN state of the sender stays ECN_CWR_SENT after the first
+  // warning: only a warning not answered yet, or one received while the
+  // lost segment was in flight, concerns the current window
+  if (tcb->m_ecnState == TcpSocketState::ECN_ECE_RCVD
+      || (tcb->m_ecnState == TcpSocketState::ECN_CWR_SENT
+          && m_warningHighTxMark > tcb->m_lastAckedSeq))
+    {
+      // The loss was preceded by a congestion warning: the window has been
+      // (or is about to be) set by RateControl, never let it grow here
+      NS_LOG_LOGIC ("Congestion loss, cwnd " << tcb->m_cWnd << " ownd " << tcb->m_ssThresh);
+      tcb->m_cWnd = std::min (tcb->m_cWnd.Get (), tcb->m_ssThresh.Get ());
+    }
+  else
+    {
+      // No congestion warning: the loss is due to the link, keep sending
+      // at the estimated available bandwidth
+      NS_LOG_LOGIC ("Non-congestion loss, cwnd " << tcb->m_cWnd << " ownd " << tcb->m_ssThresh);
+      tcb->m_cWnd = tcb->m_ssThresh;
+    }
 }
 
 Ptr<TcpCongestionOps>
@@ -24,6 +24,7 @@
 #define TCP_JERSEY_H
 
 #include "tcp-congestion-ops.h"
+#include "tcp-bw-estimator.h"
 #include "ns3/sequence-number.h"
 #include "ns3/traced-value.h"
 
@@ -36,20 +37,15 @@ class Time;
 /**
  * \ingroup congestionOps
  *
- * \brief An implementation of TCP Westwood and Westwood+.
+ * \brief An implementation of TCP Jersey.
  *
- * Westwood and Westwood+ employ the AIAD (Additive Increase/Adaptive Decrease)
- * congestion control paradigm. When a congestion episode happens,
- * instead of halving the cwnd, these protocols try to estimate the network's
- * bandwidth and use the estimated value to adjust the cwnd.
- * While Westwood performs the bandwidth sampling every ACK reception,
- * Westwood+ samples the bandwidth every RTT.
- *
- * The two main methods in the implementation are the CountAck (const TCPHeader&)
- * and the EstimateBW (int, const, Time). The CountAck method calculates
- * the number of acknowledged segments on the receipt of an ACK.
- * The EstimateBW estimates the bandwidth based on the value returned by CountAck
- * and the sampling interval (last ACK inter-arrival time for Westwood and last RTT for Westwood+).
+ * TCP Jersey estimates the available bandwidth with a time sliding window
+ * over the last K RTTs (see TcpBwEstimator), and derives from it the
+ * optimum window, that is the estimated bandwidth times the current RTT.
+ * The window is set to the optimum window in RateControl, when the
+ * receiver echoes a congestion warning (ECN), and in ExplicitRetransmit, on
+ * the losses which are not preceded by a congestion warning: those losses
+ * are not due to congestion, and the window is not halved.
  */
 class TcpJersey : public TcpNewReno
 {
@@ -72,29 +68,64 @@ public:
                                 uint32_t bytesInFlight);
 
   virtual void RateControl (Ptr<TcpSocketState> tcb, uint32_t bytesInFlight);
+
+  /**
+   * \brief Set cWnd and ssThresh when entering fast recovery
+   *
+   * If the loss was preceded by a congestion warning (ECE) received while
+   * the lost segment was in flight, or not answered yet, cWnd is capped
+   * to the optimum window (estimated bandwidth times RTT). Otherwise the loss
+   * is not due to congestion and cWnd is set to the optimum window, so that
+   * the sender keeps transmitting at the estimated available bandwidth.
+   * Without a bandwidth estimate, the NewReno response is used.
+   *
+   * \param tcb internal congestion state
+   * \param bytesInFlight bytes in flight
+   */
   virtual void ExplicitRetransmit (Ptr<TcpSocketState> tcb, uint32_t bytesInFlight);
 
+  /**
+   * \brief Update the bandwidth estimate and publish the pacing rate
+   *
+   * Once per RTT, the estimated bandwidth times PacingGain is published in
+   * TcpSocketState::m_pacingRate, which the socket uses if pacing is enabled.
+   *
+   * \param tcb internal congestion state
+   * \param packetsAcked count of packets acked
+   * \param rtt last RTT
+   */
   virtual void PktsAcked (Ptr<TcpSocketState> tcb, uint32_t packetsAcked,
                           const Time& rtt);
 
   virtual Ptr<TcpCongestionOps> Fork ();
 
+  /**
+   * \brief Get the bandwidth estimator
+   * \return the bandwidth estimator used by this congestion control
+   */
+  Ptr<TcpBwEstimator> GetBwEstimator (void) const;
+
 private:
   /**
-   * Estimate the network's bandwidth
+   * Set the RTT multiple used as the bandwidth estimation window
+   *
+   * \param [in] k the window length, in RTTs
+   */
+  void SetK (uint32_t k);
+
+  /**
+   * Get the RTT multiple used as the bandwidth estimation window
    *
-   * \param [in] rtt the RTT estimation.
-   * \param [in] tcb the socket state.
+   * \return the window length, in RTTs
    */
-  void EstimateBW (Ptr<TcpSocketState> tcb, const Time& rtt);
+  uint32_t GetK (void) const;
 
 protected:
-  double                 m_currentBW;              //!< Current value of the estimated BW
+  Ptr<TcpBwEstimator>    m_bwEstimator;            //!< Time sliding window bandwidth estimator
   Time                   m_currentRTT;             //!< Current Value of the RTT
-  Time                   m_prevAckTime;            //!<
-  Time                   m_tLast;                  //!<
-  int                    m_ackedSegments;          //!< The number of segments ACKed between RTTs
-  uint32_t               m_K;
+  uint32_t               m_K;                      //!< Bandwidth estimation window, in RTTs
+  double                 m_pacingGain;             //!< Pacing rate over estimated bandwidth
+  SequenceNumber32       m_warningHighTxMark;      //!< Highest seqno sent at the last congestion warning
 };
 
 } // namespace ns3
@@ -52,7 +52,8 @@ TcpRxBuffer::GetTypeId (void)
  * initialized below is insignificant.
  */
 TcpRxBuffer::TcpRxBuffer (uint32_t n)
-  : m_nextRxSeq (n), m_gotFin (false), m_size (0), m_maxBuffer (32768), m_availBytes (0)
+  : m_nextRxSeq (n), m_gotFin (false), m_size (0), m_maxBuffer (32768), m_availBytes (0),
+    m_first (0), m_count (0)
 {
 }
 
@@ -114,9 +115,9 @@ TcpRxBuffer::MaxRxSequence (void) const
     { // No data allowed beyond FIN
       return m_finSeq;
     }
-  else if (m_data.size () && m_nextRxSeq > m_data.begin ()->first)
+  else if (m_count && m_nextRxSeq > SlotAt (0).m_seq)
     { // No data allowed beyond Rx window allowed
-      return m_data.begin ()->first + SequenceNumber32 (m_maxBuffer);
+      return SlotAt (0).m_seq + SequenceNumber32 (m_maxBuffer);
     }
   return m_nextRxSeq + SequenceNumber32 (m_maxBuffer);
 }
@@ -137,6 +138,101 @@ TcpRxBuffer::Finished (void)
   return (m_gotFin && m_finSeq < m_nextRxSeq);
 }
 
+TcpRxBuffer::Slot &
+TcpRxBuffer::SlotAt (uint32_t i)
+{
+  NS_ASSERT (i < m_count);
+  return m_ring[(m_first + i) & (m_ring.size () - 1)];
+}
+
+const TcpRxBuffer::Slot &
+TcpRxBuffer::SlotAt (uint32_t i) const
+{
+  NS_ASSERT (i < m_count);
+  return m_ring[(m_first + i) & (m_ring.size () - 1)];
+}
+
+uint32_t
+TcpRxBuffer::LowerBound (const SequenceNumber32 &seq) const
+{
+  uint32_t low = 0;
+  uint32_t high = m_count;
+  while (low < high)
+    {
+      uint32_t mid = low + (high - low) / 2;
+      if (SlotAt (mid).m_seq < seq)
+        {
+          low = mid + 1;
+        }
+      else
+        {
+          high = mid;
+        }
+    }
+  return low;
+}
+
+void
+TcpRxBuffer::InsertSlot (uint32_t i, const SequenceNumber32 &seq, Ptr<Packet> p)
+{
+  NS_LOG_FUNCTION (this << i << seq << p);
+  NS_ASSERT (i <= m_count);
+
+  if (m_count == m_ring.size ())
+    {
+      // Full: double the ring, moving the slots to its beginning
+      std::vector<Slot> ring (std::max<std::size_t> (16, 2 * m_ring.size ()));
+      for (uint32_t j = 0; j < m_count; ++j)
+        {
+          ring[j] = SlotAt (j);
+        }
+      m_ring.swap (ring);
+      m_first = 0;
+    }
+
+  uint32_t mask = m_ring.size () - 1;
+  if (i == 0 && m_count > 0)
+    {
+      m_first = (m_first + mask) & mask;
+    }
+  else
+    {
+      // Shift the following slots by one position
+      for (uint32_t j = m_count; j > i; --j)
+        {
+          m_ring[(m_first + j) & mask] = m_ring[(m_first + j - 1) & mask];
+        }
+    }
+  ++m_count;
+
+  Slot &slot = SlotAt (i);
+  slot.m_seq = seq;
+  slot.m_packet = p;
+}
+
+void
+TcpRxBuffer::EraseSlot (uint32_t i)
+{
+  NS_LOG_FUNCTION (this << i);
+  NS_ASSERT (i < m_count);
+
+  uint32_t mask = m_ring.size () - 1;
+  if (i == 0)
+    {
+      m_ring[m_first].m_packet = 0;
+      m_first = (m_first + 1) & mask;
+    }
+  else
+    {
+      for (uint32_t j = i; j + 1 < m_count; ++j)
+        {
+          m_ring[(m_first + j) & mask] = m_ring[(m_first + j + 1) & mask];
+        }
+      m_ring[(m_first + m_count - 1) & mask].m_packet = 0;
+    }
+  --m_count;
+}
+
 bool
 TcpRxBuffer::Add (Ptr<Packet> p, TcpHeader const& tcph)
 {
@@ -150,35 +246,49 @@ TcpRxBuffer::Add (Ptr<Packet> p, TcpHeader const& tcph)
 
   // Trim packet to fit Rx window specification
   if (headSeq < m_nextRxSeq) headSeq = m_nextRxSeq;
-  if (m_data.size ())
+  if (m_count)
     {
-      SequenceNumber32 maxSeq = m_data.begin ()->first + SequenceNumber32 (m_maxBuffer);
+      SequenceNumber32 maxSeq = SlotAt (0).m_seq + SequenceNumber32 (m_maxBuffer);
       if (maxSeq < tailSeq) tailSeq = maxSeq;
       if (tailSeq < headSeq) headSeq = tailSeq;
     }
-  // Remove overlapped bytes from packet
-  BufIterator i = m_data.begin ();
-  while (i != m_data.end () && i->first <= tailSeq)
+
+  // When all the buffered data is in order, data starting at nextRxSeq
+  // cannot overlap anything, and goes at the end of the ring
+  bool inOrder = (headSeq == m_nextRxSeq && m_size == m_availBytes);
+
+  if (!inOrder)
     {
-      SequenceNumber32 lastByteSeq = i->first + SequenceNumber32 (i->second->GetSize ());
-      if (lastByteSeq > headSeq)
+      // Remove overlapped bytes from packet, starting from the slot
+      // that may contain headSeq
+      uint32_t i = LowerBound (headSeq);
+      if (i > 0)
         {
-          if (i->first > headSeq && lastByteSeq < tailSeq)
-            { // Rare case: Existing packet is embedded fully in the new packet
-              m_size -= i->second->GetSize ();
-              m_data.erase (i++);
-              continue;
-            }
-          if (i->first <= headSeq)
-            { // Incoming head is overlapped
-              headSeq = lastByteSeq;
-            }
-          if (lastByteSeq >= tailSeq)
-            { // Incoming tail is overlapped
-              tailSeq = i->first;
+          --i;
+        }
+      while (i < m_count && SlotAt (i).m_seq <= tailSeq)
+        {
+          const Slot &slot = SlotAt (i);
+          SequenceNumber32 lastByteSeq = slot.m_seq + SequenceNumber32 (slot.m_packet->GetSize ());
+          if (lastByteSeq > headSeq)
+            {
+              if (slot.m_seq > headSeq && lastByteSeq < tailSeq)
+                { // Rare case: Existing packet is embedded fully in the new packet
+                  m_size -= slot.m_packet->GetSize ();
+                  EraseSlot (i);
+                  continue;
+                }
+              if (slot.m_seq <= headSeq)
+                { // Incoming head is overlapped
+                  headSeq = lastByteSeq;
+                }
+              if (lastByteSeq >= tailSeq)
+                { // Incoming tail is overlapped
+                  tailSeq = slot.m_seq;
+                }
             }
+          ++i;
         }
-      ++i;
     }
   // We now know how much we are going to store, trim the packet
   if (headSeq >= tailSeq)
@@ -190,12 +300,21 @@ TcpRxBuffer::Add (Ptr<Packet> p, TcpHeader const& tcph)
     {
       uint32_t start = headSeq - tcph.GetSequenceNumber ();
       uint32_t length = tailSeq - headSeq;
-      p = p->CreateFragment (start, length);
+      // The buffer owns the packet it stores, as Extract extends it
+      if (start != 0 || length != pktSize)
+        {
+          p = p->CreateFragment (start, length);
+        }
+      else
+        {
+          p = p->Copy ();
+        }
       NS_ASSERT (length == p->GetSize ());
     }
   // Insert packet into buffer
-  NS_ASSERT (m_data.find (headSeq) == m_data.end ()); // Shouldn't be there yet
-  m_data [ headSeq ] = p;
+  uint32_t pos = inOrder ? m_count : LowerBound (headSeq);
+  NS_ASSERT (pos == m_count || SlotAt (pos).m_seq != headSeq); // Shouldn't be there yet
+  InsertSlot (pos, headSeq, p);
 
   if (headSeq > m_nextRxSeq)
     {
@@ -206,18 +325,13 @@ TcpRxBuffer::Add (Ptr<Packet> p, TcpHeader const& tcph)
   NS_LOG_LOGIC ("Buffered packet of seqno=" << headSeq << " len=" << p->GetSize ());
   // Update variables
   m_size += p->GetSize ();      // Occupancy
-  for (BufIterator i = m_data.begin (); i != m_data.end (); ++i)
+  // Only the new segment can start at nextRxSeq; it may fill a hole
+  // before other segments
+  for (uint32_t i = pos; i < m_count && SlotAt (i).m_seq == m_nextRxSeq; ++i)
     {
-      if (i->first < m_nextRxSeq)
-        {
-          continue;
-        }
-      else if (i->first > m_nextRxSeq)
-        {
-          break;
-        };
-      m_nextRxSeq = i->first + SequenceNumber32 (i->second->GetSize ());
-      m_availBytes += i->second->GetSize ();
+      const Slot &slot = SlotAt (i);
+      m_nextRxSeq = slot.m_seq + SequenceNumber32 (slot.m_packet->GetSize ());
+      m_availBytes += slot.m_packet->GetSize ();
       ClearSackList (m_nextRxSeq);
     }
   NS_LOG_LOGIC ("Updated buffer occupancy=" << m_size << " nextRxSeq=" << m_nextRxSeq);
@@ -351,7 +465,7 @@ TcpRxBuffer::ClearSackList (const SequenceNumber32 &seq)
     }
 }
 
-TcpOptionSack::SackList
+const TcpOptionSack::SackList &
 TcpRxBuffer::GetSackList () const
 {
   return m_sackList;
@@ -365,40 +479,51 @@ TcpRxBuffer::Extract (uint32_t maxSize)
   uint32_t extractSize = std::min (maxSize, m_availBytes);
   NS_LOG_LOGIC ("Requested to extract " << extractSize << " bytes from TcpRxBuffer of size=" << m_size);
   if (extractSize == 0) return 0;  // No contiguous block to return
-  NS_ASSERT (m_data.size ()); // At least we have something to extract
-  Ptr<Packet> outPkt = Create<Packet> (); // The packet that contains all the data to return
-  BufIterator i;
+  NS_ASSERT (m_count); // At least we have something to extract
+  Ptr<Packet> outPkt; // The packet that contains all the data to return
   while (extractSize)
     { // Check the buffered data for delivery
-      i = m_data.begin ();
-      NS_ASSERT (i->first <= m_nextRxSeq); // in-sequence data expected
+      Slot &slot = SlotAt (0);
+      NS_ASSERT (slot.m_seq <= m_nextRxSeq); // in-sequence data expected
       // Check if we send the whole pkt or just a partial
-      uint32_t pktSize = i->second->GetSize ();
+      Ptr<Packet> data;
+      uint32_t pktSize = slot.m_packet->GetSize ();
       if (pktSize <= extractSize)
-        { // Whole packet is extracted
-          outPkt->AddAtEnd (i->second);
-          m_data.erase (i);
+        { // Whole packet is extracted; the buffer does not need it anymore
+          data = slot.m_packet;
+          EraseSlot (0);
           m_size -= pktSize;
           m_availBytes -= pktSize;
           extractSize -= pktSize;
         }
       else
         { // Partial is extracted and done
-          outPkt->AddAtEnd (i->second->CreateFragment (0, extractSize));
-          m_data[i->first + SequenceNumber32 (extractSize)] = i->second->CreateFragment (extractSize, pktSize - extractSize);
-          m_data.erase (i);
+          data = slot.m_packet->CreateFragment (0, extractSize);
+          slot.m_packet->RemoveAtStart (extractSize);
+          slot.m_seq = slot.m_seq + SequenceNumber32 (extractSize);
           m_size -= extractSize;
           m_availBytes -= extractSize;
           extractSize = 0;
         }
+
+      if (outPkt == 0)
+        {
+          outPkt = data;
+        }
+      else
+        {
+          outPkt->AddAtEnd (data);
+        }
     }
   if (outPkt->GetSize () == 0)
     {
       NS_LOG_LOGIC ("Nothing extracted.");
       return 0;
     }
+  // As if the data were copied in a new packet, only byte tags are delivered
+  outPkt->RemoveAllPacketTags ();
   NS_LOG_LOGIC ("Extracted " << outPkt->GetSize ( ) << " bytes, bufsize=" << m_size
-                             << ", num pkts in buffer=" << m_data.size ());
+                             << ", num pkts in buffer=" << m_count);
   return outPkt;
 }
 
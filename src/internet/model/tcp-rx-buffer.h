@@ -21,7 +21,7 @@
 #ifndef TCP_RX_BUFFER_H
 #define TCP_RX_BUFFER_H
 
-#include <map>
+#include <vector>
 #include "ns3/traced-value.h"
 #include "ns3/trace-source-accessor.h"
 #include "ns3/sequence-number.h"
@@ -69,6 +69,20 @@ class Packet;
  *
  * \see GetSackList
  * \see UpdateSackList
+ *
+ * Storage
+ * -------
+ *
+ * The segments are stored, in sequence order, in a ring of slots that
+ * grows by doubling and is never shrunk, so that a bulk receiver reaches
+ * a steady state without allocating. A segment that arrives in order while
+ * nothing is buffered out of order is appended to the ring without any
+ * search; out-of-order segments are placed with a binary search on the
+ * sequence numbers of the slots.
+ *
+ * Extract hands the buffered packets to the application without copying
+ * them when the requested amount ends on a segment boundary; the first
+ * packet is then extended with the following ones.
  */
 class TcpRxBuffer : public Object
 {
@@ -166,7 +180,7 @@ public:
    *
    * \return a list of isolated blocks
    */
-  TcpOptionSack::SackList GetSackList () const;
+  const TcpOptionSack::SackList & GetSackList () const;
 
   /**
    * \brief Get the size of Sack list
@@ -209,17 +223,61 @@ private:
    */
   void ClearSackList (const SequenceNumber32 &seq);
 
+  /**
+   * \brief A segment stored in the ring
+   */
+  struct Slot
+  {
+    SequenceNumber32 m_seq; //!< Sequence number of the first byte
+    Ptr<Packet> m_packet;   //!< Data of the segment
+  };
+
+  /**
+   * \brief Get a slot, counting from the first one
+   * \param i index of the slot, lower than m_count
+   * \return the slot
+   */
+  Slot & SlotAt (uint32_t i);
+
+  /**
+   * \brief Get a slot, counting from the first one
+   * \param i index of the slot, lower than m_count
+   * \return the slot
+   */
+  const Slot & SlotAt (uint32_t i) const;
+
+  /**
+   * \brief Get the first slot whose sequence number is not lower than seq
+   * \param seq sequence number to search
+   * \return the index of the slot, or m_count if there is none
+   */
+  uint32_t LowerBound (const SequenceNumber32 &seq) const;
+
+  /**
+   * \brief Insert a segment in the ring
+   * \param i index that the new slot will have
+   * \param seq sequence number of the segment
+   * \param p data of the segment
+   */
+  void InsertSlot (uint32_t i, const SequenceNumber32 &seq, Ptr<Packet> p);
+
+  /**
+   * \brief Remove a slot from the ring
+   * \param i index of the slot
+   */
+  void EraseSlot (uint32_t i);
+
   TcpOptionSack::SackList m_sackList; //!< Sack list (updated constantly)
 
-  /// container for data stored in the buffer
-  typedef std::map<SequenceNumber32, Ptr<Packet> >::iterator BufIterator;
   TracedValue<SequenceNumber32> m_nextRxSeq; //!< Seqnum of the first missing byte in data (RCV.NXT)
   SequenceNumber32 m_finSeq;                 //!< Seqnum of the FIN packet
   bool m_gotFin;                             //!< Did I received FIN packet?
   uint32_t m_size;                           //!< Number of total data bytes in the buffer, not necessarily contiguous
   uint32_t m_maxBuffer;                      //!< Upper bound of the number of data bytes in buffer (RCV.WND)
   uint32_t m_availBytes;                     //!< Number of bytes available to read, i.e. contiguous block at head
-  std::map<SequenceNumber32, Ptr<Packet> > m_data; //!< Corresponding data (may be null)
+  std::vector<Slot> m_ring;                  //!< Ring of segments; the size is a power of two
+  uint32_t m_first;                          //!< Position in m_ring of the first slot
+  uint32_t m_count;                          //!< Number of slots in use
 };
 
 } //namepsace ns3
@@ -139,6 +139,14 @@ TcpSocketBase::GetTypeId (void)
                     BooleanValue (false),
                     MakeBooleanAccessor (&TcpSocketBase::m_ecn),
                     MakeBooleanChecker ())
+    .AddAttribute ("Pacing", "Enable or disable the pacing of data segments",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&TcpSocketBase::m_pacing),
+                   MakeBooleanChecker ())
+    .AddAttribute ("MaxPacingRate", "Maximum rate at which data segments are paced",
+                   DataRateValue (DataRate ("4Gb/s")),
+                   MakeDataRateAccessor (&TcpSocketBase::m_maxPacingRate),
+                   MakeDataRateChecker ())
     .AddTraceSource ("RTO",
                      "Retransmission timeout",
                      MakeTraceSourceAccessor (&TcpSocketBase::m_rto),
@@ -275,7 +283,8 @@ TcpSocketState::TcpSocketState (void)
     // Change m_nextTxSequence for non-zero initial sequence number
     m_nextTxSequence (0),
     m_rcvTimestampValue (0),
-    m_rcvTimestampEchoReply (0)
+    m_rcvTimestampEchoReply (0),
+    m_pacingRate (0)
 {
 }
 
@@ -292,7 +301,8 @@ TcpSocketState::TcpSocketState (const TcpSocketState &other)
     m_highTxMark (other.m_highTxMark),
     m_nextTxSequence (other.m_nextTxSequence),
     m_rcvTimestampValue (other.m_rcvTimestampValue),
-    m_rcvTimestampEchoReply (other.m_rcvTimestampEchoReply)
+    m_rcvTimestampEchoReply (other.m_rcvTimestampEchoReply),
+    m_pacingRate (other.m_pacingRate)
 {
 }
 
@@ -360,6 +370,9 @@ TcpSocketBase::TcpSocketBase (void)
     m_timestampEnabled (true),
     m_timestampToEcho (0),
     m_sendPendingDataEvent (),
+    m_pacing (false),
+    m_maxPacingRate (0),
+    m_pacingEvent (),
     // Set m_recover to the initial sequence number
     m_recover (0),
     m_retxThresh (3),
@@ -445,6 +458,8 @@ TcpSocketBase::TcpSocketBase (const TcpSocketBase& sock)
     m_sndWindShift (sock.m_sndWindShift),
     m_timestampEnabled (sock.m_timestampEnabled),
     m_timestampToEcho (sock.m_timestampToEcho),
+    m_pacing (sock.m_pacing),
+    m_maxPacingRate (sock.m_maxPacingRate),
     m_recover (sock.m_recover),
     m_retxThresh (sock.m_retxThresh),
     m_limitedTx (sock.m_limitedTx),
@@ -1346,9 +1361,10 @@ TcpSocketBase::DoForwardUp (Ptr<Packet> packet, const Address &fromAddress,
        */
       m_rWnd = tcpHeader.GetWindowSize ();
 
-      if (tcpHeader.HasOption (TcpOption::WINSCALE) && m_winScalingEnabled)
+      uint8_t scale;
+      if (m_winScalingEnabled && tcpHeader.GetWindowScale (scale))
         {
-          ProcessOptionWScale (tcpHeader.GetOption (TcpOption::WINSCALE));
+          ProcessOptionWScale (scale);
         }
       else
         {
@@ -1357,7 +1373,7 @@ TcpSocketBase::DoForwardUp (Ptr<Packet> packet, const Address &fromAddress,
 
       if (tcpHeader.HasOption (TcpOption::SACKPERMITTED) && m_sackEnabled)
         {
-          ProcessOptionSackPermitted (tcpHeader.GetOption (TcpOption::SACKPERMITTED));
+          ProcessOptionSackPermitted ();
         }
       else
         {
@@ -1365,10 +1381,10 @@ TcpSocketBase::DoForwardUp (Ptr<Packet> packet, const Address &fromAddress,
         }
 
       // When receiving a <SYN> or <SYN-ACK> we should adapt TS to the other end
-      if (tcpHeader.HasOption (TcpOption::TS) && m_timestampEnabled)
+      uint32_t timestamp, echo;
+      if (m_timestampEnabled && tcpHeader.GetTimestamp (timestamp, echo))
         {
-          ProcessOptionTimestamp (tcpHeader.GetOption (TcpOption::TS),
-                                  tcpHeader.GetSequenceNumber ());
+          ProcessOptionTimestamp (timestamp, echo, tcpHeader.GetSequenceNumber ());
         }
       else
         {
@@ -1388,9 +1404,10 @@ TcpSocketBase::DoForwardUp (Ptr<Packet> packet, const Address &fromAddress,
   else if (tcpHeader.GetFlags () & TcpHeader::ACK)
     {
       NS_ASSERT (!(tcpHeader.GetFlags () & TcpHeader::SYN));
+      uint32_t timestamp, echo;
       if (m_timestampEnabled)
         {
-          if (!tcpHeader.HasOption (TcpOption::TS))
+          if (!tcpHeader.GetTimestamp (timestamp, echo))
             {
               // Ignoring segment without TS, RFC 7323
               NS_LOG_LOGIC ("At state " << TcpStateName[m_state] <<
@@ -1401,8 +1418,7 @@ TcpSocketBase::DoForwardUp (Ptr<Packet> packet, const Address &fromAddress,
             }
           else
             {
-              ProcessOptionTimestamp (tcpHeader.GetOption (TcpOption::TS),
-                                      tcpHeader.GetSequenceNumber ());
+              ProcessOptionTimestamp (timestamp, echo, tcpHeader.GetSequenceNumber ());
             }
         }
 
@@ -1619,22 +1635,12 @@ void
 TcpSocketBase::ReadOptions (const TcpHeader &tcpHeader, bool &scoreboardUpdated)
 {
   NS_LOG_FUNCTION (this << tcpHeader);
-  TcpHeader::TcpOptionList::const_iterator it;
-  const TcpHeader::TcpOptionList options = tcpHeader.GetOptionList ();
 
-  for (it = options.begin (); it != options.end (); ++it)
+  // Check only for ACK options here
+  TcpOptionSack::SackList list;
+  if (tcpHeader.GetSackList (list))
     {
-      const Ptr<const TcpOption> option = (*it);
-
-      // Check only for ACK options here
-      switch (option->GetKind ())
-        {
-        case TcpOption::SACK:
-          scoreboardUpdated = ProcessOptionSack (option);
-          break;
-        default:
-          continue;
-        }
+      scoreboardUpdated = ProcessOptionSack (list);
     }
 }
 
@@ -1695,16 +1701,17 @@ TcpSocketBase::DupAck ()
   // NOTE: We count also the dupAcks received in CA_RECOVERY
   ++m_dupAckCount;
 
-  if (m_tcb->m_congState == TcpSocketState::CA_OPEN)
+  if (m_tcb->m_congState == TcpSocketState::CA_OPEN
+      || m_tcb->m_congState == TcpSocketState::CA_CWR)
     {
-      // From Open we go Disorder
+      // From Open (or CWR, whose window is already reduced) we go Disorder
       NS_ASSERT_MSG (m_dupAckCount == 1, "From OPEN->DISORDER but with " <<
                      m_dupAckCount << " dup ACKs");
 
+      NS_LOG_DEBUG (TcpSocketState::TcpCongStateName[m_tcb->m_congState] << " -> DISORDER");
+
       m_congestionControl->CongestionStateSet (m_tcb, TcpSocketState::CA_DISORDER);
       m_tcb->m_congState = TcpSocketState::CA_DISORDER;
-
-      NS_LOG_DEBUG ("OPEN -> DISORDER");
     }
 
   if (m_tcb->m_congState == TcpSocketState::CA_DISORDER)
@@ -1771,7 +1778,11 @@ TcpSocketBase::ReceivedAck (Ptr<Packet> packet, const TcpHeader& tcpHeader)
 
   if (ackNumber > m_txBuffer->HeadSequence () && (m_tcb->m_ecnState != TcpSocketState::ECN_DISABLED) && (tcpHeader.GetFlags () & TcpHeader::ECE))
         {
-          if (m_ecnEchoSeq < tcpHeader.GetAckNumber ())
+          // The echoes acknowledging data sent before the last CWR concern
+          // the window already reduced
+          if (m_ecnEchoSeq < tcpHeader.GetAckNumber ()
+              && (m_tcb->m_ecnState != TcpSocketState::ECN_CWR_SENT
+                  || tcpHeader.GetAckNumber () > m_ecnCWRSeq))
             {
               NS_LOG_INFO ("Received ECN Echo is valid");
               m_ecnEchoSeq = tcpHeader.GetAckNumber ();
@@ -1934,6 +1945,19 @@ TcpSocketBase::ProcessAck (const SequenceNumber32 &ackNumber, bool scoreboardUpd
                             ackNumber);
               m_congestionControl->PktsAcked (m_tcb, segsAcked, m_lastRtt);
             }
+          else if (m_tcb->m_congState == TcpSocketState::CA_CWR)
+            {
+              m_congestionControl->PktsAcked (m_tcb, segsAcked, m_lastRtt);
+              // The window reduced on the ECN Echo ends with the segment
+              // carrying the CWR flag
+              if (ackNumber > m_ecnCWRSeq)
+                {
+                  m_congestionControl->CongestionStateSet (m_tcb, TcpSocketState::CA_OPEN);
+                  m_tcb->m_congState = TcpSocketState::CA_OPEN;
+                  NS_LOG_DEBUG (segsAcked << " segments acked in CA_CWR, ack of " <<
+                                ackNumber << ", exiting CA_CWR -> CA_OPEN");
+                }
+            }
           else if (m_tcb->m_congState == TcpSocketState::CA_DISORDER)
             {
               // The network reorder packets. Linux changes the counting lost
@@ -3043,6 +3067,11 @@ TcpSocketBase::SendPendingData (bool withAck)
   // else branch to control silly window syndrome and Nagle)
   while (availableWindow > 0)
     {
+      if (m_pacing && m_pacingEvent.IsRunning ())
+        {
+          NS_LOG_INFO ("Pacing: waiting for the departure time of the next segment");
+          break;
+        }
       if (m_tcb->m_congState == TcpSocketState::CA_OPEN
           && m_state == TcpSocket::FIN_WAIT_1)
         {
@@ -3113,6 +3142,17 @@ TcpSocketBase::SendPendingData (bool withAck)
                         " size " << sz);
 
           ++nPacketsSent;
+
+          if (m_pacing)
+            {
+              DataRate rate = GetPacingRate ();
+              if (rate.GetBitRate () > 0)
+                {
+                  Time gap = rate.CalculateBytesTxTime (sz);
+                  NS_LOG_LOGIC ("Pacing at " << rate << ", next segment in " << gap);
+                  m_pacingEvent = Simulator::Schedule (gap, &TcpSocketBase::PacingTimeout, this);
+                }
+            }
         }
 
       // (C.4) The estimate of the amount of data outstanding in the
@@ -3133,6 +3173,33 @@ TcpSocketBase::SendPendingData (bool withAck)
   return nPacketsSent;
 }
 
+DataRate
+TcpSocketBase::GetPacingRate () const
+{
+  uint64_t bps = m_tcb->m_pacingRate.GetBitRate ();
+
+  if (bps == 0)
+    {
+      Time srtt = m_rtt->GetEstimate ();
+      if (srtt.IsZero ())
+        {
+          return DataRate (0);
+        }
+      double rate = m_tcb->m_cWnd * 8.0 / srtt.GetSeconds ();
+      rate *= (m_tcb->m_cWnd < m_tcb->m_ssThresh) ? 2.0 : 1.2;
+      bps = static_cast<uint64_t> (rate);
+    }
+
+  return DataRate (std::min (bps, m_maxPacingRate.GetBitRate ()));
+}
+
+void
+TcpSocketBase::PacingTimeout ()
+{
+  NS_LOG_FUNCTION (this);
+  SendPendingData (m_connected);
+}
+
 uint32_t
 TcpSocketBase::UnAckDataCount () const
 {
@@ -3229,6 +3296,14 @@ TcpSocketBase::ReceivedData (Ptr<Packet> p, const TcpHeader& tcpHeader)
   NS_LOG_DEBUG ("Data segment, seq=" << tcpHeader.GetSequenceNumber () <<
                 " pkt size=" << p->GetSize () );
 
+  // Check if the sender has responded to ECN echo by reducing the Congestion Window
+  if ((tcpHeader.GetFlags () & TcpHeader::CWR) && m_tcb->m_ecnState == TcpSocketState::ECN_ECE_SENT)
+    {
+      // No packet with CE bit set since the last ECN Echo: stop sending ECN Echo messages
+      m_tcb->m_ecnState = TcpSocketState::ECN_IDLE;
+      NS_LOG_DEBUG ("ECN_ECE_SENT -> ECN_IDLE");
+    }
+
   // Put into Rx buffer
   SequenceNumber32 expectedSeq = m_rxBuffer->NextRxSequence ();
   if (!m_rxBuffer->Add (p, tcpHeader))
@@ -3327,11 +3402,10 @@ TcpSocketBase::EstimateRtt (const TcpHeader& tcpHeader)
       RttHistory& h = m_history.front ();
       if (!h.retx && ackSeq >= (h.seq + SequenceNumber32 (h.count)))
         { // Ok to use this sample
-          if (m_timestampEnabled && tcpHeader.HasOption (TcpOption::TS))
+          uint32_t timestamp, echo;
+          if (m_timestampEnabled && tcpHeader.GetTimestamp (timestamp, echo))
             {
-              Ptr<const TcpOptionTS> ts;
-              ts = DynamicCast<const TcpOptionTS> (tcpHeader.GetOption (TcpOption::TS));
-              m = TcpOptionTS::ElapsedTimeFromTsValue (ts->GetEcho ());
+              m = TcpOptionTS::ElapsedTimeFromTsValue (echo);
             }
           else
             {
@@ -3661,6 +3735,7 @@ TcpSocketBase::CancelAllTimers ()
   m_lastAckEvent.Cancel ();
   m_timewaitEvent.Cancel ();
   m_sendPendingDataEvent.Cancel ();
+  m_pacingEvent.Cancel ();
 }
 
 /* Move TCP to Time_Wait state and schedule a transition to Closed state */
@@ -3855,15 +3930,13 @@ TcpSocketBase::AddOptions (TcpHeader& header)
 }
 
 void
-TcpSocketBase::ProcessOptionWScale (const Ptr<const TcpOption> option)
+TcpSocketBase::ProcessOptionWScale (uint8_t scale)
 {
-  NS_LOG_FUNCTION (this << option);
-
-  Ptr<const TcpOptionWinScale> ws = DynamicCast<const TcpOptionWinScale> (option);
+  NS_LOG_FUNCTION (this << static_cast<uint32_t> (scale));
 
   // In naming, we do the contrary of RFC 1323. The received scaling factor
   // is Rcv.Wind.Scale (and not Snd.Wind.Scale)
-  m_sndWindShift = ws->GetScale ();
+  m_sndWindShift = scale;
 
   if (m_sndWindShift > 14)
     {
@@ -3905,39 +3978,31 @@ TcpSocketBase::AddOptionWScale (TcpHeader &header)
   NS_LOG_FUNCTION (this << header);
   NS_ASSERT (header.GetFlags () & TcpHeader::SYN);
 
-  Ptr<TcpOptionWinScale> option = CreateObject<TcpOptionWinScale> ();
-
   // In naming, we do the contrary of RFC 1323. The sended scaling factor
   // is Snd.Wind.Scale (and not Rcv.Wind.Scale)
 
   m_rcvWindShift = CalculateWScale ();
-  option->SetScale (m_rcvWindShift);
-
-  header.AppendOption (option);
+  header.AppendWindowScale (m_rcvWindShift);
 
   NS_LOG_INFO (m_node->GetId () << " Send a scaling factor of " <<
                static_cast<int> (m_rcvWindShift));
 }
 
 bool
-TcpSocketBase::ProcessOptionSack (const Ptr<const TcpOption> option)
+TcpSocketBase::ProcessOptionSack (const TcpOptionSack::SackList &list)
 {
-  NS_LOG_FUNCTION (this << option);
+  NS_LOG_FUNCTION (this);
 
-  Ptr<const TcpOptionSack> s = DynamicCast<const TcpOptionSack> (option);
-  TcpOptionSack::SackList list = s->GetSackList ();
   return m_txBuffer->Update (list);
 }
 
 void
-TcpSocketBase::ProcessOptionSackPermitted (const Ptr<const TcpOption> option)
+TcpSocketBase::ProcessOptionSackPermitted (void)
 {
-  NS_LOG_FUNCTION (this << option);
-
-  Ptr<const TcpOptionSackPermitted> s = DynamicCast<const TcpOptionSackPermitted> (option);
+  NS_LOG_FUNCTION (this);
 
   NS_ASSERT (m_sackEnabled == true);
-  NS_LOG_INFO (m_node->GetId () << " Received a SACK_PERMITTED option " << s);
+  NS_LOG_INFO (m_node->GetId () << " Received a SACK_PERMITTED option");
 }
 
 void
@@ -3946,8 +4011,7 @@ TcpSocketBase::AddOptionSackPermitted (TcpHeader &header)
   NS_LOG_FUNCTION (this << header);
   NS_ASSERT (header.GetFlags () & TcpHeader::SYN);
 
-  Ptr<TcpOptionSackPermitted> option = CreateObject<TcpOptionSackPermitted> ();
-  header.AppendOption (option);
+  header.AppendSackPermitted ();
   NS_LOG_INFO (m_node->GetId () << " Add option SACK-PERMITTED");
 }
 
@@ -3960,7 +4024,7 @@ TcpSocketBase::AddOptionSack (TcpHeader& header)
   uint8_t optionLenAvail = header.GetMaxOptionLength () - header.GetOptionLength ();
   uint8_t allowedSackBlocks = (optionLenAvail - 2) / 8;
 
-  TcpOptionSack::SackList sackList = m_rxBuffer->GetSackList ();
+  const TcpOptionSack::SackList &sackList = m_rxBuffer->GetSackList ();
   if (allowedSackBlocks == 0 || sackList.empty ())
     {
       NS_LOG_LOGIC ("No space available or sack list empty, not adding sack blocks");
@@ -3968,37 +4032,33 @@ TcpSocketBase::AddOptionSack (TcpHeader& header)
     }
 
   // Append the allowed number of SACK blocks
-  Ptr<TcpOptionSack> option = CreateObject<TcpOptionSack> ();
-  TcpOptionSack::SackList::iterator i;
+  TcpOptionSack::SackList::const_iterator i;
   for (i = sackList.begin (); allowedSackBlocks > 0 && i != sackList.end (); ++i)
     {
       NS_LOG_LOGIC ("Left edge of the block: " << (*i).first << " Right edge of the block: " << (*i).second);
-      option->AddSackBlock (*i);
+      header.AppendSackBlock (*i);
       allowedSackBlocks--;
     }
 
-  header.AppendOption (option);
   NS_LOG_INFO (m_node->GetId () << " Add option SACK");
 }
 
 void
-TcpSocketBase::ProcessOptionTimestamp (const Ptr<const TcpOption> option,
+TcpSocketBase::ProcessOptionTimestamp (uint32_t timestamp, uint32_t echo,
                                        const SequenceNumber32 &seq)
 {
-  NS_LOG_FUNCTION (this << option);
+  NS_LOG_FUNCTION (this << timestamp << echo << seq);
 
-  Ptr<const TcpOptionTS> ts = DynamicCast<const TcpOptionTS> (option);
-
-  m_tcb->m_rcvTimestampValue = ts->GetTimestamp ();
-  m_tcb->m_rcvTimestampEchoReply = ts->GetEcho();
+  m_tcb->m_rcvTimestampValue = timestamp;
+  m_tcb->m_rcvTimestampEchoReply = echo;
 
   if (seq == m_rxBuffer->NextRxSequence () && seq <= m_highTxAck)
     {
-      m_timestampToEcho = ts->GetTimestamp ();
+      m_timestampToEcho = timestamp;
     }
 
   NS_LOG_INFO (m_node->GetId () << " Got timestamp=" <<
-               m_timestampToEcho << " and Echo="     << ts->GetEcho ());
+               m_timestampToEcho << " and Echo="     << echo);
 }
 
 void
@@ -4006,14 +4066,10 @@ TcpSocketBase::AddOptionTimestamp (TcpHeader& header)
 {
   NS_LOG_FUNCTION (this << header);
 
-  Ptr<TcpOptionTS> option = CreateObject<TcpOptionTS> ();
-
-  option->SetTimestamp (TcpOptionTS::NowToTsValue ());
-  option->SetEcho (m_timestampToEcho);
-
-  header.AppendOption (option);
+  uint32_t timestamp = TcpOptionTS::NowToTsValue ();
+  header.AppendTimestamp (timestamp, m_timestampToEcho);
   NS_LOG_INFO (m_node->GetId () << " Add option TS, ts=" <<
-               option->GetTimestamp () << " echo=" << m_timestampToEcho);
+               timestamp << " echo=" << m_timestampToEcho);
 }
 
 void TcpSocketBase::UpdateWindowSize (const TcpHeader &header)
@@ -33,6 +33,7 @@
 #include "ns3/ipv6-header.h"
 #include "ns3/ipv6-interface.h"
 #include "ns3/event-id.h"
+#include "ns3/data-rate.h"
 #include "tcp-tx-buffer.h"
 #include "tcp-rx-buffer.h"
 #include "rtt-estimator.h"
@@ -199,6 +200,9 @@ public:
   uint32_t               m_rcvTimestampValue;     //!< Receiver Timestamp value 
   uint32_t               m_rcvTimestampEchoReply; //!< Sender Timestamp echoed by the receiver
 
+  // Pacing
+  DataRate               m_pacingRate;      //!< Pacing rate published by the congestion control (0 if none)
+
   /**
    * \brief Get cwnd in segments rather than bytes
    *
@@ -318,10 +322,12 @@ public:
  *
  * SYN and SYN-ACK options, which are allowed only at the beginning of the
  * connection, are managed in the DoForwardUp and SendEmptyPacket methods.
- * To read all others, we have set up a cycle inside ReadOptions. For adding
+ * The others are read inside ReadOptions. For adding
  * them, there is no a unique place, since the options (and the information
  * available to build them) are scattered around the code. For instance,
  * the SACK option is built in SendEmptyPacket only under certain conditions.
+ * The options are read and added as values (e.g. TcpHeader::GetTimestamp
+ * and TcpHeader::AppendTimestamp), without creating TcpOption objects.
  *
  * SACK
  * ----
@@ -694,6 +700,23 @@ protected:
    */
   uint32_t SendPendingData (bool withAck = false);
 
+  /**
+   * \brief Get the rate at which segments are paced
+   *
+   * This is the rate published by the congestion control in
+   * TcpSocketState::m_pacingRate or, if none is published, the congestion
+   * window over the smoothed RTT (doubled in slow start, increased by 20%
+   * otherwise, as in Linux). The rate is capped to MaxPacingRate.
+   *
+   * \returns the pacing rate, or 0 if there is not enough information yet
+   */
+  DataRate GetPacingRate (void) const;
+
+  /**
+   * \brief Pacing timer expired: try to send the next segment
+   */
+  void PacingTimeout (void);
+
   /**
    * \brief Extract at most maxSize bytes from the TxBuffer at sequence seq, add the
    *        TCP header, and send to TcpL4Protocol
@@ -1034,9 +1057,9 @@ protected:
    * Read the window scale option (encoded logarithmically) and save it.
    * Per RFC 1323, the value can't exceed 14.
    *
-   * \param option Window scale option read from the header
+   * \param scale Window scale read from the header
    */
-  void ProcessOptionWScale (const Ptr<const TcpOption> option);
+  void ProcessOptionWScale (uint8_t scale);
   /**
    * \brief Add the window scale option to the header
    *
@@ -1061,18 +1084,16 @@ protected:
    *
    * Currently this is a placeholder, since no operations should be done
    * on such option.
-   *
-   * \param option SACK PERMITTED option from the header
    */
-  void ProcessOptionSackPermitted (const Ptr<const TcpOption> option);
+  void ProcessOptionSackPermitted (void);
 
   /**
    * \brief Read the SACK option
    *
-   * \param option SACK option from the header
+   * \param list SACK blocks from the header
    * \returns true in case of an update to the SACKed blocks
    */
-  bool ProcessOptionSack (const Ptr<const TcpOption> option);
+  bool ProcessOptionSack (const TcpOptionSack::SackList &list);
 
   /**
    * \brief Add the SACK PERMITTED option to the header
@@ -1095,10 +1116,11 @@ protected:
    * to utilize later to calculate RTT.
    *
    * \see EstimateRtt
-   * \param option Option from the segment
+   * \param timestamp Timestamp of the segment
+   * \param echo Echoed timestamp of the segment
    * \param seq Sequence number of the segment
    */
-  void ProcessOptionTimestamp (const Ptr<const TcpOption> option,
+  void ProcessOptionTimestamp (uint32_t timestamp, uint32_t echo,
                                const SequenceNumber32 &seq);
   /**
    * \brief Add the timestamp option to the header
@@ -1190,6 +1212,11 @@ protected:
 
   EventId m_sendPendingDataEvent; //!< micro-delay event to send pending data
 
+  // Pacing
+  bool     m_pacing;           //!< Pacing enabled
+  DataRate m_maxPacingRate;    //!< Maximum pacing rate
+  EventId  m_pacingEvent;      //!< Departure time of the next paced segment
+
   // Fast Retransmit and Recovery
   SequenceNumber32       m_recover;      //!< Previous highest Tx seqnum for fast recovery
   uint32_t               m_retxThresh;   //!< Fast Retransmit threshold
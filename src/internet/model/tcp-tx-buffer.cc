@@ -38,7 +38,8 @@ TcpTxItem::TcpTxItem ()
     m_lost (false),
     m_retrans (false),
     m_lastSent (Time::Min ()),
-    m_sacked (false)
+    m_sacked (false),
+    m_startSeq (0)
 {
 }
 
@@ -47,7 +48,8 @@ TcpTxItem::TcpTxItem (const TcpTxItem &other)
     m_lost (other.m_lost),
     m_retrans (other.m_retrans),
     m_lastSent (other.m_lastSent),
-    m_sacked (other.m_sacked)
+    m_sacked (other.m_sacked),
+    m_startSeq (other.m_startSeq)
 {
 }
 
@@ -112,8 +114,12 @@ TcpTxBuffer::GetTypeId (void)
  * initialized below is insignificant.
  */
 TcpTxBuffer::TcpTxBuffer (uint32_t n)
-  : m_maxBuffer (32768), m_size (0), m_sentSize (0), m_firstByteSeq (n)
+  : m_maxBuffer (32768), m_size (0), m_sentSize (0), m_firstByteSeq (n),
+    m_sentIndexValid (true), m_scoreboardValid (false), m_dupThresh (0),
+    m_segmentSize (0), m_lossBoundaryValid (false), m_lossBoundary (0),
+    m_pipe (0), m_lostItems (0)
 {
+  m_highestSack = std::make_pair (m_sentList.end (), SequenceNumber32 (0));
 }
 
 TcpTxBuffer::~TcpTxBuffer (void)
@@ -180,6 +186,7 @@ TcpTxBuffer::SetHeadSequence (const SequenceNumber32& seq)
   // if you change the head with data already sent, something bad will happen
   NS_ASSERT (m_sentList.size () == 0);
   m_highestSack = std::make_pair (m_sentList.end (), SequenceNumber32 (0));
+  InvalidateScoreboard (true);
 }
 
 bool
@@ -249,6 +256,14 @@ TcpTxBuffer::CopyFromSequence (uint32_t numBytes, const SequenceNumber32& seq)
       // already sent this block completely
       outItem = GetTransmittedSegment (s, seq);
       NS_ASSERT (outItem != 0);
+      if (m_scoreboardValid)
+        {
+          m_pipe -= PipeContribution (outItem);
+          if (outItem->m_lost && !outItem->m_sacked)
+            {
+              --m_lostItems;
+            }
+        }
       outItem->m_retrans = true;
 
       NS_LOG_DEBUG ("Retransmitting [" << seq << ";" << seq + s << "|" << s <<
@@ -277,15 +292,58 @@ TcpTxBuffer::CopyFromSequence (uint32_t numBytes, const SequenceNumber32& seq)
                     m_firstByteSeq + m_sentSize + amount <<"|" << amount <<
                     "] from " << *this);
 
+      // Without SACKed data after seq the loss boundary stays where it is:
+      // the retransmitted part leaves the pipe, and the merged item is
+      // added below
+      bool scoreboardValid = m_scoreboardValid && m_highestSack.second <= seq;
+      uint32_t pipe = m_pipe;
+      uint32_t lostItems = m_lostItems;
+      if (scoreboardValid)
+        {
+          PacketList::const_reverse_iterator it;
+          for (it = m_sentList.rbegin (); it != m_sentList.rend (); ++it)
+            {
+              const TcpTxItem *item = *it;
+              if (item->m_startSeq < seq)
+                {
+                  // Split below: the first part keeps its flags
+                  if (PipeContribution (item) > 0)
+                    {
+                      pipe -= item->m_startSeq + item->m_packet->GetSize () - seq;
+                    }
+                  break;
+                }
+              pipe -= PipeContribution (item);
+              if (item->m_lost)
+                {
+                  --lostItems;
+                }
+            }
+        }
+
       outItem = GetNewSegment (amount);
       NS_ASSERT (outItem != 0);
 
       // Now get outItem from the sent list (there will be a merge)
-      return CopyFromSequence (numBytes, seq);
+      outItem = GetTransmittedSegment (s, seq);
+      NS_ASSERT (outItem != 0);
+      outItem->m_retrans = true;
+
+      if (scoreboardValid)
+        {
+          // GetTransmittedSegment has invalidated the scoreboard
+          m_pipe = pipe;
+          m_lostItems = lostItems;
+          m_scoreboardValid = true;
+        }
     }
 
   outItem->m_lost = false;
   outItem->m_lastSent = Simulator::Now ();
+  if (m_scoreboardValid)
+    {
+      m_pipe += PipeContribution (outItem);
+    }
   Ptr<Packet> toRet = outItem->m_packet->Copy ();
 
   NS_ASSERT (toRet->GetSize () == s);
@@ -301,7 +359,7 @@ TcpTxBuffer::GetNewSegment (uint32_t numBytes)
   SequenceNumber32 startOfAppList = m_firstByteSeq + m_sentSize;
 
   bool listEdited = false;
-  TcpTxItem *item = GetPacketFromList (m_appList, startOfAppList,
+  TcpTxItem *item = GetPacketFromList (m_appList, m_appList.begin (), startOfAppList,
                                        numBytes, startOfAppList, &listEdited);
 
   (void) listEdited;
@@ -311,9 +369,19 @@ TcpTxBuffer::GetNewSegment (uint32_t numBytes)
   NS_ASSERT (it != m_appList.end ());
 
   m_appList.erase (it);
-  m_sentList.insert (m_sentList.end (), item);
+  item->m_startSeq = startOfAppList;
+  PacketList::const_iterator sentIt = m_sentList.insert (m_sentList.end (), item);
   m_sentSize += item->m_packet->GetSize ();
 
+  if (m_sentIndexValid)
+    {
+      m_sentIndex.insert (m_sentIndex.end (), std::make_pair (item->m_startSeq, sentIt));
+      if (item->m_sacked)
+        {
+          AddSackedRange (item->m_startSeq, item->m_startSeq + item->m_packet->GetSize ());
+        }
+    }
+
   return item;
 }
 
@@ -326,11 +394,25 @@ TcpTxBuffer::GetTransmittedSegment (uint32_t numBytes, const SequenceNumber32 &s
 
   bool listEdited = false;
 
-  TcpTxItem *item = GetPacketFromList (m_sentList, m_firstByteSeq, numBytes, seq, &listEdited);
+  // Start from the item that contains seq
+  CheckSentIndex ();
+  SentIndex::const_iterator index_it = m_sentIndex.upper_bound (seq);
+  NS_ASSERT (index_it != m_sentIndex.begin ());
+  --index_it;
+  SequenceNumber32 startingSeq = index_it->first;
+  // An empty erase turns the const_iterator of the index into an iterator
+  PacketList::iterator it = m_sentList.erase (index_it->second, index_it->second);
 
-  if (listEdited && m_highestSack.second >= m_firstByteSeq)
+  TcpTxItem *item = GetPacketFromList (m_sentList, it, startingSeq, numBytes, seq, &listEdited);
+
+  if (listEdited)
     {
-      m_highestSack = GetHighestSacked ();
+      ReindexSentList (startingSeq, seq + numBytes);
+      InvalidateScoreboard (false);
+      if (m_highestSack.second >= m_firstByteSeq)
+        {
+          m_highestSack = GetHighestSacked ();
+        }
     }
 
   return item;
@@ -341,23 +423,21 @@ TcpTxBuffer::GetHighestSacked () const
 {
   NS_LOG_FUNCTION (this);
 
-  PacketList::const_iterator it;
-  std::pair <TcpTxBuffer::PacketList::const_iterator, SequenceNumber32> ret;
-  SequenceNumber32 beginOfCurrentPacket = m_firstByteSeq;
+  CheckSentIndex ();
 
-  ret = std::make_pair (m_sentList.end (), SequenceNumber32 (0));
+  if (m_sackedRanges.empty ())
+    {
+      return std::make_pair (m_sentList.end (), SequenceNumber32 (0));
+    }
 
-  for (it = m_sentList.begin (); it != m_sentList.end (); ++it)
+  SequenceNumber32 highest = m_sackedRanges.rbegin ()->second;
+  SentIndex::const_iterator it = m_sentIndex.find (highest);
+  if (it == m_sentIndex.end ())
     {
-      const TcpTxItem *item = *it;
-      if (item->m_sacked)
-        {
-          ret = std::make_pair (it, beginOfCurrentPacket);
-        }
-      beginOfCurrentPacket += item->m_packet->GetSize ();
+      return std::make_pair (m_sentList.end (), highest);
     }
 
-  return ret;
+  return std::make_pair (it->second, highest);
 }
 
 
@@ -373,10 +453,13 @@ TcpTxBuffer::SplitItems (TcpTxItem &t1, TcpTxItem &t2, uint32_t size) const
   t1.m_lastSent = t2.m_lastSent;
   t1.m_retrans = t2.m_retrans;
   t1.m_lost = t2.m_lost;
+  t1.m_startSeq = t2.m_startSeq;
+  t2.m_startSeq += size;
 }
 
 TcpTxItem*
-TcpTxBuffer::GetPacketFromList (PacketList &list, const SequenceNumber32 &listStartFrom,
+TcpTxBuffer::GetPacketFromList (PacketList &list, PacketList::iterator it,
+                                const SequenceNumber32 &itemStartFrom,
                                 uint32_t numBytes, const SequenceNumber32 &seq,
                                 bool *listEdited) const
 {
@@ -412,8 +495,7 @@ TcpTxBuffer::GetPacketFromList (PacketList &list, const SequenceNumber32 &listSt
   Ptr<Packet> currentPacket = 0;
   TcpTxItem *currentItem = 0;
   TcpTxItem *outItem = 0;
-  PacketList::iterator it = list.begin ();
-  SequenceNumber32 beginOfCurrentPacket = listStartFrom;
+  SequenceNumber32 beginOfCurrentPacket = itemStartFrom;
 
   while (it != list.end ())
     {
@@ -445,11 +527,11 @@ TcpTxBuffer::GetPacketFromList (PacketList &list, const SequenceNumber32 &listSt
               TcpTxItem *firstPart = new TcpTxItem ();
               SplitItems (*firstPart, *currentItem, seq - beginOfCurrentPacket);
 
-              // insert firstPart before currentItem
+              // insert firstPart before currentItem, that now starts at seq
               list.insert (it, firstPart);
               *listEdited = true;
 
-              return GetPacketFromList (list, listStartFrom, numBytes, seq, listEdited);
+              return GetPacketFromList (list, it, seq, numBytes, seq, listEdited);
             }
           else
             {
@@ -487,7 +569,8 @@ TcpTxBuffer::GetPacketFromList (PacketList &list, const SequenceNumber32 &listSt
                   // current > outPacket in the list. Merge current with the
                   // previous, and recurse.
                   NS_ASSERT (it != list.begin ());
-                  TcpTxItem *previous = *(--it);
+                  PacketList::iterator previousIt = it;
+                  TcpTxItem *previous = *(--previousIt);
 
                   list.erase (it);
 
@@ -495,7 +578,8 @@ TcpTxBuffer::GetPacketFromList (PacketList &list, const SequenceNumber32 &listSt
                   delete currentItem;
                   *listEdited = true;
 
-                  return GetPacketFromList (list, listStartFrom, numBytes, seq, listEdited);
+                  // previous is outItem, that starts at seq
+                  return GetPacketFromList (list, previousIt, seq, numBytes, seq, listEdited);
                 }
             }
           else if (numBytes < currentPacket->GetSize ())
@@ -532,13 +616,13 @@ TcpTxBuffer::GetPacketFromList (PacketList &list, const SequenceNumber32 &listSt
                                    // in the previous if
 
           MergeItems (*currentItem, *next);
-          list.erase (it);
+          it = list.erase (it);
 
           delete next;
 
           *listEdited = true;
 
-          return GetPacketFromList (list, listStartFrom, numBytes, seq, listEdited);
+          return GetPacketFromList (list, --it, seq, numBytes, seq, listEdited);
         }
     }
 
@@ -605,6 +689,19 @@ TcpTxBuffer::DiscardUpTo (const SequenceNumber32& seq)
 
       if (offset >= pktSize)
         { // This packet is behind the seqnum. Remove this packet from the buffer
+          if (m_scoreboardValid)
+            {
+              m_pipe -= PipeContribution (item);
+              if (item->m_lost && !item->m_sacked)
+                {
+                  --m_lostItems;
+                }
+            }
+          if (m_sentIndexValid)
+            {
+              NS_ASSERT (m_sentIndex.begin ()->second == i);
+              m_sentIndex.erase (m_sentIndex.begin ());
+            }
           m_size -= pktSize;
           m_sentSize -= pktSize;
           offset -= pktSize;
@@ -619,11 +716,26 @@ TcpTxBuffer::DiscardUpTo (const SequenceNumber32& seq)
       else if (offset > 0)
         { // Part of the packet is behind the seqnum. Fragment
           pktSize -= offset;
+          if (m_scoreboardValid)
+            {
+              m_pipe -= PipeContribution (item);
+            }
           // PacketTags are preserved when fragmenting
           item->m_packet = item->m_packet->CreateFragment (offset, pktSize);
           m_size -= offset;
           m_sentSize -= offset;
           m_firstByteSeq += offset;
+          item->m_startSeq = m_firstByteSeq;
+          if (m_scoreboardValid)
+            {
+              m_pipe += PipeContribution (item);
+            }
+          if (m_sentIndexValid)
+            {
+              NS_ASSERT (m_sentIndex.begin ()->second == i);
+              m_sentIndex.erase (m_sentIndex.begin ());
+              m_sentIndex.insert (m_sentIndex.begin (), std::make_pair (item->m_startSeq, i));
+            }
           NS_LOG_INFO ("Fragmented one packet by size " << offset <<
                        ", new size=" << pktSize);
           break;
@@ -635,6 +747,21 @@ TcpTxBuffer::DiscardUpTo (const SequenceNumber32& seq)
       m_firstByteSeq = seq;
     }
 
+  if (m_sentIndexValid)
+    {
+      // Forget the SACKed data that has been acknowledged
+      while (!m_sackedRanges.empty () && m_sackedRanges.begin ()->first < m_firstByteSeq)
+        {
+          SequenceNumber32 end = m_sackedRanges.begin ()->second;
+          m_sackedRanges.erase (m_sackedRanges.begin ());
+          if (end > m_firstByteSeq)
+            {
+              m_sackedRanges.insert (std::make_pair (m_firstByteSeq.Get (), end));
+              break;
+            }
+        }
+    }
+
   if (!m_sentList.empty ())
     {
       TcpTxItem *head = m_sentList.front ();
@@ -644,6 +771,11 @@ TcpTxBuffer::DiscardUpTo (const SequenceNumber32& seq)
           // have been ACKed. This is, most likely, our wrong guessing
           // when crafting the SACK option for a non-SACK receiver.
           head->m_sacked = false;
+          if (m_sentIndexValid)
+            {
+              RemoveSackedRange (head->m_startSeq, head->m_startSeq + head->m_packet->GetSize ());
+            }
+          InvalidateScoreboard (false);
         }
     }
 
@@ -652,6 +784,13 @@ TcpTxBuffer::DiscardUpTo (const SequenceNumber32& seq)
       m_highestSack = std::make_pair (m_sentList.end (), SequenceNumber32 (0));
     }
 
+  if (m_lossBoundaryValid && m_lossBoundary < m_firstByteSeq)
+    {
+      // The SACKed segment at the boundary has been (partially) acknowledged;
+      // the recovery is over, start from scratch
+      InvalidateScoreboard (false);
+    }
+
   NS_LOG_DEBUG ("Discarded up to " << seq);
   NS_LOG_LOGIC ("Buffer status after discarding data " << *this);
   NS_ASSERT (m_firstByteSeq >= seq);
@@ -663,93 +802,124 @@ TcpTxBuffer::Update (const TcpOptionSack::SackList &list)
   NS_LOG_FUNCTION (this);
 
   bool modified = false;
+  bool newSack = false;
   TcpOptionSack::SackList::const_iterator option_it;
   NS_LOG_INFO ("Updating scoreboard, got " << list.size () << " blocks to analyze");
+
+  CheckSentIndex ();
+
   for (option_it = list.begin (); option_it != list.end (); ++option_it)
     {
-      Ptr<Packet> current;
-      TcpTxItem *item;
       const TcpOptionSack::SackBlock b = (*option_it);
+      SequenceNumber32 seq = b.first;
 
-      PacketList::iterator item_it = m_sentList.begin ();
-      SequenceNumber32 beginOfCurrentPacket = m_firstByteSeq;
-
-      while (item_it != m_sentList.end ())
+      // Visit only the segments of the block that are not SACKed yet,
+      // jumping over the SACKed ranges
+      while (seq < b.second)
         {
-          item = *item_it;
-          current = item->m_packet;
+          SackedRanges::const_iterator range_it = m_sackedRanges.upper_bound (seq);
+          if (range_it != m_sackedRanges.begin () && (--range_it)->second > seq)
+            {
+              // First segment starting inside the SACKed range
+              SentIndex::const_iterator index_it = m_sentIndex.lower_bound (seq);
+              if (index_it != m_sentIndex.end () && index_it->first < range_it->second
+                  && index_it->first + (*(index_it->second))->m_packet->GetSize () <= b.second)
+                {
+                  modified = true;
+                }
+              NS_LOG_INFO ("Received block [" << b.first << ";" << b.second <<
+                           "], [" << range_it->first << ";" << range_it->second <<
+                           "] found in the sackboard already sacked");
+              seq = range_it->second;
+              continue;
+            }
+
+          // First segment starting inside the rest of the block
+          SentIndex::const_iterator index_it = m_sentIndex.lower_bound (seq);
+          if (index_it == m_sentIndex.end ())
+            {
+              NS_LOG_INFO ("Received block [" << b.first << ";" << b.second <<
+                           "], not found in the sent list");
+              break;
+            }
 
-          // Check the boundary of this packet ... only mark as sacked if
-          // it is precisely mapped over the option
-          if (beginOfCurrentPacket >= b.first
-              && beginOfCurrentPacket + current->GetSize () <= b.second)
+          PacketList::const_iterator item_it = index_it->second;
+          SequenceNumber32 beginOfSacked = index_it->first;
+          SequenceNumber32 endOfSacked = beginOfSacked;
+
+          while (item_it != m_sentList.end () && !(*item_it)->m_sacked)
             {
-              if (item->m_sacked)
+              TcpTxItem *item = *item_it;
+              SequenceNumber32 beginOfCurrentPacket = item->m_startSeq;
+              SequenceNumber32 endOfCurrentPacket = beginOfCurrentPacket + item->m_packet->GetSize ();
+
+              // Only mark as sacked if the segment is precisely mapped over the option
+              if (endOfCurrentPacket > b.second)
                 {
                   NS_LOG_INFO ("Received block [" << b.first << ";" << b.second <<
                                ", checking sentList for block " << beginOfCurrentPacket <<
-                               ";" << beginOfCurrentPacket + current->GetSize () <<
-                               "], found in the sackboard already sacked");
+                               ";" << endOfCurrentPacket << "], not found, breaking loop");
+                  break;
                 }
-              else
+
+              if (m_scoreboardValid)
                 {
-                  item->m_sacked = true;
-                  NS_LOG_INFO ("Received block [" << b.first << ";" << b.second <<
-                               ", checking sentList for block " << beginOfCurrentPacket <<
-                               ";" << beginOfCurrentPacket + current->GetSize () <<
-                               "], found in the sackboard, sacking");
-                  if (m_highestSack.second <= beginOfCurrentPacket + current->GetSize ())
+                  m_pipe -= PipeContribution (item);
+                  if (item->m_lost)
                     {
-                      PacketList::iterator new_it = item_it;
-                      m_highestSack = std::make_pair (++new_it, beginOfCurrentPacket+current->GetSize ());
+                      --m_lostItems;
                     }
                 }
+              item->m_sacked = true;
+              newSack = true;
               modified = true;
-            }
-          else if (beginOfCurrentPacket + current->GetSize () > b.second)
-            {
-              // we missed the block. It's useless to iterate again; Say "ciao"
-              // to the loop for optimization purposes
+              endOfSacked = endOfCurrentPacket;
               NS_LOG_INFO ("Received block [" << b.first << ";" << b.second <<
                            ", checking sentList for block " << beginOfCurrentPacket <<
-                           ";" << beginOfCurrentPacket + current->GetSize () <<
-                           "], not found, breaking loop");
+                           ";" << endOfCurrentPacket << "], found in the sackboard, sacking");
+              if (m_highestSack.second <= endOfCurrentPacket)
+                {
+                  PacketList::const_iterator new_it = item_it;
+                  m_highestSack = std::make_pair (++new_it, endOfCurrentPacket);
+                }
+              ++item_it;
+            }
+
+          if (endOfSacked > beginOfSacked)
+            {
+              AddSackedRange (beginOfSacked, endOfSacked);
+            }
+
+          if (item_it == m_sentList.end () || !(*item_it)->m_sacked)
+            {
               break;
             }
 
-          beginOfCurrentPacket += current->GetSize ();
-          ++item_it;
+          // A SACKed range follows; skip it
+          seq = (*item_it)->m_startSeq;
         }
     }
 
+  if (newSack && m_scoreboardValid)
+    {
+      RaiseLossBoundary ();
+    }
+
   NS_ASSERT ((*(m_sentList.begin ()))->m_sacked == false);
 
   return modified;
 }
 
 bool
-TcpTxBuffer::IsLost (const SequenceNumber32 &seq, const PacketList::const_iterator &segment,
-                     uint32_t dupThresh, uint32_t segmentSize) const
+TcpTxBuffer::IsLostItem (const TcpTxItem *item) const
 {
-  NS_LOG_FUNCTION (this << seq << dupThresh << segmentSize);
-  uint32_t count = 0;
-  uint32_t bytes = 0;
-  PacketList::const_iterator it;
-  TcpTxItem *item;
-  Ptr<const Packet> current;
-  SequenceNumber32 beginOfCurrentPacket = seq;
-
-  NS_LOG_INFO ("Checking if seq=" << seq << " is lost from the buffer ");
-
-  if ((*segment)->m_lost == true)
+  if (item->m_lost)
     {
-      NS_LOG_INFO ("seq=" << seq << " is lost because of lost flag");
       return true;
     }
 
-  if ((*segment)->m_sacked == true)
+  if (item->m_sacked)
     {
-      NS_LOG_INFO ("seq=" << seq << " is not lost because of sacked flag");
       return false;
     }
 
@@ -758,35 +928,259 @@ TcpTxBuffer::IsLost (const SequenceNumber32 &seq, const PacketList::const_iterat
   // > sequences have arrived above 'seq' or more than (dupThresh - 1) * SMSS bytes
   // > with sequence numbers greater than 'SeqNum' have been SACKed.  Otherwise, the
   // > routine returns false.
-  for (it = segment; it != m_highestSack.first; ++it)
+  // This is the case for every segment below the loss boundary.
+  return m_lossBoundaryValid && item->m_startSeq < m_lossBoundary;
+}
+
+uint32_t
+TcpTxBuffer::PipeContribution (const TcpTxItem *item) const
+{
+  // Only the octets that have not been SACKed are counted
+  if (item->m_sacked)
     {
-      if (beginOfCurrentPacket >= m_highestSack.second)
-        {
-          NS_LOG_INFO ("seq=" << seq << " is not lost because there are no sacked segment ahead");
-          return false;
-        }
+      return 0;
+    }
 
-      item = *it;
-      current = item->m_packet;
+  // (a) If IsLost (S1) returns false: Pipe is incremented by 1 octet.
+  // (b) If S1 <= HighRxt: Pipe is incremented by 1 octet.
+  // (NOTE: we use the m_retrans flag instead of keeping and updating
+  // another variable). Only if the item is not marked as lost
+  if (!IsLostItem (item) || (item->m_retrans && !item->m_lost))
+    {
+      return item->m_packet->GetSize ();
+    }
 
+  return 0;
+}
+
+void
+TcpTxBuffer::ComputeLossBoundary () const
+{
+  NS_LOG_FUNCTION (this);
+  uint32_t count = 0;
+  uint32_t bytes = 0;
+
+  m_lossBoundaryValid = false;
+
+  if (m_highestSack.second <= m_firstByteSeq)
+    {
+      return;
+    }
+
+  // Walk back from the highest SACKed segment: the boundary is the first
+  // byte of the segment that satisfies the IsLost () condition for all the
+  // segments below it
+  PacketList::const_iterator it = m_highestSack.first;
+  while (it != m_sentList.begin ())
+    {
+      --it;
+      const TcpTxItem *item = *it;
       if (item->m_sacked)
         {
-          NS_LOG_INFO ("Segment [" << beginOfCurrentPacket << ", " <<
-                       beginOfCurrentPacket+item->m_packet->GetSize () <<
-                       "] found to be SACKed");
           ++count;
-          bytes += current->GetSize ();
-          if ((count >= dupThresh) || (bytes > (dupThresh-1) * segmentSize))
+          bytes += item->m_packet->GetSize ();
+          if ((count >= m_dupThresh) || (bytes > (m_dupThresh - 1) * m_segmentSize))
             {
-              NS_LOG_INFO ("seq=" << seq << " is lost because of 3 sacked blocks ahead");
-              return true;
+              m_lossBoundary = item->m_startSeq;
+              m_lossBoundaryValid = true;
+              NS_LOG_INFO ("Segments before " << m_lossBoundary << " are lost");
+              return;
             }
         }
+    }
+}
+
+void
+TcpTxBuffer::RaiseLossBoundary ()
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (m_scoreboardValid && m_sentIndexValid);
+
+  bool oldValid = m_lossBoundaryValid;
+  SequenceNumber32 oldBoundary = m_lossBoundary;
+
+  ComputeLossBoundary ();
+
+  // New SACKs can only move the boundary forward
+  NS_ASSERT (!oldValid || (m_lossBoundaryValid && m_lossBoundary >= oldBoundary));
+  if (!m_lossBoundaryValid || (oldValid && m_lossBoundary == oldBoundary))
+    {
+      return;
+    }
+
+  // The segments between the two boundaries are now lost, and they are not
+  // counted anymore in the pipe unless retransmitted
+  PacketList::const_iterator it = m_sentList.begin ();
+  if (oldValid)
+    {
+      it = m_sentIndex.lower_bound (oldBoundary)->second;
+    }
+
+  for (; it != m_sentList.end () && (*it)->m_startSeq < m_lossBoundary; ++it)
+    {
+      const TcpTxItem *item = *it;
+      if (!item->m_sacked && !item->m_lost && !item->m_retrans)
+        {
+          m_pipe -= item->m_packet->GetSize ();
+        }
+    }
+}
+
+void
+TcpTxBuffer::CheckScoreboard (uint32_t dupThresh, uint32_t segmentSize) const
+{
+  if (m_scoreboardValid && dupThresh == m_dupThresh && segmentSize == m_segmentSize)
+    {
+      return;
+    }
+
+  NS_LOG_FUNCTION (this << dupThresh << segmentSize);
 
-      beginOfCurrentPacket += current->GetSize ();
+  m_dupThresh = dupThresh;
+  m_segmentSize = segmentSize;
+  ComputeLossBoundary ();
+
+  m_pipe = 0;
+  m_lostItems = 0;
+  PacketList::const_iterator it;
+  for (it = m_sentList.begin (); it != m_sentList.end (); ++it)
+    {
+      const TcpTxItem *item = *it;
+      m_pipe += PipeContribution (item);
+      if (item->m_lost && !item->m_sacked)
+        {
+          ++m_lostItems;
+        }
     }
 
-  return false;
+  m_scoreboardValid = true;
+}
+
+void
+TcpTxBuffer::CheckSentIndex () const
+{
+  if (m_sentIndexValid)
+    {
+      return;
+    }
+
+  NS_LOG_FUNCTION (this);
+
+  m_sentIndex.clear ();
+  m_sackedRanges.clear ();
+  PacketList::const_iterator it;
+  for (it = m_sentList.begin (); it != m_sentList.end (); ++it)
+    {
+      const TcpTxItem *item = *it;
+      m_sentIndex.insert (m_sentIndex.end (), std::make_pair (item->m_startSeq, it));
+      if (item->m_sacked)
+        {
+          AddSackedRange (item->m_startSeq, item->m_startSeq + item->m_packet->GetSize ());
+        }
+    }
+
+  m_sentIndexValid = true;
+}
+
+void
+TcpTxBuffer::ReindexSentList (const SequenceNumber32 &begin, const SequenceNumber32 &end) const
+{
+  NS_LOG_FUNCTION (this << begin << end);
+  NS_ASSERT (m_sentIndexValid);
+
+  SentIndex::iterator first = m_sentIndex.lower_bound (begin);
+  SentIndex::iterator last = m_sentIndex.upper_bound (end);
+
+  // The items before begin have not been touched
+  PacketList::const_iterator it = m_sentList.begin ();
+  if (first != m_sentIndex.begin ())
+    {
+      SentIndex::iterator previous = first;
+      it = (--previous)->second;
+      ++it;
+    }
+
+  m_sentIndex.erase (first, last);
+
+  for (; it != m_sentList.end () && (*it)->m_startSeq <= end; ++it)
+    {
+      const TcpTxItem *item = *it;
+      m_sentIndex.insert (last, std::make_pair (item->m_startSeq, it));
+      if (!item->m_sacked)
+        {
+          // A merge with a not SACKed item removes the SACK
+          RemoveSackedRange (item->m_startSeq, item->m_startSeq + item->m_packet->GetSize ());
+        }
+    }
+}
+
+void
+TcpTxBuffer::AddSackedRange (const SequenceNumber32 &begin, const SequenceNumber32 &end) const
+{
+  SequenceNumber32 first = begin;
+  SequenceNumber32 last = end;
+
+  SackedRanges::iterator it = m_sackedRanges.upper_bound (first);
+  if (it != m_sackedRanges.begin ())
+    {
+      SackedRanges::iterator previous = it;
+      --previous;
+      if (previous->second >= first)
+        {
+          first = previous->first;
+          last = std::max (last, previous->second);
+          m_sackedRanges.erase (previous);
+        }
+    }
+
+  while (it != m_sackedRanges.end () && it->first <= last)
+    {
+      last = std::max (last, it->second);
+      m_sackedRanges.erase (it++);
+    }
+
+  m_sackedRanges.insert (it, std::make_pair (first, last));
+}
+
+void
+TcpTxBuffer::RemoveSackedRange (const SequenceNumber32 &begin, const SequenceNumber32 &end) const
+{
+  SackedRanges::iterator it = m_sackedRanges.upper_bound (begin);
+  if (it != m_sackedRanges.begin ())
+    {
+      --it;
+      if (it->second <= begin)
+        {
+          ++it;
+        }
+    }
+
+  while (it != m_sackedRanges.end () && it->first < end)
+    {
+      SequenceNumber32 first = it->first;
+      SequenceNumber32 last = it->second;
+      m_sackedRanges.erase (it++);
+      if (first < begin)
+        {
+          m_sackedRanges.insert (it, std::make_pair (first, begin));
+        }
+      if (last > end)
+        {
+          m_sackedRanges.insert (it, std::make_pair (end, last));
+        }
+    }
+}
+
+void
+TcpTxBuffer::InvalidateScoreboard (bool index)
+{
+  m_scoreboardValid = false;
+  if (index)
+    {
+      m_sentIndexValid = false;
+      m_sentIndex.clear ();
+      m_sackedRanges.clear ();
+    }
 }
 
 bool
@@ -795,28 +1189,22 @@ TcpTxBuffer::IsLost (const SequenceNumber32 &seq, uint32_t dupThresh,
 {
   NS_LOG_FUNCTION (this << seq << dupThresh);
 
-  SequenceNumber32 beginOfCurrentPacket = m_firstByteSeq;
-  PacketList::const_iterator it;
-
   if (seq >= m_highestSack.second)
     {
       return false;
     }
 
-  // This O(n) method is called only once, and outside this class.
-  // It should not harm the performance
-  for (it = m_sentList.begin (); it != m_sentList.end (); ++it)
-    {
-      // Search for the right iterator before calling IsLost()
-      if (beginOfCurrentPacket >= seq)
-        {
-          return IsLost (beginOfCurrentPacket, it, dupThresh, segmentSize);
-        }
+  CheckScoreboard (dupThresh, segmentSize);
+  CheckSentIndex ();
 
-      beginOfCurrentPacket += (*it)->m_packet->GetSize ();
+  // Search for the first segment starting at or after seq
+  SentIndex::const_iterator it = m_sentIndex.lower_bound (seq);
+  if (it == m_sentIndex.end ())
+    {
+      return false;
     }
 
-  return false;
+  return IsLostItem (*(it->second));
 }
 
 bool
@@ -825,6 +1213,8 @@ TcpTxBuffer::NextSeg (SequenceNumber32 *seq, uint32_t dupThresh,
 {
   NS_LOG_FUNCTION (this);
 
+  CheckScoreboard (dupThresh, segmentSize);
+
   /* RFC 6675, NextSeg definition.
    *
    * (1) If there exists a smallest unSACKed sequence number 'S2' that
@@ -839,33 +1229,40 @@ TcpTxBuffer::NextSeg (SequenceNumber32 *seq, uint32_t dupThresh,
    *
    *     (1.c) IsLost (S2) returns true.
    */
-  PacketList::const_iterator it;
-  TcpTxItem *item;
   SequenceNumber32 seqPerRule3;
   bool isSeqPerRule3Valid = false;
-  SequenceNumber32 beginOfCurrentPkt = m_firstByteSeq;
 
-  for (it = m_sentList.begin (); it != m_sentList.end (); ++it)
+  // Outside recovery, the list is traveled only if some segment can be lost
+  if (isRecovery || m_lossBoundaryValid || m_lostItems > 0)
     {
-      item = *it;
-
-      // Condition 1.a , 1.b , and 1.c
-      if (item->m_retrans == false && item->m_sacked == false)
+      PacketList::const_iterator it;
+      for (it = m_sentList.begin (); it != m_sentList.end (); ++it)
         {
-          if (IsLost (beginOfCurrentPkt, it, dupThresh, segmentSize))
+          const TcpTxItem *item = *it;
+
+          // Condition 1.a , 1.b , and 1.c
+          if (item->m_retrans == false && item->m_sacked == false)
             {
-              *seq = beginOfCurrentPkt;
-              return true;
+              if (IsLostItem (item))
+                {
+                  *seq = item->m_startSeq;
+                  return true;
+                }
+              else if (!isSeqPerRule3Valid && isRecovery)
+                {
+                  isSeqPerRule3Valid = true;
+                  seqPerRule3 = item->m_startSeq;
+                }
             }
-          else if (seqPerRule3.GetValue () == 0 && isRecovery)
+
+          // Above the loss boundary nothing is lost, unless marked as such
+          if (m_lostItems == 0
+              && (!m_lossBoundaryValid || item->m_startSeq >= m_lossBoundary)
+              && (isSeqPerRule3Valid || !isRecovery))
             {
-              isSeqPerRule3Valid = true;
-              seqPerRule3 = beginOfCurrentPkt;
+              break;
             }
         }
-
-      // Nothing found, iterate
-      beginOfCurrentPkt += item->m_packet->GetSize ();
     }
 
   /* (2) If no sequence number 'S2' per rule (1) exists but there
@@ -910,36 +1307,11 @@ TcpTxBuffer::NextSeg (SequenceNumber32 *seq, uint32_t dupThresh,
 uint32_t
 TcpTxBuffer::BytesInFlight (uint32_t dupThresh, uint32_t segmentSize) const
 {
-  PacketList::const_iterator it;
-  TcpTxItem *item;
-  uint32_t size = 0; // "pipe" in RFC
-  SequenceNumber32 beginOfCurrentPkt = m_firstByteSeq;
+  // The "pipe" of RFC 6675 (SetPipe) is updated each time the scoreboard
+  // changes; see PipeContribution for the rules applied to each octet
+  CheckScoreboard (dupThresh, segmentSize);
 
-  // After initializing pipe to zero, the following steps are taken for each
-  // octet 'S1' in the sequence space between HighACK and HighData that has not
-  // been SACKed:
-  for (it = m_sentList.begin (); it != m_sentList.end (); ++it)
-    {
-      item = *it;
-      if (!item->m_sacked)
-        {
-          // (a) If IsLost (S1) returns false: Pipe is incremented by 1 octet.
-          if (!IsLost (beginOfCurrentPkt, it, dupThresh, segmentSize))
-            {
-              size += item->m_packet->GetSize ();
-            }
-          // (b) If S1 <= HighRxt: Pipe is incremented by 1 octet.
-          // (NOTE: we use the m_retrans flag instead of keeping and updating
-          // another variable). Only if the item is not marked as lost
-          else if (item->m_retrans && !item->m_lost)
-            {
-              size += item->m_packet->GetSize ();
-            }
-        }
-      beginOfCurrentPkt += item->m_packet->GetSize ();
-    }
-
-  return size;
+  return m_pipe;
 }
 
 void
@@ -948,15 +1320,15 @@ TcpTxBuffer::ResetScoreboard ()
   NS_LOG_FUNCTION (this);
 
   PacketList::iterator it;
-  SequenceNumber32 beginOfCurrentPkt = m_firstByteSeq;
 
   for (it = m_sentList.begin (); it != m_sentList.end (); ++it)
     {
       (*it)->m_sacked = false;
-      beginOfCurrentPkt += (*it)->m_packet->GetSize ();
     }
 
+  m_sackedRanges.clear ();
   m_highestSack = std::make_pair (m_sentList.end (), SequenceNumber32 (0));
+  InvalidateScoreboard (false);
 }
 
 void
@@ -988,6 +1360,7 @@ TcpTxBuffer::ResetSentList ()
     }
 
   m_highestSack = std::make_pair (m_sentList.end (), SequenceNumber32 (0));
+  InvalidateScoreboard (true);
 }
 
 void
@@ -1001,6 +1374,17 @@ TcpTxBuffer::ResetLastSegmentSent ()
       m_sentList.pop_back ();
       m_sentSize -= item->m_packet->GetSize ();
       m_appList.insert (m_appList.begin (), item);
+
+      if (m_sentIndexValid)
+        {
+          m_sentIndex.erase (item->m_startSeq);
+          RemoveSackedRange (item->m_startSeq, item->m_startSeq + item->m_packet->GetSize ());
+        }
+      if (m_highestSack.second > m_firstByteSeq)
+        {
+          m_highestSack = GetHighestSacked ();
+        }
+      InvalidateScoreboard (false);
     }
 }
 
@@ -1015,6 +1399,8 @@ TcpTxBuffer::SetSentListLost ()
     {
       (*it)->m_lost = true;
     }
+
+  InvalidateScoreboard (false);
 }
 
 bool
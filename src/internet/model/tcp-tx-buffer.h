@@ -28,6 +28,8 @@
 #include "ns3/nstime.h"
 #include "ns3/tcp-option-sack.h"
 
+#include <map>
+
 namespace ns3 {
 class Packet;
 
@@ -62,6 +64,8 @@ public:
   Time m_lastSent;      //!< Timestamp of the time at which the segment has
                         //   been sent last time
   bool m_sacked;        //!< Indicates if the segment has been SACKed
+  SequenceNumber32 m_startSeq; //!< Sequence number of the first byte (valid
+                               //   once the item is in the sent list)
 };
 
 /**
@@ -106,18 +110,29 @@ public:
  * documentation) and maintaining the scoreboard is a matter of travelling the
  * list and set the SACK flag on the corresponding segment sent.
  *
- * Inefficiencies
- * --------------
+ * Efficiency
+ * ----------
+ *
+ * The algorithms outlined in RFC 6675, implemented literally, travel the
+ * sent list for each SACK block and for each segment whose loss state is
+ * needed, which is quadratic in the window size. Two structures avoid that:
+ *
+ * - an index of the sent list, keyed by the first sequence number of each
+ *   item, finds the items covered by a SACK block (or the item of a given
+ *   sequence) in logarithmic time;
+ * - the loss boundary. Since the number of SACKed segments above a
+ *   sequence decreases with the sequence, IsLost () is true for all the
+ *   un-SACKed segments below the first byte of the dupThresh-th SACKed
+ *   segment from the top (or of the one that makes more than
+ *   (dupThresh - 1) * SMSS bytes SACKed), and false for all those above.
+ *   The boundary only moves forward while SACK blocks arrive, so the "pipe"
+ *   of RFC 6675 is kept up to date incrementally while segments are sent,
+ *   SACKed, retransmitted and acknowledged, and BytesInFlight () is O(1).
  *
- * The algorithms outlined in RFC 6675 are full of inefficiencies. In
- * particular, traveling all the sent list each time it is needed to compute
- * the bytes in flight is expensive. We try to overcome the issue by
- * maintaining a pointer to the highest sequence SACKed; in this way, we can
- * avoid traveling all the list in some cases. Another option could be keeping
- * a count of each critical value (e.g., the number of packets sacked).
- * However, this would be different from the algorithms in RFC. There are some
- * other possible improvements; if you wish, take a look and try  to add some
- * earlier exit conditions in the loops.
+ * The cached values refer to the dupThresh and segment size of the last
+ * query, and they are rebuilt in linear time when these change or after
+ * events that reshape the sent list (fragmentation or merge of transmitted
+ * items, RTO, scoreboard reset).
  *
  * \see Size
  * \see SizeFromSequence
@@ -320,17 +335,82 @@ private:
   friend std::ostream & operator<< (std::ostream & os, TcpTxBuffer const & tcpTxBuf);
 
   typedef std::list<TcpTxItem*> PacketList; //!< container for data stored in the buffer
+  typedef std::map<SequenceNumber32, PacketList::const_iterator> SentIndex; //!< index of the sent list
+  typedef std::map<SequenceNumber32, SequenceNumber32> SackedRanges; //!< first and last (excluded) byte of SACKed data
 
   /**
-   * \brief Check if a segment is lost per RFC 6675
-   * \param seq sequence to check
-   * \param segment Iterator pointing at seq
+   * \brief Check if a segment of the sent list is lost per RFC 6675
+   *
+   * Relies on the cached loss boundary (see CheckScoreboard).
+   *
+   * \param item the segment to check
+   * \return true if the segment is supposed to be lost, false otherwise
+   */
+  bool IsLostItem (const TcpTxItem *item) const;
+
+  /**
+   * \brief Bytes that a segment of the sent list adds to the pipe
+   * \param item the segment
+   * \return the item size if it is counted in the bytes in flight, 0 otherwise
+   */
+  uint32_t PipeContribution (const TcpTxItem *item) const;
+
+  /**
+   * \brief Make sure that the cached scoreboard values are valid
+   *
+   * If they are not, or they refer to different parameters, they are
+   * computed again traveling the sent list.
+   *
    * \param dupThresh dupAck threshold
    * \param segmentSize segment size
-   * \return true if the sequence is supposed to be lost, false otherwise
    */
-  bool IsLost (const SequenceNumber32 &seq, const PacketList::const_iterator &segment, uint32_t dupThresh,
-               uint32_t segmentSize) const;
+  void CheckScoreboard (uint32_t dupThresh, uint32_t segmentSize) const;
+
+  /**
+   * \brief Find the loss boundary, walking back from the highest SACKed segment
+   */
+  void ComputeLossBoundary () const;
+
+  /**
+   * \brief Move the loss boundary after new SACKs and update the pipe
+   */
+  void RaiseLossBoundary ();
+
+  /**
+   * \brief Make sure that the sent list index is valid
+   */
+  void CheckSentIndex () const;
+
+  /**
+   * \brief Index again the items of the sent list starting in [begin;end]
+   *
+   * Used after the items around a retransmitted block have been split or
+   * merged; the SACKed ranges of the items that lost the SACK are removed.
+   *
+   * \param begin first byte of the edited part of the sent list
+   * \param end last byte of the edited part of the sent list
+   */
+  void ReindexSentList (const SequenceNumber32 &begin, const SequenceNumber32 &end) const;
+
+  /**
+   * \brief Add [begin;end) to the SACKed ranges, merging the adjacent ones
+   * \param begin first SACKed byte
+   * \param end last SACKed byte (excluded)
+   */
+  void AddSackedRange (const SequenceNumber32 &begin, const SequenceNumber32 &end) const;
+
+  /**
+   * \brief Remove [begin;end) from the SACKed ranges
+   * \param begin first byte not SACKed anymore
+   * \param end last byte not SACKed anymore (excluded)
+   */
+  void RemoveSackedRange (const SequenceNumber32 &begin, const SequenceNumber32 &end) const;
+
+  /**
+   * \brief Invalidate the cached scoreboard values and, optionally, the index
+   * \param index true if the structure of the sent list has changed
+   */
+  void InvalidateScoreboard (bool index);
 
   /**
    * \brief Get a block of data not transmitted yet and move it into SentList
@@ -427,14 +507,19 @@ private:
    * MSS can change, but it is stable, and retransmissions do not happen for
    * each segment).
    *
+   * The search starts from the item it, and not from the head of the list,
+   * so that a retransmission does not walk the whole sent list.
+   *
    * \param list List to extract block from
-   * \param startingSeq Starting sequence of the list
+   * \param it Item to start from, that must not start after requestedSeq
+   * \param startingSeq Starting sequence of the item it
    * \param numBytes Bytes to extract, starting from requestedSeq
    * \param requestedSeq Requested sequence
    * \param listEdited output parameter which indicates if the list has been edited
    * \return the item that contains the right packet
    */
-  TcpTxItem* GetPacketFromList (PacketList &list, const SequenceNumber32 &startingSeq,
+  TcpTxItem* GetPacketFromList (PacketList &list, PacketList::iterator it,
+                                const SequenceNumber32 &startingSeq,
                                 uint32_t numBytes, const SequenceNumber32 &requestedSeq,
                                 bool *listEdited) const;
 
@@ -463,7 +548,8 @@ private:
 
   /**
    * \brief Find the highest SACK byte
-   * \return a pair with the highest byte and an iterator inside m_sentList
+   * \return a pair with the highest SACKed byte (plus one) and an iterator
+   * to the item that follows it in m_sentList
    */
   std::pair <TcpTxBuffer::PacketList::const_iterator, SequenceNumber32>
   GetHighestSacked () const;
@@ -478,6 +564,18 @@ private:
 
   std::pair <PacketList::const_iterator, SequenceNumber32> m_highestSack; //!< Highest SACK byte
 
+  // Cached scoreboard, see CheckScoreboard
+  mutable SentIndex m_sentIndex;          //!< Sent list items, by first sequence number
+  mutable bool m_sentIndexValid;          //!< True if m_sentIndex is up to date
+  mutable SackedRanges m_sackedRanges;    //!< SACKed data, merged; valid with m_sentIndex
+  mutable bool m_scoreboardValid;         //!< True if the values below are up to date
+  mutable uint32_t m_dupThresh;           //!< dupThresh of the cached values
+  mutable uint32_t m_segmentSize;         //!< Segment size of the cached values
+  mutable bool m_lossBoundaryValid;       //!< True if some segment is lost because of SACKs
+  mutable SequenceNumber32 m_lossBoundary; //!< Un-SACKed segments below are lost
+  mutable uint32_t m_pipe;                //!< Bytes in flight (RFC 6675 pipe)
+  mutable uint32_t m_lostItems;           //!< Un-SACKed segments with the lost flag
+
 };
 
 /**
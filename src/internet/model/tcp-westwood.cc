@@ -51,7 +51,8 @@ TcpWestwood::GetTypeId (void)
     .SetGroupName ("Internet")
     .AddConstructor<TcpWestwood>()
     .AddAttribute("FilterType", "Use this to choose no filter or Tustin's approximation filter",
-                  EnumValue(TcpWestwood::TUSTIN), MakeEnumAccessor(&TcpWestwood::m_fType),
+                  EnumValue(TcpWestwood::TUSTIN),
+                  MakeEnumAccessor(&TcpWestwood::SetFilterType, &TcpWestwood::GetFilterType),
                   MakeEnumChecker(TcpWestwood::NONE, "None", TcpWestwood::TUSTIN, "Tustin"))
     .AddAttribute("ProtocolType", "Use this to let the code run as Westwood or WestwoodPlus",
                   EnumValue(TcpWestwood::WESTWOOD),
@@ -67,10 +68,8 @@ TcpWestwood::GetTypeId (void)
 TcpWestwood::TcpWestwood (void) :
   TcpNewReno (),
   m_currentBW (0),
-  m_lastSampleBW (0),
-  m_lastBW (0),
+  m_bwEstimator (CreateObject<TcpBwEstimator> ()),
   m_minRtt (Time (0)),
-  m_ackedSegments (0),
   m_IsCount (false)
 {
   NS_LOG_FUNCTION (this);
@@ -79,8 +78,7 @@ TcpWestwood::TcpWestwood (void) :
 TcpWestwood::TcpWestwood (const TcpWestwood& sock) :
   TcpNewReno (sock),
   m_currentBW (sock.m_currentBW),
-  m_lastSampleBW (sock.m_lastSampleBW),
-  m_lastBW (sock.m_lastBW),
+  m_bwEstimator (CopyObject<TcpBwEstimator> (sock.m_bwEstimator)),
   m_minRtt (Time (0)),
   m_pType (sock.m_pType),
   m_fType (sock.m_fType),
@@ -94,6 +92,27 @@ TcpWestwood::~TcpWestwood (void)
 {
 }
 
+void
+TcpWestwood::SetFilterType (FilterType fType)
+{
+  NS_LOG_FUNCTION (this << fType);
+  m_fType = fType;
+  m_bwEstimator->SetFilterType (fType == TcpWestwood::TUSTIN ? TcpBwEstimator::TUSTIN
+                                                              : TcpBwEstimator::NONE);
+}
+
+TcpWestwood::FilterType
+TcpWestwood::GetFilterType (void) const
+{
+  return m_fType;
+}
+
+Ptr<TcpBwEstimator>
+TcpWestwood::GetBwEstimator (void) const
+{
+  return m_bwEstimator;
+}
+
 void
 TcpWestwood::PktsAcked (Ptr<TcpSocketState> tcb, uint32_t packetsAcked,
                         const Time& rtt)
@@ -106,7 +125,7 @@ TcpWestwood::PktsAcked (Ptr<TcpSocketState> tcb, uint32_t packetsAcked,
       return;
     }
 
-  m_ackedSegments += packetsAcked;
+  m_bwEstimator->AddAckedBytes (packetsAcked * tcb->m_segmentSize);
 
   // Update minRtt
   if (m_minRtt.IsZero ())
@@ -146,31 +165,14 @@ TcpWestwood::EstimateBW (const Time &rtt, Ptr<TcpSocketState> tcb)
 
   NS_ASSERT (!rtt.IsZero ());
 
-  m_currentBW = m_ackedSegments * tcb->m_segmentSize / rtt.GetSeconds ();
+  m_bwEstimator->Sample (Simulator::Now ().GetNanoSeconds (), rtt.GetNanoSeconds ());
+  m_currentBW = m_bwEstimator->GetBandwidth ();
 
   if (m_pType == TcpWestwood::WESTWOODPLUS)
     {
       m_IsCount = false;
     }
 
-  m_ackedSegments = 0;
-  NS_LOG_LOGIC ("Estimated BW: " << m_currentBW);
-
-  // Filter the BW sample
-
-  double alpha = 0.9;
-
-  if (m_fType == TcpWestwood::NONE)
-    {
-    }
-  else if (m_fType == TcpWestwood::TUSTIN)
-    {
-      double sample_bwe = m_currentBW;
-      m_currentBW = (alpha * m_lastBW) + ((1 - alpha) * ((sample_bwe + m_lastSampleBW) / 2));
-      m_lastSampleBW = sample_bwe;
-      m_lastBW = m_currentBW;
-    }
-
   NS_LOG_LOGIC ("Estimated BW after filtering: " << m_currentBW);
 }
 
@@ -34,6 +34,7 @@
 #define TCP_WESTWOOD_H
 
 #include "tcp-congestion-ops.h"
+#include "tcp-bw-estimator.h"
 #include "ns3/sequence-number.h"
 #include "ns3/traced-value.h"
 
@@ -105,13 +106,26 @@ public:
 
   virtual Ptr<TcpCongestionOps> Fork ();
 
+  /**
+   * \brief Get the bandwidth estimator
+   * \return the bandwidth estimator used by this congestion control
+   */
+  Ptr<TcpBwEstimator> GetBwEstimator (void) const;
+
 private:
   /**
-   * Update the total number of acknowledged packets during the current RTT
+   * Set the filter applied to the bandwidth samples
+   *
+   * \param [in] fType the filter type
+   */
+  void SetFilterType (FilterType fType);
+
+  /**
+   * Get the filter applied to the bandwidth samples
    *
-   * \param [in] acked the number of packets the currently received ACK acknowledges
+   * \return the filter type
    */
-  void UpdateAckedSegments (int acked);
+  FilterType GetFilterType (void) const;
 
   /**
    * Estimate the network's bandwidth
@@ -123,14 +137,12 @@ private:
 
 protected:
   TracedValue<double>    m_currentBW;              //!< Current value of the estimated BW
-  double                 m_lastSampleBW;           //!< Last bandwidth sample
-  double                 m_lastBW;                 //!< Last bandwidth sample after being filtered
+  Ptr<TcpBwEstimator>    m_bwEstimator;            //!< Bandwidth estimator
   Time                   m_minRtt;                 //!< Minimum RTT
   enum ProtocolType      m_pType;                  //!< 0 for Westwood, 1 for Westwood+
   enum FilterType        m_fType;                  //!< 0 for none, 1 for Tustin
 
-  int                    m_ackedSegments;          //!< The number of segments ACKed between RTTs
-  bool                   m_IsCount;                //!< Start keeping track of m_ackedSegments for Westwood+ if TRUE
+  bool                   m_IsCount;                //!< Start keeping track of the ACKed bytes for Westwood+ if TRUE
   EventId                m_bwEstimateEvent;        //!< The BW estimation event for Westwood+
 
 };
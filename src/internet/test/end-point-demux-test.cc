@@ -0,0 +1,632 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ns3/test.h"
+#include "ns3/log.h"
+#include "ns3/random-variable-stream.h"
+#include "../model/ipv4-end-point-demux.h"
+#include "../model/ipv4-end-point.h"
+#include "ns3/ipv4-interface.h"
+#include "ns3/ipv4-interface-address.h"
+#include "../model/ipv6-end-point-demux.h"
+#include "../model/ipv6-end-point.h"
+
+#include <ctime>
+#include <vector>
+#include <algorithm>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("EndPointDemuxTestSuite");
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Check the IPv4 demux against a linear search of its end points
+ *
+ * End points are allocated, connected, re-addressed, disabled and released
+ * in random order; after each operation, the result of Lookup and
+ * SimpleLookup must be the one of a linear search, in the same order.
+ */
+class Ipv4EndPointDemuxTestCase : public TestCase
+{
+public:
+  Ipv4EndPointDemuxTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \brief Lookup, with a linear search of all the end points
+   * \param daddr destination address
+   * \param dport destination port
+   * \param saddr source address
+   * \param sport source port
+   * \return the end points
+   */
+  Ipv4EndPointDemux::EndPoints RefLookup (Ipv4Address daddr, uint16_t dport,
+                                          Ipv4Address saddr, uint16_t sport);
+
+  /**
+   * \brief SimpleLookup, with a linear search of all the end points
+   * \param daddr destination address
+   * \param dport destination port
+   * \param saddr source address
+   * \param sport source port
+   * \return the end point
+   */
+  Ipv4EndPoint * RefSimpleLookup (Ipv4Address daddr, uint16_t dport,
+                                  Ipv4Address saddr, uint16_t sport);
+
+  /** \brief Compare the lookups with the reference */
+  void Check ();
+
+  Ipv4EndPointDemux m_demux;              //!< The demux under test
+  std::vector<Ipv4EndPoint *> m_endPoints; //!< The allocated end points
+  Ptr<Ipv4Interface> m_interface;          //!< The incoming interface
+  std::vector<Ipv4Address> m_local;        //!< Local addresses
+  std::vector<Ipv4Address> m_peer;         //!< Peer addresses
+  std::vector<uint16_t> m_ports;           //!< Ports
+};
+
+Ipv4EndPointDemuxTestCase::Ipv4EndPointDemuxTestCase ()
+  : TestCase ("Ipv4EndPointDemux against a linear search")
+{
+}
+
+Ipv4EndPointDemux::EndPoints
+Ipv4EndPointDemuxTestCase::RefLookup (Ipv4Address daddr, uint16_t dport,
+                                      Ipv4Address saddr, uint16_t sport)
+{
+  Ipv4EndPointDemux::EndPoints retval1, retval2, retval3, retval4;
+  Ipv4EndPointDemux::EndPoints all = m_demux.GetAllEndPoints ();
+
+  for (Ipv4EndPointDemux::EndPointsI i = all.begin (); i != all.end (); i++)
+    {
+      Ipv4EndPoint* endP = *i;
+      if (!endP->IsRxEnabled () || endP->GetLocalPort () != dport)
+        {
+          continue;
+        }
+      bool subnetDirected = false;
+      Ipv4Address incomingInterfaceAddr = daddr;
+      for (uint32_t j = 0; j < m_interface->GetNAddresses (); j++)
+        {
+          Ipv4InterfaceAddress addr = m_interface->GetAddress (j);
+          if (addr.GetLocal ().CombineMask (addr.GetMask ()) == daddr.CombineMask (addr.GetMask ()) &&
+              daddr.IsSubnetDirectedBroadcast (addr.GetMask ()))
+            {
+              subnetDirected = true;
+              incomingInterfaceAddr = addr.GetLocal ();
+            }
+        }
+      bool isBroadcast = (daddr.IsBroadcast () || subnetDirected);
+      bool localWild = endP->GetLocalAddress () == Ipv4Address::GetAny ();
+      bool localExact = endP->GetLocalAddress () == daddr;
+      if (isBroadcast && !localWild)
+        {
+          localExact = (endP->GetLocalAddress () == incomingInterfaceAddr);
+        }
+      if (!(localExact || localWild))
+        {
+          continue;
+        }
+      bool peerPortExact = endP->GetPeerPort () == sport;
+      bool peerPortWild = endP->GetPeerPort () == 0;
+      bool peerAddrExact = endP->GetPeerAddress () == saddr;
+      bool peerAddrWild = endP->GetPeerAddress () == Ipv4Address::GetAny ();
+      if (!(peerPortExact || peerPortWild) || !(peerAddrExact || peerAddrWild))
+        {
+          continue;
+        }
+      if (localWild && peerPortWild && peerAddrWild)
+        {
+          retval1.push_back (endP);
+        }
+      if ((localExact || (isBroadcast && localWild)) && peerPortWild && peerAddrWild)
+        {
+          retval2.push_back (endP);
+        }
+      if (localWild && peerPortExact && peerAddrExact)
+        {
+          retval3.push_back (endP);
+        }
+      if (localExact && peerPortExact && peerAddrExact)
+        {
+          retval4.push_back (endP);
+        }
+    }
+
+  if (!retval4.empty ()) return retval4;
+  if (!retval3.empty ()) return retval3;
+  if (!retval2.empty ()) return retval2;
+  return retval1;
+}
+
+Ipv4EndPoint *
+Ipv4EndPointDemuxTestCase::RefSimpleLookup (Ipv4Address daddr, uint16_t dport,
+                                            Ipv4Address saddr, uint16_t sport)
+{
+  uint32_t genericity = 3;
+  Ipv4EndPoint *generic = 0;
+  Ipv4EndPointDemux::EndPoints all = m_demux.GetAllEndPoints ();
+  for (Ipv4EndPointDemux::EndPointsI i = all.begin (); i != all.end (); i++)
+    {
+      if ((*i)->GetLocalPort () != dport)
+        {
+          continue;
+        }
+      if ((*i)->GetLocalAddress () == daddr && (*i)->GetPeerPort () == sport
+          && (*i)->GetPeerAddress () == saddr)
+        {
+          return *i;
+        }
+      uint32_t tmp = ((*i)->GetLocalAddress () == Ipv4Address::GetAny ())
+        + ((*i)->GetPeerAddress () == Ipv4Address::GetAny ());
+      if (tmp < genericity)
+        {
+          generic = (*i);
+          genericity = tmp;
+        }
+    }
+  return generic;
+}
+
+void
+Ipv4EndPointDemuxTestCase::Check ()
+{
+  std::vector<Ipv4Address> destinations = m_local;
+  destinations.push_back (Ipv4Address ("10.0.0.255"));
+  destinations.push_back (Ipv4Address::GetBroadcast ());
+
+  for (uint32_t d = 0; d < destinations.size (); ++d)
+    {
+      for (uint32_t dp = 0; dp < m_ports.size (); ++dp)
+        {
+          for (uint32_t s = 0; s < m_peer.size (); ++s)
+            {
+              for (uint32_t sp = 0; sp < m_ports.size (); ++sp)
+                {
+                  Ipv4Address daddr = destinations[d];
+                  Ipv4Address saddr = m_peer[s];
+                  uint16_t dport = m_ports[dp];
+                  uint16_t sport = m_ports[sp];
+                  Ipv4EndPointDemux::EndPoints found = m_demux.Lookup (daddr, dport, saddr, sport, m_interface);
+                  Ipv4EndPointDemux::EndPoints expected = RefLookup (daddr, dport, saddr, sport);
+                  NS_TEST_ASSERT_MSG_EQ ((found == expected), true, "Lookup differs for " << daddr << ":" << dport
+                                         << " from " << saddr << ":" << sport);
+                  NS_TEST_ASSERT_MSG_EQ (m_demux.SimpleLookup (daddr, dport, saddr, sport),
+                                         RefSimpleLookup (daddr, dport, saddr, sport),
+                                         "SimpleLookup differs");
+                }
+            }
+          bool local = false;
+          bool portLocal = false;
+          Ipv4EndPointDemux::EndPoints all = m_demux.GetAllEndPoints ();
+          for (Ipv4EndPointDemux::EndPointsI i = all.begin (); i != all.end (); i++)
+            {
+              if ((*i)->GetLocalPort () == m_ports[dp])
+                {
+                  portLocal = true;
+                  local = local || (*i)->GetLocalAddress () == destinations[d];
+                }
+            }
+          NS_TEST_ASSERT_MSG_EQ (m_demux.LookupLocal (destinations[d], m_ports[dp]), local, "LookupLocal differs");
+          NS_TEST_ASSERT_MSG_EQ (m_demux.LookupPortLocal (m_ports[dp]), portLocal, "LookupPortLocal differs");
+        }
+    }
+}
+
+void
+Ipv4EndPointDemuxTestCase::DoRun ()
+{
+  Ptr<UniformRandomVariable> rng = CreateObject<UniformRandomVariable> ();
+  rng->SetStream (1);
+
+  m_interface = CreateObject<Ipv4Interface> ();
+  m_interface->AddAddress (Ipv4InterfaceAddress (Ipv4Address ("10.0.0.1"), Ipv4Mask ("255.255.255.0")));
+  m_interface->AddAddress (Ipv4InterfaceAddress (Ipv4Address ("10.0.0.2"), Ipv4Mask ("255.255.255.0")));
+
+  m_local.push_back (Ipv4Address::GetAny ());
+  m_local.push_back (Ipv4Address ("10.0.0.1"));
+  m_local.push_back (Ipv4Address ("10.0.0.2"));
+  m_peer.push_back (Ipv4Address::GetAny ());
+  m_peer.push_back (Ipv4Address ("10.0.1.1"));
+  m_peer.push_back (Ipv4Address ("10.0.1.2"));
+  m_ports.push_back (0);
+  m_ports.push_back (80);
+  m_ports.push_back (81);
+
+  for (uint32_t step = 0; step < 300; ++step)
+    {
+      uint32_t op = rng->GetInteger (0, 9);
+      Ipv4Address local = m_local[rng->GetInteger (0, m_local.size () - 1)];
+      Ipv4Address peer = m_peer[rng->GetInteger (0, m_peer.size () - 1)];
+      uint16_t port = m_ports[rng->GetInteger (1, m_ports.size () - 1)];
+      uint16_t peerPort = m_ports[rng->GetInteger (0, m_ports.size () - 1)];
+      Ipv4EndPoint *endPoint = 0;
+      if (!m_endPoints.empty ())
+        {
+          endPoint = m_endPoints[rng->GetInteger (0, m_endPoints.size () - 1)];
+        }
+
+      if (op < 2)
+        {
+          Ipv4EndPoint *e = m_demux.Allocate (local, port);
+          if (e != 0)
+            {
+              m_endPoints.push_back (e);
+            }
+        }
+      else if (op < 4)
+        {
+          Ipv4EndPoint *e = m_demux.Allocate (local, port, peer, peerPort);
+          if (e != 0)
+            {
+              m_endPoints.push_back (e);
+            }
+        }
+      else if (op < 5)
+        {
+          Ipv4EndPoint *e = m_demux.Allocate (local);
+          if (m_ports.size () < 5)
+            {
+              m_ports.push_back (e->GetLocalPort ());
+            }
+          m_endPoints.push_back (e);
+        }
+      else if (op < 7 && endPoint != 0)
+        {
+          endPoint->SetPeer (peer, peerPort);
+        }
+      else if (op < 8 && endPoint != 0)
+        {
+          endPoint->SetLocalAddress (local);
+        }
+      else if (op < 9 && endPoint != 0)
+        {
+          endPoint->SetRxEnabled (!endPoint->IsRxEnabled ());
+        }
+      else if (endPoint != 0)
+        {
+          m_demux.DeAllocate (endPoint);
+          m_endPoints.erase (std::find (m_endPoints.begin (), m_endPoints.end (), endPoint));
+        }
+
+      Check ();
+    }
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Check the IPv6 demux against a linear search of its end points
+ *
+ * As Ipv4EndPointDemuxTestCase, with the local port that changes as well.
+ */
+class Ipv6EndPointDemuxTestCase : public TestCase
+{
+public:
+  Ipv6EndPointDemuxTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \brief Lookup, with a linear search of all the end points
+   * \param daddr destination address
+   * \param dport destination port
+   * \param saddr source address
+   * \param sport source port
+   * \return the end points
+   */
+  Ipv6EndPointDemux::EndPoints RefLookup (Ipv6Address daddr, uint16_t dport,
+                                          Ipv6Address saddr, uint16_t sport);
+
+  /** \brief Compare the lookups with the reference */
+  void Check ();
+
+  Ipv6EndPointDemux m_demux;              //!< The demux under test
+  std::vector<Ipv6EndPoint *> m_endPoints; //!< The allocated end points
+  std::vector<Ipv6Address> m_local;        //!< Local addresses
+  std::vector<Ipv6Address> m_peer;         //!< Peer addresses
+  std::vector<uint16_t> m_ports;           //!< Ports
+};
+
+Ipv6EndPointDemuxTestCase::Ipv6EndPointDemuxTestCase ()
+  : TestCase ("Ipv6EndPointDemux against a linear search")
+{
+}
+
+Ipv6EndPointDemux::EndPoints
+Ipv6EndPointDemuxTestCase::RefLookup (Ipv6Address daddr, uint16_t dport,
+                                      Ipv6Address saddr, uint16_t sport)
+{
+  Ipv6EndPointDemux::EndPoints retval1, retval2, retval3, retval4;
+  Ipv6EndPointDemux::EndPoints all = m_demux.GetEndPoints ();
+
+  for (Ipv6EndPointDemux::EndPointsI i = all.begin (); i != all.end (); i++)
+    {
+      Ipv6EndPoint* endP = *i;
+      if (!endP->IsRxEnabled () || endP->GetLocalPort () != dport)
+        {
+          continue;
+        }
+      bool localWild = endP->GetLocalAddress () == Ipv6Address::GetAny ();
+      bool localExact = endP->GetLocalAddress () == daddr;
+      if (!(localExact || localWild))
+        {
+          continue;
+        }
+      bool peerPortExact = endP->GetPeerPort () == sport;
+      bool peerPortWild = endP->GetPeerPort () == 0;
+      bool peerAddrExact = endP->GetPeerAddress () == saddr;
+      bool peerAddrWild = endP->GetPeerAddress () == Ipv6Address::GetAny ();
+      if (!(peerPortExact || peerPortWild) || !(peerAddrExact || peerAddrWild))
+        {
+          continue;
+        }
+      if (localWild && peerPortWild && peerAddrWild)
+        {
+          retval1.push_back (endP);
+        }
+      if (localExact && peerPortWild && peerAddrWild)
+        {
+          retval2.push_back (endP);
+        }
+      if (localWild && peerPortExact && peerAddrExact)
+        {
+          retval3.push_back (endP);
+        }
+      if (localExact && peerPortExact && peerAddrExact)
+        {
+          retval4.push_back (endP);
+        }
+    }
+
+  if (!retval4.empty ()) return retval4;
+  if (!retval3.empty ()) return retval3;
+  if (!retval2.empty ()) return retval2;
+  return retval1;
+}
+
+void
+Ipv6EndPointDemuxTestCase::Check ()
+{
+  for (uint32_t d = 1; d < m_local.size (); ++d)
+    {
+      for (uint32_t dp = 0; dp < m_ports.size (); ++dp)
+        {
+          for (uint32_t s = 1; s < m_peer.size (); ++s)
+            {
+              for (uint32_t sp = 0; sp < m_ports.size (); ++sp)
+                {
+                  Ipv6EndPointDemux::EndPoints found = m_demux.Lookup (m_local[d], m_ports[dp], m_peer[s], m_ports[sp], 0);
+                  Ipv6EndPointDemux::EndPoints expected = RefLookup (m_local[d], m_ports[dp], m_peer[s], m_ports[sp]);
+                  NS_TEST_ASSERT_MSG_EQ ((found == expected), true, "Lookup differs for " << m_local[d] << ":" << m_ports[dp]
+                                         << " from " << m_peer[s] << ":" << m_ports[sp]);
+                }
+            }
+        }
+    }
+}
+
+void
+Ipv6EndPointDemuxTestCase::DoRun ()
+{
+  Ptr<UniformRandomVariable> rng = CreateObject<UniformRandomVariable> ();
+  rng->SetStream (2);
+
+  m_local.push_back (Ipv6Address::GetAny ());
+  m_local.push_back (Ipv6Address ("2001:1::1"));
+  m_local.push_back (Ipv6Address ("2001:1::2"));
+  m_peer.push_back (Ipv6Address::GetAny ());
+  m_peer.push_back (Ipv6Address ("2001:2::1"));
+  m_peer.push_back (Ipv6Address ("2001:2::2"));
+  m_ports.push_back (0);
+  m_ports.push_back (80);
+  m_ports.push_back (81);
+
+  for (uint32_t step = 0; step < 300; ++step)
+    {
+      uint32_t op = rng->GetInteger (0, 10);
+      Ipv6Address local = m_local[rng->GetInteger (0, m_local.size () - 1)];
+      Ipv6Address peer = m_peer[rng->GetInteger (0, m_peer.size () - 1)];
+      uint16_t port = m_ports[rng->GetInteger (1, m_ports.size () - 1)];
+      uint16_t peerPort = m_ports[rng->GetInteger (0, m_ports.size () - 1)];
+      Ipv6EndPoint *endPoint = 0;
+      if (!m_endPoints.empty ())
+        {
+          endPoint = m_endPoints[rng->GetInteger (0, m_endPoints.size () - 1)];
+        }
+
+      if (op < 2)
+        {
+          Ipv6EndPoint *e = m_demux.Allocate (local, port);
+          if (e != 0)
+            {
+              m_endPoints.push_back (e);
+            }
+        }
+      else if (op < 4)
+        {
+          Ipv6EndPoint *e = m_demux.Allocate (local, port, peer, peerPort);
+          if (e != 0)
+            {
+              m_endPoints.push_back (e);
+            }
+        }
+      else if (op < 5)
+        {
+          Ipv6EndPoint *e = m_demux.Allocate (local);
+          if (m_ports.size () < 5)
+            {
+              m_ports.push_back (e->GetLocalPort ());
+            }
+          m_endPoints.push_back (e);
+        }
+      else if (op < 7 && endPoint != 0)
+        {
+          endPoint->SetPeer (peer, peerPort);
+        }
+      else if (op < 8 && endPoint != 0)
+        {
+          endPoint->SetLocalAddress (local);
+        }
+      else if (op < 9 && endPoint != 0)
+        {
+          endPoint->SetLocalPort (port);
+        }
+      else if (op < 10 && endPoint != 0)
+        {
+          endPoint->SetRxEnabled (!endPoint->IsRxEnabled ());
+        }
+      else if (endPoint != 0)
+        {
+          m_demux.DeAllocate (endPoint);
+          m_endPoints.erase (std::find (m_endPoints.begin (), m_endPoints.end (), endPoint));
+        }
+
+      Check ();
+    }
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Measure Lookup and DeAllocate on a server with many connections
+ *
+ * A listening end point and a number of connections on the same port, from
+ * different clients; the packets of the connections are looked up in
+ * random order, then the connections are closed, the last opened first.
+ */
+class Ipv4EndPointDemuxTimeTestCase : public TestCase
+{
+public:
+  /**
+   * \brief Constructor
+   * \param connections number of connections
+   */
+  Ipv4EndPointDemuxTimeTestCase (uint32_t connections);
+
+private:
+  virtual void DoRun (void);
+  uint32_t m_connections; //!< Number of connections
+};
+
+Ipv4EndPointDemuxTimeTestCase::Ipv4EndPointDemuxTimeTestCase (uint32_t connections)
+  : TestCase ("Ipv4EndPointDemux lookup and deallocation time"),
+    m_connections (connections)
+{
+}
+
+void
+Ipv4EndPointDemuxTimeTestCase::DoRun ()
+{
+  const uint32_t lookups = 200000;
+  Ipv4Address server ("10.0.0.1");
+  Ptr<Ipv4Interface> interface = CreateObject<Ipv4Interface> ();
+  interface->AddAddress (Ipv4InterfaceAddress (server, Ipv4Mask ("255.0.0.0")));
+
+  Ipv4EndPointDemux demux;
+  demux.Allocate (80);
+  std::vector<Ipv4EndPoint *> connections (m_connections);
+  for (uint32_t i = 0; i < m_connections; ++i)
+    {
+      connections[i] = demux.Allocate (server, 80, Ipv4Address (0x0b000000 + i), 49152 + i % 1000);
+    }
+
+  Ptr<UniformRandomVariable> rng = CreateObject<UniformRandomVariable> ();
+  rng->SetStream (1);
+  std::vector<uint32_t> clients (lookups);
+  for (uint32_t i = 0; i < lookups; ++i)
+    {
+      clients[i] = rng->GetInteger (0, m_connections - 1);
+    }
+
+  uint32_t found = 0;
+  int start = clock ();
+  for (uint32_t i = 0; i < lookups; ++i)
+    {
+      uint32_t c = clients[i];
+      Ipv4EndPointDemux::EndPoints endPoints;
+      endPoints = demux.Lookup (server, 80, Ipv4Address (0x0b000000 + c), 49152 + c % 1000, interface);
+      found += endPoints.size ();
+    }
+  int stop = clock ();
+
+  NS_TEST_ASSERT_MSG_EQ (found, lookups, "Every packet should match one connection");
+
+  double per = 1E9 * double (stop - start) / (double (lookups) * double (CLOCKS_PER_SEC));
+
+  start = clock ();
+  for (uint32_t i = m_connections; i > 0; --i)
+    {
+      demux.DeAllocate (connections[i - 1]);
+    }
+  stop = clock ();
+
+  NS_TEST_ASSERT_MSG_EQ (demux.GetAllEndPoints ().size (), 1, "Only the listening end point should remain");
+
+  double perDeAllocate = 1E9 * double (stop - start) / (double (m_connections) * double (CLOCKS_PER_SEC));
+  std::cout << "Ipv4EndPointDemux: " << m_connections << " connections, "
+            << per << " nanosec/lookup, "
+            << perDeAllocate << " nanosec/deallocation" << std::endl;
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief the TestSuite for the end point demultiplexers
+ */
+class EndPointDemuxTestSuite : public TestSuite
+{
+public:
+  EndPointDemuxTestSuite ()
+    : TestSuite ("end-point-demux", UNIT)
+  {
+    AddTestCase (new Ipv4EndPointDemuxTestCase, TestCase::QUICK);
+    AddTestCase (new Ipv6EndPointDemuxTestCase, TestCase::QUICK);
+  }
+};
+
+static EndPointDemuxTestSuite g_endPointDemuxTestSuite; //!< Static variable for test initialization
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief the TestSuite for the end point demultiplexers performance
+ */
+class EndPointDemuxPerfTestSuite : public TestSuite
+{
+public:
+  EndPointDemuxPerfTestSuite ()
+    : TestSuite ("end-point-demux-perf", PERFORMANCE)
+  {
+    AddTestCase (new Ipv4EndPointDemuxTimeTestCase (10), TestCase::QUICK);
+    AddTestCase (new Ipv4EndPointDemuxTimeTestCase (100), TestCase::QUICK);
+    AddTestCase (new Ipv4EndPointDemuxTimeTestCase (1000), TestCase::QUICK);
+    AddTestCase (new Ipv4EndPointDemuxTimeTestCase (10000), TestCase::QUICK);
+  }
+};
+
+static EndPointDemuxPerfTestSuite g_endPointDemuxPerfTestSuite; //!< Static variable for test initialization
@@ -26,7 +26,10 @@
 #include "ns3/global-route-manager-impl.h"
 #include "ns3/candidate-queue.h"
 #include "ns3/simulator.h"
+#include "ns3/random-variable-stream.h"
 #include <cstdlib> // for rand()
+#include <list>
+#include <algorithm>
 
 using namespace ns3;
 
@@ -226,6 +229,115 @@ GlobalRouteManagerImplTestCase::DoRun (void)
 }
 
 
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Check the order of the candidate queue against a sorted list
+ *
+ * The candidate queue used to be a list sorted at each push, and sorted
+ * again (with a stable sort) after the distance of a vertex was lowered.
+ * The order in which the vertices are popped decides the order of the
+ * routes, so the heap must pop them in the very same order, ties included.
+ */
+class CandidateQueueTestCase : public TestCase
+{
+public:
+  CandidateQueueTestCase ();
+  virtual void DoRun (void);
+
+private:
+  /// The former queue: a list of vertices kept sorted
+  typedef std::list<SPFVertex *> SortedList;
+
+  /**
+   * \param v1 first vertex
+   * \param v2 second vertex
+   * \return true if v1 should be popped before v2
+   */
+  static bool Compare (const SPFVertex *v1, const SPFVertex *v2);
+};
+
+CandidateQueueTestCase::CandidateQueueTestCase ()
+  : TestCase ("Order of the SPF candidate queue")
+{
+}
+
+bool
+CandidateQueueTestCase::Compare (const SPFVertex *v1, const SPFVertex *v2)
+{
+  if (v1->GetDistanceFromRoot () != v2->GetDistanceFromRoot ())
+    {
+      return v1->GetDistanceFromRoot () < v2->GetDistanceFromRoot ();
+    }
+  return v1->GetVertexType () == SPFVertex::VertexNetwork
+         && v2->GetVertexType () == SPFVertex::VertexRouter;
+}
+
+void
+CandidateQueueTestCase::DoRun (void)
+{
+  Ptr<UniformRandomVariable> rng = CreateObject<UniformRandomVariable> ();
+  CandidateQueue candidate;
+  SortedList sorted;
+  uint32_t nextId = 1;
+
+  for (uint32_t step = 0; step < 5000; step++)
+    {
+      uint32_t action = rng->GetInteger (0, 9);
+      if (action < 4 || sorted.empty ())
+        {
+          SPFVertex *v = new SPFVertex;
+          v->SetVertexId (Ipv4Address (nextId++));
+          v->SetVertexType (rng->GetInteger (0, 1) ? SPFVertex::VertexRouter : SPFVertex::VertexNetwork);
+          v->SetDistanceFromRoot (rng->GetInteger (0, 20));
+          candidate.Push (v);
+          sorted.insert (std::upper_bound (sorted.begin (), sorted.end (), v, &Compare), v);
+        }
+      else if (action < 7)
+        {
+          SPFVertex *v = candidate.Pop ();
+          NS_TEST_ASSERT_MSG_EQ (v, sorted.front (), "Vertex popped out of order at step " << step);
+          sorted.remove (v);
+          delete v;
+        }
+      else
+        {
+          SortedList::iterator i = sorted.begin ();
+          std::advance (i, rng->GetInteger (0, sorted.size () - 1));
+          SPFVertex *v = *i;
+          NS_TEST_ASSERT_MSG_EQ (candidate.Find (v->GetVertexId ()), v, "Vertex not found");
+          if (v->GetDistanceFromRoot () == 0)
+            {
+              continue;
+            }
+          v->SetDistanceFromRoot (rng->GetInteger (0, v->GetDistanceFromRoot () - 1));
+          sorted.sort (&Compare);
+          if (action == 9)
+            {
+              candidate.Reorder ();
+            }
+          else
+            {
+              candidate.Update (v);
+            }
+        }
+      NS_TEST_ASSERT_MSG_EQ (candidate.Size (), sorted.size (), "Wrong queue size");
+      NS_TEST_ASSERT_MSG_EQ (candidate.Top (), (sorted.empty () ? 0 : sorted.front ()),
+                             "Wrong top of the queue at step " << step);
+    }
+  NS_TEST_ASSERT_MSG_EQ (candidate.Find (Ipv4Address (nextId)), 0, "Found a vertex never pushed");
+
+  while (!sorted.empty ())
+    {
+      SPFVertex *v = candidate.Pop ();
+      NS_TEST_ASSERT_MSG_EQ (v, sorted.front (), "Vertex popped out of order");
+      sorted.remove (v);
+      delete v;
+    }
+  NS_TEST_ASSERT_MSG_EQ (candidate.Empty (), true, "Queue not empty");
+}
+
 /**
  * \ingroup internet-test
  * \ingroup tests
@@ -243,6 +355,7 @@ GlobalRouteManagerImplTestSuite::GlobalRouteManagerImplTestSuite ()
   : TestSuite ("global-route-manager-impl", UNIT)
 {
   AddTestCase (new GlobalRouteManagerImplTestCase (), TestCase::QUICK);
+  AddTestCase (new CandidateQueueTestCase (), TestCase::QUICK);
 }
 
 static GlobalRouteManagerImplTestSuite g_globalRoutingManagerImplTestSuite; //!< Static variable for test initialization
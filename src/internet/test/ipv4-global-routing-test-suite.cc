@@ -42,6 +42,10 @@
 #include "ns3/ipv4-routing-table-entry.h"
 #include "ns3/ipv4-global-routing.h"
 #include "ns3/bridge-helper.h"
+#include "ns3/global-route-manager.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/system-wall-clock-ms.h"
+#include <sstream>
 
 using namespace ns3;
 
@@ -1244,6 +1248,249 @@ Ipv4GlobalRoutingSlash32TestCase::DoRun (void)
   Simulator::Destroy ();
 }
 
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Check the update of the routes against their full recomputation
+ *
+ * RecomputeRoutingTables () keeps the routes which did not change in place.
+ * On a random topology whose interfaces go down and up, the tables it
+ * leaves, and the routes they give, must be those obtained by deleting all
+ * the routes and computing them again.
+ *
+ * The routes may be computed with several threads; those they are compared
+ * with are always computed with one.
+ */
+class Ipv4GlobalRoutingUpdateTestCase : public TestCase
+{
+public:
+  /**
+   * \brief Constructor
+   * \param threads the number of threads computing the routes
+   */
+  Ipv4GlobalRoutingUpdateTestCase (uint32_t threads);
+
+private:
+  virtual void DoRun (void);
+  virtual void DoTeardown (void);
+
+  /**
+   * \brief Describe the routing tables and the routes they give
+   * \return the description
+   */
+  std::string GetRoutes (void);
+
+  uint32_t m_threads; //!< Number of threads computing the routes
+  NodeContainer m_nodes; //!< Nodes used in the test
+  std::vector<Ipv4Address> m_addresses; //!< Addresses of the interfaces
+};
+
+Ipv4GlobalRoutingUpdateTestCase::Ipv4GlobalRoutingUpdateTestCase (uint32_t threads)
+  : TestCase (threads > 1 ? "Global routing update after interface events, with threads"
+              : "Global routing update after interface events"),
+    m_threads (threads)
+{
+}
+
+std::string
+Ipv4GlobalRoutingUpdateTestCase::GetRoutes (void)
+{
+  std::ostringstream oss;
+  Ptr<Packet> packet = Create<Packet> ();
+  for (uint32_t i = 0; i < m_nodes.GetN (); i++)
+    {
+      Ptr<Ipv4> ipv4 = m_nodes.Get (i)->GetObject<Ipv4> ();
+      Ptr<Ipv4GlobalRouting> globalRouting = ipv4->GetRoutingProtocol ()->GetObject<Ipv4GlobalRouting> ();
+      oss << "node " << i << std::endl;
+      for (uint32_t j = 0; j < globalRouting->GetNRoutes (); j++)
+        {
+          oss << *globalRouting->GetRoute (j) << std::endl;
+        }
+      for (uint32_t j = 0; j < m_addresses.size (); j++)
+        {
+          Ipv4Header header;
+          header.SetDestination (m_addresses[j]);
+          Socket::SocketErrno err;
+          Ptr<Ipv4Route> route = globalRouting->RouteOutput (packet, header, 0, err);
+          if (route != 0)
+            {
+              oss << m_addresses[j] << " via " << route->GetGateway ()
+                  << " on " << ipv4->GetInterfaceForDevice (route->GetOutputDevice ()) << std::endl;
+            }
+        }
+    }
+  return oss.str ();
+}
+
+void
+Ipv4GlobalRoutingUpdateTestCase::DoRun (void)
+{
+  const uint32_t nNodes = 24;
+  Ptr<UniformRandomVariable> rng = CreateObject<UniformRandomVariable> ();
+  m_nodes.Create (nNodes);
+  InternetStackHelper internet;
+  Ipv4GlobalRoutingHelper ipv4RoutingHelper;
+  internet.SetRoutingHelper (ipv4RoutingHelper);
+  internet.Install (m_nodes);
+
+  // A random tree, plus links making loops, on /30 networks
+  SimpleNetDeviceHelper simpleHelper;
+  simpleHelper.SetNetDevicePointToPointMode (true);
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase ("10.0.0.0", "255.255.255.252");
+  for (uint32_t i = 1; i < nNodes + 12; i++)
+    {
+      uint32_t a = i < nNodes ? i : rng->GetInteger (0, nNodes - 1);
+      uint32_t b = i < nNodes ? rng->GetInteger (0, i - 1) : rng->GetInteger (0, nNodes - 1);
+      if (a == b)
+        {
+          continue;
+        }
+      NetDeviceContainer net = simpleHelper.Install (NodeContainer (m_nodes.Get (a), m_nodes.Get (b)),
+                                                     CreateObject<SimpleChannel> ());
+      Ipv4InterfaceContainer interfaces = ipv4.Assign (net);
+      m_addresses.push_back (interfaces.GetAddress (0));
+      m_addresses.push_back (interfaces.GetAddress (1));
+      ipv4.NewNetwork ();
+      for (uint32_t j = 0; j < 2; j++)
+        {
+          interfaces.Get (j).first->SetMetric (interfaces.Get (j).second, rng->GetInteger (1, 3));
+        }
+    }
+
+  Config::SetGlobal ("GlobalRoutingThreads", UintegerValue (m_threads));
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+
+  for (uint32_t step = 0; step < 20; step++)
+    {
+      Ptr<Ipv4> ip = m_nodes.Get (rng->GetInteger (0, nNodes - 1))->GetObject<Ipv4> ();
+      uint32_t interface = rng->GetInteger (1, ip->GetNInterfaces () - 1);
+      if (ip->IsUp (interface))
+        {
+          ip->SetDown (interface);
+        }
+      else
+        {
+          ip->SetUp (interface);
+        }
+
+      Ipv4GlobalRoutingHelper::RecomputeRoutingTables ();
+      std::string updated = GetRoutes ();
+      if (step % 2 == 0)
+        {
+          // Leave the updated tables for the next update
+          continue;
+        }
+      Config::SetGlobal ("GlobalRoutingThreads", UintegerValue (1));
+      GlobalRouteManager::DeleteGlobalRoutes ();
+      GlobalRouteManager::BuildGlobalRoutingDatabase ();
+      GlobalRouteManager::InitializeRoutes ();
+      std::string recomputed = GetRoutes ();
+      Config::SetGlobal ("GlobalRoutingThreads", UintegerValue (m_threads));
+      NS_TEST_ASSERT_MSG_EQ (updated, recomputed, "Updated routes differ at step " << step);
+    }
+}
+
+void
+Ipv4GlobalRoutingUpdateTestCase::DoTeardown (void)
+{
+  Config::SetGlobal ("GlobalRoutingThreads", UintegerValue (1));
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Time the computation and the update of the routes on a grid
+ *
+ * The times are wall-clock times, as the routes may be computed with
+ * several threads.
+ */
+class Ipv4GlobalRoutingTimeTestCase : public TestCase
+{
+public:
+  /**
+   * \brief Constructor
+   * \param side the number of nodes on a side of the grid
+   * \param threads the number of threads computing the routes
+   */
+  Ipv4GlobalRoutingTimeTestCase (uint32_t side, uint32_t threads);
+
+private:
+  virtual void DoRun (void);
+
+  uint32_t m_side; //!< Number of nodes on a side of the grid
+  uint32_t m_threads; //!< Number of threads computing the routes
+};
+
+Ipv4GlobalRoutingTimeTestCase::Ipv4GlobalRoutingTimeTestCase (uint32_t side, uint32_t threads)
+  : TestCase ("Time the global routing on a grid"),
+    m_side (side),
+    m_threads (threads)
+{
+}
+
+void
+Ipv4GlobalRoutingTimeTestCase::DoRun (void)
+{
+  Ptr<UniformRandomVariable> rng = CreateObject<UniformRandomVariable> ();
+  NodeContainer nodes;
+  nodes.Create (m_side * m_side);
+  InternetStackHelper internet;
+  Ipv4GlobalRoutingHelper ipv4RoutingHelper;
+  internet.SetRoutingHelper (ipv4RoutingHelper);
+  internet.Install (nodes);
+
+  // Each node is linked to its right and lower neighbours
+  SimpleNetDeviceHelper simpleHelper;
+  simpleHelper.SetNetDevicePointToPointMode (true);
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase ("10.0.0.0", "255.255.255.252");
+  for (uint32_t i = 0; i < nodes.GetN (); i++)
+    {
+      uint32_t row = i / m_side;
+      uint32_t column = i % m_side;
+      std::vector<uint32_t> neighbours;
+      if (column + 1 < m_side)
+        {
+          neighbours.push_back (i + 1);
+        }
+      if (row + 1 < m_side)
+        {
+          neighbours.push_back (i + m_side);
+        }
+      for (uint32_t j = 0; j < neighbours.size (); j++)
+        {
+          NetDeviceContainer net = simpleHelper.Install (NodeContainer (nodes.Get (i), nodes.Get (neighbours[j])),
+                                                         CreateObject<SimpleChannel> ());
+          Ipv4InterfaceContainer interfaces = ipv4.Assign (net);
+          ipv4.NewNetwork ();
+          for (uint32_t k = 0; k < 2; k++)
+            {
+              interfaces.Get (k).first->SetMetric (interfaces.Get (k).second, rng->GetInteger (1, 3));
+            }
+        }
+    }
+
+  Config::SetGlobal ("GlobalRoutingThreads", UintegerValue (m_threads));
+  SystemWallClockMs clock;
+  clock.Start ();
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+  int64_t populate = clock.End ();
+  nodes.Get (nodes.GetN () / 2)->GetObject<Ipv4> ()->SetDown (1);
+  clock.Start ();
+  Ipv4GlobalRoutingHelper::RecomputeRoutingTables ();
+  int64_t recompute = clock.End ();
+  Config::SetGlobal ("GlobalRoutingThreads", UintegerValue (1));
+
+  std::cout << nodes.GetN () << " nodes, " << m_threads << " threads: populate "
+            << populate << " ms, recompute after a link failure "
+            << recompute << " ms" << std::endl;
+  Simulator::Destroy ();
+}
+
 /**
  * \ingroup internet-test
  * \ingroup tests
@@ -1267,6 +1514,30 @@ Ipv4GlobalRoutingTestSuite::Ipv4GlobalRoutingTestSuite ()
     AddTestCase (new TwoBridgeTest, TestCase::QUICK);
     AddTestCase (new Ipv4DynamicGlobalRoutingTestCase, TestCase::QUICK);
     AddTestCase (new Ipv4GlobalRoutingSlash32TestCase, TestCase::QUICK);
+    AddTestCase (new Ipv4GlobalRoutingUpdateTestCase (1), TestCase::QUICK);
+    AddTestCase (new Ipv4GlobalRoutingUpdateTestCase (4), TestCase::QUICK);
   }
 
 static Ipv4GlobalRoutingTestSuite g_globalRoutingTestSuite; //!< Static variable for test initialization
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief IPv4 GlobalRouting performance TestSuite
+ */
+class Ipv4GlobalRoutingPerfTestSuite : public TestSuite
+{
+public:
+  Ipv4GlobalRoutingPerfTestSuite ()
+    : TestSuite ("ipv4-global-routing-perf", PERFORMANCE)
+  {
+    AddTestCase (new Ipv4GlobalRoutingTimeTestCase (10, 1), TestCase::QUICK);
+    AddTestCase (new Ipv4GlobalRoutingTimeTestCase (20, 1), TestCase::QUICK);
+    AddTestCase (new Ipv4GlobalRoutingTimeTestCase (20, 4), TestCase::QUICK);
+    AddTestCase (new Ipv4GlobalRoutingTimeTestCase (32, 1), TestCase::QUICK);
+    AddTestCase (new Ipv4GlobalRoutingTimeTestCase (32, 4), TestCase::QUICK);
+  }
+};
+
+static Ipv4GlobalRoutingPerfTestSuite g_globalRoutingPerfTestSuite; //!< Static variable for test initialization
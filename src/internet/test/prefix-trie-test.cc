@@ -0,0 +1,603 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/log.h"
+#include "ns3/node.h"
+#include "ns3/packet.h"
+#include "ns3/simulator.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/ipv6-address-helper.h"
+#include "ns3/simple-net-device-helper.h"
+#include "ns3/ipv4-static-routing.h"
+#include "ns3/ipv4-global-routing.h"
+#include "ns3/ipv4-routing-table-entry.h"
+#include "ns3/ipv6-static-routing.h"
+#include "ns3/ipv6-routing-table-entry.h"
+#include "ns3/ipv4-route.h"
+#include "ns3/ipv6-route.h"
+
+#include <ctime>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("PrefixTrieTestSuite");
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Base of the routing lookup tests: a node with three interfaces
+ */
+class PrefixTrieTestCase : public TestCase
+{
+public:
+  /**
+   * \brief Constructor
+   * \param name name of the test
+   */
+  PrefixTrieTestCase (std::string name);
+
+protected:
+  /**
+   * \brief Create the node and its interfaces
+   */
+  void CreateNode (void);
+
+  /**
+   * \return a random IPv4 prefix, from a small set of overlapping ones
+   * \param mask the mask of the prefix
+   */
+  Ipv4Address RandomIpv4Network (Ipv4Mask &mask);
+
+  /**
+   * \return a random IPv4 destination, in the networks of RandomIpv4Network
+   */
+  Ipv4Address RandomIpv4Destination (void);
+
+  /**
+   * \return a random IPv6 prefix, from a small set of overlapping ones
+   * \param prefix the prefix length
+   */
+  Ipv6Address RandomIpv6Network (Ipv6Prefix &prefix);
+
+  /**
+   * \return a random IPv6 destination, in the networks of RandomIpv6Network
+   */
+  Ipv6Address RandomIpv6Destination (void);
+
+  /**
+   * \return a random output device, or 0
+   */
+  Ptr<NetDevice> RandomOif (void);
+
+  Ptr<Node> m_node;                    //!< The node
+  Ptr<Ipv4> m_ipv4;                    //!< IPv4 of the node
+  Ptr<Ipv6> m_ipv6;                    //!< IPv6 of the node
+  Ptr<UniformRandomVariable> m_rng;    //!< Random variable
+  uint32_t m_gateways;                 //!< Gateways allocated
+};
+
+PrefixTrieTestCase::PrefixTrieTestCase (std::string name)
+  : TestCase (name),
+    m_gateways (0)
+{
+}
+
+void
+PrefixTrieTestCase::CreateNode (void)
+{
+  m_node = CreateObject<Node> ();
+  InternetStackHelper internet;
+  internet.Install (m_node);
+
+  SimpleNetDeviceHelper simple;
+  NetDeviceContainer devices;
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      devices.Add (simple.Install (m_node));
+    }
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase ("192.168.0.0", "255.255.255.0");
+  ipv4.Assign (devices);
+  Ipv6AddressHelper ipv6;
+  ipv6.SetBase (Ipv6Address ("2001:1::"), Ipv6Prefix (64));
+  ipv6.Assign (devices);
+
+  m_ipv4 = m_node->GetObject<Ipv4> ();
+  m_ipv6 = m_node->GetObject<Ipv6> ();
+  m_rng = CreateObject<UniformRandomVariable> ();
+  m_rng->SetStream (1);
+}
+
+Ipv4Address
+PrefixTrieTestCase::RandomIpv4Network (Ipv4Mask &mask)
+{
+  static const uint32_t lengths[] = { 0, 8, 16, 20, 24, 25, 30, 32 };
+  if (m_rng->GetInteger (0, 30) == 0)
+    {
+      mask = Ipv4Mask ("255.0.255.0");
+    }
+  else
+    {
+      mask = Ipv4Mask ((std::string ("/") + std::to_string (lengths[m_rng->GetInteger (0, 7)])).c_str ());
+    }
+  return RandomIpv4Destination ().CombineMask (mask);
+}
+
+Ipv4Address
+PrefixTrieTestCase::RandomIpv4Destination (void)
+{
+  return Ipv4Address ((10 << 24) | (m_rng->GetInteger (0, 3) << 16)
+                      | (m_rng->GetInteger (0, 3) << 8) | m_rng->GetInteger (0, 255));
+}
+
+Ipv6Address
+PrefixTrieTestCase::RandomIpv6Network (Ipv6Prefix &prefix)
+{
+  static const uint8_t lengths[] = { 0, 32, 48, 64, 96, 120, 127, 128 };
+  if (m_rng->GetInteger (0, 30) == 0)
+    {
+      prefix = Ipv6Prefix ("ffff:ffff:0:ffff::");
+    }
+  else
+    {
+      prefix = Ipv6Prefix (lengths[m_rng->GetInteger (0, 7)]);
+    }
+  return RandomIpv6Destination ().CombinePrefix (prefix);
+}
+
+Ipv6Address
+PrefixTrieTestCase::RandomIpv6Destination (void)
+{
+  uint8_t buf[16] = { 0x20, 0x01, 0x0d, 0xb8 };
+  buf[5] = m_rng->GetInteger (0, 3);
+  buf[7] = m_rng->GetInteger (0, 3);
+  buf[15] = m_rng->GetInteger (0, 255);
+  return Ipv6Address (buf);
+}
+
+Ptr<NetDevice>
+PrefixTrieTestCase::RandomOif (void)
+{
+  uint32_t i = m_rng->GetInteger (0, 5);
+  return i < 3 ? m_node->GetDevice (i + 1) : 0;
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Check Ipv4StaticRouting lookups against a scan of its routes
+ */
+class Ipv4StaticRoutingLookupTestCase : public PrefixTrieTestCase
+{
+public:
+  Ipv4StaticRoutingLookupTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+Ipv4StaticRoutingLookupTestCase::Ipv4StaticRoutingLookupTestCase ()
+  : PrefixTrieTestCase ("Ipv4StaticRouting lookup")
+{
+}
+
+void
+Ipv4StaticRoutingLookupTestCase::DoRun (void)
+{
+  CreateNode ();
+  Ptr<Ipv4StaticRouting> routing = CreateObject<Ipv4StaticRouting> ();
+  routing->SetIpv4 (m_ipv4);
+
+  for (uint32_t step = 0; step < 300; step++)
+    {
+      if (routing->GetNRoutes () > 4 && m_rng->GetInteger (0, 3) == 0)
+        {
+          routing->RemoveRoute (m_rng->GetInteger (0, routing->GetNRoutes () - 1));
+        }
+      else
+        {
+          Ipv4Mask mask;
+          Ipv4Address network = RandomIpv4Network (mask);
+          routing->AddNetworkRouteTo (network, mask, Ipv4Address (0x0b000000 + m_gateways++),
+                                      m_rng->GetInteger (1, 3), m_rng->GetInteger (0, 2));
+        }
+
+      for (uint32_t lookup = 0; lookup < 10; lookup++)
+        {
+          Ipv4Address dest = RandomIpv4Destination ();
+          Ptr<NetDevice> oif = RandomOif ();
+
+          // The scan of the route list, as done before the index
+          bool found = false;
+          Ipv4RoutingTableEntry expected;
+          uint16_t longestMask = 0;
+          uint32_t shortestMetric = 0xffffffff;
+          for (uint32_t i = 0; i < routing->GetNRoutes (); i++)
+            {
+              Ipv4RoutingTableEntry route = routing->GetRoute (i);
+              uint32_t metric = routing->GetMetric (i);
+              uint16_t maskLen = route.GetDestNetworkMask ().GetPrefixLength ();
+              if (!route.GetDestNetworkMask ().IsMatch (dest, route.GetDestNetwork ())
+                  || (oif != 0 && oif != m_ipv4->GetNetDevice (route.GetInterface ()))
+                  || maskLen < longestMask)
+                {
+                  continue;
+                }
+              if (maskLen > longestMask)
+                {
+                  shortestMetric = 0xffffffff;
+                }
+              longestMask = maskLen;
+              if (metric > shortestMetric)
+                {
+                  continue;
+                }
+              shortestMetric = metric;
+              expected = route;
+              found = true;
+              if (maskLen == 32)
+                {
+                  break;
+                }
+            }
+
+          Ipv4Header header;
+          header.SetDestination (dest);
+          Socket::SocketErrno err;
+          Ptr<Ipv4Route> route = routing->RouteOutput (Create<Packet> (), header, oif, err);
+          NS_TEST_ASSERT_MSG_EQ ((route != 0), found, "Route to " << dest << " found by only one lookup");
+          if (route != 0 && found)
+            {
+              NS_TEST_ASSERT_MSG_EQ (route->GetGateway (), expected.GetGateway (), "Wrong route to " << dest);
+              NS_TEST_ASSERT_MSG_EQ (route->GetOutputDevice (), m_ipv4->GetNetDevice (expected.GetInterface ()),
+                                     "Wrong device to " << dest);
+            }
+        }
+    }
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Check Ipv4GlobalRouting lookups against a scan of its routes
+ */
+class Ipv4GlobalRoutingLookupTestCase : public PrefixTrieTestCase
+{
+public:
+  Ipv4GlobalRoutingLookupTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+Ipv4GlobalRoutingLookupTestCase::Ipv4GlobalRoutingLookupTestCase ()
+  : PrefixTrieTestCase ("Ipv4GlobalRouting lookup")
+{
+}
+
+void
+Ipv4GlobalRoutingLookupTestCase::DoRun (void)
+{
+  CreateNode ();
+  Ptr<Ipv4GlobalRouting> routing = CreateObject<Ipv4GlobalRouting> ();
+  routing->SetIpv4 (m_ipv4);
+  uint32_t nHosts = 0;
+  uint32_t nNetworks = 0;
+  uint32_t nExternals = 0;
+
+  for (uint32_t step = 0; step < 300; step++)
+    {
+      uint32_t op = m_rng->GetInteger (0, 7);
+      Ipv4Address gateway (0x0b000000 + m_gateways++);
+      uint32_t interface = m_rng->GetInteger (1, 3);
+      Ipv4Mask mask;
+      Ipv4Address network = RandomIpv4Network (mask);
+      if (routing->GetNRoutes () > 4 && op < 2)
+        {
+          uint32_t index = m_rng->GetInteger (0, routing->GetNRoutes () - 1);
+          routing->RemoveRoute (index);
+          if (index < nHosts)
+            {
+              nHosts--;
+            }
+          else if (index < nHosts + nNetworks)
+            {
+              nNetworks--;
+            }
+          else
+            {
+              nExternals--;
+            }
+        }
+      else if (op < 3)
+        {
+          routing->AddHostRouteTo (RandomIpv4Destination (), gateway, interface);
+          nHosts++;
+        }
+      else if (op < 6)
+        {
+          routing->AddNetworkRouteTo (network, mask, gateway, interface);
+          nNetworks++;
+        }
+      else
+        {
+          routing->AddASExternalRouteTo (network, mask, gateway, interface);
+          nExternals++;
+        }
+
+      for (uint32_t lookup = 0; lookup < 10; lookup++)
+        {
+          Ipv4Address dest = RandomIpv4Destination ();
+          Ptr<NetDevice> oif = RandomOif ();
+
+          // The scan of the route lists, as done before the index: the
+          // first route of the first list with a match
+          Ipv4RoutingTableEntry *expected = 0;
+          for (uint32_t i = 0; i < routing->GetNRoutes () && expected == 0; i++)
+            {
+              Ipv4RoutingTableEntry *route = routing->GetRoute (i);
+              bool match = i < nHosts ? route->GetDest () == dest
+                : route->GetDestNetworkMask ().IsMatch (dest, route->GetDestNetwork ());
+              if (match && (oif == 0 || oif == m_ipv4->GetNetDevice (route->GetInterface ())))
+                {
+                  expected = route;
+                }
+            }
+
+          Ipv4Header header;
+          header.SetDestination (dest);
+          Socket::SocketErrno err;
+          Ptr<Ipv4Route> route = routing->RouteOutput (Create<Packet> (), header, oif, err);
+          NS_TEST_ASSERT_MSG_EQ ((route != 0), (expected != 0), "Route to " << dest << " found by only one lookup");
+          if (route != 0 && expected != 0)
+            {
+              NS_TEST_ASSERT_MSG_EQ (route->GetGateway (), expected->GetGateway (), "Wrong route to " << dest);
+            }
+        }
+    }
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Check Ipv6StaticRouting lookups against a scan of its routes
+ */
+class Ipv6StaticRoutingLookupTestCase : public PrefixTrieTestCase
+{
+public:
+  Ipv6StaticRoutingLookupTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+Ipv6StaticRoutingLookupTestCase::Ipv6StaticRoutingLookupTestCase ()
+  : PrefixTrieTestCase ("Ipv6StaticRouting lookup")
+{
+}
+
+void
+Ipv6StaticRoutingLookupTestCase::DoRun (void)
+{
+  CreateNode ();
+  Ptr<Ipv6StaticRouting> routing = CreateObject<Ipv6StaticRouting> ();
+  routing->SetIpv6 (m_ipv6);
+
+  for (uint32_t step = 0; step < 300; step++)
+    {
+      if (routing->GetNRoutes () > 4 && m_rng->GetInteger (0, 3) == 0)
+        {
+          routing->RemoveRoute (m_rng->GetInteger (0, routing->GetNRoutes () - 1));
+        }
+      else
+        {
+          Ipv6Prefix prefix;
+          Ipv6Address network = RandomIpv6Network (prefix);
+          uint8_t buf[16] = { 0x20, 0x01, 0x0d, 0xb9 };
+          buf[12] = m_gateways >> 24;
+          buf[13] = m_gateways >> 16;
+          buf[14] = m_gateways >> 8;
+          buf[15] = m_gateways++;
+          routing->AddNetworkRouteTo (network, prefix, Ipv6Address (buf),
+                                      m_rng->GetInteger (1, 3), m_rng->GetInteger (0, 2));
+        }
+
+      for (uint32_t lookup = 0; lookup < 10; lookup++)
+        {
+          Ipv6Address dest = RandomIpv6Destination ();
+          Ptr<NetDevice> oif = RandomOif ();
+
+          // The scan of the route list, as done before the index
+          bool found = false;
+          Ipv6RoutingTableEntry expected;
+          uint16_t longestMask = 0;
+          uint32_t shortestMetric = 0xffffffff;
+          for (uint32_t i = 0; i < routing->GetNRoutes (); i++)
+            {
+              Ipv6RoutingTableEntry route = routing->GetRoute (i);
+              uint32_t metric = routing->GetMetric (i);
+              uint16_t maskLen = route.GetDestNetworkPrefix ().GetPrefixLength ();
+              if (!route.GetDestNetworkPrefix ().IsMatch (dest, route.GetDestNetwork ())
+                  || (oif != 0 && oif != m_ipv6->GetNetDevice (route.GetInterface ()))
+                  || maskLen < longestMask)
+                {
+                  continue;
+                }
+              if (maskLen > longestMask)
+                {
+                  shortestMetric = 0xffffffff;
+                }
+              longestMask = maskLen;
+              if (metric > shortestMetric)
+                {
+                  continue;
+                }
+              shortestMetric = metric;
+              expected = route;
+              found = true;
+              if (maskLen == 128)
+                {
+                  break;
+                }
+            }
+
+          Ipv6Header header;
+          header.SetDestinationAddress (dest);
+          Socket::SocketErrno err;
+          Ptr<Ipv6Route> route = routing->RouteOutput (Create<Packet> (), header, oif, err);
+          NS_TEST_ASSERT_MSG_EQ ((route != 0), found, "Route to " << dest << " found by only one lookup");
+          if (route != 0 && found)
+            {
+              NS_TEST_ASSERT_MSG_EQ (route->GetGateway (), expected.GetGateway (), "Wrong route to " << dest);
+              NS_TEST_ASSERT_MSG_EQ (route->GetOutputDevice (), m_ipv6->GetNetDevice (expected.GetInterface ()),
+                                     "Wrong device to " << dest);
+            }
+        }
+    }
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Measure the lookup time in large routing tables
+ *
+ * The tables hold a default route and /24 routes to random networks, as
+ * the global routing of a large topology would; the destinations are
+ * random hosts of these networks.
+ */
+class PrefixTrieTimeTestCase : public PrefixTrieTestCase
+{
+public:
+  /**
+   * \brief Constructor
+   * \param routes number of routes
+   */
+  PrefixTrieTimeTestCase (uint32_t routes);
+
+private:
+  virtual void DoRun (void);
+  uint32_t m_routes; //!< Number of routes
+};
+
+PrefixTrieTimeTestCase::PrefixTrieTimeTestCase (uint32_t routes)
+  : PrefixTrieTestCase ("Routing lookup time"),
+    m_routes (routes)
+{
+}
+
+void
+PrefixTrieTimeTestCase::DoRun (void)
+{
+  const uint32_t lookups = 100000;
+  CreateNode ();
+  Ptr<Ipv4StaticRouting> staticRouting = CreateObject<Ipv4StaticRouting> ();
+  staticRouting->SetIpv4 (m_ipv4);
+  Ptr<Ipv4GlobalRouting> globalRouting = CreateObject<Ipv4GlobalRouting> ();
+  globalRouting->SetIpv4 (m_ipv4);
+
+  std::vector<Ipv4Address> networks;
+  staticRouting->SetDefaultRoute (Ipv4Address ("192.168.0.2"), 1);
+  for (uint32_t i = 0; i < m_routes; i++)
+    {
+      Ipv4Address network ((m_rng->GetInteger (1, 223) << 24) | (m_rng->GetInteger (0, 255) << 16)
+                           | (m_rng->GetInteger (0, 255) << 8));
+      networks.push_back (network);
+      staticRouting->AddNetworkRouteTo (network, Ipv4Mask ("255.255.255.0"), Ipv4Address ("192.168.0.2"), 1);
+      globalRouting->AddNetworkRouteTo (network, Ipv4Mask ("255.255.255.0"), Ipv4Address ("192.168.0.2"), 1);
+    }
+
+  std::vector<Ipv4Header> headers (lookups);
+  for (uint32_t i = 0; i < lookups; i++)
+    {
+      Ipv4Address network = networks[m_rng->GetInteger (0, m_routes - 1)];
+      headers[i].SetDestination (Ipv4Address (network.Get () | m_rng->GetInteger (1, 254)));
+    }
+
+  Ptr<Packet> packet = Create<Packet> ();
+  Socket::SocketErrno err;
+  uint32_t found = 0;
+  int start = clock ();
+  for (uint32_t i = 0; i < lookups; i++)
+    {
+      found += (staticRouting->RouteOutput (packet, headers[i], 0, err) != 0);
+    }
+  int middle = clock ();
+  for (uint32_t i = 0; i < lookups; i++)
+    {
+      found += (globalRouting->RouteOutput (packet, headers[i], 0, err) != 0);
+    }
+  int stop = clock ();
+
+  NS_TEST_ASSERT_MSG_EQ (found, 2 * lookups, "Every destination has a route");
+
+  std::cout << m_routes << " routes: Ipv4StaticRouting "
+            << 1E9 * double (middle - start) / (double (lookups) * double (CLOCKS_PER_SEC))
+            << " nanosec/lookup, Ipv4GlobalRouting "
+            << 1E9 * double (stop - middle) / (double (lookups) * double (CLOCKS_PER_SEC))
+            << " nanosec/lookup" << std::endl;
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief the TestSuite for the prefix index of the routing protocols
+ */
+class PrefixTrieTestSuite : public TestSuite
+{
+public:
+  PrefixTrieTestSuite ()
+    : TestSuite ("prefix-trie", UNIT)
+  {
+    AddTestCase (new Ipv4StaticRoutingLookupTestCase, TestCase::QUICK);
+    AddTestCase (new Ipv4GlobalRoutingLookupTestCase, TestCase::QUICK);
+    AddTestCase (new Ipv6StaticRoutingLookupTestCase, TestCase::QUICK);
+  }
+};
+
+static PrefixTrieTestSuite g_prefixTrieTestSuite; //!< Static variable for test initialization
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief the TestSuite for the routing lookup performance
+ */
+class PrefixTriePerfTestSuite : public TestSuite
+{
+public:
+  PrefixTriePerfTestSuite ()
+    : TestSuite ("prefix-trie-perf", PERFORMANCE)
+  {
+    AddTestCase (new PrefixTrieTimeTestCase (100), TestCase::QUICK);
+    AddTestCase (new PrefixTrieTimeTestCase (1000), TestCase::QUICK);
+    AddTestCase (new PrefixTrieTimeTestCase (10000), TestCase::QUICK);
+  }
+};
+
+static PrefixTriePerfTestSuite g_prefixTriePerfTestSuite; //!< Static variable for test initialization
@@ -0,0 +1,177 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017 NITK Surathkal
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Vivek Jain <jain.vivek.anand@gmail.com>
+ *          Sourabh Jain <sourabhjain560@outlook.com>
+ *          Mohit P. Tahiliani <tahiliani@nitk.edu.in>
+ */
+#include "ns3/test.h"
+#include "ns3/log.h"
+#include "ns3/tcp-bw-estimator.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("TcpBwEstimatorTestSuite");
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Check the filters of the bandwidth estimator on caller-timed samples
+ */
+class TcpBwEstimatorFilterTest : public TestCase
+{
+public:
+  TcpBwEstimatorFilterTest ();
+
+private:
+  virtual void DoRun (void);
+};
+
+TcpBwEstimatorFilterTest::TcpBwEstimatorFilterTest ()
+  : TestCase ("Bandwidth estimator filters")
+{
+}
+
+void
+TcpBwEstimatorFilterTest::DoRun ()
+{
+  const int64_t rtt = 100000000; // 100 ms
+
+  Ptr<TcpBwEstimator> est = CreateObject<TcpBwEstimator> ();
+  est->SetFilterType (TcpBwEstimator::NONE);
+  est->AddAckedBytes (1000);
+  est->Sample (rtt, rtt);
+  NS_TEST_ASSERT_MSG_EQ_TOL (est->GetBandwidth (), 10000, 1e-6, "Unfiltered sample is wrong");
+  est->Sample (2 * rtt, rtt);
+  NS_TEST_ASSERT_MSG_EQ_TOL (est->GetBandwidth (), 0, 1e-6, "Accounted bytes have not been cleared");
+
+  est = CreateObject<TcpBwEstimator> ();
+  est->SetFilterType (TcpBwEstimator::TUSTIN);
+  est->AddAckedBytes (1000);
+  est->Sample (rtt, rtt);
+  NS_TEST_ASSERT_MSG_EQ_TOL (est->GetBandwidth (), 500, 1e-6, "First Tustin estimate is wrong");
+  est->AddAckedBytes (1000);
+  est->Sample (2 * rtt, rtt);
+  NS_TEST_ASSERT_MSG_EQ_TOL (est->GetBandwidth (), 1450, 1e-6, "Second Tustin estimate is wrong");
+
+  est = CreateObject<TcpBwEstimator> ();
+  est->SetFilterType (TcpBwEstimator::MAX);
+  est->AddAckedBytes (1000);
+  est->Sample (rtt, rtt);
+  NS_TEST_ASSERT_MSG_EQ_TOL (est->GetBandwidth (), 10000, 1e-6, "First max estimate is wrong");
+  est->AddAckedBytes (500);
+  est->Sample (2 * rtt, rtt);
+  NS_TEST_ASSERT_MSG_EQ_TOL (est->GetBandwidth (), 10000, 1e-6, "The max should be kept within the window");
+  est->AddAckedBytes (200);
+  est->Sample (3 * rtt, rtt);
+  NS_TEST_ASSERT_MSG_EQ_TOL (est->GetBandwidth (), 5000, 1e-6, "The max should expire after the window");
+
+  est->Reset ();
+  NS_TEST_ASSERT_MSG_EQ_TOL (est->GetBandwidth (), 0, 1e-6, "Reset should clear the estimate");
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Check that the per-ACK TSW estimate matches the TCP Jersey formula
+ */
+class TcpBwEstimatorTswTest : public TestCase
+{
+public:
+  /**
+   * \brief Constructor
+   * \param window TSW window, in RTTs
+   * \param name Name of the test
+   */
+  TcpBwEstimatorTswTest (uint32_t window, const std::string &name);
+
+private:
+  virtual void DoRun (void);
+  uint32_t m_window; //!< TSW window
+};
+
+TcpBwEstimatorTswTest::TcpBwEstimatorTswTest (uint32_t window, const std::string &name)
+  : TestCase (name),
+    m_window (window)
+{
+}
+
+void
+TcpBwEstimatorTswTest::DoRun ()
+{
+  const int64_t rtt = 50000000; // 50 ms
+  const int64_t ackGap = 1000000; // 1 ms
+  const uint32_t segmentSize = 1446;
+
+  Ptr<TcpBwEstimator> est = CreateObject<TcpBwEstimator> ();
+  est->SetFilterType (TcpBwEstimator::TSW);
+  est->SetWindow (m_window);
+
+  // Reference computation of the TCP Jersey model, in seconds
+  double bw = 0;
+  int64_t prevAck = 0;
+  int64_t tLast = 0;
+  uint32_t acked = 0;
+  uint32_t nSamples = 0;
+
+  for (int64_t now = ackGap; now <= 20 * rtt; now += ackGap)
+    {
+      uint32_t segments = 1 + (now / ackGap) % 2;
+      acked += segments;
+
+      double tw = m_window * rtt / 1e9;
+      double delta = (now - prevAck) / 1e9;
+      prevAck = now;
+      bool sampled = false;
+      if (now - tLast >= rtt)
+        {
+          bw = (tw * bw + acked * segmentSize) / (delta + tw);
+          tLast = now;
+          acked = 0;
+          sampled = true;
+          ++nSamples;
+        }
+
+      NS_TEST_ASSERT_MSG_EQ (est->AckReceived (now, rtt, segments * segmentSize), sampled,
+                             "Sample taken at the wrong time");
+      NS_TEST_ASSERT_MSG_EQ_TOL (est->GetBandwidth (), bw, bw * 1e-9,
+                                 "TSW estimate differs from the reference");
+    }
+
+  NS_TEST_ASSERT_MSG_EQ (nSamples, 20, "There should be one sample per RTT");
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief TCP bandwidth estimator TestSuite
+ */
+class TcpBwEstimatorTestSuite : public TestSuite
+{
+public:
+  TcpBwEstimatorTestSuite () : TestSuite ("tcp-bw-estimator", UNIT)
+  {
+    AddTestCase (new TcpBwEstimatorFilterTest (), TestCase::QUICK);
+    AddTestCase (new TcpBwEstimatorTswTest (1, "TSW with a one RTT window"), TestCase::QUICK);
+    AddTestCase (new TcpBwEstimatorTswTest (4, "TSW with a four RTT window"), TestCase::QUICK);
+  }
+};
+
+static TcpBwEstimatorTestSuite g_tcpBwEstimatorTest; //!< static var for test initialization
@@ -22,6 +22,8 @@
 #include "tcp-general-test.h"
 #include "ns3/node.h"
 #include "ns3/log.h"
+#include "ns3/error-model.h"
+#include "ns3/ipv4-header.h"
 #include "tcp-error-model.h"
 
 namespace ns3 {
@@ -134,6 +136,294 @@ TcpECNTest::Tx (const Ptr<const Packet> p, const TcpHeader &h, SocketWho who)
     }
 }
 
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Error model marking one data segment with CE, and optionally
+ * dropping another one
+ */
+class TcpECNMarkErrorModel : public ErrorModel
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  TcpECNMarkErrorModel ();
+
+  /**
+   * \brief Set the segments to mark and to drop, once each
+   *
+   * \param mark sequence number of the segment to mark
+   * \param drop sequence number of the segment to drop; 0 for none
+   */
+  void SetSegments (SequenceNumber32 mark, SequenceNumber32 drop);
+
+private:
+  virtual bool DoCorrupt (Ptr<Packet> p);
+  virtual void DoReset (void);
+
+  SequenceNumber32 m_mark; //!< Segment to mark
+  SequenceNumber32 m_drop; //!< Segment to drop
+  bool m_marked;           //!< The segment has been marked
+  bool m_dropped;          //!< The segment has been dropped
+};
+
+NS_OBJECT_ENSURE_REGISTERED (TcpECNMarkErrorModel);
+
+TypeId
+TcpECNMarkErrorModel::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::TcpECNMarkErrorModel")
+    .SetParent<ErrorModel> ()
+    .AddConstructor<TcpECNMarkErrorModel> ()
+  ;
+  return tid;
+}
+
+TcpECNMarkErrorModel::TcpECNMarkErrorModel ()
+  : m_marked (false),
+    m_dropped (false)
+{
+}
+
+void
+TcpECNMarkErrorModel::SetSegments (SequenceNumber32 mark, SequenceNumber32 drop)
+{
+  m_mark = mark;
+  m_drop = drop;
+}
+
+bool
+TcpECNMarkErrorModel::DoCorrupt (Ptr<Packet> p)
+{
+  Ipv4Header ipHeader;
+  TcpHeader tcpHeader;
+  p->RemoveHeader (ipHeader);
+  p->RemoveHeader (tcpHeader);
+
+  bool drop = false;
+  if (p->GetSize () > 0 && tcpHeader.GetSequenceNumber () == m_mark && !m_marked)
+    {
+      ipHeader.SetEcn (Ipv4Header::ECN_CE);
+      m_marked = true;
+    }
+  else if (p->GetSize () > 0 && tcpHeader.GetSequenceNumber () == m_drop && !m_dropped)
+    {
+      drop = true;
+      m_dropped = true;
+    }
+
+  p->AddHeader (tcpHeader);
+  p->AddHeader (ipHeader);
+  return drop;
+}
+
+void
+TcpECNMarkErrorModel::DoReset (void)
+{
+  m_marked = false;
+  m_dropped = false;
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Check the ECN state transitions after a CE mark
+ *
+ * A data segment is marked with CE early in the connection.  Depending on
+ * the test case:
+ *
+ * - RECEIVER_CWR: the receiver stops setting ECE once it receives CWR
+ * - STALE_ECE: the sender does not go back to ECN_ECE_RCVD on the ECN
+ *   Echoes of the data sent before its CWR
+ * - CWR_EXIT: the sender leaves CA_CWR on the ACK of the CWR segment
+ * - CWR_DUPACK: a segment sent before the CWR is lost, and the dup ACKs
+ *   move the sender from CA_CWR to CA_DISORDER, and then to recovery
+ */
+class TcpECNStateTest : public TcpGeneralTest
+{
+public:
+  /** \brief The transition checked */
+  enum TestCase
+  {
+    RECEIVER_CWR,
+    STALE_ECE,
+    CWR_EXIT,
+    CWR_DUPACK
+  };
+
+  /**
+   * \brief Constructor
+   *
+   * \param testCase the transition checked
+   * \param desc Description of the test
+   */
+  TcpECNStateTest (TestCase testCase, const std::string &desc);
+
+protected:
+  virtual void ConfigureEnvironment (void);
+  virtual void ConfigureProperties (void);
+  virtual Ptr<ErrorModel> CreateReceiverErrorModel (void);
+  virtual void Rx (const Ptr<const Packet> p, const TcpHeader&h, SocketWho who);
+  virtual void Tx (const Ptr<const Packet> p, const TcpHeader&h, SocketWho who);
+  virtual void CongStateTrace (const TcpSocketState::TcpCongState_t oldValue,
+                               const TcpSocketState::TcpCongState_t newValue);
+  virtual void FinalChecks (void);
+
+private:
+  /**
+   * \brief Trace the ECN state of the sender
+   * \param oldValue old value
+   * \param newValue new value
+   */
+  void EcnStateTrace (const TcpSocketState::EcnState_t oldValue,
+                      const TcpSocketState::EcnState_t newValue);
+
+  TestCase m_testCase;          //!< The transition checked
+  bool m_cwrReceived;           //!< The receiver has received CWR
+  uint32_t m_eceAfterCwr;       //!< ECE sent by the receiver after CWR
+  uint32_t m_eceSent;           //!< ECE sent by the receiver
+  uint32_t m_cwrSent;           //!< Segments with CWR sent by the sender
+  SequenceNumber32 m_cwrSeq;    //!< Sequence number of the CWR segment
+  SequenceNumber32 m_lastAck;   //!< Last ACK received by the sender
+  uint32_t m_staleEce;          //!< ECN_CWR_SENT -> ECN_ECE_RCVD transitions
+  uint32_t m_cwrExits;          //!< CA_CWR -> CA_OPEN transitions
+  uint32_t m_cwrDisorders;      //!< CA_CWR -> CA_DISORDER transitions
+  uint32_t m_recoveries;        //!< Transitions to CA_RECOVERY
+};
+
+TcpECNStateTest::TcpECNStateTest (TestCase testCase, const std::string &desc)
+  : TcpGeneralTest (desc),
+    m_testCase (testCase),
+    m_cwrReceived (false),
+    m_eceAfterCwr (0),
+    m_eceSent (0),
+    m_cwrSent (0),
+    m_staleEce (0),
+    m_cwrExits (0),
+    m_cwrDisorders (0),
+    m_recoveries (0)
+{
+}
+
+void
+TcpECNStateTest::ConfigureEnvironment (void)
+{
+  TcpGeneralTest::ConfigureEnvironment ();
+  SetPropagationDelay (MilliSeconds (50));
+  SetAppPktCount (100);
+  SetAppPktInterval (MicroSeconds (100));
+}
+
+void
+TcpECNStateTest::ConfigureProperties (void)
+{
+  TcpGeneralTest::ConfigureProperties ();
+  SetECN (SENDER);
+  SetECN (RECEIVER);
+  SetInitialCwnd (SENDER, 10);
+  GetSenderSocket ()->TraceConnectWithoutContext ("ECNState",
+                                                  MakeCallback (&TcpECNStateTest::EcnStateTrace, this));
+}
+
+Ptr<ErrorModel>
+TcpECNStateTest::CreateReceiverErrorModel (void)
+{
+  Ptr<TcpECNMarkErrorModel> errorModel = CreateObject<TcpECNMarkErrorModel> ();
+  // The segment dropped is sent with the marked one, before the CWR
+  errorModel->SetSegments (SequenceNumber32 (1 + 5 * 500),
+                           SequenceNumber32 (m_testCase == CWR_DUPACK ? 1 + 8 * 500 : 0));
+  return errorModel;
+}
+
+void
+TcpECNStateTest::Rx (const Ptr<const Packet> p, const TcpHeader &h, SocketWho who)
+{
+  if (who == RECEIVER && (h.GetFlags () & TcpHeader::CWR) && p->GetSize () > 0)
+    {
+      m_cwrReceived = true;
+    }
+  else if (who == SENDER)
+    {
+      m_lastAck = h.GetAckNumber ();
+    }
+}
+
+void
+TcpECNStateTest::Tx (const Ptr<const Packet> p, const TcpHeader &h, SocketWho who)
+{
+  if (who == RECEIVER && (h.GetFlags () & TcpHeader::ECE) && !(h.GetFlags () & TcpHeader::SYN))
+    {
+      m_eceSent++;
+      if (m_cwrReceived)
+        {
+          m_eceAfterCwr++;
+        }
+    }
+  else if (who == SENDER && (h.GetFlags () & TcpHeader::CWR) && p->GetSize () > 0)
+    {
+      m_cwrSent++;
+      m_cwrSeq = h.GetSequenceNumber ();
+    }
+}
+
+void
+TcpECNStateTest::EcnStateTrace (const TcpSocketState::EcnState_t oldValue,
+                                const TcpSocketState::EcnState_t newValue)
+{
+  if (oldValue == TcpSocketState::ECN_CWR_SENT && newValue == TcpSocketState::ECN_ECE_RCVD)
+    {
+      m_staleEce++;
+    }
+}
+
+void
+TcpECNStateTest::CongStateTrace (const TcpSocketState::TcpCongState_t oldValue,
+                                 const TcpSocketState::TcpCongState_t newValue)
+{
+  if (oldValue == TcpSocketState::CA_CWR && newValue == TcpSocketState::CA_OPEN)
+    {
+      m_cwrExits++;
+      NS_TEST_ASSERT_MSG_GT (m_lastAck, m_cwrSeq, "CA_CWR left before the ACK of the CWR segment");
+    }
+  else if (oldValue == TcpSocketState::CA_CWR && newValue == TcpSocketState::CA_DISORDER)
+    {
+      m_cwrDisorders++;
+    }
+  else if (newValue == TcpSocketState::CA_RECOVERY)
+    {
+      m_recoveries++;
+    }
+}
+
+void
+TcpECNStateTest::FinalChecks (void)
+{
+  NS_TEST_ASSERT_MSG_GT (m_eceSent, 0, "The CE mark was not echoed");
+  NS_TEST_ASSERT_MSG_EQ (m_cwrSent, 1, "The window should be reduced once");
+  switch (m_testCase)
+    {
+    case RECEIVER_CWR:
+      NS_TEST_ASSERT_MSG_EQ (m_cwrReceived, true, "The receiver did not receive CWR");
+      NS_TEST_ASSERT_MSG_EQ (m_eceAfterCwr, 0, "The receiver kept sending ECE after CWR");
+      break;
+    case STALE_ECE:
+      NS_TEST_ASSERT_MSG_EQ (m_staleEce, 0, "The sender went back to ECN_ECE_RCVD on a stale ECE");
+      break;
+    case CWR_EXIT:
+      NS_TEST_ASSERT_MSG_EQ (m_cwrExits, 1, "The sender should leave CA_CWR once");
+      break;
+    case CWR_DUPACK:
+      NS_TEST_ASSERT_MSG_EQ (m_cwrDisorders, 1, "The dup ACKs should move the sender to CA_DISORDER");
+      NS_TEST_ASSERT_MSG_EQ (m_recoveries, 1, "The loss should cause one recovery");
+      break;
+    }
+}
+
 //-----------------------------------------------------------------------------
 
 static class TcpECNTestSuite : public TestSuite
@@ -149,6 +439,18 @@ public:
                  TestCase::QUICK);
     AddTestCase (new TcpECNTest (4, "ECN capable sender and ECN capable receiver"),
                  TestCase::QUICK);
+    AddTestCase (new TcpECNStateTest (TcpECNStateTest::RECEIVER_CWR,
+                                      "ECN receiver stops sending ECE on CWR"),
+                 TestCase::QUICK);
+    AddTestCase (new TcpECNStateTest (TcpECNStateTest::STALE_ECE,
+                                      "ECN sender ignores the ECE of data sent before CWR"),
+                 TestCase::QUICK);
+    AddTestCase (new TcpECNStateTest (TcpECNStateTest::CWR_EXIT,
+                                      "ECN sender leaves CA_CWR on the ACK of the CWR segment"),
+                 TestCase::QUICK);
+    AddTestCase (new TcpECNStateTest (TcpECNStateTest::CWR_DUPACK,
+                                      "ECN sender in CA_CWR enters fast recovery on dup ACKs"),
+                 TestCase::QUICK);
   }
 } g_tcpECNTestSuite;
 
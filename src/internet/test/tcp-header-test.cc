@@ -24,6 +24,10 @@
 #include "ns3/tcp-header.h"
 #include "ns3/buffer.h"
 #include "ns3/tcp-option-rfc793.h"
+#include "ns3/tcp-option-ts.h"
+#include "ns3/tcp-option-winscale.h"
+#include "ns3/tcp-option-sack-permitted.h"
+#include "ns3/tcp-option-sack.h"
 
 using namespace ns3;
 
@@ -351,6 +355,221 @@ TcpHeaderWithRFC793OptionTestCase::DoTeardown ()
 
 }
 
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief TCP header timestamp held as values test.
+ */
+class TcpHeaderTimestampTestCase : public TestCase
+{
+public:
+  /**
+   * Constructor.
+   * \param name Test description.
+   */
+  TcpHeaderTimestampTestCase (std::string name);
+
+private:
+  virtual void DoRun (void);
+};
+
+TcpHeaderTimestampTestCase::TcpHeaderTimestampTestCase (std::string name)
+  : TestCase (name)
+{
+}
+
+void
+TcpHeaderTimestampTestCase::DoRun (void)
+{
+  // The same header, with a timestamp held as values or as a TcpOptionTS
+  TcpHeader values, object;
+  NS_TEST_ASSERT_MSG_EQ (values.AppendTimestamp (0x01020304, 0x05060708), true,
+                         "Timestamp not appended");
+  Ptr<TcpOptionTS> ts = CreateObject<TcpOptionTS> ();
+  ts->SetTimestamp (0x01020304);
+  ts->SetEcho (0x05060708);
+  object.AppendOption (ts);
+  NS_TEST_ASSERT_MSG_EQ (values.HasOption (TcpOption::TS), true, "No timestamp");
+  NS_TEST_ASSERT_MSG_EQ (values.GetLength (), object.GetLength (), "Different lengths");
+  NS_TEST_ASSERT_MSG_EQ (values.GetOptionLength (), object.GetOptionLength (),
+                         "Different option lengths");
+
+  Buffer valuesBuffer, objectBuffer;
+  valuesBuffer.AddAtStart (values.GetSerializedSize ());
+  values.Serialize (valuesBuffer.Begin ());
+  objectBuffer.AddAtStart (object.GetSerializedSize ());
+  object.Serialize (objectBuffer.Begin ());
+  NS_TEST_ASSERT_MSG_EQ (valuesBuffer.GetSize (), objectBuffer.GetSize (), "Different sizes");
+  NS_TEST_ASSERT_MSG_EQ (memcmp (valuesBuffer.PeekData (), objectBuffer.PeekData (), valuesBuffer.GetSize ()),
+                         0, "Different serializations");
+
+  // Deserialize it as values
+  TcpHeader dest;
+  uint32_t size = dest.Deserialize (objectBuffer.Begin ());
+  NS_TEST_ASSERT_MSG_EQ (size, objectBuffer.GetSize (), "Wrong deserialized size");
+  NS_TEST_ASSERT_MSG_EQ (dest.GetLength (), object.GetLength (), "Wrong deserialized length");
+  uint32_t timestamp = 0;
+  uint32_t echo = 0;
+  NS_TEST_ASSERT_MSG_EQ (dest.GetTimestamp (timestamp, echo), true, "Timestamp not deserialized");
+  NS_TEST_ASSERT_MSG_EQ (timestamp, 0x01020304, "Wrong timestamp");
+  NS_TEST_ASSERT_MSG_EQ (echo, 0x05060708, "Wrong echo");
+
+  // The option objects are still available
+  Ptr<const TcpOptionTS> option = DynamicCast<const TcpOptionTS> (dest.GetOption (TcpOption::TS));
+  NS_TEST_ASSERT_MSG_NE (option, 0, "No TcpOptionTS");
+  NS_TEST_ASSERT_MSG_EQ (option->GetTimestamp (), 0x01020304, "Wrong TcpOptionTS timestamp");
+  NS_TEST_ASSERT_MSG_EQ (option->GetEcho (), 0x05060708, "Wrong TcpOptionTS echo");
+  uint32_t nOptions = dest.GetOptionList ().size ();
+  NS_TEST_ASSERT_MSG_EQ (nOptions, 1, "Wrong option list");
+  timestamp = echo = 0;
+  NS_TEST_ASSERT_MSG_EQ (dest.GetTimestamp (timestamp, echo), true, "Timestamp lost");
+  NS_TEST_ASSERT_MSG_EQ (timestamp, 0x01020304, "Wrong timestamp after GetOption");
+
+  // The options appended after the timestamp follow it
+  Ptr<TcpOptionWinScale> ws = CreateObject<TcpOptionWinScale> ();
+  ws->SetScale (7);
+  values.AppendOption (ws);
+  object.AppendOption (ws);
+  valuesBuffer = Buffer ();
+  valuesBuffer.AddAtStart (values.GetSerializedSize ());
+  values.Serialize (valuesBuffer.Begin ());
+  objectBuffer = Buffer ();
+  objectBuffer.AddAtStart (object.GetSerializedSize ());
+  object.Serialize (objectBuffer.Begin ());
+  NS_TEST_ASSERT_MSG_EQ (valuesBuffer.GetSize (), objectBuffer.GetSize (), "Different sizes");
+  NS_TEST_ASSERT_MSG_EQ (memcmp (valuesBuffer.PeekData (), objectBuffer.PeekData (), valuesBuffer.GetSize ()),
+                         0, "Different serializations with two options");
+  dest.Deserialize (objectBuffer.Begin ());
+  NS_TEST_ASSERT_MSG_EQ (dest.HasOption (TcpOption::WINSCALE), true, "No window scale");
+  NS_TEST_ASSERT_MSG_EQ (dest.GetTimestamp (timestamp, echo), true, "No timestamp");
+  nOptions = dest.GetOptionList ().size ();
+  NS_TEST_ASSERT_MSG_EQ (nOptions, 2, "Wrong option list with two options");
+  NS_TEST_ASSERT_MSG_EQ ((int) dest.GetOptionList ().front ()->GetKind (), (int) TcpOption::TS,
+                         "Timestamp not first");
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief TCP header options held as values test.
+ */
+class TcpHeaderOptionValuesTestCase : public TestCase
+{
+public:
+  /**
+   * Constructor.
+   * \param name Test description.
+   */
+  TcpHeaderOptionValuesTestCase (std::string name);
+
+private:
+  virtual void DoRun (void);
+};
+
+TcpHeaderOptionValuesTestCase::TcpHeaderOptionValuesTestCase (std::string name)
+  : TestCase (name)
+{
+}
+
+void
+TcpHeaderOptionValuesTestCase::DoRun (void)
+{
+  TcpOptionSack::SackBlock first (SequenceNumber32 (1000), SequenceNumber32 (2000));
+  TcpOptionSack::SackBlock second (SequenceNumber32 (3000), SequenceNumber32 (4000));
+
+  // The same header, with the options held as values or as TcpOption
+  TcpHeader values, object;
+  NS_TEST_ASSERT_MSG_EQ (values.AppendMss (1460), true, "MSS not appended");
+  NS_TEST_ASSERT_MSG_EQ (values.AppendWindowScale (7), true, "Window scale not appended");
+  NS_TEST_ASSERT_MSG_EQ (values.AppendSackPermitted (), true, "SACK permitted not appended");
+  NS_TEST_ASSERT_MSG_EQ (values.AppendTimestamp (0x01020304, 0x05060708), true,
+                         "Timestamp not appended");
+  NS_TEST_ASSERT_MSG_EQ (values.AppendSackBlock (first), true, "SACK not appended");
+  NS_TEST_ASSERT_MSG_EQ (values.AppendSackBlock (second), true, "SACK block not added");
+  NS_TEST_ASSERT_MSG_EQ (values.AppendSackBlock (first), false, "SACK block beyond the option space");
+
+  Ptr<TcpOptionMSS> mss = CreateObject<TcpOptionMSS> ();
+  mss->SetMSS (1460);
+  object.AppendOption (mss);
+  Ptr<TcpOptionWinScale> ws = CreateObject<TcpOptionWinScale> ();
+  ws->SetScale (7);
+  object.AppendOption (ws);
+  object.AppendOption (CreateObject<TcpOptionSackPermitted> ());
+  Ptr<TcpOptionTS> ts = CreateObject<TcpOptionTS> ();
+  ts->SetTimestamp (0x01020304);
+  ts->SetEcho (0x05060708);
+  object.AppendOption (ts);
+  Ptr<TcpOptionSack> sack = CreateObject<TcpOptionSack> ();
+  sack->AddSackBlock (first);
+  sack->AddSackBlock (second);
+  object.AppendOption (sack);
+
+  NS_TEST_ASSERT_MSG_EQ (values.GetLength (), object.GetLength (), "Different lengths");
+  NS_TEST_ASSERT_MSG_EQ (values.GetOptionLength (), object.GetOptionLength (),
+                         "Different option lengths");
+  std::ostringstream valuesString, objectString;
+  values.Print (valuesString);
+  object.Print (objectString);
+  NS_TEST_ASSERT_MSG_EQ (valuesString.str (), objectString.str (), "Different prints");
+
+  Buffer valuesBuffer, objectBuffer;
+  valuesBuffer.AddAtStart (values.GetSerializedSize ());
+  values.Serialize (valuesBuffer.Begin ());
+  objectBuffer.AddAtStart (object.GetSerializedSize ());
+  object.Serialize (objectBuffer.Begin ());
+  NS_TEST_ASSERT_MSG_EQ (valuesBuffer.GetSize (), objectBuffer.GetSize (), "Different sizes");
+  NS_TEST_ASSERT_MSG_EQ (memcmp (valuesBuffer.PeekData (), objectBuffer.PeekData (), valuesBuffer.GetSize ()),
+                         0, "Different serializations");
+
+  // Deserialize it as values
+  TcpHeader dest;
+  uint32_t size = dest.Deserialize (objectBuffer.Begin ());
+  NS_TEST_ASSERT_MSG_EQ (size, objectBuffer.GetSize (), "Wrong deserialized size");
+  uint16_t mssValue = 0;
+  NS_TEST_ASSERT_MSG_EQ (dest.GetMss (mssValue), true, "MSS not deserialized");
+  NS_TEST_ASSERT_MSG_EQ (mssValue, 1460, "Wrong MSS");
+  uint8_t scale = 0;
+  NS_TEST_ASSERT_MSG_EQ (dest.GetWindowScale (scale), true, "Window scale not deserialized");
+  NS_TEST_ASSERT_MSG_EQ ((int) scale, 7, "Wrong window scale");
+  NS_TEST_ASSERT_MSG_EQ (dest.HasOption (TcpOption::SACKPERMITTED), true,
+                         "SACK permitted not deserialized");
+  TcpOptionSack::SackList list;
+  NS_TEST_ASSERT_MSG_EQ (dest.GetSackList (list), true, "SACK not deserialized");
+  NS_TEST_ASSERT_MSG_EQ (list.size (), 2, "Wrong number of SACK blocks");
+  NS_TEST_ASSERT_MSG_EQ (list.front ().first, first.first, "Wrong first SACK block");
+  NS_TEST_ASSERT_MSG_EQ (list.back ().second, second.second, "Wrong second SACK block");
+
+  // The option objects are created in order
+  const TcpHeader::TcpOptionList &options = dest.GetOptionList ();
+  uint8_t kinds[] = { TcpOption::MSS, TcpOption::WINSCALE, TcpOption::SACKPERMITTED,
+                      TcpOption::TS, TcpOption::SACK };
+  NS_TEST_ASSERT_MSG_EQ (options.size (), 5, "Wrong option list");
+  uint32_t k = 0;
+  for (TcpHeader::TcpOptionList::const_iterator it = options.begin (); it != options.end (); ++it, ++k)
+    {
+      NS_TEST_ASSERT_MSG_EQ ((int) (*it)->GetKind (), (int) kinds[k], "Wrong option order");
+    }
+  scale = 0;
+  NS_TEST_ASSERT_MSG_EQ (dest.GetWindowScale (scale), true, "Window scale lost");
+  NS_TEST_ASSERT_MSG_EQ ((int) scale, 7, "Wrong window scale after GetOptionList");
+
+  // After another option, the options are appended as TcpOption, in order
+  TcpHeader fallback;
+  fallback.AppendOption (CreateObject<TcpOptionNOP> ());
+  NS_TEST_ASSERT_MSG_EQ (fallback.AppendTimestamp (1, 2), true, "Timestamp not appended after NOP");
+  NS_TEST_ASSERT_MSG_EQ (fallback.AppendSackBlock (first), true, "SACK not appended after NOP");
+  NS_TEST_ASSERT_MSG_EQ (fallback.AppendSackBlock (second), true, "SACK block not added after NOP");
+  list.clear ();
+  NS_TEST_ASSERT_MSG_EQ (fallback.GetSackList (list), true, "No SACK after NOP");
+  NS_TEST_ASSERT_MSG_EQ (list.size (), 2, "Wrong number of SACK blocks after NOP");
+  uint8_t optionLength = fallback.GetOptionLength ();
+  NS_TEST_ASSERT_MSG_EQ ((int) optionLength, 1 + 10 + 18, "Wrong option length after NOP");
+  NS_TEST_ASSERT_MSG_EQ ((int) fallback.GetOptionList ().back ()->GetKind (), (int) TcpOption::SACK,
+                         "SACK not last");
+}
+
 /**
  * \ingroup internet-test
  * \ingroup tests
@@ -435,6 +654,8 @@ public:
   {
     AddTestCase (new TcpHeaderGetSetTestCase ("GetSet test cases"), TestCase::QUICK);
     AddTestCase (new TcpHeaderWithRFC793OptionTestCase ("Test for options in RFC 793"), TestCase::QUICK);
+    AddTestCase (new TcpHeaderTimestampTestCase ("Test for the timestamp held as values"), TestCase::QUICK);
+    AddTestCase (new TcpHeaderOptionValuesTestCase ("Test for the options held as values"), TestCase::QUICK);
     AddTestCase (new TcpHeaderFlagsToString ("Test flags to string function"), TestCase::QUICK);
   }
 
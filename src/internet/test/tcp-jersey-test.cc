@@ -21,10 +21,13 @@
  */
 #include "ns3/test.h"
 #include "ns3/log.h"
+#include "ns3/error-model.h"
+#include "ns3/ipv4-header.h"
 #include "ns3/tcp-congestion-ops.h"
 #include "ns3/tcp-socket-base.h"
 #include "ns3/tcp-jersey.h"
 #include "ns3/string.h"
+#include "tcp-general-test.h"
 
 using namespace ns3;
 
@@ -120,6 +123,305 @@ TcpJerseyToNewReno::ExecuteTest ()
                          "cWnd has not updated correctly");
 }
 
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Jersey sets cWnd from the bandwidth estimate when entering recovery
+ */
+class TcpJerseyExplicitRetransmit : public TestCase
+{
+public:
+  /**
+   * \brief Constructor
+   *
+   * \param cWnd congestion window
+   * \param segmentSize segment size
+   * \param segmentsAcked segments acked one RTT after the start
+   * \param rtt RTT
+   * \param ecnState ECN state when the loss is detected
+   * \param name Name of the test
+   */
+  TcpJerseyExplicitRetransmit (uint32_t cWnd, uint32_t segmentSize, uint32_t segmentsAcked,
+                               Time rtt, TcpSocketState::EcnState_t ecnState,
+                               const std::string &name);
+
+private:
+  virtual void DoRun (void);
+  /** \brief Feed an ACK to the bandwidth estimator
+   */
+  void PktsAcked (void);
+  /** \brief Enter recovery and check the window
+   */
+  void ExecuteTest (void);
+
+  uint32_t m_cWnd; //!< cWnd
+  uint32_t m_segmentSize; //!< segment size
+  uint32_t m_segmentsAcked; //!< segments acked
+  Time m_rtt; //!< rtt
+  TcpSocketState::EcnState_t m_ecnState; //!< ECN state
+  Ptr<TcpSocketState> m_state; //!< state
+  Ptr<TcpJersey> m_cong; //!< congestion control
+};
+
+TcpJerseyExplicitRetransmit::TcpJerseyExplicitRetransmit (uint32_t cWnd, uint32_t segmentSize,
+                                                          uint32_t segmentsAcked, Time rtt,
+                                                          TcpSocketState::EcnState_t ecnState,
+                                                          const std::string &name)
+  : TestCase (name),
+    m_cWnd (cWnd),
+    m_segmentSize (segmentSize),
+    m_segmentsAcked (segmentsAcked),
+    m_rtt (rtt),
+    m_ecnState (ecnState)
+{
+}
+
+void
+TcpJerseyExplicitRetransmit::DoRun ()
+{
+  m_state = CreateObject <TcpSocketState> ();
+  m_state->m_cWnd = m_cWnd;
+  m_state->m_ssThresh = m_cWnd;
+  m_state->m_segmentSize = m_segmentSize;
+  m_state->m_ecnState = m_ecnState;
+
+  m_cong = CreateObject <TcpJersey> ();
+
+  Simulator::Schedule (m_rtt, &TcpJerseyExplicitRetransmit::PktsAcked, this);
+  Simulator::Schedule (m_rtt + MilliSeconds (1), &TcpJerseyExplicitRetransmit::ExecuteTest, this);
+  Simulator::Run ();
+  Simulator::Destroy ();
+}
+
+void
+TcpJerseyExplicitRetransmit::PktsAcked ()
+{
+  m_cong->PktsAcked (m_state, m_segmentsAcked, m_rtt);
+}
+
+void
+TcpJerseyExplicitRetransmit::ExecuteTest ()
+{
+  uint32_t ownd = m_cong->GetSsThresh (m_state, m_cWnd);
+  NS_TEST_ASSERT_MSG_GT (ownd, 2 * m_segmentSize, "Bandwidth has not been estimated");
+
+  m_cong->ExplicitRetransmit (m_state, m_cWnd);
+
+  NS_TEST_ASSERT_MSG_EQ (m_state->m_ssThresh.Get (), ownd,
+                         "ssThresh has not updated correctly");
+
+  if (m_ecnState == TcpSocketState::ECN_ECE_RCVD)
+    {
+      NS_TEST_ASSERT_MSG_EQ (m_state->m_cWnd.Get (), std::min (m_cWnd, ownd),
+                             "cWnd should not grow after a congestion warning");
+    }
+  else
+    {
+      NS_TEST_ASSERT_MSG_EQ (m_state->m_cWnd.Get (), ownd,
+                             "cWnd should be set to the optimum window");
+    }
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Error model setting the CE codepoint of a segment, and dropping
+ * another one
+ */
+class TcpJerseyCeErrorModel : public ErrorModel
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  TcpJerseyCeErrorModel ();
+
+  /**
+   * \brief Set the segments to mark and to drop, once each
+   *
+   * \param mark sequence number of the segment to mark
+   * \param drop sequence number of the segment to drop
+   */
+  void SetSegments (SequenceNumber32 mark, SequenceNumber32 drop);
+
+private:
+  virtual bool DoCorrupt (Ptr<Packet> p);
+  virtual void DoReset (void);
+
+  SequenceNumber32 m_mark; //!< Segment to mark
+  SequenceNumber32 m_drop; //!< Segment to drop
+  bool m_marked;           //!< The segment has been marked
+  bool m_dropped;          //!< The segment has been dropped
+};
+
+NS_OBJECT_ENSURE_REGISTERED (TcpJerseyCeErrorModel);
+
+TypeId
+TcpJerseyCeErrorModel::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::TcpJerseyCeErrorModel")
+    .SetParent<ErrorModel> ()
+    .AddConstructor<TcpJerseyCeErrorModel> ()
+  ;
+  return tid;
+}
+
+TcpJerseyCeErrorModel::TcpJerseyCeErrorModel ()
+  : m_marked (false),
+    m_dropped (false)
+{
+}
+
+void
+TcpJerseyCeErrorModel::SetSegments (SequenceNumber32 mark, SequenceNumber32 drop)
+{
+  m_mark = mark;
+  m_drop = drop;
+}
+
+bool
+TcpJerseyCeErrorModel::DoCorrupt (Ptr<Packet> p)
+{
+  Ipv4Header ipHeader;
+  TcpHeader tcpHeader;
+  p->RemoveHeader (ipHeader);
+  p->RemoveHeader (tcpHeader);
+
+  bool drop = false;
+  if (p->GetSize () > 0 && tcpHeader.GetSequenceNumber () == m_mark && !m_marked)
+    {
+      ipHeader.SetEcn (Ipv4Header::ECN_CE);
+      m_marked = true;
+    }
+  else if (p->GetSize () > 0 && tcpHeader.GetSequenceNumber () == m_drop && !m_dropped)
+    {
+      drop = true;
+      m_dropped = true;
+    }
+
+  p->AddHeader (tcpHeader);
+  p->AddHeader (ipHeader);
+  return drop;
+}
+
+void
+TcpJerseyCeErrorModel::DoReset (void)
+{
+  m_marked = false;
+  m_dropped = false;
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Jersey treats a loss long after a congestion warning as a
+ * non-congestion loss
+ *
+ * A segment is marked with CE early in the connection, and another one is
+ * lost several windows later.  Although the ECN state of the sender stays
+ * ECN_CWR_SENT, the window is set to the optimum window on recovery.
+ */
+class TcpJerseyEcnLossTest : public TcpGeneralTest
+{
+public:
+  /**
+   * \brief Constructor
+   *
+   * \param desc Description of the test
+   */
+  TcpJerseyEcnLossTest (const std::string &desc);
+
+protected:
+  virtual void ConfigureEnvironment (void);
+  virtual void ConfigureProperties (void);
+  virtual Ptr<ErrorModel> CreateReceiverErrorModel (void);
+  virtual void CongStateTrace (const TcpSocketState::TcpCongState_t oldValue,
+                               const TcpSocketState::TcpCongState_t newValue);
+  virtual void FinalChecks (void);
+
+private:
+  /** \brief Check the window once in recovery
+   */
+  void CheckRecovery (void);
+
+  uint32_t m_cWndBefore;  //!< cWnd before the recovery
+  uint32_t m_recoveries;  //!< Number of recoveries
+};
+
+TcpJerseyEcnLossTest::TcpJerseyEcnLossTest (const std::string &desc)
+  : TcpGeneralTest (desc),
+    m_cWndBefore (0),
+    m_recoveries (0)
+{
+}
+
+void
+TcpJerseyEcnLossTest::ConfigureEnvironment (void)
+{
+  TcpGeneralTest::ConfigureEnvironment ();
+  SetCongestionControl (TcpJersey::GetTypeId ());
+  SetPropagationDelay (MilliSeconds (50));
+  SetAppPktSize (500);
+  SetAppPktCount (400);
+  SetAppPktInterval (MicroSeconds (100));
+}
+
+void
+TcpJerseyEcnLossTest::ConfigureProperties (void)
+{
+  TcpGeneralTest::ConfigureProperties ();
+  SetECN (SENDER);
+  SetECN (RECEIVER);
+  SetInitialCwnd (SENDER, 10);
+}
+
+Ptr<ErrorModel>
+TcpJerseyEcnLossTest::CreateReceiverErrorModel (void)
+{
+  Ptr<TcpJerseyCeErrorModel> errorModel = CreateObject<TcpJerseyCeErrorModel> ();
+  errorModel->SetSegments (SequenceNumber32 (1 + 5 * 500), SequenceNumber32 (1 + 200 * 500));
+  return errorModel;
+}
+
+void
+TcpJerseyEcnLossTest::CongStateTrace (const TcpSocketState::TcpCongState_t oldValue,
+                                      const TcpSocketState::TcpCongState_t newValue)
+{
+  if (newValue == TcpSocketState::CA_RECOVERY)
+    {
+      // The window is set after the state change, by the same event
+      m_cWndBefore = GetTcb (SENDER)->m_cWnd;
+      m_recoveries++;
+      Simulator::ScheduleNow (&TcpJerseyEcnLossTest::CheckRecovery, this);
+    }
+}
+
+void
+TcpJerseyEcnLossTest::CheckRecovery (void)
+{
+  Ptr<TcpSocketState> tcb = GetTcb (SENDER);
+  uint32_t cWnd = tcb->m_cWnd;
+  uint32_t ownd = tcb->m_ssThresh;
+  bool answered = tcb->m_ecnState == TcpSocketState::ECN_CWR_SENT;
+  NS_TEST_ASSERT_MSG_EQ (answered, true,
+                         "The sender should have answered the congestion warning");
+  NS_TEST_ASSERT_MSG_LT (m_cWndBefore, ownd,
+                         "The test needs cWnd below the optimum window");
+  NS_TEST_ASSERT_MSG_EQ (cWnd, ownd,
+                         "cWnd should be set to the optimum window on non-congestion loss");
+}
+
+void
+TcpJerseyEcnLossTest::FinalChecks (void)
+{
+  NS_TEST_ASSERT_MSG_EQ (m_recoveries, 1, "The loss should cause one recovery");
+}
+
 /**
  * \ingroup internet-test
  * \ingroup tests
@@ -133,6 +435,11 @@ public:
   {
     AddTestCase (new TcpJerseyToNewReno (2 * 1446, 1446, 4 * 1446, 2, SequenceNumber32 (4753), SequenceNumber32 (3216), MilliSeconds (100), "Jersey falls to New Reno for slowstart"), TestCase::QUICK);
     AddTestCase (new TcpJerseyToNewReno (4 * 1446, 1446, 2 * 1446, 2, SequenceNumber32 (4753), SequenceNumber32 (3216), MilliSeconds (100), "Jersey falls to New Reno if timestamps are not found"), TestCase::QUICK);
+    AddTestCase (new TcpJerseyExplicitRetransmit (40 * 1446, 1446, 60, MilliSeconds (100), TcpSocketState::ECN_IDLE, "Jersey keeps the estimated rate on non-congestion loss"), TestCase::QUICK);
+    AddTestCase (new TcpJerseyExplicitRetransmit (2 * 1446, 1446, 60, MilliSeconds (100), TcpSocketState::ECN_IDLE, "Jersey grows a small window to the estimated rate on non-congestion loss"), TestCase::QUICK);
+    AddTestCase (new TcpJerseyExplicitRetransmit (40 * 1446, 1446, 60, MilliSeconds (100), TcpSocketState::ECN_ECE_RCVD, "Jersey caps cWnd on congestion loss"), TestCase::QUICK);
+    AddTestCase (new TcpJerseyExplicitRetransmit (3 * 1446, 1446, 60, MilliSeconds (100), TcpSocketState::ECN_ECE_RCVD, "Jersey does not grow cWnd on congestion loss"), TestCase::QUICK);
+    AddTestCase (new TcpJerseyEcnLossTest ("Jersey ignores a congestion warning of an earlier window on loss"), TestCase::QUICK);
   }
 };
 
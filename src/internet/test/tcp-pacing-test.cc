@@ -0,0 +1,154 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017 NITK Surathkal
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "tcp-general-test.h"
+#include "ns3/node.h"
+#include "ns3/log.h"
+#include "ns3/boolean.h"
+#include "ns3/data-rate.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("TcpPacingTestSuite");
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Check the spacing of data segments with and without pacing
+ *
+ * The application writes all its data at once, so that without pacing the
+ * sender transmits a burst of cWnd segments every RTT. With pacing enabled,
+ * two data segments never leave at the same time, and they are at least
+ * spaced by the transmission time of the previous segment at MaxPacingRate.
+ */
+class TcpPacingTest : public TcpGeneralTest
+{
+public:
+  /**
+   * \brief Constructor
+   * \param pacing true to enable pacing on the sender
+   * \param maxRate maximum pacing rate
+   * \param desc Description of the test
+   */
+  TcpPacingTest (bool pacing, DataRate maxRate, const std::string &desc);
+
+protected:
+  virtual void ConfigureEnvironment ();
+  virtual Ptr<TcpSocketMsgBase> CreateSenderSocket (Ptr<Node> node);
+  virtual void Tx (const Ptr<const Packet> p, const TcpHeader&h, SocketWho who);
+  virtual void FinalChecks ();
+
+private:
+  bool m_pacing;            //!< Pacing enabled on the sender
+  DataRate m_maxRate;       //!< Maximum pacing rate
+  Time m_lastTx;            //!< Time of the last data segment
+  uint32_t m_lastSize;      //!< Size of the last data segment
+  uint32_t m_dataSegments;  //!< Data segments sent
+  uint32_t m_bursts;        //!< Data segments sent at the same time as the previous one
+};
+
+TcpPacingTest::TcpPacingTest (bool pacing, DataRate maxRate, const std::string &desc)
+  : TcpGeneralTest (desc),
+    m_pacing (pacing),
+    m_maxRate (maxRate),
+    m_lastTx (Time::Min ()),
+    m_lastSize (0),
+    m_dataSegments (0),
+    m_bursts (0)
+{
+}
+
+void
+TcpPacingTest::ConfigureEnvironment ()
+{
+  TcpGeneralTest::ConfigureEnvironment ();
+  SetAppPktCount (20);
+  SetAppPktInterval (Time (0));
+  SetPropagationDelay (MilliSeconds (50));
+}
+
+Ptr<TcpSocketMsgBase>
+TcpPacingTest::CreateSenderSocket (Ptr<Node> node)
+{
+  Ptr<TcpSocketMsgBase> socket = TcpGeneralTest::CreateSenderSocket (node);
+  socket->SetAttribute ("Pacing", BooleanValue (m_pacing));
+  socket->SetAttribute ("MaxPacingRate", DataRateValue (m_maxRate));
+  return socket;
+}
+
+void
+TcpPacingTest::Tx (const Ptr<const Packet> p, const TcpHeader &h, SocketWho who)
+{
+  if (who != SENDER || p->GetSize () == 0)
+    {
+      return;
+    }
+
+  Time now = Simulator::Now ();
+  if (m_dataSegments > 0)
+    {
+      if (now == m_lastTx)
+        {
+          ++m_bursts;
+        }
+      if (m_pacing)
+        {
+          NS_TEST_ASSERT_MSG_GT_OR_EQ (now - m_lastTx, m_maxRate.CalculateBytesTxTime (m_lastSize),
+                                       "Segment " << h.GetSequenceNumber () << " sent too early");
+        }
+    }
+
+  m_lastTx = now;
+  m_lastSize = p->GetSize ();
+  ++m_dataSegments;
+}
+
+void
+TcpPacingTest::FinalChecks ()
+{
+  NS_TEST_ASSERT_MSG_GT_OR_EQ (m_dataSegments, GetPktCount (), "Not all the data has been sent");
+  if (m_pacing)
+    {
+      NS_TEST_ASSERT_MSG_EQ (m_bursts, 0, "Paced segments sent back to back");
+    }
+  else
+    {
+      NS_TEST_ASSERT_MSG_GT (m_bursts, 0, "Without pacing the window should be sent in bursts");
+    }
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief TCP pacing TestSuite
+ */
+class TcpPacingTestSuite : public TestSuite
+{
+public:
+  TcpPacingTestSuite () : TestSuite ("tcp-pacing-test", UNIT)
+  {
+    AddTestCase (new TcpPacingTest (false, DataRate ("4Gb/s"), "Pacing disabled"), TestCase::QUICK);
+    AddTestCase (new TcpPacingTest (true, DataRate ("4Gb/s"), "Pacing at the cWnd rate"), TestCase::QUICK);
+    AddTestCase (new TcpPacingTest (true, DataRate ("50Kb/s"), "Pacing capped to MaxPacingRate"), TestCase::QUICK);
+  }
+};
+
+static TcpPacingTestSuite g_tcpPacingTest; //!< static var for test initialization
@@ -18,9 +18,13 @@
 #include "ns3/test.h"
 #include "ns3/packet.h"
 #include "ns3/log.h"
+#include "ns3/socket.h"
+#include "ns3/random-variable-stream.h"
 
 #include "ns3/tcp-rx-buffer.h"
 
+#include <ctime>
+
 using namespace ns3;
 
 NS_LOG_COMPONENT_DEFINE ("TcpRxBufferTestSuite");
@@ -344,6 +348,192 @@ TcpRxBufferTestCase::DoTeardown ()
 }
 
 
+/**
+ * \ingroup internet-tests
+ * \ingroup tests
+ *
+ * \brief Check the data extracted from the TcpRxBuffer
+ *
+ * A byte stream is cut in segments of random size, that are added to the
+ * buffer out of order, duplicated and partially retransmitted, while the
+ * application extracts random amounts of data. The extracted bytes must be
+ * the original stream, without the packet tags of the segments.
+ */
+class TcpRxBufferReassemblyTestCase : public TestCase
+{
+public:
+  TcpRxBufferReassemblyTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \brief Add a part of the stream to the buffer
+   * \param start offset of the first byte in the stream
+   * \param size number of bytes
+   */
+  void AddSegment (uint32_t start, uint32_t size);
+
+  /**
+   * \brief Extract data from the buffer and check it
+   * \param maxSize maximum number of bytes to extract
+   */
+  void ExtractAndCheck (uint32_t maxSize);
+
+  static const uint32_t STREAM_SIZE = 200000; //!< Size of the stream
+
+  TcpRxBuffer m_rxBuf;            //!< The buffer under test
+  std::vector<uint8_t> m_stream;  //!< The stream
+  uint32_t m_read;                //!< Bytes read by the application
+};
+
+TcpRxBufferReassemblyTestCase::TcpRxBufferReassemblyTestCase ()
+  : TestCase ("TcpRxBuffer reassembly"),
+    m_rxBuf (0),
+    m_read (0)
+{
+}
+
+void
+TcpRxBufferReassemblyTestCase::AddSegment (uint32_t start, uint32_t size)
+{
+  size = std::min (size, STREAM_SIZE - start);
+  TcpHeader h;
+  h.SetSequenceNumber (SequenceNumber32 (start));
+  Ptr<Packet> p = Create<Packet> (&m_stream[start], size);
+  SocketIpTtlTag tag;
+  p->AddPacketTag (tag);
+  m_rxBuf.Add (p, h);
+}
+
+void
+TcpRxBufferReassemblyTestCase::ExtractAndCheck (uint32_t maxSize)
+{
+  uint32_t available = m_rxBuf.Available ();
+  Ptr<Packet> p = m_rxBuf.Extract (maxSize);
+  if (p == 0)
+    {
+      NS_TEST_ASSERT_MSG_EQ (std::min (available, maxSize), 0, "Data available, but not extracted");
+      return;
+    }
+
+  NS_TEST_ASSERT_MSG_EQ (p->GetSize (), std::min (available, maxSize), "Wrong amount of data");
+  SocketIpTtlTag tag;
+  NS_TEST_ASSERT_MSG_EQ (p->PeekPacketTag (tag), false, "Packet tags should not be delivered");
+
+  std::vector<uint8_t> data (p->GetSize ());
+  p->CopyData (&data[0], data.size ());
+  for (uint32_t i = 0; i < data.size (); ++i)
+    {
+      NS_TEST_ASSERT_MSG_EQ (data[i], m_stream[m_read + i], "Wrong byte at offset " << m_read + i);
+    }
+  m_read += data.size ();
+}
+
+void
+TcpRxBufferReassemblyTestCase::DoRun ()
+{
+  Ptr<UniformRandomVariable> rng = CreateObject<UniformRandomVariable> ();
+  rng->SetStream (1);
+
+  m_stream.resize (STREAM_SIZE);
+  for (uint32_t i = 0; i < STREAM_SIZE; ++i)
+    {
+      m_stream[i] = static_cast<uint8_t> (i * 7 + (i >> 8));
+    }
+  m_rxBuf.SetMaxBufferSize (STREAM_SIZE);
+
+  // Cut the stream in segments
+  std::vector<std::pair<uint32_t, uint32_t> > segments;
+  for (uint32_t start = 0; start < STREAM_SIZE; )
+    {
+      uint32_t size = rng->GetInteger (50, 1500);
+      segments.push_back (std::make_pair (start, size));
+      start += size;
+    }
+
+  for (uint32_t i = 0; i < segments.size (); ++i)
+    {
+      // Reorder with the next few segments
+      uint32_t j = std::min<uint32_t> (i + rng->GetInteger (0, 3), segments.size () - 1);
+      std::swap (segments[i], segments[j]);
+      AddSegment (segments[i].first, segments[i].second);
+
+      uint32_t op = rng->GetInteger (0, 9);
+      if (op == 0)
+        {
+          // Duplicate
+          AddSegment (segments[i].first, segments[i].second);
+        }
+      else if (op == 1)
+        {
+          // Retransmission of a range covering parts of several segments
+          uint32_t start = rng->GetInteger (segments[i].first / 2, segments[i].first);
+          AddSegment (start, rng->GetInteger (1, 4000));
+        }
+
+      ExtractAndCheck (rng->GetInteger (0, 3000));
+    }
+
+  ExtractAndCheck (STREAM_SIZE);
+  NS_TEST_ASSERT_MSG_EQ (m_read, STREAM_SIZE, "Not all the stream has been read");
+  NS_TEST_ASSERT_MSG_EQ (m_rxBuf.NextRxSequence (), SequenceNumber32 (STREAM_SIZE), "Wrong RCV.NXT");
+  NS_TEST_ASSERT_MSG_EQ (m_rxBuf.Size (), 0, "Buffer not empty");
+}
+
+/**
+ * \ingroup internet-tests
+ * \ingroup tests
+ *
+ * \brief Measure Add and Extract on in-order segments
+ *
+ * This is what the receiver of a bulk transfer does: full-sized segments
+ * arrive in order, and the application reads them as they become available.
+ */
+class TcpRxBufferInOrderTimeTestCase : public TestCase
+{
+public:
+  TcpRxBufferInOrderTimeTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+TcpRxBufferInOrderTimeTestCase::TcpRxBufferInOrderTimeTestCase ()
+  : TestCase ("TcpRxBuffer in-order time")
+{
+}
+
+void
+TcpRxBufferInOrderTimeTestCase::DoRun ()
+{
+  const uint32_t segmentSize = 1446;
+  const uint32_t segments = 200000;
+  const uint32_t readSize = 4 * segmentSize;
+
+  TcpRxBuffer rxBuf (0);
+  rxBuf.SetMaxBufferSize (131072);
+  TcpHeader h;
+  uint32_t read = 0;
+
+  int start = clock ();
+  for (uint32_t i = 0; i < segments; ++i)
+    {
+      h.SetSequenceNumber (SequenceNumber32 (i * segmentSize));
+      rxBuf.Add (Create<Packet> (segmentSize), h);
+      if (rxBuf.Available () >= readSize)
+        {
+          read += rxBuf.Extract (readSize)->GetSize ();
+        }
+    }
+  int stop = clock ();
+
+  NS_TEST_ASSERT_MSG_EQ (read + rxBuf.Available (), segments * segmentSize, "Data lost");
+
+  double per = 1E9 * double (stop - start) / (double (segments) * double (CLOCKS_PER_SEC));
+  std::cout << "TcpRxBuffer: " << per << " nanosec/segment in order" << std::endl;
+}
+
 /**
  * \ingroup internet-test
  * \ingroup tests
@@ -357,6 +547,24 @@ public:
     : TestSuite ("tcp-rx-buffer", UNIT)
   {
     AddTestCase (new TcpRxBufferTestCase, TestCase::QUICK);
+    AddTestCase (new TcpRxBufferReassemblyTestCase, TestCase::QUICK);
   }
 };
 static TcpRxBufferTestSuite  g_tcpRxBufferTestSuite;
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief the TestSuite for the TcpRxBuffer performance
+ */
+class TcpRxBufferPerfTestSuite : public TestSuite
+{
+public:
+  TcpRxBufferPerfTestSuite ()
+    : TestSuite ("tcp-rx-buffer-perf", PERFORMANCE)
+  {
+    AddTestCase (new TcpRxBufferInOrderTimeTestCase, TestCase::QUICK);
+  }
+};
+static TcpRxBufferPerfTestSuite g_tcpRxBufferPerfTestSuite;
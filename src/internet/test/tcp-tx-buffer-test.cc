@@ -20,6 +20,9 @@
 #include "ns3/packet.h"
 #include "ns3/simulator.h"
 #include "ns3/log.h"
+#include "ns3/random-variable-stream.h"
+
+#include <ctime>
 
 using namespace ns3;
 
@@ -400,6 +403,372 @@ TcpTxBufferTestCase::DoTeardown ()
 {
 }
 
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Check the scoreboard against a literal implementation of RFC 6675
+ *
+ * Segments are sent, SACKed, retransmitted and acknowledged in random order;
+ * after every operation BytesInFlight, NextSeg and IsLost are compared with
+ * the values computed over a per-segment model of the sent list.
+ */
+class TcpTxBufferScoreboardTestCase : public TestCase
+{
+public:
+  /** \brief Constructor */
+  TcpTxBufferScoreboardTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /** \brief State of a segment in the reference model */
+  struct Segment
+  {
+    bool sacked;   //!< SACKed
+    bool lost;     //!< Marked lost (RTO)
+    bool retrans;  //!< Retransmitted
+  };
+
+  /**
+   * \brief RFC 6675 IsLost over the reference model
+   * \param i index of the segment
+   * \return true if the segment is lost
+   */
+  bool RefIsLost (uint32_t i) const;
+
+  /** \brief Compare the buffer with the reference model */
+  void Check ();
+
+  static const uint32_t SEGMENT_SIZE = 100; //!< Segment size
+  static const uint32_t DUP_THRESH = 3;     //!< dupAck threshold
+
+  TcpTxBuffer m_txBuf;             //!< The buffer under test
+  std::vector<Segment> m_sent;     //!< Reference sent list
+  SequenceNumber32 m_head;         //!< First sequence of the sent list
+  SequenceNumber32 m_highestSack;  //!< End of the highest SACKed block
+  uint32_t m_unsent;               //!< Segments not sent yet
+};
+
+TcpTxBufferScoreboardTestCase::TcpTxBufferScoreboardTestCase ()
+  : TestCase ("TcpTxBuffer scoreboard against RFC 6675"),
+    m_head (1),
+    m_highestSack (0),
+    m_unsent (0)
+{
+}
+
+bool
+TcpTxBufferScoreboardTestCase::RefIsLost (uint32_t i) const
+{
+  if (m_sent[i].lost)
+    {
+      return true;
+    }
+  if (m_sent[i].sacked)
+    {
+      return false;
+    }
+
+  uint32_t count = 0;
+  for (uint32_t j = i + 1; j < m_sent.size (); ++j)
+    {
+      if (m_sent[j].sacked)
+        {
+          ++count;
+          if (count >= DUP_THRESH || count * SEGMENT_SIZE > (DUP_THRESH - 1) * SEGMENT_SIZE)
+            {
+              return true;
+            }
+        }
+    }
+  return false;
+}
+
+void
+TcpTxBufferScoreboardTestCase::Check ()
+{
+  uint32_t pipe = 0;
+  bool hasRule1 = false;
+  uint32_t rule1 = 0;
+  for (uint32_t i = 0; i < m_sent.size (); ++i)
+    {
+      const Segment &s = m_sent[i];
+      if (s.sacked)
+        {
+          continue;
+        }
+      if (!RefIsLost (i) || (s.retrans && !s.lost))
+        {
+          pipe += SEGMENT_SIZE;
+        }
+      if (!hasRule1 && !s.retrans && RefIsLost (i))
+        {
+          hasRule1 = true;
+          rule1 = i;
+        }
+    }
+
+  NS_TEST_ASSERT_MSG_EQ (m_txBuf.BytesInFlight (DUP_THRESH, SEGMENT_SIZE), pipe,
+                         "Wrong bytes in flight");
+
+  SequenceNumber32 next;
+  bool found = m_txBuf.NextSeg (&next, DUP_THRESH, SEGMENT_SIZE, false);
+  if (hasRule1)
+    {
+      NS_TEST_ASSERT_MSG_EQ (found, true, "NextSeg did not find the lost segment");
+      NS_TEST_ASSERT_MSG_EQ (next, m_head + rule1 * SEGMENT_SIZE, "Wrong NextSeg (rule 1)");
+    }
+  else if (m_unsent > 0)
+    {
+      NS_TEST_ASSERT_MSG_EQ (found, true, "NextSeg did not find new data");
+      NS_TEST_ASSERT_MSG_EQ (next, m_head + m_sent.size () * SEGMENT_SIZE, "Wrong NextSeg (rule 2)");
+    }
+
+  for (uint32_t i = 0; i < m_sent.size (); i += 7)
+    {
+      // IsLost is false above the highest SACK, even for segments marked lost
+      SequenceNumber32 seq = m_head + i * SEGMENT_SIZE;
+      bool lost = seq < m_highestSack && RefIsLost (i);
+      NS_TEST_ASSERT_MSG_EQ (m_txBuf.IsLost (seq, DUP_THRESH, SEGMENT_SIZE), lost,
+                             "Wrong IsLost for segment " << i);
+    }
+}
+
+void
+TcpTxBufferScoreboardTestCase::DoRun ()
+{
+  Ptr<UniformRandomVariable> rng = CreateObject<UniformRandomVariable> ();
+  rng->SetStream (1);
+
+  m_txBuf.SetMaxBufferSize (UINT32_MAX);
+  m_txBuf.SetHeadSequence (m_head);
+  m_unsent = 1000;
+  m_txBuf.Add (Create<Packet> (m_unsent * SEGMENT_SIZE));
+
+  for (uint32_t step = 0; step < 3000 && (m_unsent > 0 || !m_sent.empty ()); ++step)
+    {
+      uint32_t op = rng->GetInteger (0, 99);
+
+      if (op < 35 && m_unsent > 0)
+        {
+          // Send new data
+          m_txBuf.CopyFromSequence (SEGMENT_SIZE, m_head + m_sent.size () * SEGMENT_SIZE);
+          Segment s = { false, false, false };
+          m_sent.push_back (s);
+          --m_unsent;
+        }
+      else if (op < 70 && m_sent.size () > 1)
+        {
+          // SACK a block of segments (never the head)
+          uint32_t first = rng->GetInteger (1, m_sent.size () - 1);
+          uint32_t last = std::min<uint32_t> (first + rng->GetInteger (0, 3), m_sent.size () - 1);
+          TcpOptionSack::SackList list;
+          list.push_back (TcpOptionSack::SackBlock (m_head + first * SEGMENT_SIZE,
+                                                    m_head + (last + 1) * SEGMENT_SIZE));
+          m_txBuf.Update (list);
+          for (uint32_t i = first; i <= last; ++i)
+            {
+              m_sent[i].sacked = true;
+            }
+          m_highestSack = std::max (m_highestSack, m_head + (last + 1) * SEGMENT_SIZE);
+        }
+      else if (op < 85 && !m_sent.empty ())
+        {
+          // Retransmit what NextSeg suggests, if it is a retransmission
+          SequenceNumber32 next;
+          if (m_txBuf.NextSeg (&next, DUP_THRESH, SEGMENT_SIZE, true)
+              && next < m_head + m_sent.size () * SEGMENT_SIZE)
+            {
+              m_txBuf.CopyFromSequence (SEGMENT_SIZE, next);
+              Segment &s = m_sent[(next - m_head) / SEGMENT_SIZE];
+              s.retrans = true;
+              s.lost = false;
+            }
+        }
+      else if (op < 97 && !m_sent.empty ())
+        {
+          // Cumulative ACK
+          uint32_t n = rng->GetInteger (1, std::min<uint32_t> (m_sent.size (), 5));
+          m_head += n * SEGMENT_SIZE;
+          m_txBuf.DiscardUpTo (m_head);
+          m_sent.erase (m_sent.begin (), m_sent.begin () + n);
+          if (m_highestSack <= m_head)
+            {
+              m_highestSack = SequenceNumber32 (0);
+            }
+          if (!m_sent.empty ())
+            {
+              m_sent[0].sacked = false;
+            }
+        }
+      else if (op < 99)
+        {
+          // Retransmission timeout
+          m_txBuf.SetSentListLost ();
+          for (uint32_t i = 0; i < m_sent.size (); ++i)
+            {
+              m_sent[i].lost = true;
+            }
+        }
+      else
+        {
+          m_txBuf.ResetScoreboard ();
+          m_highestSack = SequenceNumber32 (0);
+          for (uint32_t i = 0; i < m_sent.size (); ++i)
+            {
+              m_sent[i].sacked = false;
+            }
+        }
+
+      Check ();
+    }
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Check the pipe when a retransmission carries new data
+ *
+ * The retransmitted part and the new data are merged in a single item; the
+ * pipe is kept up to date without rebuilding the scoreboard.
+ */
+class TcpTxBufferPartialTestCase : public TestCase
+{
+public:
+  /** \brief Constructor */
+  TcpTxBufferPartialTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+TcpTxBufferPartialTestCase::TcpTxBufferPartialTestCase ()
+  : TestCase ("TcpTxBuffer pipe of retransmissions with new data")
+{
+}
+
+void
+TcpTxBufferPartialTestCase::DoRun ()
+{
+  const uint32_t dupThresh = 3;
+  const uint32_t segmentSize = 100;
+  TcpTxBuffer txBuf;
+  SequenceNumber32 head (1);
+
+  txBuf.SetHeadSequence (head);
+  txBuf.Add (Create<Packet> (20 * segmentSize));
+  for (uint32_t i = 0; i < 10; ++i)
+    {
+      txBuf.CopyFromSequence (segmentSize, head + i * segmentSize);
+    }
+
+  // Segments 2 to 4 SACKed: 0 and 1 are lost
+  TcpOptionSack::SackList list;
+  list.push_back (TcpOptionSack::SackBlock (head + 2 * segmentSize, head + 5 * segmentSize));
+  txBuf.Update (list);
+  NS_TEST_ASSERT_MSG_EQ (txBuf.BytesInFlight (dupThresh, segmentSize), 500,
+                         "Wrong bytes in flight after the SACK");
+
+  // The last segment and 50 new bytes
+  txBuf.CopyFromSequence (150, head + 9 * segmentSize);
+  NS_TEST_ASSERT_MSG_EQ (txBuf.BytesInFlight (dupThresh, segmentSize), 550,
+                         "Wrong bytes in flight after a retransmission with new data");
+
+  // The second half of the merged item and 50 new bytes: the item is split
+  txBuf.CopyFromSequence (segmentSize, head + 10 * segmentSize);
+  NS_TEST_ASSERT_MSG_EQ (txBuf.BytesInFlight (dupThresh, segmentSize), 600,
+                         "Wrong bytes in flight after a split retransmission");
+
+  // Lost items leave the lost count, and do not count in the pipe before
+  txBuf.SetSentListLost ();
+  NS_TEST_ASSERT_MSG_EQ (txBuf.BytesInFlight (dupThresh, segmentSize), 0,
+                         "Wrong bytes in flight after the timeout");
+  txBuf.CopyFromSequence (150, head + 10 * segmentSize + 50);
+  NS_TEST_ASSERT_MSG_EQ (txBuf.BytesInFlight (dupThresh, segmentSize), 150,
+                         "Wrong bytes in flight after a lost retransmission with new data");
+
+  SequenceNumber32 next;
+  bool found = txBuf.NextSeg (&next, dupThresh, segmentSize, false);
+  NS_TEST_ASSERT_MSG_EQ (found, true, "NextSeg did not find the lost segment");
+  NS_TEST_ASSERT_MSG_EQ (next, head, "Wrong NextSeg");
+
+  // Without SACKs every segment but the last one is lost: the rebuilt
+  // scoreboard agrees with the incremental values
+  txBuf.ResetScoreboard ();
+  NS_TEST_ASSERT_MSG_EQ (txBuf.BytesInFlight (dupThresh, segmentSize), 150,
+                         "Wrong bytes in flight after the rebuild");
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Measure the scoreboard operations during a recovery
+ *
+ * A window of segments is sent, and then the receiver SACKs every segment
+ * but the first one, one ACK at a time. Each ACK updates the scoreboard and
+ * queries the bytes in flight and the next segment to send, as
+ * TcpSocketBase does.
+ */
+class TcpTxBufferScoreboardTimeTestCase : public TestCase
+{
+public:
+  /**
+   * \brief Constructor
+   * \param segments window, in segments
+   */
+  TcpTxBufferScoreboardTimeTestCase (uint32_t segments);
+
+private:
+  virtual void DoRun (void);
+  uint32_t m_segments; //!< Window, in segments
+};
+
+TcpTxBufferScoreboardTimeTestCase::TcpTxBufferScoreboardTimeTestCase (uint32_t segments)
+  : TestCase ("Scoreboard time during recovery"),
+    m_segments (segments)
+{
+}
+
+void
+TcpTxBufferScoreboardTimeTestCase::DoRun ()
+{
+  const uint32_t segmentSize = 1446;
+  const uint32_t dupThresh = 3;
+  SequenceNumber32 head (1);
+  SequenceNumber32 next;
+
+  TcpTxBuffer txBuf;
+  txBuf.SetMaxBufferSize (UINT32_MAX);
+  txBuf.SetHeadSequence (head);
+  txBuf.Add (Create<Packet> (m_segments * segmentSize));
+  for (uint32_t i = 0; i < m_segments; ++i)
+    {
+      txBuf.CopyFromSequence (segmentSize, head + i * segmentSize);
+    }
+
+  int start = clock ();
+  for (uint32_t i = 1; i < m_segments; ++i)
+    {
+      TcpOptionSack::SackList list;
+      list.push_back (TcpOptionSack::SackBlock (head + segmentSize, head + (i + 1) * segmentSize));
+      txBuf.Update (list);
+      txBuf.BytesInFlight (dupThresh, segmentSize);
+      txBuf.NextSeg (&next, dupThresh, segmentSize, true);
+    }
+  int stop = clock ();
+
+  NS_TEST_ASSERT_MSG_EQ (txBuf.BytesInFlight (dupThresh, segmentSize), 0,
+                         "Only the first segment is missing, and it is lost");
+  NS_TEST_ASSERT_MSG_EQ (next, head, "The first segment should be retransmitted");
+
+  double per = 1E6 * double (stop - start) / (double (m_segments) * double (CLOCKS_PER_SEC));
+  std::cout << "TcpTxBuffer: " << m_segments << " segments, "
+            << per << " microsec/ACK" << std::endl;
+}
+
 /**
  * \ingroup internet-test
  * \ingroup tests
@@ -413,7 +782,29 @@ public:
     : TestSuite ("tcp-tx-buffer", UNIT)
   {
     AddTestCase (new TcpTxBufferTestCase, TestCase::QUICK);
+    AddTestCase (new TcpTxBufferScoreboardTestCase, TestCase::QUICK);
+    AddTestCase (new TcpTxBufferPartialTestCase, TestCase::QUICK);
   }
 };
 
 static TcpTxBufferTestSuite  g_tcpTxBufferTestSuite; //!< Static variable for test initialization
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief the TestSuite for the TcpTxBuffer performance
+ */
+class TcpTxBufferPerfTestSuite : public TestSuite
+{
+public:
+  TcpTxBufferPerfTestSuite ()
+    : TestSuite ("tcp-tx-buffer-perf", PERFORMANCE)
+  {
+    AddTestCase (new TcpTxBufferScoreboardTimeTestCase (500), TestCase::QUICK);
+    AddTestCase (new TcpTxBufferScoreboardTimeTestCase (2000), TestCase::QUICK);
+    AddTestCase (new TcpTxBufferScoreboardTimeTestCase (8000), TestCase::QUICK);
+  }
+};
+
+static TcpTxBufferPerfTestSuite g_tcpTxBufferPerfTestSuite; //!< Static variable for test initialization
@@ -0,0 +1,788 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "multithreaded-simulator-impl.h"
+
+#include "ns3/simulator.h"
+#include "ns3/scheduler.h"
+#include "ns3/event-impl.h"
+#include "ns3/channel.h"
+#include "ns3/node-list.h"
+#include "ns3/node.h"
+#include "ns3/net-device.h"
+#include "ns3/nstime.h"
+#include "ns3/uinteger.h"
+#include "ns3/make-event.h"
+#include "ns3/assert.h"
+#include "ns3/abort.h"
+#include "ns3/log.h"
+
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <thread>
+
+/**
+ * \file
+ * \ingroup mpi
+ * Implementation of class ns3::MultithreadedSimulatorImpl.
+ */
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("MultithreadedSimulatorImpl");
+
+NS_OBJECT_ENSURE_REGISTERED (MultithreadedSimulatorImpl);
+
+thread_local MultithreadedSimulatorImpl::Partition *MultithreadedSimulatorImpl::m_current = 0;
+
+namespace {
+
+/** Timestamp of no event. */
+const uint64_t NO_TS = std::numeric_limits<uint64_t>::max ();
+
+/** Index of the global partition. */
+const uint32_t GLOBAL_INDEX = 0xffffffff;
+
+} // unnamed namespace
+
+TypeId
+MultithreadedSimulatorImpl::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::MultithreadedSimulatorImpl")
+    .SetParent<SimulatorImpl> ()
+    .SetGroupName ("Mpi")
+    .AddConstructor<MultithreadedSimulatorImpl> ()
+    .AddAttribute ("MaxThreads",
+                   "The maximum number of threads running the partitions; "
+                   "0 uses one thread per processor.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&MultithreadedSimulatorImpl::m_maxThreads),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("MaximumLookAhead",
+                   "The lookahead between the partitions which are not "
+                   "linked by point-to-point channels: the minimum delay of "
+                   "the events they schedule for each other.",
+                   TimeValue (TimeStep (0x7fffffffffffffffLL)),
+                   MakeTimeAccessor (&MultithreadedSimulatorImpl::m_maxLookAhead),
+                   MakeTimeChecker (TimeStep (1)))
+  ;
+  return tid;
+}
+
+MultithreadedSimulatorImpl::MultithreadedSimulatorImpl ()
+  : m_global (0),
+    m_lookAhead (NO_TS),
+    m_maxThreads (0),
+    m_stop (false),
+    m_windowEnd (0),
+    m_window (0),
+    m_nextPartition (0),
+    m_generation (0),
+    m_done (0),
+    m_exit (false),
+    m_windows (0)
+{
+  NS_LOG_FUNCTION (this);
+  m_global = CreatePartition (GLOBAL_INDEX);
+}
+
+MultithreadedSimulatorImpl::~MultithreadedSimulatorImpl ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+MultithreadedSimulatorImpl::Partition *
+MultithreadedSimulatorImpl::CreatePartition (uint32_t index) const
+{
+  NS_LOG_FUNCTION (this << index);
+  Partition *partition = new Partition ();
+  if (m_schedulerFactory.GetTypeId ().GetUid () != 0)
+    {
+      partition->m_events = m_schedulerFactory.Create<Scheduler> ();
+    }
+  partition->m_index = index;
+  // uids are allocated from 4.
+  // uid 0 is "invalid" events
+  // uid 1 is "now" events
+  // uid 2 is "destroy" events
+  partition->m_uid = 4;
+  partition->m_currentUid = 0;
+  partition->m_currentTs = m_global != 0 ? m_global->m_currentTs : 0;
+  partition->m_currentContext = Simulator::NO_CONTEXT;
+  partition->m_unscheduledEvents = 0;
+  partition->m_cancelledEvents = 0;
+  partition->m_sent = 0;
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      partition->m_inbox[i].store (0);
+      partition->m_inboxNext[i].store (NO_TS);
+    }
+  return partition;
+}
+
+void
+MultithreadedSimulatorImpl::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  std::vector<Partition *> partitions = m_partitions;
+  partitions.push_back (m_global);
+  for (std::vector<Partition *>::const_iterator i = partitions.begin (); i != partitions.end (); ++i)
+    {
+      Partition *partition = *i;
+      for (uint32_t j = 0; j < 2; j++)
+        {
+          Message *message = partition->m_inbox[j].exchange (0);
+          while (message != 0)
+            {
+              Message *next = message->m_next;
+              message->m_event.impl->Unref ();
+              delete message;
+              message = next;
+            }
+        }
+      while (!partition->m_events->IsEmpty ())
+        {
+          Scheduler::Event next = partition->m_events->RemoveNext ();
+          next.impl->Unref ();
+        }
+      delete partition;
+    }
+  m_partitions.clear ();
+  m_nodePartition.clear ();
+  m_systemPartition.clear ();
+  m_global = 0;
+  SimulatorImpl::DoDispose ();
+}
+
+void
+MultithreadedSimulatorImpl::Destroy ()
+{
+  NS_LOG_FUNCTION (this);
+  while (!m_destroyEvents.empty ())
+    {
+      Ptr<EventImpl> ev = m_destroyEvents.front ().PeekEventImpl ();
+      m_destroyEvents.pop_front ();
+      NS_LOG_LOGIC ("handle destroy " << ev);
+      if (!ev->IsCancelled ())
+        {
+          ev->Invoke ();
+        }
+    }
+}
+
+void
+MultithreadedSimulatorImpl::SetScheduler (ObjectFactory schedulerFactory)
+{
+  NS_LOG_FUNCTION (this << schedulerFactory);
+  NS_ASSERT_MSG (m_current == 0, "Simulator::SetScheduler called from a partition");
+  m_schedulerFactory = schedulerFactory;
+  std::vector<Partition *> partitions = m_partitions;
+  partitions.push_back (m_global);
+  for (std::vector<Partition *>::const_iterator i = partitions.begin (); i != partitions.end (); ++i)
+    {
+      Ptr<Scheduler> scheduler = schedulerFactory.Create<Scheduler> ();
+      if ((*i)->m_events != 0)
+        {
+          while (!(*i)->m_events->IsEmpty ())
+            {
+              scheduler->Insert ((*i)->m_events->RemoveNext ());
+            }
+        }
+      (*i)->m_events = scheduler;
+    }
+}
+
+// The partitions are not separate systems
+uint32_t
+MultithreadedSimulatorImpl::GetSystemId (void) const
+{
+  return 0;
+}
+
+MultithreadedSimulatorImpl::Partition *
+MultithreadedSimulatorImpl::GetCurrent (void) const
+{
+  return m_current != 0 ? m_current : m_global;
+}
+
+void
+MultithreadedSimulatorImpl::UpdatePartitions (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (m_current == 0);
+  uint32_t nNodes = NodeList::GetNNodes ();
+  if (m_nodePartition.size () == nNodes)
+    {
+      return;
+    }
+  for (uint32_t i = m_nodePartition.size (); i < nNodes; i++)
+    {
+      uint32_t systemId = NodeList::GetNode (i)->GetSystemId ();
+      std::map<uint32_t, uint32_t>::const_iterator j = m_systemPartition.find (systemId);
+      if (j == m_systemPartition.end ())
+        {
+          NS_LOG_LOGIC ("partition " << m_partitions.size () << " for system " << systemId);
+          j = m_systemPartition.insert (std::make_pair (systemId, m_partitions.size ())).first;
+          m_partitions.push_back (CreatePartition (m_partitions.size ()));
+        }
+      m_nodePartition.push_back (j->second);
+    }
+}
+
+MultithreadedSimulatorImpl::Partition *
+MultithreadedSimulatorImpl::PeekPartition (uint32_t context) const
+{
+  if (context < m_nodePartition.size ())
+    {
+      return m_partitions[m_nodePartition[context]];
+    }
+  return m_global;
+}
+
+MultithreadedSimulatorImpl::Partition *
+MultithreadedSimulatorImpl::GetPartition (uint32_t context)
+{
+  // New nodes can only be created outside of the windows
+  if (context >= m_nodePartition.size () && context != Simulator::NO_CONTEXT && m_current == 0)
+    {
+      UpdatePartitions ();
+    }
+  return PeekPartition (context);
+}
+
+void
+MultithreadedSimulatorImpl::CalculateLookAhead (void)
+{
+  NS_LOG_FUNCTION (this);
+  Time lookAhead = m_maxLookAhead;
+  for (uint32_t i = 0; i < m_nodePartition.size (); i++)
+    {
+      Ptr<Node> node = NodeList::GetNode (i);
+      for (uint32_t j = 0; j < node->GetNDevices (); j++)
+        {
+          Ptr<NetDevice> localNetDevice = node->GetDevice (j);
+          // only works for p2p links currently
+          if (!localNetDevice->IsPointToPoint ())
+            {
+              continue;
+            }
+          Ptr<Channel> channel = localNetDevice->GetChannel ();
+          if (channel == 0 || channel->GetNDevices () != 2)
+            {
+              continue;
+            }
+          Ptr<Node> remoteNode;
+          if (channel->GetDevice (0) == localNetDevice)
+            {
+              remoteNode = channel->GetDevice (1)->GetNode ();
+            }
+          else
+            {
+              remoteNode = channel->GetDevice (0)->GetNode ();
+            }
+          if (m_nodePartition[remoteNode->GetId ()] == m_nodePartition[i])
+            {
+              continue;
+            }
+          TimeValue delay;
+          channel->GetAttribute ("Delay", delay);
+          lookAhead = Min (lookAhead, delay.Get ());
+        }
+    }
+  if (m_partitions.size () > 1 && !lookAhead.IsStrictlyPositive ())
+    {
+      NS_FATAL_ERROR ("The partitions are linked by channels without delay");
+    }
+  m_lookAhead = lookAhead.GetTimeStep ();
+  NS_LOG_LOGIC ("lookahead " << lookAhead << " between " << m_partitions.size () << " partitions");
+}
+
+Time
+MultithreadedSimulatorImpl::GetLookAhead (void) const
+{
+  return TimeStep (m_lookAhead);
+}
+
+Scheduler::EventKey
+MultithreadedSimulatorImpl::Insert (Partition *partition, uint64_t ts, uint32_t context, EventImpl *event)
+{
+  Scheduler::Event ev;
+  ev.impl = event;
+  ev.key.m_ts = ts;
+  ev.key.m_context = context;
+  ev.key.m_uid = partition->m_uid;
+  partition->m_uid++;
+  partition->m_unscheduledEvents++;
+  partition->m_events->Insert (ev);
+  return ev.key;
+}
+
+void
+MultithreadedSimulatorImpl::Send (Partition *from, Partition *to, uint64_t ts, uint32_t context, EventImpl *event)
+{
+  Message *message = new Message ();
+  message->m_event.impl = event;
+  message->m_event.key.m_ts = ts;
+  message->m_event.key.m_context = context;
+  message->m_event.key.m_uid = 0;
+  message->m_source = from->m_index;
+  message->m_sequence = from->m_sent++;
+
+  uint32_t parity = m_window & 1;
+  std::atomic<Message *> &inbox = to->m_inbox[parity];
+  message->m_next = inbox.load (std::memory_order_relaxed);
+  while (!inbox.compare_exchange_weak (message->m_next, message,
+                                       std::memory_order_release,
+                                       std::memory_order_relaxed))
+    {
+    }
+  // The end of the window orders this with the reads of the main thread
+  std::atomic<uint64_t> &inboxNext = to->m_inboxNext[parity];
+  uint64_t next = inboxNext.load (std::memory_order_relaxed);
+  while (ts < next && !inboxNext.compare_exchange_weak (next, ts, std::memory_order_relaxed))
+    {
+    }
+}
+
+namespace {
+
+/**
+ * Order of the messages received by a partition: they are inserted in the
+ * event list in an order which does not depend on the threads.
+ */
+struct MessageOrder
+{
+  /**
+   * \param [in] a A message.
+   * \param [in] b Another message.
+   * \returns \c true if \p a is inserted before \p b.
+   */
+  template <typename M>
+  bool operator () (const M *a, const M *b) const
+  {
+    if (a->m_event.key.m_ts != b->m_event.key.m_ts)
+      {
+        return a->m_event.key.m_ts < b->m_event.key.m_ts;
+      }
+    if (a->m_source != b->m_source)
+      {
+        return a->m_source < b->m_source;
+      }
+    return a->m_sequence < b->m_sequence;
+  }
+};
+
+} // unnamed namespace
+
+void
+MultithreadedSimulatorImpl::Receive (Partition *partition, uint32_t parity)
+{
+  Message *message = partition->m_inbox[parity].exchange (0, std::memory_order_acquire);
+  partition->m_inboxNext[parity].store (NO_TS, std::memory_order_relaxed);
+  if (message == 0)
+    {
+      return;
+    }
+  std::vector<Message *> &received = partition->m_received;
+  for (; message != 0; message = message->m_next)
+    {
+      received.push_back (message);
+    }
+  std::sort (received.begin (), received.end (), MessageOrder ());
+  for (std::vector<Message *>::const_iterator i = received.begin (); i != received.end (); ++i)
+    {
+      const Scheduler::Event &ev = (*i)->m_event;
+      Insert (partition, ev.key.m_ts, ev.key.m_context, ev.impl);
+      delete *i;
+    }
+  received.clear ();
+}
+
+uint64_t
+MultithreadedSimulatorImpl::NextTs (const Partition *partition)
+{
+  return partition->m_events->IsEmpty () ? NO_TS : partition->m_events->PeekNext ().key.m_ts;
+}
+
+void
+MultithreadedSimulatorImpl::ProcessOneEvent (Partition *partition)
+{
+  Scheduler::Event next = partition->m_events->RemoveNext ();
+
+  NS_ASSERT (next.key.m_ts >= partition->m_currentTs);
+  partition->m_unscheduledEvents--;
+
+  NS_LOG_LOGIC ("handle " << next.key.m_ts);
+  partition->m_currentTs = next.key.m_ts;
+  partition->m_currentContext = next.key.m_context;
+  partition->m_currentUid = next.key.m_uid;
+  if (next.impl->IsCancelled ())
+    {
+      partition->m_cancelledEvents--;
+    }
+  next.impl->Invoke ();
+  next.impl->Unref ();
+}
+
+void
+MultithreadedSimulatorImpl::ProcessWindow (void)
+{
+  uint32_t received = (m_window + 1) & 1;
+  for (;;)
+    {
+      uint32_t i = m_nextPartition.fetch_add (1, std::memory_order_relaxed);
+      if (i >= m_partitions.size ())
+        {
+          break;
+        }
+      Partition *partition = m_partitions[i];
+      m_current = partition;
+      Receive (partition, received);
+      while (!partition->m_events->IsEmpty ()
+             && partition->m_events->PeekNext ().key.m_ts < m_windowEnd)
+        {
+          ProcessOneEvent (partition);
+        }
+      m_current = 0;
+    }
+  m_done.fetch_add (1, std::memory_order_release);
+}
+
+void
+MultithreadedSimulatorImpl::Work (void)
+{
+  // Run resets the generation before starting the threads
+  uint32_t generation = 0;
+  for (;;)
+    {
+      uint32_t next;
+      while ((next = m_generation.load (std::memory_order_acquire)) == generation)
+        {
+          std::this_thread::yield ();
+        }
+      generation = next;
+      if (m_exit)
+        {
+          return;
+        }
+      ProcessWindow ();
+    }
+}
+
+bool
+MultithreadedSimulatorImpl::IsFinished (void) const
+{
+  if (m_stop)
+    {
+      return true;
+    }
+  uint32_t pending = m_window & 1;
+  for (std::vector<Partition *>::const_iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+    {
+      if (!(*i)->m_events->IsEmpty () || (*i)->m_inboxNext[pending].load () != NO_TS)
+        {
+          return false;
+        }
+    }
+  return m_global->m_events->IsEmpty ();
+}
+
+void
+MultithreadedSimulatorImpl::Run (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT_MSG (m_current == 0, "Simulator::Run called from a partition");
+  UpdatePartitions ();
+  CalculateLookAhead ();
+  m_stop = false;
+
+  uint32_t nThreads = m_maxThreads;
+  if (nThreads == 0)
+    {
+      nThreads = std::max (std::thread::hardware_concurrency (), 1u);
+    }
+  nThreads = std::max<uint32_t> (std::min<uint32_t> (nThreads, m_partitions.size ()), 1);
+  m_exit = false;
+  m_generation.store (0);
+  for (uint32_t i = 1; i < nThreads; i++)
+    {
+      Ptr<SystemThread> thread = Create<SystemThread> (MakeCallback (&MultithreadedSimulatorImpl::Work, this));
+      thread->Start ();
+      m_threads.push_back (thread);
+    }
+  NS_LOG_LOGIC ("run " << m_partitions.size () << " partitions on " << nThreads << " threads");
+
+  while (!m_stop)
+    {
+      // The events sent to the global partition by the last window
+      Receive (m_global, m_window & 1);
+
+      uint64_t partitionNext = NO_TS;
+      uint32_t pending = m_window & 1;
+      for (std::vector<Partition *>::const_iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+        {
+          partitionNext = std::min (partitionNext, NextTs (*i));
+          partitionNext = std::min (partitionNext, (*i)->m_inboxNext[pending].load (std::memory_order_relaxed));
+        }
+      uint64_t globalNext = NextTs (m_global);
+      if (globalNext == NO_TS && partitionNext == NO_TS)
+        {
+          break;
+        }
+      if (globalNext <= partitionNext)
+        {
+          // All the events due before it have run
+          ProcessOneEvent (m_global);
+          continue;
+        }
+
+      m_windowEnd = partitionNext + std::min (m_lookAhead, NO_TS - partitionNext);
+      m_windowEnd = std::min (m_windowEnd, globalNext);
+      m_window++;
+      m_windows++;
+      m_nextPartition.store (0, std::memory_order_relaxed);
+      m_done.store (0, std::memory_order_relaxed);
+      m_generation.fetch_add (1, std::memory_order_release);
+      ProcessWindow ();
+      while (m_done.load (std::memory_order_acquire) < nThreads)
+        {
+          std::this_thread::yield ();
+        }
+    }
+
+  m_exit = true;
+  m_generation.fetch_add (1, std::memory_order_release);
+  for (std::vector<Ptr<SystemThread> >::const_iterator i = m_threads.begin (); i != m_threads.end (); ++i)
+    {
+      (*i)->Join ();
+    }
+  m_threads.clear ();
+
+  // Now is the time of the last event
+  for (std::vector<Partition *>::const_iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+    {
+      m_global->m_currentTs = std::max (m_global->m_currentTs, (*i)->m_currentTs);
+    }
+  NS_LOG_LOGIC (m_windows << " windows run");
+}
+
+void
+MultithreadedSimulatorImpl::Stop (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_stop = true;
+}
+
+void
+MultithreadedSimulatorImpl::Stop (Time const &delay)
+{
+  NS_LOG_FUNCTION (this << delay.GetTimeStep ());
+  Simulator::Schedule (delay, &Simulator::Stop);
+}
+
+//
+// Schedule an event for a _relative_ time in the future.
+//
+EventId
+MultithreadedSimulatorImpl::Schedule (Time const &delay, EventImpl *event)
+{
+  NS_LOG_FUNCTION (this << delay.GetTimeStep () << event);
+  NS_ASSERT (!delay.IsStrictlyNegative ());
+  Partition *partition = GetCurrent ();
+  Scheduler::EventKey key = Insert (partition, partition->m_currentTs + delay.GetTimeStep (),
+                                    partition->m_currentContext, event);
+  return EventId (event, key.m_ts, key.m_context, key.m_uid);
+}
+
+void
+MultithreadedSimulatorImpl::ScheduleWithContext (uint32_t context, Time const &delay, EventImpl *event)
+{
+  NS_LOG_FUNCTION (this << context << delay.GetTimeStep () << event);
+  NS_ASSERT (!delay.IsStrictlyNegative ());
+  Partition *from = GetCurrent ();
+  Partition *to = GetPartition (context);
+  uint64_t ts = from->m_currentTs + delay.GetTimeStep ();
+  if (m_current == 0 || to == from)
+    {
+      // No other partition is running
+      Insert (to, ts, context, event);
+      return;
+    }
+  NS_ABORT_MSG_IF (ts < m_windowEnd,
+                   "Event for context " << context << " at " << TimeStep (ts) <<
+                   " scheduled with a delay " << delay << " shorter than the lookahead " <<
+                   TimeStep (m_lookAhead));
+  Send (from, to, ts, context, event);
+}
+
+EventId
+MultithreadedSimulatorImpl::ScheduleNow (EventImpl *event)
+{
+  return Schedule (TimeStep (0), event);
+}
+
+EventId
+MultithreadedSimulatorImpl::ScheduleDestroy (EventImpl *event)
+{
+  NS_ASSERT_MSG (m_current == 0, "Simulator::ScheduleDestroy called from a partition");
+
+  EventId id (Ptr<EventImpl> (event, false), m_global->m_currentTs, 0xffffffff, 2);
+  m_destroyEvents.push_back (id);
+  return id;
+}
+
+Time
+MultithreadedSimulatorImpl::Now (void) const
+{
+  // Do not add function logging here, to avoid stack overflow
+  return TimeStep (GetCurrent ()->m_currentTs);
+}
+
+Time
+MultithreadedSimulatorImpl::GetDelayLeft (const EventId &id) const
+{
+  if (IsExpired (id))
+    {
+      return TimeStep (0);
+    }
+  else
+    {
+      return TimeStep (id.GetTs () - GetCurrent ()->m_currentTs);
+    }
+}
+
+void
+MultithreadedSimulatorImpl::Remove (const EventId &id)
+{
+  if (id.GetUid () == 2)
+    {
+      // destroy events.
+      for (DestroyEvents::iterator i = m_destroyEvents.begin (); i != m_destroyEvents.end (); i++)
+        {
+          if (*i == id)
+            {
+              m_destroyEvents.erase (i);
+              break;
+            }
+        }
+      return;
+    }
+  if (IsExpired (id))
+    {
+      return;
+    }
+  Partition *partition = PeekPartition (id.GetContext ());
+  NS_ASSERT_MSG (m_current == 0 || m_current == partition, "EventId::Remove of the event of another partition");
+  Scheduler::Event event;
+  event.impl = id.PeekEventImpl ();
+  event.key.m_ts = id.GetTs ();
+  event.key.m_context = id.GetContext ();
+  event.key.m_uid = id.GetUid ();
+  partition->m_events->Remove (event);
+  event.impl->Cancel ();
+  // whenever we remove an event from the event list, we have to unref it.
+  event.impl->Unref ();
+
+  partition->m_unscheduledEvents--;
+}
+
+void
+MultithreadedSimulatorImpl::Cancel (const EventId &id)
+{
+  if (!IsExpired (id))
+    {
+      id.PeekEventImpl ()->Cancel ();
+      if (id.GetUid () == 2)
+        {
+          // destroy events are not in the event lists
+          return;
+        }
+      PeekPartition (id.GetContext ())->m_cancelledEvents++;
+    }
+}
+
+bool
+MultithreadedSimulatorImpl::IsExpired (const EventId &id) const
+{
+  if (id.GetUid () == 2)
+    {
+      if (id.PeekEventImpl () == 0 ||
+          id.PeekEventImpl ()->IsCancelled ())
+        {
+          return true;
+        }
+      // destroy events.
+      for (DestroyEvents::const_iterator i = m_destroyEvents.begin (); i != m_destroyEvents.end (); i++)
+        {
+          if (*i == id)
+            {
+              return false;
+            }
+        }
+      return true;
+    }
+  if (id.PeekEventImpl () == 0)
+    {
+      return true;
+    }
+  const Partition *partition = PeekPartition (id.GetContext ());
+  NS_ASSERT_MSG (m_current == 0 || m_current == partition, "EventId used by another partition");
+  if (id.GetTs () < partition->m_currentTs ||
+      (id.GetTs () == partition->m_currentTs &&
+       id.GetUid () <= partition->m_currentUid) ||
+      id.PeekEventImpl ()->IsCancelled ())
+    {
+      return true;
+    }
+  else
+    {
+      return false;
+    }
+}
+
+Time
+MultithreadedSimulatorImpl::GetMaximumSimulationTime (void) const
+{
+  return TimeStep (0x7fffffffffffffffLL);
+}
+
+Simulator::EventCounts
+MultithreadedSimulatorImpl::GetEventCounts (void) const
+{
+  Simulator::EventCounts counts;
+  counts.live = 0;
+  counts.cancelled = 0;
+  counts.compactions = 0;
+  counts.purged = 0;
+  std::vector<Partition *> partitions = m_partitions;
+  partitions.push_back (m_global);
+  for (std::vector<Partition *>::const_iterator i = partitions.begin (); i != partitions.end (); ++i)
+    {
+      counts.live += (*i)->m_unscheduledEvents - (*i)->m_cancelledEvents;
+      counts.cancelled += (*i)->m_cancelledEvents;
+    }
+  return counts;
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetContext (void) const
+{
+  return GetCurrent ()->m_currentContext;
+}
+
+} // namespace ns3
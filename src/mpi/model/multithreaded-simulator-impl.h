@@ -0,0 +1,245 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef NS3_MULTITHREADED_SIMULATOR_IMPL_H
+#define NS3_MULTITHREADED_SIMULATOR_IMPL_H
+
+#include "ns3/simulator-impl.h"
+#include "ns3/scheduler.h"
+#include "ns3/event-impl.h"
+#include "ns3/system-thread.h"
+#include "ns3/ptr.h"
+
+#include <atomic>
+#include <list>
+#include <map>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup simulator
+ * \ingroup mpi
+ *
+ * \brief Parallel simulator implementation running the partitions of the
+ * nodes on threads of a single process.
+ *
+ * The nodes are partitioned as for the distributed simulator, by their
+ * system id: each partition, or logical process, has its own event list
+ * and clock.  The lookahead is the smallest delay of the point-to-point
+ * channels between nodes of different partitions, bounded by the
+ * MaximumLookAhead attribute.
+ *
+ * The simulation proceeds by windows: all the partitions run, in
+ * parallel, their events due before the earliest event of all the
+ * partitions plus the lookahead.  As no event can affect another
+ * partition sooner than the lookahead, the windows need no other
+ * synchronization than a barrier at their end.  The events a partition
+ * schedules for a node of another partition are pushed in a lock-free
+ * inbox of that partition, and inserted in its event list at the start of
+ * the next window, in an order which only depends on the partitions, so
+ * that a simulation gives the same results whatever the number of threads.
+ *
+ * The events without a context, such as those scheduled by the main
+ * program, are global: they run alone between windows, after all the
+ * events due before them, so that they can access every node.
+ *
+ * The code run by the events of a partition must not access the objects
+ * of the nodes of the other partitions, except through events scheduled
+ * with Simulator::ScheduleWithContext at least the lookahead in the
+ * future.  EventId methods may only be called for the events of the
+ * calling partition, or from global events.
+ */
+class MultithreadedSimulatorImpl : public SimulatorImpl
+{
+public:
+  /**
+   *  Register this type.
+   *  \return The object TypeId.
+   */
+  static TypeId GetTypeId (void);
+
+  /** Constructor. */
+  MultithreadedSimulatorImpl ();
+  /** Destructor. */
+  ~MultithreadedSimulatorImpl ();
+
+  // Inherited
+  virtual void Destroy ();
+  virtual bool IsFinished (void) const;
+  virtual void Stop (void);
+  virtual void Stop (const Time &delay);
+  virtual EventId Schedule (const Time &delay, EventImpl *event);
+  virtual void ScheduleWithContext (uint32_t context, const Time &delay, EventImpl *event);
+  virtual EventId ScheduleNow (EventImpl *event);
+  virtual EventId ScheduleDestroy (EventImpl *event);
+  virtual void Remove (const EventId &id);
+  virtual void Cancel (const EventId &id);
+  virtual bool IsExpired (const EventId &id) const;
+  virtual void Run (void);
+  virtual Time Now (void) const;
+  virtual Time GetDelayLeft (const EventId &id) const;
+  virtual Time GetMaximumSimulationTime (void) const;
+  virtual Simulator::EventCounts GetEventCounts (void) const;
+  virtual void SetScheduler (ObjectFactory schedulerFactory);
+  virtual uint32_t GetSystemId (void) const;
+  virtual uint32_t GetContext (void) const;
+
+  /**
+   * \returns The lookahead of the last run.
+   */
+  Time GetLookAhead (void) const;
+
+private:
+  virtual void DoDispose (void);
+
+  /** An event sent to another partition. */
+  struct Message
+  {
+    Message *m_next;          //!< Next message of the inbox
+    Scheduler::Event m_event; //!< The event, without uid
+    uint32_t m_source;        //!< Index of the sending partition
+    uint64_t m_sequence;      //!< Sequence number in the sending partition
+  };
+
+  /** A logical process: the events of the nodes of a partition. */
+  struct Partition
+  {
+    Ptr<Scheduler> m_events;        //!< The event list
+    uint32_t m_index;               //!< Index of the partition
+    uint32_t m_uid;                 //!< Next event uid
+    uint32_t m_currentUid;          //!< Uid of the current event
+    uint64_t m_currentTs;           //!< Timestamp of the current event
+    uint32_t m_currentContext;      //!< Context of the current event
+    int m_unscheduledEvents;        //!< Number of events in the event list
+    int m_cancelledEvents;          //!< Number of cancelled events in the event list
+    uint64_t m_sent;                //!< Number of messages sent
+    std::atomic<Message *> m_inbox[2];      //!< Messages received, by window parity
+    std::atomic<uint64_t> m_inboxNext[2];   //!< Earliest message received, by window parity
+    std::vector<Message *> m_received;      //!< Messages being inserted
+  };
+
+  /**
+   * Create a partition.
+   * \param [in] index The index of the partition.
+   * \returns The new partition.
+   */
+  Partition * CreatePartition (uint32_t index) const;
+  /**
+   * Get the partition of the calling thread.
+   * \returns The partition which runs the current event, or the global
+   *          partition outside of the windows.
+   */
+  Partition * GetCurrent (void) const;
+  /**
+   * Get the partition of a context.
+   * \param [in] context The context.
+   * \returns The partition of the node of the context, or the global
+   *          partition for the events without context.
+   */
+  Partition * GetPartition (uint32_t context);
+  /**
+   * Get the partition of a context, without looking for new nodes.
+   * \param [in] context The context.
+   * \returns The partition of the node of the context, or the global
+   *          partition.
+   */
+  Partition * PeekPartition (uint32_t context) const;
+  /**
+   * Create the partitions of the nodes of the NodeList.
+   */
+  void UpdatePartitions (void);
+  /**
+   * Compute the lookahead from the point-to-point channels between partitions.
+   */
+  void CalculateLookAhead (void);
+  /**
+   * Insert an event in the event list of a partition.
+   * \param [in] partition The partition.
+   * \param [in] ts The timestamp of the event.
+   * \param [in] context The context of the event.
+   * \param [in] event The event.
+   * \returns The key of the event.
+   */
+  Scheduler::EventKey Insert (Partition *partition, uint64_t ts, uint32_t context, EventImpl *event);
+  /**
+   * Push an event in the inbox of another partition, during a window.
+   * \param [in] from The sending partition.
+   * \param [in] to The receiving partition.
+   * \param [in] ts The timestamp of the event.
+   * \param [in] context The context of the event.
+   * \param [in] event The event.
+   */
+  void Send (Partition *from, Partition *to, uint64_t ts, uint32_t context, EventImpl *event);
+  /**
+   * Insert the messages received by a partition in its event list.
+   * \param [in] partition The partition.
+   * \param [in] parity The parity of the window the messages were sent in.
+   */
+  void Receive (Partition *partition, uint32_t parity);
+  /**
+   * Run the next event of a partition.
+   * \param [in] partition The partition.
+   */
+  void ProcessOneEvent (Partition *partition);
+  /**
+   * Run the events of the partitions due in the current window, until
+   * none is left.
+   */
+  void ProcessWindow (void);
+  /**
+   * Body of the worker threads.
+   */
+  void Work (void);
+  /**
+   * Get the timestamp of the next event of a partition.
+   * \param [in] partition The partition.
+   * \returns The timestamp, or the maximum timestamp if there is none.
+   */
+  static uint64_t NextTs (const Partition *partition);
+
+  /** Container type for the events to run at Simulator::Destroy() */
+  typedef std::list<EventId> DestroyEvents;
+  /** The container of events to run at Destroy. */
+  DestroyEvents m_destroyEvents;
+
+  ObjectFactory m_schedulerFactory;         //!< Factory of the event lists
+  Partition *m_global;                      //!< Partition of the global events
+  std::vector<Partition *> m_partitions;    //!< Partitions of the nodes
+  std::vector<uint32_t> m_nodePartition;    //!< Partition index of each node
+  std::map<uint32_t, uint32_t> m_systemPartition; //!< Partition index of each system id
+  uint64_t m_lookAhead;                     //!< Lookahead of the run
+  Time m_maxLookAhead;                      //!< Maximum lookahead
+  uint32_t m_maxThreads;                    //!< Maximum number of threads
+  std::atomic<bool> m_stop;                 //!< Stop at the end of the window
+
+  uint64_t m_windowEnd;                     //!< End of the current window
+  uint32_t m_window;                        //!< Number of the current window
+  std::atomic<uint32_t> m_nextPartition;    //!< Next partition to run in the window
+  std::atomic<uint32_t> m_generation;       //!< Incremented to start a window
+  std::atomic<uint32_t> m_done;             //!< Threads done with the window
+  bool m_exit;                              //!< The worker threads exit
+  std::vector<Ptr<SystemThread> > m_threads; //!< The worker threads
+  uint64_t m_windows;                       //!< Number of windows run
+
+  /** The partition run by the calling thread, null outside of the windows. */
+  static thread_local Partition *m_current;
+};
+
+} // namespace ns3
+
+#endif /* NS3_MULTITHREADED_SIMULATOR_IMPL_H */
@@ -0,0 +1,258 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/config.h"
+#include "ns3/string.h"
+#include "ns3/uinteger.h"
+#include "ns3/nstime.h"
+#include "ns3/node.h"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+/**
+ * \file
+ * \ingroup mpi-tests
+ * MultithreadedSimulatorImpl test suite.
+ */
+
+/**
+ * \ingroup mpi
+ * \defgroup mpi-tests Mpi module tests
+ */
+
+using namespace ns3;
+
+/**
+ * \ingroup mpi-tests
+ *
+ * \brief Check that the partitions run the events of their nodes as the
+ * DefaultSimulatorImpl does, whatever the number of threads.
+ *
+ * Each node runs a chain of events at pseudo-random intervals, re-arming
+ * a timeout each time, and sends events to random nodes, in its own
+ * partition or in another one, at least the lookahead in the future.  A
+ * global event checks that it runs after all the events due before it.
+ */
+class MultithreadedSimulatorTestCase : public TestCase
+{
+public:
+  MultithreadedSimulatorTestCase ();
+
+private:
+  virtual void DoRun (void);
+  virtual void DoTeardown (void);
+
+  /** A record of an event: its timestamp and what it did. */
+  typedef std::pair<int64_t, uint32_t> Record;
+  /** The records of the events of each node. */
+  typedef std::vector<std::vector<Record> > Records;
+
+  /** The state of a node, only accessed by the events of the node. */
+  struct NodeState
+  {
+    uint64_t m_random;            //!< State of the random generator
+    uint32_t m_step;              //!< Number of steps run
+    EventId m_timeout;            //!< The timeout, re-armed at each step
+    std::vector<Record> m_records; //!< The records of the events
+    bool m_wrongContext;          //!< An event ran with a wrong context
+  };
+
+  /**
+   * Run the scenario.
+   * \param [in] type The simulator implementation.
+   * \param [in] threads The MaxThreads attribute, for the MultithreadedSimulatorImpl.
+   * \param [out] records The records of the nodes.
+   */
+  void RunScenario (std::string type, uint32_t threads, Records &records);
+
+  /**
+   * A step of the chain of events of a node.
+   * \param [in] node The node.
+   */
+  void Step (uint32_t node);
+  /**
+   * An event received from another node.
+   * \param [in] node The node.
+   * \param [in] value The value sent.
+   */
+  void Receive (uint32_t node, uint32_t value);
+  /**
+   * The timeout of a node.
+   * \param [in] node The node.
+   */
+  void Timeout (uint32_t node);
+  /** The global event, counting the records of the nodes. */
+  void Check (void);
+
+  std::vector<NodeState> m_nodes;  //!< The state of the nodes
+  uint32_t m_checked;              //!< Number of records at the global event
+  bool m_wrongCheck;               //!< The global event ran with a wrong context
+};
+
+MultithreadedSimulatorTestCase::MultithreadedSimulatorTestCase ()
+  : TestCase ("Check the events of the partitions")
+{
+}
+
+void
+MultithreadedSimulatorTestCase::DoTeardown (void)
+{
+  Config::Reset ();
+}
+
+void
+MultithreadedSimulatorTestCase::Step (uint32_t node)
+{
+  NodeState &state = m_nodes[node];
+  state.m_wrongContext |= Simulator::GetContext () != node;
+  state.m_records.push_back (Record (Simulator::Now ().GetNanoSeconds (), state.m_step));
+  if (Simulator::Now () > Seconds (1))
+    {
+      return;
+    }
+  state.m_random = state.m_random * 6364136223846793005ULL + 1442695040888963407ULL;
+  uint64_t r = state.m_random >> 16;
+  state.m_timeout.Cancel ();
+  state.m_timeout = Simulator::Schedule (MilliSeconds (5), &MultithreadedSimulatorTestCase::Timeout, this, node);
+  // Coarse delays, so that many events of a node are at the same time
+  Simulator::Schedule (MicroSeconds (250 * (r % 12)), &MultithreadedSimulatorTestCase::Step, this, node);
+  if ((r >> 12) % 4 == 0)
+    {
+      uint32_t to = (r >> 16) % m_nodes.size ();
+      Simulator::ScheduleWithContext (to, MicroSeconds (1000 + 250 * ((r >> 24) % 8)),
+                                      &MultithreadedSimulatorTestCase::Receive, this,
+                                      to, node * 100000 + state.m_step);
+    }
+  state.m_step++;
+}
+
+void
+MultithreadedSimulatorTestCase::Receive (uint32_t node, uint32_t value)
+{
+  NodeState &state = m_nodes[node];
+  state.m_wrongContext |= Simulator::GetContext () != node;
+  state.m_records.push_back (Record (Simulator::Now ().GetNanoSeconds (), 1000000000 + value));
+}
+
+void
+MultithreadedSimulatorTestCase::Timeout (uint32_t node)
+{
+  NodeState &state = m_nodes[node];
+  state.m_wrongContext |= Simulator::GetContext () != node;
+  state.m_records.push_back (Record (Simulator::Now ().GetNanoSeconds (), 2000000000));
+}
+
+void
+MultithreadedSimulatorTestCase::Check (void)
+{
+  m_wrongCheck = Simulator::GetContext () != Simulator::NO_CONTEXT || Simulator::Now () != MilliSeconds (500);
+  m_checked = 0;
+  for (std::vector<NodeState>::const_iterator i = m_nodes.begin (); i != m_nodes.end (); ++i)
+    {
+      m_checked += i->m_records.size ();
+    }
+}
+
+void
+MultithreadedSimulatorTestCase::RunScenario (std::string type, uint32_t threads, Records &records)
+{
+  const uint32_t nNodes = 16;
+  const uint32_t nPartitions = 4;
+  Config::SetGlobal ("SimulatorImplementationType", StringValue (type));
+  Config::SetDefault ("ns3::MultithreadedSimulatorImpl::MaxThreads", UintegerValue (threads));
+  Config::SetDefault ("ns3::MultithreadedSimulatorImpl::MaximumLookAhead", TimeValue (MilliSeconds (1)));
+
+  m_nodes.assign (nNodes, NodeState ());
+  for (uint32_t i = 0; i < nNodes; i++)
+    {
+      Ptr<Node> node = CreateObject<Node> (i % nPartitions);
+      NS_TEST_ASSERT_MSG_EQ (node->GetId (), i, "Unexpected node id");
+      m_nodes[i].m_random = i + 1;
+      m_nodes[i].m_step = 0;
+      m_nodes[i].m_wrongContext = false;
+      Simulator::ScheduleWithContext (i, MicroSeconds (i), &MultithreadedSimulatorTestCase::Step, this, i);
+    }
+  m_checked = 0;
+  m_wrongCheck = true;
+  Simulator::Schedule (MilliSeconds (500), &MultithreadedSimulatorTestCase::Check, this);
+  Simulator::Stop (Seconds (2));
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (Simulator::Now (), Seconds (2), "Wrong time after " << type << " run");
+
+  uint32_t before = 0;
+  records.clear ();
+  for (uint32_t i = 0; i < nNodes; i++)
+    {
+      const NodeState &state = m_nodes[i];
+      NS_TEST_EXPECT_MSG_EQ (state.m_wrongContext, false, "Event of node " << i << " with a wrong context");
+      NS_TEST_EXPECT_MSG_GT (state.m_step, 100, "Too few steps for node " << i);
+      for (std::vector<Record>::const_iterator j = state.m_records.begin (); j != state.m_records.end (); ++j)
+        {
+          before += j->first < MilliSeconds (500).GetNanoSeconds () ? 1 : 0;
+        }
+      records.push_back (state.m_records);
+    }
+  NS_TEST_EXPECT_MSG_EQ (m_wrongCheck, false, "Wrong global event");
+  NS_TEST_EXPECT_MSG_EQ (m_checked, before, "The global event ran out of order");
+  Simulator::Destroy ();
+}
+
+void
+MultithreadedSimulatorTestCase::DoRun (void)
+{
+  Records reference;
+  RunScenario ("ns3::DefaultSimulatorImpl", 0, reference);
+  Records oneThread;
+  RunScenario ("ns3::MultithreadedSimulatorImpl", 1, oneThread);
+  Records fourThreads;
+  RunScenario ("ns3::MultithreadedSimulatorImpl", 4, fourThreads);
+
+  NS_TEST_ASSERT_MSG_EQ (oneThread.size (), reference.size (), "Wrong number of nodes");
+  NS_TEST_ASSERT_MSG_EQ (fourThreads.size (), reference.size (), "Wrong number of nodes");
+  for (uint32_t i = 0; i < reference.size (); i++)
+    {
+      // The events of a node at the same time may run in another order
+      // than with the DefaultSimulatorImpl, but always in the same one
+      NS_TEST_EXPECT_MSG_EQ ((oneThread[i] == fourThreads[i]), true,
+                             "Events of node " << i << " depend on the threads");
+      std::sort (reference[i].begin (), reference[i].end ());
+      std::sort (oneThread[i].begin (), oneThread[i].end ());
+      NS_TEST_EXPECT_MSG_EQ ((oneThread[i] == reference[i]), true,
+                             "Wrong events for node " << i);
+    }
+}
+
+/**
+ * \ingroup mpi-tests
+ *
+ * \brief The MultithreadedSimulatorImpl TestSuite
+ */
+class MultithreadedSimulatorTestSuite : public TestSuite
+{
+public:
+  MultithreadedSimulatorTestSuite ()
+    : TestSuite ("multithreaded-simulator")
+  {
+    AddTestCase (new MultithreadedSimulatorTestCase (), TestCase::QUICK);
+  }
+};
+
+static MultithreadedSimulatorTestSuite g_multithreadedSimulatorTestSuite; //!< Static variable for test initialization
@@ -24,6 +24,7 @@
 #include <vector>
 #include <ostream>
 #include "ns3/assert.h"
+#include "data-free-list.h"
 
 #define BUFFER_FREE_LIST 1
 
@@ -65,10 +66,11 @@ namespace ns3 {
  * contains real data bytes in its BufferData instance but it also
  * contains "virtual zero data" which typically is used to represent
  * application-level payload. No memory is allocated to store the
- * zero bytes of application-level payload unless the user fragments
- * a Buffer: this application-level payload is kept track of with
- * a pair of integers which describe where in the buffer content
- * the "virtual zero area" starts and ends.
+ * zero bytes of application-level payload, even when the Buffer is
+ * fragmented and the fragments are appended to each other again, as
+ * long as no data is written between them: this application-level
+ * payload is kept track of with a pair of integers which describe
+ * where in the buffer content the "virtual zero area" starts and ends.
  *
  * \verbatim
  * ***: unused bytes
@@ -523,7 +525,9 @@ private:
   /**
    * \param o the buffer to append to the end of this buffer.
    *
-   * Add bytes at the end of the Buffer.
+   * Add bytes at the end of the Buffer. If the zero area of this
+   * buffer ends it, and the zero area of \p o starts it, they are
+   * merged in a single zero area and only the other bytes are copied.
    * Any call to this method invalidates any Iterator
    * pointing to this Buffer.
    */
@@ -571,6 +575,17 @@ private:
    */
   uint32_t GetSerializedSize (void) const;
 
+  /**
+   * \brief Get the counters of the free lists of the buffer data.
+   *
+   * The buffer data are kept in per-thread free lists when they are
+   * no longer used, to be reused by the next buffers of the thread,
+   * or of another thread through the global depot of DataFreeList.
+   *
+   * \returns The counters of the calling thread.
+   */
+  static DataFreeListStats GetFreeListStats (void);
+
   /**
    * \return zero if buffer not large enough
    * \param buffer points to serialization buffer
@@ -764,9 +779,9 @@ private:
   /**
    * location in a newly-allocated buffer where you should start
    * writing data. i.e., m_start should be initialized to this 
-   * value.
+   * value. Each thread has its own.
    */
-  static uint32_t g_recommendedStart;
+  static thread_local uint32_t g_recommendedStart;
 
   /**
    * offset to the start of the virtual zero area from the start
@@ -790,16 +805,9 @@ private:
   uint32_t m_end;
 
 #ifdef BUFFER_FREE_LIST
-  /// Container for buffer data
-  typedef std::vector<struct Buffer::Data*> FreeList;
-  /// Local static destructor structure
-  struct LocalStaticDestructor 
-  {
-    ~LocalStaticDestructor ();
-  };
-  static uint32_t g_maxSize; //!< Max observed data size
-  static FreeList *g_freeList; //!< Buffer data container
-  static struct LocalStaticDestructor g_localStaticDestructor; //!< Local static destructor
+  /// Free lists of the buffer data
+  typedef DataFreeList<struct Buffer::Data, uint32_t, &Buffer::Data::m_size, &Buffer::Deallocate> FreeList;
+  static thread_local uint32_t g_maxSize; //!< Max observed data size, in each thread
 #endif
 };
 
@@ -24,7 +24,6 @@
 #include <limits>
 
 #define USE_FREE_LIST 1
-#define FREE_LIST_SIZE 1000
 #define OFFSET_MAX (std::numeric_limits<int32_t>::max ())
 
 namespace ns3 {
@@ -49,27 +48,23 @@ struct ByteTagListData {
 /**
  * \ingroup packet
  *
- * \brief Container class for struct ByteTagListData
+ * \brief Free the memory of a struct ByteTagListData.
  *
  * Internal use only.
+ *
+ * \param [in] data The data.
  */
-static class ByteTagListDataFreeList : public std::vector<struct ByteTagListData *>
-{
-public:
-  ~ByteTagListDataFreeList ();
-} g_freeList; //!< Container for struct ByteTagListData
-static uint32_t g_maxSize = 0; //!< maximum data size (used for allocation)
-
-ByteTagListDataFreeList::~ByteTagListDataFreeList ()
+static void
+FreeByteTagListData (struct ByteTagListData *data)
 {
-  NS_LOG_FUNCTION (this);
-  for (ByteTagListDataFreeList::iterator i = begin ();
-       i != end (); i++)
-    {
-      uint8_t *buffer = (uint8_t *)(*i);
-      delete [] buffer;
-    }
+  uint8_t *buffer = (uint8_t *)data;
+  delete [] buffer;
 }
+
+/// Free lists of struct ByteTagListData
+typedef DataFreeList<struct ByteTagListData, uint32_t, &ByteTagListData::size,
+                     &FreeByteTagListData> ByteTagListDataFreeList;
+static thread_local uint32_t g_maxSize = 0; //!< maximum data size (used for allocation), in each thread
 #endif /* USE_FREE_LIST */
 
 ByteTagList::Iterator::Item::Item (TagBuffer buf_)
@@ -345,22 +340,15 @@ struct ByteTagListData *
 ByteTagList::Allocate (uint32_t size)
 {
   NS_LOG_FUNCTION (this << size);
-  while (!g_freeList.empty ())
+  struct ByteTagListData *data = ByteTagListDataFreeList::Get (size);
+  if (data != 0)
     {
-      struct ByteTagListData *data = g_freeList.back ();
-      g_freeList.pop_back ();
-      NS_ASSERT (data != 0);
-      if (data->size >= size)
-        {
-          data->count = 1;
-          data->dirty = 0;
-          return data;
-        }
-      uint8_t *buffer = (uint8_t *)data;
-      delete [] buffer;
+      data->count = 1;
+      data->dirty = 0;
+      return data;
     }
   uint8_t *buffer = new uint8_t [std::max (size, g_maxSize) + sizeof (struct ByteTagListData) - 4];
-  struct ByteTagListData *data = (struct ByteTagListData *)buffer;
+  data = (struct ByteTagListData *)buffer;
   data->count = 1;
   data->size = size;
   data->dirty = 0;
@@ -379,19 +367,24 @@ ByteTagList::Deallocate (struct ByteTagListData *data)
   data->count--;
   if (data->count == 0)
     {
-      if (g_freeList.size () > FREE_LIST_SIZE ||
-          data->size < g_maxSize)
+      if (data->size < g_maxSize)
         {
-          uint8_t *buffer = (uint8_t *)data;
-          delete [] buffer;
+          FreeByteTagListData (data);
         }
       else
         {
-          g_freeList.push_back (data);
+          ByteTagListDataFreeList::Put (data);
         }
     }
 }
 
+DataFreeListStats
+ByteTagList::GetFreeListStats (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  return ByteTagListDataFreeList::GetStats ();
+}
+
 #else /* USE_FREE_LIST */
 
 struct ByteTagListData *
@@ -422,6 +415,13 @@ ByteTagList::Deallocate (struct ByteTagListData *data)
     }
 }
 
+DataFreeListStats
+ByteTagList::GetFreeListStats (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  return DataFreeListStats ();
+}
+
 #endif /* USE_FREE_LIST */
 
 
@@ -24,6 +24,7 @@
 #include <stdint.h>
 #include "ns3/type-id.h"
 #include "tag-buffer.h"
+#include "data-free-list.h"
 
 namespace ns3 {
 
@@ -188,6 +189,12 @@ private:
    */ 
   void RemoveAll (void);
 
+  /**
+   * \brief Get the counters of the free lists of the tag storage.
+   * \returns The counters of the calling thread.
+   */
+  static DataFreeListStats GetFreeListStats (void);
+
   /**
    * \param offsetStart the offset which uniquely identifies the first data byte 
    *        present in the byte buffer associated to this ByteTagList.
@@ -0,0 +1,337 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+#ifndef DATA_FREE_LIST_H
+#define DATA_FREE_LIST_H
+
+#include <stdint.h>
+#include <atomic>
+#include <thread>
+
+/**
+ * \file
+ * \ingroup packet
+ * Declaration of ns3::DataFreeList and ns3::DataFreeListStats.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup packet
+ *
+ * \brief Counters of the free lists of a type of data, in a thread.
+ *
+ * The misses, which needed the system allocator, are the allocations
+ * less the hits.
+ */
+struct DataFreeListStats
+{
+  uint64_t allocations;   //!< Data requested
+  uint64_t hits;          //!< Data found in the free lists
+  uint64_t recycled;      //!< Data returned to the free lists
+  uint64_t fromDepot;     //!< Data taken from the global depot
+  uint64_t toDepot;       //!< Data moved to the global depot
+  uint64_t cached;        //!< Data currently held in the free list of the thread
+  uint64_t depot;         //!< Data currently held in the global depot
+};
+
+/**
+ * \ingroup packet
+ *
+ * \brief The free lists of the data of Buffer, PacketMetadata and ByteTagList.
+ *
+ * Each thread keeps the data it recycles in a free list of its own,
+ * so that allocating and recycling them needs no synchronization.
+ * When the free list of a thread is full, half of it moves to a
+ * global depot, bounded and protected by a spin lock, from which the
+ * threads whose free list is empty take data before allocating new
+ * ones.  A thread which only receives packets, and frees them, thus
+ * feeds the threads which create them.
+ *
+ * The data is freed when the free list of its thread is destroyed
+ * with the thread, or when the global depot is destroyed with the
+ * program.  The data recycled later is freed at once.
+ *
+ * \tparam T \explicit The type of the data.
+ * \tparam S \explicit The type of the size of the data.
+ * \tparam SIZE \explicit The field of the size of the data.
+ * \tparam DEALLOCATE \explicit The function freeing a data.
+ */
+template <typename T, typename S, S T::*SIZE, void (*DEALLOCATE)(T *)>
+class DataFreeList
+{
+public:
+  /**
+   * Get a free data of a minimum size.
+   *
+   * The smaller data found on the way are freed.
+   *
+   * \param [in] size The minimum size of the data.
+   * \returns The data, or 0 if the caller must allocate it.
+   */
+  static T * Get (uint32_t size);
+  /**
+   * Keep a data which is no longer used.
+   * \param [in] data The data.
+   */
+  static void Put (T *data);
+  /**
+   * Get the counters of the free lists of the calling thread.
+   * \returns The counters.
+   */
+  static DataFreeListStats GetStats (void);
+
+private:
+  /** Maximum number of data in the free list of a thread. */
+  static const uint32_t CACHE_SIZE = 128;
+  /** Number of data moved at once to or from the global depot. */
+  static const uint32_t BATCH_SIZE = CACHE_SIZE / 2;
+  /** Maximum number of data in the global depot. */
+  static const uint32_t DEPOT_SIZE = 1024;
+
+  /**
+   * The free list of a thread.
+   *
+   * This is trivially destructible, so that it stays usable while the
+   * thread, or the program, exits.
+   */
+  struct Cache
+  {
+    T *m_data[CACHE_SIZE];       //!< The free data
+    uint32_t m_size;             //!< Number of free data
+    DataFreeListStats m_stats;   //!< Counters
+    bool m_active;               //!< The cleaner of the thread is registered
+    bool m_exiting;              //!< The thread exits: the free list is off
+  };
+  /** Free the data of the free list of a thread when it exits. */
+  struct CacheCleaner
+  {
+    /** Constructor, run on first use in a thread. */
+    CacheCleaner ();
+    /** Destructor, run when the thread exits. */
+    ~CacheCleaner ();
+    /** Make sure the cleaner of the thread is constructed. */
+    void Activate (void);
+  };
+  /**
+   * The global depot.
+   *
+   * This is trivially destructible, and zero-initialized before any
+   * constructor runs.
+   */
+  struct Depot
+  {
+    std::atomic<bool> m_locked;  //!< The spin lock
+    T *m_data[DEPOT_SIZE];       //!< The free data
+    uint32_t m_size;             //!< Number of free data
+    bool m_destroyed;            //!< The program exits: the depot is off
+  };
+  /** Free the data of the global depot when the program exits. */
+  struct DepotCleaner
+  {
+    /** Destructor. */
+    ~DepotCleaner ();
+    /** Make sure the cleaner of the depot is constructed. */
+    void Activate (void);
+  };
+
+  /** Lock the global depot. */
+  static void Lock (void);
+  /** Unlock the global depot. */
+  static void Unlock (void);
+
+  static thread_local Cache g_cache;                //!< The free list of each thread
+  static thread_local CacheCleaner g_cacheCleaner;  //!< The cleaner of each thread
+  static Depot g_depot;                             //!< The global depot
+  static DepotCleaner g_depotCleaner;               //!< The cleaner of the global depot
+};
+
+} // namespace ns3
+
+/********************************************************************
+ *  Implementation of the templates declared above.
+ ********************************************************************/
+
+namespace ns3 {
+
+template <typename T, typename S, S T::*SIZE, void (*DEALLOCATE)(T *)>
+thread_local typename DataFreeList<T, S, SIZE, DEALLOCATE>::Cache DataFreeList<T, S, SIZE, DEALLOCATE>::g_cache;
+template <typename T, typename S, S T::*SIZE, void (*DEALLOCATE)(T *)>
+thread_local typename DataFreeList<T, S, SIZE, DEALLOCATE>::CacheCleaner DataFreeList<T, S, SIZE, DEALLOCATE>::g_cacheCleaner;
+template <typename T, typename S, S T::*SIZE, void (*DEALLOCATE)(T *)>
+typename DataFreeList<T, S, SIZE, DEALLOCATE>::Depot DataFreeList<T, S, SIZE, DEALLOCATE>::g_depot;
+template <typename T, typename S, S T::*SIZE, void (*DEALLOCATE)(T *)>
+typename DataFreeList<T, S, SIZE, DEALLOCATE>::DepotCleaner DataFreeList<T, S, SIZE, DEALLOCATE>::g_depotCleaner;
+
+template <typename T, typename S, S T::*SIZE, void (*DEALLOCATE)(T *)>
+DataFreeList<T, S, SIZE, DEALLOCATE>::CacheCleaner::CacheCleaner ()
+{
+  g_cache.m_active = true;
+}
+
+template <typename T, typename S, S T::*SIZE, void (*DEALLOCATE)(T *)>
+DataFreeList<T, S, SIZE, DEALLOCATE>::CacheCleaner::~CacheCleaner ()
+{
+  while (g_cache.m_size > 0)
+    {
+      DEALLOCATE (g_cache.m_data[--g_cache.m_size]);
+    }
+  g_cache.m_stats.cached = 0;
+  g_cache.m_exiting = true;
+}
+
+template <typename T, typename S, S T::*SIZE, void (*DEALLOCATE)(T *)>
+void
+DataFreeList<T, S, SIZE, DEALLOCATE>::CacheCleaner::Activate (void)
+{
+}
+
+template <typename T, typename S, S T::*SIZE, void (*DEALLOCATE)(T *)>
+DataFreeList<T, S, SIZE, DEALLOCATE>::DepotCleaner::~DepotCleaner ()
+{
+  Lock ();
+  while (g_depot.m_size > 0)
+    {
+      DEALLOCATE (g_depot.m_data[--g_depot.m_size]);
+    }
+  g_depot.m_destroyed = true;
+  Unlock ();
+}
+
+template <typename T, typename S, S T::*SIZE, void (*DEALLOCATE)(T *)>
+void
+DataFreeList<T, S, SIZE, DEALLOCATE>::DepotCleaner::Activate (void)
+{
+}
+
+template <typename T, typename S, S T::*SIZE, void (*DEALLOCATE)(T *)>
+void
+DataFreeList<T, S, SIZE, DEALLOCATE>::Lock (void)
+{
+  while (g_depot.m_locked.exchange (true, std::memory_order_acquire))
+    {
+      std::this_thread::yield ();
+    }
+}
+
+template <typename T, typename S, S T::*SIZE, void (*DEALLOCATE)(T *)>
+void
+DataFreeList<T, S, SIZE, DEALLOCATE>::Unlock (void)
+{
+  g_depot.m_locked.store (false, std::memory_order_release);
+}
+
+template <typename T, typename S, S T::*SIZE, void (*DEALLOCATE)(T *)>
+T *
+DataFreeList<T, S, SIZE, DEALLOCATE>::Get (uint32_t size)
+{
+  Cache &cache = g_cache;
+  cache.m_stats.allocations++;
+  if (cache.m_size == 0 && !cache.m_exiting)
+    {
+      // Refill the free list of the thread from the global depot
+      Lock ();
+      uint32_t n = g_depot.m_size < BATCH_SIZE ? g_depot.m_size : BATCH_SIZE;
+      g_depot.m_size -= n;
+      for (uint32_t i = 0; i < n; i++)
+        {
+          cache.m_data[i] = g_depot.m_data[g_depot.m_size + i];
+        }
+      Unlock ();
+      if (n > 0 && !cache.m_active)
+        {
+          g_cacheCleaner.Activate ();
+        }
+      cache.m_size = n;
+      cache.m_stats.fromDepot += n;
+      cache.m_stats.cached += n;
+    }
+  while (cache.m_size > 0)
+    {
+      T *data = cache.m_data[--cache.m_size];
+      cache.m_stats.cached--;
+      if (data->*SIZE >= size)
+        {
+          cache.m_stats.hits++;
+          return data;
+        }
+      DEALLOCATE (data);
+    }
+  return 0;
+}
+
+template <typename T, typename S, S T::*SIZE, void (*DEALLOCATE)(T *)>
+void
+DataFreeList<T, S, SIZE, DEALLOCATE>::Put (T *data)
+{
+  Cache &cache = g_cache;
+  if (cache.m_exiting)
+    {
+      DEALLOCATE (data);
+      return;
+    }
+  if (!cache.m_active)
+    {
+      g_cacheCleaner.Activate ();
+    }
+  cache.m_stats.recycled++;
+  if (cache.m_size == CACHE_SIZE)
+    {
+      // Move the oldest half of the free list of the thread to the
+      // global depot, or free it if the depot is full
+      g_depotCleaner.Activate ();
+      Lock ();
+      uint32_t n = 0;
+      if (!g_depot.m_destroyed)
+        {
+          n = DEPOT_SIZE - g_depot.m_size < BATCH_SIZE ? DEPOT_SIZE - g_depot.m_size : BATCH_SIZE;
+          for (uint32_t i = 0; i < n; i++)
+            {
+              g_depot.m_data[g_depot.m_size + i] = cache.m_data[i];
+            }
+          g_depot.m_size += n;
+        }
+      Unlock ();
+      for (uint32_t i = n; i < BATCH_SIZE; i++)
+        {
+          DEALLOCATE (cache.m_data[i]);
+        }
+      for (uint32_t i = BATCH_SIZE; i < CACHE_SIZE; i++)
+        {
+          cache.m_data[i - BATCH_SIZE] = cache.m_data[i];
+        }
+      cache.m_size -= BATCH_SIZE;
+      cache.m_stats.toDepot += n;
+      cache.m_stats.cached -= BATCH_SIZE;
+    }
+  cache.m_data[cache.m_size++] = data;
+  cache.m_stats.cached++;
+}
+
+template <typename T, typename S, S T::*SIZE, void (*DEALLOCATE)(T *)>
+DataFreeListStats
+DataFreeList<T, S, SIZE, DEALLOCATE>::GetStats (void)
+{
+  DataFreeListStats stats = g_cache.m_stats;
+  Lock ();
+  stats.depot = g_depot.m_size;
+  Unlock ();
+  return stats;
+}
+
+} // namespace ns3
+
+#endif /* DATA_FREE_LIST_H */
@@ -33,20 +33,9 @@ NS_LOG_COMPONENT_DEFINE ("PacketMetadata");
 
 bool PacketMetadata::m_enable = false;
 bool PacketMetadata::m_enableChecking = false;
-bool PacketMetadata::m_metadataSkipped = false;
-uint32_t PacketMetadata::m_maxSize = 0;
-uint16_t PacketMetadata::m_chunkUid = 0;
-PacketMetadata::DataFreeList PacketMetadata::m_freeList;
-
-PacketMetadata::DataFreeList::~DataFreeList ()
-{
-  NS_LOG_FUNCTION (this);
-  for (iterator i = begin (); i != end (); i++)
-    {
-      PacketMetadata::Deallocate (*i);
-    }
-  PacketMetadata::m_enable = false;
-}
+std::atomic<bool> PacketMetadata::m_metadataSkipped (false);
+thread_local uint32_t PacketMetadata::m_maxSize = 0;
+std::atomic<uint16_t> PacketMetadata::m_chunkUid (0);
 
 void 
 PacketMetadata::Enable (void)
@@ -70,17 +59,27 @@ PacketMetadata::EnableChecking (void)
   m_enableChecking = true;
 }
 
+DataFreeListStats
+PacketMetadata::GetFreeListStats (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  return FreeList::GetStats ();
+}
+
 void
 PacketMetadata::ReserveCopy (uint32_t size)
 {
   NS_LOG_FUNCTION (this << size);
   struct PacketMetadata::Data *newData = PacketMetadata::Create (m_used + size);
-  memcpy (newData->m_data, m_data->m_data, m_used);
   newData->m_dirtyEnd = m_used;
-  m_data->m_count--;
-  if (m_data->m_count == 0) 
+  if (m_data != 0)
     {
-      PacketMetadata::Recycle (m_data);
+      memcpy (newData->m_data, m_data->m_data, m_used);
+      m_data->m_count--;
+      if (m_data->m_count == 0) 
+        {
+          PacketMetadata::Recycle (m_data);
+        }
     }
   m_data = newData;
   if (m_head != 0xffff)
@@ -133,6 +132,10 @@ bool
 PacketMetadata::IsStateOk (void) const
 {
   NS_LOG_FUNCTION (this);
+  if (m_data == 0)
+    {
+      return m_used == 0 && m_head == 0xffff && m_tail == 0xffff;
+    }
   bool ok = m_used <= m_data->m_size;
   ok &= IsPointerOk (m_head);
   ok &= IsPointerOk (m_tail);
@@ -374,12 +377,12 @@ uint16_t
 PacketMetadata::AddSmall (const struct PacketMetadata::SmallItem *item)
 {
   NS_LOG_FUNCTION (this << item->next << item->prev << item->typeUid << item->size << item->chunkUid);
-  NS_ASSERT (m_data != 0);
   NS_ASSERT (m_used != item->prev && m_used != item->next);
   uint32_t typeUidSize = GetUleb128Size (item->typeUid);
   uint32_t sizeSize = GetUleb128Size (item->size);
   uint32_t n =  2 + 2 + typeUidSize + sizeSize + 2;
-  if (m_used + n > m_data->m_size ||
+  if (m_data == 0 ||
+      m_used + n > m_data->m_size ||
       (m_head != 0xffff &&
        m_data->m_count != 1 &&
        m_used != m_data->m_dirtyEnd))
@@ -407,7 +410,6 @@ PacketMetadata::AddBig (uint32_t next, uint32_t prev,
   NS_LOG_FUNCTION (this << next << prev <<
                    item->next << item->prev << item->typeUid << item->size << item->chunkUid <<
                    extraItem->fragmentStart << extraItem->fragmentEnd << extraItem->packetUid);
-  NS_ASSERT (m_data != 0);
   uint32_t typeUid = ((item->typeUid & 0x1) == 0x1) ? item->typeUid : item->typeUid+1;
   NS_ASSERT (m_used != prev && m_used != next);
 
@@ -417,7 +419,8 @@ PacketMetadata::AddBig (uint32_t next, uint32_t prev,
   uint32_t fragEndSize = GetUleb128Size (extraItem->fragmentEnd);
   uint32_t n = 2 + 2 + typeUidSize + sizeSize + 2 + fragStartSize + fragEndSize + 4;
 
-  if (m_used + n > m_data->m_size ||
+  if (m_data == 0 ||
+      m_used + n > m_data->m_size ||
       (m_head != 0xffff &&
        m_data->m_count != 1 &&
        m_used != m_data->m_dirtyEnd))
@@ -575,18 +578,12 @@ PacketMetadata::Create (uint32_t size)
     {
       m_maxSize = size;
     }
-  while (!m_freeList.empty ()) 
+  struct PacketMetadata::Data *data = FreeList::Get (size);
+  if (data != 0)
     {
-      struct PacketMetadata::Data *data = m_freeList.back ();
-      m_freeList.pop_back ();
-      if (data->m_size >= size) 
-        {
-          NS_LOG_LOGIC ("create found size="<<data->m_size);
-          data->m_count = 1;
-          return data;
-        }
-      NS_LOG_LOGIC ("create dealloc size="<<data->m_size);
-      PacketMetadata::Deallocate (data);
+      NS_LOG_LOGIC ("create found size="<<data->m_size);
+      data->m_count = 1;
+      return data;
     }
   NS_LOG_LOGIC ("create alloc size="<<m_maxSize);
   return PacketMetadata::Allocate (m_maxSize);
@@ -596,21 +593,15 @@ void
 PacketMetadata::Recycle (struct PacketMetadata::Data *data)
 {
   NS_LOG_FUNCTION (data);
-  if (!m_enable)
-    {
-      PacketMetadata::Deallocate (data);
-      return;
-    } 
-  NS_LOG_LOGIC ("recycle size="<<data->m_size<<", list="<<m_freeList.size ());
+  NS_LOG_LOGIC ("recycle size="<<data->m_size<<", max="<<m_maxSize);
   NS_ASSERT (data->m_count == 0);
-  if (m_freeList.size () > 1000 ||
-      data->m_size < m_maxSize) 
+  if (data->m_size < m_maxSize) 
     {
       PacketMetadata::Deallocate (data);
     } 
   else 
     {
-      m_freeList.push_back (data);
+      FreeList::Put (data);
     }
 }
 
@@ -653,6 +644,11 @@ PacketMetadata::CreateFragment (uint32_t start, uint32_t end) const
 void 
 PacketMetadata::AddHeader (const Header &header, uint32_t size)
 {
+  if (!m_enable)
+    {
+      SkipMetadata ();
+      return;
+    }
   NS_LOG_FUNCTION (this << &header << size);
   NS_ASSERT (IsStateOk ());
   uint32_t uid = header.GetInstanceTypeId ().GetUid () << 1;
@@ -662,32 +658,39 @@ PacketMetadata::AddHeader (const Header &header, uint32_t size)
 void
 PacketMetadata::DoAddHeader (uint32_t uid, uint32_t size)
 {
-  NS_LOG_FUNCTION (this << uid << size);
   if (!m_enable)
     {
-      m_metadataSkipped = true;
+      SkipMetadata ();
       return;
     }
+  NS_LOG_FUNCTION (this << uid << size);
 
   struct PacketMetadata::SmallItem item;
   item.next = m_head;
   item.prev = 0xffff;
   item.typeUid = uid;
   item.size = size;
-  item.chunkUid = m_chunkUid;
-  m_chunkUid++;
+  item.chunkUid = m_chunkUid.fetch_add (1, std::memory_order_relaxed);
   uint16_t written = AddSmall (&item);
   UpdateHead (written);
 }
 void 
 PacketMetadata::RemoveHeader (const Header &header, uint32_t size)
 {
+  if (!m_enable)
+    {
+      SkipMetadata ();
+      return;
+    }
   uint32_t uid = header.GetInstanceTypeId ().GetUid () << 1;
   NS_LOG_FUNCTION (this << &header << size);
   NS_ASSERT (IsStateOk ());
-  if (!m_enable) 
+  if (m_head == 0xffff)
     {
-      m_metadataSkipped = true;
+      if (m_enableChecking)
+        {
+          NS_FATAL_ERROR ("Removing unexpected header.");
+        }
       return;
     }
   struct PacketMetadata::SmallItem item;
@@ -730,21 +733,20 @@ PacketMetadata::RemoveHeader (const Header &header, uint32_t size)
 void 
 PacketMetadata::AddTrailer (const Trailer &trailer, uint32_t size)
 {
-  uint32_t uid = trailer.GetInstanceTypeId ().GetUid () << 1;
-  NS_LOG_FUNCTION (this << &trailer << size);
-  NS_ASSERT (IsStateOk ());
   if (!m_enable)
     {
-      m_metadataSkipped = true;
+      SkipMetadata ();
       return;
     }
+  uint32_t uid = trailer.GetInstanceTypeId ().GetUid () << 1;
+  NS_LOG_FUNCTION (this << &trailer << size);
+  NS_ASSERT (IsStateOk ());
   struct PacketMetadata::SmallItem item;
   item.next = 0xffff;
   item.prev = m_tail;
   item.typeUid = uid;
   item.size = size;
-  item.chunkUid = m_chunkUid;
-  m_chunkUid++;
+  item.chunkUid = m_chunkUid.fetch_add (1, std::memory_order_relaxed);
   uint16_t written = AddSmall (&item);
   UpdateTail (written);
   NS_ASSERT (IsStateOk ());
@@ -752,12 +754,20 @@ PacketMetadata::AddTrailer (const Trailer &trailer, uint32_t size)
 void 
 PacketMetadata::RemoveTrailer (const Trailer &trailer, uint32_t size)
 {
+  if (!m_enable)
+    {
+      SkipMetadata ();
+      return;
+    }
   uint32_t uid = trailer.GetInstanceTypeId ().GetUid () << 1;
   NS_LOG_FUNCTION (this << &trailer << size);
   NS_ASSERT (IsStateOk ());
-  if (!m_enable) 
+  if (m_tail == 0xffff)
     {
-      m_metadataSkipped = true;
+      if (m_enableChecking)
+        {
+          NS_FATAL_ERROR ("Removing unexpected trailer.");
+        }
       return;
     }
   struct PacketMetadata::SmallItem item;
@@ -800,13 +810,13 @@ PacketMetadata::RemoveTrailer (const Trailer &trailer, uint32_t size)
 void
 PacketMetadata::AddAtEnd (PacketMetadata const&o)
 {
-  NS_LOG_FUNCTION (this << &o);
-  NS_ASSERT (IsStateOk ());
-  if (!m_enable) 
+  if (!m_enable)
     {
-      m_metadataSkipped = true;
+      SkipMetadata ();
       return;
     }
+  NS_LOG_FUNCTION (this << &o);
+  NS_ASSERT (IsStateOk ());
   if (m_tail == 0xffff)
     {
       // We have no items so 'AddAtEnd' is 
@@ -878,24 +888,23 @@ PacketMetadata::AddAtEnd (PacketMetadata const&o)
 void
 PacketMetadata::AddPaddingAtEnd (uint32_t end)
 {
-  NS_LOG_FUNCTION (this << end);
   if (!m_enable)
     {
-      m_metadataSkipped = true;
+      SkipMetadata ();
       return;
     }
+  NS_LOG_FUNCTION (this << end);
 }
 void 
 PacketMetadata::RemoveAtStart (uint32_t start)
 {
-  NS_LOG_FUNCTION (this << start);
-  NS_ASSERT (IsStateOk ());
-  if (!m_enable) 
+  if (!m_enable)
     {
-      m_metadataSkipped = true;
+      SkipMetadata ();
       return;
     }
-  NS_ASSERT (m_data != 0);
+  NS_LOG_FUNCTION (this << start);
+  NS_ASSERT (IsStateOk ());
   uint32_t leftToRemove = start;
   uint16_t current = m_head;
   while (current != 0xffff && leftToRemove > 0)
@@ -951,14 +960,13 @@ PacketMetadata::RemoveAtStart (uint32_t start)
 void 
 PacketMetadata::RemoveAtEnd (uint32_t end)
 {
-  NS_LOG_FUNCTION (this << end);
-  NS_ASSERT (IsStateOk ());
-  if (!m_enable) 
+  if (!m_enable)
     {
-      m_metadataSkipped = true;
+      SkipMetadata ();
       return;
     }
-  NS_ASSERT (m_data != 0);
+  NS_LOG_FUNCTION (this << end);
+  NS_ASSERT (IsStateOk ());
 
   uint32_t leftToRemove = end;
   uint16_t current = m_tail;
@@ -20,7 +20,7 @@
 
 /**
 \file   packet-tag-list.cc
-\brief  Implements a linked list of Packet tags, including copy-on-write semantics.
+\brief  Implements a list of Packet tags, stored inline or in a linked list with copy-on-write semantics.
 */
 
 #include "packet-tag-list.h"
@@ -172,9 +172,38 @@ PacketTagList::COWTraverse (Tag & tag, PacketTagList::COWWriter Writer)
 
 }
 
+uint32_t
+PacketTagList::FindInline (TypeId tid) const
+{
+  for (uint32_t i = 0; i < m_nInline; i++)
+    {
+      if (m_inline[i].tid == tid)
+        {
+          return i;
+        }
+    }
+  return INLINE_TAGS;
+}
+
+void
+PacketTagList::RemoveInline (uint32_t i)
+{
+  NS_ASSERT (i < m_nInline);
+  m_nInline--;
+  std::copy (m_inline + i + 1, m_inline + m_nInline + 1, m_inline + i);
+}
+
 bool
 PacketTagList::Remove (Tag & tag)
 {
+  uint32_t i = FindInline (tag.GetInstanceTypeId ());
+  if (i < INLINE_TAGS)
+    {
+      NS_LOG_INFO ("found inline tag " << i);
+      tag.Deserialize (TagBuffer (m_inline[i].data, m_inline[i].data + m_inline[i].size));
+      RemoveInline (i);
+      return true;
+    }
   return COWTraverse (tag, &PacketTagList::RemoveWriter);
 }
 
@@ -214,6 +243,24 @@ PacketTagList::RemoveWriter (Tag & tag, bool preMerge,
 bool
 PacketTagList::Replace (Tag & tag)
 {
+  uint32_t i = FindInline (tag.GetInstanceTypeId ());
+  if (i < INLINE_TAGS)
+    {
+      uint32_t size = tag.GetSerializedSize ();
+      if (size <= INLINE_TAG_SIZE)
+        {
+          NS_LOG_INFO ("found inline tag " << i << ", rewriting it");
+          m_inline[i].size = size;
+          tag.Serialize (TagBuffer (m_inline[i].data, m_inline[i].data + size));
+        }
+      else
+        {
+          // The new value no longer fits inline
+          RemoveInline (i);
+          Add (tag);
+        }
+      return true;
+    }
   bool found = COWTraverse (tag, &PacketTagList::ReplaceWriter);
   if (!found)
     {
@@ -259,17 +306,30 @@ PacketTagList::ReplaceWriter (Tag & tag, bool preMerge,
 void 
 PacketTagList::Add (const Tag &tag) const
 {
-  NS_LOG_FUNCTION (this << tag.GetInstanceTypeId ());
+  TypeId tid = tag.GetInstanceTypeId ();
+  NS_LOG_FUNCTION (this << tid);
   // ensure this id was not yet added
+  NS_ASSERT_MSG (FindInline (tid) == INLINE_TAGS,
+                 "Error: cannot add the same kind of tag twice.");
   for (struct TagData *cur = m_next; cur != 0; cur = cur->next) 
     {
-      NS_ASSERT_MSG (cur->tid != tag.GetInstanceTypeId (),
+      NS_ASSERT_MSG (cur->tid != tid,
                      "Error: cannot add the same kind of tag twice.");
     }
-  struct TagData * head = CreateTagData (tag.GetSerializedSize ());
+  uint32_t size = tag.GetSerializedSize ();
+  if (m_nInline < INLINE_TAGS && size <= INLINE_TAG_SIZE)
+    {
+      PacketTagList *list = const_cast<PacketTagList *> (this);
+      struct InlineTag &inlineTag = list->m_inline[list->m_nInline++];
+      inlineTag.tid = tid;
+      inlineTag.size = size;
+      tag.Serialize (TagBuffer (inlineTag.data, inlineTag.data + size));
+      return;
+    }
+  struct TagData * head = CreateTagData (size);
   head->count = 1;
   head->next = 0;
-  head->tid = tag.GetInstanceTypeId ();
+  head->tid = tid;
   head->next = m_next;
   tag.Serialize (TagBuffer (head->data, head->data + head->size));
 
@@ -281,6 +341,13 @@ PacketTagList::Peek (Tag &tag) const
 {
   NS_LOG_FUNCTION (this << tag.GetInstanceTypeId ());
   TypeId tid = tag.GetInstanceTypeId ();
+  uint32_t i = FindInline (tid);
+  if (i < INLINE_TAGS)
+    {
+      tag.Deserialize (TagBuffer (const_cast<uint8_t *> (m_inline[i].data),
+                                  const_cast<uint8_t *> (m_inline[i].data) + m_inline[i].size));
+      return true;
+    }
   for (struct TagData *cur = m_next; cur != 0; cur = cur->next) 
     {
       if (cur->tid == tid) 
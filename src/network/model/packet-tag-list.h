@@ -22,10 +22,11 @@
 
 /**
 \file   packet-tag-list.h
-\brief  Defines a linked list of Packet tags, including copy-on-write semantics.
+\brief  Defines a list of Packet tags, stored inline or in a linked list with copy-on-write semantics.
 */
 
 #include <stdint.h>
+#include <algorithm>
 #include <ostream>
 #include "ns3/type-id.h"
 
@@ -119,6 +120,16 @@ class Tag;
  *       The portion of the list between the first branch and the target is
  *       shared. This portion is copied before the #Remove or #Replace is
  *       performed.
+ *
+ * \par <b> Inline tags </b>
+ *
+ *   - The first #INLINE_TAGS tags whose serialized size is at most
+ *     #INLINE_TAG_SIZE bytes are stored in the PacketTagList itself,
+ *     as \ref InlineTag, rather than in the tree, so that the few small
+ *     tags carried by most packets need no allocation.  They are
+ *     copied with the PacketTagList.
+ *
+ *   - The other tags are stored in the tree described above.
  */
 class PacketTagList 
 {
@@ -147,6 +158,23 @@ public:
     uint8_t data[1];            /**< Serialization buffer */
   };  /* struct TagData */
 
+  /** Maximum number of tags stored in the PacketTagList itself. */
+  static const uint32_t INLINE_TAGS = 5;
+  /** Maximum serialized size of the tags stored in the PacketTagList itself. */
+  static const uint32_t INLINE_TAG_SIZE = 20;
+
+  /**
+   * A tag stored in the PacketTagList itself.
+   *
+   * See PacketTagList for a discussion of the data structure.
+   */
+  struct InlineTag
+  {
+    TypeId tid;                     /**< Type of the tag serialized into #data */
+    uint8_t size;                   /**< Size of the serialized tag */
+    uint8_t data[INLINE_TAG_SIZE];  /**< Serialization buffer */
+  };  /* struct InlineTag */
+
   /**
    * Create a new PacketTagList.
    */
@@ -157,7 +185,8 @@ public:
    * \param [in] o The PacketTagList to copy.
    *
    * This makes a light-weight copy by #RemoveAll, then
-   * pointing to the same \ref TagData as \pname{o}.
+   * pointing to the same \ref TagData as \pname{o}, and
+   * copying its inline tags.
    */
   inline PacketTagList (PacketTagList const &o);
   /**
@@ -167,7 +196,8 @@ public:
    * \returns the copied object
    *
    * This makes a light-weight copy by #RemoveAll, then
-   * pointing to the same \ref TagData as \pname{o}.
+   * pointing to the same \ref TagData as \pname{o}, and
+   * copying its inline tags.
    */
   inline PacketTagList &operator = (PacketTagList const &o);
   /**
@@ -178,7 +208,7 @@ public:
   inline ~PacketTagList ();
 
   /**
-   * Add a tag to the head of this branch.
+   * Add a tag inline, or to the head of this branch.
    *
    * \param [in] tag The tag to add
    */
@@ -214,9 +244,18 @@ public:
    */
   inline void RemoveAll (void);
   /**
-   * \returns pointer to head of tag list
+   * \returns pointer to head of tag list, without the inline tags
    */
   const struct PacketTagList::TagData *Head (void) const;
+  /**
+   * \returns The number of tags stored in the PacketTagList itself.
+   */
+  inline uint32_t GetNInlineTags (void) const;
+  /**
+   * \param [in] i The index of the tag, from the oldest one.
+   * \returns A tag stored in the PacketTagList itself.
+   */
+  inline const struct InlineTag &GetInlineTag (uint32_t i) const;
 
 private:
   /**
@@ -278,6 +317,28 @@ private:
   bool ReplaceWriter (Tag & tag, bool preMerge,
                       struct TagData * cur, struct TagData ** prevNext);
 
+  /**
+   * Find an inline tag.
+   *
+   * \param [in] tid The type of the tag.
+   * \returns The index of the tag, or #INLINE_TAGS if it is not inline.
+   */
+  uint32_t FindInline (TypeId tid) const;
+  /**
+   * Remove an inline tag, keeping the order of the others.
+   *
+   * \param [in] i The index of the tag.
+   */
+  void RemoveInline (uint32_t i);
+
+  /**
+   * The tags stored in the PacketTagList itself, from the oldest one
+   */
+  struct InlineTag m_inline[INLINE_TAGS];
+  /**
+   * Number of tags in #m_inline
+   */
+  uint8_t m_nInline;
   /**
    * Pointer to first \ref TagData on the list
    */
@@ -293,13 +354,16 @@ private:
 namespace ns3 {
 
 PacketTagList::PacketTagList ()
-  : m_next ()
+  : m_nInline (0),
+    m_next ()
 {
 }
 
 PacketTagList::PacketTagList (PacketTagList const &o)
-  : m_next (o.m_next)
+  : m_nInline (o.m_nInline),
+    m_next (o.m_next)
 {
+  std::copy (o.m_inline, o.m_inline + m_nInline, m_inline);
   if (m_next != 0)
     {
       m_next->count++;
@@ -310,16 +374,21 @@ PacketTagList &
 PacketTagList::operator = (PacketTagList const &o)
 {
   // self assignment
-  if (m_next == o.m_next) 
+  if (this == &o)
     {
       return *this;
     }
-  RemoveAll ();
-  m_next = o.m_next;
-  if (m_next != 0) 
+  if (m_next != o.m_next)
     {
-      m_next->count++;
+      RemoveAll ();
+      m_next = o.m_next;
+      if (m_next != 0) 
+        {
+          m_next->count++;
+        }
     }
+  m_nInline = o.m_nInline;
+  std::copy (o.m_inline, o.m_inline + m_nInline, m_inline);
   return *this;
 }
 
@@ -331,6 +400,7 @@ PacketTagList::~PacketTagList ()
 void
 PacketTagList::RemoveAll (void)
 {
+  m_nInline = 0;
   struct TagData *prev = 0;
   for (struct TagData *cur = m_next; cur != 0; cur = cur->next)
     {
@@ -354,6 +424,18 @@ PacketTagList::RemoveAll (void)
   m_next = 0;
 }
 
+uint32_t
+PacketTagList::GetNInlineTags (void) const
+{
+  return m_nInline;
+}
+
+const struct PacketTagList::InlineTag &
+PacketTagList::GetInlineTag (uint32_t i) const
+{
+  return m_inline[i];
+}
+
 } // namespace ns3
 
 #endif /* PACKET_TAG_LIST_H */
@@ -361,6 +361,88 @@ BufferTest::DoRun (void)
   NS_TEST_ASSERT_MSG_EQ (val1, val2, "Bad ReadNtohU16()");
 }
 //-----------------------------------------------------------------------------
+class BufferZeroAreaTest : public TestCase {
+private:
+  void CheckContent (Buffer b, uint32_t size, const char *file, int line);
+public:
+  virtual void DoRun (void);
+  BufferZeroAreaTest ();
+};
+
+BufferZeroAreaTest::BufferZeroAreaTest ()
+  : TestCase ("Buffer fragments keep their zero area when merged") {
+}
+
+/**
+ * Check a buffer of 0xaa 0xbb, zeros, and 0xcc.
+ */
+void
+BufferZeroAreaTest::CheckContent (Buffer b, uint32_t size, const char *file, int line)
+{
+  NS_TEST_ASSERT_MSG_EQ_INTERNAL (b.GetSize (), size, "Bad size", file, line);
+  Buffer::Iterator i = b.Begin ();
+  uint16_t first = i.ReadU8 ();
+  uint16_t second = i.ReadU8 ();
+  uint32_t nonZero = 0;
+  for (uint32_t j = 2; j < size - 1; j++)
+    {
+      if (i.ReadU8 () != 0)
+        {
+          nonZero++;
+        }
+    }
+  uint16_t last = i.ReadU8 ();
+  NS_TEST_ASSERT_MSG_EQ_INTERNAL (first, 0xaa, "Bad first byte", file, line);
+  NS_TEST_ASSERT_MSG_EQ_INTERNAL (second, 0xbb, "Bad second byte", file, line);
+  NS_TEST_ASSERT_MSG_EQ_INTERNAL (nonZero, 0, "Bad zero area", file, line);
+  NS_TEST_ASSERT_MSG_EQ_INTERNAL (last, 0xcc, "Bad last byte", file, line);
+}
+
+#define CHECK_CONTENT(buffer, size)                      \
+  CheckContent (buffer, size, __FILE__, __LINE__)
+
+void
+BufferZeroAreaTest::DoRun (void)
+{
+  // A payload of zeros between a header and a trailer
+  Buffer payload (100000);
+  payload.AddAtStart (2);
+  Buffer::Iterator i = payload.Begin ();
+  i.WriteU8 (0xaa);
+  i.WriteU8 (0xbb);
+  payload.AddAtEnd (1);
+  i = payload.End ();
+  i.Prev ();
+  i.WriteU8 (0xcc);
+  CHECK_CONTENT (payload, 100003);
+  uint32_t serializedSize = payload.GetSerializedSize ();
+  NS_TEST_ASSERT_MSG_LT (serializedSize, 100, "The zero area is not virtual");
+
+  // Two fragments sharing the data of the payload
+  Buffer merged = payload.CreateFragment (0, 40000);
+  Buffer end = payload.CreateFragment (40000, 60003);
+  merged.AddAtEnd (end);
+  CHECK_CONTENT (merged, 100003);
+  NS_TEST_ASSERT_MSG_LT_OR_EQ (merged.GetSerializedSize (), serializedSize,
+                               "The merged zero area is not virtual");
+
+  // Many fragments appended one by one, as in the TCP buffers
+  merged = Buffer ();
+  for (uint32_t start = 0; start < payload.GetSize (); start += 1000)
+    {
+      uint32_t length = std::min<uint32_t> (1000, payload.GetSize () - start);
+      merged.AddAtEnd (payload.CreateFragment (start, length));
+      NS_TEST_ASSERT_MSG_LT_OR_EQ (merged.GetSerializedSize (), serializedSize,
+                                   "The merged zero area is not virtual");
+    }
+  CHECK_CONTENT (merged, 100003);
+
+  // Writing in the merged buffer does not change the payload
+  i = merged.Begin ();
+  i.WriteU8 (0x11);
+  CHECK_CONTENT (payload, 100003);
+}
+//-----------------------------------------------------------------------------
 class BufferTestSuite : public TestSuite
 {
 public:
@@ -371,6 +453,7 @@ BufferTestSuite::BufferTestSuite ()
   : TestSuite ("buffer", UNIT)
 {
   AddTestCase (new BufferTest, TestCase::QUICK);
+  AddTestCase (new BufferZeroAreaTest, TestCase::QUICK);
 }
 
 static BufferTestSuite g_bufferTestSuite;
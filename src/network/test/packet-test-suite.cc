@@ -19,8 +19,13 @@
  */
 #include "ns3/packet.h"
 #include "ns3/packet-tag-list.h"
+#include "ns3/packet-metadata.h"
+#include "ns3/byte-tag-list.h"
+#include "ns3/system-thread.h"
 #include "ns3/test.h"
 #include "ns3/unused.h"
+#include <atomic>
+#include <set>
 #include <limits>     // std:numeric_limits
 #include <string>
 #include <cstdarg>
@@ -911,6 +916,328 @@ PacketTagListTest::DoRun (void)
     
 }
 
+//-----------------------------------------------------------------------------
+/**
+ * Check the packet tags stored in the PacketTagList itself, and their
+ * mix with the tags stored in its linked list.
+ */
+class PacketTagListInlineTest : public TestCase
+{
+public:
+  PacketTagListInlineTest ();
+private:
+  void DoRun (void);
+  /**
+   * Check the tags of a packet through its PacketTagIterator.
+   * \param p The packet.
+   * \param n The number of tags expected.
+   * \param msg The message of the failures.
+   */
+  void CheckIterator (Ptr<const Packet> p, uint32_t n, const char *msg);
+  /**
+   * Check the value of a tag.
+   * \param list The tags.
+   * \param tag The tag type to find.
+   * \param data The value expected.
+   * \param msg The message of the failures.
+   */
+  void CheckTag (const PacketTagList &list, ATestTagBase &tag, int data, const char *msg);
+};
+
+PacketTagListInlineTest::PacketTagListInlineTest ()
+  : TestCase ("Check the inline packet tags")
+{
+}
+
+void
+PacketTagListInlineTest::CheckIterator (Ptr<const Packet> p, uint32_t n, const char *msg)
+{
+  std::set<TypeId> found;
+  PacketTagIterator i = p->GetPacketTagIterator ();
+  while (i.HasNext ())
+    {
+      PacketTagIterator::Item item = i.Next ();
+      NS_TEST_EXPECT_MSG_EQ (found.insert (item.GetTypeId ()).second, true,
+                             msg << ": tag " << item.GetTypeId ().GetName () << " seen twice");
+      Callback<ObjectBase *> constructor = item.GetTypeId ().GetConstructor ();
+      ATestTagBase *tag = dynamic_cast<ATestTagBase *> (constructor ());
+      item.GetTag (*tag);
+      bool error = tag->m_error;
+      int data = tag->GetData ();
+      delete tag;
+      NS_TEST_EXPECT_MSG_EQ (error, false, msg << ": wrong tag " << item.GetTypeId ().GetName ());
+      NS_TEST_EXPECT_MSG_EQ (data, 1, msg << ": wrong tag " << item.GetTypeId ().GetName ());
+    }
+  uint32_t size = found.size ();
+  NS_TEST_EXPECT_MSG_EQ (size, n, msg << ": wrong number of tags");
+}
+
+void
+PacketTagListInlineTest::CheckTag (const PacketTagList &list, ATestTagBase &tag, int data, const char *msg)
+{
+  bool found = list.Peek (tag);
+  NS_TEST_EXPECT_MSG_EQ (found, true, msg << ": " << tag.GetInstanceTypeId ().GetName () << " not found");
+  NS_TEST_EXPECT_MSG_EQ (tag.m_error, false, msg << ": " << tag.GetInstanceTypeId ().GetName () << " corrupted");
+  int actual = tag.GetData ();
+  NS_TEST_EXPECT_MSG_EQ (actual, data, msg << ": " << tag.GetInstanceTypeId ().GetName () << " wrong");
+}
+
+void
+PacketTagListInlineTest::DoRun (void)
+{
+  // Five small tags, inline, then a small and two large tags in the list
+  MAKE_TEST_TAGS ;
+  ATestTag<30> l1 (1);
+  ATestTag<40> l2 (1);
+  uint32_t inlineTags = PacketTagList::INLINE_TAGS;
+  uint32_t inlineTagSize = PacketTagList::INLINE_TAG_SIZE;
+  NS_TEST_ASSERT_MSG_LT_OR_EQ (t7.GetSerializedSize (), inlineTagSize, "Tag too large to be inline");
+  NS_TEST_ASSERT_MSG_GT (l1.GetSerializedSize (), inlineTagSize, "Tag small enough to be inline");
+
+  PacketTagList ref;
+  ref.Add (t1);
+  ref.Add (l1);
+  ref.Add (t2);
+  ref.Add (t3);
+  ref.Add (t4);
+  ref.Add (t5);
+  ref.Add (t6);
+  ref.Add (l2);
+  uint32_t nInline = ref.GetNInlineTags ();
+  NS_TEST_EXPECT_MSG_EQ (nInline, inlineTags, "Wrong number of inline tags");
+
+  // Copy, and remove an inline tag and a listed tag from the copy
+  PacketTagList copy = ref;
+  ATestTag<3> r3;
+  ATestTag<30> rl1;
+  NS_TEST_EXPECT_MSG_EQ (copy.Remove (r3), true, "Inline tag not removed");
+  NS_TEST_EXPECT_MSG_EQ (r3.GetData (), 1, "Wrong removed inline tag");
+  NS_TEST_EXPECT_MSG_EQ (copy.Remove (rl1), true, "Listed tag not removed");
+  NS_TEST_EXPECT_MSG_EQ (rl1.GetData (), 1, "Wrong removed listed tag");
+  NS_TEST_EXPECT_MSG_EQ (copy.Peek (r3), false, "Inline tag still there");
+  NS_TEST_EXPECT_MSG_EQ (copy.Peek (rl1), false, "Listed tag still there");
+  NS_TEST_EXPECT_MSG_EQ (ref.Peek (r3), true, "Inline tag removed from the original");
+  NS_TEST_EXPECT_MSG_EQ (ref.Peek (rl1), true, "Listed tag removed from the original");
+
+  // The next small tag is inline again
+  copy.Add (t7);
+  nInline = copy.GetNInlineTags ();
+  NS_TEST_EXPECT_MSG_EQ (nInline, inlineTags, "Tag not inline");
+
+  // Replace an inline tag in the copy
+  ATestTag<2> n2 (2);
+  NS_TEST_EXPECT_MSG_EQ (copy.Replace (n2), true, "Inline tag not replaced");
+  CheckTag (copy, n2, 2, "replaced inline tag");
+  CheckTag (ref, t2, 1, "original of the replaced inline tag");
+
+  // Assign over a list holding other tags
+  PacketTagList other;
+  other.Add (l1);
+  other.Add (t1);
+  other = copy;
+  CheckTag (other, n2, 2, "assigned inline tag");
+  CheckTag (other, t7, 1, "assigned inline tag");
+  CheckTag (other, l2, 1, "assigned listed tag");
+  NS_TEST_EXPECT_MSG_EQ (other.Peek (rl1), false, "Listed tag not removed by the assignment");
+
+  // The tags of a packet, through its iterator
+  Ptr<Packet> p = Create<Packet> (10);
+  p->AddPacketTag (t1);
+  p->AddPacketTag (l1);
+  p->AddPacketTag (t2);
+  CheckIterator (p, 3, "packet with inline and listed tags");
+  p->AddPacketTag (t3);
+  p->AddPacketTag (t4);
+  p->AddPacketTag (t5);
+  p->AddPacketTag (t6);
+  p->AddPacketTag (t7);
+  p->AddPacketTag (l2);
+  Ptr<Packet> q = p->Copy ();
+  q->RemovePacketTag (t4);
+  CheckIterator (p, 9, "packet with all the tags");
+  CheckIterator (q, 8, "copy of the packet");
+  q->RemoveAllPacketTags ();
+  CheckIterator (q, 0, "packet without tags");
+}
+
+//-----------------------------------------------------------------------------
+/**
+ * Check the reuse of the data of the packets, in one thread and
+ * between threads.
+ *
+ * Each check runs in new threads, whose free lists are not affected
+ * by the other tests.
+ */
+class PacketFreeListTest : public TestCase
+{
+public:
+  PacketFreeListTest ();
+private:
+  void DoRun (void);
+  /**
+   * Create packets with a header and a byte tag.
+   * \param packets The packets.
+   * \param n The number of packets.
+   */
+  static void Produce (std::vector<Ptr<Packet> > *packets, uint32_t n);
+  /**
+   * Check the packets created by Produce.
+   * \param packets The packets.
+   * \returns The number of wrong packets.
+   */
+  static uint32_t Check (const std::vector<Ptr<Packet> > &packets);
+  /**
+   * Run a method in a new thread.
+   * \param method The method.
+   */
+  void RunThread (void (PacketFreeListTest::*method)(void));
+  /** Create and destroy packets, and read the counters. */
+  void ReuseThread (void);
+  /** Create packets, and read the counters. */
+  void ProducerThread (void);
+  /** Check and destroy the packets of ProducerThread, and read the counters. */
+  void ConsumerThread (void);
+  /** Create, check and destroy packets. */
+  void WorkerThread (void);
+
+  DataFreeListStats m_buffer;            //!< The buffer counters of ReuseThread
+  DataFreeListStats m_metadata;          //!< The metadata counters of ReuseThread
+  DataFreeListStats m_tags;              //!< The byte tag counters of ReuseThread
+  std::vector<Ptr<Packet> > m_packets;   //!< The packets of ProducerThread
+  DataFreeListStats m_producer;          //!< The buffer counters of ProducerThread
+  DataFreeListStats m_consumer;          //!< The buffer counters of ConsumerThread
+  std::atomic<uint32_t> m_errors;        //!< Wrong packets
+};
+
+PacketFreeListTest::PacketFreeListTest ()
+  : TestCase ("Check the free lists of the packet data")
+{
+}
+
+void
+PacketFreeListTest::Produce (std::vector<Ptr<Packet> > *packets, uint32_t n)
+{
+  for (uint32_t i = 0; i < n; i++)
+    {
+      Ptr<Packet> p = Create<Packet> (1000);
+      p->AddHeader (ATestHeader<20> ());
+      p->AddByteTag (ATestTag<4> (i % 256));
+      packets->push_back (p);
+    }
+}
+
+uint32_t
+PacketFreeListTest::Check (const std::vector<Ptr<Packet> > &packets)
+{
+  uint32_t errors = 0;
+  for (uint32_t i = 0; i < packets.size (); i++)
+    {
+      Ptr<Packet> p = packets[i]->Copy ();
+      ATestHeader<20> header;
+      ATestTag<4> tag;
+      p->RemoveHeader (header);
+      if (header.m_error || p->GetSize () != 1000
+          || !p->FindFirstMatchingByteTag (tag) || tag.m_error || tag.m_data != i % 256)
+        {
+          errors++;
+        }
+    }
+  return errors;
+}
+
+void
+PacketFreeListTest::RunThread (void (PacketFreeListTest::*method)(void))
+{
+  Ptr<SystemThread> thread = Create<SystemThread> (MakeCallback (method, this));
+  thread->Start ();
+  thread->Join ();
+}
+
+void
+PacketFreeListTest::ReuseThread (void)
+{
+  std::vector<Ptr<Packet> > packets;
+  for (uint32_t i = 0; i < 100; i++)
+    {
+      Produce (&packets, 10);
+      m_errors += Check (packets);
+      packets.clear ();
+    }
+  m_buffer = Buffer::GetFreeListStats ();
+  m_metadata = PacketMetadata::GetFreeListStats ();
+  m_tags = ByteTagList::GetFreeListStats ();
+}
+
+void
+PacketFreeListTest::ProducerThread (void)
+{
+  Produce (&m_packets, 1000);
+  m_producer = Buffer::GetFreeListStats ();
+}
+
+void
+PacketFreeListTest::ConsumerThread (void)
+{
+  m_errors += Check (m_packets);
+  m_packets.clear ();
+  m_consumer = Buffer::GetFreeListStats ();
+}
+
+void
+PacketFreeListTest::WorkerThread (void)
+{
+  for (uint32_t round = 0; round < 20; round++)
+    {
+      std::vector<Ptr<Packet> > packets;
+      Produce (&packets, 500);
+      m_errors += Check (packets);
+    }
+}
+
+void
+PacketFreeListTest::DoRun (void)
+{
+  // Register the types, and create the simulator, in the main thread
+  std::vector<Ptr<Packet> > packets;
+  Produce (&packets, 1);
+  packets.clear ();
+  m_errors = 0;
+
+  // The data of the packets destroyed are reused by the next ones
+  RunThread (&PacketFreeListTest::ReuseThread);
+  NS_TEST_EXPECT_MSG_GT_OR_EQ (m_buffer.allocations, 1000, "Buffer data not counted");
+  NS_TEST_EXPECT_MSG_GT_OR_EQ (m_buffer.hits, 990, "Buffer data not reused");
+  // The metadata is not enabled, and needs no storage
+  NS_TEST_EXPECT_MSG_EQ (m_metadata.allocations, 0, "Metadata storage allocated");
+  NS_TEST_EXPECT_MSG_GT_OR_EQ (m_tags.hits, 990, "Byte tags not reused");
+
+  // The data of the packets created by a thread, and destroyed by
+  // another one, go back to the next thread through the global depot
+  RunThread (&PacketFreeListTest::ProducerThread);
+  RunThread (&PacketFreeListTest::ConsumerThread);
+  NS_TEST_EXPECT_MSG_GT (m_consumer.toDepot, 0, "No buffer data moved to the depot");
+  RunThread (&PacketFreeListTest::ProducerThread);
+  NS_TEST_EXPECT_MSG_GT (m_producer.fromDepot, 0, "No buffer data taken from the depot");
+  NS_TEST_EXPECT_MSG_GT (m_producer.hits, 0, "No buffer data reused by another thread");
+  RunThread (&PacketFreeListTest::ConsumerThread);
+
+  // Threads creating and destroying packets at once
+  std::vector<Ptr<SystemThread> > workers;
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      workers.push_back (Create<SystemThread> (MakeCallback (&PacketFreeListTest::WorkerThread, this)));
+    }
+  for (uint32_t i = 0; i < workers.size (); i++)
+    {
+      workers[i]->Start ();
+    }
+  for (uint32_t i = 0; i < workers.size (); i++)
+    {
+      workers[i]->Join ();
+    }
+  NS_TEST_EXPECT_MSG_EQ (m_errors, 0, "Wrong packets");
+}
+
 //-----------------------------------------------------------------------------
 class PacketTestSuite : public TestSuite
 {
@@ -923,6 +1250,8 @@ PacketTestSuite::PacketTestSuite ()
 {
   AddTestCase (new PacketTest, TestCase::QUICK);
   AddTestCase (new PacketTagListTest, TestCase::QUICK);
+  AddTestCase (new PacketTagListInlineTest, TestCase::QUICK);
+  AddTestCase (new PacketFreeListTest, TestCase::QUICK);
 }
 
 static PacketTestSuite g_packetTestSuite;
@@ -20,9 +20,13 @@
 #include "point-to-point-net-device.h"
 #include "ns3/trace-source-accessor.h"
 #include "ns3/packet.h"
+#include "ns3/node.h"
 #include "ns3/simulator.h"
+#include "ns3/simulator-impl.h"
 #include "ns3/log.h"
 
+#include <vector>
+
 namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("PointToPointChannel");
@@ -80,6 +84,20 @@ PointToPointChannel::Attach (Ptr<PointToPointNetDevice> device)
       m_link[1].m_dst = m_link[0].m_src;
       m_link[0].m_state = IDLE;
       m_link[1].m_state = IDLE;
+      // Only the MultithreadedSimulatorImpl runs the system ids on
+      // different threads
+      bool multithreaded = Simulator::GetImplementation ()->GetInstanceTypeId ().GetName ()
+        == "ns3::MultithreadedSimulatorImpl";
+      for (uint32_t i = 0; i < N_DEVICES; i++)
+        {
+          Ptr<Node> src = m_link[i].m_src->GetNode ();
+          Ptr<Node> dst = m_link[i].m_dst->GetNode ();
+          if (src != 0 && dst != 0)
+            {
+              m_link[i].m_dstNodeId = dst->GetId ();
+              m_link[i].m_crossPartition = multithreaded && src->GetSystemId () != dst->GetSystemId ();
+            }
+        }
     }
 }
 
@@ -97,8 +115,30 @@ PointToPointChannel::TransmitStart (
 
   uint32_t wire = src == m_link[0].m_src ? 0 : 1;
 
-  Simulator::ScheduleWithContext (m_link[wire].m_dst->GetNode ()->GetId (),
-                                  txTime + m_delay, &PointToPointNetDevice::Receive,
+  uint32_t context = m_link[wire].m_dstNodeId;
+  if (context == 0xffffffff)
+    {
+      context = m_link[wire].m_dst->GetNode ()->GetId ();
+    }
+  if (m_link[wire].m_crossPartition)
+    {
+      // The receiver runs on another thread: it gets a copy of the
+      // packet sharing no buffer, and nothing reference counted of the
+      // sender
+      uint32_t size = p->GetSerializedSize ();
+      std::vector<uint8_t> buffer (size);
+      p->Serialize (&buffer[0], size);
+      Simulator::ScheduleWithContext (context, txTime + m_delay,
+                                      &PointToPointNetDevice::Receive,
+                                      PeekPointer (m_link[wire].m_dst),
+                                      Create<Packet> (&buffer[0], size, true));
+      // As with the remote channel, no animation trace, which would
+      // reference the receiving device
+      return true;
+    }
+
+  Simulator::ScheduleWithContext (context, txTime + m_delay,
+                                  &PointToPointNetDevice::Receive,
                                   m_link[wire].m_dst, p);
 
   // Call the tx anim callback on the net device
@@ -159,6 +159,9 @@ private:
    * net device, receiving net device, transmission time and 
    * packet receipt time.
    *
+   * It is not fired for the links between nodes of different system ids
+   * with the MultithreadedSimulatorImpl.
+   *
    * \see class CallBackTraceSource
    * \deprecated The non-const \c Ptr<NetDevice> argument is deprecated
    * and will be changed to \c Ptr<const NetDevice> in a future release.
@@ -194,11 +197,14 @@ public:
     /** \brief Create the link, it will be in INITIALIZING state
      *
      */
-    Link() : m_state (INITIALIZING), m_src (0), m_dst (0) {}
+    Link() : m_state (INITIALIZING), m_src (0), m_dst (0),
+             m_dstNodeId (0xffffffff), m_crossPartition (false) {}
 
     WireState                  m_state; //!< State of the link
     Ptr<PointToPointNetDevice> m_src;   //!< First NetDevice
     Ptr<PointToPointNetDevice> m_dst;   //!< Second NetDevice
+    uint32_t                   m_dstNodeId; //!< Id of the node of m_dst, if known at Attach
+    bool                       m_crossPartition; //!< The nodes run on different threads of the MultithreadedSimulatorImpl
   };
 
   Link    m_link[N_DEVICES]; //!< Link model
@@ -23,6 +23,14 @@
 #include "ns3/simulator.h"
 #include "ns3/point-to-point-net-device.h"
 #include "ns3/point-to-point-channel.h"
+#include "ns3/node.h"
+#include "ns3/config.h"
+#include "ns3/string.h"
+#include "ns3/uinteger.h"
+#include "ns3/data-rate.h"
+
+#include <set>
+#include <vector>
 
 using namespace ns3;
 
@@ -100,6 +108,280 @@ PointToPointTest::DoRun (void)
   Simulator::Destroy ();
 }
 
+/**
+ * \brief Test class for the links between nodes of different system ids
+ * with the DefaultSimulatorImpl
+ *
+ * The packets are delivered as between nodes of the same system id, and
+ * the TxRxPointToPoint trace source is fired.
+ */
+class PointToPointSystemIdTest : public TestCase
+{
+public:
+  /**
+   * \brief Create the test
+   */
+  PointToPointSystemIdTest ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \brief Send one packet to the device specified
+   *
+   * \param device NetDevice to send to
+   */
+  void SendOnePacket (Ptr<PointToPointNetDevice> device);
+
+  /**
+   * \brief The TxRxPointToPoint trace sink
+   *
+   * \param packet The packet
+   * \param txDevice The transmitting device
+   * \param rxDevice The receiving device
+   * \param duration The transmission time
+   * \param lastBitTime The reception time of the last bit
+   */
+  void TxRx (Ptr<const Packet> packet, Ptr<NetDevice> txDevice, Ptr<NetDevice> rxDevice,
+             Time duration, Time lastBitTime);
+
+  /**
+   * \brief Receive a packet
+   *
+   * \param device The receiving device
+   * \param packet The packet
+   * \param protocol The protocol number
+   * \param from The sender address
+   * \return true
+   */
+  bool Receive (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol, const Address &from);
+
+  Ptr<const Packet> m_sent;     //!< The packet sent
+  Ptr<const Packet> m_traced;   //!< The packet of the trace source
+  Ptr<const Packet> m_received; //!< The packet received
+};
+
+PointToPointSystemIdTest::PointToPointSystemIdTest ()
+  : TestCase ("PointToPoint link between system ids with the DefaultSimulatorImpl")
+{
+}
+
+void
+PointToPointSystemIdTest::SendOnePacket (Ptr<PointToPointNetDevice> device)
+{
+  Ptr<Packet> p = Create<Packet> (100);
+  m_sent = p;
+  device->Send (p, device->GetBroadcast (), 0x800);
+}
+
+void
+PointToPointSystemIdTest::TxRx (Ptr<const Packet> packet, Ptr<NetDevice> txDevice, Ptr<NetDevice> rxDevice,
+                                Time duration, Time lastBitTime)
+{
+  m_traced = packet;
+}
+
+bool
+PointToPointSystemIdTest::Receive (Ptr<NetDevice> device, Ptr<const Packet> packet,
+                                   uint16_t protocol, const Address &from)
+{
+  m_received = packet;
+  return true;
+}
+
+void
+PointToPointSystemIdTest::DoRun (void)
+{
+  Ptr<Node> a = CreateObject<Node> (0);
+  Ptr<Node> b = CreateObject<Node> (1);
+  Ptr<PointToPointNetDevice> devA = CreateObject<PointToPointNetDevice> ();
+  Ptr<PointToPointNetDevice> devB = CreateObject<PointToPointNetDevice> ();
+  Ptr<PointToPointChannel> channel = CreateObject<PointToPointChannel> ();
+  channel->TraceConnectWithoutContext ("TxRxPointToPoint", MakeCallback (&PointToPointSystemIdTest::TxRx, this));
+
+  devA->SetAddress (Mac48Address::Allocate ());
+  devA->SetQueue (CreateObject<DropTailQueue> ());
+  devB->SetAddress (Mac48Address::Allocate ());
+  devB->SetQueue (CreateObject<DropTailQueue> ());
+  a->AddDevice (devA);
+  b->AddDevice (devB);
+  devA->Attach (channel);
+  devB->Attach (channel);
+  devB->SetReceiveCallback (MakeCallback (&PointToPointSystemIdTest::Receive, this));
+
+  Ptr<NetDeviceQueueInterface> ifaceA = CreateObject<NetDeviceQueueInterface> ();
+  devA->AggregateObject (ifaceA);
+  ifaceA->CreateTxQueues ();
+  Ptr<NetDeviceQueueInterface> ifaceB = CreateObject<NetDeviceQueueInterface> ();
+  devB->AggregateObject (ifaceB);
+  ifaceB->CreateTxQueues ();
+
+  Simulator::Schedule (Seconds (1.0), &PointToPointSystemIdTest::SendOnePacket, this, devA);
+
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  NS_TEST_EXPECT_MSG_NE (m_traced, 0, "TxRxPointToPoint not fired");
+  NS_TEST_EXPECT_MSG_NE (m_received, 0, "Packet not received");
+  uint64_t sentUid = m_sent->GetUid ();
+  uint64_t receivedUid = m_received != 0 ? m_received->GetUid () : 0;
+  NS_TEST_EXPECT_MSG_EQ (receivedUid, sentUid, "Wrong packet received");
+  m_sent = 0;
+  m_traced = 0;
+  m_received = 0;
+}
+
+/**
+ * \brief Test class for the links between partitions of the
+ * MultithreadedSimulatorImpl
+ *
+ * The nodes of a ring, each in its own partition, send packets to both
+ * their neighbours while the partitions run on several threads.  Each
+ * packet must arrive once, and the packets created by the threads must
+ * have distinct uids.
+ */
+class PointToPointMultithreadedTest : public TestCase
+{
+public:
+  /**
+   * \brief Create the test
+   */
+  PointToPointMultithreadedTest ();
+
+private:
+  virtual void DoRun (void);
+  virtual void DoTeardown (void);
+
+  /**
+   * \brief Send a packet to each neighbour, and schedule the next ones
+   *
+   * \param node The sending node
+   * \param sequence The sequence number of the packets
+   */
+  void Send (uint32_t node, uint32_t sequence);
+
+  /**
+   * \brief Receive a packet
+   *
+   * \param device The receiving device
+   * \param packet The packet
+   * \param protocol The protocol number
+   * \param from The sender address
+   * \return true
+   */
+  bool Receive (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol, const Address &from);
+
+  /** The state of a node, only accessed by the events of the node. */
+  struct NodeState
+  {
+    std::vector<Ptr<PointToPointNetDevice> > m_devices; //!< The devices to the neighbours
+    std::vector<uint64_t> m_sent;  //!< The uids of the packets sent
+    uint32_t m_received;           //!< Number of packets received
+    uint64_t m_receivedBytes;      //!< Number of bytes received
+  };
+
+  std::vector<NodeState> m_nodes; //!< The state of the nodes
+  uint32_t m_packets;             //!< Number of packets sent to each neighbour
+};
+
+PointToPointMultithreadedTest::PointToPointMultithreadedTest ()
+  : TestCase ("PointToPoint links between the threads of the MultithreadedSimulatorImpl"),
+    m_packets (1000)
+{
+}
+
+void
+PointToPointMultithreadedTest::DoTeardown (void)
+{
+  Config::Reset ();
+}
+
+void
+PointToPointMultithreadedTest::Send (uint32_t node, uint32_t sequence)
+{
+  NodeState &state = m_nodes[node];
+  for (uint32_t i = 0; i < state.m_devices.size (); i++)
+    {
+      Ptr<Packet> p = Create<Packet> (100 + sequence % 50);
+      state.m_sent.push_back (p->GetUid ());
+      state.m_devices[i]->Send (p, state.m_devices[i]->GetBroadcast (), 0x800);
+    }
+  if (sequence + 1 < m_packets)
+    {
+      Simulator::Schedule (MicroSeconds (200), &PointToPointMultithreadedTest::Send, this, node, sequence + 1);
+    }
+}
+
+bool
+PointToPointMultithreadedTest::Receive (Ptr<NetDevice> device, Ptr<const Packet> packet,
+                                        uint16_t protocol, const Address &from)
+{
+  NodeState &state = m_nodes[device->GetNode ()->GetId ()];
+  state.m_received++;
+  state.m_receivedBytes += packet->GetSize ();
+  return true;
+}
+
+void
+PointToPointMultithreadedTest::DoRun (void)
+{
+  const uint32_t nNodes = 4;
+  Config::SetGlobal ("SimulatorImplementationType", StringValue ("ns3::MultithreadedSimulatorImpl"));
+  Config::SetDefault ("ns3::MultithreadedSimulatorImpl::MaxThreads", UintegerValue (nNodes));
+
+  std::vector<Ptr<Node> > nodes;
+  for (uint32_t i = 0; i < nNodes; i++)
+    {
+      nodes.push_back (CreateObject<Node> (i));
+    }
+  m_nodes.assign (nNodes, NodeState ());
+  for (uint32_t i = 0; i < nNodes; i++)
+    {
+      Ptr<PointToPointChannel> channel = CreateObject<PointToPointChannel> ();
+      channel->SetAttribute ("Delay", TimeValue (MilliSeconds (1)));
+      uint32_t ends[] = { i, (i + 1) % nNodes };
+      for (uint32_t j = 0; j < 2; j++)
+        {
+          Ptr<PointToPointNetDevice> device = CreateObject<PointToPointNetDevice> ();
+          device->SetAddress (Mac48Address::Allocate ());
+          device->SetAttribute ("DataRate", DataRateValue (DataRate ("10Mbps")));
+          device->SetQueue (CreateObject<DropTailQueue> ());
+          nodes[ends[j]]->AddDevice (device);
+          device->Attach (channel);
+          Ptr<NetDeviceQueueInterface> iface = CreateObject<NetDeviceQueueInterface> ();
+          device->AggregateObject (iface);
+          iface->CreateTxQueues ();
+          device->SetReceiveCallback (MakeCallback (&PointToPointMultithreadedTest::Receive, this));
+          m_nodes[ends[j]].m_devices.push_back (device);
+        }
+    }
+  for (uint32_t i = 0; i < nNodes; i++)
+    {
+      m_nodes[i].m_received = 0;
+      m_nodes[i].m_receivedBytes = 0;
+      Simulator::ScheduleWithContext (i, Seconds (0), &PointToPointMultithreadedTest::Send, this, i, 0);
+    }
+
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  uint64_t bytes = 0;
+  for (uint32_t i = 0; i < m_packets; i++)
+    {
+      bytes += 100 + i % 50;
+    }
+  std::set<uint64_t> uids;
+  for (uint32_t i = 0; i < nNodes; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_nodes[i].m_received, 2 * m_packets, "Wrong number of packets received by node " << i);
+      NS_TEST_EXPECT_MSG_EQ (m_nodes[i].m_receivedBytes, 2 * bytes, "Wrong number of bytes received by node " << i);
+      uids.insert (m_nodes[i].m_sent.begin (), m_nodes[i].m_sent.end ());
+    }
+  uint64_t sent = nNodes * 2 * m_packets;
+  NS_TEST_EXPECT_MSG_EQ (uids.size (), sent, "Packets created with the same uid");
+  m_nodes.clear ();
+}
+
 /**
  * \brief TestSuite for PointToPoint module
  */
@@ -116,6 +398,13 @@ PointToPointTestSuite::PointToPointTestSuite ()
   : TestSuite ("devices-point-to-point", UNIT)
 {
   AddTestCase (new PointToPointTest, TestCase::QUICK);
+  AddTestCase (new PointToPointSystemIdTest, TestCase::QUICK);
+  // The MultithreadedSimulatorImpl is only built with threads
+  TypeId tid;
+  if (TypeId::LookupByNameFailSafe ("ns3::MultithreadedSimulatorImpl", &tid))
+    {
+      AddTestCase (new PointToPointMultithreadedTest, TestCase::QUICK);
+    }
 }
 
 static PointToPointTestSuite g_pointToPointTestSuite; //!< The testsuite
@@ -0,0 +1,328 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017 NITK Surathkal
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Vivek Jain <jain.vivek.anand@gmail.com>
+ *          Sourabh Jain <sourabhjain560@outlook.com>
+ *          Mohit P. Tahiliani <tahiliani@nitk.edu.in>
+ */
+
+#include "ns3/log.h"
+#include "ns3/enum.h"
+#include "ns3/uinteger.h"
+#include "ns3/simulator.h"
+#include "ns3/abort.h"
+#include "cw-queue-disc.h"
+#include "ns3/drop-tail-queue.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("CwQueueDisc");
+
+NS_OBJECT_ENSURE_REGISTERED (CwQueueDisc);
+
+TypeId CwQueueDisc::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::CwQueueDisc")
+    .SetParent<QueueDisc> ()
+    .SetGroupName ("TrafficControl")
+    .AddConstructor<CwQueueDisc> ()
+    .AddAttribute ("Mode",
+                   "Determines unit for QueueLimit and MarkThreshold",
+                   EnumValue (Queue::QUEUE_MODE_PACKETS),
+                   MakeEnumAccessor (&CwQueueDisc::SetMode),
+                   MakeEnumChecker (Queue::QUEUE_MODE_BYTES, "QUEUE_MODE_BYTES",
+                                    Queue::QUEUE_MODE_PACKETS, "QUEUE_MODE_PACKETS"))
+    .AddAttribute ("QueueLimit",
+                   "Queue limit in bytes/packets",
+                   UintegerValue (25),
+                   MakeUintegerAccessor (&CwQueueDisc::SetQueueLimit),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("MarkThreshold",
+                   "Queue length in bytes/packets at or above which arriving packets are marked",
+                   UintegerValue (5),
+                   MakeUintegerAccessor (&CwQueueDisc::m_markTh),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("AverageShift",
+                   "The queue length average has weight 2^-AverageShift (0 for the instantaneous length)",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&CwQueueDisc::m_avgShift),
+                   MakeUintegerChecker<uint32_t> (0, AVG_FRAC_BITS))
+    .AddAttribute ("SojournThreshold",
+                   "Sojourn time at or above which departing packets are marked (zero to disable)",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&CwQueueDisc::m_sojournTh),
+                   MakeTimeChecker ())
+  ;
+
+  return tid;
+}
+
+CwQueueDisc::CwQueueDisc ()
+  : QueueDisc (),
+    m_qAvg (0),
+    m_markThFixed (0),
+    m_sojournThSteps (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+CwQueueDisc::~CwQueueDisc ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+CwQueueDisc::SetMode (Queue::QueueMode mode)
+{
+  NS_LOG_FUNCTION (this << mode);
+  m_mode = mode;
+}
+
+Queue::QueueMode
+CwQueueDisc::GetMode (void)
+{
+  NS_LOG_FUNCTION (this);
+  return m_mode;
+}
+
+void
+CwQueueDisc::SetQueueLimit (uint32_t lim)
+{
+  NS_LOG_FUNCTION (this << lim);
+  m_queueLimit = lim;
+}
+
+uint32_t
+CwQueueDisc::GetQueueSize (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (GetMode () == Queue::QUEUE_MODE_BYTES)
+    {
+      return GetInternalQueue (0)->GetNBytes ();
+    }
+  else if (GetMode () == Queue::QUEUE_MODE_PACKETS)
+    {
+      return GetInternalQueue (0)->GetNPackets ();
+    }
+  else
+    {
+      NS_ABORT_MSG ("Unknown CW mode.");
+    }
+}
+
+double
+CwQueueDisc::GetAverageQueueSize (void)
+{
+  NS_LOG_FUNCTION (this);
+  return static_cast<double> (m_qAvg) / (UINT64_C (1) << AVG_FRAC_BITS);
+}
+
+CwQueueDisc::Stats
+CwQueueDisc::GetStats ()
+{
+  NS_LOG_FUNCTION (this);
+  return m_stats;
+}
+
+bool
+CwQueueDisc::DoEnqueue (Ptr<QueueDiscItem> item)
+{
+  NS_LOG_FUNCTION (this << item);
+
+  uint32_t nQueued = GetQueueSize ();
+
+  if ((GetMode () == Queue::QUEUE_MODE_PACKETS && nQueued >= m_queueLimit)
+      || (GetMode () == Queue::QUEUE_MODE_BYTES && nQueued + item->GetPacketSize () > m_queueLimit))
+    {
+      // Drops due to queue limit
+      Drop (item);
+      m_stats.forcedDrop++;
+      return false;
+    }
+
+  // Update the fixed point average. Shifting the difference rather than the
+  // sample keeps the average exact for AverageShift = 0.
+  uint64_t sample = static_cast<uint64_t> (nQueued) << AVG_FRAC_BITS;
+  if (sample >= m_qAvg)
+    {
+      m_qAvg += (sample - m_qAvg) >> m_avgShift;
+    }
+  else
+    {
+      m_qAvg -= (m_qAvg - sample) >> m_avgShift;
+    }
+
+  if (m_qAvg >= m_markThFixed)
+    {
+      if (item->Mark ())
+        {
+          NS_LOG_DEBUG ("\t Marking due to queue length " << GetAverageQueueSize ());
+          m_stats.lengthMark++;
+        }
+      else
+        {
+          m_stats.unmarkable++;
+        }
+    }
+
+  bool retval = GetInternalQueue (0)->Enqueue (item);
+
+  // If Queue::Enqueue fails, QueueDisc::Drop is called by the internal queue
+  // because QueueDisc::AddInternalQueue sets the drop callback
+
+  if (retval && m_sojournThSteps > 0)
+    {
+      m_enqueueTs.push_back (Simulator::Now ().GetTimeStep ());
+    }
+
+  NS_LOG_LOGIC ("\t bytesInQueue  " << GetInternalQueue (0)->GetNBytes ());
+  NS_LOG_LOGIC ("\t packetsInQueue  " << GetInternalQueue (0)->GetNPackets ());
+
+  return retval;
+}
+
+void
+CwQueueDisc::InitializeParams (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_qAvg = 0;
+  m_markThFixed = static_cast<uint64_t> (m_markTh) << AVG_FRAC_BITS;
+  m_sojournThSteps = m_sojournTh.GetTimeStep ();
+  m_enqueueTs.clear ();
+  m_stats.forcedDrop = 0;
+  m_stats.lengthMark = 0;
+  m_stats.sojournMark = 0;
+  m_stats.unmarkable = 0;
+}
+
+Ptr<QueueDiscItem>
+CwQueueDisc::DoDequeue (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  if (GetInternalQueue (0)->IsEmpty ())
+    {
+      NS_LOG_LOGIC ("Queue empty");
+      return 0;
+    }
+
+  Ptr<QueueDiscItem> item = StaticCast<QueueDiscItem> (GetInternalQueue (0)->Dequeue ());
+
+  if (m_sojournThSteps > 0)
+    {
+      NS_ASSERT (!m_enqueueTs.empty ());
+      int64_t sojourn = Simulator::Now ().GetTimeStep () - m_enqueueTs.front ();
+      m_enqueueTs.pop_front ();
+
+      if (sojourn >= m_sojournThSteps)
+        {
+          if (item->Mark ())
+            {
+              NS_LOG_DEBUG ("\t Marking due to sojourn time " << TimeStep (sojourn));
+              m_stats.sojournMark++;
+            }
+          else
+            {
+              m_stats.unmarkable++;
+            }
+        }
+    }
+
+  NS_LOG_LOGIC ("Number packets " << GetInternalQueue (0)->GetNPackets ());
+  NS_LOG_LOGIC ("Number bytes " << GetInternalQueue (0)->GetNBytes ());
+
+  return item;
+}
+
+Ptr<const QueueDiscItem>
+CwQueueDisc::DoPeek (void) const
+{
+  NS_LOG_FUNCTION (this);
+  if (GetInternalQueue (0)->IsEmpty ())
+    {
+      NS_LOG_LOGIC ("Queue empty");
+      return 0;
+    }
+
+  Ptr<const QueueDiscItem> item = StaticCast<const QueueDiscItem> (GetInternalQueue (0)->Peek ());
+
+  NS_LOG_LOGIC ("Number packets " << GetInternalQueue (0)->GetNPackets ());
+  NS_LOG_LOGIC ("Number bytes " << GetInternalQueue (0)->GetNBytes ());
+
+  return item;
+}
+
+bool
+CwQueueDisc::CheckConfig (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (GetNQueueDiscClasses () > 0)
+    {
+      NS_LOG_ERROR ("CwQueueDisc cannot have classes");
+      return false;
+    }
+
+  if (GetNPacketFilters () > 0)
+    {
+      NS_LOG_ERROR ("CwQueueDisc cannot have packet filters");
+      return false;
+    }
+
+  if (GetNInternalQueues () == 0)
+    {
+      // create a DropTail queue
+      Ptr<Queue> queue = CreateObjectWithAttributes<DropTailQueue> ("Mode", EnumValue (m_mode));
+      if (m_mode == Queue::QUEUE_MODE_PACKETS)
+        {
+          queue->SetMaxPackets (m_queueLimit);
+        }
+      else
+        {
+          queue->SetMaxBytes (m_queueLimit);
+        }
+      AddInternalQueue (queue);
+    }
+
+  if (GetNInternalQueues () != 1)
+    {
+      NS_LOG_ERROR ("CwQueueDisc needs 1 internal queue");
+      return false;
+    }
+
+  if (GetInternalQueue (0)->GetMode () != m_mode)
+    {
+      NS_LOG_ERROR ("The mode of the provided queue does not match the mode set on the CwQueueDisc");
+      return false;
+    }
+
+  if ((m_mode ==  Queue::QUEUE_MODE_PACKETS && GetInternalQueue (0)->GetMaxPackets () < m_queueLimit)
+      || (m_mode ==  Queue::QUEUE_MODE_BYTES && GetInternalQueue (0)->GetMaxBytes () < m_queueLimit))
+    {
+      NS_LOG_ERROR ("The size of the internal queue is less than the queue disc limit");
+      return false;
+    }
+
+  if (m_sojournTh.IsStrictlyNegative ())
+    {
+      NS_LOG_ERROR ("The sojourn time threshold cannot be negative");
+      return false;
+    }
+
+  return true;
+}
+
+} //namespace ns3
@@ -0,0 +1,156 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017 NITK Surathkal
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Vivek Jain <jain.vivek.anand@gmail.com>
+ *          Sourabh Jain <sourabhjain560@outlook.com>
+ *          Mohit P. Tahiliani <tahiliani@nitk.edu.in>
+ */
+
+#ifndef CW_QUEUE_DISC_H
+#define CW_QUEUE_DISC_H
+
+#include <deque>
+#include "ns3/packet.h"
+#include "ns3/queue-disc.h"
+#include "ns3/nstime.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup traffic-control
+ *
+ * \brief Congestion Warning (CW) queue disc used by TCP Jersey
+ *
+ * The router side of TCP Jersey marks packets with ECN CE as soon as
+ * the queue builds up beyond a threshold, so that the sender can adjust
+ * its window to the estimated available bandwidth before the bottleneck
+ * overflows. Marking is deterministic: a packet is marked when
+ *
+ * - the (optionally averaged) queue length found by the arriving packet is
+ *   at or above MarkThreshold, or
+ * - the sojourn time of the departing packet is at or above SojournThreshold
+ *   (if this threshold is non-zero).
+ *
+ * The queue length average is an exponentially weighted moving average
+ * with weight 2^-AverageShift, kept in fixed point so that the per-packet
+ * cost is a few integer operations. An AverageShift of zero uses the
+ * instantaneous queue length. No random number is drawn on either path.
+ *
+ * Packets that are not ECN capable are never dropped early; they are only
+ * dropped when the queue limit is exceeded.
+ */
+class CwQueueDisc : public QueueDisc
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  /**
+   * \brief CwQueueDisc Constructor
+   */
+  CwQueueDisc ();
+
+  /**
+   * \brief CwQueueDisc Destructor
+   */
+  virtual ~CwQueueDisc ();
+
+  /**
+   * \brief Stats
+   */
+  typedef struct
+  {
+    uint32_t forcedDrop;        //!< Drops due to queue limit
+    uint32_t lengthMark;        //!< Marks due to the queue length threshold
+    uint32_t sojournMark;       //!< Marks due to the sojourn time threshold
+    uint32_t unmarkable;        //!< Packets above a threshold that are not ECN capable
+  } Stats;
+
+  /**
+   * \brief Set the operating mode of this queue.
+   *
+   * \param mode The operating mode of this queue.
+   */
+  void SetMode (Queue::QueueMode mode);
+
+  /**
+   * \brief Get the operating mode of this queue.
+   *
+   * \returns The operating mode of this queue.
+   */
+  Queue::QueueMode GetMode (void);
+
+  /**
+   * \brief Get the current value of the queue in bytes or packets.
+   *
+   * \returns The queue size in bytes or packets.
+   */
+  uint32_t GetQueueSize (void);
+
+  /**
+   * \brief Get the current average of the queue in bytes or packets.
+   *
+   * \returns The average queue size in bytes or packets.
+   */
+  double GetAverageQueueSize (void);
+
+  /**
+   * \brief Set the limit of the queue in bytes or packets.
+   *
+   * \param lim The limit in bytes or packets.
+   */
+  void SetQueueLimit (uint32_t lim);
+
+  /**
+   * \brief Get CW statistics after running.
+   *
+   * \returns The drop and mark statistics.
+   */
+  Stats GetStats ();
+
+private:
+  virtual bool DoEnqueue (Ptr<QueueDiscItem> item);
+  virtual Ptr<QueueDiscItem> DoDequeue (void);
+  virtual Ptr<const QueueDiscItem> DoPeek (void) const;
+  virtual bool CheckConfig (void);
+  virtual void InitializeParams (void);
+
+  /// Number of fractional bits of the fixed point queue average
+  static const uint32_t AVG_FRAC_BITS = 16;
+
+  Stats m_stats;                                //!< CW statistics
+
+  // ** Variables supplied by user
+  Queue::QueueMode m_mode;                      //!< Mode (bytes or packets)
+  uint32_t m_queueLimit;                        //!< Queue limit in bytes / packets
+  uint32_t m_markTh;                            //!< Queue length threshold in bytes / packets
+  uint32_t m_avgShift;                          //!< Queue average weight is 2^-m_avgShift
+  Time m_sojournTh;                             //!< Sojourn time threshold (zero disables)
+
+  // ** Variables maintained by CW
+  uint64_t m_qAvg;                              //!< Average queue length, fixed point
+  uint64_t m_markThFixed;                       //!< m_markTh in the fixed point unit of m_qAvg
+  int64_t m_sojournThSteps;                     //!< m_sojournTh in time steps
+  std::deque<int64_t> m_enqueueTs;              //!< Enqueue timestamps of the queued packets
+};
+
+} // namespace ns3
+
+#endif // CW_QUEUE_DISC_H
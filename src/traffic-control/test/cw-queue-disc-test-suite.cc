@@ -0,0 +1,305 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017 NITK Surathkal
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Vivek Jain <jain.vivek.anand@gmail.com>
+ *          Sourabh Jain <sourabhjain560@outlook.com>
+ *          Mohit P. Tahiliani <tahiliani@nitk.edu.in>
+ */
+
+#include "ns3/test.h"
+#include "ns3/cw-queue-disc.h"
+#include "ns3/uinteger.h"
+#include "ns3/string.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+
+using namespace ns3;
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Cw Queue Disc Test Item
+ */
+class CwQueueDiscTestItem : public QueueDiscItem
+{
+public:
+  /**
+   * Constructor
+   *
+   * \param p packet
+   * \param addr address
+   * \param protocol protocol
+   * \param ecnCapable ECN capable flag
+   */
+  CwQueueDiscTestItem (Ptr<Packet> p, const Address & addr, uint16_t protocol, bool ecnCapable);
+  virtual ~CwQueueDiscTestItem ();
+  virtual void AddHeader (void);
+  virtual bool Mark (void);
+
+private:
+  CwQueueDiscTestItem ();
+  /// copy constructor
+  CwQueueDiscTestItem (const CwQueueDiscTestItem &);
+  /// assignment operator
+  CwQueueDiscTestItem &operator = (const CwQueueDiscTestItem &);
+  bool m_ecnCapablePacket; ///< ECN capable packet?
+};
+
+CwQueueDiscTestItem::CwQueueDiscTestItem (Ptr<Packet> p, const Address & addr, uint16_t protocol, bool ecnCapable)
+  : QueueDiscItem (p, addr, protocol),
+    m_ecnCapablePacket (ecnCapable)
+{
+}
+
+CwQueueDiscTestItem::~CwQueueDiscTestItem ()
+{
+}
+
+void
+CwQueueDiscTestItem::AddHeader (void)
+{
+}
+
+bool
+CwQueueDiscTestItem::Mark (void)
+{
+  return m_ecnCapablePacket;
+}
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Cw Queue Disc Test Case
+ */
+class CwQueueDiscTestCase : public TestCase
+{
+public:
+  CwQueueDiscTestCase ();
+  virtual void DoRun (void);
+private:
+  /**
+   * Enqueue function
+   * \param queue the queue disc
+   * \param size the size
+   * \param nPkt the number of packets
+   * \param ecnCapable ECN capable flag
+   */
+  void Enqueue (Ptr<CwQueueDisc> queue, uint32_t size, uint32_t nPkt, bool ecnCapable);
+  /**
+   * Dequeue function
+   * \param queue the queue disc
+   * \param nPkt the number of packets
+   */
+  void Dequeue (Ptr<CwQueueDisc> queue, uint32_t nPkt);
+  /**
+   * Run test function
+   * \param mode the test mode
+   */
+  void RunCwTest (StringValue mode);
+};
+
+CwQueueDiscTestCase::CwQueueDiscTestCase ()
+  : TestCase ("Sanity check on the cw queue disc implementation")
+{
+}
+
+void
+CwQueueDiscTestCase::RunCwTest (StringValue mode)
+{
+  uint32_t pktSize = 0;
+  // 1 for packets; pktSize for bytes
+  uint32_t modeSize = 1;
+  uint32_t qSize = 25;
+  uint32_t markTh = 5;
+  Ptr<CwQueueDisc> queue = CreateObject<CwQueueDisc> ();
+
+  // test 1: simple enqueue/dequeue with no drops and no marks
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("Mode", mode), true,
+                         "Verify that we can actually set the attribute Mode");
+
+  if (queue->GetMode () == Queue::QUEUE_MODE_BYTES)
+    {
+      pktSize = 1000;
+      modeSize = pktSize;
+    }
+  qSize = qSize * modeSize;
+  markTh = markTh * modeSize;
+
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("QueueLimit", UintegerValue (qSize)), true,
+                         "Verify that we can actually set the attribute QueueLimit");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("MarkThreshold", UintegerValue (markTh)), true,
+                         "Verify that we can actually set the attribute MarkThreshold");
+
+  Address dest;
+  Ptr<Packet> p1, p2, p3;
+  p1 = Create<Packet> (pktSize);
+  p2 = Create<Packet> (pktSize);
+  p3 = Create<Packet> (pktSize);
+
+  queue->Initialize ();
+  NS_TEST_EXPECT_MSG_EQ (queue->GetQueueSize (), 0 * modeSize, "There should be no packets in there");
+  queue->Enqueue (Create<CwQueueDiscTestItem> (p1, dest, 0, true));
+  NS_TEST_EXPECT_MSG_EQ (queue->GetQueueSize (), 1 * modeSize, "There should be one packet in there");
+  queue->Enqueue (Create<CwQueueDiscTestItem> (p2, dest, 0, true));
+  queue->Enqueue (Create<CwQueueDiscTestItem> (p3, dest, 0, true));
+  NS_TEST_EXPECT_MSG_EQ (queue->GetQueueSize (), 3 * modeSize, "There should be three packets in there");
+
+  Ptr<QueueDiscItem> item;
+  item = queue->Dequeue ();
+  NS_TEST_EXPECT_MSG_EQ ((item != 0), true, "I want to remove the first packet");
+  NS_TEST_EXPECT_MSG_EQ (item->GetPacket ()->GetUid (), p1->GetUid (), "Was this the first packet ?");
+  item = queue->Dequeue ();
+  NS_TEST_EXPECT_MSG_EQ (item->GetPacket ()->GetUid (), p2->GetUid (), "Was this the second packet ?");
+  item = queue->Dequeue ();
+  NS_TEST_EXPECT_MSG_EQ (item->GetPacket ()->GetUid (), p3->GetUid (), "Was this the third packet ?");
+  item = queue->Dequeue ();
+  NS_TEST_EXPECT_MSG_EQ ((item == 0), true, "There are really no packets in there");
+
+  CwQueueDisc::Stats st = queue->GetStats ();
+  NS_TEST_EXPECT_MSG_EQ (st.lengthMark, 0, "There should be no marks");
+  NS_TEST_EXPECT_MSG_EQ (st.forcedDrop, 0, "There should be no forced drops");
+
+
+  // test 2: instantaneous queue length, every packet finding 5 or more packets is marked
+  queue = CreateObject<CwQueueDisc> ();
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("Mode", mode), true,
+                         "Verify that we can actually set the attribute Mode");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("QueueLimit", UintegerValue (qSize)), true,
+                         "Verify that we can actually set the attribute QueueLimit");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("MarkThreshold", UintegerValue (markTh)), true,
+                         "Verify that we can actually set the attribute MarkThreshold");
+  queue->Initialize ();
+  Enqueue (queue, pktSize, 10, true);
+  st = queue->GetStats ();
+  NS_TEST_EXPECT_MSG_EQ (st.lengthMark, 5, "There should be five marks");
+  NS_TEST_EXPECT_MSG_EQ (st.unmarkable, 0, "All packets should be markable");
+  NS_TEST_EXPECT_MSG_EQ (st.forcedDrop, 0, "There should be no forced drops");
+
+
+  // test 3: same as test 2, but packets are not ECN capable and are never early dropped
+  queue = CreateObject<CwQueueDisc> ();
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("Mode", mode), true,
+                         "Verify that we can actually set the attribute Mode");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("QueueLimit", UintegerValue (qSize)), true,
+                         "Verify that we can actually set the attribute QueueLimit");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("MarkThreshold", UintegerValue (markTh)), true,
+                         "Verify that we can actually set the attribute MarkThreshold");
+  queue->Initialize ();
+  Enqueue (queue, pktSize, 10, false);
+  st = queue->GetStats ();
+  NS_TEST_EXPECT_MSG_EQ (st.lengthMark, 0, "There should be no marks");
+  NS_TEST_EXPECT_MSG_EQ (st.unmarkable, 5, "There should be five unmarkable packets");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetQueueSize (), 10 * modeSize, "All packets should be enqueued");
+
+
+  // test 4: averaged queue length with weight 1/2 lags the instantaneous length by one packet
+  queue = CreateObject<CwQueueDisc> ();
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("Mode", mode), true,
+                         "Verify that we can actually set the attribute Mode");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("QueueLimit", UintegerValue (qSize)), true,
+                         "Verify that we can actually set the attribute QueueLimit");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("MarkThreshold", UintegerValue (markTh)), true,
+                         "Verify that we can actually set the attribute MarkThreshold");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("AverageShift", UintegerValue (1)), true,
+                         "Verify that we can actually set the attribute AverageShift");
+  queue->Initialize ();
+  Enqueue (queue, pktSize, 10, true);
+  st = queue->GetStats ();
+  NS_TEST_EXPECT_MSG_EQ (st.lengthMark, 4, "There should be four marks");
+  NS_TEST_EXPECT_MSG_LT (queue->GetAverageQueueSize (), 9.0 * modeSize, "The average should lag the queue length");
+
+
+  // test 5: queue limit is enforced by forced drops
+  queue = CreateObject<CwQueueDisc> ();
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("Mode", mode), true,
+                         "Verify that we can actually set the attribute Mode");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("QueueLimit", UintegerValue (qSize)), true,
+                         "Verify that we can actually set the attribute QueueLimit");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("MarkThreshold", UintegerValue (markTh)), true,
+                         "Verify that we can actually set the attribute MarkThreshold");
+  queue->Initialize ();
+  Enqueue (queue, pktSize, 30, true);
+  st = queue->GetStats ();
+  NS_TEST_EXPECT_MSG_EQ (st.forcedDrop, 5, "There should be five forced drops");
+  NS_TEST_EXPECT_MSG_EQ (st.lengthMark, 20, "There should be twenty marks");
+
+
+  // test 6: packets that waited for SojournThreshold or more are marked on dequeue
+  queue = CreateObject<CwQueueDisc> ();
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("Mode", mode), true,
+                         "Verify that we can actually set the attribute Mode");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("QueueLimit", UintegerValue (qSize)), true,
+                         "Verify that we can actually set the attribute QueueLimit");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("MarkThreshold", UintegerValue (qSize)), true,
+                         "Verify that we can actually set the attribute MarkThreshold");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("SojournThreshold", TimeValue (MilliSeconds (10))), true,
+                         "Verify that we can actually set the attribute SojournThreshold");
+  queue->Initialize ();
+  Enqueue (queue, pktSize, 5, true);
+  Simulator::Schedule (MilliSeconds (5), &CwQueueDiscTestCase::Dequeue, this, queue, 2);
+  Simulator::Schedule (MilliSeconds (20), &CwQueueDiscTestCase::Dequeue, this, queue, 3);
+  Simulator::Run ();
+  st = queue->GetStats ();
+  NS_TEST_EXPECT_MSG_EQ (st.lengthMark, 0, "There should be no queue length marks");
+  NS_TEST_EXPECT_MSG_EQ (st.sojournMark, 3, "There should be three sojourn time marks");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetQueueSize (), 0, "The queue should be empty");
+}
+
+void
+CwQueueDiscTestCase::Enqueue (Ptr<CwQueueDisc> queue, uint32_t size, uint32_t nPkt, bool ecnCapable)
+{
+  Address dest;
+  for (uint32_t i = 0; i < nPkt; i++)
+    {
+      queue->Enqueue (Create<CwQueueDiscTestItem> (Create<Packet> (size), dest, 0, ecnCapable));
+    }
+}
+
+void
+CwQueueDiscTestCase::Dequeue (Ptr<CwQueueDisc> queue, uint32_t nPkt)
+{
+  for (uint32_t i = 0; i < nPkt; i++)
+    {
+      Ptr<QueueDiscItem> item = queue->Dequeue ();
+    }
+}
+
+void
+CwQueueDiscTestCase::DoRun (void)
+{
+  RunCwTest (StringValue ("QUEUE_MODE_PACKETS"));
+  RunCwTest (StringValue ("QUEUE_MODE_BYTES"));
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Cw Queue Disc Test Suite
+ */
+static class CwQueueDiscTestSuite : public TestSuite
+{
+public:
+  CwQueueDiscTestSuite ()
+    : TestSuite ("cw-queue-disc", UNIT)
+  {
+    AddTestCase (new CwQueueDiscTestCase (), TestCase::QUICK);
+  }
+} g_cwQueueTestSuite; ///< the test suite
@@ -209,6 +209,12 @@ VisualSimulatorImpl::GetMaximumSimulationTime (void) const
   return m_simulator->GetMaximumSimulationTime ();
 }
 
+Simulator::EventCounts
+VisualSimulatorImpl::GetEventCounts (void) const
+{
+  return m_simulator->GetEventCounts ();
+}
+
 uint32_t
 VisualSimulatorImpl::GetContext (void) const
 {
@@ -26,6 +26,8 @@
 #include "ns3/system-wall-clock-ms.h"
 #include "ns3/packet.h"
 #include "ns3/packet-metadata.h"
+#include "ns3/socket.h"
+#include "ns3/flow-id-tag.h"
 #include <iostream>
 #include <sstream>
 #include <string>
@@ -328,6 +330,56 @@ benchByteTags (uint32_t n)
     }
 }
 
+static void
+benchPacketTags (uint32_t n)
+{
+  BenchHeader<25> ipv4;
+  BenchHeader<20> tcp;
+  BenchTag<9> packetInfo;   // As an Ipv4PacketInfoTag
+  BenchTag<20> flowProbe;   // As an Ipv4FlowProbeTag
+
+  for (uint32_t i = 0; i < n; i++)
+    {
+      // The socket tags of a TCP segment
+      Ptr<Packet> p = Create<Packet> (1000);
+      SocketIpTosTag tos;
+      tos.SetTos (0x10);
+      p->AddPacketTag (tos);
+      SocketIpTtlTag ttl;
+      ttl.SetTtl (64);
+      p->AddPacketTag (ttl);
+      SocketPriorityTag priority;
+      priority.SetPriority (6);
+      p->AddPacketTag (priority);
+      p->AddHeader (tcp);
+
+      // The IP layer consumes some of them, and the flow monitor adds its own
+      p->RemovePacketTag (tos);
+      p->RemovePacketTag (ttl);
+      p->AddHeader (ipv4);
+      p->AddPacketTag (flowProbe);
+      p->AddPacketTag (FlowIdTag (i));
+
+      // Three hops, each copying the packet and reading its tags
+      for (uint32_t hop = 0; hop < 3; hop++)
+        {
+          Ptr<Packet> q = p->Copy ();
+          q->PeekPacketTag (priority);
+          q->RemoveHeader (ipv4);
+          q->ReplacePacketTag (priority);
+          q->AddHeader (ipv4);
+          p = q;
+        }
+
+      // The receiver
+      p->RemoveHeader (ipv4);
+      p->AddPacketTag (packetInfo);
+      p->RemovePacketTag (flowProbe);
+      p->RemoveHeader (tcp);
+      p->RemovePacketTag (packetInfo);
+    }
+}
+
 static uint64_t
 runBenchOneIteration (void (*bench) (uint32_t), uint32_t n)
 {
@@ -357,6 +409,15 @@ runBench (void (*bench) (uint32_t), uint32_t n, uint32_t minIterations, char con
             << std::endl;
 }
 
+static void
+printFreeListStats (const DataFreeListStats &stats, char const *name)
+{
+  std::cout << name << ": " << stats.allocations << " allocations, "
+            << stats.hits << " from free lists, "
+            << stats.cached << " kept"
+            << std::endl;
+}
+
 int main (int argc, char *argv[])
 {
   uint32_t n = 0;
@@ -385,6 +446,11 @@ int main (int argc, char *argv[])
   runBench (&benchD, n, minIterations, "Intermixed add/remove headers and tags");
   runBench (&benchFragment, n, minIterations, "Fragmentation and concatenation");
   runBench (&benchByteTags, n, minIterations, "Benchmark byte tags");
+  runBench (&benchPacketTags, n, minIterations, "Forward packets with packet tags");
+
+  printFreeListStats (Buffer::GetFreeListStats (), "Buffer data");
+  printFreeListStats (PacketMetadata::GetFreeListStats (), "Packet metadata");
+  printFreeListStats (ByteTagList::GetFreeListStats (), "Byte tags");
 
   return 0;
 }
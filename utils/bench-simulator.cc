@@ -51,7 +51,9 @@ public:
   Bench (const uint32_t population, const uint32_t total)
     : m_population (population),
       m_total (total),
-      m_count (0)
+      m_count (0),
+      m_tcp (false),
+      m_time (false)
   {
   }
 
@@ -82,16 +84,48 @@ public:
     m_total = total;
   }
 
+  /**
+   * Model TCP flows: each event re-arms the retransmission timer of its
+   * flow, cancelling the previous one
+   * \param tcp whether to re-arm timers
+   */
+  void SetTcp (const bool tcp)
+  {
+    m_tcp = tcp;
+  }
+
+  /**
+   * Convert times at each event, as a TCP bandwidth estimator and
+   * RTT filter do for each ACK
+   * \param time whether to convert times
+   */
+  void SetTime (const bool time)
+  {
+    m_time = time;
+  }
+
   /// Run function
   void RunBench (void);
 private:
-  /// callback function
-  void Cb (void);
+  /**
+   * callback function
+   * \param flow the flow of the event
+   */
+  void Cb (uint32_t flow);
+  /// retransmission timer expiration, which is rare
+  void Timeout (void);
 
   Ptr<RandomVariableStream> m_rand; ///< random variable
+  Ptr<UniformRandomVariable> m_rto; ///< retransmission timeouts
+  std::vector<EventId> m_timers; ///< retransmission timer of each flow
   uint32_t m_population; ///< population
   uint32_t m_total; ///< total
   uint32_t m_count; ///< count 
+  bool m_tcp; ///< re-arm a timer at each event
+  bool m_time; ///< convert times at each event
+  Time m_last; ///< time of the previous event
+  Time m_rtt; ///< smoothed interval between events
+  int64_t m_sum; ///< sum of the smoothed intervals, in us
 };
 
 void
@@ -102,13 +136,27 @@ Bench::RunBench (void)
 
   DEB ("initializing");
   m_count = 0;
+  m_timers.clear ();
+  m_last = Time ();
+  m_rtt = Time ();
+  m_sum = 0;
+  if (m_tcp)
+    {
+      m_timers.resize (m_population);
+      if (m_rto == 0)
+        {
+          m_rto = CreateObject<UniformRandomVariable> ();
+          m_rto->SetAttribute ("Min", DoubleValue (200000000));
+          m_rto->SetAttribute ("Max", DoubleValue (1000000000));
+        }
+    }
 
 
   time.Start ();
   for (uint32_t i = 0; i < m_population; ++i)
     {
       Time at = NanoSeconds (m_rand->GetValue ());
-      Simulator::Schedule (at, &Bench::Cb, this);
+      Simulator::Schedule (at, &Bench::Cb, this, i);
     }
   init = time.End ();
   init /= 1000;
@@ -131,19 +179,46 @@ Bench::RunBench (void)
 }
 
 void
-Bench::Cb (void)
+Bench::Cb (uint32_t flow)
 {
   if (m_count >= m_total)
     {
+      if (m_tcp)
+        {
+          m_timers[flow].Cancel ();
+        }
       return;
     }
   DEB ("event at " << Simulator::Now ().GetSeconds () << "s");
 
   Time after = NanoSeconds (m_rand->GetValue ());
-  Simulator::Schedule (after, &Bench::Cb, this);
+  Simulator::Schedule (after, &Bench::Cb, this, flow);
+  if (m_time)
+    {
+      // Conversions to and from seconds, with the runtime resolution
+      // table unless the resolution is fixed at configuration
+      Time now = Simulator::Now ();
+      double interval = (now - m_last).GetSeconds ();
+      m_last = now;
+      m_rtt = Seconds (0.875 * m_rtt.GetSeconds () + 0.125 * interval);
+      m_sum += m_rtt.GetMicroSeconds ();
+    }
+  if (m_tcp)
+    {
+      // As TcpSocketBase does for each segment sent or acknowledged
+      m_timers[flow].Cancel ();
+      m_timers[flow] = Simulator::Schedule (NanoSeconds (m_rto->GetValue ()),
+                                            &Bench::Timeout, this);
+    }
   ++m_count;
 }
 
+void
+Bench::Timeout (void)
+{
+  DEB ("timeout at " << Simulator::Now ().GetSeconds () << "s");
+}
+
 
 Ptr<RandomVariableStream>
 GetRandomStream (std::string filename)
@@ -205,8 +280,12 @@ int main (int argc, char *argv[])
 
   bool schedCal  = false;
   bool schedHeap = false;
+  bool schedLadder = false;
   bool schedList = false;
   bool schedMap  = true;
+  bool schedAll  = false;
+  bool tcp = false;
+  bool time = false;
 
   uint32_t pop   =  100000;
   uint32_t total = 1000000;
@@ -221,11 +300,23 @@ int main (int argc, char *argv[])
              "  an ascii file, given by the --file=\"<filename>\" argument,\n"
              "  or standard input, by the argument --file=\"-\"\n"
              "In the case of either --file form, the input is expected\n"
-             "to be ascii, giving the relative event times in ns.");
+             "to be ascii, giving the relative event times in ns.\n"
+             "\n"
+             "With --tcp, each event also cancels and re-arms a timer of\n"
+             "200 ms to 1 s, as TCP does with its retransmission timer,\n"
+             "so that most events in the scheduler are far away timeouts.\n"
+             "\n"
+             "With --time, each event also converts times to and from\n"
+             "seconds, as TCP models do for each ACK: compare the time\n"
+             "per event with and without configuring --time-resolution.");
   cmd.AddValue ("cal",   "use CalendarSheduler",          schedCal);
   cmd.AddValue ("heap",  "use HeapScheduler",             schedHeap);
+  cmd.AddValue ("ladder", "use LadderScheduler",          schedLadder);
   cmd.AddValue ("list",  "use ListSheduler",              schedList);
   cmd.AddValue ("map",   "use MapScheduler (default)",    schedMap);
+  cmd.AddValue ("all",   "run with each scheduler in turn", schedAll);
+  cmd.AddValue ("tcp",   "re-arm a retransmission timer at each event", tcp);
+  cmd.AddValue ("time",  "convert times at each event",   time);
   cmd.AddValue ("debug", "enable debugging output",       g_debug);
   cmd.AddValue ("pop",   "event population size (default 1E5)",         pop);
   cmd.AddValue ("total", "total number of events to run (default 1E6)", total);
@@ -236,71 +327,113 @@ int main (int argc, char *argv[])
   g_me = cmd.GetName () + ": ";
   g_fwidth += 6;  // 5 extra chars in '2.000002e+07 ': . e+0 _
 
-  ObjectFactory factory ("ns3::MapScheduler");
-  if (schedCal)
+  std::vector<std::string> schedulers;
+  if (schedAll)
+    {
+      schedulers.push_back ("ns3::MapScheduler");
+      schedulers.push_back ("ns3::HeapScheduler");
+      schedulers.push_back ("ns3::CalendarScheduler");
+      schedulers.push_back ("ns3::LadderScheduler");
+      schedulers.push_back ("ns3::ListScheduler");
+    }
+  else if (schedCal)
+    {
+      schedulers.push_back ("ns3::CalendarScheduler");
+    }
+  else if (schedHeap)
     {
-      factory.SetTypeId ("ns3::CalendarScheduler");
+      schedulers.push_back ("ns3::HeapScheduler");
     }
-  if (schedHeap)
+  else if (schedLadder)
     {
-      factory.SetTypeId ("ns3::HeapScheduler");
+      schedulers.push_back ("ns3::LadderScheduler");
     }
-  if (schedList)
+  else if (schedList)
     {
-      factory.SetTypeId ("ns3::ListScheduler");
+      schedulers.push_back ("ns3::ListScheduler");
+    }
+  else
+    {
+      schedulers.push_back ("ns3::MapScheduler");
     }
-  Simulator::SetScheduler (factory);
 
   LOGME (std::setprecision (g_fwidth - 6));
   DEB ("debugging is ON");
 
-  LOGME ("scheduler: " << factory.GetTypeId ().GetName ());
   LOGME ("population: " << pop);
   LOGME ("total events: " << total);
   LOGME ("runs: " << runs);
+  LOGME ("tcp timers: " << (tcp ? "yes" : "no"));
+  LOGME ("time conversions: " << (time ? "yes" : "no"));
+#ifdef NS3_TIME_RESOLUTION
+  LOGME ("time resolution: fixed at configuration");
+#else
+  LOGME ("time resolution: set at run time");
+#endif
 
   Bench *bench = new Bench (pop, total);
   bench->SetRandomStream (GetRandomStream (filename));
+  bench->SetTcp (tcp);
+  bench->SetTime (time);
 
-  // table header
-  LOG ("");
-  LOG (std::left << std::setw (g_fwidth) << "Run #" <<
-       std::left << std::setw (3 * g_fwidth) << "Inititialization:" <<
-       std::left << std::setw (3 * g_fwidth) << "Simulation:");
-  LOG (std::left << std::setw (g_fwidth) << "" <<
-       std::left << std::setw (g_fwidth) << "Time (s)" <<
-       std::left << std::setw (g_fwidth) << "Rate (ev/s)" <<
-       std::left << std::setw (g_fwidth) << "Per (s/ev)" <<
-       std::left << std::setw (g_fwidth) << "Time (s)" <<
-       std::left << std::setw (g_fwidth) << "Rate (ev/s)" <<
-       std::left << std::setw (g_fwidth) << "Per (s/ev)" );
-  LOG (std::setfill ('-') <<
-       std::right << std::setw (g_fwidth) << " " <<
-       std::right << std::setw (g_fwidth) << " " <<
-       std::right << std::setw (g_fwidth) << " " <<
-       std::right << std::setw (g_fwidth) << " " <<
-       std::right << std::setw (g_fwidth) << " " <<
-       std::right << std::setw (g_fwidth) << " " <<
-       std::right << std::setw (g_fwidth) << " " <<
-       std::setfill (' ')
-       );
-
-  // prime
-  DEB ("priming");
-  std::cout << std::left << std::setw (g_fwidth) << "(prime)";
-  bench->RunBench ();
-
-  bench->SetPopulation (pop);
-  bench->SetTotal (total);
-  for (uint32_t i = 0; i < runs; i++)
+  for (std::vector<std::string>::const_iterator s = schedulers.begin ();
+       s != schedulers.end (); ++s)
     {
-      std::cout << std::setw (g_fwidth) << i;
-
+      ObjectFactory factory (*s);
+      Simulator::SetScheduler (factory);
+
+      LOG ("");
+      LOGME ("scheduler: " << factory.GetTypeId ().GetName ());
+
+      // table header
+      LOG ("");
+      LOG (std::left << std::setw (g_fwidth) << "Run #" <<
+           std::left << std::setw (3 * g_fwidth) << "Inititialization:" <<
+           std::left << std::setw (3 * g_fwidth) << "Simulation:");
+      LOG (std::left << std::setw (g_fwidth) << "" <<
+           std::left << std::setw (g_fwidth) << "Time (s)" <<
+           std::left << std::setw (g_fwidth) << "Rate (ev/s)" <<
+           std::left << std::setw (g_fwidth) << "Per (s/ev)" <<
+           std::left << std::setw (g_fwidth) << "Time (s)" <<
+           std::left << std::setw (g_fwidth) << "Rate (ev/s)" <<
+           std::left << std::setw (g_fwidth) << "Per (s/ev)" );
+      LOG (std::setfill ('-') <<
+           std::right << std::setw (g_fwidth) << " " <<
+           std::right << std::setw (g_fwidth) << " " <<
+           std::right << std::setw (g_fwidth) << " " <<
+           std::right << std::setw (g_fwidth) << " " <<
+           std::right << std::setw (g_fwidth) << " " <<
+           std::right << std::setw (g_fwidth) << " " <<
+           std::right << std::setw (g_fwidth) << " " <<
+           std::setfill (' ')
+           );
+
+      // prime
+      DEB ("priming");
+      std::cout << std::left << std::setw (g_fwidth) << "(prime)";
       bench->RunBench ();
+
+      bench->SetPopulation (pop);
+      bench->SetTotal (total);
+      for (uint32_t i = 0; i < runs; i++)
+        {
+          std::cout << std::setw (g_fwidth) << i;
+
+          bench->RunBench ();
+        }
+
+      Simulator::EventCounts counts = Simulator::GetEventCounts ();
+      LOGME ("compactions of cancelled events: " << counts.compactions <<
+             ", events purged: " << counts.purged);
+      LOG ("");
+      // Start the next scheduler from a new simulator
+      Simulator::Destroy ();
     }
 
-  LOG ("");
-  Simulator::Destroy ();
+  EventImpl::PoolStats stats = EventImpl::GetPoolStats ();
+  LOGME ("events allocated: " << stats.allocations <<
+         ", from free lists: " << stats.reused <<
+         ", blocks kept: " << stats.cached);
   delete bench;
   return 0;
 }
@@ -0,0 +1,221 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+// This program runs the replications of a TCP dumbbell scenario in
+// parallel worker processes, over seeds and parameter grids, and gathers
+// their FlowMonitor results in a single XML file.
+// Sample usage:
+//   ./waf --run 'run-replications --runs=10 --workers=4
+//       --sweep=ns3::TcpL4Protocol::SocketType=ns3::TcpNewReno,ns3::TcpVegas
+//       --sweep=errorRate=0,0.001,0.01 --output=sweep.xml'
+// Any argument of the scenario, attribute default or global value can be
+// swept, or given a single value for all the replications.
+// With --warmup, the replications are forked from a checkpoint of the
+// simulation at the end of the warm-up: they only sweep the errorRate and
+// the Config paths of the attributes of existing objects, such as
+//   --sweep=/NodeList/*/DeviceList/*/$ns3::PointToPointNetDevice/DataRate=5Mbps,1Gbps
+// and they have a single run.
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/point-to-point-module.h"
+#include "ns3/point-to-point-layout-module.h"
+#include "ns3/applications-module.h"
+#include "ns3/traffic-control-module.h"
+#include "ns3/flow-monitor-module.h"
+#include "ns3/replication-runner.h"
+
+#include <iostream>
+#include <string>
+
+using namespace ns3;
+
+namespace {
+
+uint32_t g_flows = 4;                          //!< Number of TCP flows
+std::string g_bottleneckRate = "10Mbps";       //!< Rate of the bottleneck
+std::string g_bottleneckDelay = "10ms";        //!< Delay of the bottleneck
+std::string g_queueDisc = "ns3::PfifoFastQueueDisc"; //!< Queue disc of the bottleneck
+double g_errorRate = 0;                        //!< Packet loss rate of the bottleneck
+double g_duration = 10;                        //!< Duration of the flows, in seconds
+Ptr<RateErrorModel> g_errorModel;              //!< Error model of the bottleneck
+Ptr<FlowMonitor> g_monitor;                    //!< The flow monitor
+FlowMonitorHelper *g_flowmon = 0;              //!< The flow monitor helper
+
+/**
+ * Add the arguments of the scenario to a CommandLine.
+ * \param [in,out] cmd The CommandLine.
+ */
+void
+AddScenarioValues (CommandLine &cmd)
+{
+  cmd.AddValue ("flows", "Number of TCP flows", g_flows);
+  cmd.AddValue ("bottleneckRate", "Rate of the bottleneck link", g_bottleneckRate);
+  cmd.AddValue ("bottleneckDelay", "Delay of the bottleneck link", g_bottleneckDelay);
+  cmd.AddValue ("queueDisc", "Queue disc of the bottleneck link", g_queueDisc);
+  cmd.AddValue ("errorRate", "Packet loss rate of the bottleneck link", g_errorRate);
+  cmd.AddValue ("duration", "Duration of the flows, in seconds", g_duration);
+}
+
+/**
+ * Build the scenario: TCP flows over a dumbbell.
+ * \param [in,out] flowmon The helper of the flow monitor.
+ */
+void
+Build (FlowMonitorHelper &flowmon)
+{
+  PointToPointHelper leaf;
+  leaf.SetDeviceAttribute ("DataRate", StringValue ("1Gbps"));
+  leaf.SetChannelAttribute ("Delay", StringValue ("1ms"));
+  PointToPointHelper bottleneck;
+  bottleneck.SetDeviceAttribute ("DataRate", StringValue (g_bottleneckRate));
+  bottleneck.SetChannelAttribute ("Delay", StringValue (g_bottleneckDelay));
+  PointToPointDumbbellHelper dumbbell (g_flows, leaf, g_flows, leaf, bottleneck);
+
+  InternetStackHelper stack;
+  dumbbell.InstallStack (stack);
+  // The bottleneck devices are the first of the routers
+  TrafficControlHelper tch;
+  tch.SetRootQueueDisc (g_queueDisc);
+  tch.Install (dumbbell.GetLeft ()->GetDevice (0));
+  dumbbell.AssignIpv4Addresses (Ipv4AddressHelper ("10.1.0.0", "255.255.255.0"),
+                                Ipv4AddressHelper ("10.2.0.0", "255.255.255.0"),
+                                Ipv4AddressHelper ("10.3.0.0", "255.255.255.0"));
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+
+  g_errorModel = CreateObject<RateErrorModel> ();
+  g_errorModel->SetAttribute ("ErrorRate", DoubleValue (g_errorRate));
+  g_errorModel->SetAttribute ("ErrorUnit", StringValue ("ERROR_UNIT_PACKET"));
+  dumbbell.GetRight ()->GetDevice (0)->SetAttribute ("ReceiveErrorModel", PointerValue (g_errorModel));
+
+  uint16_t port = 5000;
+  ApplicationContainer apps;
+  for (uint32_t i = 0; i < g_flows; i++)
+    {
+      PacketSinkHelper sink ("ns3::TcpSocketFactory", InetSocketAddress (Ipv4Address::GetAny (), port));
+      apps.Add (sink.Install (dumbbell.GetRight (i)));
+      BulkSendHelper source ("ns3::TcpSocketFactory", InetSocketAddress (dumbbell.GetRightIpv4Address (i), port));
+      apps.Add (source.Install (dumbbell.GetLeft (i)));
+    }
+  apps.Start (Seconds (0));
+  apps.Stop (Seconds (g_duration));
+
+  g_monitor = flowmon.InstallAll ();
+}
+
+/**
+ * Run the scenario up to its end, and write its results.
+ * \param [in] replication The replication.
+ * \param [in] flowmon The helper of the flow monitor.
+ */
+void
+Finish (const ReplicationRunner::Replication &replication, FlowMonitorHelper &flowmon)
+{
+  Simulator::Stop (Seconds (g_duration) - Simulator::Now ());
+  Simulator::Run ();
+  g_monitor->CheckForLostPackets ();
+  flowmon.SerializeToXmlStream (replication.GetOutput (), 4, false, false);
+  g_monitor = 0;
+  g_errorModel = 0;
+  Simulator::Destroy ();
+}
+
+/**
+ * Run a replication from the start.
+ * \param [in] replication The replication.
+ */
+void
+Scenario (const ReplicationRunner::Replication &replication)
+{
+  CommandLine cmd;
+  AddScenarioValues (cmd);
+  replication.Parse (cmd);
+  FlowMonitorHelper flowmon;
+  Build (flowmon);
+  Finish (replication, flowmon);
+}
+
+/**
+ * Run a replication from the checkpoint at the end of the warm-up.
+ * \param [in] replication The replication.
+ */
+void
+Resume (const ReplicationRunner::Replication &replication)
+{
+  CommandLine cmd;
+  AddScenarioValues (cmd);
+  replication.Parse (cmd);
+  g_errorModel->SetAttribute ("ErrorRate", DoubleValue (g_errorRate));
+  Finish (replication, *g_flowmon);
+}
+
+} // unnamed namespace
+
+int
+main (int argc, char *argv[])
+{
+  uint64_t firstRun = 1;
+  uint32_t runs = 1;
+  uint32_t workers = 0;
+  double warmup = 0;
+  std::string output = "replications.xml";
+  ReplicationRunner runner;
+
+  CommandLine cmd;
+  cmd.Usage ("Run the replications of a TCP dumbbell scenario in parallel, "
+             "and gather their FlowMonitor results.\n"
+             "The scenario arguments given set the values of all the replications.");
+  cmd.AddValue ("firstRun", "First run number", firstRun);
+  cmd.AddValue ("runs", "Number of runs of each set of parameters", runs);
+  cmd.AddValue ("workers", "Number of worker processes; 0 for one per processor", workers);
+  cmd.AddValue ("output", "File gathering the results", output);
+  cmd.AddValue ("warmup", "Duration of the warm-up run once before the replications, "
+                "in seconds; 0 for none", warmup);
+  cmd.AddValue ("sweep", "A swept parameter, as name=value1,value2,...; may be repeated",
+                MakeCallback (&ReplicationRunner::ParseParameter, &runner));
+  AddScenarioValues (cmd);
+  cmd.Parse (argc, argv);
+
+  // The random number streams of the checkpoint ignore the run number
+  NS_ABORT_MSG_IF (warmup > 0 && runs > 1, "--runs must be 1 with --warmup; "
+                   "sweep RngRun to vary the streams created after the warm-up");
+  runner.SetRuns (firstRun, runs);
+  runner.SetWorkers (workers);
+  std::cout << "Running " << runner.GetNReplications () << " replications" << std::endl;
+  uint32_t failed;
+  if (warmup > 0)
+    {
+      FlowMonitorHelper flowmon;
+      g_flowmon = &flowmon;
+      Build (flowmon);
+      Simulator::Stop (Seconds (warmup));
+      Simulator::Run ();
+      std::cout << "Checkpoint at " << Simulator::Now ().GetSeconds () << " s" << std::endl;
+      failed = runner.Run (MakeCallback (&Resume), output);
+      g_monitor = 0;
+      g_errorModel = 0;
+      g_flowmon = 0;
+      Simulator::Destroy ();
+    }
+  else
+    {
+      failed = runner.Run (MakeCallback (&Scenario), output);
+    }
+  std::cout << failed << " replications failed, results in " << output << std::endl;
+  return failed == 0 ? 0 : 1;
+}